@@ -51,6 +51,7 @@
 #include <utilities/logtags.h>
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <exception>
 #ifndef WIN32
 #include <netinet/tcp.h> // For TCP_NODELAY etc
@@ -473,6 +474,33 @@ void Connection::shutdownIfSendQueueStuck(
     }
 }
 
+template <typename Func>
+bool Connection::runInPipelineOrder(Cookie& cookie, Func func) {
+    if (!isOrderedPipelining()) {
+        return func();
+    }
+
+    const bool behind = isBehindInPipeline(cookie);
+    if (!behind) {
+        // Anything held from a previous (blocked) run must go first
+        cookie.releaseResponse(getOutputBuffer());
+    }
+    responseBuffer = behind ? cookie.getHeldResponseBuffer() : nullptr;
+    bool completed;
+    try {
+        completed = func();
+    } catch (...) {
+        responseBuffer = nullptr;
+        throw;
+    }
+    responseBuffer = nullptr;
+
+    if (completed && behind) {
+        cookie.holdResponse();
+    }
+    return completed;
+}
+
 bool Connection::processAllReadyCookies() {
     // Look at the existing commands and check possibly execute them
     bool active = false;
@@ -496,15 +524,25 @@ bool Connection::processAllReadyCookies() {
             continue;
         }
 
+        if (cookie->isResponseHeld()) {
+            // Completed, waiting for an earlier command
+            ++iter;
+            continue;
+        }
+
         if (active && !cookie->mayReorder()) {
             // we've got active commands, and this command can't be
             // reordered... stop executing!
             break;
         }
 
-        if (cookie->execute()) {
+        const auto completed = runInPipelineOrder(
+                *cookie, [&cookie]() { return cookie->execute(); });
+        if (completed) {
             // The command executed successfully
-            if (iter == cookies.begin() || cookie->getRefcount()) {
+            if (cookie->isResponseHeld()) {
+                ++iter;
+            } else if (iter == cookies.begin() || cookie->getRefcount()) {
                 cookie->reset();
                 ++iter;
             } else {
@@ -521,9 +559,61 @@ bool Connection::processAllReadyCookies() {
         }
     }
 
+    releaseHeldResponses();
     return active;
 }
 
+bool Connection::isBehindInPipeline(const Cookie& cookie) const {
+    for (const auto& c : cookies) {
+        if (c.get() == &cookie) {
+            return false;
+        }
+        if (!c->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Connection::isKeyInPipeline(const Cookie& cookie,
+                                 cb::const_byte_buffer key) const {
+    for (const auto& c : cookies) {
+        if (c.get() == &cookie || c->empty() || c->isResponseHeld() ||
+            !c->getHeader().isRequest()) {
+            continue;
+        }
+        const auto other = c->getRequest().getKey();
+        if (other.size() == key.size() &&
+            std::equal(other.begin(), other.end(), key.begin())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Connection::releaseHeldResponses() {
+    auto iter = cookies.begin();
+    while (iter != cookies.end()) {
+        auto& cookie = *iter;
+        if (cookie->empty()) {
+            ++iter;
+            continue;
+        }
+        if (!cookie->isResponseHeld()) {
+            // Still executing; everything after it has to wait
+            break;
+        }
+
+        cookie->releaseResponse(getOutputBuffer());
+        if (iter == cookies.begin() || cookie->getRefcount()) {
+            cookie->reset();
+            ++iter;
+        } else {
+            iter = cookies.erase(iter);
+        }
+    }
+}
+
 void Connection::executeCommandPipeline() {
     numEvents = max_reqs_per_event;
     const auto maxActiveCommands =
@@ -541,8 +631,8 @@ void Connection::executeCommandPipeline() {
     if (!active || cookies.back()->mayReorder()) {
         // Only look at new commands if we don't have any active commands
         // or the active command allows for reordering.
-        auto input = bufferevent_get_input(bev.get());
-        bool stop = (getSendQueueSize() >= maxSendQueueSize);
+        auto input = getInputBuffer();
+        bool stop = (getQueuedResponseSize() >= maxSendQueueSize);
         while (!stop && cookies.size() < maxActiveCommands &&
                isPacketAvailable() && numEvents > 0) {
             if (!cookies.back()->empty()) {
@@ -560,13 +650,18 @@ void Connection::executeCommandPipeline() {
                 //  * We don't have any ongoing commands
                 //  * We have an ongoing command and this command allows
                 //    for reorder
-                if ((!active || cookie.mayReorder()) && cookie.execute()) {
+                if ((!active || cookie.mayReorder()) &&
+                    runInPipelineOrder(
+                            cookie, [&cookie]() { return cookie.execute(); })) {
                     // Command executed successfully, reset the cookie to allow
-                    // it to be reused
-                    cookie.reset();
+                    // it to be reused (unless its response is held until an
+                    // earlier command completes)
+                    if (!cookie.isResponseHeld()) {
+                        cookie.reset();
+                    }
                     // Check that we're not reserving too much memory for
                     // this client...
-                    stop = (getSendQueueSize() >= maxSendQueueSize);
+                    stop = (getQueuedResponseSize() >= maxSendQueueSize);
                 } else {
                     active = true;
                     // We need to block so we need to preserve the request
@@ -581,8 +676,13 @@ void Connection::executeCommandPipeline() {
                 --numEvents;
             } else {
                 // Packet validation failed
-                cookie.sendResponse(status);
-                cookie.reset();
+                runInPipelineOrder(cookie, [&cookie, status]() {
+                    cookie.sendResponse(status);
+                    return true;
+                });
+                if (!cookie.isResponseHeld()) {
+                    cookie.reset();
+                }
             }
 
             if (evbuffer_drain(input, drainSize) == -1) {
@@ -609,7 +709,7 @@ void Connection::executeCommandPipeline() {
     // the thread to be run again if we've got a pending notification for
     // the thread (an active command running which is waiting for the engine)
     // If the last command in the pipeline may be reordered we can add more
-    if ((getSendQueueSize() < maxSendQueueSize) &&
+    if ((getQueuedResponseSize() < maxSendQueueSize) &&
         (!active || (cookies.back()->mayReorder() &&
                      cookies.size() < maxActiveCommands))) {
         enableReadEvent();
@@ -820,6 +920,16 @@ void Connection::event_callback(bufferevent*, short event, void* ctx) {
     }
 }
 
+#ifdef HAVE_LIBURING
+void Connection::uring_rw_callback(IoUringSocket&, void* ctx) {
+    rw_callback(nullptr, ctx);
+}
+
+void Connection::uring_event_callback(IoUringSocket&, short event, void* ctx) {
+    event_callback(nullptr, event, ctx);
+}
+#endif
+
 void Connection::ssl_read_callback(bufferevent* bev, void* ctx) {
     auto& instance = *reinterpret_cast<Connection*>(ctx);
     // Lets inspect the certificate before we'll do anything further
@@ -923,6 +1033,12 @@ bool Connection::tryAuthFromSslCert(const std::string& userName) {
 }
 
 void Connection::triggerCallback() {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        uringSocket->trigger();
+        return;
+    }
+#endif
     const auto opt = BEV_TRIG_IGNORE_WATERMARKS | BEV_TRIG_DEFER_CALLBACKS;
     bufferevent_trigger(bev.get(), EV_READ, opt);
 }
@@ -936,7 +1052,8 @@ void Connection::copyToOutputStream(std::string_view data) {
         return;
     }
 
-    if (bufferevent_write(bev.get(), data.data(), data.size()) == -1) {
+    auto* dest = responseBuffer ? responseBuffer : getOutputBuffer();
+    if (evbuffer_add(dest, data.data(), data.size()) == -1) {
         throw std::bad_alloc();
     }
 
@@ -954,7 +1071,8 @@ void Connection::chainDataToOutputStream(std::unique_ptr<SendBuffer> buffer) {
     }
 
     auto data = buffer->getPayload();
-    if (evbuffer_add_reference(bufferevent_get_output(bev.get()),
+    auto* dest = responseBuffer ? responseBuffer : getOutputBuffer();
+    if (evbuffer_add_reference(dest,
                                data.data(),
                                data.size(),
                                sendbuffer_cleanup_cb,
@@ -969,6 +1087,20 @@ void Connection::chainDataToOutputStream(std::unique_ptr<SendBuffer> buffer) {
     totalSend += data.size();
 }
 
+void Connection::addDcpValueToOutputStream(cb::unique_item_ptr it,
+                                           std::string_view value) {
+    if (value.empty()) {
+        return;
+    }
+
+    if (value.size() > SendBuffer::MinimumDataSize) {
+        chainDataToOutputStream(std::make_unique<ItemSendBuffer>(
+                std::move(it), value, getBucket()));
+    } else {
+        copyToOutputStream(value);
+    }
+}
+
 Connection::Connection(FrontEndThread& thr)
     : socketDescriptor(INVALID_SOCKET),
       connectedToSystemPort(false),
@@ -1004,6 +1136,19 @@ Connection::Connection(SOCKET sfd,
     cookies.emplace_back(std::make_unique<Cookie>(*this));
     setConnectionId(peername.c_str());
 
+#ifdef HAVE_LIBURING
+    if (!ssl && thr.io_uring) {
+        uringSocket = IoUringSocket::create(*thr.io_uring, sfd);
+        uringSocket->setCallbacks(Connection::uring_rw_callback,
+                                  Connection::uring_rw_callback,
+                                  Connection::uring_event_callback,
+                                  static_cast<void*>(this));
+        uringSocket->enableRead();
+        stats.conn_structs++;
+        return;
+    }
+#endif
+
     const auto options = BEV_OPT_THREADSAFE | BEV_OPT_UNLOCK_CALLBACKS |
                          BEV_OPT_CLOSE_ON_FREE | BEV_OPT_DEFER_CALLBACKS;
     if (ssl) {
@@ -1045,6 +1190,12 @@ Connection::~Connection() {
         bev.reset();
         stats.curr_conns.fetch_sub(1, std::memory_order_relaxed);
     }
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        uringSocket.reset();
+        stats.curr_conns.fetch_sub(1, std::memory_order_relaxed);
+    }
+#endif
 
     --stats.conn_structs;
 }
@@ -1083,8 +1234,7 @@ size_t Connection::getNumberOfCookies() const {
 }
 
 bool Connection::isPacketAvailable() const {
-    auto* event = bev.get();
-    auto* input = bufferevent_get_input(event);
+    auto* input = getInputBuffer();
     auto size = evbuffer_get_length(input);
     if (size < sizeof(cb::mcbp::Header)) {
         return false;
@@ -1134,8 +1284,7 @@ bool Connection::isPacketAvailable() const {
 const cb::mcbp::Header& Connection::getPacket() const {
     // Drain all of the data available in bufferevent into the
     // socket read buffer
-    auto* event = bev.get();
-    auto* input = bufferevent_get_input(event);
+    auto* input = getInputBuffer();
     auto nb = evbuffer_get_length(input);
     if (nb < sizeof(cb::mcbp::Header)) {
         throw std::runtime_error(
@@ -1147,7 +1296,7 @@ const cb::mcbp::Header& Connection::getPacket() const {
 }
 
 cb::const_byte_buffer Connection::getAvailableBytes(size_t max) const {
-    auto* input = bufferevent_get_input(bev.get());
+    auto* input = getInputBuffer();
     auto nb = std::min(evbuffer_get_length(input), max);
     return {evbuffer_pullup(input, nb), nb};
 }
@@ -1270,6 +1419,12 @@ bool Connection::selectedBucketIsXattrEnabled() const {
 }
 
 void Connection::disableReadEvent() {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        uringSocket->disableRead();
+        return;
+    }
+#endif
     if ((bufferevent_get_enabled(bev.get()) & EV_READ) == EV_READ) {
         if (bufferevent_disable(bev.get(), EV_READ) == -1) {
             throw std::runtime_error(
@@ -1280,6 +1435,12 @@ void Connection::disableReadEvent() {
 }
 
 void Connection::enableReadEvent() {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        uringSocket->enableRead();
+        return;
+    }
+#endif
     if ((bufferevent_get_enabled(bev.get()) & EV_READ) == 0) {
         if (bufferevent_enable(bev.get(), EV_READ) == -1) {
             throw std::runtime_error(
@@ -1298,9 +1459,42 @@ bool Connection::havePendingData() const {
 }
 
 size_t Connection::getSendQueueSize() const {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        return uringSocket->getSendQueueSize();
+    }
+#endif
     return evbuffer_get_length(bufferevent_get_output(bev.get()));
 }
 
+size_t Connection::getQueuedResponseSize() const {
+    auto ret = getSendQueueSize();
+    if (isOrderedPipelining()) {
+        for (const auto& cookie : cookies) {
+            ret += cookie->getHeldResponseSize();
+        }
+    }
+    return ret;
+}
+
+evbuffer* Connection::getInputBuffer() const {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        return uringSocket->getInput();
+    }
+#endif
+    return bufferevent_get_input(bev.get());
+}
+
+evbuffer* Connection::getOutputBuffer() const {
+#ifdef HAVE_LIBURING
+    if (uringSocket) {
+        return uringSocket->getOutput();
+    }
+#endif
+    return bufferevent_get_output(bev.get());
+}
+
 void Connection::sendResponseHeaders(Cookie& cookie,
                                      cb::mcbp::Status status,
                                      std::string_view extras,
@@ -1675,15 +1869,7 @@ ENGINE_ERROR_CODE Connection::mutation(uint32_t opaque,
         copyToOutputStream({key.data(), key.size()});
 
         // Add the value
-        if (!value.empty()) {
-            if (value.size() > SendBuffer::MinimumDataSize) {
-                auto sendbuffer = std::make_unique<ItemSendBuffer>(
-                        std::move(it), value, getBucket());
-                chainDataToOutputStream(std::move(sendbuffer));
-            } else {
-                copyToOutputStream(value);
-            }
-        }
+        addDcpValueToOutputStream(std::move(it), value);
     } catch (const std::bad_alloc&) {
         /// We might have written a partial message into the buffer so
         /// we need to disconnect the client
@@ -1693,13 +1879,15 @@ ENGINE_ERROR_CODE Connection::mutation(uint32_t opaque,
     return ENGINE_SUCCESS;
 }
 
-ENGINE_ERROR_CODE Connection::deletionInner(const item_info& info,
+ENGINE_ERROR_CODE Connection::deletionInner(cb::unique_item_ptr it,
+                                            const item_info& info,
                                             cb::const_byte_buffer packet,
                                             const DocKey& key) {
     try {
         copyToOutputStream(packet);
         copyToOutputStream({key.data(), key.size()});
-        copyToOutputStream(
+        addDcpValueToOutputStream(
+                std::move(it),
                 {reinterpret_cast<const char*>(info.value[0].iov_base),
                  info.nbytes});
     } catch (const std::bad_alloc&) {
@@ -1793,7 +1981,7 @@ ENGINE_ERROR_CODE Connection::deletion(uint32_t opaque,
             sizeof(Request) + sizeof(DcpDeletionV1Payload) +
                     (sid ? sizeof(cb::mcbp::DcpStreamIdFrameInfo) : 0)};
 
-    return deletionInner(info, packetBuffer, key);
+    return deletionInner(std::move(it), info, packetBuffer, key);
 }
 
 ENGINE_ERROR_CODE Connection::deletion_v2(uint32_t opaque,
@@ -1878,7 +2066,7 @@ ENGINE_ERROR_CODE Connection::deletion_v2(uint32_t opaque,
     std::copy(buffer.begin(), buffer.end(), ptr);
     size += buffer.size();
 
-    return deletionInner(info, {blob.data(), size}, key);
+    return deletionInner(std::move(it), info, {blob.data(), size}, key);
 }
 
 ENGINE_ERROR_CODE Connection::expiration(uint32_t opaque,
@@ -1963,7 +2151,7 @@ ENGINE_ERROR_CODE Connection::expiration(uint32_t opaque,
     std::copy(buffer.begin(), buffer.end(), ptr);
     size += buffer.size();
 
-    return deletionInner(info, {blob.data(), size}, key);
+    return deletionInner(std::move(it), info, {blob.data(), size}, key);
 }
 
 ENGINE_ERROR_CODE Connection::set_vbucket_state(uint32_t opaque,
@@ -2147,15 +2335,7 @@ ENGINE_ERROR_CODE Connection::prepare(uint32_t opaque,
         copyToOutputStream({key.data(), key.size()});
 
         // Add the value
-        if (!buffer.empty()) {
-            if (buffer.size() > SendBuffer::MinimumDataSize) {
-                auto sendbuffer = std::make_unique<ItemSendBuffer>(
-                        std::move(it), buffer, getBucket());
-                chainDataToOutputStream(std::move(sendbuffer));
-            } else {
-                copyToOutputStream(buffer);
-            }
-        }
+        addDcpValueToOutputStream(std::move(it), buffer);
     } catch (const std::bad_alloc&) {
         /// We might have written a partial message into the buffer so
         /// we need to disconnect the client
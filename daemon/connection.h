@@ -17,6 +17,7 @@
 #pragma once
 
 #include "datatype_filter.h"
+#include "io_uring_loop.h"
 #include "sendbuffer.h"
 #include "stats.h"
 #include "task.h"
@@ -288,6 +289,26 @@ public:
         allow_unordered_execution = enable;
     }
 
+    /**
+     * Is the connection using an ordered pipeline: the client enabled
+     * the OrderedPipelining feature (but not unordered execution), so
+     * commands on different keys may be executed concurrently, with the
+     * responses sent in request order. See docs/UnorderedExecution.md
+     */
+    bool isOrderedPipelining() const {
+        return ordered_pipelining && !allow_unordered_execution && !isDCP();
+    }
+
+    void setOrderedPipelining(bool enable) {
+        ordered_pipelining = enable;
+    }
+
+    /**
+     * Is there a command (other than the one in the provided cookie) in the
+     * pipeline operating on the provided key which hasn't completed?
+     */
+    bool isKeyInPipeline(const Cookie& cookie, cb::const_byte_buffer key) const;
+
     /**
      * Remap the current error code
      *
@@ -793,10 +814,25 @@ protected:
     void updateDescription();
 
     // Shared DCP_DELETION write function for the v1/v2 commands.
-    ENGINE_ERROR_CODE deletionInner(const item_info& info,
+    ENGINE_ERROR_CODE deletionInner(cb::unique_item_ptr it,
+                                    const item_info& info,
                                     cb::const_byte_buffer packet,
                                     const DocKey& key);
 
+    /**
+     * Add the value of a DCP message to the output stream. Values bigger
+     * than SendBuffer::MinimumDataSize are chained as a reference to the
+     * item's value (the item is kept alive until libevent is done sending
+     * it) instead of being copied into the output stream.
+     *
+     * @param it The item the value belongs to (ownership is transferred)
+     * @param value The memory area within the item to send
+     * @throws std::bad_alloc if we failed to insert the data into the output
+     *                        stream.
+     */
+    void addDcpValueToOutputStream(cb::unique_item_ptr it,
+                                   std::string_view value);
+
     /**
      * Add the provided packet to the send pipe for the connection
      */
@@ -914,6 +950,15 @@ protected:
 
     bool allow_unordered_execution{false};
 
+    /// Has the client enabled the OrderedPipelining feature?
+    bool ordered_pipelining{false};
+
+    /**
+     * If set, responses are added to this buffer (a cookie's held response
+     * buffer) instead of the output stream. See runInPipelineOrder()
+     */
+    evbuffer* responseBuffer = nullptr;
+
     std::queue<std::unique_ptr<ServerEvent>> server_events;
 
     /**
@@ -993,6 +1038,17 @@ protected:
     /// The bufferevent structure for the object
     cb::libevent::unique_bufferevent_ptr bev;
 
+#ifdef HAVE_LIBURING
+    /// Used instead of bev for plain connections on a thread using io_uring
+    IoUringSocket::Ptr uringSocket;
+#endif
+
+    /// The buffer received data is read from (of bev or uringSocket)
+    evbuffer* getInputBuffer() const;
+
+    /// The buffer data to send is added to (of bev or uringSocket)
+    evbuffer* getOutputBuffer() const;
+
     /**
      * If the client enabled the mutation seqno feature each mutation
      * command will return the vbucket UUID and sequence number for the
@@ -1053,6 +1109,14 @@ protected:
     /// Get the number of bytes stuck in the send queue
     size_t getSendQueueSize() const;
 
+    /**
+     * Get the number of bytes of responses queued for the client: the send
+     * queue plus the responses held back in an ordered pipeline (which must
+     * count towards max_send_queue_size as they can't be sent until the
+     * earlier commands complete)
+     */
+    size_t getQueuedResponseSize() const;
+
     /**
      * Shutdown the connection if the send queue is stuck  (no data transmitted
      * drained from the send queue for a certain period of time).
@@ -1072,6 +1136,27 @@ protected:
      */
     bool processAllReadyCookies();
 
+    /**
+     * Call func (executing the cookie's command, or sending its response).
+     * In an ordered pipeline the response(s) are held in the cookie if an
+     * earlier command hasn't completed yet.
+     *
+     * @return func's return value (true if the command completed)
+     */
+    template <typename Func>
+    bool runInPipelineOrder(Cookie& cookie, Func func);
+
+    /// Is there an earlier command in the pipeline which hasn't been
+    /// completed (and had its response sent)?
+    bool isBehindInPipeline(const Cookie& cookie) const;
+
+    /**
+     * Send the held responses of the commands at the front of the pipeline
+     * (i.e. which are no longer waiting for an earlier command), and reuse
+     * their cookies.
+     */
+    void releaseHeldResponses();
+
     /**
      * Execute commands in the pipeline.
      *
@@ -1121,6 +1206,12 @@ protected:
      * the standard read callback.
      */
     static void ssl_read_callback(bufferevent*, void* ctx);
+
+#ifdef HAVE_LIBURING
+    /// The IoUringSocket callbacks; forwarded to rw_callback/event_callback
+    static void uring_rw_callback(IoUringSocket&, void* ctx);
+    static void uring_event_callback(IoUringSocket&, short event, void* ctx);
+#endif
 };
 
 /**
@@ -29,6 +29,7 @@
 #include "opentracing.h"
 #include "settings.h"
 
+#include <event2/buffer.h>
 #include <logger/logger.h>
 #include <mcbp/mcbp.h>
 #include <mcbp/protocol/framebuilder.h>
@@ -487,7 +488,11 @@ cb::mcbp::Status Cookie::validate() {
         }
 
         // Add a barrier to the command if we don't support reordering it!
-        if (reorder && !is_reorder_supported(request.getClientOpcode())) {
+        // The client hasn't asked for unordered execution in an ordered
+        // pipeline, so commands on the same key must not be reordered
+        if (reorder && (!is_reorder_supported(request.getClientOpcode()) ||
+                        (!connection.allowUnorderedExecution() &&
+                         connection.isKeyInPipeline(*this, request.getKey())))) {
             setBarrier();
         }
     } // We don't currently have any validators for response packets
@@ -510,7 +515,14 @@ void Cookie::reset() {
     openTracingContext.clear();
     authorized = false;
     preserveTtl = false;
-    reorder = connection.allowUnorderedExecution();
+    reorder = connection.allowUnorderedExecution() ||
+              connection.isOrderedPipelining();
+    responseHeld = false;
+    if (heldResponse) {
+        // Frees any referenced send buffers
+        evbuffer_drain(heldResponse.get(),
+                       evbuffer_get_length(heldResponse.get()));
+    }
     inflated_input_payload.reset();
     currentCollectionInfo.reset();
     privilegeContext = connection.getPrivilegeContext();
@@ -519,6 +531,27 @@ void Cookie::reset() {
     frame_copy.reset();
 }
 
+evbuffer* Cookie::getHeldResponseBuffer() {
+    if (!heldResponse) {
+        heldResponse.reset(evbuffer_new());
+        if (!heldResponse) {
+            throw std::bad_alloc();
+        }
+    }
+    return heldResponse.get();
+}
+
+void Cookie::releaseResponse(evbuffer* dest) {
+    if (heldResponse && evbuffer_get_length(heldResponse.get()) != 0 &&
+        evbuffer_add_buffer(dest, heldResponse.get()) == -1) {
+        throw std::bad_alloc();
+    }
+}
+
+size_t Cookie::getHeldResponseSize() const {
+    return heldResponse ? evbuffer_get_length(heldResponse.get()) : 0;
+}
+
 void Cookie::setOpenTracingContext(cb::const_byte_buffer context) {
     try {
         openTracingContext.assign(reinterpret_cast<const char*>(context.data()),
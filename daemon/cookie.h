@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <libevent/utilities.h>
 #include <mcbp/protocol/datatype.h>
 #include <mcbp/protocol/status.h>
 #include <memcached/dockey.h>
@@ -464,6 +465,34 @@ public:
         return reorder;
     }
 
+    /**
+     * Get the buffer to hold this command's response(s) in while an earlier
+     * command in an ordered pipeline is still executing (see
+     * docs/UnorderedExecution.md)
+     */
+    evbuffer* getHeldResponseBuffer();
+
+    /**
+     * Mark the command as completed, with its response held until the
+     * earlier commands in the pipeline have completed. The request is
+     * preserved (so the cookie isn't reused in the meantime).
+     */
+    void holdResponse() {
+        preserveRequest();
+        responseHeld = true;
+    }
+
+    /// Has the command completed, with its response held back?
+    bool isResponseHeld() const {
+        return responseHeld;
+    }
+
+    /// Move any held response to the end of the provided buffer
+    void releaseResponse(evbuffer* dest);
+
+    /// Get the number of bytes held in the response buffer
+    size_t getHeldResponseSize() const;
+
     /**
      * Get the inflated payload (inflated as part of package validation),
      * and if the payload wasn't inflated the packets value is returned.
@@ -599,6 +628,10 @@ protected:
 
     bool reorder = false;
 
+    /// See holdResponse()
+    bool responseHeld = false;
+    cb::libevent::unique_evbuffer_ptr heldResponse;
+
     /// The tracing context provided by the client to use as the
     /// parent span
     std::string openTracingContext;
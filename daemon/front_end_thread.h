@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "io_uring_loop.h"
+
 #include <JSON_checker.h>
 #include <event.h>
 #include <memcached/engine_error.h>
@@ -62,6 +64,15 @@ struct FrontEndThread {
     /// libevent handle this thread uses
     struct event_base* base = nullptr;
 
+    /**
+     * The io_uring used for the socket I/O of this thread's plain (non-TLS)
+     * connections, if "io_uring_enabled" is set and the kernel supports it.
+     * Null if the connections use libevent bufferevents.
+     */
+#ifdef HAVE_LIBURING
+    std::unique_ptr<IoUringLoop> io_uring;
+#endif
+
     /// listen event for notify pipe
     struct event notify_event = {};
 
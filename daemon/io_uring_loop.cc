@@ -0,0 +1,485 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#ifdef HAVE_LIBURING
+
+#include "io_uring_loop.h"
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+/// Submission queue size; a loop iteration typically needs one or two
+/// entries per active connection
+static constexpr unsigned RingEntries = 4096;
+
+IoUringLoop::IoUringLoop(event_base* base) {
+    auto ret = io_uring_queue_init(RingEntries, &ring, 0);
+    if (ret < 0) {
+        throw std::system_error(
+                -ret, std::system_category(), "IoUringLoop: io_uring_queue_init");
+    }
+
+    try {
+        bufRing = io_uring_setup_buf_ring(
+                &ring, NumRecvBuffers, BufferGroup, 0, &ret);
+        if (bufRing == nullptr) {
+            throw std::system_error(-ret,
+                                    std::system_category(),
+                                    "IoUringLoop: io_uring_setup_buf_ring");
+        }
+        recvBuffers = std::make_unique<char[]>(NumRecvBuffers * RecvBufferSize);
+        const auto mask = io_uring_buf_ring_mask(NumRecvBuffers);
+        for (unsigned ii = 0; ii < NumRecvBuffers; ++ii) {
+            io_uring_buf_ring_add(bufRing,
+                                  recvBuffers.get() + ii * RecvBufferSize,
+                                  RecvBufferSize,
+                                  ii,
+                                  mask,
+                                  ii);
+        }
+        io_uring_buf_ring_advance(bufRing, NumRecvBuffers);
+
+        eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd == -1) {
+            throw std::system_error(
+                    errno, std::system_category(), "IoUringLoop: eventfd");
+        }
+        ret = io_uring_register_eventfd(&ring, eventFd);
+        if (ret < 0) {
+            throw std::system_error(-ret,
+                                    std::system_category(),
+                                    "IoUringLoop: io_uring_register_eventfd");
+        }
+
+        completionEvent.reset(event_new(base,
+                                        eventFd,
+                                        EV_READ | EV_PERSIST,
+                                        completionCallback,
+                                        this));
+        flushEvent.reset(event_new(base, -1, 0, flushCallback, this));
+        if (!completionEvent || !flushEvent ||
+            event_add(completionEvent.get(), nullptr) == -1) {
+            throw std::runtime_error("IoUringLoop: failed to create events");
+        }
+    } catch (const std::exception&) {
+        destroy();
+        throw;
+    }
+}
+
+IoUringLoop::~IoUringLoop() {
+    destroy();
+}
+
+void IoUringLoop::destroy() {
+    completionEvent.reset();
+    flushEvent.reset();
+    if (eventFd != -1) {
+        ::close(eventFd);
+        eventFd = -1;
+    }
+    if (bufRing) {
+        io_uring_free_buf_ring(&ring, bufRing, NumRecvBuffers, BufferGroup);
+        bufRing = nullptr;
+    }
+    io_uring_queue_exit(&ring);
+}
+
+bool IoUringLoop::isSupported() {
+    static const bool supported = []() {
+        io_uring probe;
+        if (io_uring_queue_init(4, &probe, 0) < 0) {
+            return false;
+        }
+        bool ok = false;
+        int ret;
+        auto* br = io_uring_setup_buf_ring(&probe, 1, BufferGroup, 0, &ret);
+        int fds[2];
+        if (br != nullptr &&
+            socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0) {
+            char buffer[16];
+            io_uring_buf_ring_add(br,
+                                  buffer,
+                                  sizeof(buffer),
+                                  0,
+                                  io_uring_buf_ring_mask(1),
+                                  0);
+            io_uring_buf_ring_advance(br, 1);
+
+            auto* sqe = io_uring_get_sqe(&probe);
+            io_uring_prep_recv_multishot(sqe, fds[0], nullptr, 0, 0);
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BufferGroup;
+            io_uring_cqe* cqe;
+            if (io_uring_submit(&probe) == 1 && ::write(fds[1], "x", 1) == 1 &&
+                io_uring_wait_cqe(&probe, &cqe) == 0) {
+                ok = cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER) &&
+                     (cqe->flags & IORING_CQE_F_MORE);
+                io_uring_cqe_seen(&probe, cqe);
+            }
+            ::close(fds[0]);
+            ::close(fds[1]);
+        }
+        if (br != nullptr) {
+            io_uring_free_buf_ring(&probe, br, 1, BufferGroup);
+        }
+        // Tears down the multishot receive still armed on the closed socket
+        io_uring_queue_exit(&probe);
+        return ok;
+    }();
+    return supported;
+}
+
+io_uring_sqe& IoUringLoop::getSqe() {
+    auto* sqe = io_uring_get_sqe(&ring);
+    if (sqe == nullptr) {
+        io_uring_submit(&ring);
+        sqe = io_uring_get_sqe(&ring);
+        if (sqe == nullptr) {
+            throw std::runtime_error(
+                    "IoUringLoop::getSqe: submission queue is full");
+        }
+    }
+    // Every request (including multishot receives) ends with exactly one
+    // completion without IORING_CQE_F_MORE set
+    ++inFlight;
+    scheduleFlush();
+    return *sqe;
+}
+
+void IoUringLoop::schedule(IoUringSocket& socket) {
+    if (!socket.isScheduled) {
+        socket.isScheduled = true;
+        scheduled.push_back(&socket);
+    }
+    scheduleFlush();
+}
+
+void IoUringLoop::scheduleFlush() {
+    if (!flushScheduled) {
+        flushScheduled = true;
+        event_active(flushEvent.get(), EV_TIMEOUT, 0);
+    }
+}
+
+void IoUringLoop::completionCallback(evutil_socket_t fd, short, void* arg) {
+    auto& loop = *static_cast<IoUringLoop*>(arg);
+    eventfd_t value;
+    (void)eventfd_read(fd, &value);
+    loop.processCompletions();
+    loop.flush();
+}
+
+void IoUringLoop::flushCallback(evutil_socket_t, short, void* arg) {
+    static_cast<IoUringLoop*>(arg)->flush();
+}
+
+void IoUringLoop::processCompletions() {
+    io_uring_cqe* cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&ring, head, cqe) {
+        ++count;
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+            --inFlight;
+        }
+        const auto data = io_uring_cqe_get_data64(cqe);
+        auto* socket = reinterpret_cast<IoUringSocket*>(data & ~uint64_t(3));
+        if (socket == nullptr) {
+            // Not issued on behalf of a socket (the cancel from drain())
+            continue;
+        }
+        // complete() only records the result; no callbacks are called (and
+        // so no socket is destroyed under our feet) until flush()
+        socket->complete(Op(data & 3), cqe->res, cqe->flags);
+    }
+    io_uring_cq_advance(&ring, count);
+}
+
+void IoUringLoop::flush() {
+    flushScheduled = false;
+    // Sockets scheduled by the callbacks run here are picked up by the next
+    // flush (the flush event is re-activated for them)
+    std::vector<IoUringSocket*> sockets;
+    sockets.swap(scheduled);
+    for (auto* socket : sockets) {
+        socket->run();
+    }
+    // Put the vector back to keep its capacity
+    if (scheduled.empty()) {
+        sockets.clear();
+        scheduled.swap(sockets);
+    }
+
+    if (io_uring_sq_ready(&ring) > 0) {
+        io_uring_submit(&ring);
+    }
+}
+
+size_t IoUringLoop::drain(std::chrono::milliseconds timeout) {
+    // Run the sockets closed since the last flush (they may only be waiting
+    // to be run before being destroyed) and submit what they prepared
+    flush();
+    if (inFlight == 0) {
+        return 0;
+    }
+
+    // The sockets are all closed, so everything left is either a receive or
+    // send to cancel, or a cancel already on its way
+    auto& sqe = getSqe();
+    io_uring_prep_cancel64(&sqe, 0, IORING_ASYNC_CANCEL_ANY);
+    io_uring_sqe_set_data64(&sqe, uint64_t(Op::Cancel));
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (inFlight > 0) {
+        flush();
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= remaining.zero()) {
+            break;
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                remaining)
+                                .count();
+        __kernel_timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        io_uring_cqe* cqe;
+        const auto ret = io_uring_wait_cqe_timeout(&ring, &cqe, &ts);
+        if (ret < 0 && ret != -EINTR && ret != -ETIME) {
+            break;
+        }
+        processCompletions();
+    }
+    flush();
+    return inFlight;
+}
+
+void IoUringLoop::returnBuffer(uint16_t bid) {
+    io_uring_buf_ring_add(bufRing,
+                          recvBuffers.get() + bid * RecvBufferSize,
+                          RecvBufferSize,
+                          bid,
+                          io_uring_buf_ring_mask(NumRecvBuffers),
+                          0);
+    io_uring_buf_ring_advance(bufRing, 1);
+}
+
+IoUringSocket::Ptr IoUringSocket::create(IoUringLoop& loop, SOCKET sfd) {
+    return Ptr{new IoUringSocket(loop, sfd)};
+}
+
+IoUringSocket::IoUringSocket(IoUringLoop& loop, SOCKET sfd)
+    : loop(loop),
+      sfd(sfd),
+      input(evbuffer_new()),
+      output(evbuffer_new()),
+      sending(evbuffer_new()) {
+    if (!input || !output || !sending) {
+        throw std::bad_alloc();
+    }
+    // As with BEV_OPT_THREADSAFE; other threads may inspect the buffers
+    evbuffer_enable_locking(input.get(), nullptr);
+    evbuffer_enable_locking(output.get(), nullptr);
+    evbuffer_enable_locking(sending.get(), nullptr);
+    evbuffer_add_cb(output.get(), outputCallback, this);
+    msg.msg_iov = iov.data();
+}
+
+IoUringSocket::~IoUringSocket() {
+    // The owner accounts for the connection (curr_conns)
+    cb::net::closesocket(sfd);
+}
+
+void IoUringSocket::setCallbacks(DataCallback read,
+                                 DataCallback write,
+                                 EventCallback event,
+                                 void* ctx) {
+    readCb = read;
+    writeCb = write;
+    eventCb = event;
+    this->ctx = ctx;
+}
+
+size_t IoUringSocket::getSendQueueSize() const {
+    return evbuffer_get_length(output.get()) +
+           evbuffer_get_length(sending.get());
+}
+
+void IoUringSocket::enableRead() {
+    readEnabled = true;
+    if (!recvArmed && !eof) {
+        loop.schedule(*this);
+    }
+}
+
+void IoUringSocket::disableRead() {
+    readEnabled = false;
+    if (recvArmed) {
+        cancel(IoUringLoop::Op::Recv);
+    }
+}
+
+void IoUringSocket::trigger() {
+    readPending = true;
+    loop.schedule(*this);
+}
+
+void IoUringSocket::close() {
+    closed = true;
+    readCb = writeCb = nullptr;
+    eventCb = nullptr;
+    if (recvArmed) {
+        cancel(IoUringLoop::Op::Recv);
+    }
+    if (sendInFlight) {
+        cancel(IoUringLoop::Op::Send);
+    }
+    maybeDestroy();
+}
+
+void IoUringSocket::outputCallback(evbuffer*,
+                                   const evbuffer_cb_info* info,
+                                   void* arg) {
+    if (info->n_added > 0) {
+        auto& socket = *static_cast<IoUringSocket*>(arg);
+        socket.loop.schedule(socket);
+    }
+}
+
+void IoUringSocket::complete(IoUringLoop::Op op, int res, uint32_t flags) {
+    switch (op) {
+    case IoUringLoop::Op::Recv:
+        if ((flags & IORING_CQE_F_MORE) == 0) {
+            recvArmed = false;
+        }
+        if (res > 0) {
+            const auto bid = uint16_t(flags >> IORING_CQE_BUFFER_SHIFT);
+            if (!closed) {
+                evbuffer_add(input.get(), loop.getRecvBuffer(bid), res);
+                readPending |= readEnabled;
+            }
+            loop.returnBuffer(bid);
+        } else if (res == 0) {
+            eof = true;
+            pendingEvents |= BEV_EVENT_READING | BEV_EVENT_EOF;
+        } else if (res != -ENOBUFS && res != -ECANCELED) {
+            // ENOBUFS: all buffers are in use; re-armed when run
+            eof = true;
+            socketError = -res;
+            pendingEvents |= BEV_EVENT_READING | BEV_EVENT_ERROR;
+        }
+        break;
+    case IoUringLoop::Op::Send:
+        sendInFlight = false;
+        if (res >= 0) {
+            evbuffer_drain(sending.get(), res);
+            writePending |= getSendQueueSize() == 0;
+        } else if (res != -ECANCELED) {
+            socketError = -res;
+            pendingEvents |= BEV_EVENT_WRITING | BEV_EVENT_ERROR;
+        }
+        break;
+    case IoUringLoop::Op::Cancel:
+        --cancelsInFlight;
+        break;
+    }
+
+    if (closed) {
+        maybeDestroy();
+    } else {
+        loop.schedule(*this);
+    }
+}
+
+void IoUringSocket::run() {
+    // isScheduled stays set while the callbacks run, so the socket cannot be
+    // destroyed by them (and any data they send is prepared below)
+    if (!closed && pendingEvents != 0) {
+        const auto events = std::exchange(pendingEvents, 0);
+        errno = socketError;
+        eventCb(*this, events, ctx);
+    }
+    if (!closed && std::exchange(readPending, false)) {
+        readCb(*this, ctx);
+    }
+    if (!closed && std::exchange(writePending, false)) {
+        writeCb(*this, ctx);
+    }
+    if (!closed) {
+        if (!sendInFlight && getSendQueueSize() > 0) {
+            prepareSend();
+        }
+        if (readEnabled && !recvArmed && !eof) {
+            armRecv();
+        }
+    }
+
+    isScheduled = false;
+    if (closed) {
+        maybeDestroy();
+    } else if (readPending || writePending || pendingEvents != 0) {
+        // Triggered from one of the callbacks
+        loop.schedule(*this);
+    }
+}
+
+void IoUringSocket::armRecv() {
+    auto& sqe = loop.getSqe();
+    io_uring_prep_recv_multishot(&sqe, sfd, nullptr, 0, 0);
+    sqe.flags |= IOSQE_BUFFER_SELECT;
+    sqe.buf_group = IoUringLoop::BufferGroup;
+    io_uring_sqe_set_data64(&sqe, userData(IoUringLoop::Op::Recv));
+    recvArmed = true;
+}
+
+void IoUringSocket::prepareSend() {
+    // Moves whole chains; no data is copied
+    evbuffer_remove_buffer(
+            output.get(), sending.get(), evbuffer_get_length(output.get()));
+    const auto n = evbuffer_peek(sending.get(), -1, nullptr, iov.data(), MaxIov);
+    msg.msg_iovlen = std::min(n, MaxIov);
+
+    auto& sqe = loop.getSqe();
+    io_uring_prep_sendmsg(&sqe, sfd, &msg, MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(&sqe, userData(IoUringLoop::Op::Send));
+    sendInFlight = true;
+}
+
+void IoUringSocket::cancel(IoUringLoop::Op op) {
+    auto& sqe = loop.getSqe();
+    io_uring_prep_cancel64(&sqe, userData(op), 0);
+    io_uring_sqe_set_data64(&sqe, userData(IoUringLoop::Op::Cancel));
+    ++cancelsInFlight;
+}
+
+void IoUringSocket::maybeDestroy() {
+    if (closed && !isScheduled && !recvArmed && !sendInFlight &&
+        cancelsInFlight == 0) {
+        delete this;
+    }
+}
+
+#endif // HAVE_LIBURING
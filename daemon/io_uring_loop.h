@@ -0,0 +1,271 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#ifdef HAVE_LIBURING
+
+#include <libevent/utilities.h>
+#include <liburing.h>
+#include <platform/socket.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class IoUringSocket;
+
+/**
+ * An io_uring instance used by a front-end thread to perform the socket I/O
+ * for its (plain, non-TLS) connections, instead of libevent bufferevents.
+ *
+ * libevent still drives the thread (the notification pipe, timers, TLS
+ * connections etc. are unchanged):
+ *
+ *  * Completions are signalled on an eventfd registered with the thread's
+ *    event_base, and are all reaped (and the sockets' callbacks called) in
+ *    one go when it fires.
+ *  * The requests prepared while running an iteration of the event loop
+ *    (the sends of all responses produced in it, re-arming receives etc.)
+ *    are submitted together with a single io_uring_enter(), from an event
+ *    activated when the first one is queued.
+ *  * Receives are multishot, selecting from a ring of buffers provided to
+ *    the kernel up front, so a socket only needs to be armed once and an
+ *    idle connection holds no buffer (and costs no syscalls).
+ *
+ * All methods must be called from the thread owning the event_base.
+ */
+class IoUringLoop {
+public:
+    /**
+     * Create the ring and register it with the given event_base.
+     *
+     * @throws std::system_error if the ring cannot be set up
+     */
+    explicit IoUringLoop(event_base* base);
+
+    ~IoUringLoop();
+
+    IoUringLoop(const IoUringLoop&) = delete;
+
+    /**
+     * @returns true if the kernel supports everything IoUringLoop needs
+     *          (provided buffer rings and multishot receive). The result is
+     *          cached after the first call.
+     */
+    static bool isSupported();
+
+    /**
+     * Cancel all requests still in flight and wait (for at most the given
+     * time) for them to complete, destroying the closed sockets they were
+     * holding on to. Must be called before the loop is destroyed, once all
+     * sockets have been closed.
+     *
+     * @returns the number of requests still in flight
+     */
+    size_t drain(std::chrono::milliseconds timeout);
+
+    /// Number of requests submitted (or prepared) which the kernel has not
+    /// yet posted the final completion for
+    size_t getInFlight() const {
+        return inFlight;
+    }
+
+    /// Number of provided receive buffers
+    static constexpr unsigned NumRecvBuffers = 256;
+
+    /// Size of each provided receive buffer
+    static constexpr size_t RecvBufferSize = 16 * 1024;
+
+protected:
+    friend class IoUringSocket;
+
+    /// The request a completion belongs to; stored in the low bits of the
+    /// user_data (IoUringSocket objects are at least 8 byte aligned)
+    enum class Op : uintptr_t { Recv = 0, Send = 1, Cancel = 2 };
+
+    /// Group ID of the provided receive buffers
+    static constexpr uint16_t BufferGroup = 0;
+
+    /**
+     * Get a submission queue entry (submitting the queued entries first if
+     * the queue is full). The entry is submitted when the loop next flushes,
+     * and is counted as in flight until its final completion is processed.
+     */
+    io_uring_sqe& getSqe();
+
+    /// Request that the loop runs the socket's callbacks / submits its
+    /// pending requests at the end of this iteration of the event loop
+    void schedule(IoUringSocket& socket);
+
+    static void completionCallback(evutil_socket_t fd, short, void* arg);
+    static void flushCallback(evutil_socket_t, short, void* arg);
+
+    void processCompletions();
+
+    /// Run the scheduled sockets and submit all prepared requests
+    void flush();
+
+    void scheduleFlush();
+
+    const char* getRecvBuffer(uint16_t bid) const {
+        return recvBuffers.get() + bid * RecvBufferSize;
+    }
+
+    /// Give a receive buffer back to the kernel
+    void returnBuffer(uint16_t bid);
+
+    /// Release everything the constructor set up
+    void destroy();
+
+    io_uring ring = {};
+    io_uring_buf_ring* bufRing = nullptr;
+    std::unique_ptr<char[]> recvBuffers;
+    int eventFd = -1;
+    cb::libevent::unique_event_ptr completionEvent;
+    cb::libevent::unique_event_ptr flushEvent;
+    bool flushScheduled = false;
+    std::vector<IoUringSocket*> scheduled;
+    /// See getInFlight()
+    size_t inFlight = 0;
+};
+
+/**
+ * A connected socket driven by an IoUringLoop. Modelled on a libevent
+ * bufferevent: data received is appended to the input buffer and the read
+ * callback called; data added to the output buffer is sent, and the write
+ * callback called once it has all been sent; EOF and errors are reported
+ * through the event callback (with BEV_EVENT_* flags).
+ *
+ * The socket is closed and the object destroyed by close() (see Ptr), once
+ * the kernel has completed all requests it has outstanding for it.
+ */
+class IoUringSocket {
+public:
+    using DataCallback = void (*)(IoUringSocket&, void* ctx);
+    using EventCallback = void (*)(IoUringSocket&, short events, void* ctx);
+
+    struct Closer {
+        void operator()(IoUringSocket* socket) {
+            socket->close();
+        }
+    };
+    using Ptr = std::unique_ptr<IoUringSocket, Closer>;
+
+    /// Create a socket (with reading disabled) taking ownership of sfd
+    static Ptr create(IoUringLoop& loop, SOCKET sfd);
+
+    void setCallbacks(DataCallback read,
+                      DataCallback write,
+                      EventCallback event,
+                      void* ctx);
+
+    evbuffer* getInput() const {
+        return input.get();
+    }
+
+    /**
+     * The buffer to add data to be sent to. Note that data is moved from it
+     * once it is being sent; use getSendQueueSize() for the number of bytes
+     * not yet sent.
+     */
+    evbuffer* getOutput() const {
+        return output.get();
+    }
+
+    size_t getSendQueueSize() const;
+
+    void enableRead();
+    void disableRead();
+
+    bool isReadEnabled() const {
+        return readEnabled;
+    }
+
+    /// Call the read callback from the event loop (deferred)
+    void trigger();
+
+protected:
+    friend class IoUringLoop;
+
+    IoUringSocket(IoUringLoop& loop, SOCKET sfd);
+    ~IoUringSocket();
+
+    /// Stop all callbacks, cancel the outstanding requests and destroy the
+    /// object once they have completed.
+    void close();
+
+    static void outputCallback(evbuffer*,
+                               const evbuffer_cb_info* info,
+                               void* arg);
+
+    /// Handle the completion of one of this socket's requests
+    void complete(IoUringLoop::Op op, int res, uint32_t flags);
+
+    /// Called by the loop at the end of an event loop iteration: run the
+    /// callbacks and prepare any requests needed
+    void run();
+
+    void armRecv();
+    void prepareSend();
+    void cancel(IoUringLoop::Op op);
+    void maybeDestroy();
+
+    uint64_t userData(IoUringLoop::Op op) const {
+        return reinterpret_cast<uintptr_t>(this) | uintptr_t(op);
+    }
+
+    IoUringLoop& loop;
+    const SOCKET sfd;
+
+    cb::libevent::unique_evbuffer_ptr input;
+    cb::libevent::unique_evbuffer_ptr output;
+    /// The data currently being sent (moved from output when the send is
+    /// prepared, so output can be freely appended to while it is in flight)
+    cb::libevent::unique_evbuffer_ptr sending;
+
+    /// Maximum number of iovecs per sendmsg
+    static constexpr int MaxIov = 64;
+    std::array<iovec, MaxIov> iov = {};
+    msghdr msg = {};
+
+    DataCallback readCb = nullptr;
+    DataCallback writeCb = nullptr;
+    EventCallback eventCb = nullptr;
+    void* ctx = nullptr;
+
+    bool readEnabled = false;
+    bool closed = false;
+    /// EOF (or a receive error) seen; no more receives are armed
+    bool eof = false;
+    /// errno of the last failed request, set when the event callback is called
+    int socketError = 0;
+
+    /// Requests in flight in the kernel
+    bool recvArmed = false;
+    bool sendInFlight = false;
+    int cancelsInFlight = 0;
+
+    /// State to be acted upon when the loop next runs this socket
+    bool isScheduled = false;
+    bool readPending = false;
+    bool writePending = false;
+    short pendingEvents = 0;
+};
+
+#endif // HAVE_LIBURING
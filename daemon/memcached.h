@@ -69,6 +69,13 @@ void threadlocal_stats_reset(std::vector<thread_stats>& thread_stats);
 void notify_io_complete(gsl::not_null<const void*> cookie,
                         ENGINE_ERROR_CODE status);
 void safe_close(SOCKET sfd);
+
+/**
+ * Add the cookie to the list of pending io for the connection's thread.
+ *
+ * @return non-zero if the caller must notify the thread (notify_thread), zero
+ *         if a notification is already outstanding for the thread
+ */
 int add_conn_to_pending_io_list(Connection* c,
                                 Cookie* cookie,
                                 ENGINE_ERROR_CODE status);
@@ -64,14 +64,8 @@ static std::pair<ENGINE_ERROR_CODE, Hdr1sfMicroSecHistogram> get_timings(
         }
     }
 
-    auto* histo = bucket.timings.get_timing_histogram(opcode);
-    if (histo) {
-        return {ENGINE_SUCCESS, *histo};
-    } else {
-        // histogram for this opcode hasn't been created yet so just
-        // return an histogram with no data in it
-        return {ENGINE_SUCCESS, {}};
-    }
+    // Empty if nothing has been recorded for this opcode yet.
+    return {ENGINE_SUCCESS, bucket.timings.get_timing_histogram(opcode)};
 }
 
 /**
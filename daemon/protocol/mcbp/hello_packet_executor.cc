@@ -85,6 +85,7 @@ void buildRequestVector(FeatureSet& requested, cb::sized_buffer<const uint16_t>
         case cb::mcbp::Feature::PiTR:
         case cb::mcbp::Feature::SubdocCreateAsDeleted:
         case cb::mcbp::Feature::SubdocDocumentMacroSupport:
+        case cb::mcbp::Feature::OrderedPipelining:
 
             // This isn't very optimal, but we've only got a handfull of elements ;)
             if (!containsFeature(requested, feature)) {
@@ -113,6 +114,7 @@ void buildRequestVector(FeatureSet& requested, cb::sized_buffer<const uint16_t>
         case cb::mcbp::Feature::SyncReplication:
         case cb::mcbp::Feature::Duplex:
         case cb::mcbp::Feature::UnorderedExecution:
+        case cb::mcbp::Feature::OrderedPipelining:
         case cb::mcbp::Feature::Collections:
         case cb::mcbp::Feature::OpenTracing:
         case cb::mcbp::Feature::PreserveTtl:
@@ -206,6 +208,7 @@ void process_hello_packet_executor(Cookie& cookie) {
     connection.setClustermapChangeNotificationSupported(false);
     connection.setTracingEnabled(false);
     connection.setAllowUnorderedExecution(false);
+    connection.setOrderedPipelining(false);
 
     if (!key.empty()) {
         if (key.front() == '{') {
@@ -333,6 +336,18 @@ void process_hello_packet_executor(Cookie& cookie) {
                 added = true;
             }
             break;
+        case cb::mcbp::Feature::OrderedPipelining:
+            if (connection.isDCP()) {
+                LOG_INFO(
+                        "{}: {} Ordered pipelining is not supported for "
+                        "DCP connections",
+                        connection.getId(),
+                        connection.getDescription());
+            } else {
+                connection.setOrderedPipelining(true);
+                added = true;
+            }
+            break;
 
         case cb::mcbp::Feature::PreserveTtl:
             // not supported yet
@@ -232,6 +232,18 @@ static void handle_stdin_listener(Settings& s, const nlohmann::json& obj) {
     s.setStdinListenerEnabled(obj.get<bool>());
 }
 
+/**
+ * Handle the "io_uring_enabled" tag in the settings
+ *
+ *  The value must be a boolean value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_io_uring_enabled(Settings& s, const nlohmann::json& obj) {
+    s.setIoUringEnabled(obj.get<bool>());
+}
+
 /**
  * Handle "default_reqs_per_event", "reqs_per_event_high_priority",
  * "reqs_per_event_med_priority" and "reqs_per_event_low_priority" tag in
@@ -759,6 +771,7 @@ void Settings::reconfigure(const nlohmann::json& json) {
             {"sasl_mechanisms", handle_sasl_mechanisms},
             {"ssl_sasl_mechanisms", handle_ssl_sasl_mechanisms},
             {"stdin_listener", handle_stdin_listener},
+            {"io_uring_enabled", handle_io_uring_enabled},
             {"dedupe_nmvb_maps", handle_dedupe_nmvb_maps},
             {"xattr_enabled", handle_xattr_enabled},
             {"client_cert_auth", handle_client_cert_auth},
@@ -849,6 +862,13 @@ void Settings::updateSettings(const Settings& other, bool apply) {
         }
     }
 
+    if (other.has.io_uring_enabled) {
+        if (other.io_uring_enabled.load() != io_uring_enabled.load()) {
+            throw std::invalid_argument(
+                    "io_uring_enabled can't be changed dynamically");
+        }
+    }
+
     if (other.has.logger) {
         if (other.logger_settings != logger_settings)
             throw std::invalid_argument(
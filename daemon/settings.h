@@ -190,6 +190,27 @@ public:
         notify_changed("stdin_listener");
     }
 
+    /**
+     * Should the front-end threads use io_uring (rather than libevent
+     * bufferevents) for the socket I/O of plain connections?
+     *
+     * @return true if enabled, false otherwise
+     */
+    bool isIoUringEnabled() const {
+        return io_uring_enabled.load();
+    }
+
+    /**
+     * Set if the front-end threads should use io_uring
+     *
+     * @param enabled the new value
+     */
+    void setIoUringEnabled(bool enabled) {
+        io_uring_enabled.store(enabled);
+        has.io_uring_enabled = true;
+        notify_changed("io_uring_enabled");
+    }
+
     cb::logger::Config getLoggerConfig() const {
         auto config = logger_settings;
         // log_level is synthesised from settings.verbose.
@@ -1014,6 +1035,11 @@ protected:
      */
     std::atomic_bool stdin_listener{true};
 
+    /**
+     * Use io_uring for the front-end connection I/O
+     */
+    std::atomic_bool io_uring_enabled{false};
+
     /**
      * Should we allow for using the external authentication service or not
      */
@@ -1107,6 +1133,7 @@ public:
         bool topkeys_enabled = false;
         bool tracing_enabled = false;
         bool stdin_listener = false;
+        bool io_uring_enabled = false;
         bool scramsha_fallback_salt = false;
         bool external_auth_service = false;
         bool active_external_users_push_interval = false;
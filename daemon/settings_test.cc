@@ -590,6 +590,29 @@ TEST_F(SettingsTest, StdinListener) {
     }
 }
 
+TEST_F(SettingsTest, IoUringEnabled) {
+    nonBooleanValuesShouldFail("io_uring_enabled");
+
+    Settings defaults;
+    EXPECT_FALSE(defaults.isIoUringEnabled());
+
+    nlohmann::json obj;
+    obj["io_uring_enabled"] = true;
+    try {
+        Settings settings(obj);
+        EXPECT_TRUE(settings.isIoUringEnabled());
+        EXPECT_TRUE(settings.has.io_uring_enabled);
+
+        // Not dynamic
+        Settings updated;
+        updated.setIoUringEnabled(false);
+        EXPECT_THROW(settings.updateSettings(updated, false),
+                     std::invalid_argument);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
 TEST_F(SettingsTest, TopkeysEnabled) {
     nonBooleanValuesShouldFail("topkeys_enabled");
 
@@ -21,6 +21,7 @@
 #include <platform/strerror.h>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdlib>
 #include <cstring>
@@ -167,6 +168,30 @@ static void setup_thread(FrontEndThread& me) {
         (event_add(&me.notify_event, nullptr) == -1)) {
         FATAL_ERROR(EXIT_FAILURE, "Can't monitor libevent notify pipe");
     }
+
+    if (Settings::instance().isIoUringEnabled()) {
+#ifdef HAVE_LIBURING
+        if (IoUringLoop::isSupported()) {
+            try {
+                me.io_uring = std::make_unique<IoUringLoop>(me.base);
+            } catch (const std::exception& e) {
+                LOG_WARNING(
+                        "Failed to create io_uring, using libevent for "
+                        "connection I/O: {}",
+                        e.what());
+            }
+        } else {
+            LOG_WARNING(
+                    "io_uring_enabled is set but the kernel does not support "
+                    "multishot receive with provided buffers; using libevent "
+                    "for connection I/O");
+        }
+#else
+        LOG_WARNING(
+                "io_uring_enabled is set but memcached was built without "
+                "liburing; using libevent for connection I/O");
+#endif
+    }
 }
 
 /*
@@ -418,6 +443,24 @@ void threads_shutdown() {
 
 void threads_cleanup() {
     for (auto& thread : threads) {
+#ifdef HAVE_LIBURING
+        if (thread.io_uring) {
+            // All connections are closed, but the kernel may still hold
+            // requests (and the loop the sockets waiting for them) which
+            // must complete before the ring can be torn down
+            const auto left =
+                    thread.io_uring->drain(std::chrono::seconds{5});
+            if (left != 0) {
+                LOG_WARNING(
+                        "Worker thread {}: {} io_uring requests did not "
+                        "complete during shutdown",
+                        thread.index,
+                        left);
+            }
+        }
+        // Unregisters its events from the event base
+        thread.io_uring.reset();
+#endif
         event_base_free(thread.base);
     }
 }
@@ -444,13 +487,20 @@ int add_conn_to_pending_io_list(Connection* c,
     auto& thread = c->getThread();
 
     std::lock_guard<std::mutex> lock(thread.pending_io.mutex);
+    // The thread only needs to be notified when the list goes from empty to
+    // non-empty; until the thread has swapped the list out (which it does
+    // after draining the notification channel) the notification sent for the
+    // first entry covers everything added after it. This batches the wakeups
+    // when many cookies on the same thread complete at once (e.g. a batch of
+    // SyncWrites being committed).
+    const bool wasEmpty = thread.pending_io.map.empty();
     auto iter = thread.pending_io.map.find(c);
     if (iter == thread.pending_io.map.end()) {
         thread.pending_io.map.emplace(
                 c,
                 std::vector<std::pair<Cookie*, ENGINE_ERROR_CODE>>{
                         {cookie, status}});
-        return 1;
+        return wasEmpty ? 1 : 0;
     }
 
     for (const auto& pair : iter->second) {
@@ -461,5 +511,5 @@ int add_conn_to_pending_io_list(Connection* c,
         }
     }
     iter->second.emplace_back(cookie, status);
-    return 1;
+    return 0;
 }
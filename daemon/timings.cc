@@ -20,9 +20,10 @@ Timings::Timings() {
     reset();
 }
 
-Timings::~Timings() {
-    std::lock_guard<std::mutex> lg(histogram_mutex);
-    for (auto& t : timings) {
+Timings::~Timings() = default;
+
+Timings::CoreTimings::~CoreTimings() {
+    for (auto& t : histograms) {
         delete t;
     }
 }
@@ -30,9 +31,11 @@ Timings::~Timings() {
 void Timings::reset() {
     {
         std::lock_guard<std::mutex> lg(histogram_mutex);
-        for (auto& t : timings) {
-            if (t) {
-                t.load()->reset();
+        for (auto& core : timings) {
+            for (auto& t : core.histograms) {
+                if (t) {
+                    t.load()->reset();
+                }
             }
         }
     }
@@ -59,11 +62,11 @@ void Timings::collect(cb::mcbp::ClientOpcode opcode,
 }
 
 std::string Timings::generate(cb::mcbp::ClientOpcode opcode) {
-    auto* histoPtr =
-            timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode)]
-                    .load();
-    if (histoPtr) {
-        return histoPtr->to_string();
+    const auto op = std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode);
+    for (const auto& core : timings) {
+        if (core.histograms[op]) {
+            return get_timing_histogram(op).to_string();
+        }
     }
     return std::string("{}");
 }
@@ -114,12 +117,11 @@ static const cb::mcbp::ClientOpcode timings_retrievals[] = {
         cb::mcbp::ClientOpcode::SubdocGet,
         cb::mcbp::ClientOpcode::SubdocExists};
 
-uint64_t Timings::get_aggregated_mutation_stats() const {
+uint64_t Timings::get_value_count(cb::mcbp::ClientOpcode opcode) const {
+    const auto op = std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode);
     uint64_t ret = 0;
-    for (auto cmd : timings_mutations) {
-        auto* histoPtr =
-                timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd)]
-                        .load();
+    for (const auto& core : timings) {
+        auto* histoPtr = core.histograms[op].load();
         if (histoPtr) {
             ret += histoPtr->getValueCount();
         }
@@ -127,15 +129,18 @@ uint64_t Timings::get_aggregated_mutation_stats() const {
     return ret;
 }
 
+uint64_t Timings::get_aggregated_mutation_stats() const {
+    uint64_t ret = 0;
+    for (auto cmd : timings_mutations) {
+        ret += get_value_count(cmd);
+    }
+    return ret;
+}
+
 uint64_t Timings::get_aggregated_retrieval_stats() const {
     uint64_t ret = 0;
     for (auto cmd : timings_retrievals) {
-        auto* histoPtr =
-                timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd)]
-                        .load();
-        if (histoPtr) {
-            ret += histoPtr->getValueCount();
-        }
+        ret += get_value_count(cmd);
     }
     return ret;
 }
@@ -152,17 +157,38 @@ cb::sampling::Interval Timings::get_interval_lookup_latency() {
 
 Hdr1sfMicroSecHistogram& Timings::get_or_create_timing_histogram(
         uint8_t opcode) {
-    if (!timings[opcode]) {
+    auto& histogram = timings.get().histograms[opcode];
+    if (!histogram) {
         std::lock_guard<std::mutex> allocLock(histogram_mutex);
-        if (!timings[opcode]) {
-            timings[opcode] = new Hdr1sfMicroSecHistogram();
+        if (!histogram) {
+            histogram = new Hdr1sfMicroSecHistogram();
         }
     }
-    return *(timings[opcode].load());
+    return *(histogram.load());
 }
 
-Hdr1sfMicroSecHistogram* Timings::get_timing_histogram(uint8_t opcode) const {
-    return timings[opcode].load();
+Hdr1sfMicroSecHistogram Timings::get_timing_histogram(uint8_t opcode) const {
+    Hdr1sfMicroSecHistogram merged;
+    for (const auto& core : timings) {
+        auto* histoPtr = core.histograms[opcode].load();
+        if (histoPtr) {
+            merged += *histoPtr;
+        }
+    }
+    return merged;
+}
+
+size_t Timings::get_mem_footprint() const {
+    size_t ret = 0;
+    for (const auto& core : timings) {
+        for (const auto& t : core.histograms) {
+            auto* histoPtr = t.load();
+            if (histoPtr) {
+                ret += histoPtr->getMemFootPrint();
+            }
+        }
+    }
+    return ret;
 }
 
 void Timings::sample(std::chrono::seconds sample_interval) {
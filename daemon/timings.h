@@ -23,6 +23,7 @@
 #include <platform/corestore.h>
 #include <utilities/hdrhistogram.h>
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <string>
 
@@ -30,6 +31,16 @@
 
 /** Records timings for each memcached opcode. Each opcode has a histogram of
  * times.
+ *
+ * Histograms are sharded by core so that front-end threads recording timings
+ * don't contend on the same counters; readers merge the shards.
+ *
+ * Memory: a histogram is only allocated for an opcode once a core has
+ * recorded a time for it, so each bucket's Timings holds at most
+ * (cores) x (opcodes seen) Hdr1sfMicroSecHistograms of ~3KB each (see
+ * get_mem_footprint()). With the couple of dozen opcodes a typical workload
+ * uses that is well under 100KB per core per bucket; the 256 opcode
+ * worst case is ~750KB per core per bucket.
  */
 class Timings {
 public:
@@ -48,19 +59,33 @@ public:
     cb::sampling::Interval get_interval_lookup_latency();
 
     /**
-     * Get a pointer to the underlying histogram for the specified opcode
-     * @return a pointer to the underling HdrMicroSecHistogram for this opcode
-     * if there isn't one allocated already a nullptr will be returned.
+     * Get the histogram for the specified opcode, merged across all cores.
+     * @return the merged histogram; empty if nothing has been recorded for
+     *         this opcode.
      */
-    Hdr1sfMicroSecHistogram* get_timing_histogram(uint8_t opcode) const;
+    Hdr1sfMicroSecHistogram get_timing_histogram(uint8_t opcode) const;
+
+    /// @return the memory used by the histograms allocated on all cores
+    size_t get_mem_footprint() const;
 
 private:
+    /// One core's histograms; one per opcode, allocated on first use.
+    struct CoreTimings {
+        ~CoreTimings();
+
+        std::array<std::atomic<Hdr1sfMicroSecHistogram*>, MAX_NUM_OPCODES>
+                histograms{};
+    };
+
     /**
-     * Method to get histogram for timing, if the histogram hasn't been created
-     * yet, for the given opcode then we will allocate one
+     * Method to get the calling core's histogram for timing, if the histogram
+     * hasn't been created yet, for the given opcode then we will allocate one
      */
     Hdr1sfMicroSecHistogram& get_or_create_timing_histogram(uint8_t opcode);
 
+    /// @return the number of values recorded for opcode, across all cores.
+    uint64_t get_value_count(cb::mcbp::ClientOpcode opcode) const;
+
     // This lock is only held by sample() and some blocks within generate().
     // It guards the various IntervalSeries variables which internally
     // contain cb::RingBuffer objects which are not thread safe.
@@ -68,10 +93,10 @@ private:
 
     cb::sampling::IntervalSeries interval_latency_lookups;
     cb::sampling::IntervalSeries interval_latency_mutations;
-    // create an array of unique_ptrs as we want to create HdrHistograms
-    // in a lazy manner as their foot print is larger than our old
-    // histogram class
-    std::array<std::atomic<Hdr1sfMicroSecHistogram*>, MAX_NUM_OPCODES> timings;
+    // HdrHistograms are created in a lazy manner as their foot print is
+    // larger than our old histogram class. Sharded by core as each collect()
+    // would otherwise bounce the histogram's cache lines between cores.
+    CoreStore<CoreTimings> timings;
     std::mutex histogram_mutex;
 
     // Sharded by core as cache contention was observed due to the number of
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "timings.h"
+
+#include <folly/portability/GTest.h>
+#include <platform/sysinfo.h>
+
+#include <thread>
+#include <vector>
+
+using cb::mcbp::ClientOpcode;
+
+class TimingsTest : public ::testing::Test {
+protected:
+    /**
+     * Collect timings for opcode from numThreads threads at once (spread
+     * over the cores' shards), and the same values into reference.
+     * Thread t records the times t, t + numThreads, t + 2 * numThreads, ...
+     * microseconds (up to ~1s) so the shards hold different values.
+     */
+    void collectConcurrently(ClientOpcode opcode,
+                             Hdr1sfMicroSecHistogram& reference) {
+        std::vector<std::thread> threads;
+        for (int tt = 0; tt < numThreads; ++tt) {
+            threads.emplace_back([this, opcode, tt]() {
+                for (int ii = tt; ii < numValues; ii += numThreads) {
+                    timings.collect(opcode, std::chrono::microseconds(ii));
+                }
+            });
+        }
+        for (int ii = 0; ii < numValues; ++ii) {
+            reference.add(std::chrono::microseconds(ii));
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    static void expectEqual(const Hdr1sfMicroSecHistogram& expected,
+                            const Hdr1sfMicroSecHistogram& actual) {
+        EXPECT_EQ(expected.getValueCount(), actual.getValueCount());
+        EXPECT_EQ(expected.getMinValue(), actual.getMinValue());
+        EXPECT_EQ(expected.getMaxValue(), actual.getMaxValue());
+        for (auto p : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+            EXPECT_EQ(expected.getValueAtPercentile(p),
+                      actual.getValueAtPercentile(p))
+                    << "at percentile " << p;
+        }
+    }
+
+    static constexpr int numThreads = 8;
+    static constexpr int numValues = 1000000;
+    Timings timings;
+};
+
+/**
+ * The histogram merged from the per-core shards is the same as if every time
+ * had been recorded into a single histogram.
+ */
+TEST_F(TimingsTest, MergedHistogramMatchesTotals) {
+    Hdr1sfMicroSecHistogram set;
+    collectConcurrently(ClientOpcode::Set, set);
+    Hdr1sfMicroSecHistogram get;
+    collectConcurrently(ClientOpcode::Get, get);
+
+    expectEqual(set, timings.get_timing_histogram(uint8_t(ClientOpcode::Set)));
+    expectEqual(get, timings.get_timing_histogram(uint8_t(ClientOpcode::Get)));
+    EXPECT_EQ(set.to_string(), timings.generate(ClientOpcode::Set));
+    EXPECT_EQ(get.to_string(), timings.generate(ClientOpcode::Get));
+
+    EXPECT_EQ(set.getValueCount(), timings.get_aggregated_mutation_stats());
+    EXPECT_EQ(get.getValueCount(), timings.get_aggregated_retrieval_stats());
+
+    // Nothing recorded for other opcodes
+    EXPECT_EQ(0,
+              timings.get_timing_histogram(uint8_t(ClientOpcode::Delete))
+                      .getValueCount());
+    EXPECT_EQ("{}", timings.generate(ClientOpcode::Delete));
+}
+
+/// reset() clears every core's shard
+TEST_F(TimingsTest, ResetClearsAllCores) {
+    Hdr1sfMicroSecHistogram set;
+    collectConcurrently(ClientOpcode::Set, set);
+    timings.reset();
+
+    EXPECT_EQ(0,
+              timings.get_timing_histogram(uint8_t(ClientOpcode::Set))
+                      .getValueCount());
+    EXPECT_EQ(0, timings.get_aggregated_mutation_stats());
+}
+
+/**
+ * Histograms are only allocated for the opcodes used, and at most one per
+ * core for each.
+ */
+TEST_F(TimingsTest, MemFootprintBound) {
+    EXPECT_EQ(0, timings.get_mem_footprint());
+
+    const auto histogramSize = Hdr1sfMicroSecHistogram().getMemFootPrint();
+    EXPECT_LT(histogramSize, 4096) << "Update the estimate in timings.h";
+
+    Hdr1sfMicroSecHistogram set;
+    collectConcurrently(ClientOpcode::Set, set);
+    const auto footprint = timings.get_mem_footprint();
+    EXPECT_GE(footprint, histogramSize);
+    EXPECT_LE(footprint, cb::get_cpu_count() * histogramSize);
+}
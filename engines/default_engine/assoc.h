@@ -1,13 +1,102 @@
 #pragma once
 
 #include <memcached/engine_error.h>
+#include <platform/platform_thread.h>
 
 #include "items.h"
 
-/* associative array */
-ENGINE_ERROR_CODE assoc_init(struct default_engine *engine);
-void assoc_destroy();
-hash_item *assoc_find(uint32_t hash, const hash_key* key);
-int assoc_insert(uint32_t hash, hash_item *item);
-void assoc_delete(uint32_t hash, const hash_key* key);
-bool assoc_expanding();
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * Associative array mapping keys to items for a single bucket.
+ *
+ * Each bucket has its own table (rather than all buckets sharing one
+ * process-wide table), guarded by its own mutex. Callers already serialise
+ * on the bucket's items.lock, so the mutex only needs to order the
+ * front-end operations against the maintenance thread.
+ *
+ * Expansion is performed incrementally by a maintenance thread which
+ * migrates one old bucket at a time, taking the mutex for each bucket so
+ * front-end operations can interleave with it.
+ */
+class Assoc {
+public:
+    /**
+     * @param hashpower the table initially has 2^hashpower buckets
+     */
+    explicit Assoc(unsigned int hashpower);
+
+    /// Waits for any in-progress expansion to complete.
+    ~Assoc();
+
+    hash_item* find(uint32_t hash, const hash_key* key);
+
+    /* Note: this isn't an update. The key must not already exist */
+    int insert(uint32_t hash, hash_item* it);
+
+    void remove(uint32_t hash, const hash_key* key);
+
+    bool isExpanding() const {
+        return expanding;
+    }
+
+    unsigned int getNumItems() const {
+        return hash_items;
+    }
+
+private:
+    /* Returns the chain head for the given hash; mutex must be held */
+    hash_item** getBucket(uint32_t hash);
+
+    /*
+     * Returns the address of the item pointer before the key. If *item == 0,
+     * the item wasn't found. mutex must be held.
+     */
+    hash_item** hashItemBefore(uint32_t hash, const hash_key* key);
+
+    /* Grows the hashtable to the next power of 2 if still required. */
+    void expand();
+
+    static void maintenanceThread(void* arg);
+    void migrateOldBuckets();
+
+    /* how many powers of 2's worth of buckets we use; changes only with
+     * maintenanceMutex and mutex held */
+    unsigned int hashpower;
+
+    /* Main hash table. This is where we look except during expansion. */
+    std::vector<hash_item*> primary_hashtable;
+
+    /*
+     * Previous hash table. During expansion, we look here for keys that haven't
+     * been moved over to the primary yet.
+     */
+    std::vector<hash_item*> old_hashtable;
+
+    /* Number of items in the hash table. */
+    std::atomic<unsigned int> hash_items{0};
+
+    /* Flag: Are we in the middle of expanding now? Changes only with mutex
+     * held */
+    std::atomic<bool> expanding{false};
+
+    /*
+     * During expansion we migrate values with bucket granularity; this is how
+     * far we've gotten so far. Ranges from 0 .. hashsize(hashpower - 1) - 1.
+     * Advanced only while holding mutex.
+     */
+    std::atomic<unsigned int> expand_bucket{0};
+
+    /* serialise access to the hashtable */
+    std::mutex mutex;
+
+    /* Serialises starting the maintenance thread with joining it */
+    std::mutex maintenanceMutex;
+    cb_thread_t maintenanceTid;
+    bool maintenanceRunning{false};
+};
+
+/* Creates the assoc for the given engine */
+ENGINE_ERROR_CODE assoc_init(struct default_engine* engine);
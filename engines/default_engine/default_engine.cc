@@ -109,7 +109,6 @@ ENGINE_ERROR_CODE create_memcache_instance(GET_SERVER_API get_server_api,
 
 void destroy_memcache_engine() {
     engine_manager_shutdown();
-    assoc_destroy();
 }
 
 static struct default_engine* get_handle(EngineIface* handle) {
@@ -145,6 +144,9 @@ void default_engine::destroy(const bool force) {
 
 void destroy_engine_instance(struct default_engine* engine) {
     if (engine->initialized) {
+        /* Destroy the hash table first; it joins the maintenance thread,
+         * which may still be reading the keys of items in the slabs */
+        engine->assoc.reset();
         /* Destory the slabs cache */
         slabs_destroy(engine);
 
@@ -13,6 +13,7 @@
 #include <relaxed_atomic.h>
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 /** How long an object can reasonably be assumed to be locked before
@@ -232,6 +233,9 @@ struct default_engine : public EngineIface {
     struct slabs slabs;
     struct items items;
 
+    /* Per-bucket hash table of linked items */
+    std::unique_ptr<Assoc> assoc;
+
     struct config config;
     struct engine_stats stats;
     struct engine_scrubber scrubber;
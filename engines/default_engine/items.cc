@@ -42,6 +42,13 @@ static int do_item_replace(struct default_engine* engine,
                            hash_item* it,
                            hash_item* new_it);
 static void item_free(struct default_engine *engine, hash_item *it);
+static void item_init(hash_item* it,
+                      unsigned int id,
+                      const hash_key* key,
+                      const int flags,
+                      const rel_time_t exptime,
+                      const int nbytes,
+                      uint8_t datatype);
 
 static bool hash_key_create(hash_key* hkey,
                             const DocKey& key,
@@ -213,12 +220,22 @@ hash_item *do_item_alloc(struct default_engine *engine,
         }
     }
 
+    cb_assert(it != engine->items.heads[id]);
+    item_init(it, id, key, flags, exptime, nbytes, datatype);
+    return it;
+}
+
+/* Initialize a chunk fresh from the slab allocator as a new item */
+static void item_init(hash_item* it,
+                      unsigned int id,
+                      const hash_key* key,
+                      const int flags,
+                      const rel_time_t exptime,
+                      const int nbytes,
+                      uint8_t datatype) {
     cb_assert(it->slabs_clsid == 0);
 
     it->slabs_clsid = id;
-
-    cb_assert(it != engine->items.heads[it->slabs_clsid]);
-
     it->next = it->prev = it->h_next = nullptr;
     it->refcount = 1;     /* the caller will have a reference */
     DEBUG_REFCNT(it, '*');
@@ -229,7 +246,6 @@ hash_item *do_item_alloc(struct default_engine *engine,
     it->exptime = exptime;
     it->locktime = 0;
     hash_key_copy_to_item(it, key);
-    return it;
 }
 
 static void item_free(struct default_engine *engine, hash_item *it) {
@@ -297,8 +313,8 @@ int do_item_link(struct default_engine *engine,
     it->iflag |= ITEM_LINKED;
     it->time = engine->server.core->get_current_time();
 
-    assoc_insert(crc32c(hash_key_get_key(key), hash_key_get_key_len(key), 0),
-                 it);
+    engine->assoc->insert(
+            crc32c(hash_key_get_key(key), hash_key_get_key_len(key), 0), it);
 
     engine->stats.curr_bytes += ITEM_ntotal(engine, it);
     engine->stats.curr_items += 1;
@@ -336,8 +352,9 @@ void do_item_unlink(struct default_engine *engine, hash_item *it) {
         it->iflag &= ~ITEM_LINKED;
         engine->stats.curr_bytes -= ITEM_ntotal(engine, it);
         engine->stats.curr_items -= 1;
-        assoc_delete(crc32c(hash_key_get_key(key), hash_key_get_key_len(key), 0),
-                     key);
+        engine->assoc->remove(
+                crc32c(hash_key_get_key(key), hash_key_get_key_len(key), 0),
+                key);
         item_unlink_q(engine, it);
         if (it->refcount == 0 || engine->scrubber.force_delete) {
             item_free(engine, it);
@@ -362,9 +379,10 @@ ENGINE_ERROR_CODE do_safe_item_unlink(struct default_engine* engine,
             stored->iflag &= ~ITEM_LINKED;
             engine->stats.curr_bytes -= ITEM_ntotal(engine, stored);
             engine->stats.curr_items -= 1;
-            assoc_delete(crc32c(hash_key_get_key(key),
-                                hash_key_get_key_len(key), 0),
-                         key);
+            engine->assoc->remove(crc32c(hash_key_get_key(key),
+                                         hash_key_get_key_len(key),
+                                         0),
+                                  key);
             item_unlink_q(engine, stored);
             if (stored->refcount == 0 || engine->scrubber.force_delete) {
                 item_free(engine, stored);
@@ -505,14 +523,13 @@ static void do_item_stats_sizes(struct default_engine* engine,
     }
 }
 
-/** wrapper around assoc_find which does the lazy expiration logic */
+/** wrapper around Assoc::find which does the lazy expiration logic */
 hash_item* do_item_get(struct default_engine* engine,
                        const hash_key* key,
                        const DocStateFilter documentStateFilter) {
     rel_time_t current_time = engine->server.core->get_current_time();
-    hash_item *it = assoc_find(crc32c(hash_key_get_key(key),
-                                      hash_key_get_key_len(key), 0),
-                               key);
+    hash_item* it = engine->assoc->find(
+            crc32c(hash_key_get_key(key), hash_key_get_key_len(key), 0), key);
 
     if (it != nullptr && engine->config.oldest_live != 0 &&
         engine->config.oldest_live <= current_time &&
@@ -646,7 +663,18 @@ hash_item* item_alloc(struct default_engine* engine,
         return nullptr;
     }
 
-    {
+    /* Reuse a chunk this thread freed recently if possible; that needs
+     * neither the items lock nor the slab class lock. Otherwise fall back
+     * to the full path which may reclaim or evict items from the LRU. */
+    const size_t ntotal =
+            sizeof(hash_item) + hash_key_get_alloc_size(&hkey) + nbytes;
+    const unsigned int id = slabs_clsid(engine, ntotal);
+    it = (id == 0) ? nullptr
+                   : static_cast<hash_item*>(
+                             slabs_alloc_cached(engine, ntotal, id));
+    if (it != nullptr) {
+        item_init(it, id, &hkey, flags, exptime, nbytes, datatype);
+    } else {
         std::lock_guard<std::mutex> guard(engine->items.lock);
         it = do_item_alloc(
                 engine, &hkey, flags, exptime, nbytes, cookie, datatype);
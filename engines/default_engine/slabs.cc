@@ -24,12 +24,40 @@
 
 #include "default_engine_internal.h"
 
+#include <atomic>
+
 /*
  * Forward Declarations
  */
 static int do_slabs_newslab(struct default_engine *engine, const unsigned int id);
 static void *memory_allocate(struct default_engine *engine, size_t size);
 
+/*
+ * Front-end threads are spread round-robin over the magazines of each slab
+ * class the first time they allocate or free.
+ */
+static unsigned int magazine_slot() {
+    static std::atomic<unsigned int> next_slot{0};
+    static thread_local const unsigned int slot =
+            next_slot++ % SLAB_MAGAZINE_SLOTS;
+    return slot;
+}
+
+static slab_magazine_t& get_magazine(struct default_engine* engine,
+                                     unsigned int id,
+                                     unsigned int slot) {
+    return engine->slabs.magazines[id * SLAB_MAGAZINE_SLOTS + slot];
+}
+
+/* Take a chunk from the magazine, or nullptr if empty. mag.lock must be held */
+static void* magazine_pop(slab_magazine_t& mag, size_t size) {
+    if (mag.count == 0) {
+        return nullptr;
+    }
+    mag.requested += size;
+    return mag.chunks[--mag.count];
+}
+
 #ifndef DONT_PREALLOC_SLABS
 /* Preallocate as many slab pages as possible (called from slabs_init)
    on start-up, so users don't get confused out-of-memory errors when
@@ -121,6 +149,13 @@ ENGINE_ERROR_CODE slabs_init(struct default_engine *engine,
     engine->slabs.slabclass[engine->slabs.power_largest].size = (unsigned int)engine->config.item_size_max;
     engine->slabs.slabclass[engine->slabs.power_largest].perslab = 1;
 
+    try {
+        engine->slabs.magazines = std::make_unique<slab_magazine_t[]>(
+                (engine->slabs.power_largest + 1) * SLAB_MAGAZINE_SLOTS);
+    } catch (const std::bad_alloc&) {
+        return ENGINE_ENOMEM;
+    }
+
     /* for the test suite:  faking of how much we've already malloc'd */
     {
         char *t_initial_malloc = getenv("T_MEMD_INITIAL_MALLOC");
@@ -176,28 +211,38 @@ static int grow_slab_list (struct default_engine *engine, const unsigned int id)
     return 1;
 }
 
+/* The class lock for id must be held */
 static int do_slabs_newslab(struct default_engine *engine, const unsigned int id) {
     slabclass_t *p = &engine->slabs.slabclass[id];
     int len = p->size * p->perslab;
     char *ptr;
 
-    if ((engine->slabs.mem_limit && engine->slabs.mem_malloced + len > engine->slabs.mem_limit && p->slabs > 0) ||
-        (grow_slab_list(engine, id) == 0) ||
-        ((ptr = static_cast<char*>(memory_allocate(engine, (size_t)len))) == nullptr)) {
-
+    if (grow_slab_list(engine, id) == 0) {
         return 0;
     }
 
+    {
+        std::lock_guard<std::mutex> guard(engine->slabs.lock);
+        if ((engine->slabs.mem_limit &&
+             engine->slabs.mem_malloced + len > engine->slabs.mem_limit &&
+             p->slabs > 0) ||
+            ((ptr = static_cast<char*>(
+                      memory_allocate(engine, (size_t)len))) == nullptr)) {
+            return 0;
+        }
+        engine->slabs.mem_malloced += len;
+    }
+
     memset(ptr, 0, (size_t)len);
     p->end_page_ptr = ptr;
     p->end_page_free = p->perslab;
 
     p->slab_list[p->slabs++] = ptr;
-    engine->slabs.mem_malloced += len;
 
     return 1;
 }
 
+/* The class lock for id must be held */
 /*@null@*/
 static void *do_slabs_alloc(struct default_engine *engine, const size_t size, unsigned int id) {
     slabclass_t *p;
@@ -210,6 +255,7 @@ static void *do_slabs_alloc(struct default_engine *engine, const size_t size, un
     p = &engine->slabs.slabclass[id];
 
 #ifdef USE_SYSTEM_MALLOC
+    std::lock_guard<std::mutex> guard(engine->slabs.lock);
     if (engine->slabs.mem_limit && engine->slabs.mem_malloced + size > engine->slabs.mem_limit) {
         MEMCACHED_SLABS_ALLOCATE_FAILED(size, id);
         return 0;
@@ -247,6 +293,7 @@ static void *do_slabs_alloc(struct default_engine *engine, const size_t size, un
     return ret;
 }
 
+/* The class lock for id must be held */
 static void do_slabs_free(struct default_engine *engine, void *ptr, const size_t size, unsigned int id) {
     slabclass_t *p;
 
@@ -256,6 +303,7 @@ static void do_slabs_free(struct default_engine *engine, void *ptr, const size_t
     p = &engine->slabs.slabclass[id];
 
 #ifdef USE_SYSTEM_MALLOC
+    std::lock_guard<std::mutex> guard(engine->slabs.lock);
     engine->slabs.mem_malloced -= size;
     cb_free(ptr);
     return;
@@ -332,6 +380,21 @@ static void do_slabs_stats(struct default_engine* engine,
     unsigned int total = 0;
 
     for(i = POWER_SMALLEST; i <= engine->slabs.power_largest; i++) {
+        /* Chunks parked in magazines are free as far as the class goes.
+         * All of the class's magazines are held (magazine locks are taken
+         * before the class lock) so chunks moving between a magazine and
+         * the class free list aren't missed or counted twice. */
+        std::array<std::unique_lock<std::mutex>, SLAB_MAGAZINE_SLOTS> guards;
+        unsigned int cached = 0;
+        int64_t cached_requested = 0;
+        for (unsigned int slot = 0; slot < SLAB_MAGAZINE_SLOTS; ++slot) {
+            auto& mag = get_magazine(engine, i, slot);
+            guards[slot] = std::unique_lock<std::mutex>(mag.lock);
+            cached += mag.count;
+            cached_requested += mag.requested;
+        }
+
+        std::lock_guard<std::mutex> guard(engine->slabs.class_locks[i]);
         slabclass_t *p = &engine->slabs.slabclass[i];
         if (p->slabs != 0) {
             uint32_t perslab, slabs;
@@ -347,14 +410,15 @@ static void do_slabs_stats(struct default_engine* engine,
             add_statistics(cookie, add_stats, nullptr, i, "total_chunks", "%u",
                            slabs * perslab);
             add_statistics(cookie, add_stats, nullptr, i, "used_chunks", "%u",
-                           slabs*perslab - p->sl_curr - p->end_page_free);
+                           slabs * perslab - p->sl_curr - cached -
+                                   p->end_page_free);
             add_statistics(cookie, add_stats, nullptr, i, "free_chunks", "%u",
-                           p->sl_curr);
+                           p->sl_curr + cached);
             add_statistics(cookie, add_stats, nullptr, i, "free_chunks_end", "%u",
                            p->end_page_free);
             add_statistics(cookie, add_stats, nullptr, i, "mem_requested",
                            "%" PRIu64,
-                           (uint64_t)p->requested);
+                           (uint64_t)(p->requested + cached_requested));
             total++;
         }
     }
@@ -362,6 +426,7 @@ static void do_slabs_stats(struct default_engine* engine,
     /* add overall slab stats and append terminator */
 
     add_statistics(cookie, add_stats, nullptr, -1, "active_slabs", "%d", total);
+    std::lock_guard<std::mutex> guard(engine->slabs.lock);
     add_statistics(cookie, add_stats, nullptr, -1, "total_malloced", "%" PRIu64,
                    (uint64_t)engine->slabs.mem_malloced);
 }
@@ -395,33 +460,104 @@ static void *memory_allocate(struct default_engine *engine, size_t size) {
     return ret;
 }
 
+void* slabs_alloc_cached(struct default_engine* engine,
+                         size_t size,
+                         unsigned int id) {
+#ifdef USE_SYSTEM_MALLOC
+    return nullptr;
+#else
+    if (id < POWER_SMALLEST || id > engine->slabs.power_largest) {
+        return nullptr;
+    }
+
+    auto& mag = get_magazine(engine, id, magazine_slot());
+    std::lock_guard<std::mutex> guard(mag.lock);
+    return magazine_pop(mag, size);
+#endif
+}
+
 void *slabs_alloc(struct default_engine *engine, size_t size, unsigned int id) {
-    std::lock_guard<std::mutex> guard(engine->slabs.lock);
+#ifdef USE_SYSTEM_MALLOC
     return do_slabs_alloc(engine, size, id);
+#else
+    if (id < POWER_SMALLEST || id > engine->slabs.power_largest) {
+        return nullptr;
+    }
+
+    const auto slot = magazine_slot();
+    void* ret;
+    {
+        auto& mag = get_magazine(engine, id, slot);
+        std::lock_guard<std::mutex> magGuard(mag.lock);
+        ret = magazine_pop(mag, size);
+        if (ret != nullptr) {
+            return ret;
+        }
+
+        std::lock_guard<std::mutex> guard(engine->slabs.class_locks[id]);
+        ret = do_slabs_alloc(engine, size, id);
+
+        /* Top up the magazine from the free list so the next few
+         * allocations don't need the class lock */
+        slabclass_t* p = &engine->slabs.slabclass[id];
+        while (mag.count < SLAB_MAGAZINE_SIZE / 2 && p->sl_curr != 0) {
+            mag.chunks[mag.count++] = p->slots[--p->sl_curr];
+        }
+    }
+
+    if (ret == nullptr) {
+        /* The class is out of memory, but other threads may have free
+         * chunks parked in their magazines */
+        for (unsigned int ii = 1; ii < SLAB_MAGAZINE_SLOTS && ret == nullptr;
+             ++ii) {
+            auto& mag = get_magazine(
+                    engine, id, (slot + ii) % SLAB_MAGAZINE_SLOTS);
+            std::lock_guard<std::mutex> guard(mag.lock);
+            ret = magazine_pop(mag, size);
+        }
+    }
+    return ret;
+#endif
 }
 
 void slabs_free(struct default_engine *engine, void *ptr, size_t size, unsigned int id) {
-    std::lock_guard<std::mutex> guard(engine->slabs.lock);
+    if (id < POWER_SMALLEST || id > engine->slabs.power_largest) {
+        return;
+    }
+
+#ifdef USE_SYSTEM_MALLOC
     do_slabs_free(engine, ptr, size, id);
+#else
+    auto& mag = get_magazine(engine, id, magazine_slot());
+    std::lock_guard<std::mutex> magGuard(mag.lock);
+    if (mag.count == SLAB_MAGAZINE_SIZE) {
+        /* Return half of the magazine to the slab class */
+        std::lock_guard<std::mutex> guard(engine->slabs.class_locks[id]);
+        while (mag.count > SLAB_MAGAZINE_SIZE / 2) {
+            do_slabs_free(engine, mag.chunks[--mag.count], 0, id);
+        }
+    }
+    mag.chunks[mag.count++] = ptr;
+    mag.requested -= size;
+#endif
 }
 
 void slabs_stats(struct default_engine* engine,
                  const AddStatFn& add_stats,
                  const void* c) {
-    std::lock_guard<std::mutex> guard(engine->slabs.lock);
     do_slabs_stats(engine, add_stats, c);
 }
 
 void slabs_adjust_mem_requested(struct default_engine *engine, unsigned int id, size_t old, size_t ntotal)
 {
     slabclass_t *p;
-    std::lock_guard<std::mutex> guard(engine->slabs.lock);
     if (id < POWER_SMALLEST || id > engine->slabs.power_largest) {
         throw std::invalid_argument(
                 "slabs_adjust_mem_requested: Internal error! Invalid slab "
                 "class");
     }
 
+    std::lock_guard<std::mutex> guard(engine->slabs.class_locks[id]);
     p = &engine->slabs.slabclass[id];
     p->requested = p->requested - old + ntotal;
 }
@@ -437,6 +573,9 @@ void slabs_destroy(struct default_engine *e)
     }
     cb_free(e->slabs.allocs.ptrs);
 
+    /* Chunks held by the magazines live in the pages freed above */
+    e->slabs.magazines.reset();
+
     /* Release the freelists */
     for (jj = POWER_SMALLEST; jj <= e->slabs.power_largest; jj++) {
         slabclass_t *p = &e->slabs.slabclass[jj];
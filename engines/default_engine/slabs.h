@@ -4,6 +4,8 @@
 #include <memcached/engine_common.h>
 #include <memcached/engine_error.h>
 
+#include <array>
+#include <memory>
 #include <mutex>
 
 /* Slab sizing definitions. */
@@ -13,6 +15,12 @@
 #define DONT_PREALLOC_SLABS
 #define MAX_NUMBER_OF_SLAB_CLASSES (POWER_LARGEST + 1)
 
+/* Number of magazines per slab class; front-end threads are spread over
+   them round-robin */
+#define SLAB_MAGAZINE_SLOTS 16
+/* Number of free chunks each magazine can hold */
+#define SLAB_MAGAZINE_SIZE 16
+
 /* powers-of-N allocation structures */
 
 typedef struct {
@@ -35,6 +43,19 @@ typedef struct {
     size_t requested; /* The number of requested bytes */
 } slabclass_t;
 
+/*
+ * A small cache of free chunks of one slab class used by a subset of the
+ * front-end threads, letting allocations and frees skip the slab class lock
+ * (and, for allocation, the items lock) in the common case.
+ */
+typedef struct {
+    std::mutex lock;
+    void* chunks[SLAB_MAGAZINE_SIZE];
+    unsigned int count{0};
+    /* Change in requested bytes not yet folded into the slab class */
+    int64_t requested{0};
+} slab_magazine_t;
+
 struct slabs {
    slabclass_t slabclass[MAX_NUMBER_OF_SLAB_CLASSES];
    size_t mem_limit;
@@ -51,8 +72,17 @@ struct slabs {
       size_t size;
    } allocs;
 
+   /* Magazines, SLAB_MAGAZINE_SLOTS per slab class */
+   std::unique_ptr<slab_magazine_t[]> magazines;
+
    /**
-    * Access to the slab allocator is protected by this lock
+    * Each slab class is protected by its own lock
+    */
+   std::array<std::mutex, MAX_NUMBER_OF_SLAB_CLASSES> class_locks;
+
+   /**
+    * Protects the memory shared by all of the slab classes (mem_* and
+    * allocs). Acquired after a class lock when a class needs a new page.
     */
    std::mutex lock;
 };
@@ -83,6 +113,15 @@ unsigned int slabs_clsid(struct default_engine *engine, const size_t size);
 /** Allocate object of given length. 0 on error */ /*@null@*/
 void *slabs_alloc(struct default_engine *engine, size_t size, unsigned int id);
 
+/**
+ * Allocate object of given length from the calling thread's magazine only.
+ * Never takes memory from the slab class itself, so this returns 0 unless
+ * the thread has recently freed a chunk of this class.
+ */
+void* slabs_alloc_cached(struct default_engine* engine,
+                         size_t size,
+                         unsigned int id);
+
 /** Free previously allocated object */
 void slabs_free(struct default_engine *engine, void *ptr, size_t size, unsigned int id);
 
@@ -0,0 +1,161 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to reading the access log during warmup, comparing the
+ * MutationLog format with the sorted (memory-mapped) format.
+ *
+ * These measure reading the log and producing the per-vBucket batches of
+ * keys which warmup passes to getMulti; the disk reads of the documents
+ * themselves are not included.
+ */
+
+#include "mutation_log.h"
+#include "sorted_access_log.h"
+
+#include <benchmark/benchmark.h>
+#include <platform/dirutils.h>
+
+#include <random>
+
+/**
+ * Fixture with an access log of state.range(0) keys spread over 1024
+ * vBuckets, in both formats. Keys are recorded in a random (HashTable) order
+ * with random seqnos, as the AccessScanner would see them.
+ */
+class AccessLogBench : public benchmark::Fixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        if (state.thread_index != 0) {
+            return;
+        }
+        mutationLogPath = cb::io::mktemp("access_log_bench_ml");
+        sortedLogPath = cb::io::mktemp("access_log_bench_sorted");
+
+        const size_t numItems = state.range(0);
+        std::mt19937_64 gen(0);
+        std::vector<std::vector<SortedAccessLogWriter::Entry>> entries(
+                numVBuckets);
+        for (size_t ii = 0; ii < numItems; ++ii) {
+            const auto vb = ii % numVBuckets;
+            entries[vb].push_back(
+                    {gen() % (numItems * 2),
+                     StoredDocKey("key_" + std::to_string(ii),
+                                  CollectionID::Default)});
+        }
+
+        MutationLog mlog(mutationLogPath, 4096);
+        mlog.open();
+        SortedAccessLogWriter writer(sortedLogPath);
+        for (uint16_t vb = 0; vb < numVBuckets; ++vb) {
+            for (const auto& entry : entries[vb]) {
+                mlog.newItem(Vbid(vb), entry.key);
+            }
+            mlog.commit1();
+            mlog.commit2();
+            writer.addRun(Vbid(vb), entries[vb]);
+        }
+        writer.commit();
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        if (state.thread_index != 0) {
+            return;
+        }
+        cb::io::rmrf(mutationLogPath);
+        cb::io::rmrf(sortedLogPath);
+    }
+
+    static constexpr uint16_t numVBuckets = 1024;
+    // Default warmup_batch_size.
+    static constexpr size_t batchSize = 10000;
+
+    std::string mutationLogPath;
+    std::string sortedLogPath;
+};
+
+static bool countKey(void* arg, Vbid, const DocKey&) {
+    ++*static_cast<size_t*>(arg);
+    return true;
+}
+
+/*
+ * Read the MutationLog format access log as Warmup::doWarmup does: harvest a
+ * batch of entries into per-vBucket sets, then visit each key.
+ * Variables:
+ *  - range(0) : Number of keys in the log.
+ */
+BENCHMARK_DEFINE_F(AccessLogBench, MutationLogRead)(benchmark::State& state) {
+    size_t keys = 0;
+    while (state.KeepRunning()) {
+        MutationLog mlog(mutationLogPath);
+        mlog.open(true);
+        MutationLogHarvester harvester(mlog);
+        for (uint16_t vb = 0; vb < numVBuckets; ++vb) {
+            harvester.setVBucket(Vbid(vb));
+        }
+        auto it = mlog.begin();
+        do {
+            it = harvester.loadBatch(it, batchSize);
+            harvester.apply(&keys, &countKey);
+        } while (it != mlog.end());
+    }
+    benchmark::DoNotOptimize(keys);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/*
+ * Read the sorted format access log as Warmup::doWarmup does: map and
+ * validate the file, then build each vBucket's batches of keys in seqno
+ * order.
+ * Variables:
+ *  - range(0) : Number of keys in the log.
+ */
+BENCHMARK_DEFINE_F(AccessLogBench, SortedLogRead)(benchmark::State& state) {
+    size_t keys = 0;
+    std::vector<DocKey> batch;
+    while (state.KeepRunning()) {
+        SortedAccessLogReader log(sortedLogPath);
+        for (uint16_t vb = 0; vb < numVBuckets; ++vb) {
+            for (const auto& entry : log.getEntries(Vbid(vb))) {
+                batch.push_back(entry.key);
+                if (batch.size() == batchSize) {
+                    keys += batch.size();
+                    batch.clear();
+                }
+            }
+            keys += batch.size();
+            batch.clear();
+        }
+    }
+    benchmark::DoNotOptimize(keys);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(AccessLogBench, MutationLogRead)
+        ->Arg(100000)
+        ->Arg(1000000)
+        ->Arg(10000000)
+        ->ArgName("Keys")
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(AccessLogBench, SortedLogRead)
+        ->Arg(100000)
+        ->Arg(1000000)
+        ->Arg(10000000)
+        ->ArgName("Keys")
+        ->Unit(benchmark::kMillisecond);
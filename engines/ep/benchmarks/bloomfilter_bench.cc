@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the BloomFilter class.
+ */
+
+#include "bloomfilter.h"
+#include "tests/module_tests/test_helpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * Fixture which populates a BloomFilter with numKeys keys.
+ *
+ * Arguments:
+ *  0: filter type (0 = Bitset, 1 = Blocked)
+ *  1: target false positive probability, in units of 0.1%
+ */
+class BloomFilterBench : public benchmark::Fixture {
+public:
+    void SetUp(benchmark::State& state) override {
+        const auto type = state.range(0) ? BloomFilter::Type::Blocked
+                                         : BloomFilter::Type::Bitset;
+        const double fpProb = state.range(1) / 1000.0;
+        filter = std::make_unique<BloomFilter>(
+                numKeys, fpProb, BFILTER_ENABLED, type);
+        for (size_t i = 0; i < numKeys; i++) {
+            filter->addKey(makeStoredDocKey("key_" + std::to_string(i)));
+        }
+        // Keys for lookups; the second half were never added.
+        keys.reserve(numKeys * 2);
+        for (size_t i = 0; i < numKeys * 2; i++) {
+            keys.push_back(makeStoredDocKey("key_" + std::to_string(i)));
+        }
+    }
+
+    void TearDown(benchmark::State& state) override {
+        filter.reset();
+        keys.clear();
+    }
+
+    // Large enough that the filter doesn't fit in L2.
+    static const size_t numKeys = 1000000;
+
+    std::unique_ptr<BloomFilter> filter;
+    std::vector<StoredDocKey> keys;
+};
+
+// Lookups of keys which are not in the filter - the full-eviction case the
+// filter exists for (avoiding a bgfetch for a non-existent key).
+BENCHMARK_DEFINE_F(BloomFilterBench, MaybeKeyExistsNegative)
+(benchmark::State& state) {
+    size_t i = 0;
+    size_t falsePositives = 0;
+    for (auto _ : state) {
+        falsePositives += filter->maybeKeyExists(keys[numKeys + i]);
+        i = (i + 1) % numKeys;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["fp_rate"] = double(falsePositives) / state.iterations();
+    state.counters["filter_bytes"] = filter->getFilterSize() / 8;
+}
+
+// Lookups of keys which are in the filter (all probes must be checked).
+BENCHMARK_DEFINE_F(BloomFilterBench, MaybeKeyExistsPositive)
+(benchmark::State& state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter->maybeKeyExists(keys[i]));
+        i = (i + 1) % numKeys;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BloomFilterArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"blocked", "fp_per_mille"});
+    for (int blocked : {0, 1}) {
+        // 1% and 0.1% false positive probability
+        for (int fp : {10, 1}) {
+            b->Args({blocked, fp});
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(BloomFilterBench, MaybeKeyExistsNegative)
+        ->Apply(BloomFilterArgs);
+BENCHMARK_REGISTER_F(BloomFilterBench, MaybeKeyExistsPositive)
+        ->Apply(BloomFilterArgs);
@@ -21,8 +21,10 @@
 
 #include "atomic.h"
 #include "checkpoint_iterator.h"
+#include "chunked_queue.h"
 
 #include <benchmark/benchmark.h>
+#include <utilities/memory_tracking_allocator.h>
 #include <list>
 
 typedef std::unique_ptr<int> TestItem;
@@ -59,3 +61,74 @@ static void BM_CheckpointIteratorCompare(benchmark::State& state) {
 
 // Register the function as a benchmark
 BENCHMARK(BM_CheckpointIteratorCompare);
+
+typedef MemoryTrackingAllocator<TestItem> TrackingAllocator;
+// The container previously used for the CheckpointQueue.
+typedef std::list<TestItem, TrackingAllocator> TrackedListContainer;
+// The container now used for the CheckpointQueue.
+typedef ChunkedQueue<TestItem, TrackingAllocator> ChunkedQueueContainer;
+
+/**
+ * Benchmark the cost of queueing items into an (initially empty) checkpoint
+ * queue, reporting the memory used by the container per item.
+ */
+template <class Container>
+static void BM_CheckpointQueuePush(benchmark::State& state) {
+    const size_t numItems = state.range(0);
+    TrackingAllocator allocator;
+    size_t bytesPerItem = 0;
+
+    while (state.KeepRunning()) {
+        Container c(allocator);
+        for (size_t ii = 0; ii < numItems; ++ii) {
+            c.push_back(std::make_unique<int>(ii));
+        }
+        bytesPerItem = *allocator.getBytesAllocated() / numItems;
+
+        // Don't measure the cost of freeing the items.
+        state.PauseTiming();
+        c.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * numItems);
+    state.counters["BytesPerItem"] = bytesPerItem;
+}
+
+/**
+ * Benchmark the throughput of draining a checkpoint queue with a cursor
+ * (as the persistence / DCP cursors do) from start to end.
+ */
+template <class Container>
+static void BM_CheckpointQueueCursorDrain(benchmark::State& state) {
+    using Iterator = CheckpointIterator<Container>;
+    const size_t numItems = state.range(0);
+    TrackingAllocator allocator;
+    Container c(allocator);
+    for (size_t ii = 0; ii < numItems; ++ii) {
+        c.push_back(std::make_unique<int>(ii));
+    }
+
+    const Iterator end(c, Iterator::Position::end);
+    while (state.KeepRunning()) {
+        for (Iterator cursor(c, Iterator::Position::begin); cursor != end;
+             ++cursor) {
+            benchmark::DoNotOptimize(**cursor);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numItems);
+    state.counters["BytesPerItem"] =
+            *allocator.getBytesAllocated() / double(numItems);
+}
+
+BENCHMARK_TEMPLATE(BM_CheckpointQueuePush, TrackedListContainer)
+        ->Arg(1000)
+        ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_CheckpointQueuePush, ChunkedQueueContainer)
+        ->Arg(1000)
+        ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_CheckpointQueueCursorDrain, TrackedListContainer)
+        ->Arg(1000)
+        ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_CheckpointQueueCursorDrain, ChunkedQueueContainer)
+        ->Arg(1000)
+        ->Arg(100000);
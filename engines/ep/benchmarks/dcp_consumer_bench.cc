@@ -0,0 +1,337 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+ * Benchmarks relating to the DcpConsumer / PassiveStream classes.
+ */
+
+#include "checkpoint_manager.h"
+#include "dcp/passive_stream.h"
+#include "engine_fixture.h"
+#include "kv_bucket.h"
+#include "vbucket.h"
+
+#include <mock/mock_dcp_consumer.h>
+#include <mock/mock_stream.h>
+
+#include <thread>
+
+/**
+ * Fixture for a single DcpConsumer with one PassiveStream for each of
+ * numVbuckets replica vBuckets - i.e. the replica side of a rebalance.
+ */
+class DcpConsumerBench : public EngineFixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        // Ephemeral so that the ingest isn't bounded by the flusher.
+        varConfig = "bucket_type=ephemeral;max_vbuckets=" +
+                    std::to_string(numVbuckets) +
+                    ";dcp_consumer_processor_tasks=" +
+                    std::to_string(state.range(0));
+        EngineFixture::SetUp(state);
+
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            engine->getKVBucket()->setVBucketState(Vbid(vb),
+                                                   vbucket_state_replica);
+        }
+
+        consumer = std::make_shared<MockDcpConsumer>(
+                *engine, cookie, "DcpConsumerBench");
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            consumer->addStream(/*opaque*/ vb, Vbid(vb), /*flags*/ 0);
+        }
+        lastSeqno = 0;
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        consumer->closeAllStreams();
+        consumer->cancelTask();
+        consumer.reset();
+        EngineFixture::TearDown(state);
+    }
+
+    /**
+     * Receive one snapshot of itemsPerVb mutations for every vBucket. The
+     * replication throttle is closed while doing so, so every message is
+     * buffered in its PassiveStream for the Processor tasks to apply.
+     */
+    void receiveSnapshots(size_t itemsPerVb) {
+        const std::string value(256, 'x');
+        auto& stats = engine->getEpStats();
+        const ssize_t queueCap = stats.replicationThrottleWriteQueueCap;
+        stats.replicationThrottleWriteQueueCap = 0;
+
+        const uint64_t start = lastSeqno + 1;
+        const uint64_t end = lastSeqno + itemsPerVb;
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            // Release what the previous iteration applied.
+            auto vbucket = engine->getKVBucket()->getVBucket(Vbid(vb));
+            bool newCkptCreated;
+            vbucket->checkpointManager->removeClosedUnrefCheckpoints(
+                    *vbucket, newCkptCreated);
+
+            const auto opaque = *consumer->getStreamOpaque(vb);
+            consumer->snapshotMarker(opaque,
+                                     Vbid(vb),
+                                     start,
+                                     end,
+                                     MARKER_FLAG_MEMORY,
+                                     /*HCS*/ {},
+                                     /*maxVisibleSeqno*/ {});
+            for (uint64_t seqno = start; seqno <= end; ++seqno) {
+                const std::string key = "key_" + std::to_string(seqno - start);
+                consumer->mutation(
+                        opaque,
+                        {key, DocKeyEncodesCollectionId::No},
+                        {reinterpret_cast<const uint8_t*>(value.data()),
+                         value.size()},
+                        0, // privileged bytes
+                        PROTOCOL_BINARY_RAW_BYTES, // datatype
+                        0, // cas
+                        Vbid(vb),
+                        0, // flags
+                        seqno, // bySeqno
+                        0, // revSeqno
+                        0, // exptime
+                        0, // locktime
+                        {}, // meta
+                        0); // nru
+            }
+        }
+        lastSeqno = end;
+
+        stats.replicationThrottleWriteQueueCap = queueCap;
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            consumer->public_notifyVbucketReady(Vbid(vb));
+        }
+    }
+
+    static constexpr uint16_t numVbuckets = 1024;
+
+    std::shared_ptr<MockDcpConsumer> consumer;
+    uint64_t lastSeqno = 0;
+};
+
+/*
+ * Rebalance ingest: apply the buffered snapshots of 1024 replica vBuckets
+ * received over one consumer connection, with each of the consumer's
+ * Processor tasks running on its own thread (as they would on the NonIO
+ * threads).
+ * Variables:
+ *  - range(0) : Number of Processor tasks (dcp_consumer_processor_tasks).
+ *  - range(1) : Number of mutations per vBucket per iteration.
+ */
+BENCHMARK_DEFINE_F(DcpConsumerBench, RebalanceIngest)
+(benchmark::State& state) {
+    const size_t numProcessors = consumer->getNumProcessors();
+    const size_t itemsPerVb = state.range(1);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        receiveSnapshots(itemsPerVb);
+        state.ResumeTiming();
+
+        std::vector<std::thread> processors;
+        for (size_t i = 0; i < numProcessors; ++i) {
+            processors.emplace_back([this, i]() {
+                ObjectRegistry::onSwitchThread(engine.get());
+                while (consumer->processBufferedItems(i) != all_processed) {
+                }
+                ObjectRegistry::onSwitchThread(nullptr);
+            });
+        }
+        for (auto& t : processors) {
+            t.join();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * itemsPerVb * numVbuckets);
+}
+
+static void RebalanceIngestArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"Processors", "ItemsPerVb"});
+    for (int processors : {1, 2, 4, 8}) {
+        for (int itemsPerVb : {1, 64}) {
+            b->Args({processors, itemsPerVb});
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(DcpConsumerBench, RebalanceIngest)
+        ->Apply(RebalanceIngestArgs)
+        ->UseRealTime();
+
+/**
+ * Fixture for a single replica vBucket receiving a recorded DCP stream - a
+ * series of snapshots of mutations - into its PassiveStream.
+ */
+class PassiveStreamBench : public EngineFixture {
+protected:
+    /// One recorded DCP_MUTATION
+    struct RecordedMutation {
+        std::string key;
+        uint64_t cas;
+    };
+
+    void SetUp(const benchmark::State& state) override {
+        // Ephemeral so that the apply isn't bounded by the flusher.
+        varConfig = "bucket_type=ephemeral";
+        EngineFixture::SetUp(state);
+        engine->getKVBucket()->setVBucketState(vbid, vbucket_state_replica);
+
+        consumer = std::make_shared<MockDcpConsumer>(
+                *engine, cookie, "PassiveStreamBench");
+        consumer->addStream(/*opaque*/ 0, vbid, /*flags*/ 0);
+        stream = std::dynamic_pointer_cast<MockPassiveStream>(
+                consumer->getVbucketStream(vbid));
+        opaque = *consumer->getStreamOpaque(0);
+
+        // Record one snapshot which is replayed with new seqnos each
+        // iteration.
+        recorded.clear();
+        for (size_t ii = 0; ii < snapshotSize; ++ii) {
+            recorded.push_back({"key_" + std::to_string(ii),
+                                /*cas*/ 0x1000 + ii});
+        }
+        lastSeqno = 0;
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        stream.reset();
+        consumer->closeAllStreams();
+        consumer->cancelTask();
+        consumer.reset();
+        EngineFixture::TearDown(state);
+    }
+
+    /// Release the checkpoints the previous iteration applied.
+    void releaseApplied() {
+        auto vb = engine->getKVBucket()->getVBucket(vbid);
+        bool newCkptCreated;
+        vb->checkpointManager->removeClosedUnrefCheckpoints(*vb,
+                                                            newCkptCreated);
+    }
+
+    /**
+     * Feed the recorded snapshot into the PassiveStream with the replication
+     * throttle closed, so that every message is buffered for
+     * processBufferedMessages.
+     */
+    void bufferSnapshot() {
+        auto& stats = engine->getEpStats();
+        const ssize_t queueCap = stats.replicationThrottleWriteQueueCap;
+        stats.replicationThrottleWriteQueueCap = 0;
+        releaseApplied();
+        replaySnapshot();
+        stats.replicationThrottleWriteQueueCap = queueCap;
+    }
+
+    /**
+     * Feed the recorded snapshot into the PassiveStream through the
+     * DcpConsumer, as DCP_SNAPSHOT_MARKER and DCP_MUTATION messages.
+     */
+    void replaySnapshot() {
+        consumer->snapshotMarker(opaque,
+                                 vbid,
+                                 lastSeqno + 1,
+                                 lastSeqno + recorded.size(),
+                                 MARKER_FLAG_MEMORY | MARKER_FLAG_CHK,
+                                 /*HCS*/ {},
+                                 /*maxVisibleSeqno*/ {});
+        for (const auto& mutation : recorded) {
+            consumer->mutation(
+                    opaque,
+                    {mutation.key, DocKeyEncodesCollectionId::No},
+                    {reinterpret_cast<const uint8_t*>(value.data()),
+                     value.size()},
+                    0, // privileged bytes
+                    PROTOCOL_BINARY_RAW_BYTES, // datatype
+                    mutation.cas,
+                    vbid,
+                    0, // flags
+                    ++lastSeqno, // bySeqno
+                    1, // revSeqno
+                    0, // exptime
+                    0, // locktime
+                    {}, // meta
+                    0); // nru
+        }
+    }
+
+    static constexpr size_t snapshotSize = 10000;
+
+    std::shared_ptr<MockDcpConsumer> consumer;
+    std::shared_ptr<MockPassiveStream> stream;
+    uint32_t opaque = 0;
+    std::vector<RecordedMutation> recorded;
+    const std::string value = std::string(256, 'x');
+    uint64_t lastSeqno = 0;
+};
+
+/*
+ * Apply a recorded snapshot of mutations buffered in a PassiveStream, as the
+ * DcpConsumerTask does.
+ * Variables:
+ *  - range(0) : Number of messages per processBufferedMessages call (the
+ *               batch size); 1 applies every mutation on its own.
+ */
+BENCHMARK_DEFINE_F(PassiveStreamBench, ApplyBufferedSnapshot)
+(benchmark::State& state) {
+    const size_t batchSize = state.range(0);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        bufferSnapshot();
+        state.ResumeTiming();
+
+        uint32_t bytes = 0;
+        while (stream->getNumBufferItems() > 0) {
+            stream->processBufferedMessages(bytes, batchSize);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * snapshotSize);
+}
+
+BENCHMARK_REGISTER_F(PassiveStreamBench, ApplyBufferedSnapshot)
+        ->Arg(1)
+        ->Arg(10)
+        ->Arg(100)
+        ->Unit(benchmark::kMillisecond);
+
+/*
+ * Receive a recorded snapshot of mutations with the replication throttle
+ * open, so the PassiveStream applies each one as it arrives
+ * (PassiveStream::messageReceived) rather than buffering it.
+ */
+BENCHMARK_DEFINE_F(PassiveStreamBench, ReceiveSnapshot)
+(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        releaseApplied();
+        state.ResumeTiming();
+
+        replaySnapshot();
+    }
+
+    if (stream->getNumBufferItems() > 0) {
+        state.SkipWithError("Mutations were buffered, not applied directly");
+    }
+    state.SetItemsProcessed(state.iterations() * snapshotSize);
+}
+
+BENCHMARK_REGISTER_F(PassiveStreamBench, ReceiveSnapshot)
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,156 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the DcpProducer / ActiveStream classes.
+ */
+
+#include "checkpoint_manager.h"
+#include "dcp/active_stream_checkpoint_processor_task.h"
+#include "engine_fixture.h"
+#include "item.h"
+#include "kv_bucket.h"
+#include "vbucket.h"
+
+#include <mock/mock_dcp.h>
+#include <mock/mock_dcp_producer.h>
+#include <mock/mock_stream.h>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * Fixture for a single DcpProducer with one in-memory ActiveStream for each
+ * of numVbuckets vBuckets.
+ */
+class DcpProducerBench : public EngineFixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        // Ephemeral so the checkpoints can be released each iteration
+        // without having to flush.
+        varConfig = "bucket_type=ephemeral;max_vbuckets=" +
+                    std::to_string(numVbuckets);
+        EngineFixture::SetUp(state);
+
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            engine->getKVBucket()->setVBucketState(Vbid(vb),
+                                                   vbucket_state_active);
+        }
+
+        producer = std::make_shared<MockDcpProducer>(
+                *engine, cookie, "DcpProducerBench", 0, false /*startTask*/);
+        producer->createCheckpointProcessorTask();
+
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            auto vbucket = engine->getKVBucket()->getVBucket(Vbid(vb));
+            producer->mockActiveStreamRequest(0 /*flags*/,
+                                              0 /*opaque*/,
+                                              *vbucket,
+                                              0 /*st_seqno*/,
+                                              ~0 /*en_seqno*/,
+                                              0 /*vb_uuid*/,
+                                              0 /*snap_start_seqno*/,
+                                              ~0 /*snap_end_seqno*/);
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        producer->closeAllStreams();
+        producer->cancelCheckpointCreatorTask();
+        producer.reset();
+        EngineFixture::TearDown(state);
+    }
+
+    /// Store itemsPerVb items into every vBucket and notify the producer.
+    void storeItems(size_t itemsPerVb) {
+        const std::string value(256, 'x');
+        for (uint16_t vb = 0; vb < numVbuckets; ++vb) {
+            auto vbucket = engine->getKVBucket()->getVBucket(Vbid(vb));
+            // Start from a new checkpoint so that re-using the keys doesn't
+            // de-duplicate, and release what the streams have already sent.
+            bool newCkptCreated;
+            vbucket->checkpointManager->createNewCheckpoint();
+            vbucket->checkpointManager->removeClosedUnrefCheckpoints(
+                    *vbucket, newCkptCreated);
+
+            for (size_t ii = 0; ii < itemsPerVb; ++ii) {
+                auto item = make_item(
+                        Vbid(vb), "key_" + std::to_string(ii), value);
+                engine->getKVBucket()->set(item, cookie);
+            }
+            producer->notifySeqnoAvailable(Vbid(vb),
+                                           vbucket->getHighSeqno(),
+                                           SyncWriteOperation::No);
+        }
+    }
+
+    /// Step the producer until the given number of mutations have been sent.
+    void drainMutations(MockDcpMessageProducers& producers, size_t expected) {
+        size_t mutations = 0;
+        while (mutations < expected) {
+            if (producer->step(&producers) == ENGINE_SUCCESS &&
+                producers.last_op == cb::mcbp::ClientOpcode::DcpMutation) {
+                ++mutations;
+            }
+        }
+    }
+
+    static constexpr uint16_t numVbuckets = 1024;
+
+    std::shared_ptr<MockDcpProducer> producer;
+};
+
+/*
+ * Front-end thread draining a producer with 1024 streams, while the
+ * ActiveStreamCheckpointProcessorTask concurrently fills the streams' readyQs
+ * from a second thread (as it would on a NonIO thread).
+ * Variables:
+ *  - range(0) : Number of mutations per vBucket per iteration.
+ */
+BENCHMARK_DEFINE_F(DcpProducerBench, StreamReadyQueue)
+(benchmark::State& state) {
+    const size_t itemsPerVb = state.range(0);
+    MockDcpMessageProducers producers(engine.get());
+
+    auto* task = producer->getCheckpointSnapshotTask();
+    std::atomic<bool> stop{false};
+    std::thread processor([this, task, &stop]() {
+        ObjectRegistry::onSwitchThread(engine.get());
+        while (!stop) {
+            task->run();
+        }
+        ObjectRegistry::onSwitchThread(nullptr);
+    });
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        storeItems(itemsPerVb);
+        state.ResumeTiming();
+
+        drainMutations(producers, itemsPerVb * numVbuckets);
+    }
+
+    stop = true;
+    processor.join();
+
+    state.SetItemsProcessed(state.iterations() * itemsPerVb * numVbuckets);
+}
+
+BENCHMARK_REGISTER_F(DcpProducerBench, StreamReadyQueue)
+        ->Arg(1)
+        ->Arg(64)
+        ->UseRealTime();
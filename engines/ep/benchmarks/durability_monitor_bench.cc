@@ -0,0 +1,117 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+/*
+ * Benchmarks relating to the DurabilityMonitor classes.
+ */
+
+#include "durability/active_durability_monitor.h"
+#include "engine_fixture.h"
+#include "item.h"
+#include "kv_bucket.h"
+#include "vbucket.h"
+
+#include "tests/module_tests/test_helpers.h"
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+
+class ActiveDurabilityMonitorBench : public EngineFixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        EngineFixture::SetUp(state);
+        engine->getKVBucket()->setVBucketState(vbid, vbucket_state_active);
+        vb = engine->getKVBucket()->getVBucket(vbid);
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        vb.reset();
+        EngineFixture::TearDown(state);
+    }
+
+    /**
+     * Create an ActiveDM tracking numWrites Majority Prepares (seqnos
+     * [1, numWrites]). The chain has 3 replicas so that no Prepare is ever
+     * satisfied by the acks of a single replica, which keeps the benchmark
+     * to the cost of ack processing alone.
+     */
+    std::unique_ptr<ActiveDurabilityMonitor> makeADM(size_t numWrites) {
+        auto adm = std::make_unique<ActiveDurabilityMonitor>(
+                engine->getEpStats(), *vb);
+        adm->setReplicationTopology(nlohmann::json::array(
+                {{"active", "replica1", "replica2", "replica3"}}));
+
+        for (size_t seqno = 1; seqno <= numWrites; ++seqno) {
+            queued_item item(new Item(
+                    makeStoredDocKey("key" + std::to_string(seqno)),
+                    0 /*flags*/,
+                    0 /*exp*/,
+                    "value",
+                    5 /*valueSize*/,
+                    PROTOCOL_BINARY_RAW_BYTES,
+                    0 /*cas*/,
+                    seqno));
+            item->setPendingSyncWrite(
+                    {cb::durability::Level::Majority,
+                     cb::durability::Timeout::Infinity()});
+            adm->addSyncWrite(nullptr /*cookie*/, item);
+        }
+        return adm;
+    }
+
+    VBucketPtr vb;
+};
+
+/*
+ * Replicas acking every tracked Prepare of an ActiveDM, a batch of Prepares
+ * per seqno-ack.
+ * Variables:
+ *  - range(0) : Number of tracked Prepares
+ *  - range(1) : Number of Prepares covered by each seqno-ack
+ */
+BENCHMARK_DEFINE_F(ActiveDurabilityMonitorBench, SeqnoAckReceived)
+(benchmark::State& state) {
+    const size_t numWrites = state.range(0);
+    const size_t ackBatch = state.range(1);
+    const std::array<std::string, 2> replicas{{"replica1", "replica2"}};
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        auto adm = makeADM(numWrites);
+        state.ResumeTiming();
+
+        for (const auto& replica : replicas) {
+            for (size_t seqno = ackBatch; seqno <= numWrites;
+                 seqno += ackBatch) {
+                adm->seqnoAckReceived(replica, seqno);
+            }
+        }
+
+        state.PauseTiming();
+        adm.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * replicas.size() * numWrites);
+}
+
+BENCHMARK_REGISTER_F(ActiveDurabilityMonitorBench, SeqnoAckReceived)
+        ->Args({10000, 1})
+        ->Args({10000, 100})
+        ->Args({100000, 1000});
@@ -29,6 +29,7 @@
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <relaxed_atomic.h>
+#include <atomic>
 #include <random>
 
 /**
@@ -108,6 +109,56 @@ BENCHMARK_DEFINE_F(ExecutorBench, OneShotScheduleRun)(benchmark::State& state) {
     state.SetItemsProcessed(consumerCount);
 }
 
+/**
+ * Benchmark throughput of many tiny Tasks. Each iteration schedules a batch
+ * of Tasks which do (almost) no work, then waits for all of them to have run.
+ *
+ * With the Task body being trivial, this measures the overhead of the
+ * ExecutorPool itself - moving ready Tasks to be run and dispatching them to
+ * the NonIO threads - and in particular how that scales as threads are
+ * added.
+ *
+ * Variables:
+ *  - range(0) : Number of NonIO threads.
+ *  - range(1) : Number of Tasks scheduled per iteration.
+ */
+BENCHMARK_DEFINE_F(ExecutorBench, ManyTinyTasks)(benchmark::State& state) {
+    const auto numThreads = state.range(0);
+    const auto tasksPerIteration = state.range(1);
+    makePool(numThreads);
+
+    folly::Baton allDone;
+    std::atomic<int64_t> remaining{0};
+    auto tinyFn = [&allDone, &remaining](LambdaTask&) {
+        if (--remaining == 0) {
+            allDone.post();
+        }
+        return false;
+    };
+
+    std::vector<ExTask> tasks;
+    tasks.reserve(tasksPerIteration);
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        tasks.clear();
+        for (int64_t i = 0; i < tasksPerIteration; i++) {
+            tasks.push_back(std::make_shared<LambdaTask>(
+                    taskable, TaskId::ItemPager, 0, true, tinyFn));
+        }
+        remaining = tasksPerIteration;
+        allDone.reset();
+        state.ResumeTiming();
+
+        for (auto& task : tasks) {
+            pool->schedule(task);
+        }
+        allDone.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * tasksPerIteration);
+
+    shutdownPool();
+}
+
 /**
  * Benchmark the performance of scheduling a Task to run in the future,
  * but it is cancelled shortly after (before running).
@@ -373,12 +424,25 @@ BENCHMARK_REGISTER_F(FollyExecutorBench, OneShotScheduleRun)
         ->ThreadRange(1, 16)
         ->UseRealTime();
 
+BENCHMARK_REGISTER_F(ExecutorBench, ManyTinyTasks)
+        ->Ranges({{1, 16}, {1000, 1000}})
+        ->ArgNames({"Threads", "Tasks"})
+        ->UseRealTime();
+
 BENCHMARK_REGISTER_F(ExecutorBench, TimeoutAddCancel)
         ->ThreadRange(1, 16)
         ->Range(1000, 30000)
         ->ArgName("Timeouts")
         ->UseRealTime();
 
+// 1M pending tasks, to show snooze() cost no longer grows with the number of
+// tasks in the futureQueue.
+BENCHMARK_REGISTER_F(ExecutorBench, TimeoutAddCancel)
+        ->Threads(1)
+        ->Arg(1000000)
+        ->ArgName("Timeouts")
+        ->UseRealTime();
+
 BENCHMARK_REGISTER_F(FollyExecutorBench, TimeoutAddCancel)
         ->ThreadRange(1, 16)
         ->Range(1000, 30000)
@@ -26,6 +26,9 @@
 #include <engines/ep/src/syncobject.h>
 #include <folly/portability/GTest.h>
 #include <spdlog/fmt/fmt.h>
+#include <utilities/hdrhistogram.h>
+
+#include <thread>
 
 // Benchmarks inserting items into a HashTable
 class HashTableBench : public benchmark::Fixture {
@@ -367,6 +370,62 @@ BENCHMARK_DEFINE_F(HashTableBench, HTStatsEpilogue)(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+// Benchmark the latency of finding items while another thread repeatedly
+// resizes the HashTable, using either the blocking (arg 0) or the incremental
+// (arg 1) algorithm. Reports lookup latency percentiles as counters.
+BENCHMARK_DEFINE_F(HashTableBench, FindForReadDuringResize)
+(benchmark::State& state) {
+    const bool incremental = state.range(0);
+
+    sharedItems = createUniqueItems("Resize::");
+    for (auto& item : sharedItems) {
+        ASSERT_EQ(MutationStatus::WasClean, ht.set(item));
+    }
+
+    // Alternate between two sizes which are multiples of the lock count, so
+    // incremental resizes never need to fall back to a blocking one.
+    const auto locks = ht.getNumLocks();
+    const std::array<size_t, 2> sizes{
+            {locks * (numItems / (4 * locks)), locks * (4 * numItems / locks)}};
+    ht.resize(sizes[0]);
+
+    std::atomic<bool> done{false};
+    std::thread resizer([this, incremental, &sizes, &done]() {
+        for (size_t i = 1; !done; ++i) {
+            const auto size = sizes[i % sizes.size()];
+            if (incremental) {
+                ht.beginIncrementalResize(size);
+                while (ht.continueIncrementalResize(1024)) {
+                }
+            } else {
+                ht.resize(size);
+            }
+        }
+    });
+
+    // Latency in nanoseconds, up to 60s.
+    HdrHistogram latency(1, 60000000000, 2);
+    while (state.KeepRunning()) {
+        auto& key = sharedItems[state.iterations() % numItems].getKey();
+        const auto start = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(ht.findForRead(key));
+        const auto end = std::chrono::steady_clock::now();
+        latency.addValue(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                     start)
+                        .count());
+    }
+
+    done = true;
+    resizer.join();
+
+    state.counters["p50_ns"] = latency.getValueAtPercentile(50);
+    state.counters["p99_ns"] = latency.getValueAtPercentile(99);
+    state.counters["p99.9_ns"] = latency.getValueAtPercentile(99.9);
+    state.counters["max_ns"] = latency.getMaxValue();
+    state.SetItemsProcessed(state.iterations());
+}
+
 BENCHMARK_REGISTER_F(HashTableBench, FindForRead)
         ->ThreadPerCpu()
         ->Iterations(HashTableBench::numItems);
@@ -392,3 +451,10 @@ BENCHMARK_REGISTER_F(HashTableBench, HTStatsEpilogue)
         ->ThreadPerCpu()
         ->Iterations(HashTableBench::numItems)
         ->Range(1, 1000);
+
+BENCHMARK_REGISTER_F(HashTableBench, FindForReadDuringResize)
+        ->ArgName("incremental")
+        ->Arg(0)
+        ->Arg(1)
+        ->Iterations(HashTableBench::numItems * 10)
+        ->UseRealTime();
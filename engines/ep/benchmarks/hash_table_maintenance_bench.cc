@@ -0,0 +1,196 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the HashTable maintenance visitors (defragmenter,
+ * item compressor, item frequency decayer), comparing each of them walking
+ * the HashTable in its own pass with all of them sharing a single pass via a
+ * CompositeHTVisitor (as HashTableMaintenance does).
+ *
+ * The visitors are configured so they do (almost) no work of their own -
+ * nothing is old enough to defragment and the compressor is passive - to
+ * measure the cost of the traversal itself.
+ */
+
+#include "collections/vbucket_manifest.h"
+#include "defragmenter.h"
+#include "defragmenter_visitor.h"
+#include "ep_vb.h"
+#include "failover-table.h"
+#include "hash_table_maintenance.h"
+#include "item.h"
+#include "item_compressor_visitor.h"
+#include "item_freq_decayer_visitor.h"
+#include "tests/module_tests/test_helpers.h"
+#include "tests/module_tests/vbucket_test.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/portability/GTest.h>
+#include <valgrind/valgrind.h>
+
+#include <functional>
+
+class HashTableMaintenanceBench : public benchmark::Fixture {
+public:
+    void SetUp(::benchmark::State& state) override {
+        vbucket.reset(
+                new EPVBucket(Vbid(0),
+                              vbucket_state_active,
+                              globalStats,
+                              checkpointConfig,
+                              /*kvshard*/ nullptr,
+                              /*lastSeqno*/ 1000,
+                              /*lastSnapStart*/ 0,
+                              /*lastSnapEnd*/ 0,
+                              /*table*/ nullptr,
+                              std::make_shared<DummyCB>(),
+                              /*newSeqnoCb*/ nullptr,
+                              [](Vbid) { return; },
+                              NoopSyncWriteCompleteCb,
+                              NoopSeqnoAckCb,
+                              config,
+                              EvictionPolicy::Value,
+                              std::make_unique<Collections::VB::Manifest>()));
+
+        // Use a large number of documents for normal runs (to exceed the D$,
+        // as in production), but only enough for functional testing when
+        // running under Valgrind.
+        const size_t ndocs = RUNNING_ON_VALGRIND ? 10 : 500000;
+        vbucket->ht.resize(ndocs);
+        char value[256];
+        for (size_t i = 0; i < ndocs; i++) {
+            std::string key = "key" + std::to_string(i);
+            Item item(makeStoredDocKey(key), 0, 0, value, sizeof(value));
+            ASSERT_EQ(MutationStatus::WasClean, vbucket->ht.set(item));
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+        vbucket.reset();
+    }
+
+protected:
+    /// A maintenance visitor, and how to set its deadline for a chunk.
+    struct Concern {
+        std::unique_ptr<VBucketAwareHTVisitor> visitor;
+        std::function<void(std::chrono::steady_clock::time_point)> setDeadline;
+    };
+
+    /// Create the first n of the defragmenter, compressor and freq decayer
+    /// visitors. The defragmenter (which may free StoredValues) is last.
+    std::vector<Concern> createConcerns(size_t n) {
+        std::vector<Concern> concerns;
+        if (n >= 2) {
+            auto visitor = std::make_unique<ItemCompressorVisitor>();
+            visitor->setCompressionMode(BucketCompressionMode::Passive);
+            auto* raw = visitor.get();
+            concerns.push_back({std::move(visitor), [raw](auto deadline) {
+                                    raw->setDeadline(deadline);
+                                }});
+        }
+        if (n >= 3) {
+            auto visitor = std::make_unique<ItemFreqDecayerVisitor>(50);
+            auto* raw = visitor.get();
+            concerns.push_back({std::move(visitor), [raw](auto deadline) {
+                                    raw->setDeadline(deadline);
+                                }});
+        }
+        auto visitor = std::make_unique<DefragmentVisitor>(
+                DefragmenterTask::getMaxValueSize());
+        visitor->setBlobAgeThreshold(std::numeric_limits<uint8_t>::max());
+        auto* raw = visitor.get();
+        concerns.push_back({std::move(visitor), [raw](auto deadline) {
+                                raw->setDeadline(deadline);
+                            }});
+
+        for (auto& concern : concerns) {
+            concern.visitor->setCurrentVBucket(*vbucket);
+        }
+        return concerns;
+    }
+
+    /// Walk the HashTable with the given visitor, in chunks of (at most)
+    /// chunkDuration.
+    void visitAll(VBucketAwareHTVisitor& visitor,
+                  const std::vector<Concern*>& concerns) {
+        HashTable::Position pos;
+        while (pos != vbucket->ht.endPosition()) {
+            const auto deadline =
+                    std::chrono::steady_clock::now() + chunkDuration;
+            for (auto* concern : concerns) {
+                concern->setDeadline(deadline);
+            }
+            pos = vbucket->ht.pauseResumeVisit(visitor, pos);
+        }
+    }
+
+    // defragmenter_chunk_duration, item_compressor_chunk_duration etc.
+    const std::chrono::milliseconds chunkDuration{20};
+
+    std::unique_ptr<VBucket> vbucket;
+    EPStats globalStats;
+    CheckpointConfig checkpointConfig;
+    Configuration config;
+};
+
+/*
+ * Each maintenance visitor walks the HashTable in its own pass.
+ * Variables:
+ *  - range(0) : Number of maintenance visitors.
+ */
+BENCHMARK_DEFINE_F(HashTableMaintenanceBench, SeparatePasses)
+(benchmark::State& state) {
+    auto concerns = createConcerns(state.range(0));
+    while (state.KeepRunning()) {
+        for (auto& concern : concerns) {
+            visitAll(*concern.visitor, {&concern});
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * vbucket->ht.getNumItems() *
+                            concerns.size());
+}
+
+/*
+ * All the maintenance visitors share a single pass via a CompositeHTVisitor.
+ * Variables:
+ *  - range(0) : Number of maintenance visitors.
+ */
+BENCHMARK_DEFINE_F(HashTableMaintenanceBench, SharedPass)
+(benchmark::State& state) {
+    auto concerns = createConcerns(state.range(0));
+    CompositeHTVisitor composite;
+    std::vector<Concern*> all;
+    for (auto& concern : concerns) {
+        composite.addVisitor(*concern.visitor);
+        all.push_back(&concern);
+    }
+    while (state.KeepRunning()) {
+        visitAll(composite, all);
+    }
+    state.SetItemsProcessed(state.iterations() * vbucket->ht.getNumItems() *
+                            concerns.size());
+}
+
+BENCHMARK_REGISTER_F(HashTableMaintenanceBench, SeparatePasses)
+        ->DenseRange(1, 3)
+        ->ArgName("Visitors")
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(HashTableMaintenanceBench, SharedPass)
+        ->DenseRange(1, 3)
+        ->ArgName("Visitors")
+        ->Unit(benchmark::kMillisecond);
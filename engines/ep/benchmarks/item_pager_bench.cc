@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the ItemPager - measures the time for the
+ * PagingVisitor to evict 10% of the items in a vBucket with each
+ * ht_eviction_policy (hifi_mfu visiting every item, sampled_lru evicting
+ * from a pool of sampled candidates).
+ */
+
+#include "engine_fixture.h"
+#include "ep_bucket.h"
+#include "fakes/fake_executorpool.h"
+#include "item.h"
+#include "kv_bucket.h"
+#include "paging_visitor.h"
+#include "tests/module_tests/test_helpers.h"
+#include "vbucket.h"
+
+#include <folly/portability/GTest.h>
+#include <valgrind/valgrind.h>
+
+class ItemPagerBench : public EngineFixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        EngineFixture::SetUp(state);
+        engine->getKVBucket()->setVBucketState(vbid, vbucket_state_active);
+
+        // Use a large number of documents for normal runs (to exceed the D$,
+        // as in production), but only enough for functional testing when
+        // running under Valgrind.
+        numDocs = RUNNING_ON_VALGRIND ? 10 : 100000;
+        for (size_t i = 0; i < numDocs; i++) {
+            storeItem(i);
+        }
+        flushAllItems();
+
+        // The PagingVisitor only evicts while memory usage is above the low
+        // watermark; zero the watermarks so each run evicts the full 10%.
+        auto& stats = engine->getEpStats();
+        stats.mem_low_wat.store(0);
+        stats.mem_high_wat.store(0);
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  engine->getKVBucket()->deleteVBucket(vbid, nullptr));
+        executorPool->runNextTask(AUXIO_TASK_IDX,
+                                  "Removing (dead) vb:0 from memory and disk");
+        EngineFixture::TearDown(state);
+    }
+
+    void storeItem(size_t i) {
+        auto item = make_item(vbid, "key" + std::to_string(i), value);
+        ASSERT_EQ(ENGINE_SUCCESS, engine->getKVBucket()->set(item, cookie));
+    }
+
+    void flushAllItems() {
+        auto& ep = dynamic_cast<EPBucket&>(*engine->getKVBucket());
+        EPBucket::MoreAvailable moreAvailable;
+        do {
+            moreAvailable = ep.flushVBucket(vbid).moreAvailable;
+        } while (moreAvailable == EPBucket::MoreAvailable::Yes);
+    }
+
+    /// Store (and flush) again every item which was evicted, so the next
+    /// run starts with a fully resident vBucket.
+    void restoreEvicted(VBucket& vb) {
+        for (size_t i = 0; i < numDocs; i++) {
+            auto key = makeStoredDocKey("key" + std::to_string(i));
+            bool resident;
+            {
+                auto htRes = vb.ht.findForRead(key, TrackReference::No);
+                resident = htRes.storedValue && htRes.storedValue->isResident();
+            }
+            if (!resident) {
+                storeItem(i);
+            }
+        }
+        flushAllItems();
+    }
+
+    size_t numDocs = 0;
+    const std::string value = std::string(256, 'x');
+};
+
+/*
+ * Run the PagingVisitor over the vBucket, evicting 10% of its items.
+ * Variables:
+ *  - range(0) : PagingVisitor::EvictionPolicy (hifi_mfu or sampled_lru).
+ */
+BENCHMARK_DEFINE_F(ItemPagerBench, Reclaim10Percent)(benchmark::State& state) {
+    const auto policy = PagingVisitor::EvictionPolicy(state.range(0));
+    auto& kvBucket = *engine->getKVBucket();
+    auto vb = kvBucket.getVBucket(vbid);
+    auto available = std::make_shared<std::atomic<bool>>(false);
+
+    size_t evicted = 0;
+    while (state.KeepRunning()) {
+        PagingVisitor visitor(kvBucket,
+                              engine->getEpStats(),
+                              EvictionRatios{0.1, 0.1},
+                              available,
+                              ITEM_PAGER,
+                              false,
+                              VBucketFilter(),
+                              /*agePercentage*/ 30,
+                              /*freqCounterAgeThreshold*/ 1);
+        visitor.setEvictionPolicy(policy);
+        visitor.visitBucket(vb);
+        evicted += visitor.numEjected();
+
+        state.PauseTiming();
+        restoreEvicted(*vb);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(evicted);
+}
+
+BENCHMARK_REGISTER_F(ItemPagerBench, Reclaim10Percent)
+        ->Arg(int(PagingVisitor::EvictionPolicy::hifi_mfu))
+        ->Arg(int(PagingVisitor::EvictionPolicy::sampled_lru))
+        ->ArgName("Policy")
+        ->Unit(benchmark::kMillisecond);
@@ -204,3 +204,95 @@ BENCHMARK_REGISTER_F(KVStoreBench, Scan)
         ->Args({NUM_ITEMS, ROCKSDB})
 #endif
         ;
+
+/*
+ * Benchmark fixture for KVStore::commit() of flush-batches to a number of
+ * vBuckets, with and without group commit (deferred sync).
+ */
+class KVStoreCommitBench : public benchmark::Fixture {
+protected:
+    void SetUp(benchmark::State& state) override {
+        Configuration config;
+        config.setMaxSize(536870912);
+        config.parseConfiguration(
+                "dbname=KVStoreCommitBench.db;backend=couchdb",
+                get_mock_server_api());
+        WorkLoadPolicy workload(config.getMaxNumWorkers(),
+                                config.getMaxNumShards());
+        kvstoreConfig = std::make_unique<KVStoreConfig>(
+                config, workload.getNumShards(), 0 /*shardId*/);
+        kvstore = std::move(KVStoreFactory::create(*kvstoreConfig).rw);
+
+        vbucket_state vbState;
+        vbState.transition.state = vbucket_state_active;
+        for (int vb = 0; vb < state.range(1); ++vb) {
+            kvstore->snapshotVBucket(Vbid(vb), vbState);
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        kvstore.reset();
+        cb::io::rmrf(kvstoreConfig->getDBName());
+    }
+
+    /// Write and commit a flush-batch of numItems items to the vBucket.
+    void flushBatch(Vbid vbid, int numItems, int64_t& seqno) {
+        kvstore->begin(std::make_unique<TransactionContext>(vbid));
+        for (int i = 0; i < numItems; ++i) {
+            auto qi = makeCommittedItem(
+                    makeStoredDocKey("key" + std::to_string(i)), "value");
+            qi->setBySeqno(++seqno);
+            kvstore->set(qi);
+        }
+        Collections::VB::Manifest manifest;
+        VB::Commit commitData(manifest);
+        ASSERT_TRUE(kvstore->commit(commitData));
+    }
+
+    std::unique_ptr<KVStoreConfig> kvstoreConfig;
+    std::unique_ptr<KVStore> kvstore;
+};
+
+/*
+ * Flush a batch to each of N vBuckets, as the flusher would.
+ * Variables:
+ *  - range(0) : Number of items per flush-batch
+ *  - range(1) : Number of vBuckets
+ *  - range(2) : Group commit (sync all vBuckets together) if non-zero
+ */
+BENCHMARK_DEFINE_F(KVStoreCommitBench, FlushVBuckets)
+(benchmark::State& state) {
+    const int itemsPerVb = state.range(0);
+    const int numVbs = state.range(1);
+    const bool groupCommit = state.range(2);
+    state.SetLabel(groupCommit ? "group" : "per-vBucket");
+
+    auto& syncHisto = kvstore->getKVStoreStat().fsStats.syncTimeHisto;
+    const auto syncsBefore = syncHisto.getValueCount();
+    std::vector<int64_t> seqnos(numVbs);
+
+    while (state.KeepRunning()) {
+        if (groupCommit) {
+            ASSERT_TRUE(kvstore->setDeferredSync(true));
+        }
+        for (int vb = 0; vb < numVbs; ++vb) {
+            flushBatch(Vbid(vb), itemsPerVb, seqnos[vb]);
+        }
+        if (groupCommit) {
+            ASSERT_TRUE(kvstore->syncDeferredCommits().empty());
+            kvstore->setDeferredSync(false);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * itemsPerVb * numVbs);
+    state.counters["fsyncs"] = benchmark::Counter(
+            syncHisto.getValueCount() - syncsBefore,
+            benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(KVStoreCommitBench, FlushVBuckets)
+        ->Args({10, 64, 0})
+        ->Args({10, 64, 1})
+        ->Args({1000, 64, 0})
+        ->Args({1000, 64, 1})
+        ->UseRealTime();
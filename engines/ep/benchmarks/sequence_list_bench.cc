@@ -0,0 +1,236 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the Ephemeral SequenceList implementations
+ * (BasicLinkedList and SkipList) - measures many concurrent DCP backfills,
+ * each from a random start seqno, while a front end thread deletes and
+ * re-creates items and the stale item purger runs.
+ */
+
+#include "hash_table.h"
+#include "item.h"
+#include "linked_list.h"
+#include "skip_list.h"
+#include "stats.h"
+#include "stored_value_factories.h"
+#include "tests/module_tests/test_helpers.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/Random.h>
+#include <folly/portability/GTest.h>
+#include <valgrind/valgrind.h>
+
+#include <thread>
+
+class SequenceListBench : public benchmark::Fixture {
+public:
+    enum class ListType { LinkedList, SkipList };
+
+    void SetUp(const benchmark::State& state) override {
+        if (ListType(state.range(0)) == ListType::SkipList) {
+            list = std::make_unique<SkipList>(Vbid(0), stats);
+        } else {
+            list = std::make_unique<BasicLinkedList>(Vbid(0), stats);
+        }
+
+        // Use a large number of documents for normal runs (to exceed the D$,
+        // as in production), but only enough for functional testing when
+        // running under Valgrind.
+        numDocs = RUNNING_ON_VALGRIND ? 10 : 100000;
+        ht.resize(numDocs);
+        std::lock_guard<std::mutex> seqLg(seqLock);
+        for (size_t i = 0; i < numDocs; i++) {
+            Item item(makeStoredDocKey("key" + std::to_string(i)),
+                      0,
+                      0,
+                      value.data(),
+                      value.size(),
+                      PROTOCOL_BINARY_RAW_BYTES,
+                      /*theCas*/ 0,
+                      /*bySeqno*/ ++highSeqno);
+            ht.set(item);
+            auto* osv = ht.findForWrite(item.getKey())
+                                .storedValue->toOrderedStoredValue();
+            std::lock_guard<std::mutex> listWriteLg(list->getListWriteLock());
+            list->appendToList(seqLg, listWriteLg, *osv);
+            list->updateHighSeqno(listWriteLg, *osv);
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        // Like in a vbucket the list must be destroyed before the HashTable.
+        list.reset();
+        ht.clear();
+        highSeqno = 0;
+    }
+
+protected:
+    /**
+     * Delete the given document if it is alive, otherwise re-create it - as
+     * EphemeralVBucket does: the item is moved to the end of the list, or if
+     * a backfill is reading it a new version is appended and the old one
+     * marked stale.
+     */
+    void mutate(size_t i) {
+        std::lock_guard<std::mutex> seqLg(seqLock);
+        auto key = makeStoredDocKey("key" + std::to_string(i));
+        auto res = ht.findForWrite(key);
+        auto* osv = res.storedValue->toOrderedStoredValue();
+        const bool wasDeleted = osv->isDeleted();
+
+        std::lock_guard<std::mutex> listWriteLg(list->getListWriteLock());
+        StoredValue::UniquePtr ownedSv;
+        StoredValue* newSv = osv;
+        Item item(key,
+                  0,
+                  0,
+                  value.data(),
+                  value.size(),
+                  PROTOCOL_BINARY_RAW_BYTES);
+        if (list->updateListElem(seqLg, listWriteLg, *osv) ==
+            SequenceList::UpdateStatus::Append) {
+            ownedSv = ht.unlocked_release(res.lock, osv);
+            newSv = ht.unlocked_addNewStoredValue(res.lock, item);
+            list->appendToList(
+                    seqLg, listWriteLg, *newSv->toOrderedStoredValue());
+        }
+        if (wasDeleted) {
+            newSv = ht.unlocked_updateStoredValue(res.lock, *newSv, item)
+                            .storedValue;
+        } else {
+            newSv = ht.unlocked_softDelete(res.lock,
+                                           *newSv,
+                                           /*onlyMarkDeleted*/ false,
+                                           DeleteSource::Explicit)
+                            .deletedValue;
+        }
+        newSv->setBySeqno(++highSeqno);
+
+        auto& newOsv = *newSv->toOrderedStoredValue();
+        list->updateHighSeqno(listWriteLg, newOsv);
+        list->updateHighestDedupedSeqno(listWriteLg, newOsv);
+        list->updateNumDeletedItems(wasDeleted, !wasDeleted);
+        if (ownedSv) {
+            list->markItemStale(listWriteLg, std::move(ownedSv), newSv);
+        }
+    }
+
+    /**
+     * Backfill as DCPBackfillMemoryBuffered does: create a range iterator,
+     * seek to the start and copy every item from there to the end.
+     *
+     * @return the number of items backfilled, and the number of times the
+     *         iterator could not be created.
+     */
+    std::pair<size_t, size_t> backfill(seqno_t start) {
+        size_t retries = 0;
+        auto itr = list->makeRangeIterator(true);
+        while (!itr) {
+            // The purger has exclusive access to the range; the backfill
+            // task would snooze.
+            ++retries;
+            std::this_thread::yield();
+            itr = list->makeRangeIterator(true);
+        }
+
+        size_t items = 0;
+        itr->seek(start);
+        for (; itr->curr() != itr->end(); ++(*itr)) {
+            benchmark::DoNotOptimize(UniqueItemPtr((**itr).toItem(Vbid(0))));
+            ++items;
+        }
+        return {items, retries};
+    }
+
+    EPStats stats;
+    HashTable ht{stats,
+                 std::make_unique<OrderedStoredValueFactory>(stats),
+                 /*initialSize*/ 47,
+                 /*locks*/ 1};
+    std::unique_ptr<SequenceList> list;
+    std::mutex seqLock;
+    std::atomic<seqno_t> highSeqno{0};
+    size_t numDocs = 0;
+    const std::string value = std::string(256, 'x');
+};
+
+/*
+ * Run concurrent backfills from random start seqnos, while a front end
+ * thread deletes and re-creates items and the purger removes stale items.
+ * Variables:
+ *  - range(0) : SequenceList implementation (BasicLinkedList or SkipList).
+ *  - range(1) : Number of concurrent backfills.
+ */
+BENCHMARK_DEFINE_F(SequenceListBench, BackfillWithDeletes)
+(benchmark::State& state) {
+    const auto numBackfills = state.range(1);
+    std::atomic<size_t> backfilled{0};
+    std::atomic<size_t> retries{0};
+    size_t purged = 0;
+
+    while (state.KeepRunning()) {
+        std::atomic<bool> done{false};
+        std::thread frontEnd([this, &done]() {
+            while (!done) {
+                mutate(folly::Random::rand32(uint32_t(numDocs)));
+            }
+        });
+        std::thread purger([this, &done, &purged]() {
+            while (!done) {
+                purged += list->purgeTombstones(highSeqno - 1);
+            }
+        });
+
+        std::vector<std::thread> backfills;
+        for (int i = 0; i < numBackfills; i++) {
+            backfills.emplace_back([this, &backfilled, &retries]() {
+                const seqno_t start =
+                        folly::Random::rand32(uint32_t(highSeqno)) + 1;
+                auto result = backfill(start);
+                backfilled += result.first;
+                retries += result.second;
+            });
+        }
+        for (auto& t : backfills) {
+            t.join();
+        }
+
+        done = true;
+        frontEnd.join();
+        purger.join();
+    }
+
+    state.SetItemsProcessed(backfilled);
+    state.counters["Retries"] = retries;
+    state.counters["Purged"] = purged;
+}
+
+static void SequenceListArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"List", "Backfills"});
+    for (auto type : {SequenceListBench::ListType::LinkedList,
+                      SequenceListBench::ListType::SkipList}) {
+        for (int backfills : {1, 4, 16}) {
+            b->Args({int(type), backfills});
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(SequenceListBench, BackfillWithDeletes)
+        ->Apply(SequenceListArgs)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,172 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the TimerWheel (the TaskQueue's futureQueue and the
+ * SyncWrite timeouts), compared with the FutureQueue binary heap it replaced.
+ */
+
+#include "futurequeue.h"
+#include "timer_wheel.h"
+#include "tests/mock/mock_taskable.h"
+#include "tests/module_tests/lambda_task.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+using namespace std::chrono_literals;
+
+/**
+ * Fixture with state.range(0) snoozed tasks, due pseudo-randomly 10-30
+ * seconds from now (as a typical SyncWrite timeout or a periodic task).
+ */
+class TimerBench : public benchmark::Fixture {
+protected:
+    void SetUp(const benchmark::State& state) override {
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            tasks.push_back(std::make_shared<LambdaTask>(
+                    taskable, TaskId::ItemPager, 0, true, [](LambdaTask&) {
+                        return false;
+                    }));
+            tasks.back()->updateWaketime(nextDeadline());
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        tasks.clear();
+    }
+
+    std::chrono::steady_clock::time_point nextDeadline() {
+        return start + std::chrono::milliseconds(timeoutDist(gen));
+    }
+
+    const std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    std::mt19937_64 gen{0};
+    std::uniform_int_distribution<> timeoutDist{10000, 30000};
+    MockTaskable taskable;
+    std::vector<ExTask> tasks;
+};
+
+/*
+ * Move the deadline of one of N pending timers - the cost of a snooze() or
+ * wake() of a task, or of re-arming a timeout.
+ * Variables:
+ *  - range(0) : Number of pending timers.
+ */
+BENCHMARK_DEFINE_F(TimerBench, WheelReschedule)(benchmark::State& state) {
+    TimerWheel<ExTask> wheel(1ms, start);
+    for (const auto& task : tasks) {
+        wheel.schedule(task, task->getWaketime());
+    }
+    std::uniform_int_distribution<size_t> taskDist(0, tasks.size() - 1);
+
+    while (state.KeepRunning()) {
+        wheel.update(tasks[taskDist(gen)], nextDeadline());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(TimerBench, FutureQueueReschedule)
+(benchmark::State& state) {
+    FutureQueue<> queue;
+    for (const auto& task : tasks) {
+        queue.push(task);
+    }
+    std::uniform_int_distribution<size_t> taskDist(0, tasks.size() - 1);
+
+    while (state.KeepRunning()) {
+        queue.updateWaketime(tasks[taskDist(gen)], nextDeadline());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/*
+ * Add and then cancel a timer while N others are pending - a SyncWrite which
+ * completes before its timeout.
+ * Variables:
+ *  - range(0) : Number of pending timers.
+ */
+BENCHMARK_DEFINE_F(TimerBench, WheelScheduleCancel)(benchmark::State& state) {
+    TimerWheel<ExTask> wheel(1ms, start);
+    for (const auto& task : tasks) {
+        wheel.schedule(task, task->getWaketime());
+    }
+    ExTask extra = std::make_shared<LambdaTask>(
+            taskable, TaskId::ItemPager, 0, true, [](LambdaTask&) {
+                return false;
+            });
+
+    while (state.KeepRunning()) {
+        wheel.schedule(extra, nextDeadline());
+        wheel.cancel(extra);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/*
+ * Take all timers due from N pending timers, with time moving on 1ms per
+ * iteration (the pending timers being re-armed as they fire, so N is
+ * constant). Measures the cost of advance(), including cascading.
+ * Variables:
+ *  - range(0) : Number of pending timers.
+ */
+BENCHMARK_DEFINE_F(TimerBench, WheelAdvance)(benchmark::State& state) {
+    TimerWheel<ExTask> wheel(1ms, start);
+    for (const auto& task : tasks) {
+        wheel.schedule(task, task->getWaketime());
+    }
+
+    auto now = start + 10s;
+    std::vector<ExTask> fired;
+    size_t totalFired = 0;
+    while (state.KeepRunning()) {
+        now += 1ms;
+        wheel.advance(now, [&fired](ExTask&& task) {
+            fired.push_back(std::move(task));
+        });
+        totalFired += fired.size();
+        for (auto& task : fired) {
+            wheel.schedule(task, now + 20s);
+        }
+        fired.clear();
+    }
+    state.counters["fired"] = benchmark::Counter(
+            double(totalFired), benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(TimerBench, WheelReschedule)
+        ->RangeMultiplier(100)
+        ->Range(100, 1000000)
+        ->ArgName("Timers");
+
+// Re-heapify is O(N), so stop at 100k for the heap.
+BENCHMARK_REGISTER_F(TimerBench, FutureQueueReschedule)
+        ->RangeMultiplier(100)
+        ->Range(100, 100000)
+        ->ArgName("Timers");
+
+BENCHMARK_REGISTER_F(TimerBench, WheelScheduleCancel)
+        ->RangeMultiplier(100)
+        ->Range(100, 1000000)
+        ->ArgName("Timers");
+
+BENCHMARK_REGISTER_F(TimerBench, WheelAdvance)
+        ->Arg(1000000)
+        ->ArgName("Timers");
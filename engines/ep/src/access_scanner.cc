@@ -22,6 +22,7 @@
 #include "hash_table.h"
 #include "kv_bucket.h"
 #include "mutation_log.h"
+#include "sorted_access_log.h"
 #include "stats.h"
 #include "vb_count_visitor.h"
 
@@ -58,12 +59,21 @@ public:
         prev = name + ".old";
         next = name + ".next";
 
-        log = std::make_unique<MutationLog>(next, conf.getAlogBlockSize());
-        log->open();
-        if (!log->isOpen()) {
-            EP_LOG_WARN("Failed to open access log: '{}'", next);
-            log.reset();
+        if (conf.isAlogSorted()) {
+            try {
+                sortedLog = std::make_unique<SortedAccessLogWriter>(next);
+            } catch (const MutationLog::WriteException& e) {
+                EP_LOG_WARN("Failed to open access log: {}", e.what());
+            }
         } else {
+            log = std::make_unique<MutationLog>(next, conf.getAlogBlockSize());
+            log->open();
+            if (!log->isOpen()) {
+                EP_LOG_WARN("Failed to open access log: '{}'", next);
+                log.reset();
+            }
+        }
+        if (log || sortedLog) {
             EP_LOG_INFO(
                     "Attempting to generate new access file "
                     "'{}'",
@@ -73,12 +83,13 @@ public:
 
     bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override {
         // Record resident, Committed HashTable items as 'accessed'.
-        if (log && v.isResident() && v.isCommitted()) {
+        if ((log || sortedLog) && v.isResident() && v.isCommitted()) {
             if (v.isExpired(startTime) || v.isDeleted()) {
                 EP_LOG_DEBUG("Skipping expired/deleted item: {}",
                              v.getBySeqno());
             } else {
-                accessed.push_back(StoredDocKey(v.getKey()));
+                accessed.push_back({uint64_t(v.getBySeqno()),
+                                    StoredDocKey(v.getKey())});
                 return ++items_scanned < items_to_scan;
             }
         }
@@ -88,7 +99,17 @@ public:
     void update(Vbid vbid) {
         if (log != nullptr) {
             for (auto& it : accessed) {
-                log->newItem(vbid, it);
+                log->newItem(vbid, it.key);
+            }
+        } else if (sortedLog != nullptr) {
+            // Each chunk is written as a sorted run, so at most
+            // items_to_scan keys are buffered.
+            try {
+                sortedLog->addRun(vbid, accessed);
+            } catch (const MutationLog::WriteException& e) {
+                EP_LOG_WARN("Failed to write access log: {}", e.what());
+                sortedLog.reset();
+                remove(next.c_str());
             }
         }
         accessed.clear();
@@ -97,7 +118,7 @@ public:
     void visitBucket(const VBucketPtr& vb) override {
         update(vb->getId());
 
-        if (log == nullptr) {
+        if (log == nullptr && sortedLog == nullptr) {
             return;
         }
         HashTable::Position ht_start;
@@ -105,84 +126,100 @@ public:
             while (ht_start != vb->ht.endPosition()) {
                 ht_start = vb->ht.pauseResumeVisit(*this, ht_start);
                 update(vb->getId());
-                log->commit1();
-                log->commit2();
+                if (log) {
+                    log->commit1();
+                    log->commit2();
+                }
                 items_scanned = 0;
             }
         }
     }
 
     void complete() override {
-
-        if (log == nullptr) {
-            updateStateFinalizer(false);
-        } else {
-            size_t num_items = log->itemsLogged[int(MutationLogType::New)];
+        size_t num_items = 0;
+        if (log) {
+            num_items = log->itemsLogged[int(MutationLogType::New)];
             log->commit1();
             log->commit2();
             log.reset();
-            stats.alogRuntime.store(ep_real_time() - startTime);
-            stats.alogNumItems.store(num_items);
-            stats.accessScannerHisto.add(
-                    std::chrono::duration_cast<std::chrono::microseconds>(
-                            std::chrono::steady_clock::now() - taskStart));
-
-            if (num_items == 0) {
-                EP_LOG_INFO(
-                        "The new access log file is empty. "
-                        "Delete it without replacing the current access "
-                        "log...");
+        } else if (sortedLog) {
+            try {
+                sortedLog->commit();
+                num_items = sortedLog->getNumEntries();
+                sortedLog.reset();
+            } catch (const MutationLog::WriteException& e) {
+                EP_LOG_WARN("Failed to write access log: {}", e.what());
+                sortedLog.reset();
                 remove(next.c_str());
-                updateStateFinalizer(true);
+                updateStateFinalizer(false);
                 return;
             }
+        } else {
+            updateStateFinalizer(false);
+            return;
+        }
 
-            if (cb::io::isFile(prev) && remove(prev.c_str()) == -1) {
-                EP_LOG_WARN(
-                        "Failed to remove access log file "
-                        "'{}': {}",
-                        prev,
-                        strerror(errno));
-                remove(next.c_str());
-                updateStateFinalizer(true);
-                return;
-            }
-            EP_LOG_INFO("Removed old access log file: '{}'", prev);
-            if (cb::io::isFile(name) &&
-                rename(name.c_str(), prev.c_str()) == -1) {
-                EP_LOG_WARN(
-                        "Failed to rename access log file "
-                        "from '{}' to '{}': {}",
-                        name,
-                        prev,
-                        strerror(errno));
-                remove(next.c_str());
-                updateStateFinalizer(true);
-                return;
-            }
+        stats.alogRuntime.store(ep_real_time() - startTime);
+        stats.alogNumItems.store(num_items);
+        stats.accessScannerHisto.add(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - taskStart));
+
+        if (num_items == 0) {
             EP_LOG_INFO(
-                    "Renamed access log file from '{}' to "
-                    "'{}'",
+                    "The new access log file is empty. "
+                    "Delete it without replacing the current access "
+                    "log...");
+            remove(next.c_str());
+            updateStateFinalizer(true);
+            return;
+        }
+
+        if (cb::io::isFile(prev) && remove(prev.c_str()) == -1) {
+            EP_LOG_WARN(
+                    "Failed to remove access log file "
+                    "'{}': {}",
+                    prev,
+                    strerror(errno));
+            remove(next.c_str());
+            updateStateFinalizer(true);
+            return;
+        }
+        EP_LOG_INFO("Removed old access log file: '{}'", prev);
+        if (cb::io::isFile(name) &&
+            rename(name.c_str(), prev.c_str()) == -1) {
+            EP_LOG_WARN(
+                    "Failed to rename access log file "
+                    "from '{}' to '{}': {}",
                     name,
-                    prev);
-            if (rename(next.c_str(), name.c_str()) == -1) {
-                EP_LOG_WARN(
-                        "Failed to rename access log file "
-                        "from '{}' to '{}': {}",
-                        next,
-                        name,
-                        strerror(errno));
-                remove(next.c_str());
-                updateStateFinalizer(true);
-                return;
-            }
-            EP_LOG_INFO(
-                    "New access log file '{}' created with "
-                    "{} keys",
+                    prev,
+                    strerror(errno));
+            remove(next.c_str());
+            updateStateFinalizer(true);
+            return;
+        }
+        EP_LOG_INFO(
+                "Renamed access log file from '{}' to "
+                "'{}'",
+                name,
+                prev);
+        if (rename(next.c_str(), name.c_str()) == -1) {
+            EP_LOG_WARN(
+                    "Failed to rename access log file "
+                    "from '{}' to '{}': {}",
+                    next,
                     name,
-                    static_cast<uint64_t>(num_items));
+                    strerror(errno));
+            remove(next.c_str());
             updateStateFinalizer(true);
+            return;
         }
+        EP_LOG_INFO(
+                "New access log file '{}' created with "
+                "{} keys",
+                name,
+                static_cast<uint64_t>(num_items));
+        updateStateFinalizer(true);
     }
 
 private:
@@ -216,9 +253,13 @@ private:
     std::string name;
     uint16_t shardID;
 
-    std::vector<StoredDocKey> accessed;
+    // Keys recorded since the last pause.
+    std::vector<SortedAccessLogWriter::Entry> accessed;
 
+    // The log being written; one of log or sortedLog, depending on
+    // alog_sorted.
     std::unique_ptr<MutationLog> log;
+    std::unique_ptr<SortedAccessLogWriter> sortedLog;
     std::atomic<bool> &stateFinalizer;
     AccessScanner &as;
 
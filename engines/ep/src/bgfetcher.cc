@@ -46,16 +46,25 @@ BgFetcher::~BgFetcher() {
 
 void BgFetcher::start() {
     ExecutorPool* iom = ExecutorPool::get();
-    auto task =
-            std::make_shared<MultiBGFetcherTask>(&(store.getEPEngine()), this);
-    this->setTaskId(task->getId());
-    iom->schedule(task);
+    const auto concurrency =
+            store.getEPEngine().getConfiguration().getBgfetchConcurrency();
+    std::vector<ExTask> tasks;
+    for (size_t ii = 0; ii < concurrency; ++ii) {
+        tasks.push_back(std::make_shared<MultiBGFetcherTask>(
+                &(store.getEPEngine()), this));
+        taskIds.push_back(tasks.back()->getId());
+    }
+    for (auto& task : tasks) {
+        iom->schedule(task);
+    }
 }
 
 void BgFetcher::stop() {
     bool inverse = true;
     pendingFetch.compare_exchange_strong(inverse, false);
-    ExecutorPool::get()->cancel(taskId);
+    for (const auto id : taskIds) {
+        ExecutorPool::get()->cancel(id);
+    }
 }
 
 void BgFetcher::notifyBGEvent() {
@@ -65,11 +74,28 @@ void BgFetcher::notifyBGEvent() {
 
 void BgFetcher::wakeUpTaskIfSnoozed() {
     bool expected = false;
-    if (pendingFetch.compare_exchange_strong(expected, true)) {
-        ExecutorPool::get()->wake(taskId);
+    if (pendingFetch.compare_exchange_strong(expected, true) &&
+        !taskIds.empty()) {
+        ExecutorPool::get()->wake(taskIds.front());
+    }
+}
+
+void BgFetcher::wakeSecondaryTasks(size_t count) {
+    for (size_t ii = 1; ii < taskIds.size() && ii <= count; ++ii) {
+        ExecutorPool::get()->wake(taskIds[ii]);
     }
 }
 
+std::optional<Vbid> BgFetcher::popPendingVB() {
+    LockHolder lh(queueMutex);
+    if (pendingVbs.empty()) {
+        return {};
+    }
+    const auto vbid = *pendingVbs.begin();
+    pendingVbs.erase(pendingVbs.begin());
+    return vbid;
+}
+
 size_t BgFetcher::doFetch(Vbid vbId, vb_bgfetch_queue_t& itemsToFetch) {
     TRACE_EVENT2("BgFetcher",
                  "doFetch",
@@ -88,30 +114,42 @@ size_t BgFetcher::doFetch(Vbid vbId, vb_bgfetch_queue_t& itemsToFetch) {
                     startTime.time_since_epoch())
                     .count());
 
-    shard.getROUnderlying()->getMulti(vbId, itemsToFetch);
+    const auto inFlight = stats.numBgFetchesInFlight.fetch_add(1) + 1;
+    stats.bgFetchInFlightHisto.addValue(inFlight);
 
+    // Complete the fetches for each key as soon as its document has been
+    // read, instead of waiting for the whole batch.
+    size_t numFetched = 0;
     std::vector<bgfetched_item_t> fetchedItems;
-    for (const auto& fetch : itemsToFetch) {
-        auto& key = fetch.first;
-        const vb_bgfetch_item_ctx_t& bg_item_ctx = fetch.second;
-
-        for (const auto& itm : bg_item_ctx.bgfetched_list) {
-            // We don't want to transfer ownership of itm here as we clean it
-            // up at the end of this method in clearItems()
-            fetchedItems.push_back(std::make_pair(key, itm.get()));
-        }
-    }
+    shard.getROUnderlying()->getMulti(
+            vbId,
+            itemsToFetch,
+            [this, vbId, startTime, &numFetched, &fetchedItems](
+                    const DiskDocKey& key,
+                    vb_bgfetch_item_ctx_t& bg_item_ctx) {
+                for (const auto& itm : bg_item_ctx.bgfetched_list) {
+                    // We don't want to transfer ownership of itm here as it
+                    // is cleaned up when our caller destroys itemsToFetch.
+                    fetchedItems.push_back(std::make_pair(key, itm.get()));
+                }
+                if (!fetchedItems.empty()) {
+                    numFetched += fetchedItems.size();
+                    store.completeBGFetchMulti(vbId, fetchedItems, startTime);
+                    fetchedItems.clear();
+                }
+            });
 
-    if (!fetchedItems.empty()) {
-        store.completeBGFetchMulti(vbId, fetchedItems, startTime);
+    stats.numBgFetchesInFlight.fetch_sub(1);
+
+    if (numFetched > 0) {
         stats.getMultiHisto.add(
                 std::chrono::duration_cast<std::chrono::microseconds>(
                         std::chrono::steady_clock::now() - startTime),
-                fetchedItems.size());
-        stats.getMultiBatchSizeHisto.addValue(fetchedItems.size());
+                numFetched);
+        stats.getMultiBatchSizeHisto.addValue(numFetched);
     }
 
-    return fetchedItems.size();
+    return numFetched;
 }
 
 bool BgFetcher::run(GlobalTask *task) {
@@ -133,35 +171,54 @@ bool BgFetcher::run(GlobalTask *task) {
     task->snooze(INT_MAX);
     pendingFetch.store(false);
 
-    std::vector<Vbid> bg_vbs(pendingVbs.size());
+    size_t numPendingVbs;
     {
         LockHolder lh(queueMutex);
-        bg_vbs.assign(pendingVbs.begin(), pendingVbs.end());
-        pendingVbs.clear();
+        numPendingVbs = pendingVbs.size();
+    }
+
+    // If there is more than one vBucket to fetch for, the primary task fans
+    // out to the secondary tasks so the vBuckets are read concurrently.
+    if (numPendingVbs > 1 && !taskIds.empty() &&
+        task->getId() == taskIds.front()) {
+        wakeSecondaryTasks(numPendingVbs - 1);
     }
 
     size_t num_fetched_items = 0;
+    std::vector<Vbid> requeueVbs;
+
+    // Only claim as many vBuckets as were pending when we started; any added
+    // since then will have woken the primary task again.
+    for (size_t ii = 0; ii < numPendingVbs; ++ii) {
+        const auto vbId = popPendingVB();
+        if (!vbId) {
+            // Remaining vBuckets have been claimed by other fetcher tasks.
+            break;
+        }
 
-    for (const auto vbId : bg_vbs) {
-        VBucketPtr vb = shard.getBucket(vbId);
+        VBucketPtr vb = shard.getBucket(*vbId);
         if (vb) {
             // Requeue the bg fetch task if vbucket DB file is not created yet.
             if (vb->isBucketCreation()) {
-                {
-                    LockHolder lh(queueMutex);
-                    pendingVbs.insert(vbId);
-                }
-                wakeUpTaskIfSnoozed();
+                requeueVbs.push_back(*vbId);
                 continue;
             }
 
             auto items = vb->getBGFetchItems();
             if (!items.empty()) {
-                num_fetched_items += doFetch(vbId, items);
+                num_fetched_items += doFetch(*vbId, items);
             }
         }
     }
 
+    if (!requeueVbs.empty()) {
+        {
+            LockHolder lh(queueMutex);
+            pendingVbs.insert(requeueVbs.begin(), requeueVbs.end());
+        }
+        wakeUpTaskIfSnoozed();
+    }
+
     stats.numRemainingBgItems.fetch_sub(num_fetched_items);
 
     return true;
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <list>
+#include <optional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "vbucket.h"
 
@@ -31,6 +33,12 @@ class GlobalTask;
 /**
  * Dispatcher job responsible for batching data reads and push to
  * underlying storage
+ *
+ * Each BgFetcher runs a number of MultiBGFetcherTasks (bgfetch_concurrency),
+ * which claim pending vBuckets one at a time so that the batches of
+ * different vBuckets are read from disk concurrently. The first (primary)
+ * task is woken when new items are queued, and wakes the others as needed
+ * when there is more than one vBucket to fetch for.
  */
 class BgFetcher {
 public:
@@ -42,7 +50,7 @@ public:
      * @param st reference to statistics
      */
     BgFetcher(KVBucket& s, KVShard& k, EPStats& st)
-        : store(s), shard(k), taskId(0), stats(st), pendingFetch(false) {
+        : store(s), shard(k), stats(st), pendingFetch(false) {
     }
 
     /**
@@ -63,7 +71,6 @@ public:
     bool run(GlobalTask *task);
     bool pendingJob() const;
     void notifyBGEvent();
-    void setTaskId(size_t newId) { taskId = newId; }
     void addPendingVB(Vbid vbId) {
         LockHolder lh(queueMutex);
         pendingVbs.insert(vbId);
@@ -72,14 +79,21 @@ public:
 private:
     size_t doFetch(Vbid vbId, vb_bgfetch_queue_t& items);
 
+    /// Remove and return the next pending vBucket (if any).
+    std::optional<Vbid> popPendingVB();
+
     /// If the BGFetch task is currently snoozed (not scheduled to
     /// run), wake it up. Has no effect the if the task has already
     /// been woken.
     void wakeUpTaskIfSnoozed();
 
+    /// Wake up to 'count' of the secondary fetcher tasks.
+    void wakeSecondaryTasks(size_t count);
+
     KVBucket& store;
     KVShard& shard;
-    size_t taskId;
+    /// Ids of our MultiBGFetcherTasks; the first is the primary task.
+    std::vector<size_t> taskIds;
     std::mutex queueMutex;
     EPStats &stats;
 
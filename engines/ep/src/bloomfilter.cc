@@ -21,7 +21,13 @@
 
 #include "murmurhash3.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #if __x86_64__ || __ppc64__
 #define MURMURHASH_3 MurmurHash3_x64_128
@@ -29,19 +35,75 @@
 #define MURMURHASH_3 MurmurHash3_x86_128
 #endif
 
-BloomFilter::BloomFilter(size_t key_count, double false_positive_prob,
-                         bfilter_status_t new_status) {
+/*
+ * Blocked filters: odd multipliers used to derive the bit position of each
+ * probe from a single 32-bit hash (as in the split block Bloom filters of
+ * Putze et al.). Probe i sets one bit in lane (i % 8) of the block.
+ */
+static const uint32_t blockSalts[] = {0x47b6137b,
+                                      0x44974d91,
+                                      0x8824ad5b,
+                                      0xa2b7289d,
+                                      0x705495c7,
+                                      0x2df1424b,
+                                      0x9efc4947,
+                                      0x5c6bfb31,
+                                      0x9e3779b1,
+                                      0x85ebca77,
+                                      0xc2b2ae3d,
+                                      0x27d4eb2f,
+                                      0x165667b1,
+                                      0xd3a2646d,
+                                      0xfd7046c5,
+                                      0xb55a4f09};
+static const size_t maxBlockHashes =
+        sizeof(blockSalts) / sizeof(blockSalts[0]);
+
+/*
+ * Confining a key's bits to one block gives a higher false positive rate
+ * than a plain bitset of the same size; 20% more bits brings it back to (or
+ * below) the requested probability for the 1% - 0.1% range.
+ */
+static const double blockedSizeFactor = 1.2;
 
+BloomFilter::BloomFilter(size_t key_count,
+                         double false_positive_prob,
+                         bfilter_status_t new_status,
+                         Type type)
+    : type(type) {
     status = new_status;
     filterSize = estimateFilterSize(key_count, false_positive_prob);
     noOfHashes = estimateNoOfHashes(key_count);
     keyCounter = 0;
-    bitArray.assign(filterSize, false);
+    if (type == Type::Blocked) {
+        const size_t bitsPerBlock = sizeof(Block) * 8;
+        const size_t numBlocks = std::max(
+                size_t(1),
+                size_t(std::ceil(filterSize * blockedSizeFactor /
+                                 bitsPerBlock)));
+        filterSize = numBlocks * bitsPerBlock;
+        noOfHashes = std::min(std::max(noOfHashes, size_t(1)), maxBlockHashes);
+        blocks.resize(numBlocks);
+    } else {
+        bitArray.assign(filterSize, false);
+    }
 }
 
 BloomFilter::~BloomFilter() {
     status = BFILTER_DISABLED;
     bitArray.clear();
+    blocks.clear();
+}
+
+BloomFilter::Type BloomFilter::typeFromString(const std::string& name) {
+    if (name == "bitset") {
+        return Type::Bitset;
+    }
+    if (name == "blocked") {
+        return Type::Blocked;
+    }
+    throw std::invalid_argument(
+            "BloomFilter::typeFromString: unknown type '" + name + "'");
 }
 
 size_t BloomFilter::estimateFilterSize(size_t key_count,
@@ -54,7 +116,7 @@ size_t BloomFilter::estimateNoOfHashes(size_t key_count) {
     return round(((double) filterSize / key_count) * (log(2.0)));
 }
 
-uint64_t BloomFilter::hashDocKey(const DocKey& key, uint32_t iteration) {
+uint64_t BloomFilter::hashDocKey(const DocKey& key, uint32_t iteration) const {
     uint64_t result = 0;
     auto hashable = key.getIdAndKey();
     uint32_t seed = iteration + (uint32_t(hashable.first) * noOfHashes);
@@ -73,6 +135,7 @@ void BloomFilter::setStatus(bfilter_status_t to) {
             if (to == BFILTER_DISABLED) {
                 status = to;
                 bitArray.clear();
+                blocks.clear();
             } else if (to == BFILTER_COMPACTING) {
                 status = to;
             }
@@ -81,6 +144,7 @@ void BloomFilter::setStatus(bfilter_status_t to) {
             if (to == BFILTER_DISABLED) {
                 status = to;
                 bitArray.clear();
+                blocks.clear();
             } else if (to == BFILTER_ENABLED) {
                 status = to;
             }
@@ -89,6 +153,7 @@ void BloomFilter::setStatus(bfilter_status_t to) {
             if (to == BFILTER_DISABLED) {
                 status = to;
                 bitArray.clear();
+                blocks.clear();
             } else if (to == BFILTER_COMPACTING) {
                 status = to;
             }
@@ -114,8 +179,66 @@ std::string BloomFilter::getStatusString() {
     return "UNKNOWN";
 }
 
+size_t BloomFilter::getBlockIndex(uint64_t hash) const {
+    // Map the upper 32 bits onto [0, blocks) without a division
+    return size_t(((hash >> 32) * blocks.size()) >> 32);
+}
+
+void BloomFilter::getBlockMasks(uint64_t hash, uint64_t* masks) const {
+    const auto lower = uint32_t(hash);
+    std::fill(masks, masks + 8, 0);
+    for (size_t i = 0; i < noOfHashes; i++) {
+        // The top 6 bits of the product select one of the 64 bits in a lane
+        masks[i % 8] |= uint64_t(1) << (uint32_t(lower * blockSalts[i]) >> 26);
+    }
+}
+
+bool BloomFilter::addKeyBlocked(const DocKey& key) {
+    const auto hash = hashDocKey(key, 0);
+    auto& block = blocks[getBlockIndex(hash)];
+    uint64_t masks[8];
+    getBlockMasks(hash, masks);
+    bool overlap = true;
+    for (int i = 0; i < 8; i++) {
+        if ((block.lanes[i] & masks[i]) != masks[i]) {
+            overlap = false;
+        }
+        block.lanes[i] |= masks[i];
+    }
+    return !overlap;
+}
+
+bool BloomFilter::maybeKeyExistsBlocked(const DocKey& key) const {
+    const auto hash = hashDocKey(key, 0);
+    const auto& block = blocks[getBlockIndex(hash)];
+    alignas(32) uint64_t masks[8];
+    getBlockMasks(hash, masks);
+#if defined(__AVX2__)
+    const auto* lanes = reinterpret_cast<const __m256i*>(block.lanes);
+    const auto* wanted = reinterpret_cast<const __m256i*>(masks);
+    // testc returns 1 iff every bit set in the mask is set in the lanes.
+    return _mm256_testc_si256(_mm256_load_si256(lanes),
+                              _mm256_load_si256(wanted)) &&
+           _mm256_testc_si256(_mm256_load_si256(lanes + 1),
+                              _mm256_load_si256(wanted + 1));
+#else
+    // Branch-free over the 8 lanes so the compiler can vectorize it.
+    uint64_t missing = 0;
+    for (int i = 0; i < 8; i++) {
+        missing |= masks[i] & ~block.lanes[i];
+    }
+    return missing == 0;
+#endif
+}
+
 void BloomFilter::addKey(const DocKey& key) {
     if (status == BFILTER_COMPACTING || status == BFILTER_ENABLED) {
+        if (type == Type::Blocked) {
+            if (addKeyBlocked(key)) {
+                keyCounter++;
+            }
+            return;
+        }
         bool overlap = true;
         for (uint32_t i = 0; i < noOfHashes; i++) {
             uint64_t result = hashDocKey(key, i);
@@ -132,6 +255,9 @@ void BloomFilter::addKey(const DocKey& key) {
 
 bool BloomFilter::maybeKeyExists(const DocKey& key) {
     if (status == BFILTER_COMPACTING || status == BFILTER_ENABLED) {
+        if (type == Type::Blocked) {
+            return maybeKeyExistsBlocked(key);
+        }
         for (uint32_t i = 0; i < noOfHashes; i++) {
             uint64_t result = hashDocKey(key, i);
             if (bitArray[result % filterSize] == 0) {
@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -33,13 +34,34 @@ enum bfilter_status_t {
  * We are to maintain the vbucket-number of these instances.
  *
  * Each vbucket will hold one such object.
+ *
+ * Two layouts are supported:
+ *  - Bitset: one bit array with noOfHashes independent probes, each of which
+ *    may touch a different cache line.
+ *  - Blocked: the bits are split into 64-byte blocks and all of a key's bits
+ *    are set in the single block selected by its hash, so a lookup touches
+ *    one cache line and needs one hash computation. A block is checked as
+ *    eight 64-bit lanes at once (with AVX2 where available). Blocking costs
+ *    some accuracy, so the filter is made slightly larger to stay at the
+ *    requested false positive probability.
  */
 class BloomFilter {
 public:
-    BloomFilter(size_t key_count, double false_positive_prob,
-                bfilter_status_t newStatus = BFILTER_DISABLED);
+    enum class Type { Bitset, Blocked };
+
+    BloomFilter(size_t key_count,
+                double false_positive_prob,
+                bfilter_status_t newStatus = BFILTER_DISABLED,
+                Type type = Type::Bitset);
     ~BloomFilter();
 
+    /// @throws std::invalid_argument for an unknown type name
+    static Type typeFromString(const std::string& name);
+
+    Type getType() const {
+        return type;
+    }
+
     void setStatus(bfilter_status_t to);
     bfilter_status_t getStatus();
     std::string getStatusString();
@@ -55,7 +77,21 @@ protected:
     size_t estimateFilterSize(size_t key_count, double false_positive_prob);
     size_t estimateNoOfHashes(size_t key_count);
 
-    uint64_t hashDocKey(const DocKey& key, uint32_t iteration);
+    uint64_t hashDocKey(const DocKey& key, uint32_t iteration) const;
+
+    /// One cache line of a Blocked filter.
+    struct alignas(64) Block {
+        uint64_t lanes[8];
+    };
+
+    /// Blocked filter: index of the block for the given key hash.
+    size_t getBlockIndex(uint64_t hash) const;
+
+    /// Blocked filter: populate the 8 lane masks for the given key hash.
+    void getBlockMasks(uint64_t hash, uint64_t* masks) const;
+
+    bool addKeyBlocked(const DocKey& key);
+    bool maybeKeyExistsBlocked(const DocKey& key) const;
 
     size_t filterSize;
     size_t noOfHashes;
@@ -63,5 +99,7 @@ protected:
     size_t keyCounter;
 
     bfilter_status_t status;
+    const Type type;
     std::vector<bool> bitArray;
+    std::vector<Block> blocks;
 };
@@ -408,6 +408,12 @@ void CB3ExecutorPool::_registerTaskable(Taskable& taskable) {
             for (size_t i = 0; i < numTaskSets; ++i) {
                 taskQ->push_back(
                         new TaskQueue(this, (task_type_t)i, queueName));
+                taskQ->back()->setNumRunQueues(std::count_if(
+                        threadQ.begin(),
+                        threadQ.end(),
+                        [i](CB3ExecutorThread* thread) {
+                            return thread->taskType == task_type_t(i);
+                        }));
             }
             *whichQset = true;
         }
@@ -460,7 +466,8 @@ void CB3ExecutorPool::_adjustWorkers(task_type_t type, size_t desiredNumItems) {
                 threadQ.push_back(new CB3ExecutorThread(
                         this,
                         type,
-                        typeName + "_worker_" + std::to_string(tidx)));
+                        typeName + "_worker_" + std::to_string(tidx),
+                        tidx));
                 threadQ.back()->start();
             }
         } else if (numItems > desiredNumItems) {
@@ -488,6 +495,7 @@ void CB3ExecutorPool::_adjustWorkers(task_type_t type, size_t desiredNumItems) {
         }
 
         numWorkers[type] = desiredNumItems;
+        _setNumRunQueues(type, desiredNumItems);
     } // release mutex
 
     // MB-22938 wake all threads to avoid blocking if a thread is sleeping
@@ -511,6 +519,15 @@ void CB3ExecutorPool::_adjustWorkers(task_type_t type, size_t desiredNumItems) {
     }
 }
 
+void CB3ExecutorPool::_setNumRunQueues(task_type_t type, size_t numThreads) {
+    if (isHiPrioQset) {
+        hpTaskQ[type]->setNumRunQueues(numThreads);
+    }
+    if (isLowPrioQset) {
+        lpTaskQ[type]->setNumRunQueues(numThreads);
+    }
+}
+
 void CB3ExecutorPool::adjustWorkers(task_type_t type, size_t newCount) {
     NonBucketAllocationGuard guard;
     _adjustWorkers(type, newCount);
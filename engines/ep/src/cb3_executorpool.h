@@ -27,7 +27,9 @@
  *
  * Each thread operates by reading from a shared TaskQueue. Each thread wakes
  * up and fetches (TaskQueue::fetchNextTask) a task for execution
- * (GlobalTask::run() is called to execute the task).
+ * (GlobalTask::run() is called to execute the task). Ready tasks of a
+ * TaskQueue are spread over per-thread run queues; a thread takes tasks from
+ * its own run queue and steals from the others' when it is empty.
  *
  * The pool also has the concept of high and low priority which is achieved by
  * having two TaskQueue objects per task-type. When a thread wakes up to run
@@ -36,9 +38,10 @@
  *
  * Within a single queue itself there is also a task priority. The task priority
  * is a value where lower is better. When many tasks are ready for execution
- * they are moved to a ready queue and sorted by their priority. Thus tasks
- * with priority 0 get to go before tasks with priority 1. Only once the ready
- * queue of tasks is empty will we consider looking for more eligible tasks.
+ * they are moved to the run queues and sorted by their priority. Thus tasks
+ * with priority 0 get to go before tasks with priority 1 (within a run queue,
+ * the most important tasks of a batch are dealt out first). Only once the run
+ * queues are empty will we consider looking for more eligible tasks.
  * In this context, an eligible task is one that has a wakeTime <= now.
  *
  * === Important methods of the ExecutorPool ===
@@ -243,6 +246,12 @@ protected:
      */
     void _adjustWorkers(task_type_t type, size_t desiredNumItems);
 
+    /**
+     * Spread the ready tasks of the given type over one run queue per
+     * thread. Caller must hold tMutex.
+     */
+    void _setNumRunQueues(task_type_t type, size_t numThreads);
+
     bool _snooze(size_t taskId, double tosleep);
     size_t _schedule(ExTask task);
     void _registerTaskable(Taskable& taskable);
@@ -73,11 +73,20 @@ public:
         std::chrono::steady_clock::time_point timepoint;
     };
 
+    /**
+     * @param m the pool the thread belongs to
+     * @param type the type of tasks the thread runs
+     * @param nm the name of the thread
+     * @param runQueueIdx index of the thread among the threads of its type,
+     *        which selects its home run queue in each TaskQueue
+     */
     CB3ExecutorThread(CB3ExecutorPool* m,
                       task_type_t type,
-                      const std::string nm)
+                      const std::string nm,
+                      size_t runQueueIdx = 0)
         : manager(m),
           taskType(type),
+          runQueueIdx(runQueueIdx),
           name(nm),
           state(EXECUTOR_RUNNING),
           now(std::chrono::steady_clock::now()),
@@ -146,6 +155,7 @@ protected:
     cb_thread_t thread;
     CB3ExecutorPool* manager;
     task_type_t taskType;
+    const size_t runQueueIdx;
     const std::string name;
     std::atomic<executor_state_t> state;
 
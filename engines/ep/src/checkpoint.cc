@@ -209,12 +209,6 @@ Checkpoint::~Checkpoint() {
     EP_LOG_DEBUG("Checkpoint {} for {} is purged from memory",
                  checkpointId,
                  vbucketId);
-    /**
-     * Calculate as best we can the overhead associated with the queue
-     * (toWrite). This is approximated to sizeof(queued_item) * number
-     * of queued_items in the checkpoint.
-     */
-    auto queueMemOverhead = sizeof(queued_item) * toWrite.size();
     stats.coreLocal.get()->memOverhead.fetch_sub(
             sizeof(Checkpoint) + keyIndexMemUsage + queueMemOverhead);
 }
@@ -229,6 +223,8 @@ QueueDirtyStatus Checkpoint::queueDirty(const queued_item& qi,
     }
 
     QueueDirtyStatus rv;
+    // Position of the existing item de-duplicated by this one (if any).
+    std::optional<ChkptQueueIterator::const_underlying_iterator> dedupedPos;
 
     // Check if the item is a meta item
     if (qi->isCheckPointMetaItem()) {
@@ -305,9 +301,11 @@ QueueDirtyStatus Checkpoint::queueDirty(const queued_item& qi,
                 // Reduce the size of the checkpoint by the size of the
                 // item being removed.
                 queuedItemsMemUsage -= ((*currPos)->size());
-                // Remove the existing item for the same key from the list.
-                toWrite.erase(
-                        ChkptQueueIterator::const_underlying_iterator{currPos});
+                // Remove the existing item for the same key from the queue.
+                // This nulls its slot, which iterators skip over.
+                dedupedPos =
+                        ChkptQueueIterator::const_underlying_iterator{currPos};
+                toWrite.erase(*dedupedPos);
             } else {
                 // The old item has been expelled, but we can continue to use
                 // this checkpoint in most cases. If the previous op was a
@@ -379,11 +377,11 @@ QueueDirtyStatus Checkpoint::queueDirty(const queued_item& qi,
             auto indexKeyUsage = qi->getKey().size() + sizeof(index_entry);
             /**
              * Calculate as best we can the memory overhead of adding the new
-             * item to the queue (toWrite).  This is approximated to the
-             * addition to metaKeyIndex / keyIndex plus sizeof(queued_item).
+             * item to the index. This is approximated to the addition to
+             * metaKeyIndex / keyIndex; the queue (toWrite) itself is accounted
+             * by updateQueueMemOverhead().
              */
-            stats.coreLocal.get()->memOverhead.fetch_add(indexKeyUsage +
-                                                         sizeof(queued_item));
+            stats.coreLocal.get()->memOverhead.fetch_add(indexKeyUsage);
             /**
              *  Update the total metaKeyIndex / keyIndex memory usage which is
              *  used when the checkpoint is destructed to manually account
@@ -393,6 +391,18 @@ QueueDirtyStatus Checkpoint::queueDirty(const queued_item& qi,
         }
     }
 
+    if (dedupedPos) {
+        // Reclaim the null slot left by de-duplication (along with any others
+        // in its chunk) if that lets a chunk be freed. Must be done after the
+        // key index has been updated, so that no entry refers to the null
+        // slot.
+        toWrite.compact(*dedupedPos,
+                        [this, checkpointManager](auto from, auto to) {
+                            relocateItem(*checkpointManager, from, to);
+                        });
+        updateQueueMemOverhead();
+    }
+
     // track the highest prepare seqno present in the checkpoint
     if (qi->getOperation() == queue_op::pending_sync_write) {
         setHighPreparedSeqno(qi->getBySeqno());
@@ -422,6 +432,7 @@ bool Checkpoint::canDedup(const queued_item& existing,
 
 void Checkpoint::addItemToCheckpoint(const queued_item& qi) {
     toWrite.push_back(qi);
+    updateQueueMemOverhead();
     // Increase the size of the checkpoint by the item being added
     queuedItemsMemUsage += (qi->size());
 
@@ -440,7 +451,7 @@ void Checkpoint::addItemToCheckpoint(const queued_item& qi) {
 
 CheckpointQueue Checkpoint::expelItems(
         CheckpointCursor& expelUpToAndIncluding) {
-    CheckpointQueue expelledItems(toWrite.get_allocator());
+    CheckpointQueue expelledItems;
 
     ChkptQueueIterator iterator = expelUpToAndIncluding.currentPos;
 
@@ -504,21 +515,66 @@ CheckpointQueue Checkpoint::expelItems(
     iterator->swap(*dummy);
 
     /*
-     * Move from (and including) the first item in the checkpoint queue upto
+     * Pop from (and including) the first item in the checkpoint queue upto
      * (but not including) the item pointed to by iterator.  The item pointed
      * to by iterator is now the new dummy item for the checkpoint queue.
+     * Chunks of toWrite are freed as soon as all of their slots are popped.
      */
-    expelledItems.splice(
-            ChkptQueueIterator::const_underlying_iterator{
-                    expelledItems.begin()},
-            toWrite,
-            ChkptQueueIterator::const_underlying_iterator{begin()},
-            ChkptQueueIterator::const_underlying_iterator{iterator});
+    const ChkptQueueIterator::const_underlying_iterator newDummy{iterator};
+    while (ChkptQueueIterator::const_underlying_iterator{toWrite.begin()} !=
+           newDummy) {
+        auto expelled = toWrite.pop_front();
+        // Slots of de-duplicated items are null; nothing to expel there.
+        if (expelled) {
+            expelledItems.push_back(std::move(expelled));
+        }
+    }
+    updateQueueMemOverhead();
 
     // Return the items that have been expelled in a separate queue.
     return expelledItems;
 }
 
+void Checkpoint::relocateItem(CheckpointManager& checkpointManager,
+                              CheckpointQueue::iterator from,
+                              CheckpointQueue::iterator to) {
+    const ChkptQueueIterator oldPos{toWrite, from};
+    const ChkptQueueIterator newPos{toWrite, to};
+
+    for (auto& cursor : checkpointManager.cursors) {
+        if ((*(cursor.second->currentCheckpoint)).get() == this &&
+            cursor.second->currentPos == oldPos) {
+            cursor.second->currentPos = newPos;
+        }
+    }
+
+    const auto& item = *from;
+    if (item->getKey().size() == 0 || isDiskCheckpoint()) {
+        // Not indexed, see queueDirty().
+        return;
+    }
+    auto& keyIndex = item->isCheckPointMetaItem()
+                             ? metaKeyIndex
+                             : item->isCommitted() ? committedKeyIndex
+                                                   : preparedKeyIndex;
+    auto it = keyIndex.find(makeIndexKey(item));
+    if (it != keyIndex.end() && it->second.position == oldPos) {
+        it->second.position = newPos;
+    }
+}
+
+void Checkpoint::updateQueueMemOverhead() {
+    const size_t allocated = getWriteQueueAllocatorBytes();
+    if (allocated > queueMemOverhead) {
+        stats.coreLocal.get()->memOverhead.fetch_add(allocated -
+                                                     queueMemOverhead);
+    } else {
+        stats.coreLocal.get()->memOverhead.fetch_sub(queueMemOverhead -
+                                                     allocated);
+    }
+    queueMemOverhead = allocated;
+}
+
 CheckpointIndexKeyType Checkpoint::makeIndexKey(const queued_item& item) const {
     return CheckpointIndexKeyType(item->getKey(), keyIndexKeyTrackingAllocator);
 }
@@ -627,6 +683,10 @@ std::ostream& operator <<(std::ostream& os, const Checkpoint& c) {
     os << " hcs:" << (hcs ? std::to_string(hcs.value()) : "none ") << " items:["
        << std::endl;
     for (const auto& e : c.toWrite) {
+        if (!e) {
+            // De-duplicated item
+            continue;
+        }
         os << "\t{" << e->getBySeqno() << "," << to_string(e->getOperation());
         e->isDeleted() ? os << "[d]," : os << ",";
         os << e->getKey() << "," << e->size() << ",";
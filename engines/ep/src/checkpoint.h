@@ -19,6 +19,7 @@
 
 #include "checkpoint_iterator.h"
 #include "checkpoint_types.h"
+#include "chunked_queue.h"
 #include "ep_types.h"
 #include "item.h"
 #include "monotonic.h"
@@ -57,10 +58,12 @@ enum checkpoint_state {
 
 const char* to_string(enum checkpoint_state);
 
-// List is used for queueing mutations as vector incurs shift operations for
-// de-duplication.  We template the list on a queued_item and our own
-// memory allocator which allows memory usage to be tracked.
-typedef std::list<queued_item, MemoryTrackingAllocator<queued_item>>
+// A chunked queue is used for queueing mutations; de-duplication nulls the
+// old item's slot (instead of shifting elements as a vector would) and
+// expelling / checkpoint removal release whole chunks at a time. We template
+// the queue on a queued_item and our own memory allocator which allows memory
+// usage to be tracked.
+typedef ChunkedQueue<queued_item, MemoryTrackingAllocator<queued_item>>
         CheckpointQueue;
 
 // Iterator for the Checkpoint queue.  The iterator is templated on the
@@ -667,6 +670,21 @@ private:
      */
     CheckpointIndexKeyType makeIndexKey(const queued_item& item) const;
 
+    /**
+     * Called by toWrite.compact() before the item at `from` is moved to `to`;
+     * points any cursor in this checkpoint and the key index entry which
+     * refer to the item at its new position.
+     */
+    void relocateItem(CheckpointManager& checkpointManager,
+                      CheckpointQueue::iterator from,
+                      CheckpointQueue::iterator to);
+
+    /**
+     * Update memOverhead by the change in the memory allocated for toWrite
+     * (whole chunks, including null and unused slots) since the last call.
+     */
+    void updateQueueMemOverhead();
+
     /**
      * When checking if the existing item has already been processed by the
      * persistence cursor we use the mutation_id field in the index_entry (the
@@ -733,6 +751,9 @@ private:
     // Records the memory consumption of all items in the checkpoint.
     // This includes each item's key, metadata and the blob.
     cb::NonNegativeCounter<size_t> queuedItemsMemUsage;
+    // The memory allocated for toWrite which has been added to memOverhead
+    // (see updateQueueMemOverhead()).
+    size_t queueMemOverhead = 0;
 
     // Is this a checkpoint created by a replica from a received disk snapshot?
     CheckpointType checkpointType;
@@ -573,6 +573,7 @@ size_t CheckpointManager::removeClosedUnrefCheckpoints(
 CheckpointManager::ExpelResult
 CheckpointManager::expelUnreferencedCheckpointItems() {
     CheckpointQueue expelledItems;
+    ssize_t queueMemoryRecovered{0};
     {
         LockHolder lh(queueLock);
 
@@ -662,7 +663,12 @@ CheckpointManager::expelUnreferencedCheckpointItems() {
          * queue thereby ensuring they still have a reference whilst
          * the queuelock is being held.
          */
+        const auto queueMemoryBefore =
+                oldestCheckpoint->getWriteQueueAllocatorBytes();
         expelledItems = oldestCheckpoint->expelItems(expelUpToAndIncluding);
+        queueMemoryRecovered =
+                queueMemoryBefore -
+                oldestCheckpoint->getWriteQueueAllocatorBytes();
     }
 
     // If called currentCheckpoint->expelItems but did not manage to expel
@@ -678,12 +684,10 @@ CheckpointManager::expelUnreferencedCheckpointItems() {
      * This is comprised of two parts:
      * 1. Memory used by each item to be expelled.  For each item this
      *    is calculated as the sizeof(Item) + key size + value size.
-     * 2. Memory used to hold the items in the checkpoint list.
-     *    The checkpoint list will be shorter by expelledItems.size().
-     *    This saving is equal to the memory allocated by the
-     *    expelledItems list.  Note: On Windows this is not strictly
-     *    true as we allocate space for size + 1.  However as its
-     *    an estimate we do not need to adjust.
+     * 2. Memory used to hold the items in the checkpoint queue.
+     *    The queue releases whole chunks once all of their items have
+     *    been expelled, so this saving is the reduction in the memory
+     *    allocated by the checkpoint queue.
      *
      * It is an optimistic estimate as it assumes that each queued_item
      * is not referenced by anyone else (e.g. a DCP stream) and therefore
@@ -698,8 +702,7 @@ CheckpointManager::expelUnreferencedCheckpointItems() {
     }
 
     // Part 2 of calculating the estimate (see comment above).
-    estimateOfAmountOfRecoveredMemory +=
-            *(expelledItems.get_allocator().getBytesAllocated());
+    estimateOfAmountOfRecoveredMemory += queueMemoryRecovered;
 
     /*
      * We are now outside of the queueLock when the method exits,
@@ -0,0 +1,425 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+/**
+ * A FIFO queue of nullable pointer-like elements (e.g. queued_item), stored in
+ * a doubly-linked list of fixed-size chunks.
+ *
+ * Compared to a std::list each element costs only its own size (plus a share
+ * of the per-chunk header) instead of a separately allocated node with two
+ * link pointers, and consecutive elements are contiguous in memory which makes
+ * walking the queue considerably more cache friendly.
+ *
+ * Elements can only be added at the back and removed from the front. An
+ * element in the middle of the queue can be erased, which resets its slot to
+ * null. Consumers are expected to skip null elements, as CheckpointIterator
+ * does. Null values must not be pushed.
+ *
+ * Null slots are reclaimed when their chunk is freed, which happens as soon as
+ * every slot in it has been popped, or by compact(): a queue which has many of
+ * its elements erased (e.g. by de-duplication) would otherwise keep a mostly
+ * null chunk allocated for each remaining element.
+ *
+ * Iterators remain valid until the element they point to is popped or moved
+ * by compact(); in particular push_back and erase never invalidate iterators
+ * to other elements.
+ *
+ * Chunks are allocated via Allocator (rebound to the chunk type), so a
+ * MemoryTrackingAllocator accounts for all memory used by the queue.
+ */
+template <class T, class Allocator = std::allocator<T>, size_t ChunkSlots = 32>
+class ChunkedQueue {
+    static_assert(ChunkSlots > 0, "ChunkedQueue: ChunkSlots must be non-zero");
+
+    struct Chunk {
+        Chunk* prev = nullptr;
+        Chunk* next = nullptr;
+        /// Slots [begin, end) have been pushed but not yet popped.
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        /// Number of non-null slots in [begin, end).
+        uint32_t live = 0;
+        T slots[ChunkSlots];
+    };
+
+    using ChunkAllocator =
+            typename std::allocator_traits<Allocator>::template rebind_alloc<
+                    Chunk>;
+    using ChunkAllocTraits = std::allocator_traits<ChunkAllocator>;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+
+        /// Allow conversion from iterator to const_iterator.
+        template <bool C = Const, class = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other)
+            : queue(other.queue), chunk(other.chunk), index(other.index) {
+        }
+
+        reference operator*() const {
+            return chunk->slots[index];
+        }
+
+        pointer operator->() const {
+            return &chunk->slots[index];
+        }
+
+        Iterator& operator++() {
+            // Checked against the chunk's current end so that an iterator to
+            // the last element moves onto elements pushed after it was taken.
+            if (++index == chunk->end) {
+                chunk = chunk->next;
+                index = chunk ? chunk->begin : 0;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto beforeInc = *this;
+            operator++();
+            return beforeInc;
+        }
+
+        Iterator& operator--() {
+            if (!chunk) {
+                chunk = queue->tail;
+                index = chunk->end - 1;
+            } else if (index == chunk->begin) {
+                if (chunk->prev) {
+                    chunk = chunk->prev;
+                    index = chunk->end - 1;
+                }
+            } else {
+                --index;
+            }
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            auto beforeDec = *this;
+            operator--();
+            return beforeDec;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return chunk == other.chunk && index == other.index;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !operator==(other);
+        }
+
+    private:
+        friend class ChunkedQueue;
+        friend class Iterator<!Const>;
+
+        Iterator(const ChunkedQueue* queue, Chunk* chunk, uint32_t index)
+            : queue(queue), chunk(chunk), index(index) {
+        }
+
+        const ChunkedQueue* queue = nullptr;
+        /// nullptr for the end iterator.
+        Chunk* chunk = nullptr;
+        uint32_t index = 0;
+    };
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    /// Number of elements stored in each chunk.
+    static constexpr size_t slotsPerChunk = ChunkSlots;
+
+    ChunkedQueue() = default;
+
+    explicit ChunkedQueue(const Allocator& alloc) : alloc(alloc) {
+    }
+
+    ChunkedQueue(const ChunkedQueue&) = delete;
+    ChunkedQueue& operator=(const ChunkedQueue&) = delete;
+
+    ChunkedQueue(ChunkedQueue&& other) noexcept
+        : alloc(other.alloc),
+          head(std::exchange(other.head, nullptr)),
+          tail(std::exchange(other.tail, nullptr)),
+          count(std::exchange(other.count, 0)) {
+    }
+
+    ChunkedQueue& operator=(ChunkedQueue&& other) noexcept {
+        if (this != &other) {
+            clear();
+            alloc = other.alloc;
+            head = std::exchange(other.head, nullptr);
+            tail = std::exchange(other.tail, nullptr);
+            count = std::exchange(other.count, 0);
+        }
+        return *this;
+    }
+
+    ~ChunkedQueue() {
+        clear();
+    }
+
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+
+    iterator begin() {
+        if (!head || head->begin == head->end) {
+            return end();
+        }
+        return {this, head, head->begin};
+    }
+
+    const_iterator begin() const {
+        return const_cast<ChunkedQueue*>(this)->begin();
+    }
+
+    iterator end() {
+        return {this, nullptr, 0};
+    }
+
+    const_iterator end() const {
+        return const_cast<ChunkedQueue*>(this)->end();
+    }
+
+    /// @return the number of (non-erased) elements in the queue.
+    size_type size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    /// @return the number of bytes allocated for each chunk.
+    static constexpr size_t getChunkSize() {
+        return sizeof(Chunk);
+    }
+
+    T& front() {
+        return head->slots[head->begin];
+    }
+
+    const T& front() const {
+        return head->slots[head->begin];
+    }
+
+    T& back() {
+        return tail->slots[tail->end - 1];
+    }
+
+    const T& back() const {
+        return tail->slots[tail->end - 1];
+    }
+
+    void push_back(const T& value) {
+        reserveSlot() = value;
+        ++count;
+    }
+
+    void push_back(T&& value) {
+        reserveSlot() = std::move(value);
+        ++count;
+    }
+
+    /**
+     * Remove the first slot of the queue, freeing its chunk if it was the last
+     * slot in use there.
+     *
+     * @return the value which was held in the slot; null if the element had
+     *         been erased.
+     */
+    T pop_front() {
+        T value = std::move(head->slots[head->begin]);
+        head->slots[head->begin] = T();
+        if (value) {
+            --head->live;
+            --count;
+        }
+
+        if (++head->begin == head->end) {
+            if (head == tail) {
+                if (head->end == ChunkSlots) {
+                    freeChunk(head);
+                    head = tail = nullptr;
+                } else {
+                    // Re-use the remainder of the tail chunk.
+                    head->begin = head->end;
+                }
+            } else {
+                auto* next = head->next;
+                freeChunk(head);
+                head = next;
+                head->prev = nullptr;
+            }
+        }
+        return value;
+    }
+
+    /**
+     * Erase the element at the given position. The slot is reset to null and
+     * remains in the queue until popped or reclaimed by compact(); iterators
+     * to other elements are unaffected.
+     *
+     * @return iterator to the slot following the erased one
+     */
+    iterator erase(const_iterator pos) {
+        auto& slot = pos.chunk->slots[pos.index];
+        if (slot) {
+            slot = T();
+            --pos.chunk->live;
+            --count;
+        }
+        iterator next{this, pos.chunk, pos.index};
+        return ++next;
+    }
+
+    /**
+     * Reclaim the null slots of the chunk containing pos (typically the slot
+     * of an element just erased) by merging the chunk with a neighbour, if
+     * the non-null elements of both fit in a single chunk. The elements are
+     * packed (in order) into the earlier of the two chunks and the later one
+     * is freed.
+     *
+     * Iterators to null slots in the merged chunks are invalidated, as are
+     * iterators to the elements which are moved. Before each element is moved
+     * relocated(iterator from, iterator to) is called, so that the caller can
+     * update any iterators it holds to the element.
+     *
+     * @return true if a chunk was freed.
+     */
+    template <class Relocated>
+    bool compact(const_iterator pos, Relocated&& relocated) {
+        auto* chunk = pos.chunk;
+        return (chunk->prev && merge(chunk->prev, relocated)) ||
+               (chunk->next && merge(chunk, relocated));
+    }
+
+    /// Remove all elements and free all chunks.
+    void clear() {
+        while (head) {
+            auto* next = head->next;
+            freeChunk(head);
+            head = next;
+        }
+        tail = nullptr;
+        count = 0;
+    }
+
+private:
+    /// @return a reference to a new slot at the back of the queue.
+    T& reserveSlot() {
+        if (!tail || tail->end == ChunkSlots) {
+            ChunkAllocator chunkAlloc(alloc);
+            auto* chunk = ChunkAllocTraits::allocate(chunkAlloc, 1);
+            new (chunk) Chunk();
+            chunk->prev = tail;
+            if (tail) {
+                tail->next = chunk;
+            } else {
+                head = chunk;
+            }
+            tail = chunk;
+        }
+        ++tail->live;
+        return tail->slots[tail->end++];
+    }
+
+    /**
+     * Move the elements of first->next into first (after packing the
+     * elements of first), then free first->next. Nothing is done unless the
+     * (non-empty) union of the elements fits in first.
+     */
+    template <class Relocated>
+    bool merge(Chunk* first, Relocated& relocated) {
+        auto* second = first->next;
+        const auto live = first->live + second->live;
+        if (live == 0 || first->begin + live > ChunkSlots) {
+            return false;
+        }
+
+        auto out = first->begin;
+        auto pack = [this, first, &out, &relocated](Chunk* from,
+                                                      uint32_t index) {
+            auto& slot = from->slots[index];
+            if (!slot) {
+                return;
+            }
+            if (from != first || index != out) {
+                relocated(iterator{this, from, index},
+                          iterator{this, first, out});
+                first->slots[out] = std::move(slot);
+                slot = T();
+            }
+            ++out;
+        };
+        for (auto index = first->begin; index < first->end; ++index) {
+            pack(first, index);
+        }
+        for (auto index = second->begin; index < second->end; ++index) {
+            pack(second, index);
+        }
+        first->end = out;
+        first->live = live;
+
+        first->next = second->next;
+        if (second->next) {
+            second->next->prev = first;
+        } else {
+            tail = first;
+        }
+        freeChunk(second);
+        return true;
+    }
+
+    void freeChunk(Chunk* chunk) {
+        ChunkAllocator chunkAlloc(alloc);
+        chunk->~Chunk();
+        ChunkAllocTraits::deallocate(chunkAlloc, chunk, 1);
+    }
+
+    Allocator alloc;
+    Chunk* head = nullptr;
+    Chunk* tail = nullptr;
+    /// Count of non-erased elements.
+    size_type count = 0;
+};
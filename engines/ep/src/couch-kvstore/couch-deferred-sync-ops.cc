@@ -0,0 +1,155 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "couch-kvstore/couch-deferred-sync-ops.h"
+
+couch_file_handle DeferredSyncOps::takeLastDeferred() {
+    auto* file = lastDeferred;
+    lastDeferred = nullptr;
+    return reinterpret_cast<couch_file_handle>(file);
+}
+
+couchstore_error_t DeferredSyncOps::syncDeferred(
+        couchstore_error_info_t* errinfo, couch_file_handle h) {
+    if (!h) {
+        return COUCHSTORE_SUCCESS;
+    }
+    return syncIfPending(errinfo, *reinterpret_cast<DeferredSyncFile*>(h));
+}
+
+couchstore_error_t DeferredSyncOps::syncIfPending(
+        couchstore_error_info_t* errinfo, DeferredSyncFile& file) {
+    if (!file.syncPending) {
+        return COUCHSTORE_SUCCESS;
+    }
+    file.syncPending = false;
+    return file.orig_ops->sync(errinfo, file.orig_handle);
+}
+
+couch_file_handle DeferredSyncOps::constructor(
+        couchstore_error_info_t* errinfo) {
+    FileOpsInterface* orig_ops = &wrapped_ops;
+    auto* file = new DeferredSyncFile(orig_ops, orig_ops->constructor(errinfo));
+    return reinterpret_cast<couch_file_handle>(file);
+}
+
+couchstore_error_t DeferredSyncOps::open(couchstore_error_info_t* errinfo,
+                                         couch_file_handle* h,
+                                         const char* path,
+                                         int flags) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(*h);
+    file->syncPending = false;
+    return file->orig_ops->open(errinfo, &file->orig_handle, path, flags);
+}
+
+couchstore_error_t DeferredSyncOps::close(couchstore_error_info_t* errinfo,
+                                          couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    if (file == lastDeferred) {
+        lastDeferred = nullptr;
+    }
+    const auto syncStatus = syncIfPending(errinfo, *file);
+    const auto closeStatus = file->orig_ops->close(errinfo, file->orig_handle);
+    return syncStatus != COUCHSTORE_SUCCESS ? syncStatus : closeStatus;
+}
+
+couchstore_error_t DeferredSyncOps::set_periodic_sync(couch_file_handle h,
+                                                      uint64_t period_bytes) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->set_periodic_sync(file->orig_handle, period_bytes);
+}
+
+couchstore_error_t DeferredSyncOps::set_tracing_enabled(couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->set_tracing_enabled(file->orig_handle);
+}
+
+couchstore_error_t DeferredSyncOps::set_write_validation_enabled(
+        couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->set_write_validation_enabled(file->orig_handle);
+}
+
+couchstore_error_t DeferredSyncOps::set_mprotect_enabled(couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->set_mprotect_enabled(file->orig_handle);
+}
+
+ssize_t DeferredSyncOps::pread(couchstore_error_info_t* errinfo,
+                               couch_file_handle h,
+                               void* buf,
+                               size_t sz,
+                               cs_off_t off) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->pread(errinfo, file->orig_handle, buf, sz, off);
+}
+
+ssize_t DeferredSyncOps::pwrite(couchstore_error_info_t* errinfo,
+                                couch_file_handle h,
+                                const void* buf,
+                                size_t sz,
+                                cs_off_t off) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    // Everything written before the sync request must be durable before
+    // anything written after it.
+    const auto status = syncIfPending(errinfo, *file);
+    if (status != COUCHSTORE_SUCCESS) {
+        return status;
+    }
+    return file->orig_ops->pwrite(errinfo, file->orig_handle, buf, sz, off);
+}
+
+cs_off_t DeferredSyncOps::goto_eof(couchstore_error_info_t* errinfo,
+                                   couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->goto_eof(errinfo, file->orig_handle);
+}
+
+couchstore_error_t DeferredSyncOps::sync(couchstore_error_info_t* errinfo,
+                                         couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    if (!deferSyncs) {
+        file->syncPending = false;
+        return file->orig_ops->sync(errinfo, file->orig_handle);
+    }
+    file->syncPending = true;
+    lastDeferred = file;
+    return COUCHSTORE_SUCCESS;
+}
+
+couchstore_error_t DeferredSyncOps::advise(couchstore_error_info_t* errinfo,
+                                           couch_file_handle h,
+                                           cs_off_t offs,
+                                           cs_off_t len,
+                                           couchstore_file_advice_t adv) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->advise(errinfo, file->orig_handle, offs, len, adv);
+}
+
+FileOpsInterface::FHStats* DeferredSyncOps::get_stats(couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    return file->orig_ops->get_stats(file->orig_handle);
+}
+
+void DeferredSyncOps::destructor(couch_file_handle h) {
+    auto* file = reinterpret_cast<DeferredSyncFile*>(h);
+    if (file == lastDeferred) {
+        lastDeferred = nullptr;
+    }
+    file->orig_ops->destructor(file->orig_handle);
+    delete file;
+}
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <libcouchstore/couch_db.h>
+
+/**
+ * FileOpsInterface implementation which can defer the sync() requests made by
+ * Couchstore, so that the flusher can commit several vBucket files and then
+ * sync them together (group commit).
+ *
+ * While deferring is enabled a sync() only marks the file as needing a sync.
+ * Ordering is preserved: the pending sync is performed before any subsequent
+ * write to (or close of) the same file, so data written before a sync request
+ * always reaches disk before data written after it (e.g. a commit's btree
+ * nodes before its header). syncDeferred() performs the pending sync of a
+ * file, if any.
+ *
+ * Deferring is enabled and the deferred syncs performed by a single thread
+ * (the flusher); other threads may use the ops concurrently for reading.
+ */
+class DeferredSyncOps : public FileOpsInterface {
+public:
+    explicit DeferredSyncOps(FileOpsInterface& ops) : wrapped_ops(ops) {
+    }
+
+    /// Enable or disable deferring of sync() requests.
+    void setDeferSyncs(bool value) {
+        deferSyncs = value;
+    }
+
+    bool isDeferringSyncs() const {
+        return deferSyncs;
+    }
+
+    /**
+     * @return the handle of the file whose sync() was most recently deferred
+     *         (or nullptr if none), and reset it. Used to identify the file of
+     *         a commit for syncDeferred().
+     */
+    couch_file_handle takeLastDeferred();
+
+    /**
+     * Perform the sync deferred for the given file (if it still has one).
+     *
+     * @param handle a handle returned by takeLastDeferred(); the file must
+     *        still be open. nullptr is a no-op.
+     */
+    couchstore_error_t syncDeferred(couchstore_error_info_t* errinfo,
+                                    couch_file_handle handle);
+
+    couch_file_handle constructor(couchstore_error_info_t* errinfo) override;
+    couchstore_error_t open(couchstore_error_info_t* errinfo,
+                            couch_file_handle* handle,
+                            const char* path,
+                            int oflag) override;
+    couchstore_error_t close(couchstore_error_info_t* errinfo,
+                             couch_file_handle handle) override;
+    couchstore_error_t set_periodic_sync(couch_file_handle handle,
+                                         uint64_t period_bytes) override;
+    couchstore_error_t set_tracing_enabled(couch_file_handle handle) override;
+    couchstore_error_t set_write_validation_enabled(
+            couch_file_handle handle) override;
+    couchstore_error_t set_mprotect_enabled(couch_file_handle handle) override;
+
+    ssize_t pread(couchstore_error_info_t* errinfo,
+                  couch_file_handle handle,
+                  void* buf,
+                  size_t nbytes,
+                  cs_off_t offset) override;
+    ssize_t pwrite(couchstore_error_info_t* errinfo,
+                   couch_file_handle handle,
+                   const void* buf,
+                   size_t nbytes,
+                   cs_off_t offset) override;
+    cs_off_t goto_eof(couchstore_error_info_t* errinfo,
+                      couch_file_handle handle) override;
+    couchstore_error_t sync(couchstore_error_info_t* errinfo,
+                            couch_file_handle handle) override;
+    couchstore_error_t advise(couchstore_error_info_t* errinfo,
+                              couch_file_handle handle,
+                              cs_off_t offset,
+                              cs_off_t len,
+                              couchstore_file_advice_t advice) override;
+    FHStats* get_stats(couch_file_handle handle) override;
+    void destructor(couch_file_handle handle) override;
+
+protected:
+    struct DeferredSyncFile {
+        DeferredSyncFile(FileOpsInterface* orig_ops,
+                         couch_file_handle orig_handle)
+            : orig_ops(orig_ops), orig_handle(orig_handle) {
+        }
+
+        FileOpsInterface* orig_ops;
+        couch_file_handle orig_handle;
+        /// A sync() was requested but not yet performed.
+        bool syncPending = false;
+    };
+
+    /// Perform the file's pending sync, if any.
+    couchstore_error_t syncIfPending(couchstore_error_info_t* errinfo,
+                                     DeferredSyncFile& file);
+
+    FileOpsInterface& wrapped_ops;
+    bool deferSyncs = false;
+    DeferredSyncFile* lastDeferred = nullptr;
+};
@@ -42,14 +42,21 @@
 #include <platform/dirutils.h>
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <shared_mutex>
+#include <unordered_set>
 #include <utility>
 
 static int bySeqnoScanCallback(Db* db, DocInfo* docinfo, void* ctx);
 static int byIdScanCallback(Db* db, DocInfo* docinfo, void* ctx);
 
 static int getMultiCallback(Db* db, DocInfo* docinfo, void* ctx);
+static void getMultiFetchDoc(Db* db,
+                             DocInfo* docinfo,
+                             struct GetMultiCbCtx& ctx,
+                             vb_bgfetch_item_ctx_t& bg_itm_ctx);
 
 static bool endWithCompact(const std::string &filename) {
     const std::string suffix{".compact"};
@@ -173,6 +180,41 @@ static std::string getDBFileName(const std::string& dbname,
            std::to_string(rev);
 }
 
+/**
+ * Copy of a DocInfo (and the key / metadata buffers it references) which
+ * outlives the couchstore callback it was passed to.
+ */
+class OwnedDocInfo {
+public:
+    explicit OwnedDocInfo(const DocInfo& other)
+        : info(other),
+          id(other.id.buf, other.id.buf + other.id.size),
+          revMeta(other.rev_meta.buf,
+                  other.rev_meta.buf + other.rev_meta.size) {
+        // Moving a vector preserves its buffer, so these remain valid for
+        // the lifetime of this object.
+        info.id = {id.data(), id.size()};
+        info.rev_meta = {revMeta.data(), revMeta.size()};
+    }
+
+    OwnedDocInfo(OwnedDocInfo&&) = default;
+    OwnedDocInfo& operator=(OwnedDocInfo&&) = default;
+
+    DocInfo* get() {
+        return &info;
+    }
+
+    /// @return the offset of the document body within the file
+    uint64_t getOffset() const {
+        return info.bp;
+    }
+
+private:
+    DocInfo info;
+    std::vector<char> id;
+    std::vector<char> revMeta;
+};
+
 struct GetMultiCbCtx {
     GetMultiCbCtx(CouchKVStore& c, Vbid v, vb_bgfetch_queue_t& f)
         : cks(c), vbId(v), fetches(f) {
@@ -181,6 +223,9 @@ struct GetMultiCbCtx {
     CouchKVStore &cks;
     Vbid vbId;
     vb_bgfetch_queue_t &fetches;
+    /// DocInfos found for the requested keys, read once all are looked up.
+    std::vector<std::pair<vb_bgfetch_queue_t::iterator, OwnedDocInfo>>
+            docInfos;
 };
 
 struct AllKeysCtx {
@@ -316,6 +361,8 @@ CouchKVStore::CouchKVStore(CouchKVStoreConfig& config,
     statCollectingFileOps = getCouchstoreStatsOps(st.fsStats, base_ops);
     statCollectingFileOpsCompaction = getCouchstoreStatsOps(
         st.fsStatsCompaction, base_ops);
+    deferredSyncFileOps =
+            std::make_unique<DeferredSyncOps>(*statCollectingFileOps);
 
     // init db file map with default revision number, 1
     auto numDbFiles = configuration.getMaxVBuckets();
@@ -566,11 +613,27 @@ GetValue CouchKVStore::getWithHeader(DbHolder& db,
 }
 
 void CouchKVStore::getMulti(Vbid vb, vb_bgfetch_queue_t& itms) {
+    getMulti(vb, itms, {});
+}
+
+void CouchKVStore::getMulti(Vbid vb,
+                            vb_bgfetch_queue_t& itms,
+                            const GetMultiCb& cb) {
     if (itms.empty()) {
         return;
     }
     int numItems = itms.size();
 
+    // Invoke the callback for every item; used when the batch as a whole
+    // fails.
+    auto notifyAll = [&itms, &cb]() {
+        if (cb) {
+            for (auto& item : itms) {
+                cb(item.first, item.second);
+            }
+        }
+    };
+
     DbHolder db(*this);
     couchstore_error_t errCode = openDB(vb, db, COUCHSTORE_OPEN_FLAG_RDONLY);
     if (errCode != COUCHSTORE_SUCCESS) {
@@ -584,6 +647,7 @@ void CouchKVStore::getMulti(Vbid vb, vb_bgfetch_queue_t& itms) {
         for (auto& item : itms) {
             item.second.value.setStatus(ENGINE_NOT_MY_VBUCKET);
         }
+        notifyAll();
         return;
     }
 
@@ -595,7 +659,9 @@ void CouchKVStore::getMulti(Vbid vb, vb_bgfetch_queue_t& itms) {
     }
 
     GetMultiCbCtx ctx(*this, vb, itms);
+    ctx.docInfos.reserve(itms.size());
 
+    // First look up the DocInfos of all keys via the by-id index...
     errCode = couchstore_docinfos_by_id(
             db, ids.data(), itms.size(), 0, getMultiCallback, &ctx);
     if (errCode != COUCHSTORE_SUCCESS) {
@@ -609,6 +675,34 @@ void CouchKVStore::getMulti(Vbid vb, vb_bgfetch_queue_t& itms) {
         for (auto& item : itms) {
             item.second.value.setStatus(couchErr2EngineErr(errCode));
         }
+        notifyAll();
+    } else {
+        // ...then read the documents in file offset order, so the reads
+        // sweep through the file instead of seeking back and forth.
+        std::sort(ctx.docInfos.begin(),
+                  ctx.docInfos.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.second.getOffset() < b.second.getOffset();
+                  });
+        for (auto& [fetch, docInfo] : ctx.docInfos) {
+            getMultiFetchDoc(db, docInfo.get(), ctx, fetch->second);
+            if (cb) {
+                cb(fetch->first, fetch->second);
+            }
+        }
+
+        // Keys which were not found still need completing.
+        if (cb && ctx.docInfos.size() < itms.size()) {
+            std::unordered_set<const vb_bgfetch_item_ctx_t*> found;
+            for (const auto& docInfo : ctx.docInfos) {
+                found.insert(&docInfo.first->second);
+            }
+            for (auto& item : itms) {
+                if (found.count(&item.second) == 0) {
+                    cb(item.first, item.second);
+                }
+            }
+        }
     }
 
     // If available, record how many reads() we did for this getMulti;
@@ -1264,6 +1358,15 @@ bool CouchKVStore::writeVBucketState(Vbid vbucketId,
     }
 
     errorCode = couchstore_commit(db);
+    if (errorCode == COUCHSTORE_SUCCESS &&
+        deferredSyncFileOps->isDeferringSyncs()) {
+        // A vbstate-only flush isn't part of the group commit; sync it now so
+        // a failure is reported to (and the cached vbstate restored by) the
+        // caller rather than lost when the file is closed.
+        couchstore_error_info_t errinfo;
+        errorCode = deferredSyncFileOps->syncDeferred(
+                &errinfo, deferredSyncFileOps->takeLastDeferred());
+    }
     if (errorCode != COUCHSTORE_SUCCESS) {
         ++st.numVbSetFailure;
         logger.warn(
@@ -1294,6 +1397,10 @@ bool CouchKVStore::snapshotVBucket(Vbid vbucketId,
 
     auto start = std::chrono::steady_clock::now();
 
+    // The cached vbstate is updated before it is written; restore it if the
+    // write fails so it doesn't expose a state which is not on disk.
+    const auto* cached = getVBucketState(vbucketId);
+    const auto previous = cached ? std::make_optional(*cached) : std::nullopt;
     if (updateCachedVBState(vbucketId, vbstate)) {
         vbucket_state* vbs = getVBucketState(vbucketId);
         if (!writeVBucketState(vbucketId, *vbs)) {
@@ -1302,6 +1409,14 @@ bool CouchKVStore::snapshotVBucket(Vbid vbucketId,
                     "state:{}, {}",
                     VBucket::toString(vbstate.transition.state),
                     vbucketId);
+            if (previous) {
+                *vbs = *previous;
+            } else {
+                if (vbs->transition.state != vbucket_state_dead) {
+                    cachedValidVBCount--;
+                }
+                cachedVBStates[vbucketId.get()].reset();
+            }
             return false;
         }
     }
@@ -1342,6 +1457,69 @@ bool CouchKVStore::commit(VB::Commit& commitData) {
     return !inTransaction;
 }
 
+struct CouchKVStore::DeferredCommit {
+    Vbid vbid;
+    /// The file is kept open until synced
+    DbHolder db;
+    /// The file's handle in deferredSyncFileOps
+    couch_file_handle syncHandle;
+    PendingRequestQueue committedReqs;
+    std::unordered_set<DiskDocKey> keyWasOnDisk;
+    std::unique_ptr<TransactionContext> transactionCtx;
+};
+
+bool CouchKVStore::setDeferredSync(bool enabled) {
+    if (isReadOnly()) {
+        throw std::logic_error(
+                "CouchKVStore::setDeferredSync: Not valid on a read-only "
+                "object.");
+    }
+    if (!enabled && !deferredCommits.empty()) {
+        throw std::logic_error(
+                "CouchKVStore::setDeferredSync: " +
+                std::to_string(deferredCommits.size()) +
+                " deferred commits have not been synced");
+    }
+    deferredSyncFileOps->setDeferSyncs(enabled);
+    return true;
+}
+
+std::vector<Vbid> CouchKVStore::syncDeferredCommits() {
+    std::vector<Vbid> failed;
+    for (auto& deferred : deferredCommits) {
+        couchstore_error_info_t errinfo;
+        const auto errCode =
+                deferredSyncFileOps->syncDeferred(&errinfo, deferred.syncHandle);
+        if (errCode != COUCHSTORE_SUCCESS) {
+            logger.warn(
+                    "CouchKVStore::syncDeferredCommits: sync error:{}, {}",
+                    couchstore_strerror(errCode),
+                    deferred.vbid);
+            failed.push_back(deferred.vbid);
+        } else {
+            updateCachedFileStats(
+                    deferred.vbid,
+                    cb::couchstore::getHeader(*deferred.db.getDb()));
+        }
+        deferred.db.close();
+
+        commitCallback(deferred.committedReqs,
+                       deferred.keyWasOnDisk,
+                       *deferred.transactionCtx,
+                       errCode);
+    }
+    deferredCommits.clear();
+    return failed;
+}
+
+void CouchKVStore::updateCachedFileStats(
+        Vbid vbid, const cb::couchstore::Header& info) {
+    cachedSpaceUsed[vbid.get()] = info.spaceUsed;
+    cachedFileSize[vbid.get()] = info.fileSize;
+    cachedDeleteCount[vbid.get()] = info.deletedCount;
+    cachedDocCount[vbid.get()] = info.docCount;
+}
+
 bool CouchKVStore::getStat(const char* name, size_t& value)  {
     if (strcmp("failure_compaction", name) == 0) {
         value = st.numCompactionFailure.load();
@@ -2127,8 +2305,10 @@ bool CouchKVStore::commit2couchstore(VB::Commit& commitData) {
     }
 
     kvstats_ctx kvctx(commitData);
+    DbHolder db(*this);
     // flush all
-    couchstore_error_t errCode = saveDocs(vbucket2flush, docs, docinfos, kvctx);
+    couchstore_error_t errCode =
+            saveDocs(vbucket2flush, db, docs, docinfos, kvctx);
 
     if (errCode) {
         success = false;
@@ -2143,7 +2323,21 @@ bool CouchKVStore::commit2couchstore(VB::Commit& commitData) {
         postFlushHook();
     }
 
-    commitCallback(pendingReqsQ, kvctx, errCode);
+    if (success && deferredSyncFileOps->isDeferringSyncs()) {
+        // Group commit - the file is synced and the persistence callbacks
+        // invoked by syncDeferredCommits(). Moving the queue keeps the
+        // requests at the same address.
+        deferredCommits.push_back({vbucket2flush,
+                                   std::move(db),
+                                   deferredSyncFileOps->takeLastDeferred(),
+                                   std::move(pendingReqsQ),
+                                   std::move(kvctx.keyWasOnDisk),
+                                   std::move(transactionCtx)});
+        pendingReqsQ.clear();
+        return success;
+    }
+
+    commitCallback(pendingReqsQ, kvctx.keyWasOnDisk, *transactionCtx, errCode);
 
     pendingReqsQ.clear();
     return success;
@@ -2232,12 +2426,15 @@ static size_t calcLogicalDataSize(const Doc* doc, const DocInfo& info) {
 }
 
 couchstore_error_t CouchKVStore::saveDocs(Vbid vbid,
+                                          DbHolder& db,
                                           const std::vector<Doc*>& docs,
                                           std::vector<DocInfo*>& docinfos,
                                           kvstats_ctx& kvctx) {
     couchstore_error_t errCode;
-    DbHolder db(*this);
-    errCode = openDB(vbid, db, COUCHSTORE_OPEN_FLAG_CREATE);
+    errCode = openDB(vbid,
+                     db,
+                     COUCHSTORE_OPEN_FLAG_CREATE,
+                     deferredSyncFileOps.get());
     if (errCode != COUCHSTORE_SUCCESS) {
         logger.warn(
                 "CouchKVStore::saveDocs: openDB error:{}, {}, rev:{}, "
@@ -2345,12 +2542,13 @@ couchstore_error_t CouchKVStore::saveDocs(Vbid vbid,
             st.flusherWriteAmplificationHisto.addValue(writeAmp);
         }
 
-        // retrieve storage system stats for file fragmentation computation
+        // retrieve storage system stats for file fragmentation computation.
+        // For a deferred commit they are cached once the file has been synced
+        // (see syncDeferredCommits).
         const auto info = cb::couchstore::getHeader(*db.getDb());
-        cachedSpaceUsed[vbid.get()] = info.spaceUsed;
-        cachedFileSize[vbid.get()] = info.fileSize;
-        cachedDeleteCount[vbid.get()] = info.deletedCount;
-        cachedDocCount[vbid.get()] = info.docCount;
+        if (!deferredSyncFileOps->isDeferringSyncs()) {
+            updateCachedFileStats(vbid, info);
+        }
 
         // Check seqno if we wrote documents
         if (!docs.empty() && maxDBSeqno != info.updateSeqNum) {
@@ -2373,9 +2571,11 @@ couchstore_error_t CouchKVStore::saveDocs(Vbid vbid,
     return errCode;
 }
 
-void CouchKVStore::commitCallback(PendingRequestQueue& committedReqs,
-                                  kvstats_ctx& kvctx,
-                                  couchstore_error_t errCode) {
+void CouchKVStore::commitCallback(
+        PendingRequestQueue& committedReqs,
+        const std::unordered_set<DiskDocKey>& keyWasOnDisk,
+        TransactionContext& txCtx,
+        couchstore_error_t errCode) {
     const auto flushSuccess = (errCode == COUCHSTORE_SUCCESS);
     for (auto& committed : committedReqs) {
         const auto docLogicalSize = calcLogicalDataSize(
@@ -2387,7 +2587,7 @@ void CouchKVStore::commitCallback(PendingRequestQueue& committedReqs,
         if (committed.isDelete()) {
             FlushStateDeletion state;
             if (flushSuccess) {
-                if (kvctx.keyWasOnDisk.find(key) != kvctx.keyWasOnDisk.end()) {
+                if (keyWasOnDisk.find(key) != keyWasOnDisk.end()) {
                     // Deletion is for an existing item on disk
                     state = FlushStateDeletion::Delete;
                 } else {
@@ -2400,11 +2600,11 @@ void CouchKVStore::commitCallback(PendingRequestQueue& committedReqs,
                 ++st.numDelFailure;
             }
 
-            transactionCtx->deleteCallback(committed.getItem(), state);
+            txCtx.deleteCallback(committed.getItem(), state);
         } else {
             FlushStateMutation state;
             if (flushSuccess) {
-                if (kvctx.keyWasOnDisk.find(key) != kvctx.keyWasOnDisk.end()) {
+                if (keyWasOnDisk.find(key) != keyWasOnDisk.end()) {
                     // Mutation is for an existing item on disk
                     state = FlushStateMutation::Update;
                 } else {
@@ -2418,7 +2618,7 @@ void CouchKVStore::commitCallback(PendingRequestQueue& committedReqs,
                 ++st.numSetFailure;
             }
 
-            transactionCtx->setCallback(committed.getItem(), state);
+            txCtx.setCallback(committed.getItem(), state);
         }
     }
 }
@@ -2659,7 +2859,6 @@ static int getMultiCallback(Db* db, DocInfo* docinfo, void* ctx) {
 
     auto *cbCtx = static_cast<GetMultiCbCtx *>(ctx);
     auto key = makeDiskDocKey(docinfo->id);
-    KVStoreStats& st = cbCtx->cks.getKVStoreStat();
 
     auto qitr = cbCtx->fetches.find(key);
     if (qitr == cbCtx->fetches.end()) {
@@ -2673,16 +2872,31 @@ static int getMultiCallback(Db* db, DocInfo* docinfo, void* ctx) {
         return 0;
     }
 
-    vb_bgfetch_item_ctx_t& bg_itm_ctx = (*qitr).second;
+    // The document is read by getMultiFetchDoc() once all DocInfos have been
+    // looked up; the docinfo is only valid during this callback so take a
+    // copy.
+    cbCtx->docInfos.emplace_back(qitr, OwnedDocInfo(*docinfo));
+    return 0;
+}
+
+/**
+ * Read the document for a getMulti() request and populate the fetch context
+ * (and all BGFetchItems waiting on it) with the result.
+ */
+static void getMultiFetchDoc(Db* db,
+                             DocInfo* docinfo,
+                             GetMultiCbCtx& ctx,
+                             vb_bgfetch_item_ctx_t& bg_itm_ctx) {
+    KVStoreStats& st = ctx.cks.getKVStoreStat();
     GetMetaOnly meta_only = bg_itm_ctx.isMetaOnly;
 
-    couchstore_error_t errCode = cbCtx->cks.fetchDoc(
-            db, docinfo, bg_itm_ctx.value, cbCtx->vbId, meta_only);
+    couchstore_error_t errCode = ctx.cks.fetchDoc(
+            db, docinfo, bg_itm_ctx.value, ctx.vbId, meta_only);
     if (errCode != COUCHSTORE_SUCCESS && (meta_only == GetMetaOnly::No)) {
         st.numGetFailure++;
     }
 
-    bg_itm_ctx.value.setStatus(cbCtx->cks.couchErr2EngineErr(errCode));
+    bg_itm_ctx.value.setStatus(ctx.cks.couchErr2EngineErr(errCode));
 
     bool return_val_ownership_transferred = false;
     for (auto& fetch : bg_itm_ctx.bgfetched_list) {
@@ -2699,14 +2913,12 @@ static int getMultiCallback(Db* db, DocInfo* docinfo, void* ctx) {
         }
     }
     if (!return_val_ownership_transferred) {
-        cbCtx->cks.getLogger().warn(
-                "getMultiCallback called with zero items in bgfetched_list, "
+        ctx.cks.getLogger().warn(
+                "getMultiFetchDoc called with zero items in bgfetched_list, "
                 "{}, seqno:{}",
-                cbCtx->vbId,
+                ctx.vbId,
                 docinfo->rev_seq);
     }
-
-    return 0;
 }
 
 void CouchKVStore::closeDatabaseHandle(Db *db) {
@@ -18,6 +18,7 @@
 
 #include "atomicqueue.h"
 #include "configuration.h"
+#include "couch-kvstore/couch-deferred-sync-ops.h"
 #include "couch-kvstore/couch-fs-stats.h"
 #include "couch-kvstore/couch-kvstore-metadata.h"
 #include "kvstore.h"
@@ -165,6 +166,10 @@ public:
      */
     bool commit(VB::Commit& commitData) override;
 
+    bool setDeferredSync(bool enabled) override;
+
+    std::vector<Vbid> syncDeferredCommits() override;
+
     /**
      * Rollback a transaction (unless not currently in one).
      */
@@ -214,6 +219,15 @@ public:
 
     void getMulti(Vbid vb, vb_bgfetch_queue_t& itms) override;
 
+    /**
+     * Looks up the DocInfos of all requested keys first, then reads the
+     * documents in order of their offset within the file, invoking cb for
+     * each key as soon as its document has been read.
+     */
+    void getMulti(Vbid vb,
+                  vb_bgfetch_queue_t& itms,
+                  const GetMultiCb& cb) override;
+
     void getRange(Vbid vb,
                   const DiskDocKey& startKey,
                   const DiskDocKey& endKey,
@@ -532,6 +546,8 @@ protected:
      * save the Documents held in docs to the file associated with vbid/rev
      *
      * @param vbid the vbucket file to open/write/commit
+     * @param db [out] the handle the file is opened with; left open on return
+     *        (so a deferred sync can be performed on it)
      * @param docs vector of Doc* to be written (can be empty)
      * @param docsinfo vector of DocInfo* to be written (non const due to
      *        couchstore API). Entry n corresponds to entry n of docs.
@@ -540,12 +556,28 @@ protected:
      * @returns COUCHSTORE_SUCCESS or a failure code (failure paths log)
      */
     couchstore_error_t saveDocs(Vbid vbid,
+                                DbHolder& db,
                                 const std::vector<Doc*>& docs,
                                 std::vector<DocInfo*>& docinfos,
                                 kvstats_ctx& kvctx);
 
+    /**
+     * Update the cached file stats (doc / delete counts, file size and space
+     * used) of a vBucket from the header of a commit.
+     */
+    void updateCachedFileStats(Vbid vbid, const cb::couchstore::Header& info);
+
+    /**
+     * Invoke the persistence callbacks for a committed flush-batch.
+     *
+     * @param committedReqs the requests of the flush-batch
+     * @param keyWasOnDisk keys which existed on disk before the commit
+     * @param txCtx the transaction context of the flush-batch
+     * @param errCode the result of the commit (and of its sync)
+     */
     void commitCallback(PendingRequestQueue& committedReqs,
-                        kvstats_ctx& kvctx,
+                        const std::unordered_set<DiskDocKey>& keyWasOnDisk,
+                        TransactionContext& txCtx,
                         couchstore_error_t errCode);
 
     /**
@@ -766,6 +798,19 @@ protected:
      */
     std::unique_ptr<FileOpsInterface> statCollectingFileOpsCompaction;
 
+    /**
+     * FileOpsInterface implementation used by the flusher's commits, wrapping
+     * statCollectingFileOps, which can defer the sync of a commit (group
+     * commit, see setDeferredSync).
+     */
+    std::unique_ptr<DeferredSyncOps> deferredSyncFileOps;
+
+    /// A commit whose sync has been deferred, and its persistence callbacks.
+    struct DeferredCommit;
+
+    /// Commits awaiting syncDeferredCommits(), in commit order.
+    std::vector<DeferredCommit> deferredCommits;
+
     /* deleted docs in each file, indexed by vBucket. RelaxedAtomic
        to allow stats access witout lock */
     std::vector<cb::RelaxedAtomic<size_t>> cachedDeleteCount;
@@ -150,6 +150,22 @@ ActiveStream::~ActiveStream() {
 }
 
 std::unique_ptr<DcpResponse> ActiveStream::next() {
+    // Fast path: an in-memory stream with responses already in the readyQ
+    // can be served without streamMutex (which the checkpoint processor task
+    // holds while building the next snapshot). Anything else - including
+    // reaching the end seqno - needs the state machine under streamMutex.
+    if (isInMemory() && lastSentSeqno.load() < end_seqno_ &&
+        !readyQ.empty()) {
+        auto response = nextQueuedItem();
+        if (response) {
+            if (nextHook) {
+                nextHook();
+            }
+            itemsReady.store(true);
+            return response;
+        }
+    }
+
     std::lock_guard<std::mutex> lh(streamMutex);
     return next(lh);
 }
@@ -973,6 +989,7 @@ void ActiveStream::addTakeoverStats(const AddStatFn& add_stat,
 }
 
 std::unique_ptr<DcpResponse> ActiveStream::nextQueuedItem() {
+    std::lock_guard<std::mutex> consumerLock(readyQConsumerLock);
     if (!readyQ.empty()) {
         auto& response = readyQ.front();
         auto producer = producerPtr.lock();
@@ -991,7 +1008,7 @@ std::unique_ptr<DcpResponse> ActiveStream::nextQueuedItem() {
                 }
             }
 
-            return popFromReadyQ();
+            return popFromReadyQ(consumerLock);
         }
     }
     return nullptr;
@@ -1446,7 +1463,7 @@ void ActiveStream::snapshot(CheckpointType checkpointType,
                                        ? std::make_optional(maxVisibleSeqno)
                                        : std::nullopt;
 
-        pushToReadyQ(std::make_unique<SnapshotMarker>(
+        stageToReadyQ(std::make_unique<SnapshotMarker>(
                 opaque_,
                 vb_,
                 snapStart,
@@ -1463,13 +1480,15 @@ void ActiveStream::snapshot(CheckpointType checkpointType,
         nextSnapshotIsCheckpoint = false;
     }
 
+    // Hand the whole snapshot over to the front-end in one go.
     for (auto& item : items) {
-        pushToReadyQ(std::move(item));
+        stageToReadyQ(std::move(item));
     }
 
     if (isSeqnoAdvancedEnabled() && isSeqnoGapAtEndOfSnapshot()) {
         queueSeqnoAdvanced();
     }
+    publishReadyQ();
 }
 
 void ActiveStream::setDeadInner(cb::mcbp::DcpStreamEndStatus status) {
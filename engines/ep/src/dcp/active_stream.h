@@ -383,6 +383,10 @@ protected:
 
     bool nextCheckpointItem();
 
+    /**
+     * Pop the next response from the readyQ if flow control allows it to be
+     * sent. Acquires readyQConsumerLock; does not require streamMutex.
+     */
     std::unique_ptr<DcpResponse> nextQueuedItem();
 
     /**
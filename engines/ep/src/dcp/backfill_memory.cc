@@ -154,7 +154,9 @@ backfill_status_t DCPBackfillMemoryBuffered::create() {
     }
 
     /* Advance the cursor till start, mark snapshot and update backfill
-       remaining count */
+       remaining count. Seek first, which lets a SequenceList that supports
+       it skip the items before start without visiting each of them */
+    rangeItr.seek(startSeqno);
     while (rangeItr.curr() != rangeItr.end()) {
         if (static_cast<uint64_t>((*rangeItr).getBySeqno()) >= startSeqno) {
             /* Determine the endSeqno of the current snapshot.
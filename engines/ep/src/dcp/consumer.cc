@@ -56,6 +56,7 @@ class DcpConsumerTask : public GlobalTask {
 public:
     DcpConsumerTask(EventuallyPersistentEngine* e,
                     std::shared_ptr<DcpConsumer> c,
+                    size_t processor,
                     double sleeptime = 1,
                     bool completeBeforeShutdown = true)
         : GlobalTask(e,
@@ -63,14 +64,19 @@ public:
                      sleeptime,
                      completeBeforeShutdown),
           consumerPtr(c),
+          processor(processor),
           description("DcpConsumerTask, processing buffered items for " +
-                      c->getName()) {
+                      c->getName() +
+                      (c->getNumProcessors() > 1
+                               ? " (processor " + std::to_string(processor) +
+                                         ")"
+                               : "")) {
     }
 
     ~DcpConsumerTask() override {
         auto consumer = consumerPtr.lock();
         if (consumer) {
-            consumer->taskCancelled();
+            consumer->taskCancelled(processor);
         }
     }
 
@@ -86,7 +92,8 @@ public:
         }
 
         double sleepFor = 0.0;
-        enum process_items_error_t state = consumer->processBufferedItems();
+        enum process_items_error_t state =
+                consumer->processBufferedItems(processor);
         switch (state) {
             case all_processed:
                 sleepFor = INT_MAX;
@@ -104,30 +111,30 @@ public:
         // Check if we've been notified of more work to do - if not then sleep;
         // if so then wakeup and re-run the task.
         // Note: The order of the wakeUp / snooze here is *critical* - another
-        // thread may concurrently notify us (set processorNotification=true)
+        // thread may concurrently notify us (set Processor::notification=true)
         // while we are performing the checks, so we need to ensure we don't
         // loose a wakeup as that would result in this Task sleeping forever
         // (and DCP hanging).
         // To prevent this, we perform an initial check of notifiedProcessor(),
         // which if false we initially sleep, and then check a second time.
-        // We could race if the other actor sets processorNotification=true
+        // We could race if the other actor sets Processor::notification=true
         // between the second `if(consumer->notifiedProcessor)` and us calling
         // `wakeUp()`; but that's essentially a benign race as it will just
         // result in wakeUp() being called twice which is benign.
-        if (consumer->notifiedProcessor(false)) {
+        if (consumer->notifiedProcessor(processor, false)) {
             wakeUp();
             state = more_to_process;
         } else {
             snooze(sleepFor);
             // Check if the processor was notified again,
             // in which case the task should wake immediately.
-            if (consumer->notifiedProcessor(false)) {
+            if (consumer->notifiedProcessor(processor, false)) {
                 wakeUp();
                 state = more_to_process;
             }
         }
 
-        consumer->setProcessorTaskState(state);
+        consumer->setProcessorTaskState(processor, state);
 
         return true;
     }
@@ -143,9 +150,12 @@ public:
     }
 
 private:
-    /* we have one task per consumer. the task only needs a reference to the
-       consumer object and does not own it. Hence std::weak_ptr should be used*/
+    /* we have dcp_consumer_processor_tasks tasks per consumer. the task only
+       needs a reference to the consumer object and does not own it. Hence
+       std::weak_ptr should be used*/
     const std::weak_ptr<DcpConsumer> consumerPtr;
+    // The Processor (and hence the set of vBuckets) this task drains
+    const size_t processor;
     const std::string description;
 };
 
@@ -157,15 +167,11 @@ DcpConsumer::DcpConsumer(EventuallyPersistentEngine& engine,
       lastMessageTime(ep_current_time()),
       engine(engine),
       opaqueCounter(0),
-      processorTaskId(0),
-      processorTaskState(all_processed),
-      processorNotification(false),
       backoffs(0),
       dcpNoopTxInterval(engine.getConfiguration().getDcpNoopTxInterval()),
       pendingSendStreamEndOnClientStreamClose(true),
       consumerName(std::move(consumerName_)),
       producerIsVersion5orHigher(false),
-      processorTaskRunning(false),
       flowControl(engine, this),
       processBufferedMessagesYieldThreshold(
               engine.getConfiguration()
@@ -174,6 +180,10 @@ DcpConsumer::DcpConsumer(EventuallyPersistentEngine& engine,
               engine.getConfiguration()
                       .getDcpConsumerProcessBufferedMessagesBatchSize()) {
     Configuration& config = engine.getConfiguration();
+    for (size_t i = 0; i < config.getDcpConsumerProcessorTasks(); i++) {
+        processors.push_back(std::make_unique<Processor>());
+    }
+
     setSupportAck(false);
     setLogHeader("DCP (Consumer) " + getName() + " -");
     setReserved(true);
@@ -212,14 +222,17 @@ DcpConsumer::~DcpConsumer() {
 
 
 void DcpConsumer::cancelTask() {
-    bool exp = true;
-    if (processorTaskRunning.compare_exchange_strong(exp, false)) {
-        ExecutorPool::get()->cancel(processorTaskId);
+    // Cancel every task which has been scheduled, whether or not it is still
+    // flagged as running: the others are not stopped when one of them exits.
+    for (const auto& processor : processors) {
+        if (processor->taskId != 0) {
+            ExecutorPool::get()->cancel(processor->taskId);
+        }
     }
 }
 
-void DcpConsumer::taskCancelled() {
-    processorTaskRunning.store(false);
+void DcpConsumer::taskCancelled(size_t processor) {
+    processors.at(processor)->taskRunning.store(false);
 }
 
 std::shared_ptr<PassiveStream> DcpConsumer::makePassiveStream(
@@ -305,13 +318,16 @@ ENGINE_ERROR_CODE DcpConsumer::addStream(uint32_t opaque,
         }
     }
 
-    /* We need 'Processor' task only when we have a stream. Hence create it
-     only once when the first stream is added */
-    bool exp = false;
-    if (processorTaskRunning.compare_exchange_strong(exp, true)) {
-        ExTask task = std::make_shared<DcpConsumerTask>(
-                &engine, shared_from_this(), 1);
-        processorTaskId = ExecutorPool::get()->schedule(task);
+    /* We need 'Processor' tasks only when we have a stream. Hence create
+     them only once when the first stream is added (or again for any which
+     have since exited) */
+    for (size_t i = 0; i < processors.size(); i++) {
+        bool exp = false;
+        if (processors[i]->taskRunning.compare_exchange_strong(exp, true)) {
+            ExTask task = std::make_shared<DcpConsumerTask>(
+                    &engine, shared_from_this(), i, 1);
+            processors[i]->taskId = ExecutorPool::get()->schedule(task);
+        }
     }
 
     stream = makePassiveStream(engine_,
@@ -1145,14 +1161,25 @@ void DcpConsumer::addStats(const AddStatFn& add_stat, const void* c) {
     }
 
     addStat("total_backoffs", backoffs, add_stat, c);
-    addStat("processor_task_state", getProcessorTaskStatusStr(), add_stat, c);
     flowControl.addStats(add_stat, c);
 
-    vbReady.addStats(getName() + ":dcp_buffered_ready_queue_", add_stat, c);
-    addStat("processor_notification",
-            processorNotification.load(),
-            add_stat,
-            c);
+    for (size_t i = 0; i < processors.size(); i++) {
+        // Processor 0 keeps the stat names from before the processing was
+        // split over several tasks.
+        const std::string suffix = i == 0 ? "" : "_" + std::to_string(i);
+        addStat("processor_task_state" + suffix,
+                getProcessorTaskStatusStr(i),
+                add_stat,
+                c);
+        processors[i]->vbReady.addStats(
+                getName() + ":dcp_buffered_ready_queue" + suffix + "_",
+                add_stat,
+                c);
+        addStat("processor_notification" + suffix,
+                processors[i]->notification.load(),
+                add_stat,
+                c);
+    }
 
     addStat("synchronous_replication", isSyncReplicationEnabled(), add_stat, c);
 }
@@ -1166,6 +1193,7 @@ process_items_error_t DcpConsumer::drainStreamsBufferedItems(
     process_items_error_t rval = all_processed;
     uint32_t bytesProcessed = 0;
     size_t iterations = 0;
+    auto& vbReady = getProcessor(stream->getVBucket()).vbReady;
     do {
         switch (engine_.getReplicationThrottle().getStatus()) {
         case ReplicationThrottle::Status::Pause:
@@ -1213,9 +1241,10 @@ process_items_error_t DcpConsumer::drainStreamsBufferedItems(
     return rval;
 }
 
-process_items_error_t DcpConsumer::processBufferedItems() {
+process_items_error_t DcpConsumer::processBufferedItems(size_t processor) {
     process_items_error_t process_ret = all_processed;
     Vbid vbucket = Vbid(0);
+    auto& vbReady = processors.at(processor)->vbReady;
     while (vbReady.popFront(vbucket)) {
         auto stream = findStream(vbucket);
 
@@ -1249,23 +1278,26 @@ process_items_error_t DcpConsumer::processBufferedItems() {
 }
 
 void DcpConsumer::notifyVbucketReady(Vbid vbucket) {
-    if (vbReady.pushUnique(vbucket) &&
-        notifiedProcessor(true)) {
-        ExecutorPool::get()->wake(processorTaskId);
+    const auto processor = getProcessorFor(vbucket);
+    if (processors[processor]->vbReady.pushUnique(vbucket) &&
+        notifiedProcessor(processor, true)) {
+        ExecutorPool::get()->wake(processors[processor]->taskId);
     }
 }
 
-bool DcpConsumer::notifiedProcessor(bool to) {
+bool DcpConsumer::notifiedProcessor(size_t processor, bool to) {
     bool inverse = !to;
-    return processorNotification.compare_exchange_strong(inverse, to);
+    return processors.at(processor)->notification.compare_exchange_strong(
+            inverse, to);
 }
 
-void DcpConsumer::setProcessorTaskState(enum process_items_error_t to) {
-    processorTaskState = to;
+void DcpConsumer::setProcessorTaskState(size_t processor,
+                                        enum process_items_error_t to) {
+    processors.at(processor)->taskState = to;
 }
 
-std::string DcpConsumer::getProcessorTaskStatusStr() const {
-    switch (processorTaskState.load()) {
+std::string DcpConsumer::getProcessorTaskStatusStr(size_t processor) const {
+    switch (processors.at(processor)->taskState.load()) {
         case all_processed:
             return "ALL_PROCESSED";
         case more_to_process:
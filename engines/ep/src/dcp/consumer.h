@@ -31,6 +31,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <engines/ep/src/collections/collections_types.h>
 
 class DcpResponse;
@@ -267,7 +268,13 @@ public:
 
     void closeStreamDueToVbStateChange(Vbid vbucket, vbucket_state_t state);
 
-    process_items_error_t processBufferedItems();
+    /**
+     * Drain the buffered items of the vBuckets owned by the given Processor
+     * task.
+     *
+     * @param processor index of the Processor task (see getProcessorFor)
+     */
+    process_items_error_t processBufferedItems(size_t processor = 0);
 
     uint64_t incrOpaqueCounter();
 
@@ -281,13 +288,29 @@ public:
 
     void cancelTask();
 
-    void taskCancelled();
+    /// Called when the task of the given Processor is destroyed
+    void taskCancelled(size_t processor);
+
+    bool notifiedProcessor(size_t processor, bool to);
 
-    bool notifiedProcessor(bool to);
+    void setProcessorTaskState(size_t processor,
+                               enum process_items_error_t to);
 
-    void setProcessorTaskState(enum process_items_error_t to);
+    std::string getProcessorTaskStatusStr(size_t processor = 0) const;
 
-    std::string getProcessorTaskStatusStr() const;
+    /// @return the number of Processor tasks this consumer fans out over
+    size_t getNumProcessors() const {
+        return processors.size();
+    }
+
+    /**
+     * @return the index of the Processor task which drains the buffered
+     *         items of the given vBucket. A vBucket is always owned by the
+     *         same task so that its messages are applied in order.
+     */
+    size_t getProcessorFor(Vbid vbucket) const {
+        return vbucket.get() % processors.size();
+    }
 
     /**
      * Check if the enough bytes have been removed from the flow control
@@ -543,11 +566,29 @@ protected:
     /* Reference to the ep engine; need to create the 'Processor' task */
     EventuallyPersistentEngine& engine;
     uint64_t opaqueCounter;
-    size_t processorTaskId;
-    std::atomic<enum process_items_error_t> processorTaskState;
 
-    VBReadyQueue vbReady;
-    std::atomic<bool> processorNotification;
+    /**
+     * State of one 'Processor' task. The buffered items of a consumer are
+     * split by vBucket over dcp_consumer_processor_tasks tasks, each with
+     * its own ready queue, so that one connection carrying many vBuckets
+     * (e.g. during rebalance) is not bound to a single NonIO thread.
+     */
+    struct Processor {
+        /// Id of the task last scheduled; 0 if none has been
+        std::atomic<size_t> taskId{0};
+        /// Whether the task is running (scheduled and not yet destroyed)
+        std::atomic<bool> taskRunning{false};
+        std::atomic<enum process_items_error_t> taskState{all_processed};
+        VBReadyQueue vbReady;
+        std::atomic<bool> notification{false};
+    };
+
+    Processor& getProcessor(Vbid vbucket) {
+        return *processors[getProcessorFor(vbucket)];
+    }
+
+    // Fixed at construction; never resized so may be read without a lock.
+    std::vector<std::unique_ptr<Processor>> processors;
 
     std::mutex readyMutex;
     std::list<Vbid> ready;
@@ -615,9 +656,6 @@ protected:
      */
     BlockingDcpControlNegotiation deletedUserXattrsNegotiation;
 
-    /* Indicates if the 'Processor' task is running */
-    std::atomic<bool> processorTaskRunning;
-
     FlowControl flowControl;
 
        /**
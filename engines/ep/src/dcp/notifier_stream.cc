@@ -108,10 +108,13 @@ std::unique_ptr<DcpResponse> NotifierStream::next() {
         return nullptr;
     }
 
+    // The readyQ front may only be accessed by its consumer; hold the
+    // consumer lock across front() and the pop, as ActiveStream does.
+    std::lock_guard<std::mutex> consumerLock(readyQConsumerLock);
     auto& response = readyQ.front();
     auto producer = producerPtr.lock();
     if (producer && producer->bufferLogInsert(response->getMessageSize())) {
-        return popFromReadyQ();
+        return popFromReadyQ(consumerLock);
     }
     return nullptr;
 }
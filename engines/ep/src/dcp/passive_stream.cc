@@ -31,6 +31,7 @@
 #include <gsl.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <memory>
 
 const std::string passiveStreamLoggingPrefix =
@@ -331,7 +332,10 @@ ENGINE_ERROR_CODE PassiveStream::messageReceived(
         return ENGINE_DISCONNECT;
     case ReplicationThrottle::Status::Process:
         if (buffer.empty()) {
-            /* Process the response here itself rather than buffering it */
+            /* Process the response here itself rather than buffering it.
+             * The consumer hands us one message per call, so mutations on
+             * this path are stored individually; only mutations which have
+             * been buffered are applied in batches (processMutationBatch). */
             ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
             switch (dcpResponse->getEvent()) {
             case DcpResponse::Event::Mutation:
@@ -432,6 +436,69 @@ process_items_error_t PassiveStream::processBufferedMessages(
             return all_processed;
         }
 
+        // A snapshot is mostly mutations; apply the run of mutations at the
+        // front of the buffer as one batch.
+        if (buffer.front(lh)->getEvent() == DcpResponse::Event::Mutation) {
+            // As below (MB-31410), the messages stay in the buffer until
+            // they have been processed.
+            std::vector<std::unique_ptr<DcpResponse>> mutations;
+            for (auto& message : buffer.messages) {
+                if (count + mutations.size() == batchSize ||
+                    message->getEvent() != DcpResponse::Event::Mutation) {
+                    break;
+                }
+                mutations.push_back(std::move(message));
+            }
+            lh.unlock();
+
+            // MB-31410: Only used for testing
+            if (processBufferedMessages_postFront_Hook) {
+                processBufferedMessages_postFront_Hook();
+            }
+
+            const auto results = processMutationBatch(mutations);
+
+            size_t processed = 0;
+            for (; processed < results.size(); ++processed) {
+                const auto rv = results[processed];
+                if (rv == ENGINE_TMPFAIL || rv == ENGINE_ENOMEM) {
+                    failed = true;
+                    noMem = (rv == ENGINE_ENOMEM);
+                    break;
+                }
+            }
+
+            lh.lock();
+            // setDead clears the buffer and sets the state under bufMutex, so
+            // if the stream was closed while we processed the batch then its
+            // messages (still counted in buffer.bytes until popped) have
+            // already been returned by setDead; don't account them again.
+            if (!isActive()) {
+                processed_bytes = total_bytes_processed;
+                return all_processed;
+            }
+
+            for (size_t ii = 0; ii < processed; ++ii) {
+                message_bytes = mutations[ii]->getMessageSize();
+                buffer.pop_front(lh, message_bytes);
+                count++;
+                if (results[ii] != ENGINE_ERANGE) {
+                    total_bytes_processed += message_bytes;
+                }
+            }
+
+            // Give the messages we did not process back to the buffer, to be
+            // retried at the next run (see the single message case below).
+            if (failed) {
+                for (size_t ii = processed; ii < mutations.size(); ++ii) {
+                    buffer.messages[ii - processed] = std::move(mutations[ii]);
+                }
+                lh.unlock();
+                break;
+            }
+            continue;
+        }
+
         // MB-31410: The front-end thread can process new incoming messages
         // only /after/ all the buffered ones have been processed.
         // So, here we get only a reference. We remove the message from the
@@ -713,6 +780,99 @@ ENGINE_ERROR_CODE PassiveStream::processMutation(
     return processMessage(mutation, MessageType::Mutation);
 }
 
+std::vector<ENGINE_ERROR_CODE> PassiveStream::processMutationBatch(
+        const std::vector<std::unique_ptr<DcpResponse>>& mutations) {
+    std::vector<ENGINE_ERROR_CODE> results(mutations.size(), ENGINE_SUCCESS);
+    VBucketPtr vb = engine->getVBucket(vb_);
+    if (!vb) {
+        std::fill(results.begin(), results.end(), ENGINE_NOT_MY_VBUCKET);
+        return results;
+    }
+
+    auto consumer = consumerPtr.lock();
+    if (!consumer) {
+        std::fill(results.begin(), results.end(), ENGINE_DISCONNECT);
+        return results;
+    }
+
+    // Check each mutation as processMessage does; the ones which pass are
+    // stored as one batch. The batch shares the vBucket lookup, state lock
+    // and memory check; each item still takes its own HashTable lock and
+    // checkpoint queue op, as queueDirty must run under the HashTable lock
+    // (and for Ephemeral append to the seqList) in seqno order.
+    std::vector<Item*> items;
+    std::vector<size_t> itemIndexes;
+    for (size_t ii = 0; ii < mutations.size(); ++ii) {
+        auto& message = static_cast<MutationConsumerMessage&>(*mutations[ii]);
+        if (uint64_t(*message.getBySeqno()) < cur_snapshot_start.load() ||
+            uint64_t(*message.getBySeqno()) > cur_snapshot_end.load()) {
+            log(spdlog::level::level_enum::warn,
+                "({}) Erroneous mutation [sequence "
+                "number does not fall in the expected snapshot range : "
+                "{{snapshot_start ({}) <= seq_no ({}) <= "
+                "snapshot_end ({})]; Dropping the mutation!",
+                vb_,
+                cur_snapshot_start.load(),
+                *message.getBySeqno(),
+                cur_snapshot_end.load());
+            results[ii] = ENGINE_ERANGE;
+            continue;
+        }
+
+        // MB-17517: See processMessage.
+        if (!Item::isValidCas(message.getItem()->getCas())) {
+            log(spdlog::level::level_enum::warn,
+                "Invalid CAS ({:#x}) received for mutation {{{}, seqno:{}}}. "
+                "Regenerating new CAS",
+                message.getItem()->getCas(),
+                vb_,
+                message.getItem()->getBySeqno());
+            message.getItem()->setCas();
+        }
+        items.push_back(message.getItem().get());
+        itemIndexes.push_back(ii);
+    }
+    if (items.empty()) {
+        return results;
+    }
+
+    const auto setResults =
+            engine->getKVBucket()->setWithMetaBatch(*vb,
+                                                    items,
+                                                    consumer->getCookie(),
+                                                    {vbucket_state_active,
+                                                     vbucket_state_replica,
+                                                     vbucket_state_pending});
+
+    for (size_t jj = 0; jj < setResults.size(); ++jj) {
+        const auto ret = setResults[jj];
+        const auto& item = *items[jj];
+        results[itemIndexes[jj]] = ret;
+
+        // ENOMEM logging is handled by maybeLogMemoryState
+        if (ret != ENGINE_SUCCESS && ret != ENGINE_ENOMEM) {
+            log(spdlog::level::level_enum::warn,
+                "{} Got error '{}' while trying to process "
+                "mutation with seqno:{}",
+                vb_,
+                cb::to_string(cb::to_engine_errc(ret)),
+                item.getBySeqno());
+        } else {
+            handleSnapshotEnd(vb, item.getBySeqno());
+        }
+
+        maybeLogMemoryState(
+                cb::to_engine_errc(ret), "mutation", item.getBySeqno());
+    }
+
+    // If the batch stopped early, the messages after the one which failed
+    // were not processed.
+    if (setResults.size() < items.size()) {
+        results.resize(itemIndexes[setResults.size() - 1] + 1);
+    }
+    return results;
+}
+
 ENGINE_ERROR_CODE PassiveStream::processDeletion(
         MutationConsumerMessage* deletion) {
     return processMessage(deletion, MessageType::Deletion);
@@ -24,6 +24,8 @@
 #include <engines/ep/src/collections/collections_types.h>
 #include <memcached/engine_error.h>
 
+#include <vector>
+
 class AbortSyncWrite;
 class BucketLogger;
 class CommitSyncWrite;
@@ -145,6 +147,21 @@ protected:
      */
     virtual ENGINE_ERROR_CODE processMutation(
             MutationConsumerMessage* mutation);
+
+    /**
+     * Apply a run of buffered mutations (all Event::Mutation, in seqno
+     * order) as one batch - the vBucket and consumer are looked up once and
+     * the items are stored via KVBucket::setWithMetaBatch. Each message is
+     * otherwise handled as processMutation would.
+     *
+     * Stops at the first message which fails with ENGINE_TMPFAIL or
+     * ENGINE_ENOMEM; that message and those after it should be retried.
+     *
+     * @param mutations the messages to apply
+     * @return the status of each message processed, in order
+     */
+    std::vector<ENGINE_ERROR_CODE> processMutationBatch(
+            const std::vector<std::unique_ptr<DcpResponse>>& mutations);
     /**
      * Deal with incoming deletion sent to the DcpConsumer/PassiveStream by
      * passing to processMessage with MessageType::Deletion
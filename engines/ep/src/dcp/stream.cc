@@ -63,34 +63,59 @@ Stream::Stream(std::string name,
 }
 
 Stream::~Stream() {
-    // NB: reusing the "unlocked" method without a lock because we're
-    // destructing and should not take any locks.
+    // NB: reusing the "unlocked" method without streamMutex because we're
+    // destructing; readyQConsumerLock is uncontended by now.
     clear_UNLOCKED();
 }
 
 void Stream::clear_UNLOCKED() {
+    std::lock_guard<std::mutex> consumerLock(readyQConsumerLock);
     while (!readyQ.empty()) {
-        popFromReadyQ();
+        popFromReadyQ(consumerLock);
     }
 }
 
 void Stream::pushToReadyQ(std::unique_ptr<DcpResponse> resp) {
+    /* expect streamMutex.ownsLock() == true */
+    stageToReadyQ(std::move(resp));
+    publishReadyQ();
+}
+
+void Stream::stageToReadyQ(std::unique_ptr<DcpResponse> resp) {
     /* expect streamMutex.ownsLock() == true */
     if (resp) {
         if (!resp->isMetaEvent()) {
-            readyQ_non_meta_items++;
+            stagedNonMetaItems++;
         }
-        readyQueueMemory.fetch_add(resp->getMessageSize(),
-                                   std::memory_order_relaxed);
-        readyQ.push(std::move(resp));
+        stagedMemory += resp->getMessageSize();
+        readyQ.stage(std::move(resp));
     }
 }
 
-std::unique_ptr<DcpResponse> Stream::popFromReadyQ() {
+void Stream::publishReadyQ() {
     /* expect streamMutex.ownsLock() == true */
+    // Account for the staged responses before they become visible, so the
+    // consumer can never decrement the counters below zero.
+    if (stagedNonMetaItems) {
+        readyQ_non_meta_items += stagedNonMetaItems;
+        stagedNonMetaItems = 0;
+    }
+    if (stagedMemory) {
+        readyQueueMemory.fetch_add(stagedMemory, std::memory_order_relaxed);
+        stagedMemory = 0;
+    }
+    readyQ.publish();
+}
+
+std::unique_ptr<DcpResponse> Stream::popFromReadyQ() {
+    std::lock_guard<std::mutex> consumerLock(readyQConsumerLock);
+    return popFromReadyQ(consumerLock);
+}
+
+std::unique_ptr<DcpResponse> Stream::popFromReadyQ(
+        const std::lock_guard<std::mutex>& consumerLock) {
     if (!readyQ.empty()) {
-        auto front = std::move(readyQ.front());
-        readyQ.pop();
+        auto front = readyQ.pop();
 
         if (!front->isMetaEvent()) {
             readyQ_non_meta_items--;
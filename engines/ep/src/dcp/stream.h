@@ -19,6 +19,7 @@
 
 #include "cursor.h"
 #include "dcp/dcp-types.h"
+#include "spsc_queue.h"
 
 #include <mcbp/protocol/dcp_stream_end_status.h>
 #include <memcached/dcp_stream_id.h>
@@ -27,7 +28,6 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 
 class CheckpointCursor;
@@ -126,9 +126,23 @@ protected:
     /* To be called after getting streamMutex lock */
     void pushToReadyQ(std::unique_ptr<DcpResponse> resp);
 
+    /**
+     * Add a response to the readyQ without making it visible to the consumer
+     * until the next publishReadyQ() / pushToReadyQ(). Used to hand off a
+     * whole snapshot at once.
+     * To be called after getting streamMutex lock.
+     */
+    void stageToReadyQ(std::unique_ptr<DcpResponse> resp);
+
     /* To be called after getting streamMutex lock */
+    void publishReadyQ();
+
+    /* Acquires readyQConsumerLock */
     std::unique_ptr<DcpResponse> popFromReadyQ();
 
+    std::unique_ptr<DcpResponse> popFromReadyQ(
+            const std::lock_guard<std::mutex>& consumerLock);
+
     uint64_t getReadyQueueMemory();
 
     std::string name_;
@@ -149,8 +163,16 @@ protected:
      * Elements are added to this queue by reading from disk/memory etc, and
      * are removed when sending over the network to our peer.
      * The readyQ owns the elements in it.
+     *
+     * Single-producer / single-consumer: elements are added with streamMutex
+     * held, and removed with readyQConsumerLock held. This allows the
+     * front-end thread to drain the queue while another thread (e.g. the
+     * ActiveStreamCheckpointProcessorTask) holds streamMutex.
      */
-    std::queue<std::unique_ptr<DcpResponse>> readyQ;
+    SPSCQueue<std::unique_ptr<DcpResponse>> readyQ;
+
+    /// Lock which must be acquired to consume (pop) elements from readyQ.
+    mutable std::mutex readyQConsumerLock;
 
     // Number of items in the readyQ that are not meta items. Used for
     // calculating getItemsRemaining(). Atomic so it can be safely read by
@@ -162,6 +184,12 @@ protected:
     Cursor noCursor;
 
 private:
+    /// Accounting for responses staged in readyQ but not yet published,
+    /// applied to readyQ_non_meta_items / readyQueueMemory on publish.
+    /// Guarded by streamMutex.
+    size_t stagedNonMetaItems = 0;
+    uint64_t stagedMemory = 0;
+
     /* readyQueueMemory tracks the memory occupied by elements
      * in the readyQ.  It is an atomic because otherwise
        getReadyQueueMemory would need to acquire streamMutex.
@@ -36,6 +36,15 @@ DefragmenterTask::DefragmenterTask(EventuallyPersistentEngine* e,
 bool DefragmenterTask::run() {
     TRACE_EVENT0("ep-engine/task", "DefragmenterTask");
     if (engine->getConfiguration().isDefragmenterEnabled()) {
+        auto& maintenance = engine->getKVBucket()->getHashTableMaintenance();
+        if (maintenance.isRegistered(*this)) {
+            // Defragment as part of the pass shared with the other HashTable
+            // maintenance tasks; see prepareChunk() / chunkComplete().
+            maintenance.run(*this);
+            snooze(getSleepTime());
+            return !engine->getEpStats().isShutdown;
+        }
+
         // Get our pause/resume visitor. If we didn't finish the previous pass,
         // then resume from where we last were, otherwise create a new visitor
         // starting from the beginning.
@@ -139,6 +148,12 @@ bool DefragmenterTask::run() {
         if (completed) {
             prAdapter.reset();
         }
+    } else {
+        // Don't hold up the other tasks sharing a pass while disabled.
+        auto& maintenance = engine->getKVBucket()->getHashTableMaintenance();
+        if (maintenance.isRegistered(*this)) {
+            maintenance.leave(*this);
+        }
     }
 
     snooze(getSleepTime());
@@ -154,6 +169,44 @@ void DefragmenterTask::stop() {
     }
 }
 
+std::unique_ptr<VBucketAwareHTVisitor> DefragmenterTask::createVisitor() {
+    return std::make_unique<DefragmentVisitor>(getMaxValueSize());
+}
+
+bool DefragmenterTask::prepareChunk(VBucketAwareHTVisitor& htVisitor) {
+    if (!engine->getConfiguration().isDefragmenterEnabled()) {
+        return false;
+    }
+
+    auto& visitor = dynamic_cast<DefragmentVisitor&>(htVisitor);
+    visitor.setDeadline(std::chrono::steady_clock::now() + getChunkDuration());
+    visitor.setBlobAgeThreshold(getAgeThreshold());
+    // Only defragment StoredValues of persistent buckets (see run()).
+    if (engine->getConfiguration().getBucketType() == "persistent") {
+        visitor.setStoredValueAgeThreshold(getStoredValueAgeThreshold());
+    }
+    visitor.clearStats();
+
+    // The chunk is run on this thread (by whichever participant's task is
+    // running it), so disable thread-caching for it as run() does.
+    cb::ArenaMalloc::switchToClient(engine->getArenaMallocClient(),
+                                    false /* no tcache*/);
+    return true;
+}
+
+void DefragmenterTask::chunkComplete(VBucketAwareHTVisitor& htVisitor,
+                                     bool completed) {
+    cb::ArenaMalloc::switchToClient(engine->getArenaMallocClient(),
+                                    true /* tcache*/);
+    updateStats(dynamic_cast<DefragmentVisitor&>(htVisitor));
+    cb::ArenaMalloc::releaseMemory(engine->getArenaMallocClient());
+}
+
+bool DefragmenterTask::mayFreeStoredValue() const {
+    // DefragmentVisitor::defragmentStoredValue() reallocates the StoredValue.
+    return true;
+}
+
 std::string DefragmenterTask::getDescription() {
     return "Memory defragmenter";
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "globaltask.h"
+#include "hash_table_maintenance.h"
 #include "kv_bucket_iface.h"
 
 class DefragmentVisitor;
@@ -94,8 +95,12 @@ class PauseResumeVBAdapter;
  *
  * Instead, we limit the duration of each defragmention invocation (chunk),
  * pause, and then later start the next chunk form where we left off.
+ *
+ * If registered with the Bucket's HashTableMaintenance (see
+ * ht_maintenance_shared_pass), the walk is shared with the other HashTable
+ * maintenance tasks instead of being performed by this task alone.
  */
-class DefragmenterTask : public GlobalTask {
+class DefragmenterTask : public GlobalTask, public HashTableMaintenanceConcern {
 public:
     DefragmenterTask(EventuallyPersistentEngine* e, EPStats& stats_);
 
@@ -110,6 +115,12 @@ public:
     /// Maximum allocation size the defragmenter should consider
     static size_t getMaxValueSize();
 
+    // HashTableMaintenanceConcern
+    std::unique_ptr<VBucketAwareHTVisitor> createVisitor() override;
+    bool prepareChunk(VBucketAwareHTVisitor& visitor) override;
+    void chunkComplete(VBucketAwareHTVisitor& visitor, bool completed) override;
+    bool mayFreeStoredValue() const override;
+
 private:
 
     /// Duration (in seconds) defragmenter should sleep for between iterations.
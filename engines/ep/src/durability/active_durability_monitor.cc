@@ -436,6 +436,14 @@ void ActiveDurabilityMonitor::checkForResolvedSyncWrites() {
 void ActiveDurabilityMonitor::processCompletedSyncWriteQueue() {
     std::lock_guard<ResolvedQueue::ConsumerLock> lock(
             resolvedQueue->getConsumerLock());
+
+    // The State is only updated once for the whole batch of completed
+    // SyncWrites, instead of acquiring the State lock for each one (which
+    // contends with seqno acks and new Prepares being added).
+    int64_t lastCommitted = 0;
+    int64_t lastAborted = 0;
+    size_t numCommitted = 0;
+    size_t numAborted = 0;
     while (auto sw = resolvedQueue->try_dequeue(lock)) {
         switch (sw->getStatus()) {
         case SyncWriteStatus::Pending:
@@ -446,14 +454,39 @@ void ActiveDurabilityMonitor::processCompletedSyncWriteQueue() {
                     to_string(sw->getStatus()));
             continue;
         case SyncWriteStatus::ToCommit:
-            commit(*sw);
+            if (commit(*sw)) {
+                lastCommitted = sw->getBySeqno();
+                ++numCommitted;
+            }
             continue;
         case SyncWriteStatus::ToAbort:
             abort(*sw);
+            lastAborted = sw->getBySeqno();
+            ++numAborted;
             continue;
         }
         folly::assume_unreachable();
     };
+
+    if (numCommitted == 0 && numAborted == 0) {
+        return;
+    }
+
+    auto s = state.wlock();
+    if (numCommitted) {
+        s->lastCommittedSeqno = lastCommitted;
+        s->totalCommitted += numCommitted;
+        // Note:
+        // - Level Majority locally-satisfied first at Active by-logic
+        // - Level MajorityAndPersistOnMaster and PersistToMajority must always
+        //     include the Active for being globally satisfied
+        Ensures(s->lastCommittedSeqno <= s->highPreparedSeqno);
+    }
+    if (numAborted) {
+        s->lastAbortedSeqno = lastAborted;
+        s->totalAborted += numAborted;
+    }
+    s->updateHighCompletedSeqno();
 }
 
 void ActiveDurabilityMonitor::unresolveCompletedSyncWriteQueue() {
@@ -544,82 +577,81 @@ ActiveDurabilityMonitor::State::State(const ActiveDurabilityMonitor& adm)
     highCompletedSeqno.setLabel(prefix + "highCompletedSeqno");
 }
 
-ActiveDurabilityMonitor::Container::iterator
-ActiveDurabilityMonitor::State::getNodeNext(const std::string& node) {
+ActiveDurabilityMonitor::State::NodePosition
+ActiveDurabilityMonitor::State::getNodePosition(const std::string& node) {
     Expects(firstChain.get());
-    // Note: Container::end could be the new position when the pointed SyncWrite
-    //     is removed from Container and the iterator repositioned.
-    //     In that case next=Container::begin
+
+    NodePosition pos;
     auto firstChainItr = firstChain->positions.find(node);
     if (firstChainItr != firstChain->positions.end()) {
-        const auto& it = firstChainItr->second.it;
-        return (it == trackedWrites.end()) ? trackedWrites.begin()
-                                           : std::next(it);
+        pos.first = &firstChainItr->second;
     }
 
     if (secondChain) {
         auto secondChainItr = secondChain->positions.find(node);
         if (secondChainItr != secondChain->positions.end()) {
-            const auto& it = secondChainItr->second.it;
-            return (it == trackedWrites.end()) ? trackedWrites.begin()
-                                               : std::next(it);
+            pos.second = &secondChainItr->second;
         }
     }
 
-    // Node not found, return the trackedWrites.end(), stl style.
-    return trackedWrites.end();
+    return pos;
 }
 
 ActiveDurabilityMonitor::Container::iterator
-ActiveDurabilityMonitor::State::advanceNodePosition(const std::string& node) {
-    // We must have at least a firstChain
-    Expects(firstChain.get());
+ActiveDurabilityMonitor::State::getNodeNext(const std::string& node) {
+    return getNodeNext(getNodePosition(node));
+}
 
-    // But the node may not be in it if we have a secondChain
-    auto firstChainItr = firstChain->positions.find(node);
-    auto firstChainFound = firstChainItr != firstChain->positions.end();
-    if (!firstChainFound && !secondChain) {
+ActiveDurabilityMonitor::Container::iterator
+ActiveDurabilityMonitor::State::getNodeNext(const NodePosition& pos) {
+    // The first chain position (if any) is the reference one.
+    const auto* chainPos = pos.first ? pos.first : pos.second;
+    if (!chainPos) {
+        // Node not found, return the trackedWrites.end(), stl style.
+        return trackedWrites.end();
+    }
+
+    // Note: Container::end could be the new position when the pointed SyncWrite
+    //     is removed from Container and the iterator repositioned.
+    //     In that case next=Container::begin
+    const auto& it = chainPos->it;
+    return (it == trackedWrites.end()) ? trackedWrites.begin() : std::next(it);
+}
+
+ActiveDurabilityMonitor::Container::iterator
+ActiveDurabilityMonitor::State::advanceNodePosition(const std::string& node) {
+    const auto pos = getNodePosition(node);
+    if (!pos) {
         // Attempting to advance for a node we don't know about, panic
         throwException<std::logic_error>(
                 __func__,
-                "Attempting to advance positions for an invalid node " + node);
+                "Attempting to advance positions for an invalid node " + node +
+                        (secondChain ? ". Node is not in firstChain or "
+                                       "secondChain"
+                                     : ""));
     }
+    return advanceNodePosition(pos, node);
+}
 
-    std::unordered_map<std::string, Position<Container>>::iterator
-            secondChainItr;
-    auto secondChainFound = false;
-    if (secondChain) {
-        secondChainItr = secondChain->positions.find(node);
-        secondChainFound = secondChainItr != secondChain->positions.end();
-        if (!firstChainFound && !secondChainFound) {
-            throwException<std::logic_error>(
-                    __func__,
-                    "Attempting to advance positions for an invalid node " +
-                            node +
-                            ". Node is not in firstChain or secondChain");
-        }
-    }
+ActiveDurabilityMonitor::Container::iterator
+ActiveDurabilityMonitor::State::advanceNodePosition(const NodePosition& pos,
+                                                    const std::string& node) {
+    Expects(pos);
 
     // Node may be in both chains (or only one) so we need to advance only the
     // correct chain.
-    if (firstChainFound) {
-        auto& pos = const_cast<Position<Container>&>(firstChainItr->second);
+    if (pos.first) {
         // We only ack if we do not have this node in the secondChain because
         // we only want to ack once
-        advanceAndAckForPosition(pos, node, !secondChainFound /*should ack*/);
-        if (!secondChainFound) {
-            return pos.it;
+        advanceAndAckForPosition(*pos.first, node, !pos.second /*should ack*/);
+        if (!pos.second) {
+            return pos.first->it;
         }
     }
 
-    if (secondChainFound) {
-        // Update second chain itr
-        auto& pos = const_cast<Position<Container>&>(secondChainItr->second);
-        advanceAndAckForPosition(pos, node, true /* should ack*/);
-        return pos.it;
-    }
-
-    folly::assume_unreachable();
+    // Update second chain itr
+    advanceAndAckForPosition(*pos.second, node, true /* should ack*/);
+    return pos.second->it;
 }
 
 void ActiveDurabilityMonitor::State::advanceAndAckForPosition(
@@ -774,6 +806,9 @@ ActiveDurabilityMonitor::State::removeSyncWrite(Container::iterator it,
     }
 
     it->setStatus(status);
+    if (it->getExpiryTime()) {
+        adm.vb.setSyncWriteTimeout(it->getBySeqno(), {});
+    }
     // Reset the chains so that we don't attempt to use some possibly re-used
     // memory if we have any bugs that still touch the chains after we remove
     // the SyncWrite from trackedWrites.
@@ -812,12 +847,25 @@ ActiveDurabilityMonitor::State::removeSyncWrite(Container::iterator it,
         }
     }
 
+    // SyncWrites complete in order, so one whose deadline fired while it was
+    // behind an unexpired SyncWrite wasn't aborted (see removeExpired) and has
+    // no timer left. Re-arm it as it becomes the head. (Not needed when
+    // aborting, removeExpired carries on to the next SyncWrite anyway.)
+    if (it == trackedWrites.begin() && status != SyncWriteStatus::ToAbort) {
+        const auto next = std::next(it);
+        if (next != trackedWrites.end() &&
+            next->isExpired(std::chrono::steady_clock::now())) {
+            adm.vb.setSyncWriteTimeout(next->getBySeqno(),
+                                       next->getExpiryTime());
+        }
+    }
+
     Container removed;
     removed.splice(removed.end(), trackedWrites, it);
     return std::move(removed.front());
 }
 
-void ActiveDurabilityMonitor::commit(const ActiveSyncWrite& sw) {
+bool ActiveDurabilityMonitor::commit(const ActiveSyncWrite& sw) {
     const auto& key = sw.getKey();
     auto cHandle = vb.lockCollections(key);
 
@@ -825,7 +873,7 @@ void ActiveDurabilityMonitor::commit(const ActiveSyncWrite& sw) {
         // collection no longer exists, cannot commit
         vb.notifyClientOfSyncWriteComplete(sw.getCookie(),
                                            ENGINE_SYNC_WRITE_AMBIGUOUS);
-        return;
+        return false;
     }
 
     const auto prepareEnd = std::chrono::steady_clock::now();
@@ -857,18 +905,7 @@ void ActiveDurabilityMonitor::commit(const ActiveSyncWrite& sw) {
             std::chrono::duration_cast<std::chrono::microseconds>(
                     prepareEnd - sw.getStartTime());
     stats.syncWriteCommitTimes.at(index).add(commitDuration);
-
-    {
-        auto s = state.wlock();
-        s->lastCommittedSeqno = sw.getBySeqno();
-        s->updateHighCompletedSeqno();
-        s->totalCommitted++;
-        // Note:
-        // - Level Majority locally-satisfied first at Active by-logic
-        // - Level MajorityAndPersistOnMaster and PersistToMajority must always
-        //     include the Active for being globally satisfied
-        Ensures(s->lastCommittedSeqno <= s->highPreparedSeqno);
-    }
+    return true;
 }
 
 void ActiveDurabilityMonitor::abort(const ActiveSyncWrite& sw) {
@@ -890,10 +927,6 @@ void ActiveDurabilityMonitor::abort(const ActiveSyncWrite& sw) {
         vb.notifyClientOfSyncWriteComplete(sw.getCookie(),
                                            ENGINE_SYNC_WRITE_AMBIGUOUS);
     }
-    auto s = state.wlock();
-    s->lastAbortedSeqno = sw.getBySeqno();
-    s->updateHighCompletedSeqno();
-    s->totalAborted++;
 }
 
 void ActiveDurabilityMonitor::eraseSyncWrite(const DocKey& key, int64_t seqno) {
@@ -944,6 +977,10 @@ void ActiveDurabilityMonitor::eraseSyncWrite(const DocKey& key, int64_t seqno) {
         }
     }
 
+    if (toErase->getExpiryTime()) {
+        vb.setSyncWriteTimeout(seqno, {});
+    }
+
     // And erase
     s->trackedWrites.erase(toErase);
 }
@@ -1006,12 +1043,16 @@ void ActiveDurabilityMonitor::State::processSeqnoAck(const std::string& node,
     // We should never ack for the active
     Expects(firstChain->active != node);
 
+    // Resolve the node's Position(s) once; an ack may cover many SyncWrites
+    // and each step below then only moves the Position iterators forwards.
+    const auto nodePos = getNodePosition(node);
+
     // Note: process up to the ack'ed seqno
     ActiveDurabilityMonitor::Container::iterator next;
-    while ((next = getNodeNext(node)) != trackedWrites.end() &&
+    while (nodePos && (next = getNodeNext(nodePos)) != trackedWrites.end() &&
            next->getBySeqno() <= seqno) {
         // Update replica tracking
-        const auto& posIt = advanceNodePosition(node);
+        const auto& posIt = advanceNodePosition(nodePos, node);
 
         // Check if Durability Requirements satisfied now, and add for commit
         if (posIt->isSatisfied()) {
@@ -1398,6 +1439,9 @@ void ActiveDurabilityMonitor::State::addSyncWrite(const void* cookie,
                                defaultTimeout,
                                firstChain.get(),
                                secondChain.get());
+    if (const auto expiry = trackedWrites.back().getExpiryTime()) {
+        adm.vb.setSyncWriteTimeout(seqno, expiry);
+    }
     lastTrackedSeqno = seqno;
     totalAccepted++;
 }
@@ -1473,10 +1517,11 @@ void ActiveDurabilityMonitor::State::updateHighPreparedSeqno(
     const auto& active = getActive();
     // Check if Durability Requirements are satisfied for the Prepare currently
     // tracked for Active, and add for commit in case.
+    const auto activePos = getNodePosition(active);
+    Expects(activePos.first);
     auto removeForCommitIfSatisfied =
-            [this, &active, &completed]() mutable -> void {
-        Expects(firstChain.get());
-        const auto& pos = firstChain->positions.at(active);
+            [this, &activePos, &completed]() mutable -> void {
+        const auto& pos = *activePos.first;
         Expects(pos.it != trackedWrites.end());
         if (pos.it->isSatisfied()) {
             completed.enqueue(
@@ -1488,11 +1533,11 @@ void ActiveDurabilityMonitor::State::updateHighPreparedSeqno(
     // First, blindly move HPS up to high-persisted-seqno. Note that here we
     // don't need to check any Durability Level: persistence makes
     // locally-satisfied all the pending Prepares up to high-persisted-seqno.
-    while ((next = getNodeNext(active)) != trackedWrites.end() &&
-           static_cast<uint64_t>(next->getBySeqno()) <=
-                   adm.vb.getPersistenceSeqno()) {
+    const auto persistenceSeqno = adm.vb.getPersistenceSeqno();
+    while ((next = getNodeNext(activePos)) != trackedWrites.end() &&
+           static_cast<uint64_t>(next->getBySeqno()) <= persistenceSeqno) {
         highPreparedSeqno = next->getBySeqno();
-        advanceNodePosition(active);
+        advanceNodePosition(activePos, active);
         removeForCommitIfSatisfied();
     }
 
@@ -1502,7 +1547,7 @@ void ActiveDurabilityMonitor::State::updateHighPreparedSeqno(
     // satisfied now. The first non-satisfied Prepare is the first
     // PersistToMajority or MajorityAndPersistToMaster not covered by
     // persisted-seqno.
-    while ((next = getNodeNext(active)) != trackedWrites.end()) {
+    while ((next = getNodeNext(activePos)) != trackedWrites.end()) {
         const auto level = next->getDurabilityReqs().getLevel();
         Expects(level != cb::durability::Level::None);
 
@@ -1514,7 +1559,7 @@ void ActiveDurabilityMonitor::State::updateHighPreparedSeqno(
         }
 
         highPreparedSeqno = next->getBySeqno();
-        advanceNodePosition(active);
+        advanceNodePosition(activePos, active);
         removeForCommitIfSatisfied();
     }
 
@@ -300,6 +300,8 @@ public:
     /**
      * For all items in the completedSWQueue, call VBucket::commit /
      * VBucket::abort as appropriate, then remove the item from the queue.
+     * The State (HCS, commit/abort counters) is updated once for the whole
+     * batch.
      */
     void processCompletedSyncWriteQueue();
 
@@ -360,14 +362,18 @@ protected:
                                      const std::string& error) const;
 
     /**
-     * Commit the given SyncWrite.
+     * Commit the given SyncWrite. Does not update the State, the caller must
+     * account the commit (see processCompletedSyncWriteQueue).
      *
      * @param sw The SyncWrite to commit
+     * @return true if committed, false if the collection of the SyncWrite no
+     *         longer exists (the client is notified of an ambiguous outcome)
      */
-    void commit(const ActiveSyncWrite& sw);
+    bool commit(const ActiveSyncWrite& sw);
 
     /**
-     * Abort the given SyncWrite.
+     * Abort the given SyncWrite. Does not update the State, the caller must
+     * account the abort (see processCompletedSyncWriteQueue).
      *
      * @param sw The SyncWrite to abort
      */
@@ -192,6 +192,11 @@ public:
      */
     bool isExpired(std::chrono::steady_clock::time_point asOf) const;
 
+    /// @return the time this SyncWrite expires at, if it has a timeout.
+    std::optional<std::chrono::steady_clock::time_point> getExpiryTime() const {
+        return expiryTime;
+    }
+
     /**
      * Reset the ack-state for this SyncWrite and set it up for the new
      * given topology. In general, checkDurabilityPossibleAndResetTopology
@@ -436,6 +441,29 @@ struct ActiveDurabilityMonitor::State {
      */
     void addSyncWrite(const void* cookie, queued_item item);
 
+    /**
+     * The Position(s) of a node in the first and second chain. Either (or
+     * both) may be null if the node is not in that chain.
+     *
+     * Resolving a node once and then using the overloads below taking a
+     * NodePosition avoids looking the node up in the chains for every
+     * SyncWrite the node is advanced over.
+     */
+    struct NodePosition {
+        explicit operator bool() const {
+            return first || second;
+        }
+
+        Position<Container>* first = nullptr;
+        Position<Container>* second = nullptr;
+    };
+
+    /**
+     * @param node
+     * @return the Position(s) of the given node in the current topology
+     */
+    NodePosition getNodePosition(const std::string& node);
+
     /**
      * Returns the next position for a node iterator.
      *
@@ -445,6 +473,9 @@ struct ActiveDurabilityMonitor::State {
      */
     Container::iterator getNodeNext(const std::string& node);
 
+    /// Overload of getNodeNext for an already resolved node.
+    Container::iterator getNodeNext(const NodePosition& pos);
+
     /**
      * Advance a node tracking to the next Position in the tracked
      * Container. Note that a Position tracks a node in terms of both:
@@ -458,6 +489,15 @@ struct ActiveDurabilityMonitor::State {
      */
     Container::iterator advanceNodePosition(const std::string& node);
 
+    /**
+     * Overload of advanceNodePosition for an already resolved node.
+     *
+     * @param pos the Position(s) of the node, must not be empty
+     * @param node the node to advance
+     */
+    Container::iterator advanceNodePosition(const NodePosition& pos,
+                                            const std::string& node);
+
     /**
      * This function updates the tracking with the last seqno ack'ed by
      * node.
@@ -18,9 +18,12 @@
 #include "durability_timeout_task.h"
 #include "ep_engine.h"
 #include "kv_bucket.h"
+#include "vbucket.h"
 
 #include <phosphor/phosphor.h>
 
+#include <algorithm>
+
 class DurabilityTimeoutTask::ConfigChangeListener
     : public ValueChangedListener {
 public:
@@ -53,15 +56,26 @@ DurabilityTimeoutTask::DurabilityTimeoutTask(EventuallyPersistentEngine& engine,
 bool DurabilityTimeoutTask::run() {
     TRACE_EVENT0("ep-engine/task", "DurabilityTimeoutTask");
 
-    // @todo: A meaningful value will be the P99.99
-    const auto maxExpectedDurationForVisitorTask =
-            std::chrono::milliseconds(100);
+    // SyncWrite::isExpired() is strict (expiry < asOf), so only take the
+    // deadlines strictly before now.
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<Vbid> expired;
+    deadlines.lock()->advance(now - std::chrono::nanoseconds(1),
+                              [&expired](SyncWriteId&& id) {
+                                  expired.push_back(id.vbid);
+                              });
+    std::sort(expired.begin(), expired.end());
+    expired.erase(std::unique(expired.begin(), expired.end()), expired.end());
 
+    // Note: the deadlines lock must not be held here, the ActiveDM cancels
+    // the deadlines of the SyncWrites it aborts.
     auto& kvBucket = *engine->getKVBucket();
-    kvBucket.visitAsync(std::make_unique<DurabilityTimeoutVisitor>(),
-                        "DurabilityTimeoutVisitor",
-                        TaskId::DurabilityTimeoutVisitor,
-                        maxExpectedDurationForVisitorTask);
+    for (const auto vbid : expired) {
+        auto vb = kvBucket.getVBucket(vbid);
+        if (vb) {
+            vb->processDurabilityTimeout(now);
+        }
+    }
 
     // Note: Default unit for std::duration is seconds, so the following gives
     // the seconds-representation (as double) of the given millis (sleepTime)
@@ -73,6 +87,18 @@ bool DurabilityTimeoutTask::run() {
     return !engine->getEpStats().isShutdown;
 }
 
-void DurabilityTimeoutVisitor::visitBucket(const VBucketPtr& vb) {
-    vb->processDurabilityTimeout(startTime);
+void DurabilityTimeoutTask::setSyncWriteTimeout(
+        Vbid vbid,
+        int64_t seqno,
+        std::optional<std::chrono::steady_clock::time_point> deadline) {
+    auto locked = deadlines.lock();
+    if (deadline) {
+        locked->schedule({vbid, seqno}, *deadline);
+    } else {
+        locked->cancel({vbid, seqno});
+    }
+}
+
+size_t DurabilityTimeoutTask::getNumPendingTimeouts() const {
+    return deadlines.lock()->size();
 }
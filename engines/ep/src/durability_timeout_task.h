@@ -17,11 +17,23 @@
 #pragma once
 
 #include "globaltask.h"
-#include "vb_visitors.h"
+#include "timer_wheel.h"
+
+#include <folly/Synchronized.h>
+#include <memcached/vbucket.h>
 #include <platform/atomic_duration.h>
 
+#include <mutex>
+#include <optional>
+
 /*
  * Enforces the Durability Timeout for the SyncWrites tracked in this KVBucket.
+ *
+ * Each ActiveDurabilityMonitor registers the deadline of every SyncWrite it
+ * tracks (and cancels it once the SyncWrite completes) via
+ * setSyncWriteTimeout(). The task keeps the deadlines in a timer wheel and on
+ * each run only visits the vBuckets which have a SyncWrite timed out, rather
+ * than polling every vBucket.
  */
 class DurabilityTimeoutTask : public GlobalTask {
 public:
@@ -29,6 +41,8 @@ public:
 
     /**
      * @param engine The engine that will be visited
+     * @param interval The interval between runs - i.e. the granularity of
+     *        the timeouts.
      */
     DurabilityTimeoutTask(EventuallyPersistentEngine& engine,
                           std::chrono::milliseconds interval);
@@ -40,37 +54,54 @@ public:
     }
 
     std::chrono::microseconds maxExpectedDuration() override {
-        // This tasks just spawns a new VBCBAdaptor, which is the actual tasks
-        // that executes the DurabilityTimeoutVisitor. So, keeping the value
-        // relatively high as there is no too much value in logging this timing.
-        return std::chrono::seconds(1);
+        // Only does work for vBuckets with expired SyncWrites, aborting those
+        // is what takes the time.
+        return std::chrono::milliseconds(100);
     }
 
     void setSleepTime(std::chrono::milliseconds value) {
         sleepTime = value;
     }
 
+    /**
+     * Set the time at which the given SyncWrite times out, replacing any
+     * previous deadline for it; or if deadline is empty, cancel its timeout.
+     *
+     * @param vbid vBucket of the SyncWrite
+     * @param seqno Prepare seqno of the SyncWrite
+     * @param deadline Time the SyncWrite times out (or none)
+     */
+    void setSyncWriteTimeout(
+            Vbid vbid,
+            int64_t seqno,
+            std::optional<std::chrono::steady_clock::time_point> deadline);
+
+    /// @returns the number of SyncWrites with a pending timeout.
+    size_t getNumPendingTimeouts() const;
+
 private:
+    struct SyncWriteId {
+        bool operator==(const SyncWriteId& other) const {
+            return vbid == other.vbid && seqno == other.seqno;
+        }
+
+        Vbid vbid;
+        int64_t seqno;
+    };
+
+    struct SyncWriteIdHash {
+        size_t operator()(const SyncWriteId& id) const {
+            return std::hash<int64_t>()(id.seqno) ^
+                   (std::hash<Vbid>()(id.vbid) << 1);
+        }
+    };
+
     // Note: this is the actual minimum interval between subsequent runs.
-    // The VBCBAdaptor (which is the actual task that executes this Visitor)
-    // has its internal sleep-time which is used for a different purpose,
-    // details in VBCBAdaptor.
     cb::AtomicDuration<std::chrono::milliseconds,
                        std::memory_order::memory_order_seq_cst>
             sleepTime;
-};
-
-/**
- * DurabilityTimeoutVisitor visits a VBucket for enforcing the Durability
- * Timeout for the SyncWrites tracked by VBucket.
- */
-class DurabilityTimeoutVisitor : public CappedDurationVBucketVisitor {
-public:
-    DurabilityTimeoutVisitor() : startTime(std::chrono::steady_clock::now()) {
-    }
 
-    void visitBucket(const VBucketPtr& vb) override;
-
-private:
-    const std::chrono::steady_clock::time_point startTime;
+    // Deadlines of the tracked SyncWrites.
+    folly::Synchronized<TimerWheel<SyncWriteId, SyncWriteIdHash>, std::mutex>
+            deadlines;
 };
@@ -178,7 +178,9 @@ bool BloomFilterCallback::initTempFilter(Vbid vbucketId) {
         estimated_count = initial_estimation;
     }
 
-    vb->initTempFilter(estimated_count, config.getBfilterFpProb());
+    vb->initTempFilter(estimated_count,
+                       config.getBfilterFpProb(),
+                       BloomFilter::typeFromString(config.getBfilterType()));
 
     return true;
 }
@@ -224,6 +226,8 @@ public:
     void sizeValueChanged(const std::string& key, size_t value) override {
         if (key == "flusher_total_batch_limit") {
             bucket.setFlusherBatchSplitTrigger(value);
+        } else if (key == "flusher_group_commit_vbuckets") {
+            bucket.setFlusherGroupCommitVBuckets(value);
         } else if (key == "alog_sleep_time") {
             bucket.setAccessScannerSleeptime(value, false);
         } else if (key == "alog_task_time") {
@@ -270,6 +274,11 @@ EPBucket::EPBucket(EventuallyPersistentEngine& theEngine)
             "flusher_total_batch_limit",
             std::make_unique<ValueChangedListener>(*this));
 
+    setFlusherGroupCommitVBuckets(config.getFlusherGroupCommitVbuckets());
+    config.addValueChangedListener(
+            "flusher_group_commit_vbuckets",
+            std::make_unique<ValueChangedListener>(*this));
+
     retainErroneousTombstones = config.isRetainErroneousTombstones();
     config.addValueChangedListener(
             "retain_erroneous_tombstones",
@@ -341,7 +350,69 @@ static bool canDeDuplicate(Item* lastFlushed, Item& candidate) {
     return true;
 }
 
+struct EPBucket::PendingFlush {
+    LockedVBucketPtr vb;
+    UniqueFlushHandle flushHandle;
+    std::unique_ptr<VB::Commit> commitData;
+    snapshot_range_t range;
+    VBucket::AggregatedFlushStats aggStats;
+    std::chrono::steady_clock::time_point flushStart;
+    size_t flushBatchSize;
+    MoreAvailable moreAvailable;
+    WakeCkptRemover wakeupCkptRemover;
+};
+
 EPBucket::FlushResult EPBucket::flushVBucket(Vbid vbid) {
+    return flushVBucket(vbid, nullptr);
+}
+
+std::vector<EPBucket::FlushResult> EPBucket::flushVBuckets(
+        const std::vector<Vbid>& vbids) {
+    Expects(!vbids.empty());
+    auto* rwUnderlying = getRWUnderlying(vbids.front());
+
+    std::vector<FlushResult> results;
+    results.reserve(vbids.size());
+
+    std::vector<PendingFlush> deferred;
+    const bool groupCommit =
+            vbids.size() > 1 && rwUnderlying->setDeferredSync(true);
+    for (const auto vbid : vbids) {
+        Expects(getRWUnderlying(vbid) == rwUnderlying);
+        results.push_back(flushVBucket(vbid, groupCommit ? &deferred : nullptr));
+    }
+
+    if (!groupCommit) {
+        return results;
+    }
+
+    // Sync all the commits; this also invokes their persistence callbacks.
+    const auto syncFailed = rwUnderlying->syncDeferredCommits();
+    rwUnderlying->setDeferredSync(false);
+
+    for (auto& flush : deferred) {
+        const auto vbid = flush.vb->getId();
+        const auto idx = std::distance(
+                vbids.begin(), std::find(vbids.begin(), vbids.end(), vbid));
+        if (std::find(syncFailed.begin(), syncFailed.end(), vbid) !=
+            syncFailed.end()) {
+            ++stats.commitFailed;
+            EP_LOG_WARN("EPBucket::flushVBuckets: sync failed {}", vbid);
+            // As for a failed commit, the flusher will re-attempt the whole
+            // flush-batch. The cached vbstate and file stats are only updated
+            // once synced, so still describe what is durable on disk.
+            flush.flushHandle->markFlushFailed();
+            results[idx] = {MoreAvailable::Yes, 0, WakeCkptRemover::No};
+        } else {
+            results[idx] = completeFlush(flush);
+        }
+    }
+
+    return results;
+}
+
+EPBucket::FlushResult EPBucket::flushVBucket(
+        Vbid vbid, std::vector<PendingFlush>* deferred) {
     const auto flushStart = std::chrono::steady_clock::now();
 
     auto vb = getLockedVBucket(vbid, std::try_to_lock);
@@ -413,7 +484,11 @@ EPBucket::FlushResult EPBucket::flushVBucket(Vbid vbid) {
         vbstate = *persistedVbState;
     }
 
-    VB::Commit commitData(vb->getManifest(), vbstate);
+    // Heap allocated as it must outlive this function if completion of the
+    // flush is deferred.
+    auto commitDataPtr =
+            std::make_unique<VB::Commit>(vb->getManifest(), vbstate);
+    auto& commitData = *commitDataPtr;
     vbucket_state& proposedVBState = commitData.proposedVBState;
 
     // We need to set a few values from the in-memory state.
@@ -690,8 +765,8 @@ EPBucket::FlushResult EPBucket::flushVBucket(Vbid vbid) {
         //   2) persisted the new vbstate
         // The function returns false if the operation fails. But, (1) may
         // succeed and (2) may fail, which makes function to return false.
-        // In that case we do not rollback the cached vbstate, which exposes
-        // a wrong on-disk state at that point.
+        // In that case CouchKVStore restores the previous cached vbstate (the
+        // other KVStores don't, which exposes a wrong on-disk state).
         // Also, when we re-attempt to flush a set-vbstate item we may fail
         // again because of the optimization at
         // vbucket_state::needsToBePersisted().
@@ -753,11 +828,37 @@ EPBucket::FlushResult EPBucket::flushVBucket(Vbid vbid) {
     // Note: We want to update the snap-range only if we have flushed at least
     // one item. I.e. don't appear to be in a snap when you have no data for it
     Expects(range.has_value());
-    vb->setPersistedSnapshot(*range);
+    PendingFlush flush{std::move(vb),
+                       std::move(toFlush.flushHandle),
+                       std::move(commitDataPtr),
+                       *range,
+                       aggStats,
+                       flushStart,
+                       flushBatchSize,
+                       moreAvailable,
+                       wakeupCheckpointRemover};
+    if (deferred) {
+        // Completed once synced, see flushVBuckets().
+        deferred->push_back(std::move(flush));
+        return {moreAvailable, flushBatchSize, wakeupCheckpointRemover};
+    }
+
+    return completeFlush(flush);
+}
+
+EPBucket::FlushResult EPBucket::completeFlush(PendingFlush& flush) {
+    auto& vb = *flush.vb;
+    const auto vbid = vb.getId();
+    KVStore* rwUnderlying = getRWUnderlying(vbid);
+
+    // Update in-memory vbstate
+    rwUnderlying->setVBucketState(vbid, flush.commitData->proposedVBState);
+
+    vb.setPersistedSnapshot(flush.range);
 
     uint64_t highSeqno = rwUnderlying->getLastPersistedSeqno(vbid);
-    if (highSeqno > 0 && highSeqno != vb->getPersistenceSeqno()) {
-        vb->setPersistenceSeqno(highSeqno);
+    if (highSeqno > 0 && highSeqno != vb.getPersistenceSeqno()) {
+        vb.setPersistenceSeqno(highSeqno);
     }
 
     // Notify the local DM that the Flusher has run. Persistence
@@ -792,19 +893,21 @@ EPBucket::FlushResult EPBucket::flushVBucket(Vbid vbid) {
     //     So, given that here we are executing in a slow bg-thread
     //     (write+sync to disk), then we can just afford to calling
     //     back to the DM unconditionally.
-    vb->notifyPersistenceToDurabilityMonitor();
+    vb.notifyPersistenceToDurabilityMonitor();
 
-    flushSuccessEpilogue(*vb,
-                         flushStart,
-                         flushBatchSize /*itemsFlushed*/,
-                         aggStats,
-                         commitData.collections);
+    flushSuccessEpilogue(vb,
+                         flush.flushStart,
+                         flush.flushBatchSize /*itemsFlushed*/,
+                         flush.aggStats,
+                         flush.commitData->collections);
 
     // Handle Seqno Persistence requests
-    vb->notifyHighPriorityRequests(
-            engine, vb->getPersistenceSeqno(), HighPriorityVBNotify::Seqno);
+    vb.notifyHighPriorityRequests(
+            engine, vb.getPersistenceSeqno(), HighPriorityVBNotify::Seqno);
 
-    return {moreAvailable, flushBatchSize, wakeupCheckpointRemover};
+    return {flush.moreAvailable,
+            flush.flushBatchSize,
+            flush.wakeupCkptRemover};
 }
 
 void EPBucket::handleCheckpointPersistence(VBucket& vb) const {
@@ -873,8 +976,6 @@ bool EPBucket::commit(Vbid vbid, KVStore& kvstore, VB::Commit& commitData) {
     const auto res = kvstore.commit(commitData);
     if (res) {
         ++stats.flusherCommits;
-        // Update in-memory vbstate
-        kvstore.setVBucketState(vbid, commitData.proposedVBState);
     } else {
         ++stats.commitFailed;
         EP_LOG_WARN("KVBucket::commit: kvstore.commit failed {}", vbid);
@@ -72,6 +72,17 @@ public:
      */
     FlushResult flushVBucket(Vbid vbid);
 
+    /**
+     * Flushes all items waiting for persistence in the given vbuckets, with
+     * a single (group) sync of their commits where the KVStore supports it.
+     * The persistence of each vbucket's flush-batch is only notified once all
+     * of them are synced.
+     *
+     * @param vbids The ids of the vbuckets to flush, all of the same shard
+     * @return an instance of FlushResult for each vbucket, in order
+     */
+    std::vector<FlushResult> flushVBuckets(const std::vector<Vbid>& vbids);
+
     /**
      * Set the number of flusher items which can be included in a
      * single flusher commit. For more details see flusherBatchSplitTrigger
@@ -81,6 +92,15 @@ public:
 
     size_t getFlusherBatchSplitTrigger();
 
+    void setFlusherGroupCommitVBuckets(size_t value) {
+        flusherGroupCommitVBuckets = value;
+    }
+
+    /// @return the max number of vbuckets flushed with a single group commit
+    size_t getFlusherGroupCommitVBuckets() const {
+        return flusherGroupCommitVBuckets;
+    }
+
     /**
      * Persist whatever flush-batch previously queued into KVStore.
      *
@@ -286,6 +306,31 @@ protected:
      */
     void handleCheckpointPersistence(VBucket& vb) const;
 
+    /// A committed flush-batch awaiting completion, see completeFlush().
+    struct PendingFlush;
+
+    /**
+     * Flushes all items waiting for persistence in a given vbucket.
+     *
+     * @param vbid The id of the vbucket to flush
+     * @param deferred If non-null, the KVStore is deferring the sync of
+     *        commits: a successfully committed flush-batch is appended here
+     *        (still holding the vbucket lock) instead of being completed,
+     *        and the returned FlushResult is provisional.
+     * @return an instance of FlushResult
+     */
+    FlushResult flushVBucket(Vbid vbid, std::vector<PendingFlush>* deferred);
+
+    /**
+     * Performs the operations that must follow the persistence of a
+     * flush-batch: updates the persisted vbstate / snapshot / seqno, notifies
+     * the DurabilityMonitor and any SeqnoPersistence request.
+     *
+     * @param flush the flush-batch, committed and synced
+     * @return the FlushResult of the flush
+     */
+    FlushResult completeFlush(PendingFlush& flush);
+
     /**
      * Performs operations that must be performed after flush succeeds,
      * regardless of whether we flush non-meta items or a new vbstate only.
@@ -321,6 +366,12 @@ protected:
      */
     std::atomic<size_t> flusherBatchSplitTrigger;
 
+    /**
+     * Max number of vbuckets a flusher commits before syncing them together,
+     * see flusher_group_commit_vbuckets.
+     */
+    std::atomic<size_t> flusherGroupCommitVBuckets{1};
+
     /**
      * Indicates whether erroneous tombstones need to retained or not during
      * compaction
@@ -46,6 +46,7 @@
 #include "kvstore.h"
 #include "replicationthrottle.h"
 #include "server_document_iface_border_guard.h"
+#include "statistics/buffered_collector.h"
 #include "statistics/collector.h"
 #include "stats-info.h"
 #include "string_utils.h"
@@ -80,10 +81,12 @@
 
 #include <chrono>
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -610,12 +613,16 @@ cb::mcbp::Status EventuallyPersistentEngine::setFlushParam(
             getConfiguration().setExpPagerStime(std::stoull(val));
         } else if (key == "exp_pager_initial_run_time") {
             getConfiguration().setExpPagerInitialRunTime(std::stoll(val));
+        } else if (key == "flusher_group_commit_vbuckets") {
+            getConfiguration().setFlusherGroupCommitVbuckets(std::stoull(val));
         } else if (key == "flusher_total_batch_limit") {
             getConfiguration().setFlusherTotalBatchLimit(std::stoll(val));
         } else if (key == "getl_default_timeout") {
             getConfiguration().setGetlDefaultTimeout(std::stoull(val));
         } else if (key == "getl_max_timeout") {
             getConfiguration().setGetlMaxTimeout(std::stoull(val));
+        } else if (key == "ht_resize_algo") {
+            getConfiguration().setHtResizeAlgo(val);
         } else if (key == "ht_resize_interval") {
             getConfiguration().setHtResizeInterval(std::stoull(val));
         } else if (key == "max_item_privileged_bytes") {
@@ -639,6 +646,8 @@ cb::mcbp::Status EventuallyPersistentEngine::setFlushParam(
             getConfiguration().setBfilterFpProb(std::stof(val));
         } else if (key == "bfilter_key_count") {
             getConfiguration().setBfilterKeyCount(std::stoull(val));
+        } else if (key == "bfilter_type") {
+            getConfiguration().setBfilterType(val);
         } else if (key == "pager_active_vb_pcnt") {
             getConfiguration().setPagerActiveVbPcnt(std::stoull(val));
         } else if (key == "pager_sleep_time_ms") {
@@ -2815,6 +2824,8 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doEngineStats(
     collector.addStat(Key::ep_bg_meta_fetched, epstats.bg_meta_fetched);
     collector.addStat(Key::ep_bg_remaining_items, epstats.numRemainingBgItems);
     collector.addStat(Key::ep_bg_remaining_jobs, epstats.numRemainingBgJobs);
+    collector.addStat(Key::ep_bg_fetches_in_flight,
+                      epstats.numBgFetchesInFlight);
     collector.addStat(Key::ep_num_pager_runs, epstats.pagerRuns);
     collector.addStat(Key::ep_num_expiry_pager_runs, epstats.expiryPagerRuns);
     collector.addStat(Key::ep_num_freq_decayer_runs, epstats.freqDecayerRuns);
@@ -3282,6 +3293,18 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doVBucketStats(
                                        *vb,
                                        kvBucket.get(),
                                        VBucketStatsDetailLevel::Durability);
+    } else if (detail == VBucketStatsDetailLevel::Full) {
+        return doStreamedStats(
+                cookie,
+                add_stat,
+                "vbucket-details stats for all vbuckets",
+                [this](const AddStatFn& addStat, const void* c) {
+                    return std::make_unique<StatVBucketVisitor>(
+                            kvBucket.get(),
+                            c,
+                            addStat,
+                            VBucketStatsDetailLevel::Full);
+                });
     } else {
         StatVBucketVisitor svbv(kvBucket.get(), cookie, add_stat, detail);
         kvBucket->visit(svbv);
@@ -3374,10 +3397,16 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doHashStats(
         BucketCompressionMode compressionMode;
     };
 
-    StatVBucketVisitor svbv(cookie, add_stat, getCompressionMode());
-    kvBucket->visit(svbv);
-
-    return ENGINE_SUCCESS;
+    // Visiting the depth of every HashTable is expensive; compute it on an
+    // executor thread.
+    return doStreamedStats(
+            cookie,
+            add_stat,
+            "hash stats for all vbuckets",
+            [this](const AddStatFn& addStat, const void* c) {
+                return std::make_unique<StatVBucketVisitor>(
+                        c, addStat, getCompressionMode());
+            });
 }
 
 /**
@@ -3503,40 +3532,197 @@ public:
 };
 
 
-class StatCheckpointTask : public GlobalTask {
+/**
+ * A group of stats which is computed by a StatStreamTask and sent to the
+ * client by the front-end thread serving the CMD_STAT request, in chunks as
+ * they become available.
+ *
+ * The front-end returns EWOULDBLOCK whenever it has sent everything produced
+ * so far but the task has not yet finished; the task notifies the cookie when
+ * it next produces a chunk (or finishes).
+ */
+class StatStream {
+public:
+    StatStream(EventuallyPersistentEngine& engine, const void* cookie)
+        : engine(engine), cookie(cookie) {
+    }
+
+    /// Called by the task with each chunk of stats.
+    void push(BufferedStatCollector::Chunk&& chunk) {
+        std::lock_guard<std::mutex> lh(mutex);
+        if (cancelled) {
+            return;
+        }
+        chunks.push_back(std::move(chunk));
+        notifyIfWaiting();
+    }
+
+    /// Called by the task once all stats have been pushed.
+    void complete() {
+        std::lock_guard<std::mutex> lh(mutex);
+        done = true;
+        notifyIfWaiting();
+    }
+
+    /// Called if the connection goes away; the cookie is no longer notified.
+    void cancel() {
+        std::lock_guard<std::mutex> lh(mutex);
+        cancelled = true;
+        chunks.clear();
+    }
+
+    bool isCancelled() const {
+        std::lock_guard<std::mutex> lh(mutex);
+        return cancelled;
+    }
+
+    /**
+     * Called by the front-end thread; sends all of the chunks available.
+     *
+     * @returns ENGINE_SUCCESS if all stats have been sent, else
+     *          ENGINE_EWOULDBLOCK (and the cookie will be notified when there
+     *          are more).
+     */
+    ENGINE_ERROR_CODE send(const AddStatFn& add_stat) {
+        std::deque<BufferedStatCollector::Chunk> ready;
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lh(mutex);
+            ready.swap(chunks);
+            finished = done;
+            waiting = !finished;
+        }
+        // Copy to the connection outside of the lock, so the task can carry
+        // on producing the next chunk.
+        for (const auto& chunk : ready) {
+            BufferedStatCollector::replay(chunk, add_stat, cookie);
+        }
+        return finished ? ENGINE_SUCCESS : ENGINE_EWOULDBLOCK;
+    }
+
+private:
+    void notifyIfWaiting() {
+        if (waiting) {
+            waiting = false;
+            engine.notifyIOComplete(cookie, ENGINE_SUCCESS);
+        }
+    }
+
+    EventuallyPersistentEngine& engine;
+    const void* const cookie;
+    mutable std::mutex mutex;
+    std::deque<BufferedStatCollector::Chunk> chunks;
+    // The front-end has returned EWOULDBLOCK and needs notifying.
+    bool waiting = false;
+    bool done = false;
+    bool cancelled = false;
+};
+
+/**
+ * Passes each vBucket on to a stat group's visitor until the stream is
+ * cancelled, so a connection which goes away part way through a large bucket
+ * doesn't keep the task visiting the rest of it.
+ */
+class StatStreamVisitor : public VBucketVisitor {
+public:
+    StatStreamVisitor(const StatStream& stream, VBucketVisitor& visitor)
+        : VBucketVisitor(visitor.getVBucketFilter()),
+          stream(stream),
+          visitor(visitor) {
+    }
+
+    void visitBucket(const VBucketPtr& vb) override {
+        if (!stream.isCancelled()) {
+            visitor.visitBucket(vb);
+        }
+    }
+
+private:
+    const StatStream& stream;
+    VBucketVisitor& visitor;
+};
+
+class StatStreamTask : public GlobalTask {
 public:
-    StatCheckpointTask(EventuallyPersistentEngine* e,
-                       const void* c,
-                       AddStatFn a)
-        : GlobalTask(e, TaskId::StatCheckpointTask, 0, false),
-          ep(e),
-          cookie(c),
-          add_stat(std::move(a)) {
+    StatStreamTask(EventuallyPersistentEngine* e,
+                   std::shared_ptr<StatStream> stream,
+                   std::string description,
+                   EventuallyPersistentEngine::StatVisitorFn makeVisitor)
+        : GlobalTask(e, TaskId::StatStreamTask, 0, false),
+          stream(std::move(stream)),
+          description(std::move(description)),
+          makeVisitor(std::move(makeVisitor)) {
     }
+
     bool run() override {
-        TRACE_EVENT0("ep-engine/task", "StatsCheckpointTask");
-        StatCheckpointVisitor scv(ep->getKVBucket(), cookie, add_stat);
-        ep->getKVBucket()->visit(scv);
-        ep->notifyIOComplete(cookie, ENGINE_SUCCESS);
+        TRACE_EVENT0("ep-engine/task", "StatStreamTask");
+        if (!stream->isCancelled()) {
+            BufferedStatCollector collector(
+                    [this](BufferedStatCollector::Chunk&& chunk) {
+                        stream->push(std::move(chunk));
+                    });
+            // The stat groups are still written in terms of AddStatFn; the
+            // cookie is only passed back to it (and must not be the
+            // connection's, which belongs to the front-end thread).
+            auto visitor = makeVisitor(
+                    [&collector](std::string_view key,
+                                 std::string_view value,
+                                 gsl::not_null<const void*>) {
+                        collector.append(key, value);
+                    },
+                    this);
+            StatStreamVisitor streamVisitor(*stream, *visitor);
+            engine->getKVBucket()->visit(streamVisitor);
+            collector.flush();
+        }
+        stream->complete();
         return false;
     }
 
     std::string getDescription() override {
-        return "checkpoint stats for all vbuckets";
+        return description;
     }
 
     std::chrono::microseconds maxExpectedDuration() override {
-        // Task needed to lookup "checkpoint" stats; so the runtime should only
+        // Task needed to lookup slow stat groups; so the runtime should only
         // affects the particular stat request. However we don't want this to
         // take /too/ long, so set limit of 100ms.
         return std::chrono::milliseconds(100);
     }
 
 private:
-    EventuallyPersistentEngine *ep;
-    const void *cookie;
-    AddStatFn add_stat;
+    const std::shared_ptr<StatStream> stream;
+    const std::string description;
+    const EventuallyPersistentEngine::StatVisitorFn makeVisitor;
 };
+
+ENGINE_ERROR_CODE EventuallyPersistentEngine::doStreamedStats(
+        const void* cookie,
+        const AddStatFn& add_stat,
+        std::string description,
+        StatVisitorFn makeVisitor) {
+    std::shared_ptr<StatStream> stream;
+    {
+        std::lock_guard<std::mutex> lh(statStreamsMutex);
+        auto& entry = statStreams[cookie];
+        if (!entry) {
+            entry = std::make_shared<StatStream>(*this, cookie);
+            ExecutorPool::get()->schedule(std::make_shared<StatStreamTask>(
+                    this,
+                    entry,
+                    std::move(description),
+                    std::move(makeVisitor)));
+        }
+        stream = entry;
+    }
+
+    const auto status = stream->send(add_stat);
+    if (status != ENGINE_EWOULDBLOCK) {
+        std::lock_guard<std::mutex> lh(statStreamsMutex);
+        statStreams.erase(cookie);
+    }
+    return status;
+}
 /// @endcond
 
 ENGINE_ERROR_CODE EventuallyPersistentEngine::doCheckpointStats(
@@ -3545,16 +3731,14 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doCheckpointStats(
         const char* stat_key,
         int nkey) {
     if (nkey == 10) {
-        void* es = getEngineSpecific(cookie);
-        if (es == nullptr) {
-            ExTask task = std::make_shared<StatCheckpointTask>(
-                    this, cookie, add_stat);
-            ExecutorPool::get()->schedule(task);
-            storeEngineSpecific(cookie, this);
-            return ENGINE_EWOULDBLOCK;
-        } else {
-            storeEngineSpecific(cookie, nullptr);
-        }
+        return doStreamedStats(
+                cookie,
+                add_stat,
+                "checkpoint stats for all vbuckets",
+                [this](const AddStatFn& addStat, const void* c) {
+                    return std::make_unique<StatCheckpointVisitor>(
+                            kvBucket.get(), c, addStat);
+                });
     } else if (nkey > 11) {
         std::string vbid(&stat_key[11], nkey - 11);
         uint16_t vbucket_id(0);
@@ -3995,6 +4179,7 @@ void EventuallyPersistentEngine::doTimingStats(StatCollector& collector) {
     // Misc
     collector.addStat(Key::notify_io, stats.notifyIOHisto);
     collector.addStat(Key::batch_read, stats.getMultiHisto);
+    collector.addStat(Key::bg_fetches_in_flight, stats.bgFetchInFlightHisto);
 
     // Disk stats
     collector.addStat(Key::disk_insert, stats.diskInsertHisto);
@@ -6193,6 +6378,15 @@ ConnHandler* EventuallyPersistentEngine::getConnHandler(const void* cookie,
 
 void EventuallyPersistentEngine::handleDisconnect(const void *cookie) {
     dcpConnMap_->disconnect(cookie);
+    {
+        // The connection went away part way through a streamed stat group.
+        std::lock_guard<std::mutex> lh(statStreamsMutex);
+        auto it = statStreams.find(cookie);
+        if (it != statStreams.end()) {
+            it->second->cancel();
+            statStreams.erase(it);
+        }
+    }
     /**
      * Decrement session_cas's counter, if the connection closes
      * before a control command (that returned ENGINE_EWOULDBLOCK
@@ -30,6 +30,7 @@
 #include <platform/cb_arena_malloc_client.h>
 
 #include <chrono>
+#include <functional>
 #include <string>
 #include <unordered_map>
 
@@ -47,8 +48,10 @@ class DcpFlowControlManager;
 class ItemMetaData;
 class KVBucket;
 class StatCollector;
+class StatStream;
 class StoredValue;
 class VBucketCountVisitor;
+class VBucketVisitor;
 
 // Forward decl
 class EventuallyPersistentEngine;
@@ -534,6 +537,11 @@ public:
 
     void notifyIOComplete(const void* cookie, ENGINE_ERROR_CODE status);
 
+    /// Creates the visitor which computes a group of stats over the vBuckets,
+    /// passing each one to the given AddStatFn.
+    using StatVisitorFn = std::function<std::unique_ptr<VBucketVisitor>(
+            const AddStatFn&, const void*)>;
+
     ENGINE_ERROR_CODE reserveCookie(const void *cookie);
     ENGINE_ERROR_CODE releaseCookie(const void *cookie);
 
@@ -923,6 +931,18 @@ protected:
     ENGINE_ERROR_CODE doHashDump(const void* cookie,
                                  const AddStatFn& addStat,
                                  std::string_view keyArgs);
+    /**
+     * Serve a group of stats which is too expensive to compute on a front-end
+     * thread. On the first call the visitor made by `makeVisitor` is
+     * scheduled to visit the vBuckets on an executor thread, buffering the
+     * stats in chunks (and stopping early if the connection goes away); each
+     * call sends the chunks produced so far, returning ENGINE_EWOULDBLOCK
+     * until all have been sent.
+     */
+    ENGINE_ERROR_CODE doStreamedStats(const void* cookie,
+                                      const AddStatFn& add_stat,
+                                      std::string description,
+                                      StatVisitorFn makeVisitor);
     ENGINE_ERROR_CODE doCheckpointStats(const void* cookie,
                                         const AddStatFn& add_stat,
                                         const char* stat_key,
@@ -1227,6 +1247,9 @@ protected:
     std::map<const void*, std::unique_ptr<Item>> lookups;
     std::unordered_map<const void*, ENGINE_ERROR_CODE> allKeysLookups;
     std::mutex lookupMutex;
+    // Stat groups being streamed to a connection (see doStreamedStats).
+    std::unordered_map<const void*, std::shared_ptr<StatStream>> statStreams;
+    std::mutex statStreamsMutex;
     GET_SERVER_API getServerApiFunc;
 
     std::unique_ptr<DcpFlowControlManager> dcpFlowControlManager_;
@@ -29,6 +29,7 @@
 #include "failover-table.h"
 #include "item.h"
 #include "linked_list.h"
+#include "skip_list.h"
 #include "stored_value_factories.h"
 #include "vbucket_bgfetch_item.h"
 #include "vbucket_queue_item_ctx.h"
@@ -80,7 +81,15 @@ EphemeralVBucket::EphemeralVBucket(
               0, // Every item in ephemeral has a HLC cas
               mightContainXattrs,
               replicationTopology),
-      seqList(std::make_unique<BasicLinkedList>(i, st)) {
+      seqList(makeSequenceList(i, st, config)) {
+}
+
+std::unique_ptr<SequenceList> EphemeralVBucket::makeSequenceList(
+        Vbid vbid, EPStats& st, Configuration& config) {
+    if (config.getEphemeralSeqlistType() == "skip_list") {
+        return std::make_unique<SkipList>(vbid, st);
+    }
+    return std::make_unique<BasicLinkedList>(vbid, st);
 }
 
 size_t EphemeralVBucket::getNumItems() const {
@@ -272,6 +272,10 @@ protected:
     std::unique_ptr<SequenceList> seqList;
 
 private:
+    /// Create the SequenceList selected by ephemeral_seqlist_type.
+    static std::unique_ptr<SequenceList> makeSequenceList(
+            Vbid vbid, EPStats& st, Configuration& config);
+
     std::tuple<StoredValue*, MutationStatus, VBNotifyCtx> updateStoredValue(
             const HashTable::HashBucketLock& hbl,
             StoredValue& v,
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "eviction_pool.h"
+
+#include "hash_table.h"
+#include "stored-value.h"
+#include "vbucket.h"
+
+#include <algorithm>
+
+/**
+ * Offers the StoredValues visited which could be evicted to an EvictionPool.
+ */
+class EvictionPoolSampler : public HashTableVisitor {
+public:
+    EvictionPoolSampler(VBucket& vb, EvictionPool& pool) : vb(vb), pool(pool) {
+    }
+
+    bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override {
+        // As the PagingVisitor, never touch prepares. Temporary and deleted
+        // items are left for the expiry pager to clean up.
+        if (v.isPending() || v.isCompleted() || v.isTempItem() ||
+            v.isDeleted()) {
+            return true;
+        }
+        if (vb.eligibleToPageOut(lh, v)) {
+            pool.offer(v);
+        }
+        return true;
+    }
+
+private:
+    VBucket& vb;
+    EvictionPool& pool;
+};
+
+void EvictionPool::refill(VBucket& vb, size_t numBuckets) {
+    EvictionPoolSampler sampler(vb, *this);
+    vb.ht.visitRandomBuckets(sampler, numBuckets);
+}
+
+void EvictionPool::offer(const StoredValue& v) {
+    const DocKey key = v.getKey();
+    // Sampling may find an item already in the pool; keep only the latest.
+    auto existing = std::find_if(
+            candidates.begin(), candidates.end(), [&key](const Candidate& c) {
+                return c.key == key;
+            });
+    if (existing != candidates.end()) {
+        candidates.erase(existing);
+    } else if (candidates.size() == MaxSize &&
+               !isBetter(v.getFreqCounterValue(),
+                         v.getCas(),
+                         candidates.front())) {
+        // Don't copy the key of an item which wouldn't be kept.
+        return;
+    }
+
+    Candidate candidate{StoredDocKey(key), v.getCas(), v.getFreqCounterValue()};
+    auto pos = std::lower_bound(
+            candidates.begin(),
+            candidates.end(),
+            candidate,
+            [](const Candidate& a, const Candidate& b) {
+                return isBetter(b, a);
+            });
+    candidates.insert(pos, std::move(candidate));
+    if (candidates.size() > MaxSize) {
+        candidates.erase(candidates.begin());
+    }
+}
+
+std::optional<EvictionPool::Candidate> EvictionPool::pop() {
+    if (candidates.empty()) {
+        return {};
+    }
+    auto best = std::move(candidates.back());
+    candidates.pop_back();
+    return best;
+}
+
+bool EvictionPool::isBetter(const Candidate& a, const Candidate& b) {
+    return isBetter(a.freqCounter, a.cas, b);
+}
+
+bool EvictionPool::isBetter(uint8_t freqCounter,
+                            uint64_t cas,
+                            const Candidate& b) {
+    if (freqCounter != b.freqCounter) {
+        return freqCounter < b.freqCounter;
+    }
+    // The top 48 bits of the (HLC) CAS are the time of the last modification,
+    // so a lower CAS is a less recently modified item.
+    return cas < b.cas;
+}
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "storeddockey.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class StoredValue;
+class VBucket;
+
+/**
+ * A small pool of the best candidates for eviction seen so far in a vBucket,
+ * used by the sampled_lru eviction policy.
+ *
+ * Instead of visiting every item in the HashTable to build a frequency
+ * histogram (as ItemEviction does for hifi_mfu), the pool is refilled by
+ * looking at the StoredValues in a few randomly chosen hash buckets and
+ * keeping the coldest of them - the ones with the lowest frequency counter,
+ * and of those the least recently modified (lowest CAS). Each eviction then
+ * takes the best candidate from the pool. Candidates which were not evicted
+ * stay in the pool, so over successive refills it converges on the coldest
+ * items in the HashTable.
+ *
+ * Candidates are identified by key (and CAS), not by StoredValue pointer, as
+ * the StoredValue may be deleted or reallocated while in the pool; the
+ * evictor must look the key up again and check it hasn't been modified since
+ * it was sampled.
+ *
+ * Not thread-safe; VBucket guards its pool with a mutex.
+ */
+class EvictionPool {
+public:
+    struct Candidate {
+        StoredDocKey key;
+        uint64_t cas;
+        uint8_t freqCounter;
+    };
+
+    /// Maximum number of candidates kept in the pool.
+    static constexpr size_t MaxSize = 16;
+
+    /// Number of hash buckets sampled by each refill.
+    static constexpr size_t BucketsPerRefill = 5;
+
+    /**
+     * Sample the StoredValues in numBuckets randomly chosen hash buckets of
+     * the vBucket's HashTable, offering those eligible for eviction to the
+     * pool.
+     */
+    void refill(VBucket& vb, size_t numBuckets = BucketsPerRefill);
+
+    /**
+     * Consider the given StoredValue as an eviction candidate; it is added if
+     * the pool isn't full or it is a better candidate than the worst one in
+     * the pool (which is then dropped). The caller must hold the
+     * StoredValue's hash bucket lock.
+     */
+    void offer(const StoredValue& v);
+
+    /// Remove and return the best candidate, or nothing if the pool is empty.
+    std::optional<Candidate> pop();
+
+    size_t size() const {
+        return candidates.size();
+    }
+
+    bool empty() const {
+        return candidates.empty();
+    }
+
+    void clear() {
+        candidates.clear();
+    }
+
+private:
+    /// @return true if a is a better candidate for eviction than b.
+    static bool isBetter(const Candidate& a, const Candidate& b);
+
+    /// @return true if an item with the given frequency counter and CAS is a
+    ///         better candidate for eviction than b.
+    static bool isBetter(uint8_t freqCounter, uint64_t cas, const Candidate& b);
+
+    /// The candidates, worst first (so the best is popped from the back).
+    std::vector<Candidate> candidates;
+};
@@ -297,21 +297,33 @@ bool Flusher::flushVB() {
         doHighPriority = false;
     }
 
+    // Flush up to flusher_group_commit_vbuckets vBuckets, syncing them
+    // together.
+    const auto groupSize = store->getFlusherGroupCommitVBuckets();
+    std::vector<Vbid> vbids;
     Vbid vbid;
-    if (!lpVbs.popFront(vbid)) {
+    while (vbids.size() < groupSize && lpVbs.popFront(vbid)) {
+        vbids.push_back(vbid);
+    }
+    if (vbids.empty()) {
         // Return no more so we don't rewake the task
         return false;
     }
 
-    const auto res = store->flushVBucket(vbid);
+    const auto results = store->flushVBuckets(vbids);
 
-    if (res.moreAvailable == EPBucket::MoreAvailable::Yes) {
-        // More items still available, add vbid back to pending set.
-        lpVbs.pushUnique(vbid);
+    bool wakeupCkptRemover = false;
+    for (size_t i = 0; i < vbids.size(); ++i) {
+        if (results[i].moreAvailable == EPBucket::MoreAvailable::Yes) {
+            // More items still available, add vbid back to pending set.
+            lpVbs.pushUnique(vbids[i]);
+        }
+        wakeupCkptRemover |= results[i].wakeupCkptRemover ==
+                             EPBucket::WakeCkptRemover::Yes;
     }
 
     // Flushing may move the persistence cursor to a new checkpoint.
-    if (res.wakeupCkptRemover == EPBucket::WakeCkptRemover::Yes) {
+    if (wakeupCkptRemover) {
         store->wakeUpCheckpointRemover();
     }
 
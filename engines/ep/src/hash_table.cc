@@ -22,6 +22,7 @@
 #include "stats.h"
 #include "stored_value_factories.h"
 
+#include <folly/Random.h>
 #include <folly/lang/Assume.h>
 #include <phosphor/phosphor.h>
 #include <platform/compress.h>
@@ -148,6 +149,7 @@ HashTable::HashTable(EPStats& st,
       numEjects(0),
       numResizes(0),
       maxDeletedRevSeqno(0),
+      lockMigrated(locks),
       probabilisticCounter(freqCounterIncFactor) {
     values.resize(size);
     activeState = true;
@@ -186,15 +188,29 @@ void HashTable::clear_UNLOCKED(bool deactivate) {
     }
     size_t clearedMemSize = 0;
     size_t clearedValSize = 0;
-    for (int i = 0; i < (int)size; i++) {
-        while (values[i]) {
-            // Take ownership of the StoredValue from the vector, update
-            // statistics and release it.
-            auto v = std::move(values[i]);
-            clearedMemSize += v->size();
-            clearedValSize += v->valuelen();
-            values[i] = std::move(v->getNext());
+    for (auto* table : {&values, &oldValues}) {
+        for (auto& chain : *table) {
+            while (chain) {
+                // Take ownership of the StoredValue from the vector, update
+                // statistics and release it.
+                auto v = std::move(chain);
+                clearedMemSize += v->size();
+                clearedValSize += v->valuelen();
+                chain = std::move(v->getNext());
+            }
+        }
+    }
+
+    // Any incremental resize in progress has nothing left to migrate.
+    if (isResizing()) {
+        // When deactivating, the owner has already accounted for our
+        // memorySize() (including the old table) as being released.
+        if (!deactivate) {
+            stats.coreLocal.get()->memOverhead.fetch_sub(oldSize *
+                                                         sizeof(StoredValue*));
         }
+        oldValues = table_type();
+        oldSize.store(0);
     }
 
     stats.coreLocal.get()->currentSize.fetch_sub(clearedMemSize -
@@ -216,10 +232,13 @@ static bool isCurrently(size_t size, ssize_t a, ssize_t b) {
     return (current == a || current == b);
 }
 
-void HashTable::resize() {
+static size_t roundUp(size_t n, size_t granularity) {
+    return ((n + granularity - 1) / granularity) * granularity;
+}
+
+size_t HashTable::calculateResizeTarget(size_t granularity) const {
     size_t ni = getNumInMemoryItems();
     int i(0);
-    size_t new_size(0);
 
     // Figure out where in the prime table we are.
     auto target(static_cast<ssize_t>(ni));
@@ -229,22 +248,27 @@ void HashTable::resize() {
 
     if (prime_size_table[i] == -1) {
         // We're at the end, take the biggest
-        new_size = prime_size_table[i-1];
+        return roundUp(prime_size_table[i - 1], granularity);
     } else if (prime_size_table[i] < static_cast<ssize_t>(initialSize)) {
         // Was going to be smaller than the initial size.
-        new_size = initialSize;
+        return roundUp(initialSize, granularity);
     } else if (0 == i) {
-        new_size = prime_size_table[i];
-    }else if (isCurrently(size, prime_size_table[i-1], prime_size_table[i])) {
+        return roundUp(prime_size_table[i], granularity);
+    }
+
+    const auto lower = roundUp(prime_size_table[i - 1], granularity);
+    const auto upper = roundUp(prime_size_table[i], granularity);
+    if (isCurrently(size, lower, upper)) {
         // If one of the candidate sizes is the current size, maintain
         // the current size in order to remain stable.
-        new_size = size;
-    } else {
-        // Somewhere in the middle, use the one we're closer to.
-        new_size = nearest(ni, prime_size_table[i-1], prime_size_table[i]);
+        return size;
     }
+    // Somewhere in the middle, use the one we're closer to.
+    return nearest(ni, lower, upper);
+}
 
-    resize(new_size);
+void HashTable::resize() {
+    resize(calculateResizeTarget(1));
 }
 
 void HashTable::resize(size_t newSize) {
@@ -282,12 +306,22 @@ void HashTable::resize(size_t newSize) {
     stats.coreLocal.get()->memOverhead.fetch_sub(memorySize());
     ++numResizes;
 
+    // If an incremental resize is in progress, finish migrating the old
+    // table first so every StoredValue is in `values`.
+    if (isResizing()) {
+        for (size_t i = 0; i < oldSize; i++) {
+            unlocked_migrateOldBucket(i);
+        }
+        oldValues = table_type();
+        oldSize.store(0);
+    }
+
     // Set the new size so all the hashy stuff works.
-    size_t oldSize = size;
+    size_t currSize = size;
     size.store(newSize);
 
     // Move existing records into the new space.
-    for (size_t i = 0; i < oldSize; i++) {
+    for (size_t i = 0; i < currSize; i++) {
         while (values[i]) {
             // unlink the front element from the hash chain at values[i].
             auto v = std::move(values[i]);
@@ -306,6 +340,137 @@ void HashTable::resize(size_t newSize) {
     stats.coreLocal.get()->memOverhead.fetch_add(memorySize());
 }
 
+bool HashTable::beginIncrementalResize() {
+    return beginIncrementalResize(calculateResizeTarget(mutexes.size()));
+}
+
+bool HashTable::beginIncrementalResize(size_t newSize) {
+    if (!isActive()) {
+        throw std::logic_error(
+                "HashTable::beginIncrementalResize: Cannot call on a "
+                "non-active object");
+    }
+
+    // A key must map to the same mutex in both the old and the new table,
+    // which holds as long as both sizes are multiples of the lock count.
+    newSize = roundUp(newSize, mutexes.size());
+
+    // Due to the way hashing works, we can't fit anything larger than
+    // an int.
+    if (newSize > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(resizeMutex);
+    if (newSize == size || isResizing()) {
+        return false;
+    }
+
+    if (size % mutexes.size() != 0) {
+        // Current table cannot be migrated incrementally; fall back to a
+        // one-off blocking resize. Subsequent resizes can then be incremental.
+        resize(newSize);
+        return false;
+    }
+
+    TRACE_EVENT2("HashTable",
+                 "beginIncrementalResize",
+                 "size",
+                 size.load(),
+                 "newSize",
+                 newSize);
+
+    // Allocate the new table before acquiring the locks; for big tables
+    // initialising it is the most expensive part of starting the resize.
+    table_type newValues(newSize);
+
+    MultiLockHolder mlh(mutexes);
+    if (visitors.load() > 0) {
+        // As per resize(), do not change size while visitors are running.
+        return false;
+    }
+
+    stats.coreLocal.get()->memOverhead.fetch_sub(memorySize());
+    ++numResizes;
+
+    oldValues = std::move(values);
+    oldSize.store(size);
+    values = std::move(newValues);
+    size.store(newSize);
+    resizeCursor = 0;
+    std::fill(lockMigrated.begin(), lockMigrated.end(), 0);
+
+    stats.coreLocal.get()->memOverhead.fetch_add(memorySize());
+    return true;
+}
+
+bool HashTable::continueIncrementalResize(size_t maxBuckets) {
+    std::lock_guard<std::mutex> guard(resizeMutex);
+    for (size_t migrated = 0; migrated < maxBuckets; ++migrated) {
+        const auto oldBucket = resizeCursor;
+        std::lock_guard<std::mutex> lh(mutexes[oldBucket % mutexes.size()]);
+        if (!isResizing()) {
+            // Completed by another path (clear / blocking resize).
+            return false;
+        }
+        if (oldBucket >= oldSize) {
+            break;
+        }
+        unlocked_migrateOldBucket(oldBucket);
+        ++resizeCursor;
+    }
+
+    if (resizeCursor < oldSize) {
+        return true;
+    }
+    completeIncrementalResize();
+    return false;
+}
+
+void HashTable::unlocked_migrateOldBucket(size_t oldBucket) {
+    auto& chain = oldValues[oldBucket];
+    while (chain) {
+        // unlink the front element from the old hash chain...
+        auto v = std::move(chain);
+        chain = std::move(v->getNext());
+
+        // ... and re-link it into the correct place in values.
+        int newBucket = getBucketForHash(v->getKey().hash());
+        v->setNext(std::move(values[newBucket]));
+        values[newBucket] = std::move(v);
+    }
+}
+
+void HashTable::migrateOldBucketsForLock(size_t lock) {
+    for (size_t oldBucket = lock;; oldBucket += mutexes.size()) {
+        LockHolder lh(mutexes[lock]);
+        if (!isResizing() || lockMigrated[lock]) {
+            return;
+        }
+        if (oldBucket >= oldSize) {
+            lockMigrated[lock] = 1;
+            return;
+        }
+        unlocked_migrateOldBucket(oldBucket);
+    }
+}
+
+void HashTable::completeIncrementalResize() {
+    table_type retired;
+    {
+        MultiLockHolder mlh(mutexes);
+        if (!isResizing()) {
+            return;
+        }
+        stats.coreLocal.get()->memOverhead.fetch_sub(memorySize());
+        retired = std::move(oldValues);
+        oldValues = table_type();
+        oldSize.store(0);
+        stats.coreLocal.get()->memOverhead.fetch_add(memorySize());
+    }
+    // `retired` only holds empty chains; free it without holding any locks.
+}
+
 HashTable::FindInnerResult HashTable::findInner(const DocKey& key) {
     if (!isActive()) {
         throw std::logic_error(
@@ -1091,13 +1256,15 @@ void HashTable::dump() const {
 nlohmann::json HashTable::dumpStoredValuesAsJson() const {
     MultiLockHolder mlh(mutexes);
     auto obj = nlohmann::json::array();
-    for (const auto& chain : values) {
-        if (chain) {
-            for (StoredValue* sv = chain.get().get(); sv != nullptr;
-                 sv = sv->getNext().get().get()) {
-                std::stringstream ss;
-                ss << sv->getKey();
-                obj.push_back(*sv);
+    for (const auto* table : {&values, &oldValues}) {
+        for (const auto& chain : *table) {
+            if (chain) {
+                for (StoredValue* sv = chain.get().get(); sv != nullptr;
+                     sv = sv->getNext().get().get()) {
+                    std::stringstream ss;
+                    ss << sv->getKey();
+                    obj.push_back(*sv);
+                }
             }
         }
     }
@@ -1133,6 +1300,7 @@ void HashTable::visitDepth(HashTableDepthVisitor &visitor) {
     lh.unlock();
 
     for (int l = 0; l < static_cast<int>(mutexes.size()); l++) {
+        migrateOldBucketsForLock(l);
         for (int i = l; i < static_cast<int>(size); i+= mutexes.size()) {
             // (re)acquire mutex on each HashBucket, to minimise any impact
             // on front-end threads.
@@ -1195,6 +1363,10 @@ HashTable::Position HashTable::pauseResumeVisit(HashTableVisitor& visitor,
 
     for (; isActive() && !paused && lock < mutexes.size(); lock++) {
 
+        // Ensure no StoredValues guarded by this lock are still waiting in
+        // the old table of an incremental resize.
+        migrateOldBucketsForLock(lock);
+
         // If the bucket position is *this* lock, then start from the
         // recorded bucket (as long as we haven't resized).
         hash_bucket = lock;
@@ -1243,6 +1415,42 @@ HashTable::Position HashTable::pauseResumeVisit(HashTableVisitor& visitor,
     return HashTable::Position(size, lock, hash_bucket);
 }
 
+void HashTable::visitRandomBuckets(HashTableVisitor& visitor,
+                                   size_t numBuckets) {
+    if ((valueStats.getNumItems() + valueStats.getNumTempItems()) == 0 ||
+        !isActive()) {
+        return;
+    }
+
+    // Prevent the Resizer changing {size} under us - see pauseResumeVisit().
+    std::unique_lock<std::mutex> lh(mutexes[0]);
+    VisitorTracker vt(&visitors);
+    lh.unlock();
+
+    bool paused = false;
+    for (size_t ii = 0; isActive() && !paused && ii < numBuckets; ++ii) {
+        const int bucket = folly::Random::rand32(size);
+        visitor.setUpHashBucketVisit();
+        {
+            auto hbl = getLockedBucket(bucket);
+            for (StoredValue* v = values[bucket].get().get(); !paused && v;
+                 v = v->getNext().get().get()) {
+                paused = !visitor.visit(hbl, *v);
+            }
+            if (isResizing()) {
+                // As getRandomKeyFromSlot(); the old bucket is guarded by
+                // the lock we already hold.
+                for (StoredValue* v = oldValues[bucket % oldSize].get().get();
+                     !paused && v;
+                     v = v->getNext().get().get()) {
+                    paused = !visitor.visit(hbl, *v);
+                }
+            }
+        }
+        visitor.tearDownHashBucketVisit();
+    }
+}
+
 HashTable::Position HashTable::endPosition() const  {
     return HashTable::Position(size, mutexes.size(), size);
 }
@@ -1293,14 +1501,28 @@ bool HashTable::unlocked_ejectItem(const HashTable::HashBucketLock&,
 std::unique_ptr<Item> HashTable::getRandomKeyFromSlot(CollectionID cid,
                                                       int slot) {
     auto lh = getLockedBucket(slot);
+    auto isCandidate = [cid](const StoredValue* v) {
+        return !v->isTempItem() && !v->isDeleted() && v->isResident() &&
+               v->isCommitted() && v->getKey().getCollectionID() == cid;
+    };
     for (StoredValue* v = values[slot].get().get(); v;
             v = v->getNext().get().get()) {
-        if (!v->isTempItem() && !v->isDeleted() && v->isResident() &&
-            v->isCommitted() && v->getKey().getCollectionID() == cid) {
+        if (isCandidate(v)) {
             return v->toItem(Vbid(0));
         }
     }
 
+    if (isResizing()) {
+        // Both table sizes are multiples of the lock count, so this old
+        // bucket is guarded by the lock we already hold.
+        for (StoredValue* v = oldValues[slot % oldSize].get().get(); v;
+             v = v->getNext().get().get()) {
+            if (isCandidate(v)) {
+                return v->toItem(Vbid(0));
+            }
+        }
+    }
+
     return nullptr;
 }
 
@@ -1372,11 +1594,13 @@ std::ostream& operator<<(std::ostream& os, const HashTable& ht) {
        << " numSystemItems:" << ht.getNumSystemItems()
        << " numPreparedSW:" << ht.getNumPreparedSyncWrites()
        << " values: " << std::endl;
-    for (const auto& chain : ht.values) {
-        if (chain) {
-            for (StoredValue* sv = chain.get().get(); sv != nullptr;
-                 sv = sv->getNext().get().get()) {
-                os << "    " << *sv << std::endl;
+    for (const auto* table : {&ht.values, &ht.oldValues}) {
+        for (const auto& chain : *table) {
+            if (chain) {
+                for (StoredValue* sv = chain.get().get(); sv != nullptr;
+                     sv = sv->getNext().get().get()) {
+                    os << "    " << *sv << std::endl;
+                }
             }
         }
     }
@@ -145,6 +145,15 @@ enum class DeletionDurability : uint8_t {};
  * re-hashing all elements into the new table. While resizing is occuring all
  * other access to the HashTable is blocked.
  *
+ * Alternatively the HashTable can be resized incrementally. The old and new
+ * bucket vectors then live side by side, and chains are migrated from the old
+ * vector into the new one a few buckets at a time, each under its own ht_lock
+ * (see beginIncrementalResize() / continueIncrementalResize()). Any access
+ * which locks the bucket for a key first migrates that key's old chain, so
+ * callers only ever observe StoredValues in the new vector. This requires that
+ * a key maps to the same ht_lock in both vectors, hence incremental resizing
+ * only uses table sizes which are a multiple of the number of ht_locks.
+ *
  * Support for holding both Committed and Pending items requires that we
  * can represent having for each key, either:
  *  1. No item present
@@ -389,7 +398,7 @@ public:
 
     size_t memorySize() {
         return sizeof(HashTable)
-            + (size * sizeof(StoredValue*))
+            + ((size + oldSize) * sizeof(StoredValue*))
             + (mutexes.size() * sizeof(std::mutex));
     }
 
@@ -540,6 +549,45 @@ public:
      */
     void resize(size_t to);
 
+    /**
+     * Start an incremental resize to fit the current data. Sizes are
+     * rounded up to a multiple of the number of locks.
+     *
+     * @return true if an incremental resize was started.
+     */
+    bool beginIncrementalResize();
+
+    /**
+     * Start an incremental resize to (at least) the specified size. The
+     * new bucket vector is installed immediately, but existing chains are
+     * only moved into it by continueIncrementalResize() or when their keys
+     * are next accessed.
+     *
+     * If the current size is not a multiple of the number of locks then the
+     * tables cannot be migrated incrementally; a one-off blocking resize() is
+     * performed instead and false is returned.
+     *
+     * @return true if an incremental resize was started.
+     */
+    bool beginIncrementalResize(size_t to);
+
+    /**
+     * Migrate up to the given number of old hash buckets into the new table,
+     * acquiring (and releasing) the lock of each bucket individually. Once
+     * all buckets have been migrated the old table is freed.
+     *
+     * @param maxBuckets maximum number of old buckets to migrate.
+     * @return true if there is still migration work remaining.
+     */
+    bool continueIncrementalResize(size_t maxBuckets);
+
+    /**
+     * @return true if an incremental resize is in progress.
+     */
+    bool isResizing() const {
+        return oldSize != 0;
+    }
+
     /**
      * Result of the findForRead() method.
      */
@@ -1098,6 +1146,19 @@ public:
      */
     Position pauseResumeVisit(HashTableVisitor& visitor, Position& start_pos);
 
+    /**
+     * Visit the items in a number of randomly chosen hash buckets (for
+     * example to sample the HashTable). Buckets may be chosen more than once,
+     * and empty buckets count towards numBuckets.
+     *
+     * The visitor must not free the StoredValue being visited; the visit
+     * stops early if the visitor returns false.
+     *
+     * @param visitor The visitor object to use.
+     * @param numBuckets The number of hash buckets to visit.
+     */
+    void visitRandomBuckets(HashTableVisitor& visitor, size_t numBuckets);
+
     /**
      * Return a position at the end of the hashtable. Has similar semantics
      * as STL end() (i.e. one past the last element).
@@ -1277,6 +1338,11 @@ private:
             int bucket = getBucketForHash(h);
             HashBucketLock rv(bucket, mutexes[mutexForBucket(bucket)]);
             if (bucket == getBucketForHash(h)) {
+                if (isResizing()) {
+                    // The key may still live in the old table; move its
+                    // chain across so callers only need to look at values.
+                    unlocked_migrateOldBucket(getOldBucketForHash(h));
+                }
                 return rv;
             }
         }
@@ -1328,6 +1394,22 @@ private:
     // in `values`
     std::atomic<size_t> size;
     table_type values;
+
+    // While an incremental resize is in progress, the table being migrated
+    // from and its size (number of buckets). oldSize is zero when no resize
+    // is in progress. Both are only modified with all mutexes held; the
+    // chains in oldValues are guarded by the same mutex as the equivalent
+    // chains in values.
+    std::atomic<size_t> oldSize{0};
+    table_type oldValues;
+
+    // Serialises callers driving an incremental resize (begin / continue).
+    std::mutex resizeMutex;
+    // Next bucket of oldValues to migrate. Guarded by resizeMutex.
+    size_t resizeCursor{0};
+    // Per-lock flag recording that all old buckets of that lock have been
+    // migrated by a visitor. Each element is guarded by its mutex.
+    std::vector<uint8_t> lockMigrated;
     // Mutable so that we can make dumpStoredValuesAsJson const
     mutable std::vector<std::mutex> mutexes;
     EPStats&             stats;
@@ -1361,6 +1443,10 @@ private:
         return abs(h % static_cast<int>(size));
     }
 
+    int getOldBucketForHash(int h) {
+        return abs(h % static_cast<int>(oldSize));
+    }
+
     inline size_t mutexForBucket(size_t bucket_num) {
         if (!isActive()) {
             throw std::logic_error("HashTable::mutexForBucket: Cannot call on a "
@@ -1409,6 +1495,32 @@ private:
 
     void clear_UNLOCKED(bool deactivate);
 
+    /**
+     * Calculate the size the HashTable should be resized to for the current
+     * number of items.
+     *
+     * @param granularity The returned size is rounded up to a multiple of this.
+     */
+    size_t calculateResizeTarget(size_t granularity) const;
+
+    /**
+     * Move every StoredValue in the given bucket of oldValues into its bucket
+     * in values. The mutex for the bucket must be held.
+     */
+    void unlocked_migrateOldBucket(size_t oldBucket);
+
+    /**
+     * Migrate all old buckets guarded by the given lock; used by visitors
+     * so they only need to walk `values`. Each bucket is migrated under its
+     * own acquisition of the mutex.
+     */
+    void migrateOldBucketsForLock(size_t lock);
+
+    /**
+     * Free the old table once all of its buckets have been migrated.
+     */
+    void completeIncrementalResize();
+
     /**
      * Update the frequency counter of a given stored value.
      * @param v  reference to a value in the hash table whose frequency counter
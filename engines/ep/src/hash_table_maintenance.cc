@@ -0,0 +1,290 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "hash_table_maintenance.h"
+
+#include "bucket_logger.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// CompositeHTVisitor implementation //////////////////////////////////////////
+
+void CompositeHTVisitor::addVisitor(VBucketAwareHTVisitor& visitor) {
+    visitors.push_back(&visitor);
+}
+
+void CompositeHTVisitor::removeVisitor(VBucketAwareHTVisitor& visitor) {
+    visitors.erase(std::remove(visitors.begin(), visitors.end(), &visitor),
+                   visitors.end());
+}
+
+bool CompositeHTVisitor::visit(const HashTable::HashBucketLock& lh,
+                               StoredValue& v) {
+    // Every visitor sees the StoredValue (so we don't hand out a partially
+    // visited one when pausing), but stop as soon as any of them has used up
+    // its budget for this chunk.
+    bool keepGoing = true;
+    for (auto* visitor : visitors) {
+        keepGoing &= visitor->visit(lh, v);
+    }
+    return keepGoing;
+}
+
+void CompositeHTVisitor::setUpHashBucketVisit() {
+    for (auto* visitor : visitors) {
+        visitor->setUpHashBucketVisit();
+    }
+}
+
+void CompositeHTVisitor::tearDownHashBucketVisit() {
+    // Tear down in the reverse order of setting up, in case the visitors'
+    // setup (e.g. locks acquired) nests.
+    for (auto it = visitors.rbegin(); it != visitors.rend(); ++it) {
+        (*it)->tearDownHashBucketVisit();
+    }
+}
+
+void CompositeHTVisitor::setCurrentVBucket(VBucket& vb) {
+    for (auto* visitor : visitors) {
+        visitor->setCurrentVBucket(vb);
+    }
+}
+
+// HashTableMaintenance implementation ////////////////////////////////////////
+
+HashTableMaintenance::HashTableMaintenance(KVBucketIface& bucket)
+    : bucket(bucket), epstore_position(bucket.startPosition()) {
+}
+
+HashTableMaintenance::~HashTableMaintenance() = default;
+
+void HashTableMaintenance::addConcern(
+        std::shared_ptr<HashTableMaintenanceConcern> concern) {
+    std::lock_guard<std::mutex> lh(mutex);
+    // Forget any concerns which no longer exist (e.g. a task which has been
+    // re-created).
+    concerns.erase(std::remove_if(concerns.begin(),
+                                  concerns.end(),
+                                  [](const Entry& entry) {
+                                      return entry.concern.expired();
+                                  }),
+                   concerns.end());
+    concerns.push_back({concern, false});
+}
+
+bool HashTableMaintenance::isRegistered(
+        const HashTableMaintenanceConcern& concern) const {
+    std::lock_guard<std::mutex> lh(mutex);
+    return std::any_of(
+            concerns.begin(), concerns.end(), [&concern](const Entry& entry) {
+                return entry.concern.lock().get() == &concern;
+            });
+}
+
+HashTableMaintenance::Status HashTableMaintenance::run(
+        HashTableMaintenanceConcern& concern) {
+    {
+        std::lock_guard<std::mutex> lh(mutex);
+        auto* entry = findEntry(concern);
+        if (!entry) {
+            throw std::logic_error(
+                    "HashTableMaintenance::run: concern is not registered");
+        }
+
+        if (participants.empty()) {
+            startPass(*entry);
+        }
+        auto* participant = findParticipant(concern);
+        if (!participant) {
+            entry->waiting = true;
+            return Status::Waiting;
+        }
+        participant->due = true;
+
+        // Only run the chunk once every participant's task is due for it
+        // (and not while another task is running the previous one).
+        if (running || std::any_of(participants.begin(),
+                                   participants.end(),
+                                   [](const Participant& p) {
+                                       return !p.due && !p.leaving;
+                                   })) {
+            return Status::Pending;
+        }
+
+        // Prepare each participant for this chunk, dropping any which no
+        // longer want to take part.
+        auto& composite = getCompositeVisitor();
+        for (auto it = participants.begin(); it != participants.end();) {
+            it->due = false;
+            if (!it->leaving && it->concern->prepareChunk(*it->visitor)) {
+                ++it;
+                continue;
+            }
+            composite.removeVisitor(*it->visitor);
+            it = participants.erase(it);
+        }
+        if (participants.empty()) {
+            abandonPass();
+            return Status::Completed;
+        }
+        running = true;
+    }
+
+    // The participants cannot change while running is set, so we can run the
+    // chunk (which may take as long as the largest budget) without the mutex.
+    const bool completed = runChunk();
+
+    std::vector<Participant> finished;
+    std::vector<std::shared_ptr<HashTableMaintenanceConcern>> toWake;
+    size_t passes = 0;
+    {
+        std::lock_guard<std::mutex> lh(mutex);
+        running = false;
+        if (completed) {
+            finished = std::move(participants);
+            participants.clear();
+            prAdapter.reset();
+            passes = ++numPasses;
+            for (auto& entry : concerns) {
+                if (entry.waiting) {
+                    if (auto waiting = entry.concern.lock()) {
+                        toWake.push_back(std::move(waiting));
+                    }
+                }
+            }
+        }
+    }
+
+    if (completed) {
+        EP_LOG_DEBUG(
+                "HashTableMaintenance: pass {} finished for {} concern(s), "
+                "{} waiting",
+                passes,
+                finished.size(),
+                toWake.size());
+    }
+    for (auto& waiting : toWake) {
+        waiting->wakeForPass();
+    }
+
+    return completed ? Status::Completed : Status::Paused;
+}
+
+void HashTableMaintenance::leave(HashTableMaintenanceConcern& concern) {
+    std::lock_guard<std::mutex> lh(mutex);
+    if (auto* entry = findEntry(concern)) {
+        entry->waiting = false;
+    }
+    auto* participant = findParticipant(concern);
+    if (!participant) {
+        return;
+    }
+    if (running) {
+        // Can't change the participants mid-chunk; drop it from the next.
+        participant->leaving = true;
+        return;
+    }
+
+    getCompositeVisitor().removeVisitor(*participant->visitor);
+    participants.erase(std::find_if(participants.begin(),
+                                    participants.end(),
+                                    [participant](const Participant& p) {
+                                        return &p == participant;
+                                    }));
+    if (participants.empty()) {
+        abandonPass();
+    }
+}
+
+size_t HashTableMaintenance::getNumPasses() const {
+    std::lock_guard<std::mutex> lh(mutex);
+    return numPasses;
+}
+
+HashTableMaintenance::Entry* HashTableMaintenance::findEntry(
+        const HashTableMaintenanceConcern& concern) {
+    for (auto& entry : concerns) {
+        if (entry.concern.lock().get() == &concern) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+HashTableMaintenance::Participant* HashTableMaintenance::findParticipant(
+        const HashTableMaintenanceConcern& concern) {
+    for (auto& participant : participants) {
+        if (participant.concern.get() == &concern) {
+            return &participant;
+        }
+    }
+    return nullptr;
+}
+
+void HashTableMaintenance::abandonPass() {
+    participants.clear();
+    prAdapter.reset();
+    epstore_position = bucket.startPosition();
+}
+
+void HashTableMaintenance::startPass(Entry& caller) {
+    caller.waiting = true;
+    for (auto& entry : concerns) {
+        if (!entry.waiting) {
+            continue;
+        }
+        entry.waiting = false;
+        if (auto concern = entry.concern.lock()) {
+            auto visitor = concern->createVisitor();
+            participants.push_back({std::move(concern), std::move(visitor)});
+        }
+    }
+
+    // Visitors which may free the StoredValue they visit must be called
+    // after all the others.
+    std::stable_partition(participants.begin(),
+                          participants.end(),
+                          [](const Participant& participant) {
+                              return !participant.concern->mayFreeStoredValue();
+                          });
+
+    auto composite = std::make_unique<CompositeHTVisitor>();
+    for (auto& participant : participants) {
+        composite->addVisitor(*participant.visitor);
+    }
+    prAdapter = std::make_unique<PauseResumeVBAdapter>(std::move(composite));
+    epstore_position = bucket.startPosition();
+}
+
+bool HashTableMaintenance::runChunk() {
+    bool completed = true;
+    if (!participants.empty()) {
+        epstore_position =
+                bucket.pauseResumeVisit(*prAdapter, epstore_position);
+        completed = (epstore_position == bucket.endPosition());
+    }
+
+    for (auto& participant : participants) {
+        participant.concern->chunkComplete(*participant.visitor, completed);
+    }
+    return completed;
+}
+
+CompositeHTVisitor& HashTableMaintenance::getCompositeVisitor() {
+    return dynamic_cast<CompositeHTVisitor&>(prAdapter->getHTVisitor());
+}
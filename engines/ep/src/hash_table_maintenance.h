@@ -0,0 +1,240 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "kv_bucket_iface.h"
+#include "vb_visitors.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * A VBucketAwareHTVisitor which forwards each StoredValue to a number of
+ * child visitors, so they can all share a single walk of the HashTable.
+ *
+ * Every child is called for every StoredValue visited (in the order they were
+ * added); the visit pauses as soon as any child returns false from visit()
+ * (i.e. has exhausted its budget for the current chunk).
+ *
+ * A child which may free the StoredValue it is visiting (e.g. the
+ * DefragmentVisitor reallocating it) must be the last one.
+ */
+class CompositeHTVisitor : public VBucketAwareHTVisitor {
+public:
+    void addVisitor(VBucketAwareHTVisitor& visitor);
+
+    void removeVisitor(VBucketAwareHTVisitor& visitor);
+
+    bool empty() const {
+        return visitors.empty();
+    }
+
+    bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override;
+
+    void setUpHashBucketVisit() override;
+
+    void tearDownHashBucketVisit() override;
+
+    void setCurrentVBucket(VBucket& vb) override;
+
+private:
+    std::vector<VBucketAwareHTVisitor*> visitors;
+};
+
+/**
+ * Something which needs to periodically visit every StoredValue in the
+ * Bucket (defragmenting, compressing, decaying frequency counters, ...) and
+ * can share that walk with the other concerns via HashTableMaintenance.
+ *
+ * Implemented by the tasks which own each concern; they keep their own
+ * scheduling (interval / wakeups) and their own per-chunk budget.
+ */
+class HashTableMaintenanceConcern {
+public:
+    virtual ~HashTableMaintenanceConcern() = default;
+
+    /// Create the visitor this concern uses for a new pass.
+    virtual std::unique_ptr<VBucketAwareHTVisitor> createVisitor() = 0;
+
+    /**
+     * Prepare the visitor for the next chunk of the pass: set its deadline
+     * (from the concern's own chunk duration), any per-chunk settings, and
+     * clear its per-chunk statistics.
+     *
+     * @return false if the concern should leave the current pass (for
+     *         example because it has been disabled); the visitor is then
+     *         destroyed without any further calls.
+     */
+    virtual bool prepareChunk(VBucketAwareHTVisitor& visitor) = 0;
+
+    /**
+     * Called after each chunk of the pass the visitor was part of has run,
+     * to update statistics etc.
+     *
+     * @param completed true if the pass has finished; the visitor is
+     *        destroyed after this call.
+     */
+    virtual void chunkComplete(VBucketAwareHTVisitor& visitor,
+                               bool completed) = 0;
+
+    /**
+     * Called when the pass the concern was waiting for has finished. A
+     * concern whose task runs at its own interval joins the next pass when
+     * it next runs (the default); one which only runs on demand should wake
+     * its task.
+     */
+    virtual void wakeForPass() {
+    }
+
+    /**
+     * @return true if the concern's visitor may free the StoredValue being
+     *         visited; such a visitor is called after all the others. At
+     *         most one registered concern may return true.
+     */
+    virtual bool mayFreeStoredValue() const {
+        return false;
+    }
+};
+
+/**
+ * Runs a single pausable pass over all the vBuckets' HashTables on behalf of
+ * all the registered concerns which want one, instead of each concern
+ * walking every HashTable independently.
+ *
+ * A concern's task calls run() whenever it would have run a chunk of its own
+ * pass (i.e. when it is due, at its own interval):
+ *  - If no pass is in progress, a new one is started, joined by the caller
+ *    and by all the concerns which have been waiting for the previous pass
+ *    to finish.
+ *  - If the caller is part of the pass in progress it is marked as due for
+ *    its next chunk. Once every participant is due, the next chunk is run
+ *    (by the task which was due last); each participant's visitor is given
+ *    its own budget by prepareChunk(), and the chunk pauses once the first
+ *    one is exhausted.
+ *  - Otherwise the caller is marked as waiting; it joins the next pass
+ *    (and wakeForPass() is called when the current one finishes).
+ *
+ * A chunk therefore never runs a concern's visitor more often than that
+ * concern's own task is due; the pass advances at the pace of its slowest
+ * participant. A concern joining part way through a pass would miss the
+ * StoredValues already visited, hence waiting for the next one.
+ */
+class HashTableMaintenance {
+public:
+    enum class Status {
+        /// The caller is waiting for the pass in progress to finish.
+        Waiting,
+        /// The caller is due for the next chunk of its pass, which runs once
+        /// the other participants are due too (or is already running).
+        Pending,
+        /// The caller ran a chunk of its pass; the pass is not finished.
+        Paused,
+        /// The pass the caller was part of has finished.
+        Completed
+    };
+
+    explicit HashTableMaintenance(KVBucketIface& bucket);
+
+    ~HashTableMaintenance();
+
+    /// Register a concern; run() may only be called for registered concerns.
+    void addConcern(std::shared_ptr<HashTableMaintenanceConcern> concern);
+
+    /// @return true if the concern has been registered by addConcern().
+    bool isRegistered(const HashTableMaintenanceConcern& concern) const;
+
+    /**
+     * Run the next chunk of maintenance on behalf of the given concern.
+     *
+     * @throws std::logic_error if the concern is not registered.
+     */
+    Status run(HashTableMaintenanceConcern& concern);
+
+    /**
+     * Remove the given concern from the pass in progress (or from waiting
+     * for the next one), e.g. because it has been disabled. The remaining
+     * participants no longer wait for it to be due.
+     */
+    void leave(HashTableMaintenanceConcern& concern);
+
+    /// @return the number of passes which have been completed.
+    size_t getNumPasses() const;
+
+private:
+    struct Entry {
+        std::weak_ptr<HashTableMaintenanceConcern> concern;
+        /// Waiting for the pass in progress to finish
+        bool waiting = false;
+    };
+
+    struct Participant {
+        std::shared_ptr<HashTableMaintenanceConcern> concern;
+        std::unique_ptr<VBucketAwareHTVisitor> visitor;
+        /// The concern's task has asked for the next chunk to be run
+        bool due = false;
+        /// leave() was called while a chunk was running
+        bool leaving = false;
+    };
+
+    /// Find the registry entry for the concern; requires mutex held.
+    Entry* findEntry(const HashTableMaintenanceConcern& concern);
+
+    Participant* findParticipant(const HashTableMaintenanceConcern& concern);
+
+    /// Forget the pass in progress (without counting it); requires mutex
+    /// held and no chunk running.
+    void abandonPass();
+
+    /// Start a new pass for the caller and all waiting concerns; requires
+    /// mutex held.
+    void startPass(Entry& caller);
+
+    /**
+     * Run one chunk of the pass; called without mutex held (but with running
+     * set, so the participants cannot change).
+     *
+     * @return true if the pass has finished.
+     */
+    bool runChunk();
+
+    CompositeHTVisitor& getCompositeVisitor();
+
+    KVBucketIface& bucket;
+
+    mutable std::mutex mutex;
+
+    std::vector<Entry> concerns;
+
+    /// The concerns taking part in the pass in progress (empty if none).
+    std::vector<Participant> participants;
+
+    /// True while a chunk is being run (by any participant's task).
+    bool running = false;
+
+    /**
+     * Visitor adapter (wrapping a CompositeHTVisitor of the participants'
+     * visitors) which supports pausing & resuming. Re-created for each pass.
+     */
+    std::unique_ptr<PauseResumeVBAdapter> prAdapter;
+
+    // Opaque marker indicating how far through the epStore we have visited.
+    KVBucketIface::Position epstore_position;
+
+    size_t numPasses = 0;
+};
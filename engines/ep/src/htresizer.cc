@@ -30,11 +30,28 @@
  */
 class ResizingVisitor : public CappedDurationVBucketVisitor {
 public:
-    ResizingVisitor() { }
+    explicit ResizingVisitor(bool incremental) : incremental(incremental) {
+    }
 
     void visitBucket(const VBucketPtr& vb) override {
-        vb->ht.resize();
+        if (!incremental) {
+            vb->ht.resize();
+            return;
+        }
+
+        // Front-end threads only ever wait for the migration of a single
+        // bucket, so we can drive the resize to completion here.
+        if (vb->ht.isResizing() || vb->ht.beginIncrementalResize()) {
+            while (vb->ht.continueIncrementalResize(bucketsPerStep)) {
+            }
+        }
     }
+
+private:
+    /// Number of old hash buckets migrated per continueIncrementalResize().
+    static const size_t bucketsPerStep = 1024;
+
+    const bool incremental;
 };
 
 HashtableResizerTask::HashtableResizerTask(KVBucketIface& s, double sleepTime)
@@ -47,12 +64,13 @@ HashtableResizerTask::HashtableResizerTask(KVBucketIface& s, double sleepTime)
 
 bool HashtableResizerTask::run() {
     TRACE_EVENT0("ep-engine/task", "HashtableResizerTask");
-    auto pv = std::make_unique<ResizingVisitor>();
+    auto pv = std::make_unique<ResizingVisitor>(
+            engine->getConfiguration().getHtResizeAlgo() == "incremental");
 
-    // [per-VBucket Task] While a Hashtable is resizing no user
-    // requests can be performed (the resizing process needs to
-    // acquire all HT locks). As such we are sensitive to the duration
-    // of this task - we want to log anything which has a
+    // [per-VBucket Task] While a Hashtable is resizing with the blocking
+    // algorithm no user requests can be performed (the resizing process
+    // needs to acquire all HT locks). As such we are sensitive to the
+    // duration of this task - we want to log anything which has a
     // non-negligible impact on frontend operations.
     const auto maxExpectedDurationForVisitorTask =
             std::chrono::milliseconds(100);
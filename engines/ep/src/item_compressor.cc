@@ -34,6 +34,15 @@ ItemCompressorTask::ItemCompressorTask(EventuallyPersistentEngine* e,
 bool ItemCompressorTask::run() {
     TRACE_EVENT0("ep-engine/task", "ItemCompressorTask");
     if (engine->getCompressionMode() == BucketCompressionMode::Active) {
+        auto& maintenance = engine->getKVBucket()->getHashTableMaintenance();
+        if (maintenance.isRegistered(*this)) {
+            // Compress as part of the pass shared with the other HashTable
+            // maintenance tasks; see prepareChunk() / chunkComplete().
+            maintenance.run(*this);
+            snooze(getSleepTime());
+            return !engine->getEpStats().isShutdown;
+        }
+
         // Get our pause/resume visitor. If we didn't finish the previous pass,
         // then resume from where we last were, otherwise create a new visitor
         // starting from the beginning.
@@ -107,6 +116,12 @@ bool ItemCompressorTask::run() {
         if (completed) {
             prAdapter.reset();
         }
+    } else {
+        // Don't hold up the other tasks sharing a pass while disabled.
+        auto& maintenance = engine->getKVBucket()->getHashTableMaintenance();
+        if (maintenance.isRegistered(*this)) {
+            maintenance.leave(*this);
+        }
     }
 
     snooze(getSleepTime());
@@ -122,6 +137,30 @@ void ItemCompressorTask::stop() {
     }
 }
 
+std::unique_ptr<VBucketAwareHTVisitor> ItemCompressorTask::createVisitor() {
+    return std::make_unique<ItemCompressorVisitor>();
+}
+
+bool ItemCompressorTask::prepareChunk(VBucketAwareHTVisitor& htVisitor) {
+    if (engine->getCompressionMode() != BucketCompressionMode::Active) {
+        return false;
+    }
+
+    auto& visitor = dynamic_cast<ItemCompressorVisitor&>(htVisitor);
+    visitor.setDeadline(std::chrono::steady_clock::now() + getChunkDuration());
+    visitor.clearStats();
+    visitor.setCompressionMode(engine->getCompressionMode());
+    visitor.setMinCompressionRatio(engine->getMinCompressionRatio());
+    return true;
+}
+
+void ItemCompressorTask::chunkComplete(VBucketAwareHTVisitor& htVisitor,
+                                       bool completed) {
+    auto& visitor = dynamic_cast<ItemCompressorVisitor&>(htVisitor);
+    stats.compressorNumCompressed.fetch_add(visitor.getCompressedCount());
+    stats.compressorNumVisited.fetch_add(visitor.getVisitedCount());
+}
+
 std::string ItemCompressorTask::getDescription() {
     return "Item Compressor";
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "globaltask.h"
+#include "hash_table_maintenance.h"
 #include "kv_bucket_iface.h"
 
 class ItemCompressorVisitor;
@@ -25,8 +26,13 @@ class PauseResumeVBAdapter;
 
 /**
  * Task responsible for compressing items in memory.
+ *
+ * Walks the HashTables itself, unless registered with the Bucket's
+ * HashTableMaintenance in which case the walk is shared with the other
+ * HashTable maintenance tasks.
  */
-class ItemCompressorTask : public GlobalTask {
+class ItemCompressorTask : public GlobalTask,
+                           public HashTableMaintenanceConcern {
 public:
     ItemCompressorTask(EventuallyPersistentEngine* e, EPStats& stats_);
 
@@ -38,6 +44,11 @@ public:
 
     std::chrono::microseconds maxExpectedDuration() override;
 
+    // HashTableMaintenanceConcern
+    std::unique_ptr<VBucketAwareHTVisitor> createVisitor() override;
+    bool prepareChunk(VBucketAwareHTVisitor& visitor) override;
+    void chunkComplete(VBucketAwareHTVisitor& visitor, bool completed) override;
+
 private:
     /// Duration (in seconds) the compressor should sleep for between
     /// iterations.
@@ -46,6 +46,11 @@ bool ItemFreqDecayerTask::run() {
 
     ++(engine->getEpStats().freqDecayerRuns);
 
+    auto& maintenance = engine->getKVBucket()->getHashTableMaintenance();
+    if (maintenance.isRegistered(*this)) {
+        return runSharedPass(maintenance);
+    }
+
     // Get our pause/resume visitor. If we didn't finish the previous pass,
     // then resume from where we last were, otherwise create a new visitor
     // starting from the beginning.
@@ -119,6 +124,50 @@ bool ItemFreqDecayerTask::run() {
     return true;
 }
 
+bool ItemFreqDecayerTask::runSharedPass(HashTableMaintenance& maintenance) {
+    if (completed && !notified) {
+        // We were woken to continue a pass which has since been finished by
+        // another participant's task; nothing to do until notified again.
+        return !engine->getEpStats().isShutdown;
+    }
+
+    // Nothing more to do here whatever the status: if Waiting we are woken
+    // by wakeForPass() once the pass in progress has finished, and after
+    // each chunk of our pass chunkComplete() either wakes us for the next one
+    // or marks the pass completed.
+    completed = false;
+    maintenance.run(*this);
+
+    return !engine->getEpStats().isShutdown;
+}
+
+std::unique_ptr<VBucketAwareHTVisitor> ItemFreqDecayerTask::createVisitor() {
+    return std::make_unique<ItemFreqDecayerVisitor>(percentage);
+}
+
+bool ItemFreqDecayerTask::prepareChunk(VBucketAwareHTVisitor& htVisitor) {
+    auto& visitor = dynamic_cast<ItemFreqDecayerVisitor&>(htVisitor);
+    visitor.setDeadline(std::chrono::steady_clock::now() + getChunkDuration());
+    visitor.clearStats();
+    return true;
+}
+
+void ItemFreqDecayerTask::chunkComplete(VBucketAwareHTVisitor& htVisitor,
+                                        bool passCompleted) {
+    if (passCompleted) {
+        completed = true;
+        notified.store(false);
+    } else {
+        // We have not completed decaying all the items so wake the task back
+        // up (this may be called on another participant's thread).
+        ExecutorPool::get()->wake(getId());
+    }
+}
+
+void ItemFreqDecayerTask::wakeForPass() {
+    ExecutorPool::get()->wake(getId());
+}
+
 void ItemFreqDecayerTask::stop() {
     if (uid) {
         ExecutorPool::get()->cancel(uid);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "globaltask.h"
+#include "hash_table_maintenance.h"
 #include "kv_bucket_iface.h"
 
 class ItemFreqDecayerVisitor;
@@ -27,8 +28,13 @@ class PauseResumeVBAdapter;
  * The task is responsible for running a visitor that iterates over all
  * documents in a given hash table, decaying the frequency count of each
  * document by a given percentage.
+ *
+ * If registered with the Bucket's HashTableMaintenance, the documents are
+ * visited as part of the pass shared with the other HashTable maintenance
+ * tasks.
  */
-class ItemFreqDecayerTask : public GlobalTask {
+class ItemFreqDecayerTask : public GlobalTask,
+                            public HashTableMaintenanceConcern {
 public:
     ItemFreqDecayerTask(EventuallyPersistentEngine* e, uint16_t percentage_);
 
@@ -46,16 +52,27 @@ public:
     // Made virtual so can be overridden in mock version used in testing.
     virtual void wakeup();
 
+    // HashTableMaintenanceConcern
+    std::unique_ptr<VBucketAwareHTVisitor> createVisitor() override;
+    bool prepareChunk(VBucketAwareHTVisitor& visitor) override;
+    void chunkComplete(VBucketAwareHTVisitor& visitor, bool completed) override;
+    void wakeForPass() override;
+
 protected:
     // bool used to indicate whether the task's visitor has finished visiting
-    // all the documents in the given hash table.
-    bool completed;
+    // all the documents in the given hash table. Atomic as with a shared
+    // pass it may be set by another task's thread (via chunkComplete()).
+    std::atomic<bool> completed;
 
     // Upper limit on how long each ager chunk can run for, before
     // being paused.
     virtual std::chrono::milliseconds getChunkDuration() const;
 
 private:
+    // Run the next chunk of the pass shared with the other HashTable
+    // maintenance tasks.
+    bool runSharedPass(HashTableMaintenance& maintenance);
+
     // Returns the underlying AgeVisitor instance.
     ItemFreqDecayerVisitor& getItemFreqDecayerVisitor();
 
@@ -195,6 +195,9 @@ bool ItemPager::run() {
                 filter,
                 cfg.getItemEvictionAgePercentage(),
                 cfg.getItemEvictionFreqCounterAgeThreshold());
+        if (cfg.getHtEvictionPolicy() == "sampled_lru") {
+            pv->setEvictionPolicy(PagingVisitor::EvictionPolicy::sampled_lru);
+        }
 
         // p99.99 is ~200ms
         const auto maxExpectedDurationForVisitorTask =
@@ -49,6 +49,7 @@
 #include "ext_meta_parser.h"
 #include "failover-table.h"
 #include "flusher.h"
+#include "hash_table_maintenance.h"
 #include "htresizer.h"
 #include "item.h"
 #include "item_compressor.h"
@@ -293,6 +294,7 @@ KVBucket::KVBucket(EventuallyPersistentEngine& theEngine)
       defragmenterTask(nullptr),
       itemCompressorTask(nullptr),
       itemFreqDecayerTask(nullptr),
+      hashTableMaintenance(std::make_unique<HashTableMaintenance>(*this)),
       vb_mutexes(engine.getConfiguration().getMaxVbuckets()),
       backfillMemoryThreshold(0.95),
       statsSnapshotTaskId(0),
@@ -464,6 +466,7 @@ bool KVBucket::initialize() {
      * allocator which can facilitate defragmenting memory.
      */
     defragmenterTask = std::make_shared<DefragmenterTask>(&engine, stats);
+    addHashTableMaintenanceConcern(defragmenterTask);
     ExecutorPool::get()->schedule(defragmenterTask);
 #endif
 
@@ -478,6 +481,7 @@ bool KVBucket::initialize() {
      */
     itemFreqDecayerTask = std::make_shared<ItemFreqDecayerTask>(
             &engine, config.getItemFreqDecayerPercent());
+    addHashTableMaintenanceConcern(itemFreqDecayerTask);
     ExecutorPool::get()->schedule(itemFreqDecayerTask);
 
     return true;
@@ -996,13 +1000,16 @@ ENGINE_ERROR_CODE KVBucket::createVBucket_UNLOCKED(
 
     newvb->setFreqSaturatedCallback(
             [this] { this->wakeItemFreqDecayerTask(); });
+    newvb->setSyncWriteTimeoutCallback(makeSyncWriteTimeoutCB());
 
     Configuration& config = engine.getConfiguration();
     if (config.isBfilterEnabled()) {
         // Initialize bloom filters upon vbucket creation during
         // bucket creation and rebalance
-        newvb->createFilter(config.getBfilterKeyCount(),
-                            config.getBfilterFpProb());
+        newvb->createFilter(
+                config.getBfilterKeyCount(),
+                config.getBfilterFpProb(),
+                BloomFilter::typeFromString(config.getBfilterType()));
     }
 
     // The first checkpoint for active vbucket should start with id 2.
@@ -1651,55 +1658,127 @@ ENGINE_ERROR_CODE KVBucket::setWithMeta(Item& itm,
     }
 
     folly::SharedMutex::ReadHolder rlh(vb->getStateLock());
-    if (!permittedVBStates.test(vb->getState())) {
-        if (vb->getState() == vbucket_state_pending) {
-            if (vb->addPendingOp(cookie)) {
+    ENGINE_ERROR_CODE rv =
+            checkSetWithMetaVBState(*vb, cookie, permittedVBStates);
+    if (rv != ENGINE_SUCCESS) {
+        return rv;
+    }
+
+    rv = setWithMeta_UNLOCKED(*vb,
+                              itm,
+                              cas,
+                              seqno,
+                              cookie,
+                              checkConflicts,
+                              allowExisting,
+                              genBySeqno,
+                              genCas);
+    if (rv == ENGINE_SUCCESS) {
+        checkAndMaybeFreeMemory();
+    }
+    return rv;
+}
+
+std::vector<ENGINE_ERROR_CODE> KVBucket::setWithMetaBatch(
+        VBucket& vb,
+        const std::vector<Item*>& items,
+        const void* cookie,
+        PermittedVBStates permittedVBStates) {
+    std::vector<ENGINE_ERROR_CODE> results;
+    results.reserve(items.size());
+
+    folly::SharedMutex::ReadHolder rlh(vb.getStateLock());
+    const auto stateRv = checkSetWithMetaVBState(vb, cookie, permittedVBStates);
+    if (stateRv == ENGINE_TMPFAIL) {
+        // The batch stops at the first item; the caller retries all of them
+        results.push_back(stateRv);
+        return results;
+    } else if (stateRv != ENGINE_SUCCESS) {
+        results.resize(items.size(), stateRv);
+        return results;
+    }
+
+    bool stored = false;
+    for (auto* itm : items) {
+        const auto rv = setWithMeta_UNLOCKED(vb,
+                                             *itm,
+                                             0,
+                                             nullptr,
+                                             cookie,
+                                             CheckConflicts::No,
+                                             true,
+                                             GenerateBySeqno::No,
+                                             GenerateCas::No);
+        results.push_back(rv);
+        if (rv == ENGINE_SUCCESS) {
+            stored = true;
+        } else if (rv == ENGINE_TMPFAIL || rv == ENGINE_ENOMEM) {
+            break;
+        }
+    }
+
+    if (stored) {
+        checkAndMaybeFreeMemory();
+    }
+    return results;
+}
+
+ENGINE_ERROR_CODE KVBucket::checkSetWithMetaVBState(
+        VBucket& vb,
+        const void* cookie,
+        PermittedVBStates permittedVBStates) {
+    if (!permittedVBStates.test(vb.getState())) {
+        if (vb.getState() == vbucket_state_pending) {
+            if (vb.addPendingOp(cookie)) {
                 return ENGINE_EWOULDBLOCK;
             }
         } else {
             ++stats.numNotMyVBuckets;
             return ENGINE_NOT_MY_VBUCKET;
         }
-    } else if (vb->isTakeoverBackedUp()) {
+    } else if (vb.isTakeoverBackedUp()) {
         EP_LOG_DEBUG(
                 "({}) Returned TMPFAIL to a setWithMeta op"
                 ", becuase takeover is lagging",
-                vb->getId());
+                vb.getId());
         return ENGINE_TMPFAIL;
     }
+    return ENGINE_SUCCESS;
+}
 
+ENGINE_ERROR_CODE KVBucket::setWithMeta_UNLOCKED(VBucket& vb,
+                                                 Item& itm,
+                                                 uint64_t cas,
+                                                 uint64_t* seqno,
+                                                 const void* cookie,
+                                                 CheckConflicts checkConflicts,
+                                                 bool allowExisting,
+                                                 GenerateBySeqno genBySeqno,
+                                                 GenerateCas genCas) {
     //check for the incoming item's CAS validity
     if (!Item::isValidCas(itm.getCas())) {
         return ENGINE_KEY_EEXISTS;
     }
 
-    ENGINE_ERROR_CODE rv = ENGINE_SUCCESS;
-    { // hold collections read lock for duration of set
-
-        auto cHandle = vb->lockCollections(itm.getKey());
-        if (!cHandle.valid()) {
-            engine.setUnknownCollectionErrorContext(cookie,
-                                                    cHandle.getManifestUid());
-            rv = ENGINE_UNKNOWN_COLLECTION;
-        } else {
-            cHandle.processExpiryTime(itm, getMaxTtl());
-            rv = vb->setWithMeta(itm,
-                                 cas,
-                                 seqno,
-                                 cookie,
-                                 engine,
-                                 checkConflicts,
-                                 allowExisting,
-                                 genBySeqno,
-                                 genCas,
-                                 cHandle);
-        }
+    // hold collections read lock for duration of set
+    auto cHandle = vb.lockCollections(itm.getKey());
+    if (!cHandle.valid()) {
+        engine.setUnknownCollectionErrorContext(cookie,
+                                                cHandle.getManifestUid());
+        return ENGINE_UNKNOWN_COLLECTION;
     }
 
-    if (rv == ENGINE_SUCCESS) {
-        checkAndMaybeFreeMemory();
-    }
-    return rv;
+    cHandle.processExpiryTime(itm, getMaxTtl());
+    return vb.setWithMeta(itm,
+                          cas,
+                          seqno,
+                          cookie,
+                          engine,
+                          checkConflicts,
+                          allowExisting,
+                          genBySeqno,
+                          genCas,
+                          cHandle);
 }
 
 ENGINE_ERROR_CODE KVBucket::prepare(Item& itm, const void* cookie) {
@@ -2274,9 +2353,17 @@ void KVBucket::resetAccessScannerStartTime() {
 
 void KVBucket::enableItemCompressor() {
     itemCompressorTask = std::make_shared<ItemCompressorTask>(&engine, stats);
+    addHashTableMaintenanceConcern(itemCompressorTask);
     ExecutorPool::get()->schedule(itemCompressorTask);
 }
 
+void KVBucket::addHashTableMaintenanceConcern(const ExTask& task) {
+    if (engine.getConfiguration().isHtMaintenanceSharedPass()) {
+        hashTableMaintenance->addConcern(
+                std::dynamic_pointer_cast<HashTableMaintenanceConcern>(task));
+    }
+}
+
 void KVBucket::setAllBloomFilters(bool to) {
     for (auto vbid : vbMap.getBuckets()) {
         VBucketPtr vb = vbMap.getBucket(vbid);
@@ -2736,6 +2823,18 @@ SeqnoAckCallback KVBucket::makeSeqnoAckCB() const {
     };
 }
 
+SyncWriteTimeoutCallback KVBucket::makeSyncWriteTimeoutCB() {
+    return [this](Vbid vbid,
+                  int64_t seqno,
+                  std::optional<std::chrono::steady_clock::time_point>
+                          deadline) {
+        if (this->durabilityTimeoutTask) {
+            this->durabilityTimeoutTask->setSyncWriteTimeout(
+                    vbid, seqno, deadline);
+        }
+    };
+}
+
 KVStoreRWRO KVBucket::takeRWRO(size_t shardId) {
     return vbMap.shards[shardId]->takeRWRO();
 }
@@ -29,6 +29,8 @@
 #include <deque>
 
 class DurabilityCompletionTask;
+class DurabilityTimeoutTask;
+class HashTableMaintenance;
 class ReplicationThrottle;
 class VBucketCountVisitor;
 namespace Collections {
@@ -157,6 +159,29 @@ public:
 
     ENGINE_ERROR_CODE prepare(Item& item, const void* cookie);
 
+    /**
+     * Store a batch of replicated mutations into one vBucket - the
+     * equivalent of calling setWithMeta(CheckConflicts::No, allowExisting,
+     * GenerateBySeqno::No, GenerateCas::No) for each item in turn, but
+     * taking the vBucket state lock and checking memory usage once per
+     * batch rather than once per item.
+     *
+     * Items are stored in order. The batch stops at the first item which
+     * returns ENGINE_TMPFAIL or ENGINE_ENOMEM, so the caller can retry the
+     * remaining items later.
+     *
+     * @param vb vBucket to store the items into
+     * @param items items to store, in seqno order
+     * @param cookie cookie of the connection storing the items
+     * @param permittedVBStates states in which the vBucket accepts the items
+     * @return the status of each item attempted
+     */
+    std::vector<ENGINE_ERROR_CODE> setWithMetaBatch(
+            VBucket& vb,
+            const std::vector<Item*>& items,
+            const void* cookie,
+            PermittedVBStates permittedVBStates);
+
     GetValue getAndUpdateTtl(const DocKey& key,
                              Vbid vbucket,
                              const void* cookie,
@@ -497,6 +522,17 @@ public:
 
     void enableItemCompressor();
 
+    HashTableMaintenance& getHashTableMaintenance() {
+        return *hashTableMaintenance;
+    }
+
+    /**
+     * Register the given task (a HashTableMaintenanceConcern) with
+     * hashTableMaintenance, if ht_maintenance_shared_pass is enabled, so its
+     * HashTable walk is shared with the other maintenance tasks.
+     */
+    void addHashTableMaintenanceConcern(const ExTask& task);
+
     void setAllBloomFilters(bool to) override;
 
     float getBfiltersResidencyThreshold() override {
@@ -707,6 +743,33 @@ protected:
     bool resetVBucket_UNLOCKED(LockedVBucketPtr& vb,
                                std::unique_lock<std::mutex>& vbset);
 
+    /**
+     * Check whether a setWithMeta may proceed against the given vBucket in
+     * its current state. Caller must hold the vBucket's state lock.
+     *
+     * @return ENGINE_SUCCESS if the set may proceed, otherwise the error to
+     *         return for it (EWOULDBLOCK if queued as a pending op).
+     */
+    ENGINE_ERROR_CODE checkSetWithMetaVBState(
+            VBucket& vb,
+            const void* cookie,
+            PermittedVBStates permittedVBStates);
+
+    /**
+     * The body of setWithMeta shared with setWithMetaBatch: validates the
+     * CAS, takes the collections handle and stores the item. Caller must
+     * hold the vBucket's state lock and have checked its state.
+     */
+    ENGINE_ERROR_CODE setWithMeta_UNLOCKED(VBucket& vb,
+                                           Item& itm,
+                                           uint64_t cas,
+                                           uint64_t* seqno,
+                                           const void* cookie,
+                                           CheckConflicts checkConflicts,
+                                           bool allowExisting,
+                                           GenerateBySeqno genBySeqno,
+                                           GenerateCas genCas);
+
     /* Notify flusher of a new seqno being added in the vbucket */
     virtual void notifyFlusher(const Vbid vbid);
 
@@ -766,6 +829,12 @@ protected:
      */
     SeqnoAckCallback makeSeqnoAckCB() const;
 
+    /**
+     * Returns the callback function to be invoked by a vBucket's
+     * ActiveDurabilityMonitor to set / cancel the timeout of a SyncWrite.
+     */
+    SyncWriteTimeoutCallback makeSyncWriteTimeoutCB();
+
     /**
      * Chech if the given level is a valid Bucket Durability Level for this
      * Bucket.
@@ -791,12 +860,15 @@ protected:
     // stored in the hash table.  This is required to ensure that all the
     // frequency counts do not become saturated.
     ExTask itemFreqDecayerTask;
+    // Runs the HashTable walk shared by the above tasks, if they are
+    // registered with it (ht_maintenance_shared_pass).
+    std::unique_ptr<HashTableMaintenance> hashTableMaintenance;
     size_t                          compactionWriteQueueCap;
     float                           compactionExpMemThreshold;
 
     // Responsible for enforcing the Durability Timeout for the SyncWrites
     // tracked in this KVBucket.
-    ExTask durabilityTimeoutTask;
+    std::shared_ptr<DurabilityTimeoutTask> durabilityTimeoutTask;
 
     /// Responsible for completing (commiting or aborting SyncWrites which have
     /// completed in this KVBucket.
@@ -41,6 +41,7 @@
 #include "persistence_callback.h"
 #include "statistics/collector.h"
 #include "vbucket.h"
+#include "vbucket_bgfetch_item.h"
 #include "vbucket_state.h"
 
 #include <platform/dirutils.h>
@@ -503,6 +504,15 @@ void KVStore::addTimingStats(const AddStatFn& add_stat, const void* c) {
             prefix, "fsWriteCount", st.fsStats.writeCountHisto, add_stat, c);
 }
 
+void KVStore::getMulti(Vbid vb,
+                       vb_bgfetch_queue_t& itms,
+                       const GetMultiCb& cb) {
+    getMulti(vb, itms);
+    for (auto& fetch : itms) {
+        cb(fetch.first, fetch.second);
+    }
+}
+
 void KVStore::optimizeWrites(std::vector<queued_item>& items) {
     if (isReadOnly()) {
         throw std::logic_error(
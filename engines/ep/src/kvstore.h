@@ -634,6 +634,34 @@ public:
      */
     virtual bool commit(VB::Commit& commitData) = 0;
 
+    /**
+     * Group commit: enable / disable deferring the sync of commits. While
+     * enabled, commit() writes and commits the flush-batch but does not wait
+     * for it to be synced to disk, nor invoke the persistence callbacks of the
+     * batch; both happen for all deferred commits in syncDeferredCommits().
+     * This allows the flusher to commit several vBuckets and then sync their
+     * files together.
+     *
+     * @param enabled whether to defer syncs
+     * @return true if the KVStore supports (hence has now enabled) deferring
+     *         syncs; false if commit() always syncs
+     */
+    virtual bool setDeferredSync(bool enabled) {
+        return false;
+    }
+
+    /**
+     * Sync the files of all the commits deferred since the last call, then
+     * invoke the persistence callbacks of those commits.
+     *
+     * @return the vBuckets for which the sync failed; the persistence
+     *         callbacks of their flush-batches were invoked with a failure
+     *         status
+     */
+    virtual std::vector<Vbid> syncDeferredCommits() {
+        return {};
+    }
+
     /**
      * Rollback the current transaction.
      */
@@ -682,6 +710,29 @@ public:
         throw std::runtime_error("Backend does not support getMulti()");
     }
 
+    /**
+     * Callback for getMulti(), invoked once for each requested key as soon as
+     * its fetch has completed (successfully or not).
+     */
+    using GetMultiCb =
+            std::function<void(const DiskDocKey& key, vb_bgfetch_item_ctx_t&)>;
+
+    /**
+     * Retrieve multiple documents from the underlying storage system at once,
+     * invoking a callback for each document as soon as it has been read so
+     * the caller does not have to wait for the whole batch.
+     *
+     * The default implementation reads the whole batch and then invokes the
+     * callback for each item.
+     *
+     * @param vb vbucket id of a document
+     * @param itms list of items whose documents are going to be retrieved
+     * @param cb callback invoked for each item once it has been fetched
+     */
+    virtual void getMulti(Vbid vb,
+                          vb_bgfetch_queue_t& itms,
+                          const GetMultiCb& cb);
+
     /**
      * Callback for getRange().
      * @param value The fetched value. Note r-value receiver can modify (e.g.
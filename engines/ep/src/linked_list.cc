@@ -630,6 +630,12 @@ operator++() {
     return *this;
 }
 
+void BasicLinkedList::RangeIteratorLL::seek(seqno_t seqno) {
+    while (curr() != end() && curr() < seqno) {
+        ++(*this);
+    }
+}
+
 void BasicLinkedList::RangeIteratorLL::incrOperatorHelper() {
     if (curr() >= end()) {
         throw std::out_of_range(
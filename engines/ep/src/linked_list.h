@@ -315,6 +315,10 @@ private:
            latest is returned */
         RangeIteratorLL& operator++() override;
 
+        /* A linked list can only be walked, so this is linear in the number
+           of items skipped */
+        void seek(seqno_t seqno) override;
+
         seqno_t curr() const override {
             return itrRange.getBegin();
         }
@@ -263,6 +263,7 @@ public:
                            Vbid vb,
                            GetMetaOnly getMetaOnly) override;
 
+    using KVStore::getMulti;
     void getMulti(Vbid vb, vb_bgfetch_queue_t& itms) override;
 
     void getRange(Vbid vb,
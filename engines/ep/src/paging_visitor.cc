@@ -236,6 +236,12 @@ void PagingVisitor::visitBucket(const VBucketPtr& vb) {
     if (current > lower) {
         if (vBucketFilter(vb->getId())) {
             currentBucket = vb;
+            if (evictionPolicy == EvictionPolicy::sampled_lru) {
+                evictFromPool(*vb);
+                removeClosedUnrefCheckpoints(*vb);
+                return;
+            }
+
             maxCas = currentBucket->getMaxCas();
             itemEviction.reset();
             freqCounterThreshold = 0;
@@ -378,6 +384,66 @@ bool PagingVisitor::doEviction(const HashTable::HashBucketLock& lh,
     return false;
 }
 
+void PagingVisitor::evictFromPool(VBucket& vb) {
+    const double evictionRatio = evictionRatios.getForState(vb.getState());
+    if (evictionRatio <= 0.0) {
+        return;
+    }
+
+    // Aim to evict the same fraction of the vBucket's items as a hifi_mfu
+    // visit, but without visiting them all.
+    const size_t target =
+            std::ceil(vb.ht.getNumInMemoryItems() * evictionRatio);
+    // Bound the work done if few of the sampled items can be evicted (e.g.
+    // they are dirty).
+    const size_t maxAttempts = target * 2 + EvictionPool::MaxSize;
+
+    const bool isActiveOrPending = (vb.getState() == vbucket_state_active) ||
+                                   (vb.getState() == vbucket_state_pending);
+    auto& frequencyValuesEvictedHisto =
+            isActiveOrPending ? stats.activeOrPendingFrequencyValuesEvictedHisto
+                              : stats.replicaFrequencyValuesEvictedHisto;
+
+    auto pool = vb.evictionPool.lock();
+    size_t evicted = 0;
+    for (size_t attempt = 0; evicted < target && attempt < maxAttempts;
+         ++attempt) {
+        // Unlike a hifi_mfu visit we check memory usage after every
+        // eviction, so we stop as soon as enough has been freed.
+        if (stats.getEstimatedTotalMemoryUsed() < stats.mem_low_wat) {
+            isBelowLowWaterMark = true;
+            break;
+        }
+        pool->refill(vb);
+        auto candidate = pool->pop();
+        if (candidate && evictCandidate(vb, *candidate)) {
+            ++evicted;
+            frequencyValuesEvictedHisto.addValue(candidate->freqCounter);
+        }
+    }
+}
+
+bool PagingVisitor::evictCandidate(VBucket& vb,
+                                   const EvictionPool::Candidate& candidate) {
+    // Acquire the collections handle before the HashBucketLock, as for a
+    // HashTable visit (see setUpHashBucketVisit).
+    readHandle = vb.lockCollections();
+    bool evicted = false;
+    {
+        auto htRes = vb.ht.findOnlyCommitted(candidate.key);
+        auto* v = htRes.storedValue;
+        // An item which has been modified or referenced since it was sampled
+        // is no longer a good candidate.
+        if (v && v->getCas() == candidate.cas &&
+            v->getFreqCounterValue() <= candidate.freqCounter &&
+            !v->isDeleted() && !v->isTempItem()) {
+            evicted = doEviction(htRes.lock, v);
+        }
+    }
+    readHandle.unlock();
+    return evicted;
+}
+
 void PagingVisitor::setUpHashBucketVisit() {
     // Grab a locked ReadHandle
     readHandle = currentBucket->lockCollections();
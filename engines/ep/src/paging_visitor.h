@@ -18,6 +18,7 @@
 #pragma once
 
 #include "collections/vbucket_manifest_handles.h"
+#include "eviction_pool.h"
 #include "hash_table.h"
 #include "item_eviction.h"
 #include "item_pager.h"
@@ -42,7 +43,8 @@ class PagingVisitor : public PausableVBucketVisitor, public HashTableVisitor {
 public:
     enum class EvictionPolicy : uint8_t {
         lru2Bit, // The original 2-bit LRU policy
-        hifi_mfu // The new hifi_mfu policy
+        hifi_mfu, // The new hifi_mfu policy
+        sampled_lru // Evict the coldest of a pool of sampled candidates
     };
 
     /**
@@ -74,6 +76,17 @@ public:
                   size_t _agePercentage,
                   size_t _freqCounterAgeThreshold);
 
+    /**
+     * Select how the ItemPager chooses the items to evict from each vBucket:
+     * hifi_mfu (the default) visits every item, evicting those below the
+     * frequency (and age) thresholds; sampled_lru evicts the best candidates
+     * from the vBucket's EvictionPool, refilled by sampling the HashTable,
+     * until enough items have been evicted.
+     */
+    void setEvictionPolicy(EvictionPolicy policy) {
+        evictionPolicy = policy;
+    }
+
     bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override;
 
     void visitBucket(const VBucketPtr& vb) override;
@@ -133,6 +146,21 @@ private:
 
     bool doEviction(const HashTable::HashBucketLock& lh, StoredValue* v);
 
+    /**
+     * Evict items from the vBucket using its EvictionPool (sampled_lru),
+     * until the vBucket's eviction ratio of its items have been evicted or
+     * memory usage is below the low watermark.
+     */
+    void evictFromPool(VBucket& vb);
+
+    /**
+     * Evict the given candidate if it is still in the HashTable and hasn't
+     * been modified or referenced since it was sampled.
+     *
+     * @return true if the candidate was evicted.
+     */
+    bool evictCandidate(VBucket& vb, const EvictionPool::Candidate& candidate);
+
     std::list<Item> expired;
 
     KVBucket& store;
@@ -160,6 +188,8 @@ private:
     // visit all items in the vbucket.
     uint64_t maxCas;
 
+    EvictionPolicy evictionPolicy = EvictionPolicy::hifi_mfu;
+
     // The VB::Manifest read handle that we use to lock around HashBucket
     // visits. Will contain a nullptr if we aren't currently locking anything.
     Collections::VB::ReadHandle readHandle;
@@ -36,6 +36,10 @@ SequenceList::RangeIterator& SequenceList::RangeIterator::operator++() {
     return *this;
 }
 
+void SequenceList::RangeIterator::seek(seqno_t seqno) {
+    rangeIterImpl->seek(seqno);
+}
+
 seqno_t SequenceList::RangeIterator::curr() const {
     return rangeIterImpl->curr();
 }
@@ -95,6 +95,13 @@ protected:
          */
         virtual RangeIteratorImpl& operator++() = 0;
 
+        /**
+         * Advance the iterator to the first item with a seqno >= the given
+         * seqno (or to end() if there is none). Does nothing if the iterator
+         * is already past the seqno.
+         */
+        virtual void seek(seqno_t seqno) = 0;
+
         /**
          * Curr iterator position, indicated by the seqno of the item at that
          * position
@@ -194,6 +201,12 @@ public:
          */
         RangeIterator& operator++();
 
+        /**
+         * Advance the iterator to the first item with a seqno >= the given
+         * seqno (or to end() if there is none).
+         */
+        void seek(seqno_t seqno);
+
         /**
          * Curr iterator position, indicated by the seqno of the item at that
          * position
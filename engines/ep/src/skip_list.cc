@@ -0,0 +1,729 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "skip_list.h"
+#include "bucket_logger.h"
+#include "item.h"
+#include "objectregistry.h"
+#include "stats.h"
+
+#include <folly/Random.h>
+#include <folly/synchronization/Rcu.h>
+#include <memcached/vbucket.h>
+
+#include <algorithm>
+
+SkipList::Node::Node(OrderedStoredValue* osv, int height)
+    : osv(osv), height(height), next(new std::atomic<Node*>[height]) {
+    for (int level = 0; level < height; ++level) {
+        next[level].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+SkipList::SkipList(Vbid vbucketId, EPStats& st)
+    : SequenceList(),
+      head(nullptr, MaxHeight),
+      staleSize(0),
+      staleMetaDataSize(0),
+      highSeqno(0),
+      highestDedupedSeqno(0),
+      highestPurgedDeletedSeqno(0),
+      numStaleItems(0),
+      numDeletedItems(0),
+      vbid(vbucketId),
+      st(st) {
+    head.seqno = 0;
+    tails.fill(&head);
+}
+
+SkipList::~SkipList() {
+    {
+        /* Delete stale items and all the nodes here, other items are deleted
+           by the hash table */
+        std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+        auto* node = head.next[0].load();
+        while (node) {
+            auto* next = node->next[0].load();
+            if (node->osv->isStale(writeGuard)) {
+                st.coreLocal.get()->currentSize.fetch_sub(
+                        node->osv->metaDataSize());
+                delete node->osv;
+            }
+            delete node;
+            node = next;
+        }
+    }
+
+    /* Wait for the retired nodes to be freed, as that references the list */
+    folly::rcu_barrier();
+}
+
+void SkipList::appendToList(std::lock_guard<std::mutex>& seqLock,
+                            std::lock_guard<std::mutex>& writeLock,
+                            OrderedStoredValue& v) {
+    /* Normally the seqno of the tail is set by updateHighSeqno before the
+       next append; if not, set it now so the list stays ordered by seqno */
+    auto* tail = tails[0];
+    if (tail != &head && tail->seqno.load() == UnsetSeqno) {
+        tail->seqno.store(tail->osv->getBySeqno(), std::memory_order_release);
+    }
+
+    auto* node = new Node(&v, randomHeight());
+    /* Link the bottom level first, so a node reachable at any level is
+       reachable at level 0 */
+    for (int level = 0; level < node->height; ++level) {
+        tails[level]->next[level].store(node, std::memory_order_release);
+        tails[level] = node;
+    }
+    ++numItems;
+}
+
+SequenceList::UpdateStatus SkipList::updateListElem(
+        std::lock_guard<std::mutex>& seqLock,
+        std::lock_guard<std::mutex>& writeLock,
+        OrderedStoredValue& v) {
+    auto range = rangeLockManager.getLockedRange();
+
+    if (range.contains(v.getBySeqno())) {
+        /* OSV is in middle of a point-in-time snapshot, hence we cannot
+           move the element to the end of the list. Return a temp failure */
+        return UpdateStatus::Append;
+    }
+
+    auto* node = findFirstAtLeast(v.getBySeqno());
+    if (!node || node->osv != &v) {
+        throw std::logic_error(
+                "SkipList::updateListElem(): " + vbid.to_string() +
+                " item with seqno " + std::to_string(v.getBySeqno()) +
+                " is not in the list");
+    }
+
+    /* Since there is no other reads happening at this position, we can move
+       the item to the end of the list */
+    unlink(*node);
+    appendToList(seqLock, writeLock, v);
+
+    return UpdateStatus::Success;
+}
+
+std::tuple<ENGINE_ERROR_CODE, std::vector<UniqueItemPtr>, seqno_t>
+SkipList::rangeRead(seqno_t start, seqno_t end) {
+    if ((start > end) || (start <= 0)) {
+        EP_LOG_WARN("SkipList::rangeRead(): ({}) ERANGE: start {} > end {}",
+                    vbid,
+                    start,
+                    end);
+        return std::make_tuple(ENGINE_ERANGE, std::vector<UniqueItemPtr>(), 0);
+    }
+
+    RangeGuard range;
+
+    {
+        std::lock_guard<std::mutex> listWriteLg(getListWriteLock());
+
+        if (start > highSeqno) {
+            EP_LOG_WARN(
+                    "SkipList::rangeRead(): "
+                    "({}) ERANGE: start {} > highSeqno {}",
+                    vbid,
+                    start,
+                    static_cast<seqno_t>(highSeqno));
+            /* If the request is for an invalid range, return before iterating
+               through the list */
+            return std::make_tuple(
+                    ENGINE_ERANGE, std::vector<UniqueItemPtr>(), 0);
+        }
+
+        /* Mark the initial read range */
+        end = std::min(end, static_cast<seqno_t>(highSeqno));
+        end = std::max(end, static_cast<seqno_t>(highestDedupedSeqno));
+
+        /* Unlike BasicLinkedList we need only lock from start (not from the
+           beginning of the list), as we seek to it rather than walk to it.
+           The range lock will be released when the RangeGuard is destroyed */
+        range = tryLockSeqnoRangeShared(start, end);
+        if (!range) {
+            return std::make_tuple(
+                    ENGINE_TMPFAIL, std::vector<UniqueItemPtr>(), 0);
+        }
+    }
+
+    /* Read items in the range. Nodes in the locked range are stable, but the
+       seek may pass through (and each step may reach, past the end) nodes
+       being unlinked concurrently */
+    Node* node;
+    seqno_t currSeqno;
+    {
+        folly::rcu_reader guard;
+        node = findFirstAtLeast(start);
+        currSeqno = node ? node->seqno.load(std::memory_order_acquire)
+                         : UnsetSeqno;
+    }
+
+    std::vector<UniqueItemPtr> items;
+
+    while (currSeqno <= end) {
+        if (currSeqno > range.getRange().getBegin()) {
+            // strictly monotonically update the range lock
+            range.updateRangeStart(currSeqno);
+        }
+
+        /* Check if this OSV has been made stale and has been superseded by a
+         * newer version. If it has, and the replacement is /also/ in the range
+         * we are reading, we should skip this item to avoid duplicates */
+        seqno_t replacementSeqno = 0;
+        {
+            std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+            auto* replacement = node->osv->getReplacementIfStale(writeGuard);
+            if (replacement) {
+                replacementSeqno = replacement->getBySeqno();
+            }
+        }
+
+        if (replacementSeqno == 0 || replacementSeqno > end) {
+            try {
+                items.push_back(UniqueItemPtr(node->osv->toItem(vbid)));
+            } catch (const std::bad_alloc&) {
+                EP_LOG_WARN(
+                        "SkipList::rangeRead(): "
+                        "({}) ENOMEM while trying to copy "
+                        "item with seqno {} before streaming it",
+                        vbid,
+                        currSeqno);
+                return std::make_tuple(
+                        ENGINE_ENOMEM, std::vector<UniqueItemPtr>(), 0);
+            }
+        }
+
+        {
+            folly::rcu_reader guard;
+            node = node->next[0].load(std::memory_order_acquire);
+            currSeqno = node ? node->seqno.load(std::memory_order_acquire)
+                             : UnsetSeqno;
+        }
+    }
+
+    /* Return all the range read items */
+    return std::make_tuple(ENGINE_SUCCESS, std::move(items), end);
+}
+
+void SkipList::updateHighSeqno(std::lock_guard<std::mutex>& listWriteLg,
+                               const OrderedStoredValue& v) {
+    if (v.getBySeqno() < 1) {
+        throw std::invalid_argument("SkipList::updateHighSeqno(): " +
+                                    vbid.to_string() +
+                                    "; Cannot set the highSeqno to a value " +
+                                    std::to_string(v.getBySeqno()) +
+                                    " which is < 1");
+    }
+    highSeqno = v.getBySeqno();
+
+    /* The item has been assigned its seqno; publish it in its node (the
+       tail) so readers can find it */
+    auto* tail = tails[0];
+    if (tail != &head && tail->osv == &v &&
+        tail->seqno.load() == UnsetSeqno) {
+        tail->seqno.store(v.getBySeqno(), std::memory_order_release);
+    }
+}
+
+void SkipList::updateHighestDedupedSeqno(
+        std::lock_guard<std::mutex>& listWriteLg, const OrderedStoredValue& v) {
+    if (v.getBySeqno() < 1) {
+        throw std::invalid_argument(
+                "SkipList::updateHighestDedupedSeqno(): " + vbid.to_string() +
+                "; Cannot set the highestDedupedSeqno to "
+                "a value " +
+                std::to_string(v.getBySeqno()) + " which is < 1");
+    }
+    highestDedupedSeqno = v.getBySeqno();
+}
+
+void SkipList::maybeUpdateMaxVisibleSeqno(
+        std::lock_guard<std::mutex>& seqLock,
+        std::lock_guard<std::mutex>& writeLock,
+        const OrderedStoredValue& newSV) {
+    switch (newSV.getCommitted()) {
+    case CommittedState::CommittedViaMutation:
+    case CommittedState::CommittedViaPrepare:
+    case CommittedState::PrepareCommitted:
+        maxVisibleSeqno = static_cast<uint64_t>(newSV.getBySeqno());
+        return;
+    case CommittedState::Pending:
+    case CommittedState::PreparedMaybeVisible:
+    case CommittedState::PrepareAborted:
+        return;
+    }
+}
+
+void SkipList::markItemStale(std::lock_guard<std::mutex>& listWriteLg,
+                             StoredValue::UniquePtr ownedSv,
+                             StoredValue* newSv) {
+    /* Release the StoredValue as SkipList does not want it to be of owned
+       type */
+    StoredValue* v = ownedSv.release().get();
+
+    /* Update the stats tracking the memory owned by the list */
+    staleSize.fetch_add(v->size());
+    staleMetaDataSize.fetch_add(v->metaDataSize());
+    st.coreLocal.get()->currentSize.fetch_add(v->metaDataSize());
+
+    ++numStaleItems;
+    v->toOrderedStoredValue()->markStale(listWriteLg, newSv);
+}
+
+size_t SkipList::purgeTombstones(
+        seqno_t purgeUpToSeqno,
+        Collections::IsDroppedEphemeralCb isDroppedKeyCb,
+        std::function<bool()> shouldPause) {
+    // Purge items marked as stale (or belonging to dropped collections) from
+    // the list.
+    //
+    // Unlike BasicLinkedList we don't take an exclusive range lock: readers
+    // can create range locks at any time, and we only unlink an item if it
+    // is below every locked range (checked under the writeLock, which range
+    // locks are also created under). Readers only read items in their locked
+    // range, and nodes unlinked under a reader which is seeking are not freed
+    // until it has finished (see retire).
+    //
+    // The purger holds on to a node outside of the writeLock, inside an
+    // rcu_reader section so it is not freed meanwhile; if the node is
+    // unlinked meanwhile (the item was updated) we carry on from the node's
+    // seqno.
+    std::unique_lock<std::mutex> purgeGuard(purgeLock, std::try_to_lock);
+    if (!purgeGuard) {
+        // Another purge is running.
+        return 0;
+    }
+    folly::rcu_reader rcuGuard;
+
+    size_t purgedCount = 0;
+    Node* node;
+    {
+        std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+        node = findFirstAtLeast(pausedPurgeSeqno);
+    }
+    pausedPurgeSeqno = 0;
+
+    while (node) {
+        seqno_t seqno;
+        bool stale;
+        {
+            std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+            seqno = node->seqno.load();
+            if (seqno > purgeUpToSeqno || seqno <= 0) {
+                // Reached the end of the requested range, or the last item
+                // with no valid seqno yet.
+                break;
+            }
+
+            if (node->unlinked) {
+                node = findFirstAtLeast(seqno + 1);
+                continue;
+            }
+
+            if (!canPurge(seqno)) {
+                // Reached a range locked by a reader. Pause so next time
+                // purge is attempted it will resume from here (the reader
+                // may have moved on by then).
+                pausedPurgeSeqno = seqno;
+                break;
+            }
+            stale = node->osv->isStale(writeGuard);
+        }
+
+        bool isDropped = false;
+        if (!stale && isDroppedKeyCb) {
+            isDropped = isDroppedKeyCb(
+                    node->osv->getKey(), seqno, node->osv->isPending());
+        }
+
+        std::unique_ptr<OrderedStoredValue> purged;
+        {
+            std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+            if (node->unlinked) {
+                node = findFirstAtLeast(seqno + 1);
+                continue;
+            }
+            // Only stale or dropped items are purged, and only if a reader
+            // hasn't locked a range covering them meanwhile. (The item may
+            // also have been made stale meanwhile.)
+            stale = node->osv->isStale(writeGuard);
+            if ((stale || isDropped) && canPurge(seqno)) {
+                unlink(*node);
+                purged.reset(node->osv);
+            }
+            node = node->next[0].load();
+        }
+
+        if (purged) {
+            disposePurged(std::move(purged), stale);
+            ++purgedCount;
+        }
+
+        if (shouldPause()) {
+            if (node) {
+                std::lock_guard<std::mutex> writeGuard(getListWriteLock());
+                pausedPurgeSeqno = node->seqno.load();
+            }
+            break;
+        }
+    }
+
+    return purgedCount;
+}
+
+void SkipList::updateNumDeletedItems(bool oldDeleted, bool newDeleted) {
+    if (oldDeleted && !newDeleted) {
+        --numDeletedItems;
+    } else if (!oldDeleted && newDeleted) {
+        ++numDeletedItems;
+    }
+}
+
+uint64_t SkipList::getNumStaleItems() const {
+    return numStaleItems;
+}
+
+size_t SkipList::getStaleValueBytes() const {
+    return staleSize;
+}
+
+size_t SkipList::getStaleMetadataBytes() const {
+    return staleMetaDataSize;
+}
+
+uint64_t SkipList::getNumDeletedItems() const {
+    std::lock_guard<std::mutex> lckGd(getListWriteLock());
+    return numDeletedItems;
+}
+
+uint64_t SkipList::getNumItems() const {
+    return numItems;
+}
+
+uint64_t SkipList::getHighSeqno() const {
+    std::lock_guard<std::mutex> lckGd(getListWriteLock());
+    return highSeqno;
+}
+
+uint64_t SkipList::getHighestDedupedSeqno() const {
+    std::lock_guard<std::mutex> lckGd(getListWriteLock());
+    return highestDedupedSeqno;
+}
+
+seqno_t SkipList::getHighestPurgedDeletedSeqno() const {
+    return highestPurgedDeletedSeqno;
+}
+
+uint64_t SkipList::getMaxVisibleSeqno() const {
+    std::lock_guard<std::mutex> lg(getListWriteLock());
+    return maxVisibleSeqno;
+}
+
+std::pair<uint64_t, uint64_t> SkipList::getRangeRead() const {
+    return rangeLockManager.getLockedRange().getRange();
+}
+
+std::mutex& SkipList::getListWriteLock() const {
+    return writeLock;
+}
+
+std::optional<SequenceList::RangeIterator> SkipList::makeRangeIterator(
+        bool isBackfill) {
+    auto pRangeItr = RangeIteratorSL::create(*this, isBackfill);
+    return pRangeItr ? RangeIterator(std::move(pRangeItr))
+                     : std::optional<SequenceList::RangeIterator>{};
+}
+
+RangeGuard SkipList::tryLockSeqnoRangeShared(seqno_t start, seqno_t end) {
+    return rangeLockManager.tryLockRangeShared(start, end);
+}
+
+void SkipList::dump() const {
+    std::cerr << *this << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& os, const SkipList& sl) {
+    os << "SkipList[" << &sl << "] with numItems:" << sl.getNumItems()
+       << " deletedItems:" << sl.numDeletedItems
+       << " staleItems:" << sl.getNumStaleItems()
+       << " highPurgeSeqno:" << sl.getHighestPurgedDeletedSeqno()
+       << " elements:[" << std::endl;
+    size_t count = 0;
+    for (auto* node = sl.head.next[0].load(); node;
+         node = node->next[0].load()) {
+        os << "    height:" << node->height << " " << *node->osv << std::endl;
+        ++count;
+    }
+    os << "] (count:" << count << ")";
+    return os;
+}
+
+SkipList::Node* SkipList::findFirstAtLeast(seqno_t seqno) const {
+    const Node* pred = &head;
+    for (int level = MaxHeight - 1; level >= 0; --level) {
+        auto* next = pred->next[level].load(std::memory_order_acquire);
+        while (next && next->seqno.load(std::memory_order_acquire) < seqno) {
+            pred = next;
+            next = pred->next[level].load(std::memory_order_acquire);
+        }
+    }
+    return pred->next[0].load(std::memory_order_acquire);
+}
+
+int SkipList::randomHeight() {
+    int height = 1;
+    while (height < MaxHeight && folly::Random::oneIn(4)) {
+        ++height;
+    }
+    return height;
+}
+
+void SkipList::unlink(Node& node) {
+    const auto seqno = node.seqno.load();
+    Node* pred = &head;
+    for (int level = MaxHeight - 1; level >= 0; --level) {
+        auto* next = pred->next[level].load();
+        while (next && next != &node && next->seqno.load() < seqno) {
+            pred = next;
+            next = pred->next[level].load();
+        }
+        if (next == &node) {
+            /* The node keeps its own links, so a reader currently at it can
+               carry on to its (former) successors */
+            pred->next[level].store(node.next[level].load(),
+                                    std::memory_order_release);
+            if (tails[level] == &node) {
+                tails[level] = pred;
+            }
+        }
+    }
+    node.unlinked = true;
+    retire(node);
+    --numItems;
+}
+
+void SkipList::retire(Node& node) {
+    /* Freed once no reader can still be referencing it; that may be done by
+       any thread (of any bucket), so switch to this list's bucket for the
+       memory accounting */
+    ++numRetiredNodes;
+    auto* engine = ObjectRegistry::getCurrentEngine();
+    folly::rcu_retire(&node, [this, engine](Node* retired) {
+        BucketAllocationGuard guard(engine);
+        delete retired;
+        --numRetiredNodes;
+    });
+}
+
+bool SkipList::canPurge(seqno_t seqno) const {
+    const auto range = rangeLockManager.getLockedRange();
+    return !range.valid() || seqno < range.getBegin();
+}
+
+void SkipList::disposePurged(std::unique_ptr<OrderedStoredValue> purged,
+                             bool isStale) {
+    if (isStale) {
+        /* Update the stats tracking the memory owned by the list */
+        staleSize.fetch_sub(purged->size());
+        staleMetaDataSize.fetch_sub(purged->metaDataSize());
+        --numStaleItems;
+    }
+
+    st.coreLocal.get()->currentSize.fetch_sub(purged->metaDataSize());
+
+    if (purged->isDeleted()) {
+        --numDeletedItems;
+    }
+
+    if (purged->isDeleted() &&
+        purged->getBySeqno() > highestPurgedDeletedSeqno.load()) {
+        highestPurgedDeletedSeqno = purged->getBySeqno();
+    }
+}
+
+std::unique_ptr<SkipList::RangeIteratorSL> SkipList::RangeIteratorSL::create(
+        SkipList& sl, bool isBackfill) {
+    /* Note: cannot use std::make_unique because the constructor of
+       RangeIteratorSL is private */
+    std::unique_ptr<SkipList::RangeIteratorSL> pRangeItr(
+            new SkipList::RangeIteratorSL(sl, isBackfill));
+    return pRangeItr->tryLater() ? nullptr : std::move(pRangeItr);
+}
+
+SkipList::RangeIteratorSL::RangeIteratorSL(SkipList& sl, bool isBackfill)
+    : list(sl),
+      itrRange(0, 0),
+      numRemaining(0),
+      earlySnapShotEndSeqno(0),
+      maxVisibleSeqno(0),
+      isBackfill(isBackfill) {
+    std::lock_guard<std::mutex> listWriteLg(list.getListWriteLock());
+
+    /* First node of the list; stable under the writeLock */
+    currNode = list.head.next[0].load();
+
+    if (list.highSeqno < 1 || !currNode) {
+        /* No need of holding a lock for the snapshot as there are no items;
+           Also iterator range is at default (0, 0) */
+        return;
+    }
+
+    /* Number of items that can be iterated over */
+    numRemaining = list.numItems;
+
+    /* The minimum seqno in the iterator that must be read to get a consistent
+       read snapshot */
+    earlySnapShotEndSeqno = list.highestDedupedSeqno;
+
+    maxVisibleSeqno = list.maxVisibleSeqno;
+
+    const auto first = currNode->seqno.load();
+    const auto last = list.tails[0]->seqno.load();
+
+    /* Mark the snapshot range on the list. The range that can be read by the
+       iterator is inclusive of the start and the end. */
+    rangeGuard = list.tryLockSeqnoRangeShared(first, last);
+
+    if (!rangeGuard) {
+        return;
+    }
+
+    /* As for RangeIteratorLL, the range end is one higher than the last seqno
+       which can be read, to identify the end point of the iterator */
+    itrRange = SeqRange(first, last + 1);
+
+    auto severity = isBackfill ? spdlog::level::level_enum::info
+                               : spdlog::level::level_enum::debug;
+
+    EP_LOG_FMT(severity,
+               "{} Created range iterator from {} to {}",
+               list.vbid,
+               itrRange.getBegin(),
+               itrRange.getEnd());
+}
+
+SkipList::RangeIteratorSL::~RangeIteratorSL() {
+    if (rangeGuard) {
+        auto severity = isBackfill ? spdlog::level::level_enum::info
+                                   : spdlog::level::level_enum::debug;
+        EP_LOG_FMT(severity, "{} Releasing the range iterator", list.vbid);
+    }
+    /* As rangeGuard is destroyed, it will automatically release
+       the range lock on the list */
+}
+
+OrderedStoredValue& SkipList::RangeIteratorSL::operator*() const {
+    if (curr() >= end()) {
+        /* We can't read beyond the range end */
+        throw std::out_of_range(
+                "SkipList::RangeIteratorSL::operator*()"
+                ": Trying to read beyond range end seqno " +
+                std::to_string(end()));
+    }
+    return *currNode->osv;
+}
+
+SkipList::RangeIteratorSL& SkipList::RangeIteratorSL::operator++() {
+    do {
+        if (curr() >= end()) {
+            throw std::out_of_range(
+                    "SkipList::RangeIteratorSL::operator++()"
+                    ": Trying to move the iterator beyond range end"
+                    " seqno " +
+                    std::to_string(end()));
+        }
+
+        --numRemaining;
+
+        /* Increment beyond the last element indicates the end of the
+           iteration */
+        if (curr() == back()) {
+            finish();
+            return *this;
+        }
+
+        /* The successor of a node before back() is also in the range */
+        moveTo(currNode->next[0].load(std::memory_order_acquire));
+    } while (itrRangeContainsAnUpdatedVersion());
+    return *this;
+}
+
+void SkipList::RangeIteratorSL::seek(seqno_t seqno) {
+    if (curr() >= end() || seqno <= curr()) {
+        return;
+    }
+    if (seqno > back()) {
+        numRemaining = 0;
+        finish();
+        return;
+    }
+
+    /* back() >= seqno, so the node found is in the range; the descent may
+       pass through nodes below it which are being unlinked */
+    Node* node;
+    {
+        folly::rcu_reader guard;
+        node = list.findFirstAtLeast(seqno);
+    }
+    moveTo(node);
+
+    /* We can't tell how many items were skipped without counting them;
+       the remaining items can be no more than the remaining seqnos */
+    numRemaining = std::min(numRemaining, uint64_t(end() - curr()));
+
+    if (itrRangeContainsAnUpdatedVersion()) {
+        ++(*this);
+    }
+}
+
+void SkipList::RangeIteratorSL::moveTo(Node* node) {
+    currNode = node;
+    const auto seqno = currNode->seqno.load(std::memory_order_acquire);
+
+    /* As the iterator moves we reduce the snapshot range being read on the
+       list. This helps reduce the stale items in the list during heavy
+       update load from the front end, and lets the purger follow behind */
+    rangeGuard.updateRangeStart(seqno);
+
+    /* Also update the current range stored in the iterator obj */
+    itrRange.setBegin(seqno);
+}
+
+void SkipList::RangeIteratorSL::finish() {
+    /* We reset the range lock here so that any iterator client that does not
+       delete the iterator obj will not end up holding the list range lock
+       forever */
+    rangeGuard.reset();
+    auto severity = isBackfill ? spdlog::level::level_enum::info
+                               : spdlog::level::level_enum::debug;
+    EP_LOG_FMT(severity, "{} Releasing the range iterator", list.vbid);
+
+    /* Update the begin to end() so the client can see that the iteration
+       has ended */
+    itrRange.setBegin(end());
+}
+
+bool SkipList::RangeIteratorSL::itrRangeContainsAnUpdatedVersion() {
+    /* Check if this OSV has been made stale and has been superseded by a
+       newer version. If it has, and the replacement is /also/ in the range
+       we are reading, we should skip this item to avoid duplicates */
+    std::lock_guard<std::mutex> writeGuard(list.getListWriteLock());
+    auto* replacement = currNode->osv->getReplacementIfStale(writeGuard);
+    return (replacement != nullptr && replacement->getBySeqno() <= back());
+}
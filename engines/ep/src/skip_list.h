@@ -0,0 +1,412 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/**
+ * This header file contains the class definition of the skip list
+ * implementation of the abstract class SequenceList
+ */
+
+#pragma once
+
+#include "monotonic.h"
+#include "range_lock_manager.h"
+#include "seqlist.h"
+#include "stored-value.h"
+
+#include <platform/non_negative_counter.h>
+#include <relaxed_atomic.h>
+
+#include <array>
+#include <atomic>
+#include <limits>
+
+/**
+ * This class implements SequenceList as a skip list ordered by seqno.
+ *
+ * Compared to BasicLinkedList it lets readers find the position of a given
+ * seqno in O(log n) instead of walking the list from the start - a DCP
+ * backfill from a high seqno no longer visits every item before it - and
+ * lets the stale item purger run concurrently with range readers instead of
+ * excluding them.
+ *
+ * Each OrderedStoredValue in the list is referenced by a Node which holds
+ * the forward links of each level. Like BasicLinkedList, the HashTable owns
+ * the non-stale OSVs and the list owns (and deletes) the stale ones; unlike
+ * it, the OSV's intrusive seqno_hook is not used.
+ *
+ * The cost of this is memory: every item appended (or moved by an update)
+ * needs two heap allocations, the Node and its array of next pointers (4/3
+ * levels on average), where BasicLinkedList needs none.
+ *
+ * Concurrency:
+ * ===========
+ * - Writes (append, update, unlink by the purger) are serialised by the
+ *   writeLock, as the SequenceList interface requires. Appends are O(1)
+ *   expected - the new node is linked after the tail of each of its levels -
+ *   and links are published with release stores, so readers never need the
+ *   writeLock to walk the list.
+ * - Readers walk the list without the writeLock. A node's seqno is copied
+ *   into the node when it is set (updateHighSeqno) and never changes after,
+ *   so a reader walking concurrently with an update sees a consistent order.
+ * - Unlinked nodes are not freed immediately: a reader may still be at (or
+ *   passing through) one. They are retired (folly::rcu_retire) when unlinked
+ *   - by an update as well as by the purger - and freed after an RCU grace
+ *   period, so every walk which may reach an unlinked node is done inside a
+ *   folly::rcu_reader section.
+ * - Range reads and iterators hold a shared range lock, as for
+ *   BasicLinkedList, which stops front end ops relocating items in the
+ *   range. The purger does not take a range lock at all: it purges stale
+ *   items below the lowest locked seqno and pauses there. Readers thus never
+ *   have to back off (TMPFAIL) because of the purger, and the purger makes
+ *   progress underneath a long backfill.
+ *
+ * Lock hierarchy: purgeLock ==> writeLock ==> rangeLock.
+ */
+class SkipList : public SequenceList {
+public:
+    /// Maximum number of levels of a node.
+    static constexpr int MaxHeight = 16;
+
+    SkipList(Vbid vbucketId, EPStats& st);
+
+    ~SkipList() override;
+
+    void appendToList(std::lock_guard<std::mutex>& seqLock,
+                      std::lock_guard<std::mutex>& writeLock,
+                      OrderedStoredValue& v) override;
+
+    SequenceList::UpdateStatus updateListElem(
+            std::lock_guard<std::mutex>& seqLock,
+            std::lock_guard<std::mutex>& writeLock,
+            OrderedStoredValue& v) override;
+
+    std::tuple<ENGINE_ERROR_CODE, std::vector<UniqueItemPtr>, seqno_t>
+    rangeRead(seqno_t start, seqno_t end) override;
+
+    void updateHighSeqno(std::lock_guard<std::mutex>& listWriteLg,
+                         const OrderedStoredValue& v) override;
+
+    void updateHighestDedupedSeqno(std::lock_guard<std::mutex>& listWriteLg,
+                                   const OrderedStoredValue& v) override;
+
+    void maybeUpdateMaxVisibleSeqno(std::lock_guard<std::mutex>& seqLock,
+                                    std::lock_guard<std::mutex>& writeLock,
+                                    const OrderedStoredValue& newSV) override;
+
+    void markItemStale(std::lock_guard<std::mutex>& listWriteLg,
+                       StoredValue::UniquePtr ownedSv,
+                       StoredValue* newSv) override;
+
+    size_t purgeTombstones(
+            seqno_t purgeUpToSeqno,
+            Collections::IsDroppedEphemeralCb isDroppedKeyCb =
+                    [](const DocKey, int64_t, bool) { return false; },
+            std::function<bool()> shouldPause =
+                    []() { return false; }) override;
+
+    void updateNumDeletedItems(bool oldDeleted, bool newDeleted) override;
+
+    uint64_t getNumStaleItems() const override;
+
+    size_t getStaleValueBytes() const override;
+
+    size_t getStaleMetadataBytes() const override;
+
+    uint64_t getNumDeletedItems() const override;
+
+    uint64_t getNumItems() const override;
+
+    /// @return the number of nodes unlinked but not yet freed
+    size_t getNumRetiredNodes() const {
+        return numRetiredNodes;
+    }
+
+    uint64_t getHighSeqno() const override;
+
+    uint64_t getHighestDedupedSeqno() const override;
+
+    seqno_t getHighestPurgedDeletedSeqno() const override;
+
+    uint64_t getMaxVisibleSeqno() const override;
+
+    std::pair<uint64_t, uint64_t> getRangeRead() const override;
+
+    std::mutex& getListWriteLock() const override;
+
+    std::optional<SequenceList::RangeIterator> makeRangeIterator(
+            bool isBackfill) override;
+
+    /**
+     * Locks a range of seqnos in the sequence list, stopping front end ops
+     * updating and relocating items in the given seqno range and the purger
+     * removing items at or above its start. See
+     * BasicLinkedList::tryLockSeqnoRangeShared.
+     */
+    RangeGuard tryLockSeqnoRangeShared(seqno_t start, seqno_t end);
+
+    void dump() const override;
+
+protected:
+    /// Seqno of a node whose item has not been assigned its seqno yet.
+    static constexpr seqno_t UnsetSeqno = std::numeric_limits<seqno_t>::max();
+
+    struct Node {
+        Node(OrderedStoredValue* osv, int height);
+
+        /* The item; nullptr for the head node */
+        OrderedStoredValue* const osv;
+
+        /* Seqno of the item when it was put in this position of the list.
+           UnsetSeqno until updateHighSeqno (only the tail can be unset),
+           immutable afterwards */
+        std::atomic<seqno_t> seqno{UnsetSeqno};
+
+        /* Number of levels this node is linked in */
+        const int height;
+
+        /* Set when the node is removed from the list. Guarded by writeLock */
+        bool unlinked = false;
+
+        /* Forward links, one per level */
+        std::unique_ptr<std::atomic<Node*>[]> next;
+    };
+
+    /**
+     * Returns the first node in the list with a seqno >= the given seqno, or
+     * nullptr if there is none.
+     *
+     * Must be called with the writeLock held, or inside a folly::rcu_reader
+     * section (as it may pass through nodes being unlinked concurrently).
+     */
+    Node* findFirstAtLeast(seqno_t seqno) const;
+
+    /* Sentinel before the first node; linked at every level */
+    Node head;
+
+    /* Last node of each level (&head if the level is empty). Guarded by
+       writeLock */
+    std::array<Node*, MaxHeight> tails;
+
+    /**
+     * Lock that serializes writes (append, update, unlinking by
+     * purgeTombstones) on the list + the updation of the corresponding
+     * highSeqno or the highestDedupedSeqno atomic
+     */
+    mutable std::mutex writeLock;
+
+    /* Serializes runs of purgeTombstones */
+    std::mutex purgeLock;
+
+    /**
+     * Used to mark of the range where point-in-time snapshot is happening.
+     * To get a valid point-in-time snapshot and for correct list iteration we
+     * must not de-duplicate or purge an item in the range tracked by the
+     * manager.
+     */
+    RangeLockManager rangeLockManager;
+
+    /* Overall memory consumed by (stale) OrderedStoredValues owned by the
+       list */
+    cb::RelaxedAtomic<size_t> staleSize;
+
+    /* Metadata memory consumed by (stale) OrderedStoredValues owned by the
+       list */
+    cb::RelaxedAtomic<size_t> staleMetaDataSize;
+
+private:
+    /// Returns a random height for a new node; each level above the first
+    /// with probability 1/4.
+    static int randomHeight();
+
+    /**
+     * Remove the node from the list and retire it. The caller must hold the
+     * writeLock.
+     */
+    void unlink(Node& node);
+
+    /**
+     * Can the item at the given seqno be removed from the list now, i.e. is
+     * it below every range currently locked by readers? The caller must hold
+     * the writeLock.
+     */
+    bool canPurge(seqno_t seqno) const;
+
+    /**
+     * Update the stats for an item the purger has removed from the list, and
+     * delete it.
+     */
+    void disposePurged(std::unique_ptr<OrderedStoredValue> purged,
+                       bool isStale);
+
+    /**
+     * Free the unlinked node once no reader can still be referencing it.
+     * The caller must hold the writeLock.
+     */
+    void retire(Node& node);
+
+    /* Number of nodes linked in the list */
+    std::atomic<uint64_t> numItems{0};
+
+    /* Number of nodes unlinked but not yet freed */
+    std::atomic<size_t> numRetiredNodes{0};
+
+    /**
+     * We need to keep track of the highest seqno separately because there is a
+     * small window wherein the last element of the list (though in correct
+     * order) does not have a seqno.
+     *
+     * Guarded by writeLock.
+     */
+    Monotonic<seqno_t> highSeqno;
+
+    /* We need to this to send out point-in-time snapshots in range read */
+    Monotonic<seqno_t> highestDedupedSeqno;
+
+    /* The sequence number of the highest purged element */
+    Monotonic<seqno_t> highestPurgedDeletedSeqno;
+
+    /* Seqno of the last visible item; see BasicLinkedList::maxVisibleSeqno */
+    Monotonic<uint64_t> maxVisibleSeqno{0};
+
+    /* Number of stale items in the list */
+    cb::NonNegativeCounter<uint64_t> numStaleItems;
+
+    /* Number of logically deleted items in the list */
+    cb::NonNegativeCounter<uint64_t> numDeletedItems;
+
+    /* Used only to log debug messages */
+    const Vbid vbid;
+
+    /* Ep engine stats handle to track stats */
+    EPStats& st;
+
+    /* Seqno at which the tombstone purging was paused (0 if not paused).
+       Guarded by purgeLock */
+    seqno_t pausedPurgeSeqno = 0;
+
+    friend std::ostream& operator<<(std::ostream& os, const SkipList& sl);
+
+    class RangeIteratorSL : public SequenceList::RangeIteratorImpl {
+    public:
+        /**
+         * Method to create instances of RangeIteratorSL. Creation fails if
+         * the range cannot be locked.
+         *
+         * @param sl ref to the skip list on which the iterator is created
+         * @param isBackfill indicates if the iterator is for backfill (for
+         *                   debug)
+         *
+         * @return Non-null pointer on success, or null if the range could not
+         *         be locked.
+         */
+        static std::unique_ptr<RangeIteratorSL> create(SkipList& sl,
+                                                       bool isBackfill);
+
+        ~RangeIteratorSL() override;
+
+        OrderedStoredValue& operator*() const override;
+
+        /* Duplicate items are not returned by the iterator. That is, if there
+           multiple copies of an item in the iterator range, then only the
+           latest is returned */
+        RangeIteratorSL& operator++() override;
+
+        /* O(log n): descends the skip list from the head */
+        void seek(seqno_t seqno) override;
+
+        seqno_t curr() const override {
+            return itrRange.getBegin();
+        }
+
+        seqno_t end() const override {
+            return itrRange.getEnd();
+        }
+
+        seqno_t back() const override {
+            return itrRange.getEnd() - 1;
+        }
+
+        uint64_t count() const override {
+            return numRemaining;
+        }
+
+        seqno_t getEarlySnapShotEnd() const override {
+            return earlySnapShotEndSeqno;
+        }
+
+        uint64_t getMaxVisibleSeqno() const override {
+            return maxVisibleSeqno;
+        }
+
+    private:
+        RangeIteratorSL(SkipList& sl, bool isBackfill);
+
+        /**
+         * Indicates if the client should try creating the iterator at a later
+         * point.
+         */
+        bool tryLater() const {
+            /* could not lock and the list has items */
+            return (!rangeGuard && (list.getNumItems() > 0));
+        }
+
+        /* Move the iterator to the given node, which must be in the range */
+        void moveTo(Node* node);
+
+        /* Mark the iteration as finished and release the range lock */
+        void finish();
+
+        /**
+         * Indicates if there is a newer version of the curr item in the
+         * iterator range
+         */
+        bool itrRangeContainsAnUpdatedVersion();
+
+        /* Ref to SkipList object which is iterated by this iterator */
+        SkipList& list;
+
+        /* The current node pointed by the iterator. Nodes in the locked range
+           are neither unlinked nor freed while the lock is held */
+        Node* currNode = nullptr;
+
+        /* guard holding the range lock over the list to stop items in the
+           needed range being updated or purged */
+        RangeGuard rangeGuard;
+
+        /* Current range of the iterator */
+        SeqRange itrRange;
+
+        /* Number of items that can be iterated over by this (forward only)
+           iterator at that instance */
+        uint64_t numRemaining;
+
+        /* Indicates the minimum seqno in the iterator that can give a
+           consistent read snapshot */
+        seqno_t earlySnapShotEndSeqno;
+
+        uint64_t maxVisibleSeqno;
+
+        /* Indicates if the range iterator is for DCP backfill
+           (for debug) */
+        bool isBackfill;
+    };
+
+    friend class RangeIteratorSL;
+};
+
+/// Outputs a textual description of the SkipList
+std::ostream& operator<<(std::ostream& os, const SkipList& sl);
@@ -0,0 +1,312 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "sorted_access_log.h"
+#include "mutation_log.h"
+
+#include <folly/FileUtil.h>
+#include <folly/hash/Checksum.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace SortedAccessLog {
+
+static constexpr char Magic[8] = {'c', 'b', 'a', 'l', 'o', 'g', 's', '\0'};
+
+// Offsets of the header fields.
+static constexpr size_t VersionOffset = 8;
+static constexpr size_t NumRunsOffset = 12;
+static constexpr size_t NumEntriesOffset = 16;
+static constexpr size_t IndexOffsetOffset = 24;
+static constexpr size_t ChecksumOffset = 32;
+
+template <class T>
+static void put(uint8_t* dest, T value) {
+    value = folly::Endian::big(value);
+    std::memcpy(dest, &value, sizeof(T));
+}
+
+template <class T>
+static T get(const uint8_t* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return folly::Endian::big(value);
+}
+
+bool isSortedAccessLog(const std::string& path) {
+    try {
+        folly::File file(path);
+        char magic[sizeof(Magic)];
+        return folly::readFull(file.fd(), magic, sizeof(magic)) ==
+                       ssize_t(sizeof(magic)) &&
+               std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+    } catch (const std::system_error&) {
+        return false;
+    }
+}
+
+} // namespace SortedAccessLog
+
+using namespace SortedAccessLog;
+
+SortedAccessLogWriter::SortedAccessLogWriter(std::string path)
+    : path(std::move(path)), offset(HeaderSize), checksum(~0U) {
+    try {
+        file = folly::File(this->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    } catch (const std::system_error& e) {
+        throw MutationLog::WriteException(
+                "SortedAccessLogWriter: failed to create '" + this->path +
+                "': " + e.what());
+    }
+    // Placeholder, rewritten by commit().
+    const std::vector<uint8_t> header(HeaderSize);
+    write(header.data(), header.size());
+}
+
+void SortedAccessLogWriter::addRun(Vbid vbid, std::vector<Entry>& entries) {
+    if (committed) {
+        throw std::logic_error("SortedAccessLogWriter::addRun: log '" + path +
+                               "' has already been committed");
+    }
+    // A vBucket's runs must be consecutive (so that the reader can treat them
+    // as one range of the file).
+    if (completed.count(vbid)) {
+        throw std::logic_error("SortedAccessLogWriter::addRun: " +
+                               vbid.to_string() + " already added to '" +
+                               path + "'");
+    }
+    if (entries.empty()) {
+        return;
+    }
+    if (!index.empty() && index.back().vbid != vbid) {
+        completed.insert(index.back().vbid);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.seqno < b.seqno;
+    });
+
+    index.push_back({vbid, uint32_t(entries.size()), offset});
+    buffer.clear();
+    for (const auto& entry : entries) {
+        const auto pos = buffer.size();
+        buffer.resize(pos + EntryHeaderSize + entry.key.size());
+        put<uint64_t>(buffer.data() + pos, entry.seqno);
+        put<uint16_t>(buffer.data() + pos + 8, uint16_t(entry.key.size()));
+        std::memcpy(buffer.data() + pos + EntryHeaderSize,
+                    entry.key.data(),
+                    entry.key.size());
+    }
+    checksum = folly::crc32c(buffer.data(), buffer.size(), checksum);
+    write(buffer.data(), buffer.size());
+    numEntries += entries.size();
+}
+
+void SortedAccessLogWriter::commit() {
+    if (committed) {
+        return;
+    }
+
+    const auto indexOffset = offset;
+    buffer.assign(index.size() * IndexRecordSize, 0);
+    for (size_t ii = 0; ii < index.size(); ++ii) {
+        auto* rec = buffer.data() + ii * IndexRecordSize;
+        put<uint16_t>(rec, index[ii].vbid.get());
+        put<uint32_t>(rec + 4, index[ii].numEntries);
+        put<uint64_t>(rec + 8, index[ii].offset);
+    }
+    checksum = folly::crc32c(buffer.data(), buffer.size(), checksum);
+    write(buffer.data(), buffer.size());
+
+    std::vector<uint8_t> header(HeaderSize);
+    std::memcpy(header.data(), Magic, sizeof(Magic));
+    put<uint32_t>(header.data() + VersionOffset, Version);
+    put<uint32_t>(header.data() + NumRunsOffset, uint32_t(index.size()));
+    put<uint64_t>(header.data() + NumEntriesOffset, numEntries);
+    put<uint64_t>(header.data() + IndexOffsetOffset, indexOffset);
+    put<uint32_t>(header.data() + ChecksumOffset, checksum);
+    if (folly::pwriteFull(file.fd(), header.data(), header.size(), 0) !=
+                ssize_t(header.size()) ||
+        folly::fsyncNoInt(file.fd()) != 0) {
+        throw MutationLog::WriteException(
+                "SortedAccessLogWriter::commit: failed to write '" + path +
+                "': " + std::strerror(errno));
+    }
+    file.close();
+    committed = true;
+}
+
+void SortedAccessLogWriter::write(const uint8_t* data, size_t len) {
+    if (folly::writeFull(file.fd(), data, len) != ssize_t(len)) {
+        throw MutationLog::WriteException(
+                "SortedAccessLogWriter: failed to write '" + path +
+                "': " + std::strerror(errno));
+    }
+    offset += len;
+}
+
+SortedAccessLogReader::Entry SortedAccessLogReader::const_iterator::operator*()
+        const {
+    return {get<uint64_t>(pos),
+            DocKey(pos + EntryHeaderSize,
+                   get<uint16_t>(pos + 8),
+                   DocKeyEncodesCollectionId::Yes)};
+}
+
+SortedAccessLogReader::const_iterator&
+SortedAccessLogReader::const_iterator::operator++() {
+    pos += EntryHeaderSize + get<uint16_t>(pos + 8);
+    return *this;
+}
+
+static folly::MemoryMapping mapFile(const std::string& path) {
+    try {
+        return folly::MemoryMapping(path.c_str());
+    } catch (const std::system_error& e) {
+        throw MutationLog::ReadException("SortedAccessLogReader: failed to map '" +
+                                         path + "': " + e.what());
+    }
+}
+
+SortedAccessLogReader::SortedAccessLogReader(const std::string& path)
+    : mapping(mapFile(path)) {
+    // Validation reads the whole file front to back, as will warmup.
+    mapping.hintLinearScan();
+    validate(path);
+}
+
+void SortedAccessLogReader::validate(const std::string& path) {
+    const auto data = mapping.range();
+    if (data.size() < HeaderSize) {
+        throw MutationLog::ShortReadException();
+    }
+    const auto* base = data.data();
+    if (std::memcmp(base, Magic, sizeof(Magic)) != 0) {
+        throw MutationLog::ReadException("SortedAccessLogReader: '" + path +
+                                         "' is not a sorted access log");
+    }
+    const auto version = get<uint32_t>(base + VersionOffset);
+    if (version < 1 || version > Version) {
+        throw MutationLog::ReadException(
+                "SortedAccessLogReader: '" + path + "' has unsupported version " +
+                std::to_string(version));
+    }
+
+    const auto numRuns = get<uint32_t>(base + NumRunsOffset);
+    const auto expectedEntries = get<uint64_t>(base + NumEntriesOffset);
+    const auto indexOffset = get<uint64_t>(base + IndexOffsetOffset);
+    // The index is the last thing in the file.
+    if (indexOffset < HeaderSize || indexOffset > data.size() ||
+        (data.size() - indexOffset) != uint64_t(numRuns) * IndexRecordSize) {
+        throw MutationLog::ShortReadException();
+    }
+    if (folly::crc32c(base + HeaderSize, data.size() - HeaderSize) !=
+        get<uint32_t>(base + ChecksumOffset)) {
+        throw MutationLog::CRCReadException();
+    }
+
+    // The checksum only guards against corruption; check the structure so
+    // that iterating can never step outside the mapping. The runs must cover
+    // the entries exactly, so check them in file order (the index of a
+    // version 1 log is in vbid order instead).
+    const auto* entriesEnd = base + indexOffset;
+    std::vector<IndexRecord> runs;
+    runs.reserve(numRuns);
+    for (uint32_t ii = 0; ii < numRuns; ++ii) {
+        const auto* rec = entriesEnd + ii * IndexRecordSize;
+        const auto runOffset = get<uint64_t>(rec + 8);
+        if (runOffset > indexOffset) {
+            throw MutationLog::ShortReadException();
+        }
+        runs.push_back({Vbid(get<uint16_t>(rec)),
+                        get<uint32_t>(rec + 4),
+                        base + runOffset,
+                        nullptr});
+    }
+    std::stable_sort(runs.begin(), runs.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    const auto* next = base + HeaderSize;
+    for (auto& record : runs) {
+        if (record.first != next) {
+            throw MutationLog::ReadException(
+                    "SortedAccessLogReader: '" + path +
+                    "' has an invalid index record for " +
+                    record.vbid.to_string());
+        }
+        auto* pos = record.first;
+        for (uint32_t entry = 0; entry < record.numEntries; ++entry) {
+            if (entriesEnd - pos < ptrdiff_t(EntryHeaderSize) ||
+                entriesEnd - pos - EntryHeaderSize < get<uint16_t>(pos + 8)) {
+                throw MutationLog::ShortReadException();
+            }
+            pos += EntryHeaderSize + get<uint16_t>(pos + 8);
+        }
+        record.last = pos;
+        next = pos;
+        numEntries += record.numEntries;
+        // A vBucket's (consecutive) runs are merged into one record.
+        if (!index.empty() && index.back().vbid == record.vbid) {
+            index.back().numEntries += record.numEntries;
+            index.back().last = record.last;
+        } else {
+            index.push_back(record);
+        }
+    }
+    if (next != entriesEnd || numEntries != expectedEntries) {
+        throw MutationLog::ReadException(
+                "SortedAccessLogReader: '" + path +
+                "' entries do not match the index");
+    }
+    std::sort(index.begin(), index.end(), [](const auto& a, const auto& b) {
+        return a.vbid < b.vbid;
+    });
+    const auto duplicate = std::adjacent_find(
+            index.begin(), index.end(), [](const auto& a, const auto& b) {
+                return a.vbid == b.vbid;
+            });
+    if (duplicate != index.end()) {
+        throw MutationLog::ReadException(
+                "SortedAccessLogReader: '" + path + "' has runs of " +
+                duplicate->vbid.to_string() + " which are not consecutive");
+    }
+}
+
+std::vector<Vbid> SortedAccessLogReader::getVBuckets() const {
+    std::vector<Vbid> vbids;
+    vbids.reserve(index.size());
+    for (const auto& record : index) {
+        vbids.push_back(record.vbid);
+    }
+    return vbids;
+}
+
+SortedAccessLogReader::VBucketEntries SortedAccessLogReader::getEntries(
+        Vbid vbid) const {
+    auto it = std::lower_bound(
+            index.begin(), index.end(), vbid, [](const auto& rec, Vbid id) {
+                return rec.vbid < id;
+            });
+    if (it == index.end() || it->vbid != vbid) {
+        return {};
+    }
+    return {const_iterator(it->first), const_iterator(it->last), it->numEntries};
+}
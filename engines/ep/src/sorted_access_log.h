@@ -0,0 +1,250 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/**
+ * The sorted access log: an alternative on-disk format for the access log
+ * written by the AccessScanner and read by Warmup.
+ *
+ * The original format (see MutationLog) is a stream of CRC'd blocks holding
+ * keys in HashTable order, which warmup has to parse entry by entry and then
+ * fetch in batches whose keys are spread randomly over the data file. In this
+ * format each vBucket's keys are stored in one or more runs sorted by seqno -
+ * i.e. in the order they were appended to the vBucket's data file - so a
+ * batch of consecutive entries refers to a narrow range of the data file.
+ * The AccessScanner writes a run per chunk of the HashTable it visits, so it
+ * only needs to hold one chunk of keys in memory. The file is memory-mapped
+ * and read in place.
+ *
+ * Layout (all integers big-endian):
+ *
+ *   Header
+ *     magic        8 bytes   "cbalogs\0"
+ *     version      uint32
+ *     numRuns      uint32    Number of index records
+ *     numEntries   uint64    Total number of keys
+ *     indexOffset  uint64    Offset of the first index record
+ *     checksum     uint32    crc32c of everything after the header
+ *     reserved     uint32
+ *   Entries, for each run in seqno order
+ *     seqno        uint64
+ *     keyLen       uint16
+ *     key          keyLen bytes (DocKey, including the collection ID)
+ *   Index, one record per run in file order
+ *     vbid         uint16
+ *     reserved     uint16
+ *     numEntries   uint32
+ *     offset       uint64    Offset of the run's first entry
+ *
+ * The runs of a vBucket are consecutive in the file. Version 1 logs (written
+ * with a single run per vBucket and the index in vbid order) are still read.
+ */
+
+#pragma once
+
+#include "storeddockey.h"
+
+#include <folly/File.h>
+#include <folly/system/MemoryMapping.h>
+#include <memcached/dockey.h>
+#include <memcached/vbucket.h>
+
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace SortedAccessLog {
+
+constexpr uint32_t Version = 2;
+constexpr size_t HeaderSize = 40;
+constexpr size_t IndexRecordSize = 16;
+constexpr size_t EntryHeaderSize = 10;
+
+/**
+ * @returns true if the file at path exists and starts with the sorted access
+ *          log magic (i.e. should be read with a SortedAccessLogReader rather
+ *          than a MutationLog).
+ */
+bool isSortedAccessLog(const std::string& path);
+
+} // namespace SortedAccessLog
+
+/**
+ * Writes a sorted access log. vBuckets are added one at a time (in any
+ * order), each as one or more runs; the file is only valid once commit() has
+ * returned.
+ *
+ * Errors are reported by throwing MutationLog::WriteException.
+ */
+class SortedAccessLogWriter {
+public:
+    struct Entry {
+        uint64_t seqno;
+        StoredDocKey key;
+    };
+
+    /// Create (or truncate) the file at path.
+    explicit SortedAccessLogWriter(std::string path);
+
+    /**
+     * Append a run of the given vBucket's entries, sorting them by seqno (the
+     * vector is sorted in place). All the runs of a vBucket must be added
+     * before those of the next one.
+     */
+    void addRun(Vbid vbid, std::vector<Entry>& entries);
+
+    /// Write the index and header and sync the file to disk.
+    void commit();
+
+    size_t getNumEntries() const {
+        return numEntries;
+    }
+
+    const std::string& getPath() const {
+        return path;
+    }
+
+private:
+    struct IndexRecord {
+        Vbid vbid;
+        uint32_t numEntries;
+        uint64_t offset;
+    };
+
+    void write(const uint8_t* data, size_t len);
+
+    const std::string path;
+    folly::File file;
+    /// Records of the runs written so far, in file order.
+    std::vector<IndexRecord> index;
+    /// vBuckets which can have no more runs added.
+    std::set<Vbid> completed;
+    std::vector<uint8_t> buffer;
+    uint64_t offset;
+    size_t numEntries = 0;
+    uint32_t checksum;
+    bool committed = false;
+};
+
+/**
+ * Reads a sorted access log by memory-mapping it. The whole file is
+ * validated (magic, version, checksum and structure) on construction, so
+ * iterating it cannot fail.
+ *
+ * Errors are reported by throwing MutationLog::ReadException (or one of its
+ * subclasses).
+ */
+class SortedAccessLogReader {
+public:
+    /// A key in the log; key refers to the mapped file.
+    struct Entry {
+        uint64_t seqno;
+        DocKey key;
+    };
+
+    /// Iterates the entries of one vBucket, in seqno order.
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = Entry;
+
+        const_iterator() = default;
+
+        Entry operator*() const;
+
+        const_iterator& operator++();
+
+        bool operator==(const const_iterator& other) const {
+            return pos == other.pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return pos != other.pos;
+        }
+
+    private:
+        explicit const_iterator(const uint8_t* pos) : pos(pos) {
+        }
+
+        const uint8_t* pos = nullptr;
+
+        friend class SortedAccessLogReader;
+    };
+
+    /// The entries of one vBucket (in seqno order within each of its runs).
+    class VBucketEntries {
+    public:
+        const_iterator begin() const {
+            return first;
+        }
+
+        const_iterator end() const {
+            return last;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+    private:
+        VBucketEntries() = default;
+        VBucketEntries(const_iterator first, const_iterator last, size_t count)
+            : first(first), last(last), count(count) {
+        }
+
+        const_iterator first;
+        const_iterator last;
+        size_t count = 0;
+
+        friend class SortedAccessLogReader;
+    };
+
+    explicit SortedAccessLogReader(const std::string& path);
+
+    /// @returns the vBuckets present in the log, in vbid order.
+    std::vector<Vbid> getVBuckets() const;
+
+    /// @returns the entries for vbid (empty if it is not in the log).
+    VBucketEntries getEntries(Vbid vbid) const;
+
+    size_t getNumEntries() const {
+        return numEntries;
+    }
+
+private:
+    struct IndexRecord {
+        Vbid vbid;
+        uint32_t numEntries;
+        const uint8_t* first;
+        const uint8_t* last;
+    };
+
+    void validate(const std::string& path);
+
+    folly::MemoryMapping mapping;
+    /// One record per vBucket (spanning all of its runs), in vbid order.
+    std::vector<IndexRecord> index;
+    size_t numEntries = 0;
+};
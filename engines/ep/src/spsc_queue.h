@@ -0,0 +1,186 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/lang/Align.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Unbounded, lock-free, single-producer / single-consumer FIFO queue.
+ *
+ * Elements are stored in fixed-size segments which are linked together as the
+ * queue grows; a segment is freed by the consumer once it has popped every
+ * element in it. Slots are never re-used, so the producer and consumer only
+ * ever share the published element count.
+ *
+ * The producer adds elements in two steps: stage() appends an element which
+ * is not yet visible to the consumer, and publish() makes everything staged
+ * so far visible at once (a single release store). push() does both. This
+ * allows a producer to hand off a whole batch (e.g. a snapshot) with one
+ * synchronisation with the consumer.
+ *
+ * The queue itself does not enforce a single producer or a single consumer;
+ * the owner must serialise each side (e.g. by holding a producer lock /
+ * consumer lock, see Stream::readyQ).
+ *
+ * size() and empty() may be called from any thread; the result is
+ * approximate unless called by the consumer (where elements can only appear,
+ * not disappear) or the producer (the reverse).
+ */
+template <class T, size_t SegmentSlots = 64>
+class SPSCQueue {
+    static_assert(SegmentSlots > 0, "SPSCQueue: SegmentSlots must be non-zero");
+
+    struct Segment {
+        std::array<T, SegmentSlots> slots;
+        /// Written by the producer before publishing any element in the
+        /// next segment, so read by the consumer after an acquire load of
+        /// 'published'.
+        std::atomic<Segment*> next{nullptr};
+    };
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+
+    SPSCQueue() : head(new Segment), tail(head) {
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    ~SPSCQueue() {
+        while (head) {
+            delete std::exchange(head,
+                                 head->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    // Producer interface //////////////////////////////////////////////////
+
+    /// Append an element, and publish it (and anything staged before it).
+    void push(T value) {
+        stage(std::move(value));
+        publish();
+    }
+
+    /// Append an element without making it visible to the consumer.
+    void stage(T value) {
+        if (tailIndex == SegmentSlots) {
+            auto* segment = new Segment;
+            tail->next.store(segment, std::memory_order_relaxed);
+            tail = segment;
+            tailIndex = 0;
+        }
+        tail->slots[tailIndex++] = std::move(value);
+        ++staged;
+    }
+
+    /// Make all staged elements visible to the consumer.
+    void publish() {
+        published.store(staged, std::memory_order_release);
+    }
+
+    /// @returns the element most recently staged. The queue must not be empty
+    ///          and the element must not have been popped yet.
+    T& back() {
+        return tail->slots[tailIndex - 1];
+    }
+
+    const T& back() const {
+        return tail->slots[tailIndex - 1];
+    }
+
+    // Consumer interface //////////////////////////////////////////////////
+
+    /// @returns the oldest published element. The queue must not be empty.
+    T& front() {
+        return headSlot();
+    }
+
+    const T& front() const {
+        return const_cast<SPSCQueue*>(this)->headSlot();
+    }
+
+    /**
+     * Remove the oldest published element.
+     *
+     * @return the element, or a default-constructed T if nothing has been
+     *         published.
+     */
+    T pop() {
+        if (empty()) {
+            return T();
+        }
+        T value = std::move(headSlot());
+        ++headIndex;
+        consumed.store(consumed.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+        return value;
+    }
+
+    /// Pop all published elements.
+    void clear() {
+        while (!empty()) {
+            pop();
+        }
+    }
+
+    // Any thread ////////////////////////////////////////////////////////////
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /// @returns the number of published elements not yet popped.
+    size_type size() const {
+        // Read consumed first; both counters only increase and consumed can
+        // never pass published, so this cannot underflow.
+        const auto c = consumed.load(std::memory_order_acquire);
+        return published.load(std::memory_order_acquire) - c;
+    }
+
+private:
+    /// @returns the slot of the oldest element, moving onto the next segment
+    ///          (and freeing the current one) if the current one is used up.
+    T& headSlot() {
+        if (headIndex == SegmentSlots) {
+            // The producer has published an element beyond this segment,
+            // hence has linked the next one and will not touch this again.
+            delete std::exchange(head,
+                                 head->next.load(std::memory_order_relaxed));
+            headIndex = 0;
+        }
+        return head->slots[headIndex];
+    }
+
+    // Consumer state.
+    alignas(folly::hardware_destructive_interference_size) Segment* head;
+    size_t headIndex = 0;
+    std::atomic<size_t> consumed{0};
+
+    // Producer state.
+    alignas(folly::hardware_destructive_interference_size) Segment* tail;
+    size_t tailIndex = 0;
+    size_t staged = 0;
+    std::atomic<size_t> published{0};
+};
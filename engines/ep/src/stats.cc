@@ -86,6 +86,7 @@ EPStats::EPStats()
       bg_meta_fetched(0),
       numRemainingBgItems(0),
       numRemainingBgJobs(0),
+      numBgFetchesInFlight(0),
       bgNumOperations(0),
       bgWait(0),
       bgMinWait(0),
@@ -319,6 +320,7 @@ void EPStats::reset() {
     diskCommitHisto.reset();
     itemAllocSizeHisto.reset();
     getMultiBatchSizeHisto.reset();
+    bgFetchInFlightHisto.reset();
     dirtyAgeHisto.reset();
     getMultiHisto.reset();
     persistenceCursorGetItemsHisto.reset();
@@ -364,6 +366,7 @@ size_t EPStats::getMemFootPrint() const {
            diskCommitHisto.getMemFootPrint() +
            itemAllocSizeHisto.getMemFootPrint() +
            getMultiBatchSizeHisto.getMemFootPrint() +
+           bgFetchInFlightHisto.getMemFootPrint() +
            dirtyAgeHisto.getMemFootPrint() + getMultiHisto.getMemFootPrint() +
            persistenceCursorGetItemsHisto.getMemFootPrint() +
            dcpCursorsGetItemsHisto.getMemFootPrint() +
@@ -321,6 +321,8 @@ public:
     Counter numRemainingBgItems;
     //! Number of remaining bg fetch jobs.
     Counter numRemainingBgJobs;
+    //! Number of vBucket batches currently being read by the bg fetchers
+    Counter numBgFetchesInFlight;
     //! The number of samples the bgWaitDelta and bgLoadDelta contains of
     Counter bgNumOperations;
 
@@ -449,6 +451,12 @@ public:
      */
     Hdr1sfInt32Histogram getMultiBatchSizeHisto;
 
+    /**
+     * Histogram of the number of vBucket batches being read concurrently by
+     * the bg fetchers, sampled as each batch starts.
+     */
+    Hdr1sfInt32Histogram bgFetchInFlightHisto;
+
     /**
      * Histogram of frequency counts for items evicted from active or pending
      * vbuckets.
@@ -19,6 +19,7 @@
 #include "cb3_executorpool.h"
 #include "cb3_executorthread.h"
 
+#include <algorithm>
 #include <cmath>
 
 TaskQueue::TaskQueue(CB3ExecutorPool* m, task_type_t t, const char* nm)
@@ -35,8 +36,11 @@ const std::string TaskQueue::getName() const {
 }
 
 size_t TaskQueue::getReadyQueueSize() {
-    LockHolder lh(mutex);
-    return readyQueue.size();
+    size_t size = 0;
+    for (auto& runQueue : runQueues) {
+        size += runQueue.size.load();
+    }
+    return size;
 }
 
 size_t TaskQueue::getFutureQueueSize() {
@@ -44,11 +48,35 @@ size_t TaskQueue::getFutureQueueSize() {
     return futureQueue.size();
 }
 
-ExTask TaskQueue::_popReadyTask() {
-    ExTask t = readyQueue.top();
-    readyQueue.pop();
-    manager->lessWork(queueType);
-    return t;
+void TaskQueue::setNumRunQueues(size_t count) {
+    numRunQueues = std::min(std::max(count, size_t(1)), MaxRunQueues);
+}
+
+bool TaskQueue::_popRunQueueTask(CB3ExecutorThread& t) {
+    const auto home = t.runQueueIdx % numRunQueues.load();
+    // Own run queue first, then steal from the others.
+    for (size_t i = 0; i < MaxRunQueues; ++i) {
+        auto& runQueue = runQueues[(home + i) % MaxRunQueues];
+        if (runQueue.size.load() == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lh(runQueue.mutex);
+        if (runQueue.tasks.empty()) {
+            continue;
+        }
+        t.setCurrentTask(runQueue.tasks.top());
+        runQueue.tasks.pop();
+        runQueue.size.store(runQueue.tasks.size());
+        manager->lessWork(queueType);
+        return true;
+    }
+    return false;
+}
+
+void TaskQueue::snooze(ExTask& task, const double secs) {
+    LockHolder lh(mutex);
+    task->snooze(secs);
+    futureQueue.update(task, task->getWaketime());
 }
 
 void TaskQueue::doWake(size_t &numToWake) {
@@ -74,10 +102,8 @@ bool TaskQueue::_doSleep(CB3ExecutorThread& t,
     t.updateCurrentTime();
 
     // Determine the time point to wake this thread - either "forever" if the
-    // futureQueue is empty, or the earliest wake time in the futureQueue.
-    const auto wakeTime = futureQueue.empty()
-                                  ? std::chrono::steady_clock::time_point::max()
-                                  : futureQueue.top()->getWaketime();
+    // futureQueue is empty, or when the earliest task in it may be due.
+    const auto wakeTime = futureQueue.nextExpiry();
 
     if (t.getCurTime() < wakeTime && manager->trySleep(queueType)) {
         // Atomically switch from running to sleeping; iff we were previously
@@ -122,24 +148,21 @@ bool TaskQueue::_sleepThenFetchNextTask(CB3ExecutorThread& t) {
 }
 
 bool TaskQueue::_fetchNextTask(CB3ExecutorThread& t) {
+    // Only if there are no ready tasks do we need the futureQueue (and hence
+    // the queue-wide mutex).
+    if (_popRunQueueTask(t)) {
+        return true;
+    }
     std::unique_lock<std::mutex> lh(mutex);
     return _fetchNextTaskInner(t, lh);
 }
 
 bool TaskQueue::_fetchNextTaskInner(CB3ExecutorThread& t,
                                     const std::unique_lock<std::mutex>&) {
-    bool ret = false;
-
-    size_t numToWake = _moveReadyTasks(t.getCurTime());
-
-    if (!readyQueue.empty() && readyQueue.top()->isdead()) {
-        t.setCurrentTask(_popReadyTask()); // clean out dead tasks first
-        ret = true;
-    } else if (!readyQueue.empty()) {
-        ExTask tid = _popReadyTask(); // and pop out the top task
-        t.setCurrentTask(tid);
-        ret = true;
-    } else {
+    size_t numToWake = _moveReadyTasks(t);
+
+    const bool ret = _popRunQueueTask(t);
+    if (!ret) {
         numToWake = numToWake ? numToWake - 1 : 0; // 1 fewer task ready
     }
 
@@ -157,35 +180,55 @@ bool TaskQueue::sleepThenFetchNextTask(CB3ExecutorThread& thread) {
     return _sleepThenFetchNextTask(thread);
 }
 
-size_t TaskQueue::_moveReadyTasks(
-        const std::chrono::steady_clock::time_point tv) {
-    if (!readyQueue.empty()) {
-        return 0;
-    }
-
-    size_t numReady = 0;
-    while (!futureQueue.empty()) {
-        ExTask tid = futureQueue.top();
-        if (tid->getWaketime() <= tv) {
-            futureQueue.pop();
-            readyQueue.push(tid);
-            numReady++;
+size_t TaskQueue::_moveReadyTasks(CB3ExecutorThread& t) {
+    const auto now = t.getCurTime();
+    std::vector<ExTask> ready;
+    std::vector<ExTask> resnoozed;
+    futureQueue.advance(now, [now, &ready, &resnoozed](ExTask&& task) {
+        // GlobalTask::snooze() may have been called directly on the task
+        // (rather than via ExecutorPool::snooze()) after it was queued.
+        if (task->getWaketime() > now) {
+            resnoozed.push_back(std::move(task));
         } else {
-            break;
+            ready.push_back(std::move(task));
         }
+    });
+    for (auto& task : resnoozed) {
+        futureQueue.schedule(task, task->getWaketime());
     }
 
-    manager->addWork(numReady, queueType);
+    if (ready.empty()) {
+        return 0;
+    }
+
+    // Accounted before the tasks become visible to other threads, which may
+    // take them straight away.
+    manager->addWork(ready.size(), queueType);
+
+    // Deal the tasks out over the run queues in priority order (earliest
+    // waketime first within a priority), starting with the calling thread's
+    // own run queue so it gets the most important task.
+    std::sort(ready.begin(), ready.end(), [](ExTask& a, ExTask& b) {
+        return CompareByPriority()(b, a);
+    });
+    const auto count = numRunQueues.load();
+    const auto home = t.runQueueIdx % count;
+    for (size_t i = 0; i < ready.size(); ++i) {
+        auto& runQueue = runQueues[(home + i) % count];
+        std::lock_guard<std::mutex> lh(runQueue.mutex);
+        runQueue.tasks.push(std::move(ready[i]));
+        runQueue.size.store(runQueue.tasks.size());
+    }
 
     // Current thread will pop one task, so wake up one less thread
-    return numReady ? numReady - 1 : 0;
+    return ready.size() - 1;
 }
 
 std::chrono::steady_clock::time_point TaskQueue::_reschedule(ExTask& task) {
     LockHolder lh(mutex);
 
-    futureQueue.push(task);
-    return futureQueue.top()->getWaketime();
+    futureQueue.schedule(task, task->getWaketime());
+    return futureQueue.nextExpiry();
 }
 
 std::chrono::steady_clock::time_point TaskQueue::reschedule(ExTask& task) {
@@ -205,7 +248,7 @@ void TaskQueue::_schedule(ExTask &task) {
         // the task state to the initial value of running.
         task->setState(TASK_RUNNING, TASK_DEAD);
 
-        futureQueue.push(task);
+        futureQueue.schedule(task, task->getWaketime());
 
         EP_LOG_TRACE("{}: Schedule a task \"{}\" id {}",
                      name,
@@ -238,7 +281,8 @@ void TaskQueue::_wake(ExTask &task) {
                      task->getDescription(),
                      task->getId());
 
-        futureQueue.updateWaketime(task, now);
+        task->updateWaketime(now);
+        futureQueue.update(task, now);
         task->setState(TASK_RUNNING, TASK_SNOOZED);
 
         _doWake_UNLOCKED(readyCount);
@@ -15,10 +15,15 @@
  */
 #pragma once
 
-#include "futurequeue.h"
+#include "globaltask.h"
 #include "syncobject.h"
 #include "task_type.h"
+#include "timer_wheel.h"
 
+#include <folly/lang/Align.h>
+
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <list>
 #include <queue>
@@ -26,22 +31,37 @@
 class CB3ExecutorPool;
 class CB3ExecutorThread;
 
+/**
+ * The queue of tasks of one task type (and bucket priority).
+ *
+ * Snoozed tasks wait in the futureQueue - a timer wheel keyed by task, so
+ * snoozing or waking a task is O(1) - guarded by `mutex`. Once due they are
+ * moved (in batches) onto the run queues, from which worker threads take
+ * the tasks to run. Each worker has a home run queue (see
+ * CB3ExecutorThread::runQueueIdx) and only steals from the other run queues
+ * when its own is empty; this avoids all the workers of a type contending on
+ * the same lock for every task they run. Ready tasks are ordered by task
+ * priority within each run queue.
+ */
 class TaskQueue {
     friend class CB3ExecutorPool;
 
 public:
+    /// Upper bound on the number of run queues of a TaskQueue.
+    static constexpr size_t MaxRunQueues = 32;
+
     TaskQueue(CB3ExecutorPool* m, task_type_t t, const char* nm);
     ~TaskQueue();
 
     void schedule(ExTask &task);
 
     /**
-     * Reschedules the given task, adding it onto the futureQueue (sorted by
-     * each task's waketime.
+     * Reschedules the given task, adding it onto the futureQueue (to be
+     * made ready at its waketime).
      *
      * @param task Task to reschedule.
-     * @return The waketime of the earliest (next) task in the futureQueue -
-     *         note this isn't necessarily the same as `task`.
+     * @return The earliest time at which a task in the futureQueue may be
+     *         due - note this isn't necessarily the waketime of `task`.
      */
     std::chrono::steady_clock::time_point reschedule(ExTask& task);
 
@@ -75,9 +95,14 @@ public:
 
     size_t getFutureQueueSize();
 
-    void snooze(ExTask& task, const double secs) {
-        futureQueue.snooze(task, secs);
-    }
+    void snooze(ExTask& task, const double secs);
+
+    /**
+     * Set the number of run queues ready tasks are spread over; normally the
+     * number of worker threads of this queue's type (clamped to
+     * [1, MaxRunQueues]).
+     */
+    void setNumRunQueues(size_t count);
 
 private:
     void _schedule(ExTask &task);
@@ -90,8 +115,15 @@ private:
     bool _doSleep(CB3ExecutorThread& thread,
                   std::unique_lock<std::mutex>& lock);
     void _doWake_UNLOCKED(size_t &numToWake);
-    size_t _moveReadyTasks(const std::chrono::steady_clock::time_point tv);
-    ExTask _popReadyTask();
+    size_t _moveReadyTasks(CB3ExecutorThread& t);
+
+    /**
+     * Take the next task to run from the thread's home run queue, or steal it
+     * from another run queue if that is empty, updating
+     * thread::currentTask.
+     * @returns true if a task was found.
+     */
+    bool _popRunQueueTask(CB3ExecutorThread& t);
 
     SyncObject mutex;
     const std::string name;
@@ -99,10 +131,21 @@ private:
     CB3ExecutorPool* manager;
     size_t sleepers; // number of threads sleeping in this taskQueue
 
-    // sorted by task priority.
-    std::priority_queue<ExTask, std::deque<ExTask>,
-                        CompareByPriority> readyQueue;
+    struct alignas(folly::hardware_destructive_interference_size) RunQueue {
+        std::mutex mutex;
+        // sorted by task priority. Guarded by `mutex`.
+        std::priority_queue<ExTask, std::deque<ExTask>, CompareByPriority>
+                tasks;
+        // tasks.size(), readable without the mutex to skip empty queues.
+        std::atomic<size_t> size{0};
+    };
+
+    std::array<RunQueue, MaxRunQueues> runQueues;
+
+    // Number of runQueues which tasks are currently spread over. Any queue
+    // beyond this (after a reduction) is drained by stealing.
+    std::atomic<size_t> numRunQueues{1};
 
-    // sorted by waketime. Guarded by `mutex`.
-    FutureQueue<> futureQueue;
+    // Snoozed tasks, by waketime. Guarded by `mutex`.
+    TimerWheel<ExTask> futureQueue;
 };
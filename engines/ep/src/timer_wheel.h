@@ -0,0 +1,345 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * A hashed, hierarchical timer wheel: a set of unique keys, each with a
+ * deadline, from which the keys whose deadline has passed can be taken.
+ *
+ * Time is divided into ticks of a fixed resolution. The wheel has Levels
+ * levels of 256 slots each; a slot at level L covers 256^L ticks. A timer is
+ * placed in the lowest level whose range covers its deadline and is moved
+ * ("cascaded") down a level each time the wheel turns onto its slot, until it
+ * reaches level 0 where it fires. Deadlines beyond the range of the top level
+ * are parked in the top level's last slot and re-placed whenever it cascades.
+ *
+ * Compared to a binary heap ordered by deadline:
+ * - schedule(), cancel() and changing a deadline are O(1) (plus a hash
+ *   lookup) instead of O(log n) - or O(n) for a re-heapify;
+ * - advance() costs O(1) per tick elapsed (stretches with nothing to fire or
+ *   cascade are skipped) plus O(1) per timer fired or cascaded.
+ *
+ * Deadlines are exact: a timer only fires once `now` has reached its
+ * deadline, the tick resolution only determines how timers are bucketed.
+ * Timers which fire in the same call are passed out in tick order, but
+ * not sorted within a tick.
+ *
+ * Not thread-safe; the owner must serialise access.
+ */
+template <class Key,
+          class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>,
+          size_t Levels = 4>
+class TimerWheel {
+    static_assert(Levels > 0 && Levels <= 7,
+                  "TimerWheel: Levels must be in the range [1, 7]");
+
+public:
+    using clock = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+
+    /**
+     * @param resolution Length of one tick.
+     * @param start Time of tick zero; deadlines before it are treated as
+     *        already due.
+     */
+    explicit TimerWheel(
+            std::chrono::nanoseconds resolution = std::chrono::milliseconds(1),
+            time_point start = clock::now())
+        : resolution(resolution), origin(start) {
+        slots.fill(nullptr);
+        levelSizes.fill(0);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * Add a timer for key, or move the existing timer for key to the new
+     * deadline.
+     *
+     * @return true if a timer was added, false if an existing one was moved.
+     */
+    bool schedule(const Key& key, time_point deadline) {
+        auto result = timers.try_emplace(key);
+        auto& node = *result.first;
+        if (!result.second) {
+            unlink(node);
+        }
+        node.second.deadline = deadline;
+        insert(node);
+        return result.second;
+    }
+
+    /**
+     * Move the timer for key (if there is one) to the new deadline.
+     *
+     * @return true if key has a timer.
+     */
+    bool update(const Key& key, time_point deadline) {
+        auto it = timers.find(key);
+        if (it == timers.end()) {
+            return false;
+        }
+        unlink(*it);
+        it->second.deadline = deadline;
+        insert(*it);
+        return true;
+    }
+
+    /**
+     * Remove the timer for key (if there is one).
+     *
+     * @return true if key had a timer.
+     */
+    bool cancel(const Key& key) {
+        auto it = timers.find(key);
+        if (it == timers.end()) {
+            return false;
+        }
+        unlink(*it);
+        timers.erase(it);
+        return true;
+    }
+
+    bool contains(const Key& key) const {
+        return timers.count(key) != 0;
+    }
+
+    size_t size() const {
+        return timers.size();
+    }
+
+    bool empty() const {
+        return timers.empty();
+    }
+
+    /**
+     * Remove every timer whose deadline is at or before now, passing each
+     * one's key to the callback. The callback must not modify the wheel.
+     *
+     * @param now The current time. May be earlier than a previous call's (for
+     *        example if the caller uses a cached time), in which case only
+     *        timers which are due as of now fire.
+     * @param fn Callable invoked as fn(Key&&) for each fired timer.
+     * @return the number of timers fired.
+     */
+    template <class Fn>
+    size_t advance(time_point now, Fn&& fn) {
+        std::vector<Node*> fired;
+        const auto target = toTick(now);
+        while (nextTick < target) {
+            if (levelSizes[0] == 0) {
+                // Nothing can fire before the lowest non-empty level next
+                // cascades; skip straight to it.
+                size_t level = 1;
+                while (level < Levels && levelSizes[level] == 0) {
+                    ++level;
+                }
+                if (level == Levels) {
+                    nextTick = target;
+                    break;
+                }
+                const auto mask = (uint64_t(1) << (level * SlotBits)) - 1;
+                if ((nextTick & mask) != 0 || cascadedTick == nextTick) {
+                    nextTick = std::min(target, (nextTick | mask) + 1);
+                    continue;
+                }
+            }
+            processTick(now, fired);
+            ++nextTick;
+        }
+        // The current tick may only be partly due; it is processed again
+        // (for the timers still pending) on the next call.
+        processTick(now, fired);
+
+        for (auto* node : fired) {
+            auto handle = timers.extract(node->first);
+            fn(std::move(handle.key()));
+        }
+        return fired.size();
+    }
+
+    /**
+     * @return a time at or before the earliest deadline, at which advance()
+     *         next has work to do - either the earliest deadline itself, or
+     *         the time at which a higher level next cascades. time_point::max()
+     *         if there are no timers.
+     */
+    time_point nextExpiry() const {
+        auto result = time_point::max();
+        if (levelSizes[0] != 0) {
+            // All level 0 timers are within SlotsPerLevel ticks, so the first
+            // non-empty slot holds the earliest.
+            for (size_t i = 0; i < SlotsPerLevel; ++i) {
+                const auto* head = slots[(nextTick + i) & SlotMask];
+                if (head) {
+                    for (auto* node = head; node; node = node->second.next) {
+                        result = std::min(result, node->second.deadline);
+                    }
+                    break;
+                }
+            }
+        }
+        for (size_t level = 1; level < Levels; ++level) {
+            if (levelSizes[level] == 0) {
+                continue;
+            }
+            // Timers at this level (or above) fire no earlier than its next
+            // cascade.
+            const auto shift = level * SlotBits;
+            uint64_t boundary = ((nextTick >> shift) + 1) << shift;
+            if (cascadedTick != nextTick &&
+                (nextTick & ((uint64_t(1) << shift) - 1)) == 0) {
+                boundary = nextTick;
+            }
+            result = std::min(result, toTimePoint(boundary));
+            break;
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t SlotBits = 8;
+    static constexpr size_t SlotsPerLevel = size_t(1) << SlotBits;
+    static constexpr uint64_t SlotMask = SlotsPerLevel - 1;
+
+    struct Timer;
+    using Map = std::unordered_map<Key, Timer, Hash, KeyEqual>;
+    // Map nodes are never moved by rehashing, so can be linked together.
+    using Node = typename Map::value_type;
+
+    struct Timer {
+        time_point deadline;
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        // Index into slots of the list this timer is on.
+        uint32_t slot = 0;
+    };
+
+    uint64_t toTick(time_point tp) const {
+        if (tp <= origin) {
+            return 0;
+        }
+        return uint64_t((tp - origin) / resolution);
+    }
+
+    time_point toTimePoint(uint64_t tick) const {
+        return origin + resolution * int64_t(tick);
+    }
+
+    /// Place node in the slot for its deadline, relative to nextTick.
+    void insert(Node& node) {
+        // Overdue timers go in the next slot to be processed.
+        const auto tick = std::max(toTick(node.second.deadline), nextTick);
+        const auto delta = tick - nextTick;
+
+        size_t level = 0;
+        while (level < Levels - 1 &&
+               delta >= (uint64_t(1) << ((level + 1) * SlotBits))) {
+            ++level;
+        }
+        const auto shift = level * SlotBits;
+        uint64_t index = (tick >> shift) & SlotMask;
+        if (level == Levels - 1 &&
+            delta >= (uint64_t(1) << (Levels * SlotBits))) {
+            // Out of range; park in the slot which cascades last.
+            index = ((nextTick >> shift) + SlotMask) & SlotMask;
+        }
+
+        auto& timer = node.second;
+        timer.slot = uint32_t(level * SlotsPerLevel + index);
+        timer.prev = nullptr;
+        timer.next = slots[timer.slot];
+        if (timer.next) {
+            timer.next->second.prev = &node;
+        }
+        slots[timer.slot] = &node;
+        ++levelSizes[level];
+    }
+
+    void unlink(Node& node) {
+        auto& timer = node.second;
+        if (timer.prev) {
+            timer.prev->second.next = timer.next;
+        } else {
+            slots[timer.slot] = timer.next;
+        }
+        if (timer.next) {
+            timer.next->second.prev = timer.prev;
+        }
+        --levelSizes[timer.slot / SlotsPerLevel];
+    }
+
+    /**
+     * Cascade the higher levels onto nextTick (once per tick), then move all
+     * timers in nextTick's level 0 slot which are due as of now into fired.
+     */
+    void processTick(time_point now, std::vector<Node*>& fired) {
+        if (cascadedTick != nextTick) {
+            cascadedTick = nextTick;
+            for (size_t level = 1; level < Levels; ++level) {
+                const auto shift = level * SlotBits;
+                if ((nextTick & ((uint64_t(1) << shift) - 1)) != 0) {
+                    break;
+                }
+                const auto slot =
+                        level * SlotsPerLevel + ((nextTick >> shift) & SlotMask);
+                auto* node = std::exchange(slots[slot], nullptr);
+                while (node) {
+                    auto* next = node->second.next;
+                    --levelSizes[level];
+                    insert(*node);
+                    node = next;
+                }
+            }
+        }
+
+        auto* node = slots[nextTick & SlotMask];
+        while (node) {
+            auto* next = node->second.next;
+            if (node->second.deadline <= now) {
+                unlink(*node);
+                fired.push_back(node);
+            }
+            node = next;
+        }
+    }
+
+    const std::chrono::nanoseconds resolution;
+    const time_point origin;
+
+    Map timers;
+    std::array<Node*, Levels * SlotsPerLevel> slots;
+    std::array<size_t, Levels> levelSizes;
+
+    // The next tick to be processed; every timer with an earlier tick has
+    // fired.
+    uint64_t nextTick = 0;
+    // The last tick for which the higher levels were cascaded.
+    uint64_t cascadedTick = 0;
+};
@@ -697,6 +697,14 @@ void VBucket::notifySyncWritesPendingCompletion() {
     syncWriteResolvedCb(getId());
 }
 
+void VBucket::setSyncWriteTimeout(
+        int64_t seqno,
+        std::optional<std::chrono::steady_clock::time_point> deadline) {
+    if (syncWriteTimeoutCb) {
+        syncWriteTimeoutCb(getId(), seqno, deadline);
+    }
+}
+
 void VBucket::processResolvedSyncWrites() {
     // Acquire shared access on stateLock as need to ensure the vbucket is
     // active (and we have an ActiveDM).
@@ -1069,27 +1077,31 @@ bool VBucket::isResidentRatioUnderThreshold(float threshold) {
     }
 }
 
-void VBucket::createFilter(size_t key_count, double probability) {
+void VBucket::createFilter(size_t key_count,
+                           double probability,
+                           BloomFilter::Type type) {
     // Create the actual bloom filter upon vbucket creation during
     // scenarios:
     //      - Bucket creation
     //      - Rebalance
     LockHolder lh(bfMutex);
     if (bFilter == nullptr && tempFilter == nullptr) {
-        bFilter = std::make_unique<BloomFilter>(key_count, probability,
-                                        BFILTER_ENABLED);
+        bFilter = std::make_unique<BloomFilter>(
+                key_count, probability, BFILTER_ENABLED, type);
     } else {
         EP_LOG_WARN("({}) Bloom filter / Temp filter already exist!", id);
     }
 }
 
-void VBucket::initTempFilter(size_t key_count, double probability) {
+void VBucket::initTempFilter(size_t key_count,
+                             double probability,
+                             BloomFilter::Type type) {
     // Create a temp bloom filter with status as COMPACTING,
     // if the main filter is found to exist, set its state to
     // COMPACTING as well.
     LockHolder lh(bfMutex);
-    tempFilter = std::make_unique<BloomFilter>(key_count, probability,
-                                     BFILTER_COMPACTING);
+    tempFilter = std::make_unique<BloomFilter>(
+            key_count, probability, BFILTER_COMPACTING, type);
     if (bFilter) {
         bFilter->setStatus(BFILTER_COMPACTING);
     }
@@ -3987,6 +3999,10 @@ void VBucket::setFreqSaturatedCallback(std::function<void()> callbackFunction) {
     ht.setFreqSaturatedCallback(callbackFunction);
 }
 
+void VBucket::setSyncWriteTimeoutCallback(SyncWriteTimeoutCallback callback) {
+    syncWriteTimeoutCb = std::move(callback);
+}
+
 ENGINE_ERROR_CODE VBucket::checkDurabilityRequirements(const Item& item) {
     if (item.isPending()) {
         return checkDurabilityRequirements(item.getDurabilityReqs());
@@ -21,12 +21,14 @@
 #include "checkpoint_types.h"
 #include "collections/collections_types.h"
 #include "dcp/dcp-types.h"
+#include "eviction_pool.h"
 #include "hash_table.h"
 #include "hlc.h"
 #include "monotonic.h"
 #include "vbucket_fwd.h"
 #include "vbucket_notify_context.h"
 
+#include <folly/Synchronized.h>
 #include <folly/SynchronizedPtr.h>
 #include <memcached/engine.h>
 #include <nlohmann/json_fwd.hpp>
@@ -129,6 +131,18 @@ using SeqnoAckCallback = std::function<void(Vbid vbid, int64_t seqno)>;
 /// Instance of SeqnoAckCallback which does nothing.
 const SeqnoAckCallback NoopSeqnoAckCb = [](Vbid vbid, int64_t seqno) {};
 
+/**
+ * Callback function invoked by the ActiveDurabilityMonitor to set the time at
+ * which a tracked SyncWrite (identified by its prepare seqno) times out, or -
+ * with no deadline - to cancel the timeout once the SyncWrite has completed.
+ *
+ * Will normally register the deadline with the DurabilityTimeoutTask.
+ */
+using SyncWriteTimeoutCallback = std::function<void(
+        Vbid vbid,
+        int64_t seqno,
+        std::optional<std::chrono::steady_clock::time_point> deadline)>;
+
 class EventuallyPersistentEngine;
 class FailoverTable;
 class KVShard;
@@ -438,6 +452,14 @@ public:
 
     void notifySyncWritesPendingCompletion();
 
+    /**
+     * Set (or with no deadline, cancel) the timeout of the SyncWrite with the
+     * given prepare seqno. Called by the ActiveDurabilityMonitor.
+     */
+    void setSyncWriteTimeout(
+            int64_t seqno,
+            std::optional<std::chrono::steady_clock::time_point> deadline);
+
     /**
      * For all SyncWrites which the DurabilityMonitor has resolved (to be
      * committed or aborted), perform the appropriate operation - i.e.
@@ -653,8 +675,13 @@ public:
     /**
      * BloomFilter operations for vbucket
      */
-    void createFilter(size_t key_count, double probability);
-    void initTempFilter(size_t key_count, double probability);
+    void createFilter(
+            size_t key_count,
+            double probability,
+            BloomFilter::Type type = BloomFilter::Type::Bitset);
+    void initTempFilter(size_t key_count,
+                        double probability,
+                        BloomFilter::Type type = BloomFilter::Type::Bitset);
     void addToFilter(const DocKey& key);
     virtual bool maybeKeyExistsInFilter(const DocKey& key);
     bool isTempFilterAvailable();
@@ -839,6 +866,10 @@ public:
     /// Manager of this vBucket's checkpoints. unique_ptr for pimpl.
     std::unique_ptr<CheckpointManager> checkpointManager;
 
+    /// Candidates for eviction by the ItemPager when using the sampled_lru
+    /// ht_eviction_policy.
+    folly::Synchronized<EvictionPool, std::mutex> evictionPool;
+
     /**
      * Searches for a 'valid' StoredValue in the VBucket.
      *
@@ -1507,6 +1538,13 @@ public:
      */
     void setFreqSaturatedCallback(std::function<void()> callbackFunction);
 
+    /**
+     * Sets the callback function to invoke to set / cancel the timeout of
+     * a SyncWrite tracked by this VBucket. Must be set before any SyncWrite
+     * is tracked.
+     */
+    void setSyncWriteTimeoutCallback(SyncWriteTimeoutCallback callback);
+
     /**
      * Returns the number of deletes in the memory
      *
@@ -2499,6 +2537,13 @@ private:
      */
     SeqnoAckCallback seqnoAckCb;
 
+    /**
+     * Callback invoked by the ActiveDurabilityMonitor to set / cancel
+     * SyncWrite timeouts. If unset, SyncWrites only time out when
+     * processDurabilityTimeout() is called.
+     */
+    SyncWriteTimeoutCallback syncWriteTimeoutCb;
+
     /// The VBucket collection state
     std::unique_ptr<Collections::VB::Manifest> manifest;
 
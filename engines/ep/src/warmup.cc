@@ -32,6 +32,7 @@
 #include "item.h"
 #include "kvstore.h"
 #include "mutation_log.h"
+#include "sorted_access_log.h"
 #include "statistics/collector.h"
 #include "vb_visitors.h"
 #include "vbucket_bgfetch_item.h"
@@ -43,6 +44,7 @@
 #include <utilities/logtags.h>
 
 #include <array>
+#include <climits>
 #include <limits>
 #include <memory>
 #include <random>
@@ -127,6 +129,57 @@ private:
     WarmupState::State warmupState;
 };
 
+/**
+ * Scan callback for the per-vBucket phases which load items: collects the
+ * items read into batches of warmup_batch_size, which are queued for the
+ * WarmupInsert tasks to insert into the HashTable - so that the next batch
+ * can be read from disk while the previous one is being inserted. If the
+ * queue is full the batch is inserted directly (bounding how far reads can
+ * get ahead of inserts, and how much memory they can hold).
+ */
+class WarmupBatchingCallback : public StatusCallback<GetValue> {
+public:
+    WarmupBatchingCallback(EPBucket& ep,
+                           Warmup& warmup,
+                           bool maybeEnableTraffic)
+        : warmup(warmup),
+          batchSize(warmup.config.getWarmupBatchSize()),
+          batch(std::make_unique<WarmupBatch>()),
+          loadCallback(ep, maybeEnableTraffic, warmup.state.getState()) {
+    }
+
+    void callback(GetValue& val) override {
+        if (!warmup.phaseStopped) {
+            batch->push_back(std::move(val));
+            if (batch->size() >= batchSize) {
+                flush();
+            }
+        }
+        // Once the phase has been stopped (memory or item threshold reached)
+        // return ENGINE_ENOMEM to cancel the rest of the scan.
+        setStatus(warmup.phaseStopped ? ENGINE_ENOMEM : ENGINE_SUCCESS);
+    }
+
+    /// Queue (or insert) the items collected so far.
+    void flush() {
+        if (batch->empty()) {
+            return;
+        }
+        if (warmup.queueBatch(batch)) {
+            batch = std::make_unique<WarmupBatch>();
+        } else {
+            warmup.insertBatch(*batch, loadCallback);
+        }
+    }
+
+private:
+    Warmup& warmup;
+    const size_t batchSize;
+    std::unique_ptr<WarmupBatch> batch;
+    /// Used to insert batches directly when the queue is full.
+    LoadStorageKVPairCallback loadCallback;
+};
+
 // Warmup Tasks ///////////////////////////////////////////////////////////////
 
 class WarmupInitialize : public GlobalTask {
@@ -264,18 +317,19 @@ private:
 
 /**
  * Warmup task which loads any prepared SyncWrites which are not yet marked
- * as Committed (or Aborted) from disk.
+ * as Committed (or Aborted) from disk, one vBucket per run.
  */
 class WarmupLoadPreparedSyncWrites : public GlobalTask {
 public:
     WarmupLoadPreparedSyncWrites(EventuallyPersistentEngine* engine,
-                                 uint16_t shard,
+                                 uint16_t index,
                                  Warmup& warmup)
         : GlobalTask(engine, TaskId::WarmupLoadPreparedSyncWrites, 0, false),
-          shardId(shard),
           warmup(warmup),
-          description("Warmup - loading prepared SyncWrites: shard " +
-                      std::to_string(shardId)){};
+          description("Warmup - loading prepared SyncWrites: task " +
+                      std::to_string(index)) {
+        warmup.addToTaskSet(uid);
+    }
 
     std::string getDescription() override {
         return description;
@@ -283,24 +337,28 @@ public:
 
     std::chrono::microseconds maxExpectedDuration() override {
         // Runtime is a function of how many prepared sync writes exist in the
-        // buckets for this shard - can be minutes in large datasets.
+        // vBucket - can be minutes in large datasets.
         // Given this large variation; set max duration to a "way out" value
         // which we don't expect to see.
         return std::chrono::minutes(10);
     }
 
     bool run() override {
-        TRACE_EVENT1("ep-engine/task",
-                     "WarmupLoadPreparedSyncWrites",
-                     "shard",
-                     shardId);
-        warmup.loadPreparedSyncWrites(shardId);
+        auto vbid = warmup.claimNextVBucket();
+        if (vbid) {
+            TRACE_EVENT1("ep-engine/task",
+                         "WarmupLoadPreparedSyncWrites",
+                         "vb",
+                         vbid->get());
+            warmup.loadPreparedSyncWrites(*vbid);
+            return true;
+        }
         warmup.removeFromTaskSet(uid);
+        warmup.scanTaskComplete();
         return false;
     }
 
 private:
-    uint16_t shardId;
     Warmup& warmup;
     const std::string description;
 };
@@ -344,13 +402,16 @@ private:
     const std::string description;
 };
 
+/**
+ * [Value-eviction only] Warmup task which loads the keys of one vBucket per
+ * run.
+ */
 class WarmupKeyDump : public GlobalTask {
 public:
-    WarmupKeyDump(EPBucket& st, uint16_t sh, Warmup* w)
+    WarmupKeyDump(EPBucket& st, uint16_t index, Warmup* w)
         : GlobalTask(&st.getEPEngine(), TaskId::WarmupKeyDump, 0, false),
-          _shardId(sh),
           _warmup(w),
-          _description("Warmup - key dump: shard " + std::to_string(_shardId)) {
+          _description("Warmup - key dump: task " + std::to_string(index)) {
         _warmup->addToTaskSet(uid);
     }
 
@@ -359,7 +420,7 @@ public:
     }
 
     std::chrono::microseconds maxExpectedDuration() override {
-        // Runtime is a function of the number of keys in the database; can be
+        // Runtime is a function of the number of keys in the vBucket; can be
         // many minutes in large datasets.
         // Given this large variation; set max duration to a "way out" value
         // which we don't expect to see.
@@ -367,14 +428,18 @@ public:
     }
 
     bool run() override {
-        TRACE_EVENT1("ep-engine/task", "WarmupKeyDump", "shard", _shardId);
-        _warmup->keyDumpforShard(_shardId);
+        auto vbid = _warmup->claimNextVBucket();
+        if (vbid) {
+            TRACE_EVENT1("ep-engine/task", "WarmupKeyDump", "vb", vbid->get());
+            _warmup->keyDumpForVBucket(*vbid);
+            return true;
+        }
         _warmup->removeFromTaskSet(uid);
+        _warmup->scanTaskComplete();
         return false;
     }
 
 private:
-    uint16_t _shardId;
     Warmup* _warmup;
     const std::string _description;
 };
@@ -446,14 +511,17 @@ private:
     const std::string _description;
 };
 
+/**
+ * [Full-eviction only] Warmup task which loads the keys and values of one
+ * vBucket per run.
+ */
 class WarmupLoadingKVPairs : public GlobalTask {
 public:
-    WarmupLoadingKVPairs(EPBucket& st, uint16_t sh, Warmup* w)
+    WarmupLoadingKVPairs(EPBucket& st, uint16_t index, Warmup* w)
         : GlobalTask(&st.getEPEngine(), TaskId::WarmupLoadingKVPairs, 0, false),
-          _shardId(sh),
           _warmup(w),
-          _description("Warmup - loading KV Pairs: shard " +
-                       std::to_string(_shardId)) {
+          _description("Warmup - loading KV Pairs: task " +
+                       std::to_string(index)) {
         _warmup->addToTaskSet(uid);
     }
 
@@ -471,26 +539,33 @@ public:
     }
 
     bool run() override {
-        TRACE_EVENT0("ep-engine/task", "WarmupLoadingKVPairs");
-        _warmup->loadKVPairsforShard(_shardId);
+        auto vbid = _warmup->claimNextVBucket();
+        if (vbid) {
+            TRACE_EVENT1(
+                    "ep-engine/task", "WarmupLoadingKVPairs", "vb", vbid->get());
+            _warmup->loadKVPairsForVBucket(*vbid);
+            return true;
+        }
         _warmup->removeFromTaskSet(uid);
+        _warmup->scanTaskComplete();
         return false;
     }
 
 private:
-    uint16_t _shardId;
     Warmup* _warmup;
     const std::string _description;
 };
 
+/**
+ * Warmup task which loads the values of one vBucket per run.
+ */
 class WarmupLoadingData : public GlobalTask {
 public:
-    WarmupLoadingData(EPBucket& st, uint16_t sh, Warmup* w)
+    WarmupLoadingData(EPBucket& st, uint16_t index, Warmup* w)
         : GlobalTask(&st.getEPEngine(), TaskId::WarmupLoadingData, 0, false),
-          _shardId(sh),
           _warmup(w),
-          _description("Warmup - loading data: shard " +
-                       std::to_string(_shardId)) {
+          _description("Warmup - loading data: task " +
+                       std::to_string(index)) {
         _warmup->addToTaskSet(uid);
     }
 
@@ -508,18 +583,67 @@ public:
     }
 
     bool run() override {
-        TRACE_EVENT0("ep-engine/task", "WarmupLoadingData");
-        _warmup->loadDataforShard(_shardId);
+        auto vbid = _warmup->claimNextVBucket();
+        if (vbid) {
+            TRACE_EVENT1(
+                    "ep-engine/task", "WarmupLoadingData", "vb", vbid->get());
+            _warmup->loadDataForVBucket(*vbid);
+            return true;
+        }
         _warmup->removeFromTaskSet(uid);
+        _warmup->scanTaskComplete();
         return false;
     }
 
 private:
-    uint16_t _shardId;
     Warmup* _warmup;
     const std::string _description;
 };
 
+/**
+ * Warmup task which inserts the items read from disk by the scan tasks of
+ * the current phase (queued in Warmup::insertQueue) into the HashTable.
+ */
+class WarmupInsert : public GlobalTask {
+public:
+    WarmupInsert(EPBucket& st,
+                 uint16_t index,
+                 bool maybeEnableTraffic,
+                 Warmup& warmup)
+        : GlobalTask(&st.getEPEngine(), TaskId::WarmupInsert, 0, false),
+          warmup(warmup),
+          loadCallback(st, maybeEnableTraffic, warmup.state.getState()),
+          description("Warmup - inserting items: task " +
+                      std::to_string(index)) {
+        warmup.addToTaskSet(uid);
+    }
+
+    std::string getDescription() override {
+        return description;
+    }
+
+    std::chrono::microseconds maxExpectedDuration() override {
+        // Runs until the queue is drained, which depends on how quickly the
+        // scan tasks can read from disk; can be minutes in large datasets.
+        return std::chrono::hours(1);
+    }
+
+    bool run() override {
+        TRACE_EVENT0("ep-engine/task", "WarmupInsert");
+        if (warmup.insertQueuedBatches(*this, loadCallback)) {
+            return true;
+        }
+        warmup.removeFromTaskSet(uid);
+        warmup.phaseTaskComplete();
+        return false;
+    }
+
+private:
+    Warmup& warmup;
+    LoadStorageKVPairCallback loadCallback;
+    const std::string description;
+};
+
 class WarmupCompletion : public GlobalTask {
 public:
     WarmupCompletion(EPBucket& st, Warmup* w)
@@ -548,63 +672,72 @@ private:
     Warmup* _warmup;
 };
 
-static bool batchWarmupCallback(Vbid vbId,
-                                const std::set<StoredDocKey>& fetches,
-                                void* arg) {
-    auto *c = static_cast<WarmupCookie *>(arg);
-
-    if (!c->epstore->maybeEnableTraffic()) {
-        vb_bgfetch_queue_t items2fetch;
-        for (auto& key : fetches) {
-            // Access log only records Committed keys, therefore construct
-            // DiskDocKey with pending == false.
-            DiskDocKey diskKey{key, /*prepared*/ false};
-            // Deleted below via a unique_ptr in the next loop
-            vb_bgfetch_item_ctx_t& bg_itm_ctx = items2fetch[diskKey];
-            bg_itm_ctx.isMetaOnly = GetMetaOnly::No;
-            bg_itm_ctx.bgfetched_list.emplace_back(
-                    std::make_unique<FrontEndBGFetchItem>(nullptr, false));
-            bg_itm_ctx.bgfetched_list.back()->value = &bg_itm_ctx.value;
-        }
-
-        c->epstore->getROUnderlying(vbId)->getMulti(vbId, items2fetch);
-
-        // applyItem controls the  mode this loop operates in.
-        // true we will attempt the callback (attempt a HashTable insert)
-        // false we don't attempt the callback
-        // in both cases the loop must delete the VBucketBGFetchItem we
-        // allocated above.
-        bool applyItem = true;
-        for (auto& items : items2fetch) {
-            vb_bgfetch_item_ctx_t& bg_itm_ctx = items.second;
-            std::unique_ptr<BGFetchItem> fetchedItem(
-                    std::move(bg_itm_ctx.bgfetched_list.back()));
-            if (applyItem) {
-                GetValue& val = *fetchedItem->value;
-                if (val.getStatus() == ENGINE_SUCCESS) {
-                    // NB: callback will delete the GetValue's Item
-                    c->cb.callback(val);
-                } else {
-                    EP_LOG_WARN(
-                            "Warmup failed to load data for {}"
-                            " key{{{}}} error = {}",
-                            vbId,
-                            cb::UserData{items.first.to_string()},
-                            val.getStatus());
-                    c->error++;
-                }
+/**
+ * Fetch the given (Committed) keys of a vBucket from disk and pass them to
+ * the cookie's callback.
+ *
+ * @param keys Range of keys convertible to DocKey.
+ */
+template <class Keys>
+static void warmupFetchKeys(Vbid vbId, const Keys& keys, WarmupCookie& c) {
+    vb_bgfetch_queue_t items2fetch;
+    for (const auto& key : keys) {
+        // Access log only records Committed keys, therefore construct
+        // DiskDocKey with pending == false.
+        DiskDocKey diskKey{key, /*prepared*/ false};
+        // Deleted below via a unique_ptr in the next loop
+        vb_bgfetch_item_ctx_t& bg_itm_ctx = items2fetch[diskKey];
+        bg_itm_ctx.isMetaOnly = GetMetaOnly::No;
+        bg_itm_ctx.bgfetched_list.emplace_back(
+                std::make_unique<FrontEndBGFetchItem>(nullptr, false));
+        bg_itm_ctx.bgfetched_list.back()->value = &bg_itm_ctx.value;
+    }
+
+    c.epstore->getROUnderlying(vbId)->getMulti(vbId, items2fetch);
+
+    // applyItem controls the  mode this loop operates in.
+    // true we will attempt the callback (attempt a HashTable insert)
+    // false we don't attempt the callback
+    // in both cases the loop must delete the VBucketBGFetchItem we
+    // allocated above.
+    bool applyItem = true;
+    for (auto& items : items2fetch) {
+        vb_bgfetch_item_ctx_t& bg_itm_ctx = items.second;
+        std::unique_ptr<BGFetchItem> fetchedItem(
+                std::move(bg_itm_ctx.bgfetched_list.back()));
+        if (applyItem) {
+            GetValue& val = *fetchedItem->value;
+            if (val.getStatus() == ENGINE_SUCCESS) {
+                // NB: callback will delete the GetValue's Item
+                c.cb.callback(val);
+            } else {
+                EP_LOG_WARN(
+                        "Warmup failed to load data for {}"
+                        " key{{{}}} error = {}",
+                        vbId,
+                        cb::UserData{items.first.to_string()},
+                        val.getStatus());
+                c.error++;
+            }
 
-                if (c->cb.getStatus() == ENGINE_SUCCESS) {
-                    c->loaded++;
-                } else {
-                    // Failed to apply an Item, so fail the rest
-                    applyItem = false;
-                }
+            if (c.cb.getStatus() == ENGINE_SUCCESS) {
+                c.loaded++;
             } else {
-                c->skipped++;
+                // Failed to apply an Item, so fail the rest
+                applyItem = false;
             }
+        } else {
+            c.skipped++;
         }
+    }
+}
+
+template <class Keys>
+static bool batchWarmupCallback(Vbid vbId, const Keys& fetches, void* arg) {
+    auto *c = static_cast<WarmupCookie *>(arg);
 
+    if (!c->epstore->maybeEnableTraffic()) {
+        warmupFetchKeys(vbId, fetches, *c);
         return true;
     } else {
         c->skipped++;
@@ -977,6 +1110,10 @@ void Warmup::initialize()
         std::lock_guard<std::mutex> lock(warmupStart.mutex);
         warmupStart.time = std::chrono::steady_clock::now();
     }
+    {
+        std::lock_guard<std::mutex> lock(currentPhase.mutex);
+        currentPhase.start = std::chrono::steady_clock::now();
+    }
 
     std::map<std::string, std::string> session_stats;
     store.getOneROUnderlying()->getPersistedStats(session_stats);
@@ -1080,6 +1217,7 @@ void Warmup::createVBuckets(uint16_t shardId) {
             EPBucket* bucket = &this->store;
             vb->setFreqSaturatedCallback(
                     [bucket]() { bucket->wakeItemFreqDecayerTask(); });
+            vb->setSyncWriteTimeoutCallback(bucket->makeSyncWriteTimeoutCB());
 
             // Add the new vbucket to our local map, it will later be added
             // to the bucket's vbMap once the vbuckets are fully initialised
@@ -1225,37 +1363,30 @@ void Warmup::estimateDatabaseItemCount(uint16_t shardId) {
 }
 
 void Warmup::scheduleLoadPreparedSyncWrites() {
-    threadtask_count = 0;
-    for (size_t i = 0; i < store.vbMap.shards.size(); i++) {
-        ExTask task = std::make_shared<WarmupLoadPreparedSyncWrites>(
-                &store.getEPEngine(), i, *this);
-        ExecutorPool::get()->schedule(task);
-    }
+    scheduleVBucketScans(
+            WarmupState::State::PopulateVBucketMap,
+            [this](uint16_t index) {
+                return std::make_shared<WarmupLoadPreparedSyncWrites>(
+                        &store.getEPEngine(), index, *this);
+            },
+            {});
 }
 
-void Warmup::loadPreparedSyncWrites(uint16_t shardId) {
-    for (const auto vbid : shardVbIds[shardId]) {
-        auto itr = warmedUpVbuckets.find(vbid.get());
-        if (itr == warmedUpVbuckets.end()) {
-            continue;
-        }
-
-        // Our EPBucket function will do the load for us as we re-use the code
-        // for rollback.
-        auto& vb = *(itr->second);
-        folly::SharedMutex::WriteHolder vbStateLh(vb.getStateLock());
-
-        auto result = store.loadPreparedSyncWrites(vbStateLh, vb);
-        store.getEPEngine()
-                .getEpStats()
-                .warmupItemsVisitedWhilstLoadingPrepares += result.itemsVisited;
-        store.getEPEngine().getEpStats().warmedUpPrepares +=
-                result.preparesLoaded;
+void Warmup::loadPreparedSyncWrites(Vbid vbid) {
+    auto itr = warmedUpVbuckets.find(vbid.get());
+    if (itr == warmedUpVbuckets.end()) {
+        return;
     }
 
-    if (++threadtask_count == store.vbMap.getNumShards()) {
-        transition(WarmupState::State::PopulateVBucketMap);
-    }
+    // Our EPBucket function will do the load for us as we re-use the code
+    // for rollback.
+    auto& vb = *(itr->second);
+    folly::SharedMutex::WriteHolder vbStateLh(vb.getStateLock());
+
+    auto result = store.loadPreparedSyncWrites(vbStateLh, vb);
+    store.getEPEngine().getEpStats().warmupItemsVisitedWhilstLoadingPrepares +=
+            result.itemsVisited;
+    store.getEPEngine().getEpStats().warmedUpPrepares += result.preparesLoaded;
 }
 
 void Warmup::schedulePopulateVBucketMap() {
@@ -1289,39 +1420,19 @@ void Warmup::populateVBucketMap(uint16_t shardId) {
 
 void Warmup::scheduleKeyDump()
 {
-    threadtask_count = 0;
-    for (size_t i = 0; i < store.vbMap.shards.size(); i++) {
-        ExTask task = std::make_shared<WarmupKeyDump>(store, i, this);
-        ExecutorPool::get()->schedule(task);
-    }
-
+    scheduleVBucketScans(
+            WarmupState::State::CheckForAccessLog,
+            [this](uint16_t index) {
+                return std::make_shared<WarmupKeyDump>(store, index, this);
+            },
+            false);
 }
 
-void Warmup::keyDumpforShard(uint16_t shardId)
-{
-    KVStore* kvstore = store.getROUnderlyingByShard(shardId);
-    for (const auto vbid : shardVbIds[shardId]) {
-        auto ctx = kvstore->initBySeqnoScanContext(
-                std::make_unique<LoadStorageKVPairCallback>(
-                        store, false, state.getState()),
+void Warmup::keyDumpForVBucket(Vbid vbid) {
+    scanVBucket(vbid,
+                false,
                 std::make_unique<NoLookupCallback>(),
-                vbid,
-                0,
-                DocumentFilter::NO_DELETES,
-                ValueFilter::KEYS_ONLY,
-                SnapshotSource::Head);
-        if (ctx) {
-            auto errorCode = kvstore->scan(*ctx);
-            if (errorCode == scan_again) { // ENGINE_ENOMEM
-                // skip loading remaining VBuckets as memory limit was reached
-                break;
-            }
-        }
-    }
-
-    if (++threadtask_count == store.vbMap.getNumShards()) {
-        transition(WarmupState::State::CheckForAccessLog);
-    }
+                ValueFilter::KEYS_ONLY);
 }
 
 void Warmup::scheduleCheckForAccessLog()
@@ -1380,11 +1491,20 @@ void Warmup::loadingAccessLog(uint16_t shardId)
     auto stTime = std::chrono::steady_clock::now();
     if (store.accessLog[shardId].exists()) {
         try {
-            store.accessLog[shardId].open();
-            if (doWarmup(store.accessLog[shardId],
-                         shardVbStates[shardId],
-                         load_cb) != (size_t)-1) {
-                success = true;
+            const auto& curr = store.accessLog[shardId].getLogFile();
+            if (SortedAccessLog::isSortedAccessLog(curr)) {
+                if (doWarmup(SortedAccessLogReader(curr),
+                             shardVbStates[shardId],
+                             load_cb) != (size_t)-1) {
+                    success = true;
+                }
+            } else {
+                store.accessLog[shardId].open();
+                if (doWarmup(store.accessLog[shardId],
+                             shardVbStates[shardId],
+                             load_cb) != (size_t)-1) {
+                    success = true;
+                }
             }
         } catch (MutationLog::ReadException &e) {
             corruptAccessLog = true;
@@ -1399,10 +1519,18 @@ void Warmup::loadingAccessLog(uint16_t shardId)
         MutationLog old(nm);
         if (old.exists()) {
             try {
-                old.open();
-                if (doWarmup(old, shardVbStates[shardId], load_cb) !=
-                    (size_t)-1) {
-                    success = true;
+                if (SortedAccessLog::isSortedAccessLog(nm)) {
+                    if (doWarmup(SortedAccessLogReader(nm),
+                                 shardVbStates[shardId],
+                                 load_cb) != (size_t)-1) {
+                        success = true;
+                    }
+                } else {
+                    old.open();
+                    if (doWarmup(old, shardVbStates[shardId], load_cb) !=
+                        (size_t)-1) {
+                        success = true;
+                    }
                 }
             } catch (MutationLog::ReadException &e) {
                 corruptAccessLog = true;
@@ -1456,7 +1584,7 @@ size_t Warmup::doWarmup(MutationLog& lf,
 
         // .. then apply it to the store.
         auto apply_start = std::chrono::steady_clock::now();
-        harvester.apply(&cookie, &batchWarmupCallback);
+        harvester.apply(&cookie, &batchWarmupCallback<std::set<StoredDocKey>>);
         log_apply_duration += (std::chrono::steady_clock::now() - apply_start);
     } while (alog_iter != lf.end());
 
@@ -1475,6 +1603,57 @@ size_t Warmup::doWarmup(MutationLog& lf,
     return cookie.loaded;
 }
 
+size_t Warmup::doWarmup(const SortedAccessLogReader& log,
+                        const std::map<Vbid, vbucket_state>& vbmap,
+                        StatusCallback<GetValue>& cb) {
+    // Each vBucket's keys are in runs in seqno order, i.e. the order they
+    // were written to its data file, so each batch of consecutive keys
+    // refers to a narrow region of the file.
+    const auto start = std::chrono::steady_clock::now();
+    const size_t batchSize = config.getWarmupBatchSize();
+    WarmupCookie cookie(&store, cb);
+    std::vector<DocKey> batch;
+    bool stop = false;
+    for (auto it = vbmap.begin(); it != vbmap.end() && !stop; ++it) {
+        const auto vbid = it->first;
+        auto vb = store.getVBucket(vbid);
+        if (!vb) {
+            continue;
+        }
+        for (const auto& entry : log.getEntries(vbid)) {
+            // As MutationLogHarvester::apply, skip items which are no longer
+            // valid in the VBucket.
+            if (vb->ht.findForRead(entry.key,
+                                   TrackReference::No,
+                                   WantsDeleted::No)
+                        .storedValue == nullptr) {
+                continue;
+            }
+            batch.push_back(entry.key);
+            if (batch.size() == batchSize) {
+                stop = !batchWarmupCallback(vbid, batch, &cookie);
+                batch.clear();
+                if (stop) {
+                    break;
+                }
+            }
+        }
+        if (!stop && !batch.empty()) {
+            stop = !batchWarmupCallback(vbid, batch, &cookie);
+        }
+        batch.clear();
+    }
+
+    setEstimatedWarmupCount(log.getNumEntries());
+    EP_LOG_DEBUG("Populated sorted log in {} with(l: {}, s: {}, e: {})",
+                 cb::time2text(std::chrono::steady_clock::now() - start),
+                 cookie.loaded,
+                 cookie.skipped,
+                 cookie.error);
+
+    return cookie.loaded;
+}
+
 void Warmup::scheduleLoadingKVPairs()
 {
     // We reach here only if keyDump didn't return SUCCESS or if
@@ -1483,91 +1662,192 @@ void Warmup::scheduleLoadingKVPairs()
     // keys have been warmed up at this point.
     setEstimatedWarmupCount(estimatedItemCount);
 
-    threadtask_count = 0;
-    for (size_t i = 0; i < store.vbMap.shards.size(); i++) {
-        ExTask task = std::make_shared<WarmupLoadingKVPairs>(store, i, this);
-        ExecutorPool::get()->schedule(task);
-    }
+    scheduleVBucketScans(
+            WarmupState::State::Done,
+            [this](uint16_t index) {
+                return std::make_shared<WarmupLoadingKVPairs>(
+                        store, index, this);
+            },
+            store.getItemEvictionPolicy() == EvictionPolicy::Full);
+}
 
+void Warmup::loadKVPairsForVBucket(Vbid vbid) {
+    scanVBucket(vbid,
+                store.getItemEvictionPolicy() == EvictionPolicy::Full,
+                std::make_unique<LoadValueCallback>(store.vbMap,
+                                                    state.getState()),
+                store.getValueFilterForCompressionMode());
 }
 
-void Warmup::loadKVPairsforShard(uint16_t shardId)
+void Warmup::scheduleLoadingData()
 {
-    bool maybe_enable_traffic = false;
-    scan_error_t errorCode = scan_success;
-
-    if (store.getItemEvictionPolicy() == EvictionPolicy::Full) {
-        maybe_enable_traffic = true;
-    }
+    size_t estimatedCount = store.getEPEngine().getEpStats().warmedUpKeys;
+    setEstimatedWarmupCount(estimatedCount);
 
-    KVStore* kvstore = store.getROUnderlyingByShard(shardId);
-    ValueFilter valFilter = store.getValueFilterForCompressionMode();
+    scheduleVBucketScans(
+            WarmupState::State::Done,
+            [this](uint16_t index) {
+                return std::make_shared<WarmupLoadingData>(store, index, this);
+            },
+            true);
+}
 
-    for (const auto vbid : shardVbIds[shardId]) {
-        auto ctx = kvstore->initBySeqnoScanContext(
-                std::make_unique<LoadStorageKVPairCallback>(
-                        store, maybe_enable_traffic, state.getState()),
+void Warmup::loadDataForVBucket(Vbid vbid) {
+    scanVBucket(vbid,
+                true,
                 std::make_unique<LoadValueCallback>(store.vbMap,
                                                     state.getState()),
-                vbid,
-                0,
-                DocumentFilter::NO_DELETES,
-                valFilter,
-                SnapshotSource::Head);
-        if (ctx) {
-            errorCode = kvstore->scan(*ctx);
-            if (errorCode == scan_again) { // ENGINE_ENOMEM
-                // skip loading remaining VBuckets as memory limit was reached
-                break;
-            }
-        }
+                store.getValueFilterForCompressionMode());
+}
+
+void Warmup::scanVBucket(Vbid vbid,
+                         bool maybeEnableTraffic,
+                         std::unique_ptr<StatusCallback<CacheLookup>> lookup,
+                         ValueFilter valFilter) {
+    KVStore* kvstore = store.getROUnderlying(vbid);
+    auto ctx = kvstore->initBySeqnoScanContext(
+            std::make_unique<WarmupBatchingCallback>(
+                    store, *this, maybeEnableTraffic),
+            std::move(lookup),
+            vbid,
+            0,
+            DocumentFilter::NO_DELETES,
+            valFilter,
+            SnapshotSource::Head);
+    if (!ctx) {
+        return;
     }
-    if (++threadtask_count == store.vbMap.getNumShards()) {
-        transition(WarmupState::State::Done);
+
+    if (kvstore->scan(*ctx) == scan_again) { // ENGINE_ENOMEM
+        // skip loading remaining VBuckets as memory limit was reached
+        phaseStopped = true;
     }
+    static_cast<WarmupBatchingCallback&>(ctx->getValueCallback()).flush();
 }
 
-void Warmup::scheduleLoadingData()
-{
-    size_t estimatedCount = store.getEPEngine().getEpStats().warmedUpKeys;
-    setEstimatedWarmupCount(estimatedCount);
-
+void Warmup::scheduleVBucketScans(
+        WarmupState::State next,
+        const std::function<ExTask(uint16_t)>& makeScanTask,
+        std::optional<bool> maybeEnableTraffic) {
+    nextPhaseState = next;
+    nextVbToScan = 0;
+    phaseStopped = false;
     threadtask_count = 0;
-    for (size_t i = 0; i < store.vbMap.shards.size(); i++) {
-        ExTask task = std::make_shared<WarmupLoadingData>(store, i, this);
+
+    // One task per reader thread, but no more than there are vBuckets to
+    // scan. When loading items, half of them insert what the others read.
+    const size_t numTasks =
+            std::max(size_t(1),
+                     std::min(ExecutorPool::get()->getNumReaders(),
+                              vbScanOrder.size()));
+    std::vector<ExTask> tasks;
+    inserterTasks.clear();
+    if (maybeEnableTraffic && config.getWarmupInsertQueueSize() > 0) {
+        const size_t numInserters = std::max(size_t(1), numTasks / 2);
+        for (size_t i = 0; i < numInserters; ++i) {
+            tasks.push_back(std::make_shared<WarmupInsert>(
+                    store, uint16_t(i), *maybeEnableTraffic, *this));
+            inserterTasks.push_back(tasks.back()->getId());
+        }
+    }
+    const size_t numScanTasks =
+            std::max(size_t(1), numTasks - inserterTasks.size());
+    for (size_t i = 0; i < numScanTasks; ++i) {
+        tasks.push_back(makeScanTask(uint16_t(i)));
+    }
+    scanTasksRunning = numScanTasks;
+    numPhaseTasks = tasks.size();
+
+    for (auto& task : tasks) {
         ExecutorPool::get()->schedule(task);
     }
 }
 
-void Warmup::loadDataforShard(uint16_t shardId)
-{
-    scan_error_t errorCode = scan_success;
+std::optional<Vbid> Warmup::claimNextVBucket() {
+    if (phaseStopped) {
+        return {};
+    }
+    const auto index = nextVbToScan++;
+    if (index >= vbScanOrder.size()) {
+        return {};
+    }
+    return vbScanOrder[index];
+}
 
-    KVStore* kvstore = store.getROUnderlyingByShard(shardId);
-    ValueFilter valFilter = store.getValueFilterForCompressionMode();
+void Warmup::scanTaskComplete() {
+    if (--scanTasksRunning == 0) {
+        // Nothing more will be queued; wake the insert tasks so they finish
+        // once the queue is drained.
+        for (auto taskId : inserterTasks) {
+            ExecutorPool::get()->wake(taskId);
+        }
+    }
+    phaseTaskComplete();
+}
 
-    for (const auto vbid : shardVbIds[shardId]) {
-        auto ctx = kvstore->initBySeqnoScanContext(
-                std::make_unique<LoadStorageKVPairCallback>(
-                        store, true, state.getState()),
-                std::make_unique<LoadValueCallback>(store.vbMap,
-                                                    state.getState()),
-                vbid,
-                0,
-                DocumentFilter::NO_DELETES,
-                valFilter,
-                SnapshotSource::Head);
-        if (ctx) {
-            errorCode = kvstore->scan(*ctx);
-            if (errorCode == scan_again) { // ENGINE_ENOMEM
-                // skip loading remaining VBuckets as memory limit was reached
-                break;
-            }
+void Warmup::phaseTaskComplete() {
+    if (++threadtask_count == numPhaseTasks) {
+        transition(nextPhaseState);
+    }
+}
+
+bool Warmup::queueBatch(std::unique_ptr<WarmupBatch>& batch) {
+    {
+        auto queue = insertQueue.lock();
+        if (queue->size() >= config.getWarmupInsertQueueSize()) {
+            return false;
         }
+        queue->push_back(std::move(batch));
     }
+    for (auto taskId : inserterTasks) {
+        ExecutorPool::get()->wake(taskId);
+    }
+    return true;
+}
 
-    if (++threadtask_count == store.vbMap.getNumShards()) {
-        transition(WarmupState::State::Done);
+void Warmup::insertBatch(WarmupBatch& batch, LoadStorageKVPairCallback& cb) {
+    for (auto& val : batch) {
+        if (phaseStopped) {
+            // Loading stopped - discard the rest of the batch.
+            break;
+        }
+        cb.callback(val);
+        if (cb.getStatus() == ENGINE_ENOMEM) {
+            phaseStopped = true;
+        }
+    }
+    batch.clear();
+}
+
+bool Warmup::insertQueuedBatches(GlobalTask& task,
+                                 LoadStorageKVPairCallback& cb) {
+    while (true) {
+        // Check for running scans before checking the queue - once none are
+        // running nothing more can be queued, so an empty queue means done.
+        const bool scansComplete = scanTasksRunning == 0;
+        std::unique_ptr<WarmupBatch> batch;
+        {
+            auto queue = insertQueue.lock();
+            if (!queue->empty()) {
+                batch = std::move(queue->front());
+                queue->pop_front();
+            }
+        }
+        if (batch) {
+            insertBatch(*batch, cb);
+            continue;
+        }
+        if (scansComplete) {
+            return false;
+        }
+
+        // Sleep until a scan task queues a batch or completes (which wakes
+        // us), re-checking in case that happened before we snoozed.
+        task.snooze(INT_MAX);
+        if (scanTasksRunning == 0 || !insertQueue.lock()->empty()) {
+            task.snooze(0);
+        }
+        return true;
     }
 }
 
@@ -1631,6 +1911,16 @@ void Warmup::step() {
 void Warmup::transition(WarmupState::State to, bool force) {
     auto old = state.getState();
     if (old != WarmupState::State::Done) {
+        {
+            std::lock_guard<std::mutex> lock(currentPhase.mutex);
+            const auto now = std::chrono::steady_clock::now();
+            auto& phase = phaseStats[size_t(old)];
+            phase.duration.store(now - currentPhase.start);
+            phase.items.store(getPhaseItemCount(old) -
+                              currentPhase.itemsAtStart);
+            currentPhase.start = now;
+            currentPhase.itemsAtStart = getPhaseItemCount(to);
+        }
         state.transition(to, force);
         step();
     }
@@ -1714,6 +2004,84 @@ void Warmup::addStats(const AddStatFn& add_stat, const void* c) const {
     } else {
         addStat("estimated_value_count", warmupCount, add_stat, c);
     }
+
+    const auto current = state.getState();
+    for (auto phase : {WarmupState::State::LoadPreparedSyncWrites,
+                       WarmupState::State::KeyDump,
+                       WarmupState::State::LoadingAccessLog,
+                       WarmupState::State::LoadingKVPairs,
+                       WarmupState::State::LoadingData}) {
+        addPhaseStats(phase, phase == current, add_stat, c);
+    }
+}
+
+/// @returns the prefix of the per-phase stats for the given phase.
+static const char* getPhaseStatName(WarmupState::State phase) {
+    switch (phase) {
+    case WarmupState::State::LoadPreparedSyncWrites:
+        return "prepares";
+    case WarmupState::State::KeyDump:
+        return "key_dump";
+    case WarmupState::State::LoadingAccessLog:
+        return "access_log_load";
+    case WarmupState::State::LoadingKVPairs:
+        return "kv_pairs";
+    case WarmupState::State::LoadingData:
+        return "data";
+    default:
+        return nullptr;
+    }
+}
+
+void Warmup::addPhaseStats(WarmupState::State phase,
+                           bool current,
+                           const AddStatFn& add_stat,
+                           const void* c) const {
+    using namespace std::chrono;
+
+    steady_clock::duration elapsed;
+    size_t items;
+    if (current) {
+        std::lock_guard<std::mutex> lock(currentPhase.mutex);
+        elapsed = steady_clock::now() - currentPhase.start;
+        items = getPhaseItemCount(phase) - currentPhase.itemsAtStart;
+    } else {
+        const auto& stats = phaseStats[size_t(phase)];
+        elapsed = stats.duration.load();
+        items = stats.items.load();
+    }
+    if (elapsed == elapsed.zero()) {
+        // Phase hasn't run.
+        return;
+    }
+
+    const std::string name = getPhaseStatName(phase);
+    addStat((name + "_time").c_str(),
+            duration_cast<microseconds>(elapsed).count(),
+            add_stat,
+            c);
+    addStat((name + "_items").c_str(), items, add_stat, c);
+    const auto seconds = duration_cast<duration<double>>(elapsed).count();
+    addStat((name + "_items_per_sec").c_str(),
+            uint64_t(items / seconds),
+            add_stat,
+            c);
+}
+
+size_t Warmup::getPhaseItemCount(WarmupState::State phase) const {
+    const auto& stats = store.getEPEngine().getEpStats();
+    switch (phase) {
+    case WarmupState::State::LoadPreparedSyncWrites:
+        return stats.warmedUpPrepares;
+    case WarmupState::State::KeyDump:
+        return stats.warmedUpKeys;
+    case WarmupState::State::LoadingAccessLog:
+    case WarmupState::State::LoadingKVPairs:
+    case WarmupState::State::LoadingData:
+        return stats.warmedUpValues;
+    default:
+        return 0;
+    }
 }
 
 /* In the case of CouchKVStore, all vbucket states of all the shards
@@ -1800,4 +2168,21 @@ void Warmup::populateShardVbStates()
             }
         }
     }
+
+    // The per-vBucket phases aren't bound to shards; interleave the shards'
+    // lists so that every shard's first (active) vBucket is loaded first and
+    // the shards' files are read from evenly.
+    vbScanOrder.clear();
+    for (size_t pos = 0;; ++pos) {
+        bool added = false;
+        for (const auto& vbids : shardVbIds) {
+            if (pos < vbids.size()) {
+                vbScanOrder.push_back(vbids[pos]);
+                added = true;
+            }
+        }
+        if (!added) {
+            break;
+        }
+    }
 }
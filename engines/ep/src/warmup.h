@@ -21,32 +21,48 @@
 #include "vbucket_fwd.h"
 
 #include <folly/AtomicHashMap.h>
+#include <folly/Synchronized.h>
 #include <memcached/engine_common.h>
 #include <platform/atomic_duration.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
+class CacheLookup;
 class Configuration;
 class EPStats;
 class EPBucket;
 class GetValue;
+class GlobalTask;
+class LoadStorageKVPairCallback;
 class MutationLog;
+class SortedAccessLogReader;
 class VBucketMap;
 class Vbid;
 
 struct vbucket_state;
 
+enum class ValueFilter;
+
 template <typename...>
 class StatusCallback;
 
+using ExTask = std::shared_ptr<GlobalTask>;
+
+/// A batch of items read from disk, waiting to be inserted into the HashTable.
+using WarmupBatch = std::vector<GetValue>;
+
 /**
  * Class representing the current state (phase) of the warmup process.
  *
@@ -211,6 +227,15 @@ private:
  *    LoadingKVPairs
  *    Done
  *
+ * The per-vBucket phases (LoadPreparedSyncWrites, KeyDump, LoadingKVPairs and
+ * LoadingData) are not bound to shards: one task per reader thread is
+ * scheduled, each of which repeatedly claims the next vBucket (in
+ * vbScanOrder) and scans it. For the phases which load items, the scan tasks
+ * only read from disk - the items read are passed in batches through a
+ * bounded queue to WarmupInsert tasks which insert them into the HashTable,
+ * so disk reads overlap with inserts. A scan task which finds the queue full
+ * inserts its batch itself.
+ *
  * Note that once warmup is complete (Warmup::isComplete() returns true) the
  * warmup will conclude the phase and short-cut to Done.
  * When Warmup::isComplete() returns true:
@@ -244,6 +269,14 @@ public:
                     const std::map<Vbid, vbucket_state>& vbmap,
                     StatusCallback<GetValue>& cb);
 
+    /**
+     * As doWarmup, for an access log in the sorted format: each vBucket's
+     * keys are fetched in batches of consecutive seqnos.
+     */
+    size_t doWarmup(const SortedAccessLogReader& log,
+                    const std::map<Vbid, vbucket_state>& vbmap,
+                    StatusCallback<GetValue>& cb);
+
     bool isComplete() const {
         return warmupComplete.load();
     }
@@ -326,11 +359,11 @@ private:
     void estimateDatabaseItemCount(uint16_t shardId);
 
     /**
-     * Loads all prepared SyncWrites for each vBucket in the given shard
+     * Loads all prepared SyncWrites for the given vBucket
      * - Performs a KVStore scan against the DurabilityPrepare namespace,
      *   loading all found documents into memory.
      */
-    void loadPreparedSyncWrites(uint16_t shardId);
+    void loadPreparedSyncWrites(Vbid vbid);
 
     /**
      * Adds all warmed up vbuckets (for the shard) to the bucket's VBMap, once
@@ -343,9 +376,9 @@ private:
 
     /**
      * [Value-eviction only]
-     * Loads all keys into memory for each vBucket in the given shard.
+     * Loads all keys into memory for the given vBucket.
      */
-    void keyDumpforShard(uint16_t shardId);
+    void keyDumpForVBucket(Vbid vbid);
 
     /**
      * Checks for the existance of an access log file for each shard:
@@ -367,15 +400,81 @@ private:
 
     /**
      * [Full-eviction only]
-     * Loads both keys and values into memory for each vBucket in the given
-     * shard.
+     * Loads both keys and values into memory for the given vBucket.
+     */
+    void loadKVPairsForVBucket(Vbid vbid);
+
+    /**
+     * Loads values into memory for the given vBucket.
+     */
+    void loadDataForVBucket(Vbid vbid);
+
+    /**
+     * Scans the given vBucket from disk, queuing the items read for
+     * insertion by the WarmupInsert tasks.
+     * @param maybeEnableTraffic see LoadStorageKVPairCallback
+     * @param lookup Callback to check if an item needs loading
+     * @param valFilter which values to read
+     */
+    void scanVBucket(Vbid vbid,
+                     bool maybeEnableTraffic,
+                     std::unique_ptr<StatusCallback<CacheLookup>> lookup,
+                     ValueFilter valFilter);
+
+    /**
+     * Schedules the tasks of a per-vBucket phase, see the class-level
+     * comment.
+     * @param next The state to transition to once the phase is complete.
+     * @param makeScanTask Creates the scan task with the given index.
+     * @param maybeEnableTraffic If non-empty, the phase loads items and
+     *        WarmupInsert tasks are scheduled (which are passed this value,
+     *        see LoadStorageKVPairCallback). If empty the scan tasks do all
+     *        of the work themselves.
+     */
+    void scheduleVBucketScans(
+            WarmupState::State next,
+            const std::function<ExTask(uint16_t)>& makeScanTask,
+            std::optional<bool> maybeEnableTraffic);
+
+    /**
+     * Claim the next vBucket to be scanned in the current per-vBucket phase.
+     * @return the vBucket, or an empty optional if all have been claimed or
+     *         the phase has been stopped early.
+     */
+    std::optional<Vbid> claimNextVBucket();
+
+    /**
+     * Called by a scan task of a per-vBucket phase once it has no more
+     * vBuckets to scan.
+     */
+    void scanTaskComplete();
+
+    /**
+     * Called by each task of a per-vBucket phase once it is finished; the
+     * last one transitions to the next state.
+     */
+    void phaseTaskComplete();
+
+    /**
+     * Add a batch to the insert queue, waking the WarmupInsert tasks.
+     * @return false (leaving batch untouched) if the queue is full.
      */
-    void loadKVPairsforShard(uint16_t shardId);
+    bool queueBatch(std::unique_ptr<WarmupBatch>& batch);
 
     /**
-     * Loads values into memory for each vBucket in the given shard.
+     * Insert the items in the given batch into the HashTable using the given
+     * callback, stopping the phase if the callback reports that loading
+     * should stop (memory / item threshold reached).
      */
-    void loadDataforShard(uint16_t shardId);
+    void insertBatch(WarmupBatch& batch, LoadStorageKVPairCallback& cb);
+
+    /**
+     * Insert all queued batches (run by the WarmupInsert tasks).
+     * @return true if the task should run again - snoozed until more batches
+     *         are queued, false once all scans are complete and the queue
+     *         drained.
+     */
+    bool insertQueuedBatches(GlobalTask& task, LoadStorageKVPairCallback& cb);
 
     /* Terminal state of warmup. Updates statistics and marks warmup as
      * completed
@@ -402,6 +501,18 @@ private:
 
     void transition(WarmupState::State to, bool force = false);
 
+    /**
+     * Adds the per-phase duration / throughput stats for the given phase,
+     * which is either complete or (if current) in progress.
+     */
+    void addPhaseStats(WarmupState::State phase,
+                       bool current,
+                       const AddStatFn& add_stat,
+                       const void* c) const;
+
+    /// @returns the stat counting the items loaded by the given phase.
+    size_t getPhaseItemCount(WarmupState::State phase) const;
+
     WarmupState state;
 
     EPBucket& store;
@@ -430,6 +541,36 @@ private:
     /// contains all vBucket IDs which are present for the given shard.
     std::vector<std::vector<Vbid>> shardVbIds;
 
+    /// The order in which the per-vBucket phases visit vBuckets; the
+    /// vBuckets of each shard (in shardVbIds order) interleaved across shards.
+    std::vector<Vbid> vbScanOrder;
+
+    /// State of the current per-vBucket phase. The tasks are all scheduled
+    /// (and numPhaseTasks / inserterTasks written) before any runs.
+    std::atomic<size_t> nextVbToScan{0};
+    std::atomic<bool> phaseStopped{false};
+    std::atomic<size_t> scanTasksRunning{0};
+    size_t numPhaseTasks{0};
+    WarmupState::State nextPhaseState{WarmupState::State::Done};
+    std::vector<size_t> inserterTasks;
+
+    /// Batches of items read from disk, waiting for a WarmupInsert task.
+    folly::Synchronized<std::deque<std::unique_ptr<WarmupBatch>>, std::mutex>
+            insertQueue;
+
+    /// Duration and number of items loaded by each completed phase, and when
+    /// the current phase started.
+    struct PhaseStats {
+        cb::AtomicDuration<> duration;
+        std::atomic<size_t> items{0};
+    };
+    std::array<PhaseStats, size_t(WarmupState::State::Done)> phaseStats;
+    struct {
+        mutable std::mutex mutex;
+        std::chrono::steady_clock::time_point start;
+        size_t itemsAtStart{0};
+    } currentPhase;
+
     cb::AtomicDuration<> estimateTime;
     std::atomic<size_t> estimatedItemCount{std::numeric_limits<size_t>::max()};
     bool cleanShutdown{true};
@@ -468,4 +609,6 @@ private:
     friend class WarmupLoadingKVPairs;
     friend class WarmupLoadingData;
     friend class WarmupCompletion;
+    friend class WarmupInsert;
+    friend class WarmupBatchingCallback;
 };
@@ -3843,6 +3843,7 @@ static enum test_result test_worker_stats(EngineIface* h) {
     tasklist.insert("Warmup - loading access log");
     tasklist.insert("Warmup - loading KV Pairs");
     tasklist.insert("Warmup - loading data");
+    tasklist.insert("Warmup - inserting items");
     tasklist.insert("Warmup - completion");
     tasklist.insert("Not currently running any task");
 
@@ -6958,6 +6959,8 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_bfilter_fp_prob",
               "ep_bfilter_key_count",
               "ep_bfilter_residency_threshold",
+              "ep_bfilter_type",
+              "ep_bgfetch_concurrency",
               "ep_bucket_type",
               "ep_cache_size",
               "ep_chk_expel_enabled",
@@ -6992,6 +6995,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_dcp_producer_snapshot_marker_yield_limit",
               "ep_dcp_consumer_process_buffered_messages_yield_limit",
               "ep_dcp_consumer_process_buffered_messages_batch_size",
+              "ep_dcp_consumer_processor_tasks",
               "ep_dcp_scan_byte_limit",
               "ep_dcp_scan_item_limit",
               "ep_dcp_takeover_max_time",
@@ -7007,6 +7011,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_exp_pager_initial_run_time",
               "ep_exp_pager_stime",
               "ep_failpartialwarmup",
+              "ep_flusher_group_commit_vbuckets",
               "ep_flusher_total_batch_limit",
               "ep_fsync_after_every_n_bytes_written",
               "ep_couchstore_tracing",
@@ -7017,7 +7022,10 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_getl_max_timeout",
               "ep_hlc_drift_ahead_threshold_us",
               "ep_hlc_drift_behind_threshold_us",
+              "ep_ht_eviction_policy",
               "ep_ht_locks",
+              "ep_ht_maintenance_shared_pass",
+              "ep_ht_resize_algo",
               "ep_ht_resize_interval",
               "ep_ht_size",
               "ep_item_compressor_chunk_duration",
@@ -7090,6 +7098,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_time_synchronization",
               "ep_uuid",
               "ep_warmup_batch_size",
+              "ep_warmup_insert_queue_size",
               "ep_warmup_min_items_threshold",
               "ep_warmup_min_memory_threshold",
               "ep_xattr_enabled"}},
@@ -7146,11 +7155,14 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_bfilter_fp_prob",
               "ep_bfilter_key_count",
               "ep_bfilter_residency_threshold",
+              "ep_bfilter_type",
               "ep_bg_fetch_avg_read_amplification",
               "ep_bg_fetched",
+              "ep_bg_fetches_in_flight",
               "ep_bg_meta_fetched",
               "ep_bg_remaining_items",
               "ep_bg_remaining_jobs",
+              "ep_bgfetch_concurrency",
               "ep_blob_num",
               "ep_blob_overhead",
               "ep_bucket_priority",
@@ -7189,6 +7201,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_dcp_conn_buffer_size_perc",
               "ep_dcp_consumer_process_buffered_messages_batch_size",
               "ep_dcp_consumer_process_buffered_messages_yield_limit",
+              "ep_dcp_consumer_processor_tasks",
               "ep_dcp_enable_noop",
               "ep_dcp_flow_control_policy",
               "ep_dcp_idle_timeout",
@@ -7225,6 +7238,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_expiry_pager_task_time",
               "ep_failpartialwarmup",
               "ep_flush_duration_total",
+              "ep_flusher_group_commit_vbuckets",
               "ep_flusher_total_batch_limit",
               "ep_fsync_after_every_n_bytes_written",
               "ep_couchstore_tracing",
@@ -7235,7 +7249,10 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_getl_max_timeout",
               "ep_hlc_drift_ahead_threshold_us",
               "ep_hlc_drift_behind_threshold_us",
+              "ep_ht_eviction_policy",
               "ep_ht_locks",
+              "ep_ht_maintenance_shared_pass",
+              "ep_ht_resize_algo",
               "ep_ht_resize_interval",
               "ep_ht_size",
               "ep_io_bg_fetch_read_count",
@@ -7386,6 +7403,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_vbucket_del",
               "ep_vbucket_del_fail",
               "ep_warmup_batch_size",
+              "ep_warmup_insert_queue_size",
               "ep_warmup_min_items_threshold",
               "ep_warmup_min_memory_threshold",
               "ep_workload_pattern",
@@ -7579,6 +7597,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                 "ep_alog_path",
                 "ep_alog_resident_ratio_threshold",
                 "ep_alog_sleep_time",
+                "ep_alog_sorted",
                 "ep_alog_task_time",
                 "ep_item_eviction_policy",
                 "ep_persistent_metadata_purge_age",
@@ -7618,6 +7637,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                           "ep_ephemeral_metadata_purge_age",
                           "ep_ephemeral_metadata_purge_interval",
                           "ep_ephemeral_metadata_purge_stale_chunk_duration",
+                          "ep_ephemeral_seqlist_type",
 
                           "vb_active_auto_delete_count",
                           "vb_active_ht_tombstone_purged_count",
@@ -7672,7 +7692,8 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                  "ep_ephemeral_metadata_mark_stale_chunk_duration",
                  "ep_ephemeral_metadata_purge_age",
                  "ep_ephemeral_metadata_purge_interval",
-                 "ep_ephemeral_metadata_purge_stale_chunk_duration"});
+                 "ep_ephemeral_metadata_purge_stale_chunk_duration",
+                 "ep_ephemeral_seqlist_type"});
     }
 
     // In addition to the exact stat keys above, we also use regex patterns
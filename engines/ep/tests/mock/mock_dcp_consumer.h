@@ -58,6 +58,11 @@ public:
         notifyVbucketReady(vbid);
     }
 
+    /// @return the id of the given Processor's task (0 if none scheduled)
+    size_t getProcessorTaskId(size_t processor) const {
+        return processors.at(processor)->taskId;
+    }
+
     void setNumBackoffs(uint32_t v) {
         backoffs = v;
     }
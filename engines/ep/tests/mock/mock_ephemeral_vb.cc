@@ -36,10 +36,15 @@ MockEphemeralVBucket::MockEphemeralVBucket(
                        config,
                        evictionPolicy,
                        std::make_unique<Collections::VB::Manifest>()) {
-    /* we want MockBasicLinkedList instead to call certain non-public
-       APIs of BasicLinkedList in ephemeral vbucket */
-    this->seqList = std::make_unique<MockBasicLinkedList>(st);
-    mockLL = dynamic_cast<MockBasicLinkedList*>((this->seqList).get());
+    /* we want MockBasicLinkedList (or MockSkipList) instead to call certain
+       non-public APIs of the list in ephemeral vbucket */
+    if (config.getEphemeralSeqlistType() == "skip_list") {
+        this->seqList = std::make_unique<MockSkipList>(st);
+        mockSL = dynamic_cast<MockSkipList*>((this->seqList).get());
+    } else {
+        this->seqList = std::make_unique<MockBasicLinkedList>(st);
+        mockLL = dynamic_cast<MockBasicLinkedList*>((this->seqList).get());
+    }
 }
 
 size_t MockEphemeralVBucket::markOldTombstonesStale(rel_time_t purgeAge) {
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "../mock/mock_basic_ll.h"
+#include "../mock/mock_skip_list.h"
 #include "ephemeral_vb.h"
 
 #include <mutex>
@@ -47,31 +48,50 @@ public:
 
     /* Register fake shared range lock for testing */
     RangeGuard registerFakeSharedRangeLock(seqno_t start, seqno_t end) {
-        return mockLL->registerFakeSharedRangeLock(start, end);
+        if (mockLL) {
+            return mockLL->registerFakeSharedRangeLock(start, end);
+        }
+        return mockSL->registerFakeSharedRangeLock(start, end);
     }
 
     /* Register fake exclusive range lock for testing */
     RangeGuard registerFakeRangeLock(seqno_t start, seqno_t end) {
-        return mockLL->registerFakeRangeLock(start, end);
+        if (mockLL) {
+            return mockLL->registerFakeRangeLock(start, end);
+        }
+        return mockSL->registerFakeRangeLock(start, end);
+    }
+
+    std::vector<seqno_t> getAllSeqnoForVerification() const {
+        if (mockLL) {
+            return mockLL->getAllSeqnoForVerification();
+        }
+        return mockSL->getAllSeqnoForVerification();
     }
 
     int public_getNumStaleItems() {
-        return mockLL->getNumStaleItems();
+        return seqList->getNumStaleItems();
     }
 
     int public_getNumListItems() {
-        return mockLL->getNumItems();
+        return seqList->getNumItems();
     }
 
     int public_getNumListDeletedItems() {
-        return mockLL->getNumDeletedItems();
+        return seqList->getNumDeletedItems();
     }
 
     uint64_t public_getListHighSeqno() const {
-        return mockLL->getHighSeqno();
+        return seqList->getHighSeqno();
+    }
+
+    /// The sequence list, of the type selected by ephemeral_seqlist_type
+    SequenceList* getLL() {
+        return seqList.get();
     }
 
-    MockBasicLinkedList* getLL() {
+    /// The sequence list if it is a BasicLinkedList, else nullptr
+    MockBasicLinkedList* getBasicLL() {
         return mockLL;
     }
 
@@ -88,6 +108,8 @@ public:
             const VBNotifyCtx& notifyCtx);
 
 private:
-    /* non owning ptr to the linkedlist in the ephemeral vbucket obj */
-    MockBasicLinkedList* mockLL;
+    /* non owning ptrs to the sequence list in the ephemeral vbucket obj;
+       only the one of the configured ephemeral_seqlist_type is set */
+    MockBasicLinkedList* mockLL = nullptr;
+    MockSkipList* mockSL = nullptr;
 };
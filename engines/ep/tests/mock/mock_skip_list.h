@@ -0,0 +1,55 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Mock of the SkipList class. Wraps the real SkipList class and provides
+ * the same test helpers as MockBasicLinkedList.
+ */
+
+#pragma once
+
+#include "skip_list.h"
+
+#include <mutex>
+#include <vector>
+
+class MockSkipList : public SkipList {
+public:
+    explicit MockSkipList(EPStats& st) : SkipList(Vbid(0), st) {
+    }
+
+    std::vector<seqno_t> getAllSeqnoForVerification() const {
+        std::vector<seqno_t> allSeqnos;
+        std::lock_guard<std::mutex> lckGd(writeLock);
+
+        for (auto* node = head.next[0].load(); node;
+             node = node->next[0].load()) {
+            allSeqnos.push_back(node->osv->getBySeqno());
+        }
+        return allSeqnos;
+    }
+
+    /* Register fake range lock for testing */
+    RangeGuard registerFakeSharedRangeLock(seqno_t start, seqno_t end) {
+        return tryLockSeqnoRangeShared(start, end);
+    }
+
+    /* Register fake read range for testing */
+    RangeGuard registerFakeRangeLock(seqno_t start, seqno_t end) {
+        return rangeLockManager.tryLockRange(start, end);
+    }
+};
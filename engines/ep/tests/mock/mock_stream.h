@@ -59,7 +59,7 @@ public:
         return nextCheckpointItem();
     }
 
-    const std::queue<std::unique_ptr<DcpResponse>>& public_readyQ() {
+    const SPSCQueue<std::unique_ptr<DcpResponse>>& public_readyQ() {
         return readyQ;
     }
 
@@ -321,7 +321,7 @@ public:
 
     std::unique_ptr<DcpResponse> public_popFromReadyQ();
 
-    const std::queue<std::unique_ptr<DcpResponse>>& public_readyQ() const {
+    const SPSCQueue<std::unique_ptr<DcpResponse>>& public_readyQ() const {
         return readyQ;
     }
 
@@ -18,6 +18,7 @@
 
 #include "../mock/mock_basic_ll.h"
 #include "../mock/mock_function_helper.h"
+#include "../mock/mock_skip_list.h"
 #include "hash_table.h"
 #include "item.h"
 #include "linked_list.h"
@@ -33,9 +34,13 @@
 
 static EPStats global_stats;
 
-class BasicLinkedListTest : public ::testing::Test {
+/**
+ * Fixture for tests of a SequenceList; the implementation tested is chosen by
+ * the subclass.
+ */
+class SequenceListTestBase : public ::testing::Test {
 public:
-    BasicLinkedListTest() : ht(global_stats, makeFactory(), 2, 1) {
+    SequenceListTestBase() : ht(global_stats, makeFactory(), 2, 1) {
     }
 
     static std::unique_ptr<AbstractStoredValueFactory> makeFactory() {
@@ -54,13 +59,31 @@ public:
 
 protected:
     void SetUp() override {
-        basicLL = std::make_unique<MockBasicLinkedList>(global_stats);
+        seqList = makeList();
     }
 
     void TearDown() override {
         /* Like in a vbucket we want the list to be erased before HashTable is
            is destroyed. */
-        basicLL.reset();
+        seqList.reset();
+    }
+
+    virtual std::unique_ptr<SequenceList> makeList() = 0;
+
+    std::vector<seqno_t> getAllSeqnoForVerification() const {
+        if (auto* ll = dynamic_cast<MockBasicLinkedList*>(seqList.get())) {
+            return ll->getAllSeqnoForVerification();
+        }
+        return dynamic_cast<MockSkipList&>(*seqList)
+                .getAllSeqnoForVerification();
+    }
+
+    RangeGuard registerFakeSharedRangeLock(seqno_t start, seqno_t end) {
+        if (auto* ll = dynamic_cast<MockBasicLinkedList*>(seqList.get())) {
+            return ll->registerFakeSharedRangeLock(start, end);
+        }
+        return dynamic_cast<MockSkipList&>(*seqList)
+                .registerFakeSharedRangeLock(start, end);
     }
 
     /**
@@ -96,9 +119,9 @@ protected:
             sv = ht.findForWrite(key).storedValue->toOrderedStoredValue();
 
             std::lock_guard<std::mutex> listWriteLg(
-                    basicLL->getListWriteLock());
-            basicLL->appendToList(lg, listWriteLg, *sv);
-            basicLL->updateHighSeqno(listWriteLg, *sv);
+                    seqList->getListWriteLock());
+            seqList->appendToList(lg, listWriteLg, *sv);
+            seqList->updateHighSeqno(listWriteLg, *sv);
             expectedSeqno.push_back(i);
         }
         return expectedSeqno;
@@ -122,8 +145,8 @@ protected:
         OrderedStoredValue* sv =
                 ht.findForWrite(sKey).storedValue->toOrderedStoredValue();
 
-        std::lock_guard<std::mutex> listWriteLg(basicLL->getListWriteLock());
-        basicLL->appendToList(lg, listWriteLg, *sv);
+        std::lock_guard<std::mutex> listWriteLg(seqList->getListWriteLock());
+        seqList->appendToList(lg, listWriteLg, *sv);
     }
 
     void addStaleItem(const std::string& key, seqno_t seqno) {
@@ -148,13 +171,13 @@ protected:
         auto res = ht.findForWrite(sKey);
         ASSERT_TRUE(res.storedValue);
         auto* sv = res.storedValue->toOrderedStoredValue();
-        std::lock_guard<std::mutex> listWriteLg(basicLL->getListWriteLock());
-        basicLL->appendToList(lg, listWriteLg, *sv);
-        basicLL->updateHighSeqno(listWriteLg, *sv);
+        std::lock_guard<std::mutex> listWriteLg(seqList->getListWriteLock());
+        seqList->appendToList(lg, listWriteLg, *sv);
+        seqList->updateHighSeqno(listWriteLg, *sv);
 
         /* Mark stale */
         auto ownedSV = ht.unlocked_release(res.lock, res.storedValue);
-        basicLL->markItemStale(listWriteLg, std::move(ownedSV), nullptr);
+        seqList->markItemStale(listWriteLg, std::move(ownedSV), nullptr);
     }
 
     /**
@@ -170,11 +193,11 @@ protected:
         ASSERT_TRUE(sv);
         auto* osv = sv->toOrderedStoredValue();
 
-        std::lock_guard<std::mutex> listWriteLg(basicLL->getListWriteLock());
+        std::lock_guard<std::mutex> listWriteLg(seqList->getListWriteLock());
         EXPECT_EQ(SequenceList::UpdateStatus::Success,
-                  basicLL->updateListElem(lg, listWriteLg, *osv));
+                  seqList->updateListElem(lg, listWriteLg, *osv));
         osv->setBySeqno(highSeqno + 1);
-        basicLL->updateHighSeqno(listWriteLg, *osv);
+        seqList->updateHighSeqno(listWriteLg, *osv);
     }
 
     /**
@@ -193,9 +216,9 @@ protected:
         EXPECT_TRUE(res.storedValue);
         auto* osv = res.storedValue->toOrderedStoredValue();
 
-        std::lock_guard<std::mutex> listWriteLg(basicLL->getListWriteLock());
+        std::lock_guard<std::mutex> listWriteLg(seqList->getListWriteLock());
         EXPECT_EQ(SequenceList::UpdateStatus::Append,
-                  basicLL->updateListElem(lg, listWriteLg, *osv));
+                  seqList->updateListElem(lg, listWriteLg, *osv));
 
         /* Release the current sv from the HT */
         auto ownedSv = ht.unlocked_release(res.lock, res.storedValue);
@@ -210,11 +233,11 @@ protected:
                  /*theCas*/ 0,
                  /*bySeqno*/ highSeqno + 1);
         auto* newSv = ht.unlocked_addNewStoredValue(res.lock, itm);
-        basicLL->markItemStale(listWriteLg, std::move(ownedSv), newSv);
+        seqList->markItemStale(listWriteLg, std::move(ownedSv), newSv);
 
-        basicLL->appendToList(
+        seqList->appendToList(
                 lg, listWriteLg, *(newSv->toOrderedStoredValue()));
-        basicLL->updateHighSeqno(listWriteLg, *(newSv->toOrderedStoredValue()));
+        seqList->updateHighSeqno(listWriteLg, *(newSv->toOrderedStoredValue()));
     }
 
     /**
@@ -249,7 +272,7 @@ protected:
      * one always.
      */
     SequenceList::RangeIterator getRangeIterator() {
-        auto itrOptional = basicLL->makeRangeIterator(true /*isBackfill*/);
+        auto itrOptional = seqList->makeRangeIterator(true /*isBackfill*/);
         EXPECT_TRUE(itrOptional);
         return std::move(*itrOptional);
     }
@@ -257,20 +280,58 @@ protected:
     /* We need a HashTable because StoredValue is created only in the HashTable
        and then put onto the sequence list */
     HashTable ht;
-    std::unique_ptr<MockBasicLinkedList> basicLL;
+    std::unique_ptr<SequenceList> seqList;
 };
 
-TEST_F(BasicLinkedListTest, SetItems) {
+/**
+ * Tests which apply to every SequenceList implementation, run for each
+ * ephemeral_seqlist_type.
+ */
+class SequenceListTest : public SequenceListTestBase,
+                         public ::testing::WithParamInterface<std::string> {
+protected:
+    std::unique_ptr<SequenceList> makeList() override {
+        if (GetParam() == "skip_list") {
+            return std::make_unique<MockSkipList>(global_stats);
+        }
+        return std::make_unique<MockBasicLinkedList>(global_stats);
+    }
+};
+
+INSTANTIATE_TEST_SUITE_P(SeqListTypes,
+                         SequenceListTest,
+                         ::testing::Values("linked_list", "skip_list"),
+                         [](const ::testing::TestParamInfo<std::string>& info) {
+                             return info.param;
+                         });
+
+/**
+ * Tests specific to BasicLinkedList: its exclusive / partial range locks,
+ * and its purger which excludes range readers (the SkipList purger runs
+ * alongside them; see skip_list_test.cc).
+ */
+class BasicLinkedListTest : public SequenceListTestBase {
+protected:
+    std::unique_ptr<SequenceList> makeList() override {
+        auto list = std::make_unique<MockBasicLinkedList>(global_stats);
+        basicLL = list.get();
+        return list;
+    }
+
+    MockBasicLinkedList* basicLL = nullptr;
+};
+
+TEST_P(SequenceListTest, SetItems) {
     const int numItems = 3;
 
     /* Add 3 new items */
     std::vector<seqno_t> expectedSeqno =
             addNewItemsToList(1, std::string("key"), numItems);
 
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, TestRangeRead) {
+TEST_P(SequenceListTest, TestRangeRead) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -280,7 +341,7 @@ TEST_F(BasicLinkedListTest, TestRangeRead) {
     ENGINE_ERROR_CODE status;
     std::vector<UniqueItemPtr> items;
     seqno_t endSeqno;
-    std::tie(status, items, endSeqno) = basicLL->rangeRead(1, numItems);
+    std::tie(status, items, endSeqno) = seqList->rangeRead(1, numItems);
 
     EXPECT_EQ(ENGINE_SUCCESS, status);
     EXPECT_EQ(numItems, items.size());
@@ -288,7 +349,7 @@ TEST_F(BasicLinkedListTest, TestRangeRead) {
     EXPECT_EQ(numItems, endSeqno);
 }
 
-TEST_F(BasicLinkedListTest, TestRangeReadTillInf) {
+TEST_P(SequenceListTest, TestRangeReadTillInf) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -299,7 +360,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadTillInf) {
     std::vector<UniqueItemPtr> items;
     seqno_t endSeqno;
     std::tie(status, items, endSeqno) =
-            basicLL->rangeRead(1, std::numeric_limits<seqno_t>::max());
+            seqList->rangeRead(1, std::numeric_limits<seqno_t>::max());
 
     EXPECT_EQ(ENGINE_SUCCESS, status);
     EXPECT_EQ(numItems, items.size());
@@ -307,7 +368,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadTillInf) {
     EXPECT_EQ(numItems, endSeqno);
 }
 
-TEST_F(BasicLinkedListTest, TestRangeReadFromMid) {
+TEST_P(SequenceListTest, TestRangeReadFromMid) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -317,7 +378,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadFromMid) {
     ENGINE_ERROR_CODE status;
     std::vector<UniqueItemPtr> items;
     seqno_t endSeqno;
-    std::tie(status, items, endSeqno) = basicLL->rangeRead(2, numItems);
+    std::tie(status, items, endSeqno) = seqList->rangeRead(2, numItems);
 
     EXPECT_EQ(ENGINE_SUCCESS, status);
     EXPECT_EQ(numItems - 1, items.size());
@@ -325,7 +386,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadFromMid) {
     EXPECT_EQ(numItems, endSeqno);
 }
 
-TEST_F(BasicLinkedListTest, TestRangeReadStopBeforeEnd) {
+TEST_P(SequenceListTest, TestRangeReadStopBeforeEnd) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -335,7 +396,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadStopBeforeEnd) {
     ENGINE_ERROR_CODE status;
     std::vector<UniqueItemPtr> items;
     seqno_t endSeqno;
-    std::tie(status, items, endSeqno) = basicLL->rangeRead(1, numItems - 1);
+    std::tie(status, items, endSeqno) = seqList->rangeRead(1, numItems - 1);
 
     EXPECT_EQ(ENGINE_SUCCESS, status);
     EXPECT_EQ(numItems - 1, items.size());
@@ -343,7 +404,7 @@ TEST_F(BasicLinkedListTest, TestRangeReadStopBeforeEnd) {
     EXPECT_EQ(numItems - 1, endSeqno);
 }
 
-TEST_F(BasicLinkedListTest, TestRangeReadNegatives) {
+TEST_P(SequenceListTest, TestRangeReadNegatives) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -353,16 +414,16 @@ TEST_F(BasicLinkedListTest, TestRangeReadNegatives) {
     std::vector<UniqueItemPtr> items;
 
     /* Now do a range read with start > end */
-    std::tie(status, items, std::ignore) = basicLL->rangeRead(2, 1);
+    std::tie(status, items, std::ignore) = seqList->rangeRead(2, 1);
     EXPECT_EQ(ENGINE_ERANGE, status);
 
     /* Now do a range read with start > highSeqno */
     std::tie(status, items, std::ignore) =
-            basicLL->rangeRead(numItems + 1, numItems + 2);
+            seqList->rangeRead(numItems + 1, numItems + 2);
     EXPECT_EQ(ENGINE_ERANGE, status);
 }
 
-TEST_F(BasicLinkedListTest, UpdateFirstElem) {
+TEST_P(SequenceListTest, UpdateFirstElem) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -374,10 +435,10 @@ TEST_F(BasicLinkedListTest, UpdateFirstElem) {
 
     /* Check if the updated element has moved to the end */
     std::vector<seqno_t> expectedSeqno = {2, 3, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, UpdateMiddleElem) {
+TEST_P(SequenceListTest, UpdateMiddleElem) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -389,10 +450,10 @@ TEST_F(BasicLinkedListTest, UpdateMiddleElem) {
 
     /* Check if the updated element has moved to the end */
     std::vector<seqno_t> expectedSeqno = {1, 3, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, UpdateLastElem) {
+TEST_P(SequenceListTest, UpdateLastElem) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -404,10 +465,10 @@ TEST_F(BasicLinkedListTest, UpdateLastElem) {
 
     /* Check if the updated element has moved to the end */
     std::vector<seqno_t> expectedSeqno = {1, 2, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, WriteNewAfterUpdate) {
+TEST_P(SequenceListTest, WriteNewAfterUpdate) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -423,17 +484,17 @@ TEST_F(BasicLinkedListTest, WriteNewAfterUpdate) {
 
     /* Check if the new element is added correctly */
     std::vector<seqno_t> expectedSeqno = {1, 3, 4, 5};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, UpdateDuringRangeRead) {
+TEST_P(SequenceListTest, UpdateDuringRangeRead) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
     /* Add 3 new items */
     addNewItemsToList(1, keyPrefix, numItems);
 
-    auto range = basicLL->registerFakeSharedRangeLock(1, numItems);
+    auto range = registerFakeSharedRangeLock(1, numItems);
 
     /* Update an item in the list when a fake range read is happening */
     updateItemDuringRangeRead(numItems,
@@ -441,34 +502,34 @@ TEST_F(BasicLinkedListTest, UpdateDuringRangeRead) {
 
     /* Check if the new element is added correctly */
     std::vector<seqno_t> expectedSeqno = {1, 2, 3, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, DeletedItem) {
+TEST_P(SequenceListTest, DeletedItem) {
     const std::string keyPrefix("key");
     const int numItems = 1;
 
-    int numDeleted = basicLL->getNumDeletedItems();
+    int numDeleted = seqList->getNumDeletedItems();
 
     /* Add an item */
     addNewItemsToList(numItems, keyPrefix, 1);
 
     /* Delete the item */
     softDeleteItem(numItems, keyPrefix + std::to_string(numItems));
-    basicLL->updateNumDeletedItems(false, true);
+    seqList->updateNumDeletedItems(false, true);
 
     /* Check if the delete is added correctly */
     std::vector<seqno_t> expectedSeqno = {numItems + 1};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
-    EXPECT_EQ(numDeleted + 1, basicLL->getNumDeletedItems());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
+    EXPECT_EQ(numDeleted + 1, seqList->getNumDeletedItems());
 }
 
-TEST_F(BasicLinkedListTest, MarkStale) {
+TEST_P(SequenceListTest, MarkStale) {
     const std::string keyPrefix("key");
     const int numItems = 1;
 
     /* To begin with we expect 0 stale items */
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 
     /* Add an item */
     addNewItemsToList(numItems, keyPrefix, 1);
@@ -488,28 +549,28 @@ TEST_F(BasicLinkedListTest, MarkStale) {
 
     /* Mark the item stale */
     {
-        std::lock_guard<std::mutex> writeGuard(basicLL->getListWriteLock());
-        basicLL->markItemStale(writeGuard, std::move(ownedSv), replacement);
+        std::lock_guard<std::mutex> writeGuard(seqList->getListWriteLock());
+        seqList->markItemStale(writeGuard, std::move(ownedSv), replacement);
     }
 
     /* Check if the StoredValue is marked stale */
     {
-        std::lock_guard<std::mutex> writeGuard(basicLL->getListWriteLock());
+        std::lock_guard<std::mutex> writeGuard(seqList->getListWriteLock());
         EXPECT_TRUE(nonOwnedSvPtr->isStale(writeGuard));
     }
 
     /* Check if the stale count incremented to 1 */
-    EXPECT_EQ(1, basicLL->getNumStaleItems());
+    EXPECT_EQ(1, seqList->getNumStaleItems());
 
     /* Check if the total item count in the linked list is 2 */
-    EXPECT_EQ(2, basicLL->getNumItems());
+    EXPECT_EQ(2, seqList->getNumItems());
 
     /* Check memory usage of the list as it owns the stale item */
-    EXPECT_EQ(svSize, basicLL->getStaleValueBytes());
-    EXPECT_EQ(svMetaDataSize, basicLL->getStaleMetadataBytes());
+    EXPECT_EQ(svSize, seqList->getStaleValueBytes());
+    EXPECT_EQ(svMetaDataSize, seqList->getStaleMetadataBytes());
 }
 
-TEST_F(BasicLinkedListTest, RangeIterator) {
+TEST_P(SequenceListTest, RangeIterator) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -528,14 +589,14 @@ TEST_F(BasicLinkedListTest, RangeIterator) {
     EXPECT_EQ(expectedSeqno, actualSeqno);
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorNoItems) {
+TEST_P(SequenceListTest, RangeIteratorNoItems) {
     auto itr = getRangeIterator();
     /* Since there are no items in the list to iterate over, we expect itr start
        to be end */
     EXPECT_EQ(itr.curr(), itr.end());
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorSingleItem) {
+TEST_P(SequenceListTest, RangeIteratorSingleItem) {
     /* Add an item */
     std::vector<seqno_t> expectedSeqno =
             addNewItemsToList(1, std::string("key"), 1);
@@ -551,7 +612,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorSingleItem) {
     EXPECT_EQ(expectedSeqno, actualSeqno);
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorOverflow) {
+TEST_P(SequenceListTest, RangeIteratorOverflow) {
     const int numItems = 1;
     bool caughtOutofRangeExcp = false;
 
@@ -574,7 +635,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorOverflow) {
     EXPECT_TRUE(caughtOutofRangeExcp);
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorDeletion) {
+TEST_P(SequenceListTest, RangeIteratorDeletion) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -599,7 +660,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorDeletion) {
     }
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorAddNewItemDuringRead) {
+TEST_P(SequenceListTest, RangeIteratorAddNewItemDuringRead) {
     const int numItems = 3;
 
     /* Add 3 new items */
@@ -645,7 +706,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorAddNewItemDuringRead) {
     }
 }
 
-TEST_F(BasicLinkedListTest, RangeIteratorUpdateItemDuringRead) {
+TEST_P(SequenceListTest, RangeIteratorUpdateItemDuringRead) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -697,7 +758,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorUpdateItemDuringRead) {
 /* Creates 2 range iterators such that iterator2 is created after iterator1
    has read all items, and has hence released the rangeReadLock, but before
    iterator1 is deleted */
-TEST_F(BasicLinkedListTest, MultipleRangeIterator_MB24474) {
+TEST_P(SequenceListTest, MultipleRangeIterator_MB24474) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -709,7 +770,7 @@ TEST_F(BasicLinkedListTest, MultipleRangeIterator_MB24474) {
        the function scope ends */
     auto itr1Optional =
             std::make_unique<std::optional<SequenceList::RangeIterator>>(
-                    basicLL->makeRangeIterator(true /*isBackfill*/));
+                    seqList->makeRangeIterator(true /*isBackfill*/));
     auto itr1 = std::move(**itr1Optional);
 
     /* Read all items */
@@ -733,7 +794,7 @@ TEST_F(BasicLinkedListTest, MultipleRangeIterator_MB24474) {
     EXPECT_EQ(expectedSeqno, actualSeqno);
 }
 
-TEST_F(BasicLinkedListTest, ConcurrentRangeIterators) {
+TEST_P(SequenceListTest, ConcurrentRangeIterators) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -886,7 +947,7 @@ TEST_F(BasicLinkedListTest,
     EXPECT_FALSE(guard2);
 }
 
-TEST_F(BasicLinkedListTest, RangeReadStopsOnInvalidSeqno) {
+TEST_P(SequenceListTest, RangeReadStopsOnInvalidSeqno) {
     /* MB-24376: rangeRead has to stop if it encounters an OSV with a seqno of
      * -1; this item is definitely past the end of the rangeRead, and has not
      * yet had its seqno updated in queueDirty */
@@ -899,9 +960,9 @@ TEST_F(BasicLinkedListTest, RangeReadStopsOnInvalidSeqno) {
     /* Add a key that does not yet have a vaild seqno (say -1) */
     addItemWithoutSeqno("key3");
 
-    EXPECT_EQ(-1, basicLL->getSeqList().back().getBySeqno());
+    EXPECT_EQ(-1, getAllSeqnoForVerification().back());
 
-    auto res = basicLL->rangeRead(1, std::numeric_limits<seqno_t>::max());
+    auto res = seqList->rangeRead(1, std::numeric_limits<seqno_t>::max());
 
     EXPECT_EQ(ENGINE_SUCCESS, std::get<0>(res));
     EXPECT_EQ(numItems, std::get<1>(res).size());
@@ -911,7 +972,7 @@ TEST_F(BasicLinkedListTest, RangeReadStopsOnInvalidSeqno) {
 /* 'EphemeralVBucket' (class that has the list) never calls the purge of last
    element, but the list must support generic purge (that is purge until any
    element). */
-TEST_F(BasicLinkedListTest, PurgeTillLast) {
+TEST_P(SequenceListTest, PurgeTillLast) {
     const int numItems = 2;
     const std::string keyPrefix("key");
 
@@ -920,38 +981,38 @@ TEST_F(BasicLinkedListTest, PurgeTillLast) {
 
     /* Add a stale item */
     addStaleItem("stale", numItems + 1);
-    EXPECT_EQ(numItems + 1, basicLL->getNumItems());
-    EXPECT_EQ(1, basicLL->getNumStaleItems());
+    EXPECT_EQ(numItems + 1, seqList->getNumItems());
+    EXPECT_EQ(1, seqList->getNumStaleItems());
 
     /* Purge the last item */
-    EXPECT_EQ(1, basicLL->purgeTombstones(numItems + 1));
-    EXPECT_EQ(numItems, basicLL->getNumItems());
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(1, seqList->purgeTombstones(numItems + 1));
+    EXPECT_EQ(numItems, seqList->getNumItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 
     /* Should be able to add elements to the list after the purger has run */
     addNewItemsToList(
             numItems + 2 /*startseqno*/, keyPrefix, 1 /*add one element*/);
     std::vector<seqno_t> expectedSeqno = {1, 2, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
 /* 'EphemeralVBucket' (class that has the list) never calls the purge of the
    only element, but the list must support generic purge (that is purge until
    any element). */
-TEST_F(BasicLinkedListTest, PurgeTheOnlyElement) {
+TEST_P(SequenceListTest, PurgeTheOnlyElement) {
     /* Add a stale item */
     addStaleItem("stale", 1);
-    EXPECT_EQ(1, basicLL->getNumItems());
-    EXPECT_EQ(1, basicLL->getNumStaleItems());
+    EXPECT_EQ(1, seqList->getNumItems());
+    EXPECT_EQ(1, seqList->getNumStaleItems());
 
     /* Purge the only item */
-    EXPECT_EQ(1, basicLL->purgeTombstones(1));
-    EXPECT_EQ(0, basicLL->getNumItems());
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(1, seqList->purgeTombstones(1));
+    EXPECT_EQ(0, seqList->getNumItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 
     /* Should be able to add elements to the list after the purger has run */
     addNewItemsToList(2 /*startseqno*/, "key", 1 /*add one element*/);
-    EXPECT_EQ(1, basicLL->getNumItems());
+    EXPECT_EQ(1, seqList->getNumItems());
 }
 
 /* 'EphemeralVBucket' (class that has the list) never calls the purge of
@@ -959,7 +1020,7 @@ TEST_F(BasicLinkedListTest, PurgeTheOnlyElement) {
    (that is purge until any element).
    This is a negative test case which checks that 'purgeTombstones' completes
    correctly even in the case of a wrong input */
-TEST_F(BasicLinkedListTest, PurgeBeyondLast) {
+TEST_P(SequenceListTest, PurgeBeyondLast) {
     const int numItems = 2;
     const std::string keyPrefix("key");
 
@@ -968,22 +1029,22 @@ TEST_F(BasicLinkedListTest, PurgeBeyondLast) {
 
     /* Add a stale item */
     addStaleItem("stale", numItems + 1);
-    EXPECT_EQ(numItems + 1, basicLL->getNumItems());
-    EXPECT_EQ(1, basicLL->getNumStaleItems());
+    EXPECT_EQ(numItems + 1, seqList->getNumItems());
+    EXPECT_EQ(1, seqList->getNumStaleItems());
 
     /* Purge beyond the last item */
-    EXPECT_EQ(1, basicLL->purgeTombstones(numItems + 1000));
-    EXPECT_EQ(numItems, basicLL->getNumItems());
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(1, seqList->purgeTombstones(numItems + 1000));
+    EXPECT_EQ(numItems, seqList->getNumItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 
     /* Should be able to add elements to the list after the purger has run */
     addNewItemsToList(
             numItems + 2 /*startseqno*/, keyPrefix, 1 /*add one element*/);
     std::vector<seqno_t> expectedSeqno = {1, 2, 4};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, UpdateDuringPurge) {
+TEST_P(SequenceListTest, UpdateDuringPurge) {
     const int numItems = 2;
     const std::string keyPrefix("key");
 
@@ -996,7 +1057,7 @@ TEST_F(BasicLinkedListTest, UpdateDuringPurge) {
        the updated item */
 
     size_t timesShouldPauseCalled = 0;
-    basicLL->purgeTombstones(numItems, {}, [&]() {
+    seqList->purgeTombstones(numItems, {}, [&]() {
         /* By sending the update in the callback, we are simulating a
            scenario where an update happens in between the purge */
         if (timesShouldPauseCalled == 1) {
@@ -1008,9 +1069,9 @@ TEST_F(BasicLinkedListTest, UpdateDuringPurge) {
     });
 
     /* Update should succeed */
-    EXPECT_EQ(numItems + 1, basicLL->getHighSeqno());
+    EXPECT_EQ(numItems + 1, seqList->getHighSeqno());
     /* Update should not create stale items */
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 }
 
 TEST_F(BasicLinkedListTest, RangeIteratorRefusedDuringPurge) {
@@ -1113,7 +1174,7 @@ TEST_F(BasicLinkedListTest, PurgeEarlyExitsIfRangeLockCoversStartSeqno) {
 }
 
 /* Run purge when the last item in the list does not yet have a seqno */
-TEST_F(BasicLinkedListTest, PurgeWithItemWithoutSeqno) {
+TEST_P(SequenceListTest, PurgeWithItemWithoutSeqno) {
     const int numItems = 2;
     int expItems = numItems;
     const std::string keyPrefix("key");
@@ -1124,24 +1185,24 @@ TEST_F(BasicLinkedListTest, PurgeWithItemWithoutSeqno) {
     /* Add a stale item */
     addStaleItem("stale", numItems + 1);
     ++expItems;
-    ASSERT_EQ(expItems, basicLL->getNumItems());
-    ASSERT_EQ(1, basicLL->getNumStaleItems());
+    ASSERT_EQ(expItems, seqList->getNumItems());
+    ASSERT_EQ(1, seqList->getNumStaleItems());
 
     /* Add an item which doesn't yet have a seqno. Such a scenario is possible
        when an item is added to the list, but seqno for it is yet to be
        generated */
     addItemWithoutSeqno("itemInMetaState");
     ++expItems;
-    ASSERT_EQ(expItems, basicLL->getNumItems());
+    ASSERT_EQ(expItems, seqList->getNumItems());
 
     /* Run purge */
-    EXPECT_EQ(1, basicLL->purgeTombstones(numItems + 1));
+    EXPECT_EQ(1, seqList->purgeTombstones(numItems + 1));
     --expItems;
-    EXPECT_EQ(expItems, basicLL->getNumItems());
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(expItems, seqList->getNumItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
 }
 
-TEST_F(BasicLinkedListTest, PurgePauseResume) {
+TEST_P(SequenceListTest, PurgePauseResume) {
     const int numItems = 4, numPurgeItems = 2;
     const std::string keyPrefix("key");
 
@@ -1158,8 +1219,8 @@ TEST_F(BasicLinkedListTest, PurgePauseResume) {
     /* Add another stale item at the end */
     addStaleItem("stale", 1 + numItems + 1 /* one stale item */);
 
-    ASSERT_EQ(numItems + numPurgeItems, basicLL->getNumItems());
-    ASSERT_EQ(numPurgeItems, basicLL->getNumStaleItems());
+    ASSERT_EQ(numItems + numPurgeItems, seqList->getNumItems());
+    ASSERT_EQ(numPurgeItems, seqList->getNumStaleItems());
 
     /* Purge the list. Set the max purge duration to 0 so that tombstone
      purging will pause */
@@ -1167,23 +1228,23 @@ TEST_F(BasicLinkedListTest, PurgePauseResume) {
 
     /* Expect all items to be purged and atleast one pause-resume */
     while (purged != numPurgeItems) {
-        purged += basicLL->purgeTombstones(
+        purged += seqList->purgeTombstones(
                 numItems + numPurgeItems, {}, []() { return true; });
         ++numPaused;
     }
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
     EXPECT_GE(numPaused, 1);
-    EXPECT_EQ(numItems, basicLL->getNumItems());
+    EXPECT_EQ(numItems, seqList->getNumItems());
 
     /* Should be able to add elements to the list after the purger has run */
     addNewItemsToList(numItems + numPurgeItems + 1 /*startseqno*/,
                       keyPrefix,
                       1 /*add one element*/);
     std::vector<seqno_t> expectedSeqno = {1, 2, 4, 5, 7};
-    EXPECT_EQ(expectedSeqno, basicLL->getAllSeqnoForVerification());
+    EXPECT_EQ(expectedSeqno, getAllSeqnoForVerification());
 }
 
-TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdate) {
+TEST_P(SequenceListTest, PurgePauseResumeWithUpdate) {
     const int numItems = 2, numPurgeItems = 1;
     const std::string keyPrefix("key");
 
@@ -1196,8 +1257,8 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdate) {
     /* Add another item */
     addNewItemsToList(3 /*seqno*/, keyPrefix, 1);
 
-    ASSERT_EQ(numItems + numPurgeItems, basicLL->getNumItems());
-    ASSERT_EQ(numPurgeItems, basicLL->getNumStaleItems());
+    ASSERT_EQ(numItems + numPurgeItems, seqList->getNumItems());
+    ASSERT_EQ(numPurgeItems, seqList->getNumStaleItems());
 
     /* Purge the list. Set the max purge duration to 0 so that tombstone
      purging will pause */
@@ -1205,7 +1266,7 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdate) {
 
     /* Expect all items to be purged and atleast one pause-resume */
     while (purged != numPurgeItems) {
-        purged += basicLL->purgeTombstones(
+        purged += seqList->purgeTombstones(
                 numItems + numPurgeItems, {}, []() { return true; });
         if (numPaused == -1) {
             /* During one pause, update some list element (last element here) */
@@ -1214,12 +1275,12 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdate) {
         }
         ++numPaused;
     }
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
     EXPECT_GE(numPaused, 1);
-    EXPECT_EQ(numItems, basicLL->getNumItems());
+    EXPECT_EQ(numItems, seqList->getNumItems());
 }
 
-TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
+TEST_P(SequenceListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
     const int numItems = 4, numPurgeItems = 2;
     const std::string keyPrefix("key");
 
@@ -1236,8 +1297,8 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
     /* Add another stale item at the end */
     addStaleItem("stale", 1 + numItems + 1 /* one stale item */);
 
-    ASSERT_EQ(numItems + numPurgeItems, basicLL->getNumItems());
-    ASSERT_EQ(numPurgeItems, basicLL->getNumStaleItems());
+    ASSERT_EQ(numItems + numPurgeItems, seqList->getNumItems());
+    ASSERT_EQ(numPurgeItems, seqList->getNumStaleItems());
 
     /* Purge the list. Set the max purge duration to 0 so that tombstone
      purging will pause */
@@ -1245,7 +1306,7 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
 
     /* Expect all items to be purged and atleast one pause-resume */
     while (purged != numPurgeItems) {
-        purged += basicLL->purgeTombstones(
+        purged += seqList->purgeTombstones(
                 numItems + numPurgeItems, {}, []() { return true; });
         if (numPaused == -1) {
             /* After first call to purgeTombstones() we know that the list is
@@ -1255,9 +1316,9 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
         }
         ++numPaused;
     }
-    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(0, seqList->getNumStaleItems());
     EXPECT_GE(numPaused, 1);
-    EXPECT_EQ(numItems, basicLL->getNumItems());
+    EXPECT_EQ(numItems, seqList->getNumItems());
 }
 
 TEST_F(BasicLinkedListTest, SeqRangeOverlapTest) {
@@ -100,6 +100,61 @@ TEST_F(BloomFilterTest, FalsePositiveRate) {
                 expectedFalsePositives * 0.1);
 }
 
+// Test that a Blocked filter finds every key which was added.
+TEST_F(BloomFilterTest, BlockedPositiveCheck) {
+    const int numKeys = 10000;
+    BloomFilter bf(numKeys, 0.01, BFILTER_ENABLED, BloomFilter::Type::Blocked);
+    EXPECT_EQ(BloomFilter::Type::Blocked, bf.getType());
+    for (int i = 0; i < numKeys; i++) {
+        bf.addKey(makeStoredDocKey("key_" + std::to_string(i)));
+    }
+    EXPECT_EQ(numKeys, bf.getNumOfKeysInFilter());
+
+    for (int i = 0; i < numKeys; i++) {
+        auto key = makeStoredDocKey("key_" + std::to_string(i));
+        EXPECT_TRUE(bf.maybeKeyExists(key)) << "For key:" << key.to_string();
+    }
+}
+
+// Test that a Blocked filter is sized up so its false positive rate stays
+// at (or below) the target, at both 1% and 0.1%.
+TEST_F(BloomFilterTest, BlockedFalsePositiveRate) {
+    const int numKeys = 100000;
+    for (const double targetFalsePositive : {0.01, 0.001}) {
+        BloomFilter bitset(numKeys, targetFalsePositive, BFILTER_ENABLED);
+        BloomFilter bf(numKeys,
+                       targetFalsePositive,
+                       BFILTER_ENABLED,
+                       BloomFilter::Type::Blocked);
+        EXPECT_GT(bf.getFilterSize(), bitset.getFilterSize());
+        EXPECT_EQ(0, bf.getFilterSize() % 512);
+
+        for (int i = 0; i < numKeys; i++) {
+            bf.addKey(makeStoredDocKey("key_" + std::to_string(i)));
+        }
+
+        int falsePositives = 0;
+        for (int i = 0; i < numKeys; i++) {
+            if (bf.maybeKeyExists(makeStoredDocKey(
+                        "key_" + std::to_string(numKeys + i)))) {
+                falsePositives++;
+            }
+        }
+
+        // Allow some slack above the target given the probabilistic nature.
+        const int expectedFalsePositives = numKeys * targetFalsePositive;
+        EXPECT_LE(falsePositives, expectedFalsePositives * 1.2)
+                << "For target:" << targetFalsePositive;
+    }
+}
+
+TEST_F(BloomFilterTest, TypeFromString) {
+    EXPECT_EQ(BloomFilter::Type::Bitset, BloomFilter::typeFromString("bitset"));
+    EXPECT_EQ(BloomFilter::Type::Blocked,
+              BloomFilter::typeFromString("blocked"));
+    EXPECT_THROW(BloomFilter::typeFromString("other"), std::invalid_argument);
+}
+
 class BloomFilterDocKeyTest
     : public BloomFilter,
       public ::testing::TestWithParam<std::tuple<CollectionID, CollectionID>> {
@@ -110,11 +110,6 @@ TEST_F(CheckpointRemoverEPTest, CheckpointManagerMemoryUsage) {
     // We should have one checkpoint which is for the state change
     ASSERT_EQ(1, checkpointManager->getNumCheckpoints());
 
-    // The queue (toWrite) is implemented as std:list, therefore
-    // when we add an item it results in the creation of 3 pointers -
-    // forward ptr, backward ptr and ptr to object.
-    const size_t perElementOverhead = 3 * sizeof(uintptr_t);
-
     // Allocator used for tracking memory used by the CheckpointQueue
     checkpoint_index::allocator_type memoryTrackingAllocator;
 
@@ -122,6 +117,11 @@ TEST_F(CheckpointRemoverEPTest, CheckpointManagerMemoryUsage) {
     // checkpoint indexes.
     checkpoint_index::key_type::allocator_type keyIndexKeyTrackingAllocator;
 
+    // Emulate the queue (toWrite) of each Checkpoint so we can determine the
+    // number of bytes that should be allocated for it.
+    MemoryTrackingAllocator<queued_item> queueTrackingAllocator;
+    CheckpointQueue queue(queueTrackingAllocator);
+
     // Emulate the Checkpoint metaKeyIndex so we can determine the number
     // of bytes that should be allocated during its use.
     checkpoint_index metaKeyIndex(memoryTrackingAllocator);
@@ -143,21 +143,13 @@ TEST_F(CheckpointRemoverEPTest, CheckpointManagerMemoryUsage) {
                  *checkpointManager)) {
         // Add the overhead of the Checkpoint object
         expected_size += sizeof(Checkpoint);
-#ifdef WIN32
-        // On windows for an empty list we still allocate space for
-        // containing one element.
-        expected_size += perElementOverhead;
-#if _DEBUG
-        // additional 16 bytes overhead in an empty list with Debug CRT.
-        expected_size += 16;
-#endif
-#endif
 
+        queue = CheckpointQueue(queueTrackingAllocator);
         for (auto& itr : *checkpoint) {
             // Add the size of the item
             expected_size += itr->size();
-            // Add the size of adding to the queue
-            expected_size += perElementOverhead;
+            // Add to the emulated queue
+            queue.push_back(itr);
             // Add to the emulated metaKeyIndex
 
             metaKeyIndex.emplace(
@@ -165,6 +157,8 @@ TEST_F(CheckpointRemoverEPTest, CheckpointManagerMemoryUsage) {
                                            keyIndexKeyTrackingAllocator),
                     entry);
         }
+        // Add the size of the queue
+        expected_size += *queueTrackingAllocator.getBytesAllocated();
     }
 
     const auto metaKeyIndexSize =
@@ -179,8 +173,11 @@ TEST_F(CheckpointRemoverEPTest, CheckpointManagerMemoryUsage) {
     size_t new_expected_size = expected_size;
     // Add the size of the item
     new_expected_size += item.size();
-    // Add the size of adding to the queue
-    new_expected_size += perElementOverhead;
+    // Add the size of adding to the (last checkpoint's) queue
+    const auto queueSize = *queueTrackingAllocator.getBytesAllocated();
+    queue.push_back(queued_item(new Item(item)));
+    new_expected_size +=
+            *queueTrackingAllocator.getBytesAllocated() - queueSize;
     // Add to the keyIndex
     committedKeyIndex.emplace(
             CheckpointIndexKeyType(item.getKey(), keyIndexKeyTrackingAllocator),
@@ -269,11 +266,6 @@ TEST_F(CheckpointRemoverEPTest, CursorDropMemoryFreed) {
 
     createDcpStream(*producer);
 
-    // The queue (toWrite) is implemented as std:list, therefore
-    // when we add an item it results in the creation of 3 pointers -
-    // forward ptr, backward ptr and ptr to object.
-    const size_t perElementOverhead = 3 * sizeof(uintptr_t);
-
     // Allocator used for tracking memory used by the CheckpointQueue
     checkpoint_index::allocator_type memoryTrackingAllocator;
 
@@ -295,13 +287,25 @@ TEST_F(CheckpointRemoverEPTest, CursorDropMemoryFreed) {
                     ->begin();
     index_entry entry{iterator, 0};
 
+    // Emulate the Checkpoint queue (toWrite) so we can determine the number
+    // of bytes that should be allocated for it.
+    MemoryTrackingAllocator<queued_item> queueTrackingAllocator;
+    CheckpointQueue queue(queueTrackingAllocator);
+    for (const auto& qi :
+         *CheckpointManagerTestIntrospector::public_getCheckpointList(
+                  *checkpointManager)
+                  .front()) {
+        queue.push_back(qi);
+    }
+    const auto initialQueueSize = *queueTrackingAllocator.getBytesAllocated();
+
     auto expectedFreedMemoryFromItems = initialSize;
     for (size_t i = 0; i < getMaxCheckpointItems(*vb); i++) {
         std::string doc_key = "key_" + std::to_string(i);
         Item item = store_item(vbid, makeStoredDocKey(doc_key), "value");
         expectedFreedMemoryFromItems += item.size();
-        // Add the size of adding to the queue
-        expectedFreedMemoryFromItems += perElementOverhead;
+        // Add to the emulated queue
+        queue.push_back(queued_item(new Item(item)));
         // Add to the emulated keyIndex
         keyIndex.emplace(CheckpointIndexKeyType(item.getKey(),
                                                 keyIndexKeyTrackingAllocator),
@@ -333,7 +337,9 @@ TEST_F(CheckpointRemoverEPTest, CursorDropMemoryFreed) {
     // Add the size of the checkpoint end
     expectedFreedMemoryFromItems += chkptEnd->size();
     // Add the size of adding to the queue
-    expectedFreedMemoryFromItems += perElementOverhead;
+    queue.push_back(chkptEnd);
+    expectedFreedMemoryFromItems +=
+            *queueTrackingAllocator.getBytesAllocated() - initialQueueSize;
     // Add to the emulated keyIndex
     keyIndex.emplace(CheckpointIndexKeyType(chkptEnd->getKey(),
                                             keyIndexKeyTrackingAllocator),
@@ -1645,6 +1645,61 @@ TEST_P(CheckpointTest, dedupeMemoryTest) {
     EXPECT_LT(memoryUsage3, memoryUsage4);
 }
 
+// Test that the chunks of the checkpoint queue left mostly null by
+// de-duplication are merged (instead of each remaining item keeping a chunk
+// allocated), that the cursors and key index entries of the items moved by
+// the merge are updated, and that memOverhead tracks the chunks allocated.
+TEST_P(CheckpointTest, dedupeCompactsQueue) {
+    const int numKeys = 3 * CheckpointQueue::slotsPerChunk;
+    for (int ii = 0; ii < numKeys; ++ii) {
+        ASSERT_TRUE(this->queueNewItem("key" + std::to_string(ii)));
+    }
+
+    // Move the cursor onto key10 (past the checkpoint_start).
+    bool isLastMutationItem;
+    for (int ii = 0; ii < 12; ++ii) {
+        manager->nextItem(cursor, isLastMutationItem);
+    }
+
+    const auto& checkpoint =
+            *CheckpointManagerTestIntrospector::public_getCheckpointList(
+                     *manager)
+                     .front();
+    const auto queueBytes = checkpoint.getWriteQueueAllocatorBytes();
+    const auto memOverhead = this->global_stats.getMemOverhead();
+
+    // De-duplicating every odd key leaves each chunk half null; they are
+    // merged so the queue doesn't grow.
+    for (int ii = 1; ii < numKeys; ii += 2) {
+        EXPECT_FALSE(this->queueNewItem("key" + std::to_string(ii)));
+    }
+    EXPECT_EQ(queueBytes, checkpoint.getWriteQueueAllocatorBytes());
+    EXPECT_EQ(memOverhead, this->global_stats.getMemOverhead());
+
+    // The cursor is still on key10 (which has been moved).
+    std::vector<queued_item> items;
+    manager->getItemsForCursor(cursor, items, 1000);
+    std::vector<StoredDocKey> expected;
+    for (int ii = 12; ii < numKeys; ii += 2) {
+        expected.push_back(makeStoredDocKey("key" + std::to_string(ii)));
+    }
+    for (int ii = 1; ii < numKeys; ii += 2) {
+        expected.push_back(makeStoredDocKey("key" + std::to_string(ii)));
+    }
+    std::vector<StoredDocKey> keys;
+    for (const auto& item : items) {
+        keys.emplace_back(item->getKey());
+    }
+    EXPECT_EQ(expected, keys);
+
+    // The moved items are still found (and de-duplicated) via the key index.
+    for (int ii = 0; ii < numKeys; ii += 2) {
+        EXPECT_FALSE(this->queueNewItem("key" + std::to_string(ii)));
+    }
+    EXPECT_EQ(numKeys, manager->getNumOpenChkItems());
+    EXPECT_EQ(queueBytes, checkpoint.getWriteQueueAllocatorBytes());
+}
+
 // Test that the checkpoint memory stat is correctly maintained when
 // de-duplication occurs and also when the checkpoint containing the
 // mutation is removed.
@@ -1673,6 +1728,19 @@ TEST_P(CheckpointTest, checkpointMemoryTest) {
                     ->begin();
     index_entry entry{iterator, 0};
 
+    // Emulate the Checkpoint queue (toWrite), which already holds the dummy
+    // and checkpoint_start items, so we can determine the number of bytes
+    // that should be allocated as items are queued.
+    MemoryTrackingAllocator<queued_item> queueTrackingAllocator;
+    CheckpointQueue queue(queueTrackingAllocator);
+    for (const auto& qi :
+         *CheckpointManagerTestIntrospector::public_getCheckpointList(
+                  *(this->manager))
+                  .front()) {
+        queue.push_back(qi);
+    }
+    const auto initialQueueSize = *queueTrackingAllocator.getBytesAllocated();
+
     // Create a queued_item with a 'small' value
     std::string value("value");
     queued_item qiSmall(new Item(makeStoredDocKey("key"),
@@ -1692,18 +1760,15 @@ TEST_P(CheckpointTest, checkpointMemoryTest) {
                               GenerateCas::Yes,
                               /*preLinkDocCtx*/ nullptr);
 
-    // The queue (toWrite) is implemented as std:list, therefore
-    // when we add an item it results in the creation of 3 pointers -
-    // forward ptr, backward ptr and ptr to object.
-    const size_t perElementOverhead = 3 * sizeof(uintptr_t);
-
     // Check that checkpoint size is the initial size plus the addition of
     // qiSmall.
     auto expectedSize = initialSize;
     // Add the size of the item
     expectedSize += qiSmall->size();
     // Add the size of adding to the queue
-    expectedSize += perElementOverhead;
+    queue.push_back(qiSmall);
+    expectedSize += *queueTrackingAllocator.getBytesAllocated() -
+                    initialQueueSize;
     // Add to the emulated keyIndex
     keyIndex.emplace(CheckpointIndexKeyType(qiSmall->getKey(),
                                             keyIndexKeyTrackingAllocator),
@@ -1738,8 +1803,12 @@ TEST_P(CheckpointTest, checkpointMemoryTest) {
     expectedSize = initialSize;
     // Add the size of the item
     expectedSize += qiBig->size();
-    // Add the size of adding to the queue
-    expectedSize += perElementOverhead;
+    // Add the size of adding to the queue. De-duplicating qiSmall only nulls
+    // its slot, so qiBig takes a new slot.
+    queue.erase(std::prev(queue.end()));
+    queue.push_back(qiBig);
+    expectedSize += *queueTrackingAllocator.getBytesAllocated() -
+                    initialQueueSize;
     // Add to the keyIndex
     keyIndex.emplace(CheckpointIndexKeyType(qiBig->getKey(),
                                             keyIndexKeyTrackingAllocator),
@@ -1808,6 +1877,18 @@ TEST_P(CheckpointTest, checkpointTrackingMemoryOverheadTest) {
                     ->begin();
     index_entry entry{iterator, 0};
 
+    // Emulate the Checkpoint queue (toWrite) so we can determine the number
+    // of bytes that should be allocated when the item is queued.
+    MemoryTrackingAllocator<queued_item> queueTrackingAllocator;
+    CheckpointQueue queue(queueTrackingAllocator);
+    for (const auto& qi :
+         *CheckpointManagerTestIntrospector::public_getCheckpointList(
+                  *(this->manager))
+                  .front()) {
+        queue.push_back(qi);
+    }
+    const auto initialQueueSize = *queueTrackingAllocator.getBytesAllocated();
+
     // Create a queued_item
     std::string value("value");
     queued_item qiSmall(new Item(makeStoredDocKey("key"),
@@ -1829,15 +1910,17 @@ TEST_P(CheckpointTest, checkpointTrackingMemoryOverheadTest) {
 
     // Re-measure the checkpoint overhead
     const auto updatedOverhead = this->manager->getMemoryOverhead();
-    // Three pointers - forward, backward and pointer to item
-    const auto perElementListOverhead = sizeof(uintptr_t) * 3;
+    // Add the item to the emulated queue
+    queue.push_back(qiSmall);
+    const auto queueOverhead =
+            *queueTrackingAllocator.getBytesAllocated() - initialQueueSize;
     // Add entry into keyIndex
     keyIndex.emplace(CheckpointIndexKeyType(qiSmall->getKey(),
                                             keyIndexKeyTrackingAllocator),
                      entry);
 
     const auto keyIndexSize = *(keyIndex.get_allocator().getBytesAllocated());
-    EXPECT_EQ(perElementListOverhead + (keyIndexSize - initialKeyIndexSize),
+    EXPECT_EQ(queueOverhead + (keyIndexSize - initialKeyIndexSize),
               updatedOverhead - initialOverhead);
 
     bool isLastMutationItem;
@@ -1918,6 +2001,18 @@ TEST_P(CheckpointTest, checkpointTrackingMemoryOverheadDiskCheckpointTest) {
     // Get the intial size of the checkpoint overhead.
     const auto initialOverhead = this->manager->getMemoryOverhead();
 
+    // Emulate the (open) Checkpoint queue (toWrite) so we can determine the
+    // number of bytes that should be allocated when the item is queued.
+    MemoryTrackingAllocator<queued_item> queueTrackingAllocator;
+    CheckpointQueue queue(queueTrackingAllocator);
+    for (const auto& qi :
+         *CheckpointManagerTestIntrospector::public_getCheckpointList(
+                  *(this->manager))
+                  .back()) {
+        queue.push_back(qi);
+    }
+    const auto initialQueueSize = *queueTrackingAllocator.getBytesAllocated();
+
     auto keySize = 2000;
     std::string value("value");
     queued_item qiSmall(new Item(makeStoredDocKey(std::string(keySize, 'x')),
@@ -1937,11 +2032,12 @@ TEST_P(CheckpointTest, checkpointTrackingMemoryOverheadDiskCheckpointTest) {
                               GenerateCas::Yes,
                               /*preLinkDocCtx*/ nullptr);
 
-    // The queue (toWrite) is implemented as std:list, therefore when we add an
-    // item it results in the creation of 3 pointers - forward ptr, backward ptr
-    // and ptr to object. This is tracked under memoryOverhead.
-    const size_t perElementOverhead = 3 * sizeof(uintptr_t);
-    EXPECT_EQ(initialOverhead + perElementOverhead,
+    // Only the queue (toWrite) should have grown; this is tracked under
+    // memoryOverhead.
+    queue.push_back(qiSmall);
+    const auto queueOverhead =
+            *queueTrackingAllocator.getBytesAllocated() - initialQueueSize;
+    EXPECT_EQ(initialOverhead + queueOverhead,
               this->manager->getMemoryOverhead());
 }
 
@@ -2377,24 +2473,12 @@ void CheckpointTest::testExpelCheckpointItemsMemoryRecovered() {
     // Get the memory usage after expelling
     auto checkpointMemoryUsageAfterExpel = this->manager->getMemoryUsage();
 
-    size_t extra = 0;
-    // A list is comprised of 3 pointers (forward, backwards and
-    // pointer to the element).
-    const size_t perElementOverhead = extra + (3 * sizeof(uintptr_t));
-#if WIN32
-    // On windows for an empty list we still allocate space for
-    // containing one element.
-    extra = perElementOverhead;
-#if _DEBUG
-    // additional 16 bytes overhead in an empty list with Debug CRT.
-    extra += 16;
-#endif
-#endif
-
     const size_t reductionInCheckpointMemoryUsage =
             checkpointMemoryUsageBeforeExpel - checkpointMemoryUsageAfterExpel;
-    const size_t checkpointListSaving =
-            (perElementOverhead * expelResult.expelCount);
+    // The queue (toWrite) only releases memory once all the slots of a chunk
+    // have been expelled; here everything still fits in the first chunk.
+    ASSERT_LT(5, CheckpointQueue::slotsPerChunk);
+    const size_t checkpointListSaving = 0;
     const auto& checkpointStartItem =
             this->manager->public_createCheckpointItem(
                     0, Vbid(0), queue_op::checkpoint_start);
@@ -2404,8 +2488,7 @@ void CheckpointTest::testExpelCheckpointItemsMemoryRecovered() {
             checkpointListSaving + queuedItemSaving;
 
     EXPECT_EQ(3, expelResult.expelCount);
-    EXPECT_EQ(expectedMemoryRecovered,
-              expelResult.estimateOfFreeMemory - extra);
+    EXPECT_EQ(expectedMemoryRecovered, expelResult.estimateOfFreeMemory);
     EXPECT_EQ(expectedMemoryRecovered, reductionInCheckpointMemoryUsage);
     EXPECT_EQ(3, this->global_stats.itemsExpelledFromCheckpoints);
 }
@@ -0,0 +1,213 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "atomic.h"
+
+#include "checkpoint_iterator.h"
+#include "chunked_queue.h"
+
+#include <folly/portability/GTest.h>
+#include <utilities/memory_tracking_allocator.h>
+
+/*
+ * Unit tests for the ChunkedQueue
+ */
+
+namespace {
+class MyInt : public RCValue {
+public:
+    explicit MyInt(int v) : value(v) {
+    }
+
+    int getValue() const {
+        return value;
+    }
+
+private:
+    int value;
+};
+
+} // namespace
+
+typedef SingleThreadedRCPtr<MyInt> TestItem;
+
+class ChunkedQueueTest : public ::testing::Test {
+protected:
+    using Queue = ChunkedQueue<TestItem, MemoryTrackingAllocator<TestItem>, 4>;
+    using QueueIterator = CheckpointIterator<Queue>;
+
+    size_t bytesAllocated() const {
+        return *allocator.getBytesAllocated();
+    }
+
+    void pushItems(int first, int last) {
+        for (int ii = first; ii < last; ++ii) {
+            queue.push_back(TestItem(new MyInt(ii)));
+        }
+    }
+
+    MemoryTrackingAllocator<TestItem> allocator;
+    Queue queue{allocator};
+};
+
+TEST_F(ChunkedQueueTest, Empty) {
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(0, queue.size());
+    EXPECT_EQ(queue.end(), queue.begin());
+    EXPECT_EQ(0, bytesAllocated());
+}
+
+// Elements are returned in FIFO order across chunk boundaries, and memory is
+// allocated (and freed) a whole chunk at a time.
+TEST_F(ChunkedQueueTest, PushPop) {
+    pushItems(0, 10);
+    EXPECT_EQ(10, queue.size());
+    EXPECT_EQ(3 * Queue::getChunkSize(), bytesAllocated());
+
+    int expected = 0;
+    for (const auto& item : queue) {
+        EXPECT_EQ(expected++, item->getValue());
+    }
+    EXPECT_EQ(10, expected);
+    EXPECT_EQ(9, queue.back()->getValue());
+
+    // Popping the first chunk's worth of items frees it.
+    for (int ii = 0; ii < 4; ++ii) {
+        EXPECT_EQ(ii, queue.pop_front()->getValue());
+    }
+    EXPECT_EQ(6, queue.size());
+    EXPECT_EQ(2 * Queue::getChunkSize(), bytesAllocated());
+
+    while (!queue.empty()) {
+        queue.pop_front();
+    }
+    // The partially used tail chunk is retained for re-use.
+    EXPECT_EQ(Queue::getChunkSize(), bytesAllocated());
+    EXPECT_EQ(queue.end(), queue.begin());
+
+    pushItems(10, 12);
+    EXPECT_EQ(Queue::getChunkSize(), bytesAllocated());
+    EXPECT_EQ(10, queue.front()->getValue());
+
+    queue.clear();
+    EXPECT_EQ(0, bytesAllocated());
+}
+
+// Erasing an element nulls its slot without affecting other iterators.
+TEST_F(ChunkedQueueTest, Erase) {
+    pushItems(0, 6);
+    auto second = std::next(queue.begin());
+    auto fifth = std::next(queue.begin(), 4);
+
+    queue.erase(second);
+    EXPECT_EQ(5, queue.size());
+    EXPECT_EQ(nullptr, second->get());
+    EXPECT_EQ(4, (*fifth)->getValue());
+
+    // The null slot is still popped, but not counted.
+    EXPECT_EQ(0, queue.pop_front()->getValue());
+    EXPECT_EQ(nullptr, queue.pop_front().get());
+    EXPECT_EQ(4, queue.size());
+
+    // CheckpointIterator skips erased elements.
+    queue.erase(fifth);
+    std::vector<int> values;
+    for (auto it = QueueIterator(queue, QueueIterator::Position::begin);
+         it != QueueIterator(queue, QueueIterator::Position::end);
+         ++it) {
+        values.push_back((*it)->getValue());
+    }
+    EXPECT_EQ(std::vector<int>({2, 3, 5}), values);
+}
+
+// An iterator to the last element moves onto elements pushed after it was
+// taken, and end() can be decremented to the last element.
+TEST_F(ChunkedQueueTest, IteratorStableOverPush) {
+    pushItems(0, 4);
+    auto last = std::prev(queue.end());
+    EXPECT_EQ(3, (*last)->getValue());
+
+    // Next push starts a new chunk.
+    pushItems(4, 5);
+    ++last;
+    ASSERT_NE(queue.end(), last);
+    EXPECT_EQ(4, (*last)->getValue());
+    ++last;
+    EXPECT_EQ(queue.end(), last);
+
+    --last;
+    --last;
+    EXPECT_EQ(3, (*last)->getValue());
+}
+
+// Moving a queue transfers its chunks.
+TEST_F(ChunkedQueueTest, Move) {
+    pushItems(0, 5);
+    Queue other(std::move(queue));
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(5, other.size());
+    EXPECT_EQ(2 * Queue::getChunkSize(), bytesAllocated());
+
+    queue = std::move(other);
+    EXPECT_EQ(5, queue.size());
+    EXPECT_EQ(0, queue.front()->getValue());
+    EXPECT_EQ(2 * Queue::getChunkSize(), bytesAllocated());
+}
+
+// Compacting merges a chunk with its neighbour once their elements fit in one
+// chunk, reporting each element moved before it is moved.
+TEST_F(ChunkedQueueTest, Compact) {
+    pushItems(0, 12);
+    ASSERT_EQ(3 * Queue::getChunkSize(), bytesAllocated());
+    for (int value : {1, 2, 5, 6}) {
+        queue.erase(std::next(queue.begin(), value));
+    }
+
+    std::vector<int> moved;
+    auto relocated = [&moved](auto from, auto to) {
+        EXPECT_NE(nullptr, from->get());
+        EXPECT_EQ(nullptr, to->get());
+        moved.push_back((*from)->getValue());
+    };
+    // The first two chunks now hold {0, 3} and {4, 7}.
+    EXPECT_TRUE(queue.compact(std::next(queue.begin(), 4), relocated));
+    EXPECT_EQ(std::vector<int>({3, 4, 7}), moved);
+    EXPECT_EQ(2 * Queue::getChunkSize(), bytesAllocated());
+    EXPECT_EQ(8, queue.size());
+
+    std::vector<int> values;
+    for (const auto& item : queue) {
+        values.push_back(item->getValue());
+    }
+    EXPECT_EQ(std::vector<int>({0, 3, 4, 7, 8, 9, 10, 11}), values);
+
+    // No merge if the elements don't fit in one chunk.
+    moved.clear();
+    queue.erase(std::next(queue.begin(), 4));
+    EXPECT_FALSE(queue.compact(std::next(queue.begin(), 4), relocated));
+    EXPECT_TRUE(moved.empty());
+    EXPECT_EQ(2 * Queue::getChunkSize(), bytesAllocated());
+
+    // The merged chunk is still the tail when pushing more elements.
+    pushItems(12, 14);
+    values.clear();
+    while (!queue.empty()) {
+        if (auto item = queue.pop_front()) {
+            values.push_back(item->getValue());
+        }
+    }
+    EXPECT_EQ(std::vector<int>({0, 3, 4, 7, 9, 10, 11, 12, 13}), values);
+}
@@ -584,9 +584,12 @@ TEST_F(CouchKVStoreErrorInjectionTest, initializeWithHeaderButNoVBState) {
         vbucket_state state;
         state.maxVisibleSeqno = 10;
 
-        kvstore->snapshotVBucket(vbid, state);
+        EXPECT_FALSE(kvstore->snapshotVBucket(vbid, state));
     }
 
+    // The cached vbstate of the failed write has been discarded
+    EXPECT_FALSE(kvstore->getVBucketState(vbid));
+
     // vbucket_state is still default as readVBState returns a default value
     // instead of a non-success status or exception...
     vbucket_state defaultState;
@@ -732,6 +735,84 @@ TEST_F(CouchKVStoreErrorInjectionTest, commit_commit) {
     }
 }
 
+/// TransactionContext recording the state of each set persisted.
+class RecordingTransactionContext : public TransactionContext {
+public:
+    RecordingTransactionContext(
+            Vbid vbid, std::vector<KVStore::FlushStateMutation>& states)
+        : TransactionContext(vbid), states(states) {
+    }
+
+    void setCallback(const queued_item&,
+                     KVStore::FlushStateMutation state) override {
+        states.push_back(state);
+    }
+
+    std::vector<KVStore::FlushStateMutation>& states;
+};
+
+/**
+ * With deferred sync (group commit) the persistence callbacks of a commit
+ * are only invoked once the commit is synced.
+ */
+TEST_F(CouchKVStoreErrorInjectionTest, commit_deferred_sync) {
+    generate_items(1);
+    ASSERT_TRUE(kvstore->setDeferredSync(true));
+
+    std::vector<KVStore::FlushStateMutation> states;
+    kvstore->begin(std::make_unique<RecordingTransactionContext>(vbid, states));
+    kvstore->set(items.front());
+    EXPECT_TRUE(kvstore->commit(flush));
+    EXPECT_TRUE(states.empty());
+    // The file stats are not cached until the commit is durable
+    EXPECT_EQ(0, kvstore->getItemCount(vbid));
+
+    // Only the header sync of the commit is outstanding.
+    EXPECT_CALL(ops, sync(_, _)).Times(1).RetiresOnSaturation();
+    EXPECT_TRUE(kvstore->syncDeferredCommits().empty());
+    EXPECT_EQ(std::vector<KVStore::FlushStateMutation>{
+                      KVStore::FlushStateMutation::Insert},
+              states);
+    EXPECT_EQ(1, kvstore->getItemCount(vbid));
+
+    kvstore->setDeferredSync(false);
+}
+
+/**
+ * Injects error during CouchKVStore::syncDeferredCommits
+ */
+TEST_F(CouchKVStoreErrorInjectionTest, syncDeferredCommits_sync) {
+    generate_items(1);
+    ASSERT_TRUE(kvstore->setDeferredSync(true));
+
+    std::vector<KVStore::FlushStateMutation> states;
+    kvstore->begin(std::make_unique<RecordingTransactionContext>(vbid, states));
+    kvstore->set(items.front());
+    EXPECT_TRUE(kvstore->commit(flush));
+    {
+        /* Establish Logger expectation */
+        EXPECT_CALL(logger, mlog(_, _)).Times(AnyNumber());
+        EXPECT_CALL(logger,
+                    mlog(Ge(spdlog::level::level_enum::warn),
+                         VCE(COUCHSTORE_ERROR_WRITE)))
+                .Times(1)
+                .RetiresOnSaturation();
+
+        /* Establish FileOps expectation */
+        EXPECT_CALL(ops, sync(_, _))
+                .WillOnce(Return(COUCHSTORE_ERROR_WRITE))
+                .RetiresOnSaturation();
+
+        EXPECT_EQ(std::vector<Vbid>{vbid}, kvstore->syncDeferredCommits());
+    }
+    EXPECT_EQ(std::vector<KVStore::FlushStateMutation>{
+                      KVStore::FlushStateMutation::Failed},
+              states);
+    EXPECT_EQ(0, kvstore->getItemCount(vbid));
+
+    kvstore->setDeferredSync(false);
+}
+
 /**
  * Injects error during CouchKVStore::get/couchstore_docinfo_by_id
  */
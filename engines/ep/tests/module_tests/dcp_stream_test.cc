@@ -2507,6 +2507,245 @@ TEST_P(SingleThreadedPassiveStreamTest, MB_33773_oom_close) {
     mb_33773(mb_33773Mode::noMemoryAndClosed);
 }
 
+// Buffered mutations are applied as batches (runs of mutations between other
+// messages); check the batches split at snapshot markers, that a mutation
+// outside of its snapshot is still dropped and not acked, and that the
+// mutations are queued in seqno order.
+TEST_P(SingleThreadedPassiveStreamTest, ProcessBufferedMutationBatches) {
+    const uint32_t opaque = 1;
+
+    // Trick the replication throttle into returning pause so that all
+    // messages are buffered.
+    engine->getReplicationThrottle().adjustWriteQueueCap(0);
+    const size_t size = engine->getEpStats().getMaxDataSize();
+    engine->getEpStats().setMaxDataSize(1);
+    ASSERT_EQ(ReplicationThrottle::Status::Pause,
+              engine->getReplicationThrottle().getStatus());
+
+    auto mutation = [this, opaque](uint64_t seqno) {
+        EXPECT_EQ(ENGINE_SUCCESS,
+                  consumer->mutation(
+                          opaque,
+                          makeStoredDocKey("k" + std::to_string(seqno)),
+                          {},
+                          0,
+                          0,
+                          0,
+                          vbid,
+                          0,
+                          seqno,
+                          0,
+                          0,
+                          0,
+                          {},
+                          0));
+    };
+
+    // Snapshot [1, 5], followed by an erroneous mutation at seqno 6
+    consumer->snapshotMarker(opaque,
+                             vbid,
+                             1,
+                             5,
+                             dcp_marker_flag_t::MARKER_FLAG_MEMORY,
+                             {} /*HCS*/,
+                             {} /*maxVisibleSeqno*/);
+    for (uint64_t seqno = 1; seqno <= 6; seqno++) {
+        mutation(seqno);
+    }
+    // Snapshot [7, 9]
+    consumer->snapshotMarker(opaque,
+                             vbid,
+                             7,
+                             9,
+                             dcp_marker_flag_t::MARKER_FLAG_MEMORY,
+                             {} /*HCS*/,
+                             {} /*maxVisibleSeqno*/);
+    for (uint64_t seqno = 7; seqno <= 9; seqno++) {
+        mutation(seqno);
+    }
+    ASSERT_EQ(11, stream->getNumBufferItems());
+    engine->getEpStats().setMaxDataSize(size); // undo the quota adjustment
+
+    uint32_t expectedBytes = 0;
+    for (const auto& message : stream->getBufferMessages()) {
+        if (message->getBySeqno().value_or(0) != 6) {
+            expectedBytes += message->getMessageSize();
+        }
+    }
+
+    uint32_t bytesProcessed = 0;
+    EXPECT_EQ(all_processed,
+              stream->processBufferedMessages(bytesProcessed,
+                                              100 /*batchSize*/));
+    EXPECT_EQ(0, stream->getNumBufferItems());
+    EXPECT_EQ(expectedBytes, bytesProcessed);
+
+    auto vb = engine->getVBucket(vbid);
+    EXPECT_EQ(9, vb->getHighSeqno());
+    {
+        auto res = vb->ht.findForRead(makeStoredDocKey("k6"));
+        EXPECT_FALSE(res.storedValue);
+    }
+
+    auto& ckptMgr = static_cast<MockCheckpointManager&>(*vb->checkpointManager);
+    std::vector<queued_item> items;
+    ckptMgr.getNextItemsForPersistence(items);
+    uint64_t prevSeqno = 0;
+    size_t mutations = 0;
+    for (const auto& item : items) {
+        if (item->getOperation() == queue_op::mutation) {
+            EXPECT_GT(item->getBySeqno(), prevSeqno);
+            prevSeqno = item->getBySeqno();
+            ++mutations;
+        }
+    }
+    EXPECT_EQ(8, mutations);
+}
+
+void SingleThreadedPassiveStreamTest::bufferSnapshots(
+        const std::vector<std::pair<uint64_t, uint64_t>>& snapshots) {
+    const uint32_t opaque = 1;
+
+    // Trick the replication throttle into returning pause so that all
+    // messages are buffered.
+    engine->getReplicationThrottle().adjustWriteQueueCap(0);
+    const size_t size = engine->getEpStats().getMaxDataSize();
+    engine->getEpStats().setMaxDataSize(1);
+    ASSERT_EQ(ReplicationThrottle::Status::Pause,
+              engine->getReplicationThrottle().getStatus());
+
+    size_t messages = 0;
+    for (const auto& [start, end] : snapshots) {
+        consumer->snapshotMarker(opaque,
+                                 vbid,
+                                 start,
+                                 end,
+                                 dcp_marker_flag_t::MARKER_FLAG_MEMORY,
+                                 {} /*HCS*/,
+                                 {} /*maxVisibleSeqno*/);
+        for (uint64_t seqno = start; seqno <= end; seqno++) {
+            EXPECT_EQ(ENGINE_SUCCESS,
+                      consumer->mutation(
+                              opaque,
+                              makeStoredDocKey("k" + std::to_string(seqno)),
+                              {},
+                              0,
+                              0,
+                              0,
+                              vbid,
+                              0,
+                              seqno,
+                              0,
+                              0,
+                              0,
+                              {},
+                              0));
+        }
+        messages += 1 + (end - start + 1);
+    }
+    ASSERT_EQ(messages, stream->getNumBufferItems());
+    engine->getEpStats().setMaxDataSize(size); // undo the quota adjustment
+}
+
+// A mutation batch which fails with TMPFAIL must be given back to the buffer
+// intact (after the messages processed before it) and be applied in full at
+// the next run.
+TEST_P(SingleThreadedPassiveStreamTest, ProcessBufferedMutationBatchesRetry) {
+    // marker, batch [1, 3], marker, batch [4, 6]
+    bufferSnapshots({{1, 3}, {4, 6}});
+
+    uint32_t firstBytes = 0, retryBytes = 0;
+    size_t ii = 0;
+    for (const auto& message : stream->getBufferMessages()) {
+        (ii++ < 5 ? firstBytes : retryBytes) += message->getMessageSize();
+    }
+
+    // Fail the second batch: setWithMeta returns TMPFAIL while a takeover is
+    // backed up.
+    auto vb = engine->getVBucket(vbid);
+    size_t hookCalls = 0;
+    stream->setProcessBufferedMessages_postFront_Hook([&vb, &hookCalls]() {
+        if (++hookCalls == 4) {
+            vb->setTakeoverBackedUpState(true);
+        }
+    });
+
+    uint32_t bytesProcessed = 0;
+    EXPECT_EQ(cannot_process,
+              stream->processBufferedMessages(bytesProcessed,
+                                              100 /*batchSize*/));
+    EXPECT_EQ(4, hookCalls);
+    ASSERT_EQ(3, stream->getNumBufferItems());
+    for (const auto& message : stream->getBufferMessages()) {
+        ASSERT_TRUE(message);
+        EXPECT_EQ(DcpResponse::Event::Mutation, message->getEvent());
+    }
+    EXPECT_EQ(4, *stream->getBufferMessages().front()->getBySeqno());
+    EXPECT_EQ(firstBytes, bytesProcessed);
+    EXPECT_EQ(3, vb->getHighSeqno());
+
+    vb->setTakeoverBackedUpState(false);
+    EXPECT_EQ(all_processed,
+              stream->processBufferedMessages(bytesProcessed,
+                                              100 /*batchSize*/));
+    EXPECT_EQ(0, stream->getNumBufferItems());
+    EXPECT_EQ(retryBytes, bytesProcessed);
+    EXPECT_EQ(6, vb->getHighSeqno());
+    for (uint64_t seqno = 1; seqno <= 6; seqno++) {
+        auto res = vb->ht.findForRead(
+                makeStoredDocKey("k" + std::to_string(seqno)));
+        ASSERT_TRUE(res.storedValue);
+        EXPECT_EQ(seqno, res.storedValue->getBySeqno());
+    }
+}
+
+// A stream closed while a mutation batch is being applied: the rest of the
+// buffer is dropped, and the bytes of the batch are returned to flow control
+// once only (by setDead), not again as processed bytes.
+TEST_P(SingleThreadedPassiveStreamTest,
+       ProcessBufferedMutationBatchesStreamDead) {
+    // marker, batch [1, 3], marker, batch [4, 6], marker, batch [7, 9]
+    bufferSnapshots({{1, 3}, {4, 6}, {7, 9}});
+
+    uint32_t firstBytes = 0, totalBytes = 0;
+    size_t ii = 0;
+    for (const auto& message : stream->getBufferMessages()) {
+        if (ii++ < 5) {
+            firstBytes += message->getMessageSize();
+        }
+        totalBytes += message->getMessageSize();
+    }
+
+    // Close the stream just before the second batch is applied
+    const auto freedBytes = consumer->getFlowControl().getFreedBytes();
+    size_t hookCalls = 0;
+    stream->setProcessBufferedMessages_postFront_Hook([this, &hookCalls]() {
+        if (++hookCalls == 4) {
+            consumer->closeStreamDueToVbStateChange(vbid,
+                                                    vbucket_state_active);
+        }
+    });
+
+    uint32_t bytesProcessed = 0;
+    EXPECT_EQ(all_processed,
+              stream->processBufferedMessages(bytesProcessed,
+                                              100 /*batchSize*/));
+    EXPECT_EQ(4, hookCalls);
+    EXPECT_FALSE(stream->isActive());
+    EXPECT_EQ(0, stream->getNumBufferItems());
+    EXPECT_EQ(firstBytes, bytesProcessed);
+    EXPECT_EQ(totalBytes,
+              bytesProcessed +
+                      (consumer->getFlowControl().getFreedBytes() -
+                       freedBytes));
+
+    // The batch in flight was applied, the last snapshot was dropped
+    auto vb = engine->getVBucket(vbid);
+    EXPECT_EQ(6, vb->getHighSeqno());
+    auto res = vb->ht.findForRead(makeStoredDocKey("k7"));
+    EXPECT_FALSE(res.storedValue);
+}
+
 void SingleThreadedPassiveStreamTest::
         testInitialDiskSnapshotFlagClearedOnTransitionToActive(
                 vbucket_state_t initialState) {
@@ -163,6 +163,13 @@ protected:
     };
     void mb_33773(mb_33773Mode mode);
 
+    /**
+     * Buffer (by pausing the replication throttle) a snapshot marker followed
+     * by a mutation per seqno for each of the given [start, end] snapshots.
+     */
+    void bufferSnapshots(
+            const std::vector<std::pair<uint64_t, uint64_t>>& snapshots);
+
     /**
      * Test that when we transition state to active we clear the
      * initialDiskSnapshot flag to ensure that we can stream from this vBucket.
@@ -27,6 +27,7 @@
 #include "durability/active_durability_monitor.h"
 
 #include "../mock/mock_synchronous_ep_engine.h"
+#include <programs/engine_testapp/mock_cookie.h>
 
 void ActiveDurabilityMonitorTest::SetUp() {
     // MB-34453: Change sync_writes_max_allowed_replicas back to total
@@ -1950,6 +1951,70 @@ TEST_P(ActiveDurabilityMonitorTest, dropLastKeyAndCompleteFirst) {
     EXPECT_EQ(1, adm.getHighCompletedSeqno());
 }
 
+/**
+ * SyncWrites resolved together are completed as a batch: the State (HCS and
+ * the commit / abort counters) only reflects them once the completed queue
+ * is processed, and then every client in the batch is notified. Only the
+ * SyncWrites resolved so far are completed when the queue is processed
+ * partway through the tracked ones.
+ */
+TEST_P(ActiveDurabilityMonitorTest, CompleteSyncWritesInBatches) {
+    // Note: Topology set to {{active, replica1}} in test setup
+    auto& adm = getActiveDM();
+    ASSERT_EQ(5, addSyncWrites(1 /*seqnoStart*/, 5 /*seqnoEnd*/));
+    const auto notified = get_number_of_mock_cookie_io_notifications(cookie);
+
+    // Partial batch: the ack resolves only the first 2 Prepares.
+    adm.seqnoAckReceived(replica1, 2);
+    EXPECT_EQ(3, adm.getNumTracked());
+    EXPECT_EQ(0, adm.getNumCommitted());
+    EXPECT_EQ(0, adm.getHighCompletedSeqno());
+    EXPECT_EQ(notified, get_number_of_mock_cookie_io_notifications(cookie));
+
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(2, adm.getNumCommitted());
+    EXPECT_EQ(2, adm.getHighCompletedSeqno());
+    EXPECT_EQ(notified + 2,
+              get_number_of_mock_cookie_io_notifications(cookie));
+    {
+        SCOPED_TRACE("");
+        assertNumTrackedAndHPSAndHCS(3, 5, 2);
+    }
+
+    // The rest of the batch.
+    adm.seqnoAckReceived(replica1, 5);
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(5, adm.getNumCommitted());
+    EXPECT_EQ(0, adm.getNumAborted());
+    EXPECT_EQ(notified + 5,
+              get_number_of_mock_cookie_io_notifications(cookie));
+    {
+        SCOPED_TRACE("");
+        assertNumTrackedAndHPSAndHCS(0, 5, 5);
+    }
+
+    // A batch of aborts.
+    ASSERT_EQ(3,
+              addSyncWrites(6 /*seqnoStart*/,
+                            8 /*seqnoEnd*/,
+                            {cb::durability::Level::Majority,
+                             cb::durability::Timeout(1)}));
+    adm.processTimeout(std::chrono::steady_clock::now() +
+                       std::chrono::milliseconds(1000));
+    EXPECT_EQ(0, adm.getNumAborted());
+    EXPECT_EQ(5, adm.getHighCompletedSeqno());
+
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(5, adm.getNumCommitted());
+    EXPECT_EQ(3, adm.getNumAborted());
+    EXPECT_EQ(notified + 8,
+              get_number_of_mock_cookie_io_notifications(cookie));
+    {
+        SCOPED_TRACE("");
+        assertNumTrackedAndHPSAndHCS(0, 8, 8);
+    }
+}
+
 void PassiveDurabilityMonitorTest::SetUp() {
     STParameterizedBucketTest::SetUp();
     setVBucketStateAndRunPersistTask(vbid, vbucket_state_replica);
@@ -33,8 +33,10 @@
 
 /**
  * Test fixture for VBucket-level tests specific to Ephemeral VBuckets.
+ * Parameterised on the ephemeral_seqlist_type.
  */
-class EphemeralVBucketTest : public VBucketTestBase, public ::testing::Test {
+class EphemeralVBucketTest : public VBucketTestBase,
+                             public ::testing::TestWithParam<std::string> {
 public:
     EphemeralVBucketTest()
         : VBucketTestBase(VBType::Ephemeral, EvictionPolicy::Value) {
@@ -42,6 +44,12 @@ public:
 
 protected:
     void SetUp() override {
+        config.parseConfiguration(("bucket_type=ephemeral;"
+                                   "ephemeral_seqlist_type=" +
+                                   GetParam())
+                                          .c_str(),
+                                  get_mock_server_api());
+
         /* to test ephemeral vbucket specific stuff */
         mockEpheVB = new MockEphemeralVBucket(Vbid(0),
                                               vbucket_state_active,
@@ -76,9 +84,19 @@ protected:
     Configuration config;
 };
 
+static std::string seqListTypeName(
+        const ::testing::TestParamInfo<std::string>& info) {
+    return info.param;
+}
+
+INSTANTIATE_TEST_SUITE_P(SeqListTypes,
+                         EphemeralVBucketTest,
+                         ::testing::Values("linked_list", "skip_list"),
+                         seqListTypeName);
+
 // Verify that attempting to pageOut an item twice has no effect the second
 // time.
-TEST_F(EphemeralVBucketTest, DoublePageOut) {
+TEST_P(EphemeralVBucketTest, DoublePageOut) {
     auto key = makeStoredDocKey("key");
     ASSERT_EQ(AddStatus::Success, addOne(key));
     ASSERT_EQ(1, vbucket->getNumItems());
@@ -120,7 +138,7 @@ TEST_F(EphemeralVBucketTest, DoublePageOut) {
 
 // Verify that we can pageOut deleted items which have a value associated with
 // them - and afterwards the value is null.
-TEST_F(EphemeralVBucketTest, PageOutAfterDeleteWithValue) {
+TEST_P(EphemeralVBucketTest, PageOutAfterDeleteWithValue) {
     // Add an item which is marked as deleted, but has a body (e.g. system
     // XATTR).
     auto key = makeStoredDocKey("key");
@@ -151,7 +169,7 @@ TEST_F(EphemeralVBucketTest, PageOutAfterDeleteWithValue) {
 
 // NRU: check the seqlist has correct statistics for a create, pageout,
 // and (re)create of the same key.
-TEST_F(EphemeralVBucketTest, CreatePageoutCreate) {
+TEST_P(EphemeralVBucketTest, CreatePageoutCreate) {
     auto key = makeStoredDocKey("key");
 
     // Add a key, then page out.
@@ -215,7 +233,7 @@ TEST_F(EphemeralVBucketTest, CreatePageoutCreate) {
     EXPECT_EQ(1, mockEpheVB->getLL()->getNumDeletedItems());
 }
 
-TEST_F(EphemeralVBucketTest, SetItems) {
+TEST_P(EphemeralVBucketTest, SetItems) {
     const int numItems = 3;
 
     auto keys = generateKeys(numItems);
@@ -225,7 +243,7 @@ TEST_F(EphemeralVBucketTest, SetItems) {
     EXPECT_EQ(numItems, vbucket->getHighSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, UpdateItems) {
+TEST_P(EphemeralVBucketTest, UpdateItems) {
     /* Add 3 items and then update all of them */
     const int numItems = 3;
 
@@ -239,7 +257,7 @@ TEST_F(EphemeralVBucketTest, UpdateItems) {
     EXPECT_EQ(numItems, vbucket->getNumItems());
 }
 
-TEST_F(EphemeralVBucketTest, SoftDelete) {
+TEST_P(EphemeralVBucketTest, SoftDelete) {
     /* Add 3 items and then delete all of them */
     const int numItems = 3;
 
@@ -253,7 +271,7 @@ TEST_F(EphemeralVBucketTest, SoftDelete) {
     EXPECT_EQ(0, vbucket->getNumItems());
 }
 
-TEST_F(EphemeralVBucketTest, AddItems) {
+TEST_P(EphemeralVBucketTest, AddItems) {
     const int numItems = 3;
 
     auto keys = generateKeys(numItems);
@@ -262,7 +280,7 @@ TEST_F(EphemeralVBucketTest, AddItems) {
     EXPECT_EQ(numItems, vbucket->getHighSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, AddTempItem) {
+TEST_P(EphemeralVBucketTest, AddTempItem) {
     /* Add temp item */
     EXPECT_EQ(TempAddStatus::BgFetch, addOneTemp(makeStoredDocKey("one")));
 
@@ -278,7 +296,7 @@ TEST_F(EphemeralVBucketTest, AddTempItem) {
     EXPECT_EQ(0, mockEpheVB->public_getListHighSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, AddTempItemAndUpdate) {
+TEST_P(EphemeralVBucketTest, AddTempItemAndUpdate) {
     const StoredDocKey k = makeStoredDocKey("one");
 
     /* Add temp item */
@@ -301,7 +319,7 @@ TEST_F(EphemeralVBucketTest, AddTempItemAndUpdate) {
     EXPECT_EQ(1, mockEpheVB->public_getListHighSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, AddTempItemAndSoftDelete) {
+TEST_P(EphemeralVBucketTest, AddTempItemAndSoftDelete) {
     const StoredDocKey k = makeStoredDocKey("one");
 
     /* Add temp item */
@@ -326,7 +344,7 @@ TEST_F(EphemeralVBucketTest, AddTempItemAndSoftDelete) {
     EXPECT_EQ(1, mockEpheVB->public_getListHighSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, Backfill) {
+TEST_P(EphemeralVBucketTest, Backfill) {
     /* Add 3 items and get them by backfill */
     const int numItems = 3;
 
@@ -338,7 +356,7 @@ TEST_F(EphemeralVBucketTest, Backfill) {
     EXPECT_EQ(numItems, std::get<1>(res).size());
 }
 
-TEST_F(EphemeralVBucketTest, UpdateDuringBackfill) {
+TEST_P(EphemeralVBucketTest, UpdateDuringBackfill) {
     /* Add 5 items and then update all of them */
     const int numItems = 5;
 
@@ -369,7 +387,7 @@ TEST_F(EphemeralVBucketTest, UpdateDuringBackfill) {
               mockEpheVB->public_getNumListItems());
 }
 
-TEST_F(EphemeralVBucketTest, GetAndUpdateTtl) {
+TEST_P(EphemeralVBucketTest, GetAndUpdateTtl) {
     const int numItems = 2;
 
     /* Add 2 keys */
@@ -412,7 +430,7 @@ TEST_F(EphemeralVBucketTest, GetAndUpdateTtl) {
     /* There should be 1 stale item */
     EXPECT_EQ(1, mockEpheVB->public_getNumStaleItems());
 
-    auto seqNoVec = mockEpheVB->getLL()->getAllSeqnoForVerification();
+    auto seqNoVec = mockEpheVB->getAllSeqnoForVerification();
     seqno_t prevSeqNo = 0;
 
     for (const auto& seqNo : seqNoVec) {
@@ -421,7 +439,7 @@ TEST_F(EphemeralVBucketTest, GetAndUpdateTtl) {
     }
 }
 
-TEST_F(EphemeralVBucketTest, SoftDeleteDuringBackfill) {
+TEST_P(EphemeralVBucketTest, SoftDeleteDuringBackfill) {
     /* Add 5 items and then soft delete all of them */
     const int numItems = 5;
 
@@ -466,12 +484,17 @@ protected:
     std::vector<StoredDocKey> keys;
 };
 
+INSTANTIATE_TEST_SUITE_P(SeqListTypes,
+                         EphTombstoneTest,
+                         ::testing::Values("linked_list", "skip_list"),
+                         seqListTypeName);
+
 /**
  * MB-31175. We should not be able to delete a tombstone that has been deleted
  * after the HTTombstonePurger starts running as this could cause int underflow
  * and the subsequent deletion of the tombstone before the purgeAge
  */
-TEST_F(EphTombstoneTest, DeleteAfterPurgeStarts) {
+TEST_P(EphTombstoneTest, DeleteAfterPurgeStarts) {
     // Delete an item after the task starts but before the purgeArge
     {
         TimeTraveller toTheFuture(1985);
@@ -490,7 +513,7 @@ TEST_F(EphTombstoneTest, DeleteAfterPurgeStarts) {
 }
 
 // Check an empty seqList is handled correctly.
-TEST_F(EphTombstoneTest, ZeroElementPurge) {
+TEST_P(EphTombstoneTest, ZeroElementPurge) {
     // Create a new empty VB (using parent class SetUp).
     EphemeralVBucketTest::SetUp();
     ASSERT_EQ(0, mockEpheVB->public_getNumListItems());
@@ -500,7 +523,7 @@ TEST_F(EphTombstoneTest, ZeroElementPurge) {
 }
 
 // Check a seqList with one element is handled correctly.
-TEST_F(EphTombstoneTest, OneElementPurge) {
+TEST_P(EphTombstoneTest, OneElementPurge) {
     // Create a new empty VB (using parent class SetUp).
     EphemeralVBucketTest::SetUp();
     ASSERT_EQ(MutationStatus::WasClean, setOne(makeStoredDocKey("one")));
@@ -511,7 +534,7 @@ TEST_F(EphTombstoneTest, OneElementPurge) {
 }
 
 // Check that nothing is purged if no items are stale.
-TEST_F(EphTombstoneTest, NoPurgeIfNoneStale) {
+TEST_P(EphTombstoneTest, NoPurgeIfNoneStale) {
     // Run purger - nothing should be removed.
     EXPECT_EQ(0, mockEpheVB->markOldTombstonesStale(0));
     EXPECT_EQ(0, mockEpheVB->purgeStaleItems());
@@ -519,7 +542,7 @@ TEST_F(EphTombstoneTest, NoPurgeIfNoneStale) {
 }
 
 // Check that deletes are not purged if they are not old enough.
-TEST_F(EphTombstoneTest, NoPurgeIfNoneOldEnough) {
+TEST_P(EphTombstoneTest, NoPurgeIfNoneOldEnough) {
     // Delete the first item "now"
     softDeleteOne(keys.at(0), MutationStatus::WasDirty);
     ASSERT_EQ(2, vbucket->getNumItems());
@@ -537,7 +560,7 @@ TEST_F(EphTombstoneTest, NoPurgeIfNoneOldEnough) {
 }
 
 // Check that items should be purged when they are old enough.
-TEST_F(EphTombstoneTest, OnePurgeIfDeletedItemOld) {
+TEST_P(EphTombstoneTest, OnePurgeIfDeletedItemOld) {
     // Delete the first item "now"
     softDeleteOne(keys.at(0), MutationStatus::WasDirty);
     ASSERT_EQ(2, vbucket->getNumItems());
@@ -571,7 +594,7 @@ TEST_F(EphTombstoneTest, OnePurgeIfDeletedItemOld) {
 }
 
 /* Do not purge the last (back of the list) deleted stale item */
-TEST_F(EphTombstoneTest, DoNotPurgeLastDelete) {
+TEST_P(EphTombstoneTest, DoNotPurgeLastDelete) {
     /* Advance to non-zero time. */
     TimeTraveller jamesCole(10);
 
@@ -594,7 +617,7 @@ TEST_F(EphTombstoneTest, DoNotPurgeLastDelete) {
 }
 
 /* Do not purge if stale item is the only item in the list */
-TEST_F(EphTombstoneTest, DoNotPurgeTheOnlyElement) {
+TEST_P(EphTombstoneTest, DoNotPurgeTheOnlyElement) {
     /* Create a new empty VB (using parent class SetUp). */
     EphemeralVBucketTest::SetUp();
     const auto key = makeStoredDocKey("one");
@@ -624,7 +647,7 @@ TEST_F(EphTombstoneTest, DoNotPurgeTheOnlyElement) {
 }
 
 // Check that deleted items can be purged immediately.
-TEST_F(EphTombstoneTest, ImmediateDeletedPurge) {
+TEST_P(EphTombstoneTest, ImmediateDeletedPurge) {
     // Advance to non-zero time.
     TimeTraveller jamesCole(10);
 
@@ -653,11 +676,14 @@ TEST_F(EphTombstoneTest, ImmediateDeletedPurge) {
 }
 
 // Check that alive, stale items have no constraint on age.
-TEST_F(EphTombstoneTest, ImmediatePurgeOfAliveStale) {
+TEST_P(EphTombstoneTest, ImmediatePurgeOfAliveStale) {
     // Perform a mutation on the second element, with a (fake) Range Read in
     // place; causing the initial OSV to be marked as stale and a new OSV to
     // be added for that key.
-    auto& seqList = mockEpheVB->getLL()->getSeqList();
+    if (!mockEpheVB->getBasicLL()) {
+        GTEST_SKIP() << "Inspects the BasicLinkedList's list directly";
+    }
+    auto& seqList = mockEpheVB->getBasicLL()->getSeqList();
     {
         auto range = mockEpheVB->registerFakeSharedRangeLock(1, 2);
         ASSERT_EQ(MutationStatus::WasClean, setOne(keys.at(1)));
@@ -694,7 +720,7 @@ TEST_F(EphTombstoneTest, ImmediatePurgeOfAliveStale) {
 
 // Test that deleted items purged out of order are handled correctly (and
 // highestDeletedPurged is updated).
-TEST_F(EphTombstoneTest, PurgeOutOfOrder) {
+TEST_P(EphTombstoneTest, PurgeOutOfOrder) {
     // Delete the 3rd item.
     softDeleteOne(keys.at(2), MutationStatus::WasDirty);
 
@@ -728,7 +754,7 @@ TEST_F(EphTombstoneTest, PurgeOutOfOrder) {
 // Thread-safety test (intended to run via Valgrind / ASan / TSan) -
 // perform sets and deletes on 2 additional threads while the purger
 // runs constantly in the main thread.
-TEST_F(EphTombstoneTest, ConcurrentPurge) {
+TEST_P(EphTombstoneTest, ConcurrentPurge) {
     ThreadGate started(2);
     std::atomic<size_t> completed(0);
 
@@ -759,7 +785,7 @@ TEST_F(EphTombstoneTest, ConcurrentPurge) {
 
 // Test that on a double-delete (delete with a different value) the deleted time
 // is updated correctly.
-TEST_F(EphTombstoneTest, DoubleDeleteTimeCorrect) {
+TEST_P(EphTombstoneTest, DoubleDeleteTimeCorrect) {
     // Delete the first item at +0s
     auto key = keys.at(0);
     softDeleteOne(key, MutationStatus::WasDirty);
@@ -786,7 +812,7 @@ TEST_F(EphTombstoneTest, DoubleDeleteTimeCorrect) {
     EXPECT_GE(secondDelTime, initialDelTime + timeJump);
 }
 
-TEST_F(EphemeralVBucketTest, UpdateUpdatesHighestDedupedSeqno) {
+TEST_P(EphemeralVBucketTest, UpdateUpdatesHighestDedupedSeqno) {
     /* Add 3 items and then update all of them */
     const int numItems = 3;
 
@@ -801,7 +827,7 @@ TEST_F(EphemeralVBucketTest, UpdateUpdatesHighestDedupedSeqno) {
     EXPECT_EQ(6, mockEpheVB->getLL()->getHighestDedupedSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, AppendUpdatesHighestDedupedSeqno) {
+TEST_P(EphemeralVBucketTest, AppendUpdatesHighestDedupedSeqno) {
     /* Add 3 items and then update all of them */
     const int numItems = 3;
 
@@ -820,7 +846,7 @@ TEST_F(EphemeralVBucketTest, AppendUpdatesHighestDedupedSeqno) {
     ASSERT_EQ(6, mockEpheVB->getLL()->getHighestDedupedSeqno());
 }
 
-TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicates) {
+TEST_P(EphemeralVBucketTest, SnapshotHasNoDuplicates) {
     /* Add 2 items and then update all of them */
     const int numItems = 2;
 
@@ -843,7 +869,7 @@ TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicates) {
     EXPECT_EQ(numItems * 2, std::get<2>(res));
 }
 
-TEST_F(EphemeralVBucketTest, SnapshotIncludesNonDuplicateStaleItems) {
+TEST_P(EphemeralVBucketTest, SnapshotIncludesNonDuplicateStaleItems) {
     /* Add 2 items and then update all of them */
     const int numItems = 2;
 
@@ -865,7 +891,7 @@ TEST_F(EphemeralVBucketTest, SnapshotIncludesNonDuplicateStaleItems) {
     EXPECT_EQ(numItems * 2, std::get<2>(res));
 }
 
-TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithInterveningItems) {
+TEST_P(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithInterveningItems) {
     // Add 3 items, begin a rangeRead, add 1 more item, then update the first 2
     const int numItems = 2;
 
@@ -894,7 +920,7 @@ TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithInterveningItems) {
     EXPECT_EQ(numItems * 3, std::get<2>(res)); // extended end of readRange
 }
 
-TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithMultipleStale) {
+TEST_P(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithMultipleStale) {
     /* repeatedly update two items, ensure the backfill ignores all stale
      * versions */
     const int numItems = 2;
@@ -924,7 +950,7 @@ TEST_F(EphemeralVBucketTest, SnapshotHasNoDuplicatesWithMultipleStale) {
 }
 
 // Check that tombstone purger runs fine in pause-resume mode
-TEST_F(EphTombstoneTest, PurgePauseResume) {
+TEST_P(EphTombstoneTest, PurgePauseResume) {
     // Delete the second item
     softDeleteOne(keys.at(1), MutationStatus::WasDirty);
     ASSERT_EQ(keys.size() - 1, vbucket->getNumItems());
@@ -954,7 +980,7 @@ TEST_F(EphTombstoneTest, PurgePauseResume) {
             << "Test expected to simulate atleast one pause-resume";
 }
 
-TEST_F(EphTombstoneTest, PurgePauseResumeWithUpdateAtPausedPoint) {
+TEST_P(EphTombstoneTest, PurgePauseResumeWithUpdateAtPausedPoint) {
     // Delete any stale items. Set the max purge duration to 0 to
     // simulate pause-resume
     int numPurged = 0, numPaused = -1;
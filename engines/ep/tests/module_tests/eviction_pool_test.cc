@@ -0,0 +1,145 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the EvictionPool used by the sampled_lru eviction policy,
+ * and the HashTable sampling it relies on.
+ */
+
+#include "eviction_pool.h"
+#include "hash_table.h"
+#include "hash_table_test.h"
+#include "item.h"
+#include "stored_value_factories.h"
+#include "test_helpers.h"
+
+#include <folly/portability/GTest.h>
+
+class EvictionPoolTest : public HashTableTest {
+protected:
+    EvictionPoolTest() : ht(global_stats, makeFactory(), defaultHtSize, 1) {
+    }
+
+    /// Store an item with the given frequency counter and CAS, and offer it
+    /// to the pool.
+    void offer(const std::string& key, uint8_t freqCounter, uint64_t cas) {
+        auto docKey = makeStoredDocKey(key);
+        Item item(docKey, 0, 0, "value", 5);
+        ht.set(item);
+        auto htRes = ht.findForWrite(docKey);
+        ASSERT_TRUE(htRes.storedValue);
+        htRes.storedValue->setFreqCounterValue(freqCounter);
+        htRes.storedValue->setCas(cas);
+        pool.offer(*htRes.storedValue);
+    }
+
+    StoredDocKey popKey() {
+        auto candidate = pool.pop();
+        EXPECT_TRUE(candidate);
+        return candidate ? candidate->key : makeStoredDocKey("");
+    }
+
+    HashTable ht;
+    EvictionPool pool;
+};
+
+// Test that candidates are popped least frequently used first, and for the
+// same frequency counter least recently modified first.
+TEST_F(EvictionPoolTest, PopsColdestFirst) {
+    offer("hot", 200, 1);
+    offer("cold_new", 4, 10);
+    offer("cold_old", 4, 5);
+    offer("coldest", 0, 100);
+
+    EXPECT_EQ(4, pool.size());
+    EXPECT_EQ(makeStoredDocKey("coldest"), popKey());
+    EXPECT_EQ(makeStoredDocKey("cold_old"), popKey());
+    EXPECT_EQ(makeStoredDocKey("cold_new"), popKey());
+    EXPECT_EQ(makeStoredDocKey("hot"), popKey());
+    EXPECT_TRUE(pool.empty());
+    EXPECT_FALSE(pool.pop());
+}
+
+// Test that once full the pool keeps only the best candidates.
+TEST_F(EvictionPoolTest, KeepsBestWhenFull) {
+    for (size_t ii = 0; ii < EvictionPool::MaxSize * 2; ++ii) {
+        offer("key_" + std::to_string(ii), uint8_t(100 - ii), 1);
+    }
+    ASSERT_EQ(EvictionPool::MaxSize, pool.size());
+
+    // The last MaxSize offered have the lowest frequency counters.
+    for (size_t ii = EvictionPool::MaxSize * 2; ii > EvictionPool::MaxSize;
+         --ii) {
+        EXPECT_EQ(makeStoredDocKey("key_" + std::to_string(ii - 1)), popKey());
+    }
+    EXPECT_TRUE(pool.empty());
+}
+
+// Test that offering an item already in the pool updates it rather than
+// adding a duplicate.
+TEST_F(EvictionPoolTest, ReofferUpdatesCandidate) {
+    offer("a", 1, 1);
+    offer("b", 2, 1);
+    offer("a", 3, 2);
+    ASSERT_EQ(2, pool.size());
+
+    auto candidate = pool.pop();
+    ASSERT_TRUE(candidate);
+    EXPECT_EQ(makeStoredDocKey("b"), candidate->key);
+    candidate = pool.pop();
+    ASSERT_TRUE(candidate);
+    EXPECT_EQ(makeStoredDocKey("a"), candidate->key);
+    EXPECT_EQ(3, candidate->freqCounter);
+    EXPECT_EQ(2, candidate->cas);
+}
+
+/// Counts the StoredValues visited.
+class SampleCounter : public HashTableVisitor {
+public:
+    bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override {
+        ++visited;
+        return true;
+    }
+
+    size_t visited = 0;
+};
+
+// Test that visitRandomBuckets visits each StoredValue in the buckets it
+// chooses.
+TEST_F(HashTableTest, VisitRandomBuckets) {
+    // With a single bucket every StoredValue is visited for each bucket.
+    HashTable ht(global_stats, makeFactory(), 1, 1);
+    const size_t numItems = 10;
+    for (size_t ii = 0; ii < numItems; ++ii) {
+        Item item(makeStoredDocKey("key_" + std::to_string(ii)),
+                  0,
+                  0,
+                  "value",
+                  5);
+        ASSERT_EQ(MutationStatus::WasClean, ht.set(item));
+    }
+
+    SampleCounter visitor;
+    ht.visitRandomBuckets(visitor, 3);
+    EXPECT_EQ(numItems * 3, visitor.visited);
+
+    // Nothing is visited in an empty HashTable.
+    HashTable empty(global_stats, makeFactory(), defaultHtSize, 1);
+    SampleCounter emptyVisitor;
+    empty.visitRandomBuckets(emptyVisitor, 3);
+    EXPECT_EQ(0, emptyVisitor.visited);
+}
@@ -45,6 +45,8 @@
 #include <programs/engine_testapp/mock_cookie.h>
 #include <programs/engine_testapp/mock_server.h>
 
+#include <thread>
+
 class DurabilityEPBucketTest : public STParameterizedBucketTest {
 protected:
     void SetUp() override {
@@ -4416,6 +4418,128 @@ TEST_P(DurabilityBucketTest, PrepareDoesNotExpire) {
     EXPECT_EQ(DeleteSource::TTL, res.storedValue->getDeletionSource());
 }
 
+/**
+ * Test that the ActiveDM registers the deadline of each SyncWrite with a
+ * timeout (so the DurabilityTimeoutTask doesn't need to poll every vBucket),
+ * and cancels it once the SyncWrite completes - however it completes.
+ */
+TEST_P(DurabilityBucketTest, SyncWriteTimeoutRegisteredAndCancelled) {
+    using namespace cb::durability;
+
+    setVBucketToActiveWithValidTopology();
+    auto vb = store->getVBucket(vbid);
+
+    using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+    std::vector<std::pair<int64_t, Deadline>> timeouts;
+    vb->setSyncWriteTimeoutCallback(
+            [&timeouts](Vbid, int64_t seqno, Deadline deadline) {
+                timeouts.emplace_back(seqno, deadline);
+            });
+
+    // Prepare (1) is committed.
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(ENGINE_SYNC_WRITE_PENDING,
+              store->set(*makePendingItem(makeStoredDocKey("key1"),
+                                          "value",
+                                          {Level::Majority, Timeout(10000)}),
+                         cookie));
+    ASSERT_EQ(1, timeouts.size());
+    EXPECT_EQ(1, timeouts.back().first);
+    ASSERT_TRUE(timeouts.back().second);
+    EXPECT_GE(*timeouts.back().second, start + std::chrono::seconds(10));
+
+    EXPECT_EQ(ENGINE_SUCCESS,
+              vb->seqnoAcknowledged(
+                      folly::SharedMutex::ReadHolder(vb->getStateLock()),
+                      "replica",
+                      1 /*preparedSeqno*/));
+    vb->notifyActiveDMOfLocalSyncWrite();
+    ASSERT_EQ(2, timeouts.size());
+    EXPECT_EQ(1, timeouts.back().first);
+    EXPECT_FALSE(timeouts.back().second);
+    vb->processResolvedSyncWrites();
+
+    // Prepare (3) times out.
+    ASSERT_EQ(ENGINE_SYNC_WRITE_PENDING,
+              store->set(*makePendingItem(makeStoredDocKey("key2"),
+                                          "value",
+                                          {Level::Majority, Timeout(10000)}),
+                         cookie));
+    ASSERT_EQ(3, timeouts.size());
+    EXPECT_EQ(3, timeouts.back().first);
+    ASSERT_TRUE(timeouts.back().second);
+
+    vb->processDurabilityTimeout(std::chrono::steady_clock::now() +
+                                 std::chrono::milliseconds(10001));
+    ASSERT_EQ(4, timeouts.size());
+    EXPECT_EQ(3, timeouts.back().first);
+    EXPECT_FALSE(timeouts.back().second);
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(0, vb->getDurabilityMonitor().getNumTracked());
+}
+
+/**
+ * A SyncWrite whose deadline fires while it is behind a SyncWrite which hasn't
+ * expired cannot be aborted yet (SyncWrites complete in order). Its deadline
+ * must be re-armed once the SyncWrite ahead of it completes, else it is never
+ * aborted.
+ */
+TEST_P(DurabilityBucketTest, SyncWriteTimeoutRearmedBehindUnexpiredHead) {
+    using namespace cb::durability;
+
+    setVBucketToActiveWithValidTopology();
+    auto vb = store->getVBucket(vbid);
+
+    using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+    std::vector<std::pair<int64_t, Deadline>> timeouts;
+    vb->setSyncWriteTimeoutCallback(
+            [&timeouts](Vbid, int64_t seqno, Deadline deadline) {
+                timeouts.emplace_back(seqno, deadline);
+            });
+
+    // Prepare (1) has a long timeout, prepare (2) behind it a short one.
+    ASSERT_EQ(ENGINE_SYNC_WRITE_PENDING,
+              store->set(*makePendingItem(makeStoredDocKey("key1"),
+                                          "value",
+                                          {Level::Majority, Timeout(30000)}),
+                         cookie));
+    ASSERT_EQ(ENGINE_SYNC_WRITE_PENDING,
+              store->set(*makePendingItem(makeStoredDocKey("key2"),
+                                          "value",
+                                          {Level::Majority, Timeout(1)}),
+                         cookie));
+    ASSERT_EQ(2, timeouts.size());
+    ASSERT_TRUE(timeouts.back().second);
+    const auto deadline2 = *timeouts.back().second;
+
+    // (2)'s deadline fires (it has been taken off the timer wheel) but
+    // nothing can be aborted as (1) hasn't expired.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    vb->processDurabilityTimeout(std::chrono::steady_clock::now());
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(2, vb->getDurabilityMonitor().getNumTracked());
+    timeouts.clear();
+
+    // (1) commits; (2)'s deadline is re-armed as it is now the head.
+    EXPECT_EQ(ENGINE_SUCCESS,
+              vb->seqnoAcknowledged(
+                      folly::SharedMutex::ReadHolder(vb->getStateLock()),
+                      "replica",
+                      1 /*preparedSeqno*/));
+    vb->notifyActiveDMOfLocalSyncWrite();
+    const std::vector<std::pair<int64_t, Deadline>> expected{
+            {1, Deadline{}}, {2, deadline2}};
+    EXPECT_EQ(expected, timeouts);
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(1, vb->getDurabilityMonitor().getNumTracked());
+
+    // And when it fires (2) is aborted.
+    vb->processDurabilityTimeout(std::chrono::steady_clock::now());
+    vb->processResolvedSyncWrites();
+    EXPECT_EQ(0, vb->getDurabilityMonitor().getNumTracked());
+    EXPECT_EQ(2, vb->getHighCompletedSeqno());
+}
+
 // Test cases which run against couchstore
 INSTANTIATE_TEST_SUITE_P(AllBackends,
                          DurabilityCouchstoreBucketTest,
@@ -793,6 +793,107 @@ TEST_F(SingleThreadedEPBucketTest, FlusherBatchSizeLimitWritersChange) {
     EXPECT_EQ(expected, bucket.getFlusherBatchSplitTrigger());
 }
 
+// Check that flushing several vBuckets with a group commit persists each of
+// them as if they were flushed individually.
+TEST_F(SingleThreadedEPBucketTest, FlushVBucketsGroupCommit) {
+    // Another vBucket of the same shard (hence KVStore) as vbid.
+    const Vbid vbid2(vbid.get() + store->getVBuckets().getNumShards());
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+    setVBucketStateAndRunPersistTask(vbid2, vbucket_state_active);
+
+    store_item(vbid, makeStoredDocKey("key1"), "value");
+    store_item(vbid, makeStoredDocKey("key2"), "value");
+    store_item(vbid2, makeStoredDocKey("key1"), "value");
+
+    auto& bucket = getEPBucket();
+    const auto results = bucket.flushVBuckets({vbid, vbid2});
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(2, results[0].numFlushed);
+    EXPECT_EQ(1, results[1].numFlushed);
+
+    for (const auto vb : {vbid, vbid2}) {
+        auto vbucket = store->getVBucket(vb);
+        EXPECT_EQ(vbucket->getHighSeqno(), vbucket->getPersistenceSeqno());
+        EXPECT_EQ(0, vbucket->dirtyQueueSize);
+        EXPECT_EQ(vbucket->getHighSeqno(),
+                  store->getRWUnderlying(vb)->getVBucketState(vb)->highSeqno);
+    }
+}
+
+// Check that several fetcher tasks draining the same shard's vBuckets
+// concurrently fetch every queued item exactly once.
+TEST_F(SingleThreadedEPBucketTest, BgFetcherConcurrentTasks) {
+    const size_t numVbs = 8;
+    const size_t numKeys = 10;
+    const size_t numTasks = 4;
+
+    // vBuckets of the same shard (hence BgFetcher) as vbid.
+    std::vector<Vbid> vbids;
+    for (size_t ii = 0; ii < numVbs; ++ii) {
+        vbids.emplace_back(vbid.get() +
+                           ii * store->getVBuckets().getNumShards());
+        setVBucketStateAndRunPersistTask(vbids.back(), vbucket_state_active);
+    }
+
+    for (const auto vb : vbids) {
+        for (size_t ii = 0; ii < numKeys; ++ii) {
+            store_item(vb, makeStoredDocKey("key" + std::to_string(ii)), "v");
+        }
+        flush_vbucket_to_disk(vb, numKeys);
+        for (size_t ii = 0; ii < numKeys; ++ii) {
+            evict_key(vb, makeStoredDocKey("key" + std::to_string(ii)));
+        }
+    }
+
+    const auto options = static_cast<get_options_t>(
+            QUEUE_BG_FETCH | HONOR_STATES | TRACK_REFERENCE | HIDE_LOCKED_CAS);
+    for (const auto vb : vbids) {
+        for (size_t ii = 0; ii < numKeys; ++ii) {
+            ASSERT_EQ(ENGINE_EWOULDBLOCK,
+                      store->get(makeStoredDocKey("key" + std::to_string(ii)),
+                                 vb,
+                                 cookie,
+                                 options)
+                              .getStatus());
+        }
+    }
+    auto& stats = engine->getEpStats();
+    ASSERT_EQ(numVbs * numKeys, stats.numRemainingBgItems);
+
+    // Run the fetcher tasks all at once; each claims pending vBuckets until
+    // there are none left.
+    auto* bgFetcher = store->getVBucket(vbid)->getShard()->getBgFetcher();
+    ThreadGate tg(numTasks);
+    std::vector<std::thread> tasks;
+    for (size_t ii = 0; ii < numTasks; ++ii) {
+        tasks.emplace_back([this, bgFetcher, &tg]() {
+            MockGlobalTask mockTask(engine->getTaskable(),
+                                    TaskId::MultiBGFetcherTask);
+            tg.threadUp();
+            bgFetcher->run(&mockTask);
+        });
+    }
+    for (auto& t : tasks) {
+        t.join();
+    }
+
+    EXPECT_EQ(numVbs * numKeys, stats.bg_fetched);
+    EXPECT_EQ(0, stats.numRemainingBgItems);
+    EXPECT_EQ(0, stats.numBgFetchesInFlight);
+    EXPECT_FALSE(bgFetcher->pendingJob());
+
+    // All of the items are resident again.
+    for (const auto vb : vbids) {
+        for (size_t ii = 0; ii < numKeys; ++ii) {
+            auto gv = store->get(makeStoredDocKey("key" + std::to_string(ii)),
+                                 vb,
+                                 cookie,
+                                 options);
+            EXPECT_EQ(ENGINE_SUCCESS, gv.getStatus()) << vb << " key" << ii;
+        }
+    }
+}
+
 /*
  * The following test checks to see if we call handleSlowStream when in a
  * backfilling state, but the backfillTask is not running, we
@@ -2155,6 +2256,133 @@ TEST_F(SingleThreadedEPBucketTest, MB18452_yield_dcp_processor) {
     consumer->closeStream(/*opaque*/0, vbid);
 }
 
+/**
+ * With dcp_consumer_processor_tasks > 1 the buffered items of a consumer are
+ * split over several Processor tasks by vBucket; check that each task only
+ * drains the vBuckets it owns, so the vBuckets can be processed in parallel
+ * while each one is still applied in order.
+ */
+TEST_F(SingleThreadedEPBucketTest, dcp_processor_per_vbucket) {
+    engine->getConfiguration().setDcpConsumerProcessorTasks(2);
+    const Vbid vbid1 = Vbid(1);
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_replica);
+    setVBucketStateAndRunPersistTask(vbid1, vbucket_state_replica);
+
+    auto consumer = std::make_shared<MockDcpConsumer>(*engine, cookie, "test");
+    ASSERT_EQ(2, consumer->getNumProcessors());
+    ASSERT_NE(consumer->getProcessorFor(vbid),
+              consumer->getProcessorFor(vbid1));
+
+    const int messages = 10;
+    // Force the streams to buffer rather than process messages immediately
+    const ssize_t queueCap =
+            engine->getEpStats().replicationThrottleWriteQueueCap;
+    engine->getEpStats().replicationThrottleWriteQueueCap = 0;
+
+    for (auto vb : {vbid, vbid1}) {
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  consumer->addStream(/*opaque*/ vb.get(), vb, /*flags*/ 0));
+        const auto opaque = *consumer->getStreamOpaque(vb.get());
+        consumer->snapshotMarker(opaque,
+                                 vb,
+                                 /*startseq*/ 0,
+                                 /*endseq*/ messages,
+                                 /*flags*/ 0,
+                                 /*HCS*/ {},
+                                 /*maxVisibleSeqno*/ {});
+        for (int ii = 1; ii <= messages; ii++) {
+            const std::string key = "key" + std::to_string(ii);
+            const DocKey docKey{key, DocKeyEncodesCollectionId::No};
+            std::string value = "value";
+            consumer->mutation(opaque,
+                               docKey,
+                               {(const uint8_t*)value.c_str(), value.length()},
+                               0, // privileged bytes
+                               PROTOCOL_BINARY_RAW_BYTES, // datatype
+                               0, // cas
+                               vb, // vbucket
+                               0, // flags
+                               ii, // bySeqno
+                               0, // revSeqno
+                               0, // exptime
+                               0, // locktime
+                               {}, // meta
+                               0); // nru
+        }
+    }
+    engine->getEpStats().replicationThrottleWriteQueueCap = queueCap;
+
+    auto stream0 = std::dynamic_pointer_cast<MockPassiveStream>(
+            consumer->getVbucketStream(vbid));
+    auto stream1 = std::dynamic_pointer_cast<MockPassiveStream>(
+            consumer->getVbucketStream(vbid1));
+    ASSERT_TRUE(stream0);
+    ASSERT_TRUE(stream1);
+    ASSERT_NE(0, stream0->getNumBufferItems());
+    ASSERT_NE(0, stream1->getNumBufferItems());
+
+    consumer->public_notifyVbucketReady(vbid);
+    consumer->public_notifyVbucketReady(vbid1);
+
+    // Draining the processor owning vbid1 must not touch vbid's buffer
+    const auto p1 = consumer->getProcessorFor(vbid1);
+    while (consumer->processBufferedItems(p1) != all_processed) {
+    }
+    EXPECT_EQ(0, stream1->getNumBufferItems());
+    EXPECT_NE(0, stream0->getNumBufferItems());
+    EXPECT_EQ(messages, store->getVBucket(vbid1)->getHighSeqno());
+    EXPECT_EQ(0, store->getVBucket(vbid)->getHighSeqno());
+
+    const auto p0 = consumer->getProcessorFor(vbid);
+    while (consumer->processBufferedItems(p0) != all_processed) {
+    }
+    EXPECT_EQ(0, stream0->getNumBufferItems());
+    EXPECT_EQ(messages, store->getVBucket(vbid)->getHighSeqno());
+
+    consumer->closeStream(/*opaque*/ 0, vbid);
+    consumer->closeStream(/*opaque*/ 0, vbid1);
+}
+
+/**
+ * With dcp_consumer_processor_tasks > 1, one Processor task exiting (here on
+ * seeing the disconnect) must not stop the consumer cancelling the others,
+ * else those snoozed with nothing to process are leaked.
+ */
+TEST_F(SingleThreadedEPBucketTest, dcp_processor_tasks_cancelled_on_disconnect) {
+    engine->getConfiguration().setDcpConsumerProcessorTasks(2);
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_replica);
+
+    auto consumer = std::make_shared<MockDcpConsumer>(*engine, cookie, "test");
+    ASSERT_EQ(ENGINE_SUCCESS,
+              consumer->addStream(/*opaque*/ 0, vbid, /*flags*/ 0));
+    const auto task0 = consumer->getProcessorTaskId(0);
+    const auto task1 = consumer->getProcessorTaskId(1);
+    ASSERT_NE(0, task0);
+    ASSERT_NE(0, task1);
+
+    auto isScheduled = [this](size_t taskId) {
+        const auto locator = task_executor->getTaskLocator();
+        const auto it = locator.find(taskId);
+        return it != locator.end() && !it->second.first->isdead();
+    };
+    EXPECT_TRUE(isScheduled(task0));
+    EXPECT_TRUE(isScheduled(task1));
+
+    // Processor 0's task runs, sees the disconnect and exits; processor 1's
+    // doesn't run.
+    consumer->setDisconnect();
+    task_executor->wake(task0);
+    runNextTask(*task_executor->getLpTaskQ()[NONIO_TASK_IDX],
+                "DcpConsumerTask, processing buffered items for test "
+                "(processor 0)");
+    EXPECT_FALSE(isScheduled(task0));
+    EXPECT_TRUE(isScheduled(task1));
+
+    // As when DcpConnMap disconnects the consumer
+    consumer->cancelTask();
+    EXPECT_FALSE(isScheduled(task1));
+}
+
 /**
  * MB-29861: Ensure that a delete time is generated for a document
  * that is received on the consumer side as a result of a disk
@@ -322,6 +322,18 @@ TEST_F(WarmupTest, OperationsInterlockedWithWarmup) {
     EXPECT_EQ(ENGINE_SUCCESS,
               engine->get_stats(statsCookie1, "vbucket", {}, dummyAddStats));
 
+    // "vbucket-details" for all vBuckets is now computed on a NonIO task,
+    // which notifies the cookie once it has finished.
+    const auto statsNotifications =
+            get_number_of_mock_cookie_io_notifications(statsCookie2);
+    EXPECT_EQ(ENGINE_EWOULDBLOCK,
+              engine->get_stats(
+                      statsCookie2, "vbucket-details", {}, dummyAddStats));
+    auto& nonIOQueue = *task_executor->getLpTaskQ()[NONIO_TASK_IDX];
+    while (get_number_of_mock_cookie_io_notifications(statsCookie2) ==
+           statsNotifications) {
+        runNextTask(nonIOQueue);
+    }
     EXPECT_EQ(ENGINE_SUCCESS,
               engine->get_stats(
                       statsCookie2, "vbucket-details", {}, dummyAddStats));
@@ -2098,6 +2110,49 @@ TEST_F(WarmupTest, MB_35326) {
     flush_vbucket_to_disk(vbid);
 }
 
+// Check that the per-vBucket warmup phases load every vBucket, with batches
+// both queued for the insert task and (once the queue is full) inserted by
+// the scan task itself, and that the per-phase stats are reported.
+TEST_F(WarmupTest, LoadAllVBucketsViaInsertQueue) {
+    const std::vector<Vbid> vbids{Vbid(0), Vbid(1), Vbid(2), Vbid(3)};
+    const size_t itemsPerVb = 10;
+    for (auto vb : vbids) {
+        setVBucketStateAndRunPersistTask(vb, vbucket_state_active);
+        for (size_t i = 0; i < itemsPerVb; ++i) {
+            store_item(vb, makeStoredDocKey("key" + std::to_string(i)), "value");
+        }
+        flush_vbucket_to_disk(vb, itemsPerVb);
+    }
+
+    resetEngineAndWarmup("warmup_batch_size=3;warmup_insert_queue_size=1");
+
+    for (auto vb : vbids) {
+        auto vbucket = store->getVBucket(vb);
+        ASSERT_TRUE(vbucket);
+        EXPECT_EQ(itemsPerVb, vbucket->getNumItems());
+        for (size_t i = 0; i < itemsPerVb; ++i) {
+            auto key = makeStoredDocKey("key" + std::to_string(i));
+            auto result = vbucket->ht.findForRead(key);
+            ASSERT_TRUE(result.storedValue) << vb;
+            EXPECT_TRUE(result.storedValue->isResident()) << vb;
+        }
+    }
+
+    std::map<std::string, std::string> stats;
+    store->getWarmup()->addStats(
+            [&stats](std::string_view key, std::string_view value, const void*) {
+                stats[std::string(key)] = std::string(value);
+            },
+            cookie);
+    const auto expected = std::to_string(vbids.size() * itemsPerVb);
+    EXPECT_EQ(expected, stats["ep_warmup_key_dump_items"]);
+    EXPECT_EQ(expected, stats["ep_warmup_data_items"]);
+    EXPECT_EQ(1, stats.count("ep_warmup_data_time"));
+    EXPECT_EQ(1, stats.count("ep_warmup_data_items_per_sec"));
+    // Full-eviction only phase.
+    EXPECT_EQ(0, stats.count("ep_warmup_kv_pairs_time"));
+}
+
 INSTANTIATE_TEST_SUITE_P(FullOrValue,
                          MB_34718_WarmupTest,
                          STParameterizedBucketTest::persistentConfigValues(),
@@ -980,6 +980,71 @@ TEST_F(SingleThreadedExecutorPoolTest, ignore_duplicate_schedule) {
     this->pool->cancel(taskId, true);
 }
 
+/// Tests of CB3ExecutorPool's per-thread run queues.
+class CB3ExecutorPoolTest : public ExecutorPoolTest<TestExecutorPool> {};
+
+/**
+ * Test that a worker whose own run queue is empty steals the ready tasks
+ * queued on the run queue of a worker which is busy running a long task,
+ * instead of them waiting for the busy worker.
+ */
+TEST_F(CB3ExecutorPoolTest, IdleWorkerStealsFromBusyWorker) {
+    makePool(10, 2, 2, 2, /*numNonIO*/ 2);
+    MockTaskable taskable;
+    pool->registerTaskable(taskable);
+
+    // Occupy both NonIO workers with tasks which run until released.
+    folly::Baton<> busyRunning, busyRelease;
+    folly::Baton<> otherRunning, otherRelease;
+    auto makeBlockingTask = [&taskable](folly::Baton<>& running,
+                                        folly::Baton<>& release) {
+        return std::make_shared<LambdaTask>(
+                taskable,
+                TaskId::ItemPager,
+                0,
+                true,
+                [&running, &release](LambdaTask&) {
+                    running.post();
+                    release.wait();
+                    return false;
+                });
+    };
+    pool->schedule(makeBlockingTask(busyRunning, busyRelease));
+    ASSERT_TRUE(busyRunning.try_wait_for(10s));
+    pool->schedule(makeBlockingTask(otherRunning, otherRelease));
+    ASSERT_TRUE(otherRunning.try_wait_for(10s));
+
+    // Neither worker is fetching, so the next worker to fetch moves all of
+    // these at once, dealing them over both workers' run queues.
+    const size_t numTasks = 10;
+    std::atomic<size_t> numRun{0};
+    folly::Baton<> allRun;
+    for (size_t ii = 0; ii < numTasks; ++ii) {
+        pool->schedule(std::make_shared<LambdaTask>(
+                taskable,
+                TaskId::ItemPager,
+                0,
+                true,
+                [&numRun, &allRun, numTasks](LambdaTask&) {
+                    if (++numRun == numTasks) {
+                        allRun.post();
+                    }
+                    return false;
+                }));
+    }
+
+    // Test: Release only one worker. It must run all of the tasks, including
+    // those dealt to the run queue of the worker which is still busy.
+    otherRelease.post();
+    EXPECT_TRUE(allRun.try_wait_for(10s))
+            << "Only " << numRun << " of " << numTasks
+            << " tasks ran while one worker was busy";
+
+    busyRelease.post();
+    pool->unregisterTaskable(taskable, false);
+    pool->shutdown();
+}
+
 class ScheduleOnDestruct {
 public:
     ScheduleOnDestruct(ExecutorPool& pool,
@@ -0,0 +1,433 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for HashTableMaintenance - the single HashTable pass shared by
+ * the HashTable maintenance tasks.
+ */
+
+#include "defragmenter.h"
+#include "evp_store_single_threaded_test.h"
+#include "hash_table_maintenance.h"
+#include "item_compressor.h"
+#include "mock/mock_item_freq_decayer.h"
+#include "test_helpers.h"
+
+#include <folly/portability/GTest.h>
+
+#include <limits>
+
+/// Visitor which counts the StoredValues it visits, pausing once it has
+/// visited `budget` in the current chunk.
+class CountingVisitor : public VBucketAwareHTVisitor {
+public:
+    CountingVisitor(int id, std::vector<int>& order) : id(id), order(order) {
+    }
+
+    bool visit(const HashTable::HashBucketLock& lh, StoredValue& v) override {
+        order.push_back(id);
+        ++chunkVisited;
+        return chunkVisited < budget;
+    }
+
+    const int id;
+    std::vector<int>& order;
+    size_t budget = std::numeric_limits<size_t>::max();
+    size_t chunkVisited = 0;
+};
+
+class TestConcern : public HashTableMaintenanceConcern {
+public:
+    TestConcern(int id, std::vector<int>& order) : id(id), order(order) {
+    }
+
+    std::unique_ptr<VBucketAwareHTVisitor> createVisitor() override {
+        return std::make_unique<CountingVisitor>(id, order);
+    }
+
+    bool prepareChunk(VBucketAwareHTVisitor& htVisitor) override {
+        if (!enabled) {
+            return false;
+        }
+        auto& visitor = dynamic_cast<CountingVisitor&>(htVisitor);
+        visitor.budget = budget;
+        visitor.chunkVisited = 0;
+        return true;
+    }
+
+    void chunkComplete(VBucketAwareHTVisitor& htVisitor,
+                       bool completed) override {
+        visited += dynamic_cast<CountingVisitor&>(htVisitor).chunkVisited;
+        if (completed) {
+            ++passes;
+        }
+    }
+
+    void wakeForPass() override {
+        ++wakes;
+    }
+
+    bool mayFreeStoredValue() const override {
+        return freesStoredValue;
+    }
+
+    const int id;
+    std::vector<int>& order;
+    size_t budget = std::numeric_limits<size_t>::max();
+    bool enabled = true;
+    bool freesStoredValue = false;
+
+    size_t visited = 0;
+    size_t passes = 0;
+    size_t wakes = 0;
+};
+
+class HashTableMaintenanceTest : public SingleThreadedKVBucketTest {
+protected:
+    void SetUp() override {
+        SingleThreadedKVBucketTest::SetUp();
+        setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+        ASSERT_TRUE(store_items(
+                int(numItems), vbid, makeStoredDocKey("key"), "v"));
+        maintenance = std::make_unique<HashTableMaintenance>(*store);
+    }
+
+    void TearDown() override {
+        maintenance.reset();
+        SingleThreadedKVBucketTest::TearDown();
+    }
+
+    std::shared_ptr<TestConcern> addConcern(int id) {
+        auto concern = std::make_shared<TestConcern>(id, order);
+        maintenance->addConcern(concern);
+        return concern;
+    }
+
+    /// Run the participants of a pass (as their tasks would, each time they
+    /// are due) until the pass completes.
+    void runToCompletion(std::initializer_list<TestConcern*> participants) {
+        for (;;) {
+            for (auto* concern : participants) {
+                if (maintenance->run(*concern) ==
+                    HashTableMaintenance::Status::Completed) {
+                    return;
+                }
+            }
+        }
+    }
+
+    const size_t numItems = 100;
+    std::vector<int> order;
+    std::unique_ptr<HashTableMaintenance> maintenance;
+};
+
+// Test that a single concern visits every StoredValue in a pass, and that a
+// chunk ends once its budget is exhausted.
+TEST_F(HashTableMaintenanceTest, SingleConcern) {
+    auto concern = addConcern(1);
+    EXPECT_EQ(HashTableMaintenance::Status::Completed,
+              maintenance->run(*concern));
+    EXPECT_EQ(numItems, concern->visited);
+    EXPECT_EQ(1, concern->passes);
+    EXPECT_EQ(1, maintenance->getNumPasses());
+
+    concern->budget = 10;
+    EXPECT_EQ(HashTableMaintenance::Status::Paused,
+              maintenance->run(*concern));
+    EXPECT_EQ(numItems + 10, concern->visited);
+    runToCompletion({concern.get()});
+    EXPECT_EQ(2, concern->passes);
+    EXPECT_EQ(2, maintenance->getNumPasses());
+}
+
+// Test that concerns which asked for a pass while one was in progress wait
+// for it, are woken when it finishes, and then share a single pass.
+TEST_F(HashTableMaintenanceTest, WaitingConcernsShareNextPass) {
+    auto first = addConcern(1);
+    auto second = addConcern(2);
+    auto third = addConcern(3);
+    first->budget = 10;
+
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*first));
+    EXPECT_EQ(HashTableMaintenance::Status::Waiting,
+              maintenance->run(*second));
+    EXPECT_EQ(HashTableMaintenance::Status::Waiting, maintenance->run(*third));
+
+    runToCompletion({first.get()});
+    EXPECT_EQ(1, first->passes);
+    EXPECT_EQ(0, second->visited);
+    EXPECT_EQ(1, second->wakes);
+    EXPECT_EQ(1, third->wakes);
+
+    // Once both waiting concerns are due, one chunk visits every item for
+    // both.
+    order.clear();
+    EXPECT_EQ(HashTableMaintenance::Status::Pending,
+              maintenance->run(*second));
+    EXPECT_EQ(0, second->visited);
+    EXPECT_EQ(HashTableMaintenance::Status::Completed,
+              maintenance->run(*third));
+    EXPECT_EQ(numItems, second->visited);
+    EXPECT_EQ(numItems, third->visited);
+    EXPECT_EQ(1, second->passes);
+    EXPECT_EQ(1, third->passes);
+    EXPECT_EQ(numItems * 2, order.size());
+    EXPECT_EQ(2, maintenance->getNumPasses());
+
+    // The first concern wasn't waiting, so didn't take part.
+    EXPECT_EQ(1, first->passes);
+}
+
+// Test that a chunk pauses once the smallest budget is exhausted, and that
+// each participant sees every StoredValue visited in it.
+TEST_F(HashTableMaintenanceTest, ChunkEndsAtSmallestBudget) {
+    auto driver = addConcern(1);
+    auto small = addConcern(2);
+    auto big = addConcern(3);
+    small->budget = 10;
+    big->budget = 50;
+
+    // Make small & big wait for (and so share) the second pass.
+    driver->budget = 1;
+    maintenance->run(*driver);
+    maintenance->run(*small);
+    maintenance->run(*big);
+    driver->budget = std::numeric_limits<size_t>::max();
+    runToCompletion({driver.get()});
+
+    EXPECT_EQ(HashTableMaintenance::Status::Pending, maintenance->run(*big));
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*small));
+    EXPECT_EQ(10, small->visited);
+    EXPECT_EQ(10, big->visited);
+
+    // Whichever participant is due last runs the next chunk.
+    EXPECT_EQ(HashTableMaintenance::Status::Pending, maintenance->run(*small));
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*big));
+    EXPECT_EQ(20, small->visited);
+    EXPECT_EQ(20, big->visited);
+
+    // Once the small budget participant leaves, chunks use the next
+    // smallest budget.
+    small->enabled = false;
+    EXPECT_EQ(HashTableMaintenance::Status::Pending, maintenance->run(*big));
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*small));
+    EXPECT_EQ(20, small->visited);
+    EXPECT_EQ(70, big->visited);
+    runToCompletion({big.get()});
+    EXPECT_EQ(1, big->passes);
+    EXPECT_EQ(0, small->passes);
+}
+
+// Test that a concern whose visitor may free the StoredValue is called after
+// the other participants, whatever order the concerns were registered in.
+TEST_F(HashTableMaintenanceTest, FreeingVisitorCalledLast) {
+    auto driver = addConcern(1);
+    auto frees = addConcern(2);
+    auto other = addConcern(3);
+    frees->freesStoredValue = true;
+
+    driver->budget = 1;
+    maintenance->run(*driver);
+    maintenance->run(*frees);
+    maintenance->run(*other);
+    driver->budget = std::numeric_limits<size_t>::max();
+    runToCompletion({driver.get()});
+
+    order.clear();
+    runToCompletion({frees.get(), other.get()});
+    ASSERT_EQ(numItems * 2, order.size());
+    for (size_t ii = 0; ii < order.size(); ii += 2) {
+        EXPECT_EQ(3, order[ii]);
+        EXPECT_EQ(2, order[ii + 1]);
+    }
+}
+
+// Test that a participant's visitor only runs in chunks which that
+// participant's task asked for: a participant which is due doesn't drive
+// the others' visitors, it waits for them to be due too.
+TEST_F(HashTableMaintenanceTest, ChunkRunsOnceEveryParticipantIsDue) {
+    auto driver = addConcern(1);
+    auto fast = addConcern(2);
+    auto slow = addConcern(3);
+    fast->budget = 10;
+    slow->budget = 10;
+
+    driver->budget = 1;
+    maintenance->run(*driver);
+    maintenance->run(*fast);
+    maintenance->run(*slow);
+    driver->budget = std::numeric_limits<size_t>::max();
+    runToCompletion({driver.get()});
+
+    // However often the fast task runs, nothing is visited until the slow
+    // one is due.
+    for (int ii = 0; ii < 3; ++ii) {
+        EXPECT_EQ(HashTableMaintenance::Status::Pending,
+                  maintenance->run(*fast));
+    }
+    EXPECT_EQ(0, fast->visited);
+    EXPECT_EQ(0, slow->visited);
+
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*slow));
+    EXPECT_EQ(10, fast->visited);
+    EXPECT_EQ(10, slow->visited);
+}
+
+// Test that a participant leaving the pass (e.g. its task being disabled)
+// doesn't stop the other participants' chunks from running.
+TEST_F(HashTableMaintenanceTest, LeaveDoesNotStallPass) {
+    auto driver = addConcern(1);
+    auto stays = addConcern(2);
+    auto leaves = addConcern(3);
+    stays->budget = 10;
+
+    driver->budget = 1;
+    maintenance->run(*driver);
+    maintenance->run(*stays);
+    maintenance->run(*leaves);
+    driver->budget = std::numeric_limits<size_t>::max();
+    runToCompletion({driver.get()});
+
+    EXPECT_EQ(HashTableMaintenance::Status::Pending, maintenance->run(*stays));
+    maintenance->leave(*leaves);
+    EXPECT_EQ(HashTableMaintenance::Status::Paused, maintenance->run(*stays));
+    EXPECT_EQ(10, stays->visited);
+    EXPECT_EQ(0, leaves->visited);
+
+    stays->budget = std::numeric_limits<size_t>::max();
+    runToCompletion({stays.get()});
+    EXPECT_EQ(1, stays->passes);
+    EXPECT_EQ(0, leaves->passes);
+}
+
+TEST_F(HashTableMaintenanceTest, UnregisteredConcern) {
+    TestConcern concern(1, order);
+    EXPECT_FALSE(maintenance->isRegistered(concern));
+    EXPECT_THROW(maintenance->run(concern), std::logic_error);
+
+    auto registered = addConcern(2);
+    EXPECT_TRUE(maintenance->isRegistered(*registered));
+}
+
+/**
+ * Tests of the real HashTable maintenance tasks sharing the bucket's pass
+ * (ht_maintenance_shared_pass=true). Tasks are run directly (as the executor
+ * would when each is due) to control the order in which they become due.
+ */
+class HashTableMaintenanceTaskTest : public SingleThreadedKVBucketTest {
+protected:
+    void SetUp() override {
+        config_string +=
+                "ht_maintenance_shared_pass=true;compression_mode=active";
+        SingleThreadedKVBucketTest::SetUp();
+        setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+
+        // More than ProgressTracker:INITIAL_VISIT_COUNT_CHECK (100) items, so
+        // the MockItemFreqDecayerTask (0ms chunks) needs two chunks per pass.
+        ASSERT_TRUE(store_items(110, vbid, makeStoredDocKey("key"), "value"));
+
+        auto& maintenance = store->getHashTableMaintenance();
+        defragmenter = std::make_shared<DefragmenterTask>(
+                engine.get(), engine->getEpStats());
+        compressor = std::make_shared<ItemCompressorTask>(
+                engine.get(), engine->getEpStats());
+        decayer = std::make_shared<MockItemFreqDecayerTask>(engine.get(), 50);
+        maintenance.addConcern(defragmenter);
+        maintenance.addConcern(compressor);
+        maintenance.addConcern(decayer);
+    }
+
+    void TearDown() override {
+        defragmenter.reset();
+        compressor.reset();
+        decayer.reset();
+        SingleThreadedKVBucketTest::TearDown();
+    }
+
+    /// Run the decayer on its own until its pass completes, queueing the
+    /// defragmenter and compressor for the next pass.
+    void runDecayerPassWithOthersWaiting() {
+        decayer->run();
+        ASSERT_FALSE(decayer->isCompleted());
+        defragmenter->run();
+        compressor->run();
+        decayer->run();
+        ASSERT_TRUE(decayer->isCompleted());
+    }
+
+    std::shared_ptr<DefragmenterTask> defragmenter;
+    std::shared_ptr<ItemCompressorTask> compressor;
+    std::shared_ptr<MockItemFreqDecayerTask> decayer;
+};
+
+// Test that the defragmenter and compressor don't visit anything while they
+// wait for a pass in progress, and that neither visits items in the pass
+// they share until both tasks are due.
+TEST_F(HashTableMaintenanceTaskTest, VisitorsOnlyRunWhenTheirTaskIsDue) {
+    auto& stats = engine->getEpStats();
+    auto& maintenance = store->getHashTableMaintenance();
+
+    runDecayerPassWithOthersWaiting();
+    EXPECT_EQ(1, maintenance.getNumPasses());
+    EXPECT_EQ(0, stats.defragNumVisited.load());
+    EXPECT_EQ(0, stats.compressorNumVisited.load());
+
+    // The defragmenter being due doesn't compress items before the
+    // compressor is due (and vice versa).
+    defragmenter->run();
+    defragmenter->run();
+    EXPECT_EQ(0, stats.defragNumVisited.load());
+    EXPECT_EQ(0, stats.compressorNumVisited.load());
+
+    while (maintenance.getNumPasses() < 2) {
+        compressor->run();
+        defragmenter->run();
+    }
+    EXPECT_EQ(110, stats.defragNumVisited.load());
+    EXPECT_EQ(110, stats.compressorNumVisited.load());
+}
+
+// Test that disabling one of the tasks sharing a pass doesn't stall the
+// others.
+TEST_F(HashTableMaintenanceTaskTest, DisabledTaskLeavesPass) {
+    auto& stats = engine->getEpStats();
+    auto& maintenance = store->getHashTableMaintenance();
+
+    runDecayerPassWithOthersWaiting();
+    engine->getConfiguration().setDefragmenterEnabled(false);
+    defragmenter->run();
+
+    while (maintenance.getNumPasses() < 2) {
+        compressor->run();
+    }
+    EXPECT_EQ(0, stats.defragNumVisited.load());
+    EXPECT_EQ(110, stats.compressorNumVisited.load());
+}
+
+// Equivalent of ItemFreqDecayerTaskTest with the decayer sharing the
+// bucket's pass: the task must wake itself for the second chunk of its pass.
+TEST_F(HashTableMaintenanceTaskTest, ItemFreqDecayerTaskRunsPass) {
+    auto& lpNonioQ = *task_executor->getLpTaskQ()[NONIO_TASK_IDX];
+    task_executor->schedule(decayer);
+    decayer->wakeup();
+
+    runNextTask(lpNonioQ, "Item frequency count decayer task");
+    EXPECT_FALSE(decayer->isCompleted());
+    runNextTask(lpNonioQ, "Item frequency count decayer task");
+    EXPECT_TRUE(decayer->isCompleted());
+    EXPECT_EQ(1, store->getHashTableMaintenance().getNumPasses());
+}
@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <limits>
 #include <string>
+#include <thread>
 #include <utility>
 
 EPStats global_stats;
@@ -315,6 +316,95 @@ TEST_F(HashTableTest, AutoResize) {
     verifyFound(h, keys);
 }
 
+TEST_F(HashTableTest, IncrementalResize) {
+    HashTable h(global_stats, makeFactory(), 6, 3);
+
+    auto keys = generateKeys(1000);
+    storeMany(h, keys);
+
+    ASSERT_TRUE(h.beginIncrementalResize(6143));
+    EXPECT_TRUE(h.isResizing());
+    // Size is rounded up to a multiple of the lock count.
+    EXPECT_EQ(6144, h.getSize());
+
+    // Migrate part of the old table; all items must remain reachable.
+    EXPECT_TRUE(h.continueIncrementalResize(2));
+    EXPECT_TRUE(h.isResizing());
+    verifyFound(h, keys);
+    EXPECT_EQ(1000, count(h));
+
+    while (h.continueIncrementalResize(1)) {
+    }
+    EXPECT_FALSE(h.isResizing());
+    EXPECT_EQ(6144, h.getSize());
+    verifyFound(h, keys);
+
+    // Visiting migrates any chains the resizer has not reached yet.
+    ASSERT_TRUE(h.beginIncrementalResize(771));
+    EXPECT_EQ(1000, count(h));
+    EXPECT_FALSE(h.continueIncrementalResize(6144));
+    EXPECT_FALSE(h.isResizing());
+    verifyFound(h, keys);
+}
+
+TEST_F(HashTableTest, IncrementalResizeFallsBackToBlocking) {
+    HashTable h(global_stats, makeFactory(), 5, 3);
+
+    auto keys = generateKeys(1000);
+    storeMany(h, keys);
+
+    // 5 is not a multiple of the lock count, so the first resize can't be
+    // incremental.
+    EXPECT_FALSE(h.beginIncrementalResize(769));
+    EXPECT_FALSE(h.isResizing());
+    EXPECT_EQ(771, h.getSize());
+    verifyFound(h, keys);
+
+    EXPECT_TRUE(h.beginIncrementalResize(3000));
+    EXPECT_EQ(3000, h.getSize());
+    EXPECT_FALSE(h.continueIncrementalResize(771));
+    verifyFound(h, keys);
+}
+
+TEST_F(HashTableTest, IncrementalResizeClear) {
+    HashTable h(global_stats, makeFactory(), 6, 3);
+
+    auto keys = generateKeys(1000);
+    storeMany(h, keys);
+
+    ASSERT_TRUE(h.beginIncrementalResize(3000));
+    h.clear();
+    EXPECT_FALSE(h.isResizing());
+    EXPECT_EQ(0, count(h));
+    EXPECT_FALSE(h.continueIncrementalResize(1));
+}
+
+TEST_F(HashTableTest, ConcurrentAccessIncrementalResize) {
+    HashTable h(global_stats, makeFactory(), 6, 3);
+
+    auto keys = generateKeys(2000);
+    storeMany(h, keys);
+
+    std::atomic<bool> done{false};
+    std::thread resizer([&h, &done]() {
+        size_t size = 1000;
+        while (!done) {
+            h.beginIncrementalResize(size);
+            while (h.continueIncrementalResize(8)) {
+            }
+            size = size == 1000 ? 3000 : 1000;
+        }
+    });
+
+    verifyFound(h, keys);
+    for (const auto& key : keys) {
+        EXPECT_TRUE(del(h, key));
+    }
+    done = true;
+    resizer.join();
+    EXPECT_EQ(0, count(h));
+}
+
 TEST_F(HashTableTest, DepthCounting) {
     HashTable h(global_stats, makeFactory(), 5, 1);
     const int nkeys = 5000;
@@ -431,6 +431,33 @@ TEST_P(STItemPagerTest, PagerEvictsSomething) {
     }
 }
 
+// Test that the pager evicts something using the sampled_lru eviction policy.
+TEST_P(STItemPagerTest, SampledLruPagerEvictsSomething) {
+    // Pager can't run in fail_new_data policy so test is invalid
+    if ((std::get<1>(GetParam()) == "fail_new_data")) {
+        return;
+    }
+    engine->getConfiguration().setHtEvictionPolicy("sampled_lru");
+
+    // Fill to just over HWM
+    populateUntilAboveHighWaterMark(vbid);
+
+    // Flush so items are eligible for ejection
+    flushDirectlyIfPersistent(vbid);
+
+    auto vb = store->getVBucket(vbid);
+    auto items = vb->getNumItems();
+
+    runHighMemoryPager();
+
+    if (persistent()) {
+        EXPECT_LT(0, vb->getNumNonResidentItems());
+        EXPECT_EQ(items, vb->getNumItems());
+    } else {
+        EXPECT_LT(vb->getNumItems(), items);
+    }
+}
+
 // Tests that for the hifi_mfu eviction algorithm we visit replica vbuckets
 // first.
 TEST_P(STItemPagerTest, ReplicaItemsVisitedFirst) {
@@ -324,6 +324,43 @@ TEST_P(KVStoreParamTest, GetMultiMissNumGetFailure) {
     EXPECT_EQ(0, kvstore->getKVStoreStat().io_bgfetch_doc_bytes);
 }
 
+// getMulti with a callback should invoke it once for every requested key
+// (including those not found), with the key's fetch already complete.
+TEST_P(KVStoreParamTest, GetMultiCallback) {
+    kvstore->begin(std::make_unique<TransactionContext>(vbid));
+    for (int ii = 0; ii < 5; ++ii) {
+        auto qi = makeCommittedItem(makeStoredDocKey("key" + std::to_string(ii)),
+                                    "value");
+        qi->setBySeqno(ii + 1);
+        kvstore->set(qi);
+    }
+    ASSERT_TRUE(kvstore->commit(flush));
+
+    vb_bgfetch_queue_t q;
+    for (int ii = 0; ii < 6; ++ii) {
+        vb_bgfetch_item_ctx_t ctx;
+        ctx.isMetaOnly = GetMetaOnly::No;
+        q[makeDiskDocKey("key" + std::to_string(ii))] = std::move(ctx);
+    }
+
+    std::map<DiskDocKey, ENGINE_ERROR_CODE> completed;
+    kvstore->getMulti(
+            vbid,
+            q,
+            [&completed](const DiskDocKey& key, vb_bgfetch_item_ctx_t& ctx) {
+                EXPECT_TRUE(completed.emplace(key, ctx.value.getStatus())
+                                    .second)
+                        << "Callback invoked more than once for a key";
+            });
+
+    ASSERT_EQ(6, completed.size());
+    for (int ii = 0; ii < 5; ++ii) {
+        EXPECT_EQ(ENGINE_SUCCESS,
+                  completed[makeDiskDocKey("key" + std::to_string(ii))]);
+    }
+    EXPECT_EQ(ENGINE_KEY_ENOENT, completed[makeDiskDocKey("key5")]);
+}
+
 TEST_P(KVStoreParamTest, GetRangeMissNumGetFailure) {
     std::vector<GetValue> results;
     kvstore->getRange(
@@ -0,0 +1,461 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the SkipList implementation of SequenceList.
+ */
+
+#include "hash_table.h"
+#include "item.h"
+#include "skip_list.h"
+#include "stats.h"
+#include "stored_value_factories.h"
+#include "tests/module_tests/test_helpers.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Rcu.h>
+
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+static EPStats global_stats;
+
+class SkipListTest : public ::testing::Test {
+public:
+    SkipListTest() : ht(global_stats, makeFactory(), 2, 1) {
+    }
+
+    static std::unique_ptr<AbstractStoredValueFactory> makeFactory() {
+        return std::make_unique<OrderedStoredValueFactory>(global_stats);
+    }
+
+protected:
+    void SetUp() override {
+        skipList = std::make_unique<SkipList>(Vbid(0), global_stats);
+    }
+
+    void TearDown() override {
+        /* Like in a vbucket we want the list to be erased before HashTable is
+           is destroyed. */
+        skipList.reset();
+    }
+
+    /**
+     * Adds 'numItems' number of new items to the list, from startSeqno.
+     * Items to have key as keyPrefixXX, XX being the seqno.
+     */
+    void addNewItemsToList(seqno_t startSeqno,
+                           const std::string& keyPrefix,
+                           const int numItems) {
+        const std::string val("data");
+
+        /* Get a fake sequence lock */
+        std::mutex fakeSeqLock;
+        std::lock_guard<std::mutex> lg(fakeSeqLock);
+
+        for (seqno_t i = startSeqno; i < startSeqno + numItems; ++i) {
+            StoredDocKey key = makeStoredDocKey(keyPrefix + std::to_string(i));
+            Item item(key,
+                      0,
+                      0,
+                      val.data(),
+                      val.length(),
+                      PROTOCOL_BINARY_RAW_BYTES,
+                      /*theCas*/ 0,
+                      /*bySeqno*/ i);
+            EXPECT_EQ(MutationStatus::WasClean, ht.set(item));
+
+            auto* sv = ht.findForWrite(key).storedValue->toOrderedStoredValue();
+
+            std::lock_guard<std::mutex> listWriteLg(
+                    skipList->getListWriteLock());
+            skipList->appendToList(lg, listWriteLg, *sv);
+            skipList->updateHighSeqno(listWriteLg, *sv);
+        }
+    }
+
+    void addStaleItem(const std::string& key, seqno_t seqno) {
+        const std::string val("data");
+
+        /* Get a fake sequence lock */
+        std::mutex fakeSeqLock;
+        std::lock_guard<std::mutex> lg(fakeSeqLock);
+
+        StoredDocKey sKey = makeStoredDocKey(key);
+        Item item(sKey,
+                  0,
+                  0,
+                  val.data(),
+                  val.length(),
+                  PROTOCOL_BINARY_RAW_BYTES,
+                  /*theCas*/ 0,
+                  /*bySeqno*/ seqno);
+        EXPECT_EQ(MutationStatus::WasClean, ht.set(item));
+
+        auto res = ht.findForWrite(sKey);
+        ASSERT_TRUE(res.storedValue);
+        auto* sv = res.storedValue->toOrderedStoredValue();
+        std::lock_guard<std::mutex> listWriteLg(skipList->getListWriteLock());
+        skipList->appendToList(lg, listWriteLg, *sv);
+        skipList->updateHighSeqno(listWriteLg, *sv);
+
+        /* Mark stale */
+        auto ownedSV = ht.unlocked_release(res.lock, res.storedValue);
+        skipList->markItemStale(listWriteLg, std::move(ownedSV), nullptr);
+    }
+
+    /**
+     * Updates an existing item with key == key and assigns it a seqno of
+     * highSeqno + 1, returning the status of the list update. If the item
+     * can't be moved (due to a range read) it is appended and the old
+     * version marked stale.
+     */
+    SequenceList::UpdateStatus updateItem(seqno_t highSeqno,
+                                          const std::string& key) {
+        const std::string val("data");
+
+        /* Get a fake sequence lock */
+        std::mutex fakeSeqLock;
+        std::lock_guard<std::mutex> lg(fakeSeqLock);
+
+        auto docKey = makeStoredDocKey(key);
+        auto res = ht.findForWrite(docKey);
+        EXPECT_TRUE(res.storedValue);
+        auto* osv = res.storedValue->toOrderedStoredValue();
+
+        std::lock_guard<std::mutex> listWriteLg(skipList->getListWriteLock());
+        auto status = skipList->updateListElem(lg, listWriteLg, *osv);
+        if (status == SequenceList::UpdateStatus::Success) {
+            osv->setBySeqno(highSeqno + 1);
+            skipList->updateHighSeqno(listWriteLg, *osv);
+            return status;
+        }
+
+        auto ownedSv = ht.unlocked_release(res.lock, res.storedValue);
+        Item itm(docKey,
+                 0,
+                 0,
+                 val.data(),
+                 val.length(),
+                 PROTOCOL_BINARY_RAW_BYTES,
+                 /*theCas*/ 0,
+                 /*bySeqno*/ highSeqno + 1);
+        auto* newSv = ht.unlocked_addNewStoredValue(res.lock, itm);
+        auto& newOsv = *newSv->toOrderedStoredValue();
+        skipList->appendToList(lg, listWriteLg, newOsv);
+        skipList->updateHighSeqno(listWriteLg, newOsv);
+        skipList->markItemStale(listWriteLg, std::move(ownedSv), newSv);
+        return status;
+    }
+
+    /// Returns the seqnos of all the items in the list, read by rangeRead.
+    std::vector<seqno_t> readAllSeqnos() {
+        ENGINE_ERROR_CODE status;
+        std::vector<UniqueItemPtr> items;
+        seqno_t endSeqno;
+        std::tie(status, items, endSeqno) = skipList->rangeRead(
+                1, std::numeric_limits<seqno_t>::max());
+        EXPECT_EQ(ENGINE_SUCCESS, status);
+        std::vector<seqno_t> seqnos;
+        for (const auto& item : items) {
+            seqnos.push_back(item->getBySeqno());
+        }
+        return seqnos;
+    }
+
+    SequenceList::RangeIterator getRangeIterator() {
+        auto itrOptional = skipList->makeRangeIterator(true /*isBackfill*/);
+        EXPECT_TRUE(itrOptional);
+        return std::move(*itrOptional);
+    }
+
+    /* We need a HashTable because StoredValue is created only in the HashTable
+       and then put onto the sequence list */
+    HashTable ht;
+    std::unique_ptr<SkipList> skipList;
+};
+
+TEST_F(SkipListTest, RangeRead) {
+    const int numItems = 100;
+    addNewItemsToList(1, "key", numItems);
+    EXPECT_EQ(numItems, skipList->getNumItems());
+
+    ENGINE_ERROR_CODE status;
+    std::vector<UniqueItemPtr> items;
+    seqno_t endSeqno;
+    std::tie(status, items, endSeqno) = skipList->rangeRead(40, 60);
+    EXPECT_EQ(ENGINE_SUCCESS, status);
+    ASSERT_EQ(21, items.size());
+    EXPECT_EQ(40, items.front()->getBySeqno());
+    EXPECT_EQ(60, items.back()->getBySeqno());
+    EXPECT_EQ(60, endSeqno);
+
+    std::tie(status, items, endSeqno) = skipList->rangeRead(numItems + 1, 200);
+    EXPECT_EQ(ENGINE_ERANGE, status);
+
+    /* The read range is released on return */
+    EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(0)),
+              skipList->getRangeRead());
+}
+
+TEST_F(SkipListTest, UpdateMovesItemToEnd) {
+    const int numItems = 5;
+    addNewItemsToList(1, "key", numItems);
+
+    EXPECT_EQ(SequenceList::UpdateStatus::Success, updateItem(numItems, "key1"));
+    EXPECT_EQ(SequenceList::UpdateStatus::Success,
+              updateItem(numItems + 1, "key3"));
+    EXPECT_EQ(SequenceList::UpdateStatus::Success,
+              updateItem(numItems + 2, "key5"));
+
+    std::vector<seqno_t> expectedSeqno = {2, 4, 6, 7, 8};
+    EXPECT_EQ(expectedSeqno, readAllSeqnos());
+    EXPECT_EQ(numItems, skipList->getNumItems());
+    EXPECT_EQ(numItems + 3, skipList->getHighSeqno());
+}
+
+TEST_F(SkipListTest, UpdateDuringRangeIterator) {
+    const int numItems = 3;
+    addNewItemsToList(1, "key", numItems);
+
+    {
+        auto itr = getRangeIterator();
+        /* The item is in the locked range so can't be moved */
+        EXPECT_EQ(SequenceList::UpdateStatus::Append,
+                  updateItem(numItems, "key2"));
+        EXPECT_EQ(1, skipList->getNumStaleItems());
+
+        /* The iterator doesn't see the new version (beyond its range) so
+           returns the old one */
+        std::vector<seqno_t> seqnos;
+        for (; itr.curr() != itr.end(); ++itr) {
+            seqnos.push_back(itr->getBySeqno());
+        }
+        EXPECT_EQ(std::vector<seqno_t>({1, 2, 3}), seqnos);
+    }
+
+    /* Without the iterator the stale item is skipped as its replacement is
+       in the range */
+    EXPECT_EQ(std::vector<seqno_t>({1, 3, 4}), readAllSeqnos());
+}
+
+TEST_F(SkipListTest, RangeIteratorSeek) {
+    const int numItems = 1000;
+    addNewItemsToList(1, "key", numItems);
+
+    auto itr = getRangeIterator();
+    EXPECT_EQ(1, itr.curr());
+    EXPECT_EQ(numItems, itr.back());
+
+    /* Seek forwards */
+    itr.seek(500);
+    EXPECT_EQ(500, itr.curr());
+    EXPECT_EQ(500, itr->getBySeqno());
+    EXPECT_LE(itr.count(), numItems - 499);
+    EXPECT_EQ(std::make_pair(uint64_t(500), uint64_t(numItems)),
+              skipList->getRangeRead());
+
+    /* Seeking backwards does nothing */
+    itr.seek(10);
+    EXPECT_EQ(500, itr.curr());
+
+    ++itr;
+    EXPECT_EQ(501, itr.curr());
+
+    /* Seek beyond the end finishes the iteration and releases the range */
+    itr.seek(numItems + 1);
+    EXPECT_EQ(itr.end(), itr.curr());
+    EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(0)),
+              skipList->getRangeRead());
+}
+
+TEST_F(SkipListTest, RangeIteratorSeekPastMovedItems) {
+    const int numItems = 10;
+    addNewItemsToList(1, "key", numItems);
+
+    /* Move items 4..6 to the end; seeking to 4 lands on the next item still
+       at its original position */
+    for (int ii = 4; ii <= 6; ++ii) {
+        updateItem(numItems + ii - 4, "key" + std::to_string(ii));
+    }
+
+    auto itr = getRangeIterator();
+    itr.seek(4);
+    EXPECT_EQ(7, itr.curr());
+}
+
+TEST_F(SkipListTest, PurgeStaleItems) {
+    const int numItems = 4;
+    addNewItemsToList(1, "key", numItems / 2);
+    addStaleItem("stale", numItems / 2 + 1);
+    addNewItemsToList(numItems / 2 + 2, "key", numItems / 2);
+    addStaleItem("stale", numItems + 2);
+    ASSERT_EQ(numItems + 2, skipList->getNumItems());
+    ASSERT_EQ(2, skipList->getNumStaleItems());
+
+    EXPECT_EQ(2, skipList->purgeTombstones(numItems + 2));
+    EXPECT_EQ(numItems, skipList->getNumItems());
+    EXPECT_EQ(0, skipList->getNumStaleItems());
+    EXPECT_EQ(0, skipList->getStaleValueBytes());
+
+    /* Should be able to add elements to the list after the purger has run */
+    addNewItemsToList(numItems + 3, "key", 1);
+    EXPECT_EQ(std::vector<seqno_t>({1, 2, 4, 5, 7}), readAllSeqnos());
+}
+
+TEST_F(SkipListTest, PurgePauseResume) {
+    const int numItems = 10;
+    for (int ii = 1; ii <= numItems; ++ii) {
+        addStaleItem("stale", ii);
+    }
+
+    int purged = 0, numPaused = -1;
+    while (purged != numItems) {
+        purged += skipList->purgeTombstones(numItems, {}, []() {
+            return true;
+        });
+        ++numPaused;
+    }
+    EXPECT_EQ(numItems - 1, numPaused);
+    EXPECT_EQ(0, skipList->getNumItems());
+}
+
+// Test that the purger doesn't wait for (or block) a range iterator: it
+// purges below the iterator's position, and carries on from there once the
+// iterator has moved on.
+TEST_F(SkipListTest, PurgeRunsBelowRangeIterator) {
+    addStaleItem("stale", 1);
+    addStaleItem("stale", 2);
+    addNewItemsToList(3, "key", 2);
+    addStaleItem("stale", 5);
+    addNewItemsToList(6, "key", 1);
+    ASSERT_EQ(3, skipList->getNumStaleItems());
+
+    auto itr = getRangeIterator();
+    itr.seek(3);
+    ASSERT_EQ(3, itr.curr());
+
+    /* Can purge the stale items before the iterator */
+    EXPECT_EQ(2, skipList->purgeTombstones(6));
+    EXPECT_EQ(1, skipList->getNumStaleItems());
+
+    /* Once the iterator has gone past the last stale item it is purged */
+    for (; itr.curr() != itr.end(); ++itr) {
+    }
+    EXPECT_EQ(1, skipList->purgeTombstones(6));
+    EXPECT_EQ(0, skipList->getNumStaleItems());
+}
+
+// Test that a reader can lock a range while the purger runs, and the purger
+// then stops below it.
+TEST_F(SkipListTest, RangeLockDuringPurge) {
+    addStaleItem("stale", 1);
+    addStaleItem("stale", 2);
+    addStaleItem("stale", 3);
+    addNewItemsToList(4, "key", 1);
+
+    RangeGuard guard;
+    EXPECT_EQ(1, skipList->purgeTombstones(3, {}, [this, &guard]() {
+        if (!guard) {
+            guard = skipList->tryLockSeqnoRangeShared(2, 4);
+            EXPECT_TRUE(guard);
+        }
+        return false;
+    }));
+    EXPECT_EQ(2, skipList->getNumStaleItems());
+
+    guard.reset();
+    EXPECT_EQ(2, skipList->purgeTombstones(3));
+    EXPECT_EQ(0, skipList->getNumStaleItems());
+}
+
+// Test that the nodes unlinked by updates are freed without waiting for the
+// purger, so the memory they use stays bounded while items are updated.
+TEST_F(SkipListTest, UpdatesFreeNodesWithoutPurge) {
+    const int numItems = 10;
+    addNewItemsToList(1, "key", numItems);
+
+    seqno_t highSeqno = numItems;
+    size_t updates = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(1)) {
+        ASSERT_EQ(SequenceList::UpdateStatus::Success,
+                  updateItem(highSeqno, "key1"));
+        ++highSeqno;
+        ++updates;
+    }
+    // Only the nodes retired within the last couple of grace periods are
+    // still waiting to be freed
+    EXPECT_LT(skipList->getNumRetiredNodes(), updates / 2);
+
+    folly::rcu_barrier();
+    EXPECT_EQ(0, skipList->getNumRetiredNodes());
+    EXPECT_EQ(numItems, skipList->getNumItems());
+}
+
+// Test that a range read which starts after items being concurrently
+// updated and purged reads a consistent range.
+TEST_F(SkipListTest, ConcurrentUpdatePurgeAndRangeRead) {
+    const int numItems = 1000;
+    addNewItemsToList(1, "key", numItems);
+
+    std::atomic<bool> done{false};
+    std::thread purger([this, &done]() {
+        while (!done) {
+            skipList->purgeTombstones(skipList->getHighSeqno() - 1);
+        }
+    });
+
+    std::thread reader([this, &done]() {
+        while (!done) {
+            const seqno_t start = skipList->getHighSeqno() / 2 + 1;
+            ENGINE_ERROR_CODE status;
+            std::vector<UniqueItemPtr> items;
+            seqno_t endSeqno;
+            std::tie(status, items, endSeqno) =
+                    skipList->rangeRead(start, skipList->getHighSeqno());
+            ASSERT_EQ(ENGINE_SUCCESS, status);
+            seqno_t prev = start - 1;
+            for (const auto& item : items) {
+                ASSERT_GT(item->getBySeqno(), prev);
+                ASSERT_LE(item->getBySeqno(), endSeqno);
+                prev = item->getBySeqno();
+            }
+        }
+    });
+
+    seqno_t highSeqno = numItems;
+    for (int round = 0; round < 10; ++round) {
+        for (int ii = 1; ii <= numItems; ii += 7) {
+            updateItem(highSeqno, "key" + std::to_string(ii));
+            ++highSeqno;
+        }
+    }
+    done = true;
+    purger.join();
+    reader.join();
+
+    /* Every key is still in the list exactly once, after purging the stale
+       versions */
+    while (skipList->getNumStaleItems() != 0) {
+        skipList->purgeTombstones(highSeqno);
+    }
+    EXPECT_EQ(numItems, skipList->getNumItems());
+    EXPECT_EQ(numItems, readAllSeqnos().size());
+}
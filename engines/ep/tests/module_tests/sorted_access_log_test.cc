@@ -0,0 +1,231 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "sorted_access_log.h"
+#include "mutation_log.h"
+#include "tests/module_tests/test_helpers.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/portability/Unistd.h>
+#include <platform/dirutils.h>
+
+#include <fstream>
+
+/*
+ * Unit tests for the sorted access log format
+ */
+
+class SortedAccessLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = cb::io::mktemp("salt_test");
+    }
+
+    void TearDown() override {
+        cb::io::rmrf(path);
+    }
+
+    /// Write numVBuckets vBuckets of itemsPerVb keys, with seqnos descending.
+    void writeLog(uint16_t numVBuckets, uint32_t itemsPerVb) {
+        SortedAccessLogWriter writer(path);
+        // Add in reverse vbid order; the index must still be sorted.
+        for (int vb = numVBuckets - 1; vb >= 0; --vb) {
+            std::vector<SortedAccessLogWriter::Entry> entries;
+            for (uint32_t ii = 0; ii < itemsPerVb; ++ii) {
+                entries.push_back(
+                        {itemsPerVb - ii,
+                         makeStoredDocKey("vb" + std::to_string(vb) + "_key" +
+                                          std::to_string(itemsPerVb - ii))});
+            }
+            writer.addRun(Vbid(vb), entries);
+        }
+        writer.commit();
+        EXPECT_EQ(size_t(numVBuckets) * itemsPerVb, writer.getNumEntries());
+    }
+
+    /// Overwrite the byte at offset (from the end if negative) of the log.
+    void corruptByte(int64_t offset, char value = '\xff') {
+        std::fstream file(path,
+                          std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(0, std::ios::end);
+        const int64_t size = file.tellg();
+        file.seekp(offset < 0 ? size + offset : offset);
+        file.put(value);
+    }
+
+    std::string path;
+};
+
+TEST_F(SortedAccessLogTest, RoundTrip) {
+    writeLog(4, 100);
+    ASSERT_TRUE(SortedAccessLog::isSortedAccessLog(path));
+
+    SortedAccessLogReader reader(path);
+    EXPECT_EQ(400, reader.getNumEntries());
+    EXPECT_EQ((std::vector<Vbid>{Vbid(0), Vbid(1), Vbid(2), Vbid(3)}),
+              reader.getVBuckets());
+
+    for (uint16_t vb = 0; vb < 4; ++vb) {
+        const auto entries = reader.getEntries(Vbid(vb));
+        EXPECT_EQ(100, entries.size());
+        // Entries come back in seqno order.
+        uint64_t expectedSeqno = 1;
+        for (const auto& entry : entries) {
+            EXPECT_EQ(expectedSeqno, entry.seqno);
+            EXPECT_EQ(makeStoredDocKey("vb" + std::to_string(vb) + "_key" +
+                                       std::to_string(expectedSeqno)),
+                      StoredDocKey(entry.key));
+            ++expectedSeqno;
+        }
+        EXPECT_EQ(101, expectedSeqno);
+    }
+    EXPECT_TRUE(reader.getEntries(Vbid(4)).empty());
+}
+
+TEST_F(SortedAccessLogTest, Empty) {
+    {
+        SortedAccessLogWriter writer(path);
+        std::vector<SortedAccessLogWriter::Entry> none;
+        writer.addRun(Vbid(0), none);
+        writer.commit();
+    }
+    SortedAccessLogReader reader(path);
+    EXPECT_EQ(0, reader.getNumEntries());
+    EXPECT_TRUE(reader.getVBuckets().empty());
+    EXPECT_TRUE(reader.getEntries(Vbid(0)).empty());
+}
+
+// A vBucket can be written as several runs (as the AccessScanner does, one
+// per chunk); each is in seqno order.
+TEST_F(SortedAccessLogTest, MultipleRuns) {
+    {
+        SortedAccessLogWriter writer(path);
+        for (const auto& run : std::vector<std::vector<uint64_t>>{
+                     {8, 6, 5, 7}, {2, 1}, {4, 3}}) {
+            std::vector<SortedAccessLogWriter::Entry> entries;
+            for (auto seqno : run) {
+                entries.push_back(
+                        {seqno, makeStoredDocKey(std::to_string(seqno))});
+            }
+            writer.addRun(Vbid(1), entries);
+        }
+        std::vector<SortedAccessLogWriter::Entry> entries{
+                {1, makeStoredDocKey("vb0")}};
+        writer.addRun(Vbid(0), entries);
+        writer.commit();
+    }
+
+    SortedAccessLogReader reader(path);
+    EXPECT_EQ(9, reader.getNumEntries());
+    EXPECT_EQ((std::vector<Vbid>{Vbid(0), Vbid(1)}), reader.getVBuckets());
+    EXPECT_EQ(1, reader.getEntries(Vbid(0)).size());
+
+    const auto entries = reader.getEntries(Vbid(1));
+    EXPECT_EQ(8, entries.size());
+    std::vector<uint64_t> seqnos;
+    for (const auto& entry : entries) {
+        EXPECT_EQ(makeStoredDocKey(std::to_string(entry.seqno)),
+                  StoredDocKey(entry.key));
+        seqnos.push_back(entry.seqno);
+    }
+    EXPECT_EQ((std::vector<uint64_t>{5, 6, 7, 8, 1, 2, 3, 4}), seqnos);
+}
+
+// The runs of a vBucket must be consecutive.
+TEST_F(SortedAccessLogTest, DuplicateVBucket) {
+    SortedAccessLogWriter writer(path);
+    std::vector<SortedAccessLogWriter::Entry> entries{
+            {1, makeStoredDocKey("key")}};
+    writer.addRun(Vbid(0), entries);
+    writer.addRun(Vbid(0), entries);
+    writer.addRun(Vbid(1), entries);
+    EXPECT_THROW(writer.addRun(Vbid(0), entries), std::logic_error);
+}
+
+// Version 1 logs (one run per vBucket) are still read.
+TEST_F(SortedAccessLogTest, Version1) {
+    writeLog(2, 10);
+    // The version is a big-endian uint32 at offset 8, not covered by the
+    // checksum.
+    corruptByte(11, '\x01');
+    SortedAccessLogReader reader(path);
+    EXPECT_EQ(20, reader.getNumEntries());
+
+    corruptByte(11, '\x03');
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ReadException);
+}
+
+// A MutationLog is not mistaken for a sorted log (and vice versa).
+TEST_F(SortedAccessLogTest, FormatDetection) {
+    {
+        MutationLog ml(path);
+        ml.open();
+        ml.newItem(Vbid(0), makeStoredDocKey("key"));
+        ml.commit1();
+        ml.commit2();
+    }
+    EXPECT_FALSE(SortedAccessLog::isSortedAccessLog(path));
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ReadException);
+
+    writeLog(1, 1);
+    EXPECT_TRUE(SortedAccessLog::isSortedAccessLog(path));
+    MutationLog ml(path);
+    EXPECT_THROW(ml.open(), MutationLog::ReadException);
+}
+
+TEST_F(SortedAccessLogTest, Missing) {
+    cb::io::rmrf(path);
+    EXPECT_FALSE(SortedAccessLog::isSortedAccessLog(path));
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ReadException);
+}
+
+TEST_F(SortedAccessLogTest, CorruptEntry) {
+    writeLog(2, 10);
+    corruptByte(SortedAccessLog::HeaderSize + 20);
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::CRCReadException);
+}
+
+TEST_F(SortedAccessLogTest, CorruptIndex) {
+    writeLog(2, 10);
+    corruptByte(-1);
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::CRCReadException);
+}
+
+TEST_F(SortedAccessLogTest, Truncated) {
+    writeLog(2, 10);
+    const auto size = cb::io::loadFile(path).size();
+    cb::io::rmrf(path);
+    // Never committed: the header is all zeros.
+    {
+        SortedAccessLogWriter writer(path);
+        std::vector<SortedAccessLogWriter::Entry> entries{
+                {1, makeStoredDocKey("key")}};
+        writer.addRun(Vbid(0), entries);
+    }
+    EXPECT_FALSE(SortedAccessLog::isSortedAccessLog(path));
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ReadException);
+
+    // Header only.
+    writeLog(2, 10);
+    ASSERT_EQ(0, truncate(path.c_str(), SortedAccessLog::HeaderSize));
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ShortReadException);
+
+    // Part of the index.
+    writeLog(2, 10);
+    ASSERT_EQ(0, truncate(path.c_str(), size - 1));
+    EXPECT_THROW(SortedAccessLogReader{path}, MutationLog::ShortReadException);
+}
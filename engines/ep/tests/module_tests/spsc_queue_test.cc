@@ -0,0 +1,113 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "spsc_queue.h"
+
+#include <folly/portability/GTest.h>
+
+#include <memory>
+#include <thread>
+
+/*
+ * Unit tests for the SPSCQueue
+ */
+
+class SPSCQueueTest : public ::testing::Test {
+protected:
+    using Queue = SPSCQueue<std::unique_ptr<int>, 4>;
+
+    Queue queue;
+};
+
+TEST_F(SPSCQueueTest, Empty) {
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(0, queue.size());
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST_F(SPSCQueueTest, PushPop) {
+    // Cross several segments.
+    for (int ii = 0; ii < 10; ++ii) {
+        queue.push(std::make_unique<int>(ii));
+        EXPECT_EQ(ii, *queue.back());
+    }
+    EXPECT_EQ(10, queue.size());
+
+    for (int ii = 0; ii < 10; ++ii) {
+        ASSERT_FALSE(queue.empty());
+        EXPECT_EQ(ii, *queue.front());
+        EXPECT_EQ(ii, *queue.pop());
+    }
+    EXPECT_TRUE(queue.empty());
+
+    // Queue is still usable once drained.
+    queue.push(std::make_unique<int>(10));
+    EXPECT_EQ(10, *queue.pop());
+}
+
+// Staged elements are not visible until published.
+TEST_F(SPSCQueueTest, StagePublish) {
+    queue.push(std::make_unique<int>(0));
+    for (int ii = 1; ii < 6; ++ii) {
+        queue.stage(std::make_unique<int>(ii));
+    }
+    EXPECT_EQ(1, queue.size());
+    EXPECT_EQ(0, *queue.pop());
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+
+    queue.publish();
+    EXPECT_EQ(5, queue.size());
+    for (int ii = 1; ii < 6; ++ii) {
+        EXPECT_EQ(ii, *queue.pop());
+    }
+}
+
+TEST_F(SPSCQueueTest, Clear) {
+    for (int ii = 0; ii < 6; ++ii) {
+        queue.push(std::make_unique<int>(ii));
+    }
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    queue.push(std::make_unique<int>(6));
+    EXPECT_EQ(6, *queue.pop());
+}
+
+// Producer and consumer on different threads must see every element, in
+// order (most useful when run under ThreadSanitizer).
+TEST_F(SPSCQueueTest, ConcurrentProducerConsumer) {
+    const int numItems = 100000;
+    std::thread producer([this]() {
+        for (int ii = 0; ii < numItems; ++ii) {
+            queue.stage(std::make_unique<int>(ii));
+            if (ii % 7 == 0) {
+                queue.publish();
+            }
+        }
+        queue.publish();
+    });
+
+    int expected = 0;
+    while (expected < numItems) {
+        if (auto value = queue.pop()) {
+            ASSERT_EQ(expected, *value);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
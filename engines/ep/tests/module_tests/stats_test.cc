@@ -27,6 +27,7 @@
 #include "evp_store_single_threaded_test.h"
 #include "item.h"
 #include "kv_bucket.h"
+#include "statistics/buffered_collector.h"
 #include "statistics/collector.h"
 #include "statistics/labelled_collector.h"
 #include "tasks.h"
@@ -551,6 +552,105 @@ TEST_F(StatTest, StringStats) {
     engine->doEngineStats(collector);
 }
 
+TEST_F(StatTest, BufferedCollector) {
+    // Check that stats added to a BufferedStatCollector are split into chunks
+    // and replayed in order, formatted as CBStatCollector would.
+    using namespace std::string_view_literals;
+    using namespace testing;
+
+    std::vector<BufferedStatCollector::Chunk> chunks;
+    BufferedStatCollector collector(
+            [&chunks](BufferedStatCollector::Chunk&& chunk) {
+                chunks.push_back(std::move(chunk));
+            },
+            64);
+
+    HistogramData hist;
+    hist.mean = 5;
+    hist.buckets.push_back({0, 10, 3});
+
+    collector.addStat("bool_stat", true);
+    collector.addStat("int_stat", int64_t(-1));
+    collector.addStat("uint_stat", uint64_t(1234));
+    collector.addStat("string_stat", "value"sv);
+    collector.addStat("hist_stat", hist);
+    const std::string bigKey(100, 'k');
+    collector.append(bigKey, "big"sv);
+    EXPECT_FALSE(chunks.empty());
+    collector.flush();
+    // A stat bigger than the chunk size gets a chunk to itself.
+    EXPECT_LT(2, chunks.size());
+
+    auto cookie = create_mock_cookie(engine.get());
+    StrictMock<MockFunction<void(
+            std::string_view, std::string_view, gsl::not_null<const void*>)>>
+            cb;
+    {
+        InSequence s;
+        EXPECT_CALL(cb, Call("bool_stat"sv, "true"sv, _));
+        EXPECT_CALL(cb, Call("int_stat"sv, "-1"sv, _));
+        EXPECT_CALL(cb, Call("uint_stat"sv, "1234"sv, _));
+        EXPECT_CALL(cb, Call("string_stat"sv, "value"sv, _));
+        EXPECT_CALL(cb, Call("hist_stat_mean"sv, "5"sv, _));
+        EXPECT_CALL(cb, Call("hist_stat_0,10"sv, "3"sv, _));
+        EXPECT_CALL(cb, Call(std::string_view(bigKey), "big"sv, _));
+    }
+    for (const auto& chunk : chunks) {
+        BufferedStatCollector::replay(chunk, asStdFunction(cb), cookie);
+    }
+    destroy_mock_cookie(cookie);
+}
+
+// Check that the "checkpoint" stat group is computed on a NonIO task and
+// sent once the task notifies the connection.
+TEST_F(StatTest, StreamedStats) {
+    auto cookie = create_mock_cookie(engine.get());
+    std::map<std::string, std::string> stats;
+    AddStatFn addStats = [&stats](std::string_view key,
+                                  std::string_view value,
+                                  gsl::not_null<const void*>) {
+        stats[std::string(key)] = std::string(value);
+    };
+
+    ASSERT_EQ(ENGINE_EWOULDBLOCK,
+              engine->get_stats(cookie, "checkpoint", {}, addStats));
+    EXPECT_TRUE(stats.empty());
+
+    const auto notifications =
+            get_number_of_mock_cookie_io_notifications(cookie);
+    runNextTask(*task_executor->getLpTaskQ()[NONIO_TASK_IDX],
+                "checkpoint stats for all vbuckets");
+    EXPECT_EQ(notifications + 1,
+              get_number_of_mock_cookie_io_notifications(cookie));
+
+    EXPECT_EQ(ENGINE_SUCCESS,
+              engine->get_stats(cookie, "checkpoint", {}, addStats));
+    EXPECT_EQ("active", stats["vb_0:state"]);
+    EXPECT_NE(0, stats.count("vb_0:open_checkpoint_id"));
+    destroy_mock_cookie(cookie);
+}
+
+// Check that a connection which disconnects part way through a streamed stat
+// group is not notified.
+TEST_F(StatTest, StreamedStatsDisconnect) {
+    auto cookie = create_mock_cookie(engine.get());
+    AddStatFn addStats =
+            [](std::string_view, std::string_view, gsl::not_null<const void*>) {
+            };
+
+    ASSERT_EQ(ENGINE_EWOULDBLOCK,
+              engine->get_stats(cookie, "checkpoint", {}, addStats));
+    engine->handleDisconnect(cookie);
+
+    const auto notifications =
+            get_number_of_mock_cookie_io_notifications(cookie);
+    runNextTask(*task_executor->getLpTaskQ()[NONIO_TASK_IDX],
+                "checkpoint stats for all vbuckets");
+    EXPECT_EQ(notifications,
+              get_number_of_mock_cookie_io_notifications(cookie));
+    destroy_mock_cookie(cookie);
+}
+
 TEST_P(DatatypeStatTest, datatypesInitiallyZero) {
     // Check that the datatype stats initialise to 0
     auto vals = get_stat(nullptr);
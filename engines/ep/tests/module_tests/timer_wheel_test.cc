@@ -0,0 +1,169 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "timer_wheel.h"
+
+#include <folly/portability/GTest.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+/*
+ * Unit tests for the TimerWheel
+ */
+
+using namespace std::chrono_literals;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    /// Advance the wheel to now + delta, returning the keys which fired.
+    std::set<int> advance(std::chrono::nanoseconds delta) {
+        now += delta;
+        std::set<int> fired;
+        wheel.advance(now, [&fired](int&& key) { fired.insert(key); });
+        return fired;
+    }
+
+    const std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point now = start;
+    TimerWheel<int> wheel{1ms, start};
+};
+
+TEST_F(TimerWheelTest, Empty) {
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(0, wheel.size());
+    EXPECT_EQ(std::chrono::steady_clock::time_point::max(),
+              wheel.nextExpiry());
+    EXPECT_TRUE(advance(1h).empty());
+}
+
+TEST_F(TimerWheelTest, FiresAtDeadline) {
+    EXPECT_TRUE(wheel.schedule(1, start + 10ms + 500us));
+    EXPECT_TRUE(wheel.contains(1));
+    EXPECT_EQ(start + 10ms + 500us, wheel.nextExpiry());
+
+    // Same tick as the deadline, but before it.
+    EXPECT_TRUE(advance(10ms).empty());
+    EXPECT_EQ(std::set<int>{1}, advance(500us));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, OverdueFiresImmediately) {
+    wheel.schedule(1, start - 1s);
+    EXPECT_EQ(std::set<int>{1}, advance(0ns));
+}
+
+TEST_F(TimerWheelTest, RescheduleMoves) {
+    EXPECT_TRUE(wheel.schedule(1, start + 10ms));
+    EXPECT_FALSE(wheel.schedule(1, start + 20ms));
+    EXPECT_EQ(1, wheel.size());
+    EXPECT_TRUE(advance(10ms).empty());
+    EXPECT_EQ(std::set<int>{1}, advance(10ms));
+}
+
+TEST_F(TimerWheelTest, UpdateOnlyExisting) {
+    EXPECT_FALSE(wheel.update(1, start + 10ms));
+    EXPECT_TRUE(wheel.empty());
+
+    wheel.schedule(1, start + 1h);
+    EXPECT_TRUE(wheel.update(1, start + 10ms));
+    EXPECT_EQ(std::set<int>{1}, advance(10ms));
+}
+
+TEST_F(TimerWheelTest, Cancel) {
+    wheel.schedule(1, start + 10ms);
+    wheel.schedule(2, start + 10ms);
+    EXPECT_TRUE(wheel.cancel(1));
+    EXPECT_FALSE(wheel.cancel(1));
+    EXPECT_EQ(std::set<int>{2}, advance(10ms));
+}
+
+// Timers far enough out to be held in the higher levels (and beyond the
+// range of the wheel) must cascade down and fire at the right time.
+TEST_F(TimerWheelTest, HigherLevels) {
+    const std::vector<std::chrono::nanoseconds> deadlines{
+            300ms, 70s, 5h, 30 * 24h, 100 * 24h, 10 * 365 * 24h};
+    for (int i = 0; i < int(deadlines.size()); ++i) {
+        wheel.schedule(i, start + deadlines[i]);
+    }
+
+    for (int i = 0; i < int(deadlines.size()); ++i) {
+        // nextExpiry must never be after the earliest deadline.
+        EXPECT_LE(wheel.nextExpiry(), start + deadlines[i]);
+        EXPECT_TRUE(advance(start + deadlines[i] - 1ns - now).empty());
+        EXPECT_EQ(std::set<int>{i}, advance(1ns));
+    }
+    EXPECT_TRUE(wheel.empty());
+}
+
+// Time going backwards (e.g. a stale cached time) only fires what is due.
+TEST_F(TimerWheelTest, StaleNow) {
+    wheel.schedule(1, start + 10ms);
+    wheel.schedule(2, start + 20ms);
+    EXPECT_EQ(std::set<int>{1}, advance(15ms));
+    EXPECT_TRUE(advance(-5ms).empty());
+    wheel.schedule(3, start + 5ms);
+    EXPECT_EQ(std::set<int>{3}, advance(0ns));
+    EXPECT_EQ(std::set<int>{2}, advance(10ms));
+}
+
+// Compare against a simple model with a random mix of operations.
+TEST_F(TimerWheelTest, RandomisedAgainstModel) {
+    std::mt19937_64 gen(0);
+    std::map<int, std::chrono::steady_clock::time_point> model;
+
+    for (int op = 0; op < 100000; ++op) {
+        const int key = gen() % 1000;
+        switch (gen() % 4) {
+        case 0: {
+            // Mostly near deadlines, some far and some overdue.
+            const auto range = std::vector<int64_t>{
+                    2'000'000, 1'000'000'000, 1'000'000'000'000}[gen() % 3];
+            const auto deadline =
+                    now + std::chrono::nanoseconds(int64_t(gen() % range) -
+                                                   range / 100);
+            EXPECT_EQ(!model.count(key), wheel.schedule(key, deadline));
+            model[key] = deadline;
+            break;
+        }
+        case 1:
+            EXPECT_EQ(model.erase(key) == 1, wheel.cancel(key));
+            break;
+        default: {
+            const auto fired =
+                    advance(std::chrono::nanoseconds(gen() % 5'000'000));
+            std::set<int> expected;
+            for (auto it = model.begin(); it != model.end();) {
+                if (it->second <= now) {
+                    expected.insert(it->first);
+                    it = model.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            ASSERT_EQ(expected, fired);
+            ASSERT_EQ(model.size(), wheel.size());
+            const auto nextExpiry = wheel.nextExpiry();
+            for (const auto& entry : model) {
+                ASSERT_LE(nextExpiry, entry.second);
+            }
+        }
+        }
+    }
+}
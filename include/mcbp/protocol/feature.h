@@ -88,6 +88,10 @@ enum class Feature : uint16_t {
     /// Does the server support using the virtual $document attributes in macro
     /// expansion ( "${document.CAS}" etc)
     SubdocDocumentMacroSupport = 0x18,
+
+    /// Tell the server that it may execute the commands in the pipeline
+    /// concurrently, as long as the responses are sent in request order
+    OrderedPipelining = 0x19,
 };
 
 } // namespace mcbp
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "collector.h"
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+ * StatCollector which serializes stats into fixed size chunks of memory,
+ * rather than immediately calling an AddStatFn for each one.
+ *
+ * Allows a (slow) group of stats to be computed somewhere other than the
+ * front-end thread which is serving the CMD_STAT request (e.g. on an executor
+ * thread), and handed back to it in chunks. The front-end then calls replay()
+ * with each chunk to send the stats to the client.
+ *
+ * Each stat is appended to the current chunk as
+ *
+ *   keylen    uint16 (host byte order)
+ *   valuelen  uint32 (host byte order)
+ *   key       keylen bytes
+ *   value     valuelen bytes
+ *
+ * with numbers formatted to text exactly as CBStatCollector would. Values are
+ * formatted on the stack and chunks are allocated (at their full size) only
+ * when the previous one fills up, so adding a stat does not allocate.
+ */
+class BufferedStatCollector : public StatCollector {
+public:
+    using Chunk = std::vector<char>;
+
+    /// Called with each chunk, once it is full or flush() is called.
+    using ChunkFn = std::function<void(Chunk&&)>;
+
+    static constexpr size_t DefaultChunkSize = 64 * 1024;
+
+    explicit BufferedStatCollector(ChunkFn chunkFn,
+                                   size_t chunkSize = DefaultChunkSize);
+
+    // Allow usage of the "helper" methods defined in the base type.
+    // They would otherwise be shadowed
+    using StatCollector::addStat;
+
+    void addStat(const cb::stats::StatDef& k,
+                 std::string_view v,
+                 const Labels& labels) override;
+    void addStat(const cb::stats::StatDef& k,
+                 bool v,
+                 const Labels& labels) override;
+    void addStat(const cb::stats::StatDef& k,
+                 int64_t v,
+                 const Labels& labels) override;
+    void addStat(const cb::stats::StatDef& k,
+                 uint64_t v,
+                 const Labels& labels) override;
+    void addStat(const cb::stats::StatDef& k,
+                 double v,
+                 const Labels& labels) override;
+    void addStat(const cb::stats::StatDef& k,
+                 const HistogramData& hist,
+                 const Labels& labels) override;
+
+    /**
+     * Append an already formatted stat. Has the signature of an AddStatFn
+     * (minus the cookie) so code which has not yet been converted to the
+     * StatCollector interface can add to a BufferedStatCollector.
+     */
+    void append(std::string_view key, std::string_view value);
+
+    /// Pass the current chunk (if not empty) to the ChunkFn.
+    void flush();
+
+    /**
+     * Call addStatFn for each stat in the given chunk, in the order they
+     * were added.
+     */
+    static void replay(const Chunk& chunk,
+                       const AddStatFn& addStatFn,
+                       const void* cookie);
+
+private:
+    const ChunkFn chunkFn;
+    const size_t chunkSize;
+    Chunk chunk;
+};
@@ -98,13 +98,21 @@ struct StatDef {
             std::string_view metricFamilyKey,
             Labels&& labels);
 
+    /**
+     * @returns the metric name used by Prometheus. Used to "group" stats in
+     * combination with distinguishing labels.
+     */
+    std::string_view getMetricFamily() const {
+        return metricFamily.empty() ? uniqueKey : metricFamily;
+    }
+
     // Key which is unique per bucket. Used by CBStats
     std::string_view uniqueKey;
     // The unit this stat represents, e.g., microseconds.
     // Used to scale to base units and name the stat correctly for Prometheus,
     cb::stats::Unit unit;
-    // Metric name used by Prometheus. Used to "group"
-    // stats in combination with distinguishing labels.
+    // Metric family name, if it differs from uniqueKey (empty otherwise).
+    // Use getMetricFamily().
     std::string metricFamily;
     // Labels for this metric. Labels set here will
     // override defaults labels set in the StatCollector
@@ -139,6 +139,7 @@ STAT(ep_bg_fetched, count, , , )
 STAT(ep_bg_meta_fetched, count, , , )
 STAT(ep_bg_remaining_items, count, , , )
 STAT(ep_bg_remaining_jobs, count, , , )
+STAT(ep_bg_fetches_in_flight, count, , , )
 STAT(ep_num_pager_runs, count, , , )
 STAT(ep_num_expiry_pager_runs, count, , , )
 STAT(ep_num_freq_decayer_runs, count, , , )
@@ -272,6 +273,10 @@ STAT(bg_batch_size,
      count,
      ,
      , ) // TODO: this is not timing related but is in doTimingStats
+// Histogram of how many vBucket batches the bucket's BgFetchers were reading
+// from disk at once, sampled as each batch starts. Not a timing, but it is
+// reported by doTimingStats alongside bg_batch_size.
+STAT(bg_fetches_in_flight, count, , , )
 STAT(persistence_cursor_get_all_items,
      microseconds,
      cursor_get_all_items_time,
@@ -49,8 +49,12 @@ Options:
                                  kilo or megabytes).
   -c or --control key=value      Add a control message
   -C or --csv                    Print out the result as csv (ms;bytes;#items)
+                                 (followed by ;cpu ms;cpu ms per GB with -U)
   -M or --memcached              Connect to a memcached bucket (no cccp)
   -N or --name                   The dcp name to use
+  -U or --cpu-usage              Report the CPU time the server spent on the
+                                 DCP connections (per GB streamed). Requires
+                                 the Stats privilege
   -v or --verbose                Add more output
   -4 or --ipv4                   Connect over IPv4
   -6 or --ipv6                   Connect over IPv6
@@ -104,6 +108,30 @@ size_t total_bytes = 0;
 size_t max_vbuckets = 0;
 bool verbose = false;
 
+/// When requested (--cpu-usage) we keep a second connection to each node
+/// to look up the CPU time the server spent on our DCP connection (the
+/// total_cpu_time reported in "stats connections") before the DCP
+/// connection gets closed.
+struct CpuMonitor {
+    std::unique_ptr<MemcachedConnection> connection;
+    intptr_t dcpConnectionId;
+};
+std::vector<CpuMonitor> cpuMonitors;
+std::chrono::nanoseconds server_cpu_time{0};
+
+static void sampleServerCpuTime() {
+    server_cpu_time = std::chrono::nanoseconds::zero();
+    for (auto& monitor : cpuMonitors) {
+        monitor.connection->stats(
+                [](const std::string&, const std::string& value) {
+                    const auto json = nlohmann::json::parse(value);
+                    server_cpu_time += std::chrono::nanoseconds(std::stoull(
+                            json["total_cpu_time"].get<std::string>()));
+                },
+                "connections " + std::to_string(monitor.dcpConnectionId));
+    }
+}
+
 static void handleDcpNoop(const cb::mcbp::Request& header, bufferevent* bev) {
     cb::mcbp::Response resp = {};
     resp.setMagic(cb::mcbp::Magic::ClientResponse);
@@ -195,6 +223,10 @@ void read_callback(bufferevent* bev, void*) {
 
         evbuffer_drain(input, header->getBodylen() + sizeof(cb::mcbp::Header));
         if (stream_end == max_vbuckets) {
+            // Grab the server side CPU usage while the DCP connections
+            // still exist
+            sampleServerCpuTime();
+
             // Received all stream end messages.. shut down our read
             // side and wait for our send pipe to be drained to cause
             // the bufferevent loop to stop
@@ -372,6 +404,7 @@ int main(int argc, char** argv) {
     sa_family_t family = AF_UNSPEC;
     bool csv = false;
     bool memcached = false;
+    bool cpuUsage = false;
     std::vector<std::pair<std::string, std::string>> controls;
     std::string name = "dcpdrain";
 
@@ -393,11 +426,12 @@ int main(int argc, char** argv) {
             {"memcached", no_argument, nullptr, 'M'},
             {"name", required_argument, nullptr, 'N'},
             {"verbose", no_argument, nullptr, 'v'},
+            {"cpu-usage", no_argument, nullptr, 'U'},
             {nullptr, 0, nullptr, 0}};
 
     while ((cmd = getopt_long(argc,
                               argv,
-                              "46h:p:u:b:P:B:c:vCMN:",
+                              "46h:p:u:b:P:B:c:vCMN:U",
                               long_options.data(),
                               nullptr)) != EOF) {
         switch (cmd) {
@@ -440,6 +474,9 @@ int main(int argc, char** argv) {
         case 'N':
             name = optarg;
             break;
+        case 'U':
+            cpuUsage = true;
+            break;
         default:
             usage();
             return EXIT_FAILURE;
@@ -505,6 +542,16 @@ int main(int argc, char** argv) {
 
         // set up all of the connections
         for (const auto& [c, vbuckets] : vbmap) {
+            if (cpuUsage) {
+                auto monitor = c->clone();
+                if (!user.empty()) {
+                    monitor->authenticate(
+                            user, password, monitor->getSaslMechanisms());
+                }
+                cpuMonitors.push_back({std::move(monitor),
+                                       c->getServerConnectionId()});
+            }
+
             auto rsp = c->execute(BinprotDcpOpenCommand{
                     name, cb::mcbp::request::DcpOpenPayload::Producer});
             if (!rsp.isSuccess()) {
@@ -592,15 +639,31 @@ int main(int argc, char** argv) {
     const auto duration =
             std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
 
+    const auto cpu = std::chrono::duration_cast<std::chrono::milliseconds>(
+            server_cpu_time);
+    // Server CPU time (in ms) per GB streamed
+    const auto cpuPerGB = total_bytes == 0
+                                  ? 0.0
+                                  : double(cpu.count()) * (1024 * 1024 * 1024) /
+                                            total_bytes;
+
     if (csv) {
-        std::cout << duration.count() << ';' << total_bytes << ';' << mutations
-                  << std::endl;
+        std::cout << duration.count() << ';' << total_bytes << ';' << mutations;
+        if (cpuUsage) {
+            std::cout << ';' << cpu.count() << ';' << cpuPerGB;
+        }
+        std::cout << std::endl;
     } else {
         std::cout << "Took " << duration.count() << " ms - " << mutations
                   << " mutations with a total of " << total_bytes
                   << " bytes received ("
                   << calculateThroughput(total_bytes, duration.count() / 1000)
                   << ")" << std::endl;
+        if (cpuUsage) {
+            std::cout << "Server used " << cpu.count()
+                      << " ms CPU on the DCP connections (" << cpuPerGB
+                      << " ms/GB)" << std::endl;
+        }
     }
     return EXIT_SUCCESS;
 }
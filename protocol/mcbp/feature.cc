@@ -69,6 +69,8 @@ std::string to_string(cb::mcbp::Feature feature) {
         return "SubdocCreateAsDeleted";
     case cb::mcbp::Feature::SubdocDocumentMacroSupport:
         return "SubdocDocumentMacroSupport";
+    case cb::mcbp::Feature::OrderedPipelining:
+        return "OrderedPipelining";
     }
 
     throw std::invalid_argument(
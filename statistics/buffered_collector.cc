@@ -0,0 +1,142 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "statistics/buffered_collector.h"
+
+#include <gsl/gsl>
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace std::string_view_literals;
+
+static constexpr size_t HeaderSize = sizeof(uint16_t) + sizeof(uint32_t);
+
+BufferedStatCollector::BufferedStatCollector(ChunkFn chunkFn, size_t chunkSize)
+    : chunkFn(std::move(chunkFn)), chunkSize(chunkSize) {
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    std::string_view v,
+                                    const Labels&) {
+    // As for CBStatCollector, only the uniqueKey is used.
+    append(k.uniqueKey, v);
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    bool v,
+                                    const Labels& labels) {
+    addStat(k, v ? "true"sv : "false"sv, labels);
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    int64_t v,
+                                    const Labels& labels) {
+    fmt::memory_buffer buf;
+    format_to(buf, "{}", v);
+    addStat(k, {buf.data(), buf.size()}, labels);
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    uint64_t v,
+                                    const Labels& labels) {
+    fmt::memory_buffer buf;
+    format_to(buf, "{}", v);
+    addStat(k, {buf.data(), buf.size()}, labels);
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    double v,
+                                    const Labels& labels) {
+    fmt::memory_buffer buf;
+    format_to(buf, "{}", v);
+    addStat(k, {buf.data(), buf.size()}, labels);
+}
+
+void BufferedStatCollector::addStat(const cb::stats::StatDef& k,
+                                    const HistogramData& hist,
+                                    const Labels&) {
+    // Same naming as CBStatCollector, but formatting the key and value
+    // directly rather than via a StatDef per bucket.
+    fmt::memory_buffer key;
+    fmt::memory_buffer value;
+    format_to(key, "{}_mean", k.uniqueKey);
+    format_to(value, "{}", hist.mean);
+    append({key.data(), key.size()}, {value.data(), value.size()});
+
+    for (const auto& bucket : hist.buckets) {
+        key.resize(0);
+        value.resize(0);
+        format_to(key,
+                  "{}_{},{}",
+                  k.uniqueKey,
+                  bucket.lowerBound,
+                  bucket.upperBound);
+        format_to(value, "{}", bucket.count);
+        append({key.data(), key.size()}, {value.data(), value.size()});
+    }
+}
+
+void BufferedStatCollector::append(std::string_view key,
+                                   std::string_view value) {
+    Expects(key.size() <= std::numeric_limits<uint16_t>::max());
+    Expects(value.size() <= std::numeric_limits<uint32_t>::max());
+
+    const auto needed = HeaderSize + key.size() + value.size();
+    if (!chunk.empty() && chunk.size() + needed > chunkSize) {
+        flush();
+    }
+    if (chunk.capacity() == 0) {
+        chunk.reserve(std::max(chunkSize, needed));
+    }
+
+    const auto keyLen = uint16_t(key.size());
+    const auto valueLen = uint32_t(value.size());
+    const auto pos = chunk.size();
+    chunk.resize(pos + needed);
+    auto* dest = chunk.data() + pos;
+    std::memcpy(dest, &keyLen, sizeof(keyLen));
+    std::memcpy(dest + sizeof(keyLen), &valueLen, sizeof(valueLen));
+    std::memcpy(dest + HeaderSize, key.data(), key.size());
+    std::memcpy(dest + HeaderSize + key.size(), value.data(), value.size());
+}
+
+void BufferedStatCollector::flush() {
+    if (chunk.empty()) {
+        return;
+    }
+    chunkFn(std::move(chunk));
+    chunk = Chunk();
+}
+
+void BufferedStatCollector::replay(const Chunk& chunk,
+                                   const AddStatFn& addStatFn,
+                                   const void* cookie) {
+    const auto* pos = chunk.data();
+    const auto* end = pos + chunk.size();
+    while (pos < end) {
+        uint16_t keyLen;
+        uint32_t valueLen;
+        std::memcpy(&keyLen, pos, sizeof(keyLen));
+        std::memcpy(&valueLen, pos + sizeof(keyLen), sizeof(valueLen));
+        pos += HeaderSize;
+        addStatFn({pos, keyLen}, {pos + keyLen, valueLen}, cookie);
+        pos += keyLen + valueLen;
+    }
+}
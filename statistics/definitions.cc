@@ -47,12 +47,16 @@ StatDef::StatDef(std::string_view uniqueKey,
                  Labels&& labels)
     : uniqueKey(uniqueKey),
       unit(unit),
-      metricFamily(metricFamilyKey),
       labels(std::move(labels)) {
-    if (metricFamily.empty()) {
-        metricFamily = uniqueKey;
+    // Ad-hoc StatDefs are constructed for every stat which is not (yet) in
+    // stats.def.h, so only build a separate metric family name if it would
+    // differ from the uniqueKey; this keeps the common case allocation-free.
+    const auto suffix = unit.getSuffix();
+    if (metricFamilyKey.empty() && suffix.empty()) {
+        return;
     }
-    metricFamily += unit.getSuffix();
+    metricFamily = metricFamilyKey.empty() ? uniqueKey : metricFamilyKey;
+    metricFamily += suffix;
 }
 
 } // end namespace cb::stats
\ No newline at end of file
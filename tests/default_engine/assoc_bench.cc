@@ -0,0 +1,180 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "default_engine_internal.h"
+
+#include <benchmark/benchmark.h>
+#include <platform/crc32c.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Normally provided by default_engine.cc; items here use the same layout
+// (hash_item immediately followed by its hash_key).
+hash_key* item_get_key(const hash_item* item) {
+    return (hash_key*)(item + 1);
+}
+
+/**
+ * Fixture for multi-threaded access to default_engine hash tables.
+ *
+ * The benchmark argument selects whether every thread uses one shared
+ * table (as when all buckets shared the process-wide table) or each thread
+ * uses the table of its own bucket. Operations within one bucket are
+ * serialised by the bucket's items.lock, which is modelled by holding a
+ * per-bucket mutex around every operation.
+ */
+class AssocBench : public benchmark::Fixture {
+public:
+    struct BenchItem {
+        hash_item item;
+        hash_key key;
+    };
+
+    /// One bucket's table, the items.lock serialising access to it and the
+    /// items it initially contains.
+    struct Bucket {
+        Bucket() : assoc(16) {
+        }
+        std::mutex itemsLock;
+        Assoc assoc;
+        std::vector<std::unique_ptr<BenchItem>> items;
+    };
+
+    void SetUp(benchmark::State& state) override {
+        if (state.thread_index == 0) {
+            const bool perBucket = state.range(0);
+            for (int bb = 0; bb < (perBucket ? state.threads : 1); ++bb) {
+                auto bucket = std::make_unique<Bucket>();
+                bucket->items = createItems("key::", numItems);
+                for (auto& it : bucket->items) {
+                    bucket->assoc.insert(hashOf(*it), &it->item);
+                }
+                buckets.push_back(std::move(bucket));
+            }
+        }
+    }
+
+    void TearDown(benchmark::State& state) override {
+        if (state.thread_index == 0) {
+            // Destroy the tables first; they may still be migrating items
+            buckets.clear();
+            threadItems.clear();
+        }
+    }
+
+    Bucket& getBucket(const benchmark::State& state) {
+        return *buckets[state.thread_index % buckets.size()];
+    }
+
+    static std::vector<std::unique_ptr<BenchItem>> createItems(
+            const std::string& prefix, size_t count) {
+        std::vector<std::unique_ptr<BenchItem>> ret;
+        ret.reserve(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            auto it = std::make_unique<BenchItem>();
+            const auto key = prefix + std::to_string(ii);
+            it->key.header.full_key = (hash_key_data*)&it->key.key_storage;
+            hash_key_set_len(
+                    &it->key,
+                    gsl::narrow<uint16_t>(sizeof(bucket_id_t) + key.size()));
+            hash_key_set_bucket_index(&it->key, 0);
+            hash_key_set_client_key(&it->key, key.data(), key.size());
+            ret.push_back(std::move(it));
+        }
+        return ret;
+    }
+
+    static uint32_t hashOf(const BenchItem& it) {
+        return crc32c(hash_key_get_key(&it.key),
+                      hash_key_get_key_len(&it.key),
+                      0);
+    }
+
+    static const size_t numItems = 100000;
+
+    static const size_t numThreadItems = 10000;
+
+    std::vector<std::unique_ptr<Bucket>> buckets;
+    // Per-thread keys for the insert/remove benchmark, indexed by thread
+    std::vector<std::vector<std::unique_ptr<BenchItem>>> threadItems;
+};
+
+// Benchmark concurrent lookups of existing keys.
+BENCHMARK_DEFINE_F(AssocBench, Find)(benchmark::State& state) {
+    auto& bucket = getBucket(state);
+    size_t ii = state.thread_index * 7919;
+    for (auto _ : state) {
+        const auto& it = *bucket.items[ii++ % numItems];
+        std::lock_guard<std::mutex> guard(bucket.itemsLock);
+        benchmark::DoNotOptimize(bucket.assoc.find(hashOf(it), &it.key));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Benchmark a read-mostly mix: each thread inserts and removes its own
+// keys (growing the table, so expansion runs concurrently with the other
+// operations) while looking up the shared keys.
+BENCHMARK_DEFINE_F(AssocBench, FindInsertRemove)(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        threadItems.resize(state.threads);
+        for (int tt = 0; tt < state.threads; ++tt) {
+            threadItems[tt] = createItems(
+                    "thread" + std::to_string(tt) + "::", numThreadItems);
+        }
+    }
+
+    auto& bucket = getBucket(state);
+    size_t ii = state.thread_index * 7919;
+    size_t ops = 0;
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> guard(bucket.itemsLock);
+        if (ii % 10 == 0) {
+            // First pass over our keys inserts them, the second removes them
+            auto& it = *threadItems[state.thread_index][ops % numThreadItems];
+            if (ops < numThreadItems) {
+                bucket.assoc.insert(hashOf(it), &it.item);
+            } else {
+                bucket.assoc.remove(hashOf(it), &it.key);
+            }
+            ops = (ops + 1) % (numThreadItems * 2);
+        } else {
+            const auto& it = *bucket.items[ii % numItems];
+            benchmark::DoNotOptimize(bucket.assoc.find(hashOf(it), &it.key));
+        }
+        ++ii;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(AssocBench, Find)
+        ->ArgName("per_bucket")
+        ->Arg(0)
+        ->Arg(1)
+        ->ThreadRange(1, 32)
+        ->UseRealTime();
+
+BENCHMARK_REGISTER_F(AssocBench, FindInsertRemove)
+        ->ArgName("per_bucket")
+        ->Arg(0)
+        ->Arg(1)
+        ->ThreadRange(1, 32)
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,233 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the default_engine slab allocator's per-class magazines of
+ * free chunks.
+ *
+ * Note that each thread is given its magazine slot (round-robin) the first
+ * time it allocates or frees, and keeps it for its lifetime; the tests use
+ * fewer than SLAB_MAGAZINE_SLOTS threads in total so no other thread shares
+ * the main thread's slot.
+ */
+
+#include "default_engine_internal.h"
+
+#include <folly/portability/GTest.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SlabsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        engine = std::make_unique<default_engine>();
+        default_engine_constructor(engine.get(), 0);
+        // With a limit of 1 byte every slab class gets exactly one page
+        // (the first page of a class is always allowed)
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  slabs_init(engine.get(),
+                             limited ? 1 : engine->config.maxbytes,
+                             engine->config.factor,
+                             false));
+        id = slabs_clsid(engine.get(), ItemSize);
+        ASSERT_NE(0, id);
+    }
+
+    void TearDown() override {
+        slabs_destroy(engine.get());
+    }
+
+    std::vector<void*> allocate(size_t count) {
+        std::vector<void*> chunks;
+        for (size_t ii = 0; ii < count; ++ii) {
+            auto* chunk = slabs_alloc(engine.get(), ItemSize, id);
+            EXPECT_NE(nullptr, chunk);
+            chunks.push_back(chunk);
+        }
+        return chunks;
+    }
+
+    void free(const std::vector<void*>& chunks) {
+        for (auto* chunk : chunks) {
+            slabs_free(engine.get(), chunk, ItemSize, id);
+        }
+    }
+
+    /// @return the number of chunks the calling thread's magazine held
+    ///         (emptying it)
+    size_t drainMagazine() {
+        size_t count = 0;
+        while (slabs_alloc_cached(engine.get(), ItemSize, id) != nullptr) {
+            ++count;
+        }
+        return count;
+    }
+
+    /// The slabs stats of the test's slab class, by name
+    std::map<std::string, uint64_t> getStats() {
+        std::map<std::string, uint64_t> stats;
+        const auto prefix = std::to_string(id) + ":";
+        slabs_stats(engine.get(),
+                    [&stats, &prefix](std::string_view key,
+                                      std::string_view value,
+                                      gsl::not_null<const void*>) {
+                        if (key.substr(0, prefix.size()) == prefix) {
+                            stats[std::string(key.substr(prefix.size()))] =
+                                    std::stoull(std::string(value));
+                        }
+                    },
+                    this);
+        return stats;
+    }
+
+    /// Check that the class's stats account for count chunks in use and all
+    /// others as free
+    void expectStats(uint64_t used) {
+        auto stats = getStats();
+        EXPECT_EQ(used, stats["used_chunks"]);
+        EXPECT_EQ(stats["total_chunks"],
+                  stats["used_chunks"] + stats["free_chunks"] +
+                          stats["free_chunks_end"]);
+        EXPECT_EQ(used * ItemSize, stats["mem_requested"]);
+    }
+
+    static constexpr size_t ItemSize = 1000;
+
+    bool limited = false;
+    std::unique_ptr<default_engine> engine;
+    unsigned int id = 0;
+};
+
+/**
+ * Frees go to the thread's magazine; once it is full, half of it is
+ * returned to the slab class before the chunk is added.
+ */
+TEST_F(SlabsTest, MagazineFlush) {
+    free(allocate(SLAB_MAGAZINE_SIZE + 1));
+    EXPECT_EQ(SLAB_MAGAZINE_SIZE / 2 + 1, drainMagazine());
+    expectStats(0);
+}
+
+/**
+ * An allocation which misses the (empty) magazine takes a chunk from the
+ * slab class, and tops the magazine up to half full from its free list.
+ */
+TEST_F(SlabsTest, MagazineRefill) {
+    // Leave chunks on the class free list, and the magazine empty
+    free(allocate(SLAB_MAGAZINE_SIZE * 3));
+    drainMagazine();
+    ASSERT_EQ(nullptr, slabs_alloc_cached(engine.get(), ItemSize, id));
+
+    ASSERT_NE(nullptr, slabs_alloc(engine.get(), ItemSize, id));
+    EXPECT_EQ(SLAB_MAGAZINE_SIZE / 2, drainMagazine());
+}
+
+/// Chunks held in magazines are counted as free (and not requested)
+TEST_F(SlabsTest, StatsCountMagazineChunksAsFree) {
+    expectStats(0);
+    auto chunks = allocate(SLAB_MAGAZINE_SIZE * 2);
+    expectStats(chunks.size());
+
+    // Some to the magazine only, then enough to flush it
+    const std::vector<void*> some(chunks.begin(), chunks.begin() + 4);
+    free(some);
+    expectStats(chunks.size() - some.size());
+    const std::vector<void*> rest(chunks.begin() + 4, chunks.end());
+    free(rest);
+    expectStats(0);
+
+    // And taking them back out of the magazine
+    chunks = allocate(SLAB_MAGAZINE_SIZE / 2);
+    expectStats(chunks.size());
+    free(chunks);
+    expectStats(0);
+}
+
+/**
+ * The stats stay consistent while several threads allocate and free
+ * through their own magazines (and the class free list) concurrently.
+ */
+TEST_F(SlabsTest, ConcurrentAllocFree) {
+    const int numThreads = 4;
+    std::vector<std::thread> threads;
+    for (int tt = 0; tt < numThreads; ++tt) {
+        threads.emplace_back([this]() {
+            for (int ii = 0; ii < 100; ++ii) {
+                free(allocate(1 + ii % (SLAB_MAGAZINE_SIZE * 2)));
+            }
+        });
+    }
+    for (int ii = 0; ii < 100; ++ii) {
+        // A chunk moving between a magazine and the class free list must be
+        // counted exactly once
+        auto stats = getStats();
+        EXPECT_LE(stats["used_chunks"], stats["total_chunks"]);
+        EXPECT_EQ(stats["used_chunks"] * ItemSize, stats["mem_requested"]);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    expectStats(0);
+}
+
+class LimitedSlabsTest : public SlabsTest {
+protected:
+    void SetUp() override {
+        limited = true;
+        SlabsTest::SetUp();
+    }
+};
+
+/**
+ * When the slab class is out of memory, an allocation steals the free
+ * chunks parked in other threads' magazines.
+ */
+TEST_F(LimitedSlabsTest, StealFromOtherMagazine) {
+    // Use up the class's only page
+    std::vector<void*> chunks;
+    void* chunk;
+    while ((chunk = slabs_alloc(engine.get(), ItemSize, id)) != nullptr) {
+        chunks.push_back(chunk);
+    }
+    ASSERT_EQ(engine->slabs.slabclass[id].perslab, chunks.size());
+
+    // Another thread frees a few (not enough to fill its magazine)
+    const size_t freed = 4;
+    std::thread other([this, &chunks, freed]() {
+        for (size_t ii = 0; ii < freed; ++ii) {
+            slabs_free(engine.get(), chunks.back(), ItemSize, id);
+            chunks.pop_back();
+        }
+    });
+    other.join();
+    expectStats(chunks.size());
+
+    // They're not in this thread's magazine, but can be stolen
+    ASSERT_EQ(nullptr, slabs_alloc_cached(engine.get(), ItemSize, id));
+    for (size_t ii = 0; ii < freed; ++ii) {
+        chunk = slabs_alloc(engine.get(), ItemSize, id);
+        ASSERT_NE(nullptr, chunk);
+        chunks.push_back(chunk);
+    }
+    EXPECT_EQ(nullptr, slabs_alloc(engine.get(), ItemSize, id));
+    expectStats(chunks.size());
+    free(chunks);
+}
@@ -21,6 +21,7 @@
 
 #include <benchmark/benchmark.h>
 #include <daemon/timing_histogram.h>
+#include <daemon/timings.h>
 #include <folly/portability/GTest.h>
 #include <nlohmann/json.hpp>
 #include <utilities/hdrhistogram.h>
@@ -203,6 +204,39 @@ void HistogramToJson(benchmark::State& state) {
     }
 }
 
+/*
+ * Record command timings from state.threads front-end threads into the
+ * Timings of one bucket, where each core records into its own histograms.
+ */
+void TimingsCollect(benchmark::State& state) {
+    using namespace std::chrono;
+    static Timings timings;
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        timings.collect(cb::mcbp::ClientOpcode::Get,
+                        microseconds(50 + (i++ % 1000) * 10));
+    }
+    if (state.thread_index == 0) {
+        state.counters["recorded"] =
+                timings.get_timing_histogram(uint8_t(
+                                cb::mcbp::ClientOpcode::Get))
+                        .getValueCount();
+    }
+}
+
+/*
+ * As TimingsCollect, but with every thread recording into one shared
+ * histogram (as Timings did before it was sharded by core).
+ */
+void SharedHistogramCollect(benchmark::State& state) {
+    using namespace std::chrono;
+    static Hdr1sfMicroSecHistogram histogram;
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        histogram.add(microseconds(50 + (i++ % 1000) * 10));
+    }
+}
+
 BENCHMARK_TEMPLATE(HistogramConstructionDestructionHeap, TimingHistogram);
 BENCHMARK_TEMPLATE(HistogramConstructionDestructionHeap, HdrHistogramBench);
 BENCHMARK_TEMPLATE(HistogramConstructionDestructionHeap, HdrHistogramEmpty);
@@ -239,4 +273,11 @@ BENCHMARK_TEMPLATE(HistogramReset, HdrHistogramEmpty);
 BENCHMARK_TEMPLATE(HistogramAggregation, TimingHistogram)->Arg(100);
 BENCHMARK_TEMPLATE(HistogramAggregation, HdrHistogramBench)->Arg(100);
 
+BENCHMARK(TimingsCollect)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+BENCHMARK(SharedHistogramCollect)
+        ->Threads(1)
+        ->Threads(8)
+        ->Threads(32)
+        ->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,256 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the front-end connection I/O, comparing libevent
+ * bufferevents with io_uring (IoUringSocket) on loopback TCP.
+ *
+ * A single server thread (as a FrontEndThread) answers each fixed size
+ * request with a fixed size response; each benchmark thread is a client
+ * doing blocking round trips on its own connection. Items per second is the
+ * server's throughput in requests, and the time per iteration the latency of
+ * a round trip of range(0) pipelined requests.
+ */
+
+#include <benchmark/benchmark.h>
+#include <daemon/io_uring_loop.h>
+#include <daemon/libevent_locking.h>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <libevent/utilities.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <platform/socket.h>
+
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/// A GET-sized request: header + 10 byte key
+static constexpr size_t RequestSize = 24 + 10;
+/// A GET response with a 100 byte value
+static constexpr size_t ResponseSize = 24 + 100;
+
+enum class Backend { Libevent, IoUring };
+
+/// Answer all complete requests in input
+static void respond(evbuffer* input, evbuffer* output) {
+    static const std::array<char, ResponseSize> response{};
+    while (evbuffer_get_length(input) >= RequestSize) {
+        evbuffer_drain(input, RequestSize);
+        evbuffer_add(output, response.data(), response.size());
+    }
+}
+
+class Server {
+public:
+    explicit Server(Backend backend) : base(event_base_new()) {
+        if (backend == Backend::IoUring) {
+            uring = std::make_unique<IoUringLoop>(base.get());
+        }
+        listenSock = cb::net::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (listenSock == INVALID_SOCKET ||
+            cb::net::bind(listenSock,
+                          reinterpret_cast<sockaddr*>(&addr),
+                          sizeof(addr)) != 0 ||
+            cb::net::listen(listenSock, 1024) != 0 ||
+            getsockname(listenSock, reinterpret_cast<sockaddr*>(&addr), &len) !=
+                    0) {
+            throw std::runtime_error("Server: failed to create listen socket");
+        }
+        port = ntohs(addr.sin_port);
+        evutil_make_socket_nonblocking(listenSock);
+
+        acceptEvent.reset(event_new(base.get(),
+                                    listenSock,
+                                    EV_READ | EV_PERSIST,
+                                    acceptCallback,
+                                    this));
+        event_add(acceptEvent.get(), nullptr);
+        thread = std::thread([this]() { event_base_dispatch(base.get()); });
+    }
+
+    ~Server() {
+        event_base_loopbreak(base.get());
+        thread.join();
+        acceptEvent.reset();
+        cb::net::closesocket(listenSock);
+    }
+
+    in_port_t getPort() const {
+        return port;
+    }
+
+protected:
+    static void acceptCallback(evutil_socket_t fd, short, void* arg) {
+        auto& server = *static_cast<Server*>(arg);
+        auto sfd = cb::net::accept(fd, nullptr, nullptr);
+        if (sfd == INVALID_SOCKET) {
+            return;
+        }
+        const int flag = 1;
+        cb::net::setsockopt(
+                sfd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        evutil_make_socket_nonblocking(sfd);
+
+        if (server.uring) {
+            auto socket = IoUringSocket::create(*server.uring, sfd);
+            socket->setCallbacks(
+                    [](IoUringSocket& s, void*) {
+                        respond(s.getInput(), s.getOutput());
+                    },
+                    [](IoUringSocket&, void*) {},
+                    [](IoUringSocket&, short, void*) {},
+                    nullptr);
+            socket->enableRead();
+            server.sockets.push_back(std::move(socket));
+            return;
+        }
+        // The options used by Connection
+        cb::libevent::unique_bufferevent_ptr bev(bufferevent_socket_new(
+                server.base.get(),
+                sfd,
+                BEV_OPT_THREADSAFE | BEV_OPT_UNLOCK_CALLBACKS |
+                        BEV_OPT_CLOSE_ON_FREE | BEV_OPT_DEFER_CALLBACKS));
+        bufferevent_setcb(
+                bev.get(),
+                [](bufferevent* b, void*) {
+                    respond(bufferevent_get_input(b), bufferevent_get_output(b));
+                },
+                nullptr,
+                nullptr,
+                nullptr);
+        bufferevent_enable(bev.get(), EV_READ);
+        server.bevs.push_back(std::move(bev));
+    }
+
+    cb::libevent::unique_event_base_ptr base;
+    std::unique_ptr<IoUringLoop> uring;
+    std::vector<IoUringSocket::Ptr> sockets;
+    std::vector<cb::libevent::unique_bufferevent_ptr> bevs;
+    cb::libevent::unique_event_ptr acceptEvent;
+    SOCKET listenSock = INVALID_SOCKET;
+    in_port_t port = 0;
+    std::thread thread;
+};
+
+/// The server for each backend; started by the first benchmark using it
+static Server& getServer(Backend backend) {
+    if (backend == Backend::IoUring) {
+        static Server server(Backend::IoUring);
+        return server;
+    }
+    static Server server(Backend::Libevent);
+    return server;
+}
+
+/*
+ * Each benchmark thread connects to the server and performs round trips of
+ * range(0) pipelined requests.
+ * Variables:
+ *  - range(0) : Number of requests per round trip.
+ */
+static void roundTrips(benchmark::State& state, Backend backend) {
+    if (backend == Backend::IoUring && !IoUringLoop::isSupported()) {
+        state.SkipWithError("io_uring is not supported by the kernel");
+        return;
+    }
+    auto& server = getServer(backend);
+
+    auto sock = cb::net::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(server.getPort());
+    if (sock == INVALID_SOCKET ||
+        cb::net::connect(sock,
+                         reinterpret_cast<sockaddr*>(&addr),
+                         sizeof(addr)) != 0) {
+        state.SkipWithError("Failed to connect to the server");
+        return;
+    }
+    const int flag = 1;
+    cb::net::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    const size_t depth = state.range(0);
+    const std::vector<char> requests(RequestSize * depth);
+    std::vector<char> responses(ResponseSize * depth);
+    while (state.KeepRunning()) {
+        if (cb::net::send(sock, requests.data(), requests.size(), 0) !=
+            ssize_t(requests.size())) {
+            state.SkipWithError("send failed");
+            break;
+        }
+        size_t received = 0;
+        while (received < responses.size()) {
+            const auto nr = cb::net::recv(sock,
+                                          responses.data() + received,
+                                          responses.size() - received,
+                                          0);
+            if (nr <= 0) {
+                state.SkipWithError("recv failed");
+                break;
+            }
+            received += nr;
+        }
+    }
+    cb::net::closesocket(sock);
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+
+static void Libevent(benchmark::State& state) {
+    roundTrips(state, Backend::Libevent);
+}
+
+static void IoUring(benchmark::State& state) {
+    roundTrips(state, Backend::IoUring);
+}
+
+BENCHMARK(Libevent)
+        ->Arg(1)
+        ->Arg(16)
+        ->ArgName("Pipeline")
+        ->Threads(1)
+        ->Threads(4)
+        ->Threads(16)
+        ->UseRealTime();
+
+BENCHMARK(IoUring)
+        ->Arg(1)
+        ->Arg(16)
+        ->ArgName("Pipeline")
+        ->Threads(1)
+        ->Threads(4)
+        ->Threads(16)
+        ->UseRealTime();
+
+int main(int argc, char** argv) {
+    setup_libevent_locking();
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+    ::benchmark::RunSpecifiedBenchmarks();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Functional tests of IoUringSocket over loopback TCP connections: the
+ * socket under test is driven by an IoUringLoop on the test thread, and the
+ * test plays the peer with plain blocking socket calls.
+ */
+
+#include <daemon/io_uring_loop.h>
+#include <daemon/libevent_locking.h>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <folly/portability/GTest.h>
+#include <libevent/utilities.h>
+#include <netinet/in.h>
+#include <platform/socket.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class IoUringSocketTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!IoUringLoop::isSupported()) {
+            GTEST_SKIP() << "io_uring is not supported by the kernel";
+        }
+        base.reset(event_base_new());
+        loop = std::make_unique<IoUringLoop>(base.get());
+
+        SOCKET sfd;
+        connectPair(sfd, peer);
+        evutil_make_socket_nonblocking(sfd);
+        socket = IoUringSocket::create(*loop, sfd);
+        socket->setCallbacks(readCallback, writeCallback, eventCallback, this);
+    }
+
+    void TearDown() override {
+        if (loop) {
+            socket.reset();
+            // Nothing may be left behind for the ring's destruction
+            EXPECT_EQ(0, loop->drain(std::chrono::seconds{5}));
+            loop.reset();
+        }
+        if (peer != INVALID_SOCKET) {
+            cb::net::closesocket(peer);
+        }
+    }
+
+    /// Create a connected pair of loopback TCP sockets
+    static void connectPair(SOCKET& server, SOCKET& client) {
+        auto listenSock = cb::net::socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_NE(INVALID_SOCKET, listenSock);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(0,
+                  cb::net::bind(listenSock,
+                                reinterpret_cast<sockaddr*>(&addr),
+                                sizeof(addr)));
+        ASSERT_EQ(0, cb::net::listen(listenSock, 1));
+        ASSERT_EQ(0,
+                  getsockname(listenSock,
+                              reinterpret_cast<sockaddr*>(&addr),
+                              &len));
+        client = cb::net::socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_NE(INVALID_SOCKET, client);
+        ASSERT_EQ(0,
+                  cb::net::connect(client,
+                                   reinterpret_cast<sockaddr*>(&addr),
+                                   sizeof(addr)));
+        server = cb::net::accept(listenSock, nullptr, nullptr);
+        ASSERT_NE(INVALID_SOCKET, server);
+        cb::net::closesocket(listenSock);
+    }
+
+    /// Run the event loop until pred() returns true (or 10s have passed)
+    template <class Pred>
+    bool runUntil(Pred pred) {
+        const auto deadline =
+                std::chrono::steady_clock::now() + std::chrono::seconds{10};
+        while (!pred()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            timeval tv{0, 10000};
+            event_base_loopexit(base.get(), &tv);
+            event_base_loop(base.get(), EVLOOP_ONCE);
+        }
+        return true;
+    }
+
+    /// Run the event loop for the given time
+    void runFor(std::chrono::milliseconds duration) {
+        const auto end = std::chrono::steady_clock::now() + duration;
+        runUntil([end]() { return std::chrono::steady_clock::now() > end; });
+    }
+
+    /// Queue numChunks chunks of ChunkSize bytes to be sent, each as its own
+    /// evbuffer chain (so they need several sendmsg calls) and with all bytes
+    /// of chunk n set to n % 256 (so the peer can check the order)
+    void queueChunks(size_t numChunks) {
+        for (size_t ii = 0; ii < numChunks; ++ii) {
+            chunks.emplace_back(ChunkSize, char(ii));
+            evbuffer_add_reference(socket->getOutput(),
+                                   chunks.back().data(),
+                                   ChunkSize,
+                                   nullptr,
+                                   nullptr);
+        }
+    }
+
+    /// Read (and check) what queueChunks() sent, a little at a time
+    static void readChunks(SOCKET sock, size_t numChunks, bool& ok) {
+        std::vector<char> buffer(4096);
+        size_t offset = 0;
+        ok = true;
+        while (offset < numChunks * ChunkSize) {
+            const auto nr =
+                    cb::net::recv(sock, buffer.data(), buffer.size(), 0);
+            if (nr <= 0) {
+                ok = false;
+                return;
+            }
+            for (ssize_t ii = 0; ii < nr; ++ii, ++offset) {
+                if (buffer[ii] != char(offset / ChunkSize)) {
+                    ok = false;
+                    return;
+                }
+            }
+        }
+    }
+
+    static void readCallback(IoUringSocket& socket, void* ctx) {
+        auto& test = *static_cast<IoUringSocketTest*>(ctx);
+        auto* input = socket.getInput();
+        const auto length = evbuffer_get_length(input);
+        std::string data(length, '\0');
+        evbuffer_remove(input, &data[0], length);
+        test.received += data;
+    }
+
+    static void writeCallback(IoUringSocket&, void* ctx) {
+        ++static_cast<IoUringSocketTest*>(ctx)->writes;
+    }
+
+    static void eventCallback(IoUringSocket&, short events, void* ctx) {
+        static_cast<IoUringSocketTest*>(ctx)->events |= events;
+    }
+
+    static constexpr size_t ChunkSize = 16 * 1024;
+
+    cb::libevent::unique_event_base_ptr base;
+    std::unique_ptr<IoUringLoop> loop;
+    IoUringSocket::Ptr socket;
+    SOCKET peer = INVALID_SOCKET;
+    std::vector<std::string> chunks;
+
+    std::string received;
+    int writes = 0;
+    short events = 0;
+};
+
+/// Data sent by the peer before closing is received, followed by EOF
+TEST_F(IoUringSocketTest, PeerEOF) {
+    socket->enableRead();
+    const std::string data = "Hello, world";
+    ASSERT_EQ(ssize_t(data.size()),
+              cb::net::send(peer, data.data(), data.size(), 0));
+    cb::net::closesocket(peer);
+    peer = INVALID_SOCKET;
+
+    ASSERT_TRUE(runUntil([this]() { return events != 0; }));
+    EXPECT_EQ(BEV_EVENT_READING | BEV_EVENT_EOF, events);
+    EXPECT_EQ(data, received);
+    // The multishot receive ended with the EOF
+    EXPECT_EQ(0, loop->getInFlight());
+}
+
+/**
+ * Data which the kernel only accepts a bit at a time (the peer reads it
+ * slowly through small socket buffers, and it spans more iovecs than one
+ * sendmsg takes) is sent in order, and the write callback is only called
+ * once all of it has been sent.
+ */
+TEST_F(IoUringSocketTest, PartialSends) {
+    const int bufSize = 16 * 1024;
+    ASSERT_EQ(0,
+              cb::net::setsockopt(
+                      peer, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize)));
+
+    const size_t numChunks = 256;
+    queueChunks(numChunks);
+    bool ok = false;
+    std::thread reader(readChunks, peer, numChunks, std::ref(ok));
+
+    const bool sent = runUntil([this]() { return writes != 0; });
+    reader.join();
+    ASSERT_TRUE(sent);
+    EXPECT_TRUE(ok) << "The peer didn't receive the data sent in order";
+    EXPECT_EQ(1, writes);
+    EXPECT_EQ(0, socket->getSendQueueSize());
+    EXPECT_EQ(0, events);
+}
+
+/**
+ * Closing a socket with a receive armed and a send stuck waiting for the
+ * peer to read cancels both; the socket is destroyed (and the peer sees it
+ * close) once they have completed.
+ */
+TEST_F(IoUringSocketTest, CloseWithRequestsInFlight) {
+    socket->enableRead();
+    const size_t numChunks = 1024;
+    queueChunks(numChunks);
+    runFor(std::chrono::milliseconds{100});
+    ASSERT_NE(0, socket->getSendQueueSize()) << "The send didn't block";
+    ASSERT_EQ(2, loop->getInFlight());
+
+    socket.reset();
+    ASSERT_TRUE(runUntil([this]() { return loop->getInFlight() == 0; }));
+
+    // The socket was closed: the peer gets what was sent before the cancel,
+    // followed by EOF (not a reset)
+    std::vector<char> buffer(64 * 1024);
+    ssize_t nr;
+    do {
+        nr = cb::net::recv(peer, buffer.data(), buffer.size(), 0);
+    } while (nr > 0);
+    EXPECT_EQ(0, nr);
+    EXPECT_EQ(0, events);
+}
+
+/**
+ * As at shutdown: a socket closed without the loop running again still has
+ * its requests (and the cancels for them, not yet submitted) outstanding;
+ * drain() completes them all and destroys the socket.
+ */
+TEST_F(IoUringSocketTest, DrainCancelsRequestsInFlight) {
+    socket->enableRead();
+    queueChunks(1024);
+    runFor(std::chrono::milliseconds{100});
+    ASSERT_EQ(2, loop->getInFlight());
+
+    socket.reset();
+    EXPECT_EQ(0, loop->drain(std::chrono::seconds{5}));
+
+    std::vector<char> buffer(64 * 1024);
+    ssize_t nr;
+    do {
+        nr = cb::net::recv(peer, buffer.data(), buffer.size(), 0);
+    } while (nr > 0);
+    EXPECT_EQ(0, nr);
+}
+
+int main(int argc, char** argv) {
+    setup_libevent_locking();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -65,6 +65,8 @@ int memcached_verbose = 0;
 // State variable if we're running the memcached server in a
 // thread in the same process or not
 static bool embedded_memcached_server;
+// Use io_uring for the front-end connection I/O (-u)
+static bool io_uring_enabled;
 
 static SOCKET connect_to_server_ssl(in_port_t ssl_port);
 
@@ -393,6 +395,10 @@ nlohmann::json TestappTest::generate_config() {
         ret["parent_identifier"] = (int)getpid();
     }
 
+    if (io_uring_enabled) {
+        ret["io_uring_enabled"] = true;
+    }
+
     if (memcached_verbose == 0) {
         ret["logger"]["console"] = false;
     } else {
@@ -1383,7 +1389,7 @@ int main(int argc, char** argv) {
     std::string engine_config;
 
     int cmd;
-    while ((cmd = getopt(argc, argv, "vc:eE:")) != EOF) {
+    while ((cmd = getopt(argc, argv, "vc:eE:u")) != EOF) {
         switch (cmd) {
         case 'v':
             memcached_verbose++;
@@ -1397,8 +1403,11 @@ int main(int argc, char** argv) {
         case 'E':
             engine_name.assign(optarg);
             break;
+        case 'u':
+            io_uring_enabled = true;
+            break;
         default:
-            std::cerr << "Usage: " << argv[0] << " [-v] [-e]" << std::endl
+            std::cerr << "Usage: " << argv[0] << " [-v] [-e] [-u]" << std::endl
                       << std::endl
                       << "  -v Verbose - Print verbose memcached output "
                       << "to stderr." << std::endl
@@ -1409,6 +1418,8 @@ int main(int argc, char** argv) {
                       << "  -e Embedded - Run the memcached daemon in the "
                       << "same process (for debugging only..)" << std::endl
                       << "  -E ENGINE engine type to use. <default|ep>"
+                      << std::endl
+                      << "  -u io_uring - Use io_uring for the connection I/O"
                       << std::endl;
             return 1;
         }
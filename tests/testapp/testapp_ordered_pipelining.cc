@@ -0,0 +1,166 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Tests for connections which enabled the OrderedPipelining HELLO feature
+ * (see docs/UnorderedExecution.md). The first command in the pipeline is
+ * suspended in the ewouldblock engine until it is resumed from a second
+ * connection, which lets the tests observe what the server did with the
+ * commands behind it in the meantime.
+ */
+
+#include "testapp.h"
+#include "testapp_client_test.h"
+
+#include <chrono>
+#include <thread>
+
+class OrderedPipeliningTest : public TestappClientTest {
+protected:
+    void SetUp() override {
+        TestappClientTest::SetUp();
+        conn = getConnectionForBucket();
+        conn->setFeature(cb::mcbp::Feature::OrderedPipelining, true);
+        other = getConnectionForBucket();
+    }
+
+    void TearDown() override {
+        if (suspended) {
+            // Don't leave the cookie registered in the engine if the test
+            // failed before resuming it
+            resume();
+        }
+        conn.reset();
+        other.reset();
+        TestappClientTest::TearDown();
+    }
+
+    std::unique_ptr<MemcachedConnection> getConnectionForBucket() {
+        auto ret = getConnection().clone();
+        ret->authenticate("@admin", "password", "PLAIN");
+        ret->selectBucket(bucketName);
+        return ret;
+    }
+
+    /**
+     * Make the next command on conn block in the engine (until resume() is
+     * called), and send it a GET of key followed by a SET of setKey
+     */
+    void sendBlockedGetThenSet(const std::string& key,
+                               const std::string& setKey,
+                               const std::string& setValue) {
+        conn->configureEwouldBlockEngine(
+                EWBEngineMode::Suspend, ENGINE_EWOULDBLOCK, suspendId);
+        suspended = true;
+
+        BinprotGetCommand get;
+        get.setKey(key);
+        get.setOpaque(1);
+        conn->sendCommand(get);
+
+        BinprotMutationCommand set;
+        set.setMutationType(MutationType::Set);
+        set.setKey(setKey);
+        set.setValue(setValue);
+        set.setOpaque(2);
+        conn->sendCommand(set);
+    }
+
+    void resume() {
+        other->configureEwouldBlockEngine(
+                EWBEngineMode::Resume, ENGINE_SUCCESS, suspendId);
+        suspended = false;
+    }
+
+    /// Receive the responses to sendBlockedGetThenSet, checking their order
+    /// @return the value returned by the GET
+    std::string recvGetThenSetResponses() {
+        BinprotResponse rsp;
+        conn->recvResponse(rsp);
+        EXPECT_EQ(1, rsp.getResponse().getOpaque());
+        EXPECT_EQ(cb::mcbp::ClientOpcode::Get, rsp.getOp());
+        EXPECT_TRUE(rsp.isSuccess()) << to_string(rsp.getStatus());
+        const auto value = rsp.getDataString();
+
+        conn->recvResponse(rsp);
+        EXPECT_EQ(2, rsp.getResponse().getOpaque());
+        EXPECT_EQ(cb::mcbp::ClientOpcode::Set, rsp.getOp());
+        EXPECT_TRUE(rsp.isSuccess()) << to_string(rsp.getStatus());
+        return value;
+    }
+
+    static constexpr uint32_t suspendId = 0xcafe;
+    bool suspended = false;
+    std::unique_ptr<MemcachedConnection> conn;
+    std::unique_ptr<MemcachedConnection> other;
+};
+
+INSTANTIATE_TEST_SUITE_P(TransportProtocols,
+                         OrderedPipeliningTest,
+                         ::testing::Values(TransportProtocols::McbpPlain),
+                         ::testing::PrintToStringParamName());
+
+/**
+ * A command on another key behind a blocked command is executed while the
+ * first one is blocked, but its response is only sent after the response
+ * to the blocked command.
+ */
+TEST_P(OrderedPipeliningTest, CommandsExecuteConcurrently) {
+    const auto blockedKey = name + "-blocked";
+    const auto setKey = name + "-set";
+    other->store(blockedKey, Vbid(0), "blocked");
+
+    sendBlockedGetThenSet(blockedKey, setKey, "value");
+
+    // The SET completes (as seen from the other connection) while the GET
+    // ahead of it is still blocked.
+    const auto timeout =
+            std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    bool stored = false;
+    do {
+        try {
+            stored = other->get(setKey, Vbid(0)).value == "value";
+        } catch (const ConnectionError& error) {
+            ASSERT_TRUE(error.isNotFound()) << error.what();
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+    } while (!stored && std::chrono::steady_clock::now() < timeout);
+    EXPECT_TRUE(stored) << "The SET wasn't executed while the GET ahead of "
+                           "it in the pipeline was blocked";
+
+    resume();
+    EXPECT_EQ("blocked", recvGetThenSetResponses());
+}
+
+/**
+ * A command on the same key as a blocked command is a barrier: it isn't
+ * executed until the blocked one completes, so the blocked GET doesn't see
+ * the value stored by the SET sent after it.
+ */
+TEST_P(OrderedPipeliningTest, SameKeyKeepsOrder) {
+    other->store(name, Vbid(0), "old");
+
+    sendBlockedGetThenSet(name, name, "new");
+
+    // Give the server the chance to (incorrectly) run the SET
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    EXPECT_EQ("old", other->get(name, Vbid(0)).value);
+
+    resume();
+    EXPECT_EQ("old", recvGetThenSetResponses());
+    EXPECT_EQ("new", other->get(name, Vbid(0)).value);
+}
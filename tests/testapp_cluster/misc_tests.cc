@@ -23,6 +23,9 @@
 #include <protocol/connection/client_connection.h>
 #include <protocol/connection/client_mcbp_commands.h>
 #include <protocol/connection/frameinfo.h>
+#include <xattr/blob.h>
+#include <xattr/utils.h>
+#include <map>
 #include <string>
 
 class BasicClusterTest : public cb::test::ClusterTest {};
@@ -155,3 +158,96 @@ TEST_F(BasicClusterTest, UsingExternalAuth) {
 
     cluster->getAuthProviderService().removeUser("extuser");
 }
+
+/// DCP deletions carry the document's xattrs as their value; values larger
+/// than SendBuffer::MinimumDataSize are chained into the output stream by
+/// reference rather than copied. Verify the bytes received for a deletion
+/// on either side of that threshold, and that the server's CPU time for the
+/// DCP connection (which dcpdrain --cpu-usage reports) can be read from
+/// "stats connections".
+TEST_F(BasicClusterTest, DcpDeletionWithXattrValue) {
+    auto bucket = cluster->getBucket("default");
+    auto conn = bucket->getConnection(Vbid(0));
+    conn->authenticate("@admin", "password", "PLAIN");
+    conn->selectBucket(bucket->getName());
+
+    // Create each key as a deleted document with a system xattr (user xattrs
+    // of deleted documents need IncludeDeletedUserXattrs to be streamed)
+    const std::map<std::string, std::string> values = {
+            {"DcpDeletionWithXattrValue_small", std::string(100, 'a')},
+            {"DcpDeletionWithXattrValue_large", std::string(8192, 'b')}};
+    for (const auto& [key, value] : values) {
+        BinprotSubdocCommand cmd(
+                cb::mcbp::ClientOpcode::SubdocDictUpsert,
+                key,
+                "_sync.value",
+                "\"" + value + "\"",
+                SUBDOC_FLAG_XATTR_PATH | SUBDOC_FLAG_MKDIR_P,
+                mcbp::subdoc::doc_flag::Mkdoc |
+                        mcbp::subdoc::doc_flag::CreateAsDeleted);
+        cmd.setVBucket(Vbid(0));
+        const auto rsp = conn->execute(cmd);
+        ASSERT_EQ(cb::mcbp::Status::SubdocSuccessDeleted, rsp.getStatus());
+    }
+
+    auto dcp = bucket->getConnection(Vbid(0));
+    dcp->authenticate("@admin", "password", "PLAIN");
+    dcp->selectBucket(bucket->getName());
+    const auto dcpConnectionId = dcp->getServerConnectionId();
+    auto rsp = dcp->execute(BinprotDcpOpenCommand{
+            "DcpDeletionWithXattrValue",
+            cb::mcbp::request::DcpOpenPayload::Producer |
+                    cb::mcbp::request::DcpOpenPayload::IncludeXattrs});
+    ASSERT_TRUE(rsp.isSuccess());
+    dcp->dcpStreamRequest(Vbid(0), 0, 0, ~0, 0, 0, 0);
+
+    // Skip anything else in the vBucket (snapshot markers, other tests'
+    // documents) until both deletions have been received.
+    std::map<std::string, std::string> received;
+    Frame frame;
+    while (received.size() < values.size()) {
+        dcp->recvFrame(frame);
+        ASSERT_EQ(cb::mcbp::Magic::ClientRequest, frame.getMagic());
+        const auto* request = frame.getRequest();
+        if (request->getClientOpcode() != cb::mcbp::ClientOpcode::DcpDeletion) {
+            continue;
+        }
+        const auto key = request->getKey();
+        const std::string name{reinterpret_cast<const char*>(key.data()),
+                               key.size()};
+        if (values.count(name) == 0) {
+            continue;
+        }
+        EXPECT_TRUE(mcbp::datatype::is_xattr(uint8_t(request->getDatatype())))
+                << name;
+        const auto value = request->getValue();
+        received[name] = {reinterpret_cast<const char*>(value.data()),
+                          value.size()};
+    }
+
+    for (const auto& [key, value] : values) {
+        // The value is the xattr blob only (a deleted document has no body)
+        const auto& payload = received[key];
+        EXPECT_EQ(payload.size(), cb::xattr::get_body_offset(payload)) << key;
+
+        cb::xattr::Blob expected;
+        expected.set("_sync", nlohmann::json{{"value", value}}.dump());
+        ASSERT_EQ(expected.size(), payload.size()) << key;
+
+        std::string copy = payload;
+        cb::xattr::Blob blob({copy.data(), copy.size()}, false);
+        EXPECT_EQ(expected.to_json(), blob.to_json()) << key;
+    }
+
+    // The CPU time the server spent on the DCP connection is available
+    // (as a string of nanoseconds) while the connection is open.
+    size_t cpuTime = 0;
+    conn->stats(
+            [&cpuTime](const std::string&, const std::string& value) {
+                const auto json = nlohmann::json::parse(value);
+                cpuTime = std::stoull(
+                        json["total_cpu_time"].get<std::string>());
+            },
+            "connections " + std::to_string(dcpConnectionId));
+    EXPECT_NE(0, cpuTime);
+}
@@ -27,12 +27,16 @@ class OutOfOrderClusterTest : public cb::test::ClusterTest {
 protected:
     enum class Reorder { None, Half, All };
 
-    static void testGetReorderWithAndWithoutReorder(Reorder reorder) {
+    static void testGetReorderWithAndWithoutReorder(
+            Reorder reorder, bool unorderedExecution = true) {
         auto bucket = cluster->getBucket("default");
         auto conn = bucket->getConnection(Vbid(0));
         conn->authenticate("@admin", "password", "PLAIN");
         conn->selectBucket(bucket->getName());
-        conn->setFeature(cb::mcbp::Feature::UnorderedExecution, true);
+        conn->setFeature(cb::mcbp::Feature::UnorderedExecution,
+                         unorderedExecution);
+        conn->setFeature(cb::mcbp::Feature::OrderedPipelining,
+                         !unorderedExecution);
 
         const std::string prefix = "testGetReorderWithAndWithoutReorder-";
         const std::size_t numDocs = 100;
@@ -93,7 +97,7 @@ protected:
                     return ret;
                 });
 
-        if (reorder == Reorder::All) {
+        if (reorder == Reorder::All && unorderedExecution) {
             ASSERT_TRUE(unordered) << "I didn't get any unordered responses";
         } else {
             ASSERT_FALSE(unordered) << "We received documents out of order";
@@ -126,3 +130,13 @@ TEST_F(OutOfOrderClusterTest, GetSequenceNoBarriers) {
 TEST_F(OutOfOrderClusterTest, OnlyReorderReordableCommands) {
     testGetReorderWithAndWithoutReorder(Reorder::Half);
 }
+
+/**
+ * Verify that if the client enabled ordered pipelining (rather than unordered
+ * execution) we receive the responses in the right sequence, even though
+ * commands after the ones needing to page in their document from disk are
+ * executed
+ */
+TEST_F(OutOfOrderClusterTest, GetSequenceOrderedPipeline) {
+    testGetReorderWithAndWithoutReorder(Reorder::All, false);
+}
@@ -0,0 +1,188 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks relating to the execution of a pipeline of commands on a
+ * connection, where some of the commands have to wait for a background
+ * fetch (the document was evicted).
+ *
+ * Runs a single node cluster with an ep bucket, and measures the throughput
+ * of pipelined GETs with 5% of the keys evicted before each pipeline is
+ * sent, with:
+ *  - every command a barrier (the behaviour of a connection without
+ *    unordered execution or ordered pipelining),
+ *  - ordered pipelining enabled through HELLO (responses are sent in
+ *    request order),
+ *  - unordered execution enabled through HELLO.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cluster_framework/bucket.h>
+#include <cluster_framework/cluster.h>
+#include <event2/thread.h>
+#include <platform/dirutils.h>
+#include <platform/platform_socket.h>
+#include <protocol/connection/client_connection.h>
+#include <protocol/connection/client_mcbp_commands.h>
+#include <protocol/connection/frameinfo.h>
+
+#include <array>
+#include <csignal>
+#include <iostream>
+#include <random>
+
+enum class Mode { Barriers, OrderedPipeline, Unordered };
+
+class PipelineBench : public benchmark::Fixture {
+public:
+    static void TearDownCluster() {
+        bucket.reset();
+        cluster.reset();
+    }
+
+protected:
+    void SetUp(const benchmark::State& state) override {
+        if (!cluster) {
+            cluster = cb::test::Cluster::create(1);
+            if (!cluster) {
+                throw std::runtime_error("Failed to create the cluster");
+            }
+            bucket = cluster->createBucket(
+                    "default", {{"replicas", 0}, {"max_vbuckets", 8}});
+            if (!bucket) {
+                throw std::runtime_error("Failed to create default bucket");
+            }
+            auto conn = getConnection(Mode::Barriers);
+            for (size_t ii = 0; ii < NumDocuments; ++ii) {
+                conn->store("key-" + std::to_string(ii), Vbid(0), "value");
+            }
+        }
+    }
+
+    std::unique_ptr<MemcachedConnection> getConnection(Mode mode) {
+        auto conn = bucket->getConnection(Vbid(0));
+        conn->authenticate("@admin", "password", "PLAIN");
+        conn->selectBucket(bucket->getName());
+        conn->setFeature(cb::mcbp::Feature::UnorderedExecution,
+                         mode == Mode::Unordered);
+        conn->setFeature(cb::mcbp::Feature::OrderedPipelining,
+                         mode == Mode::OrderedPipeline);
+        return conn;
+    }
+
+    static constexpr size_t NumDocuments = 10000;
+    // Percentage of the keys in each pipeline evicted before it is sent
+    static constexpr size_t MissPercent = 5;
+
+    static std::unique_ptr<cb::test::Cluster> cluster;
+    static std::shared_ptr<cb::test::Bucket> bucket;
+};
+
+std::unique_ptr<cb::test::Cluster> PipelineBench::cluster;
+std::shared_ptr<cb::test::Bucket> PipelineBench::bucket;
+
+/*
+ * Send pipelines of GETs and wait for all the responses.
+ * Variables:
+ *  - range(0) : Mode (Barriers, OrderedPipeline or Unordered).
+ *  - range(1) : Number of commands in each pipeline.
+ */
+BENCHMARK_DEFINE_F(PipelineBench, PipelinedGet)(benchmark::State& state) {
+    const auto mode = Mode(state.range(0));
+    const size_t pipelineSize = state.range(1);
+    auto conn = getConnection(mode);
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<size_t> distribution(0, NumDocuments - 1);
+    std::vector<std::pair<const std::string, Vbid>> keys;
+    for (size_t ii = 0; ii < pipelineSize; ++ii) {
+        keys.emplace_back("key-" + std::to_string(distribution(gen)),
+                          Vbid(0));
+    }
+    const size_t misses = std::max(size_t(1), pipelineSize * MissPercent / 100);
+
+    size_t errors = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        for (size_t ii = 0; ii < misses; ++ii) {
+            // Waits for the document to be persisted (and succeeds if it
+            // is already evicted)
+            conn->evict(keys[distribution(gen) % pipelineSize].first, Vbid(0));
+        }
+        state.ResumeTiming();
+
+        conn->mget(
+                keys,
+                [](std::unique_ptr<Document>&) {},
+                [&errors](const std::string&, const cb::mcbp::Response&) {
+                    ++errors;
+                },
+                [mode]() -> FrameInfoVector {
+                    FrameInfoVector ret;
+                    if (mode == Mode::Barriers) {
+                        ret.emplace_back(std::make_unique<BarrierFrameInfo>());
+                    }
+                    return ret;
+                });
+    }
+
+    if (errors) {
+        state.SkipWithError("Failed to get documents");
+    }
+    state.SetItemsProcessed(state.iterations() * pipelineSize);
+}
+
+BENCHMARK_REGISTER_F(PipelineBench, PipelinedGet)
+        ->ArgNames({"Mode", "Pipeline"})
+        ->Args({int(Mode::Barriers), 100})
+        ->Args({int(Mode::OrderedPipeline), 100})
+        ->Args({int(Mode::Unordered), 100})
+        ->Args({int(Mode::Barriers), 1000})
+        ->Args({int(Mode::OrderedPipeline), 1000})
+        ->Args({int(Mode::Unordered), 1000})
+        ->UseRealTime();
+
+int main(int argc, char** argv) {
+    cb_initialize_sockets();
+    if (evthread_use_pthreads() == -1) {
+        std::cerr << "Failed to enable libevent locking. Terminating program"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const auto isasl_file_name = cb::io::sanitizePath(
+            SOURCE_ROOT "/tests/testapp_cluster/cbsaslpw.json");
+    static std::array<char, 1024> isasl_env_var;
+    snprintf(isasl_env_var.data(),
+             isasl_env_var.size(),
+             "CBSASL_PWFILE=%s",
+             isasl_file_name.c_str());
+    putenv(isasl_env_var.data());
+
+    if (sigignore(SIGPIPE) == -1) {
+        std::cerr << "Fatal: failed to ignore SIGPIPE; sigaction" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+    ::benchmark::RunSpecifiedBenchmarks();
+    PipelineBench::TearDownCluster();
+    return EXIT_SUCCESS;
+}